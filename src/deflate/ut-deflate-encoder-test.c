@@ -102,5 +102,26 @@ int main(int argc, char **argv) {
   }
   ut_assert_uint8_list_equal_hex(short_write_result, "cb48cdc9c90700");
 
+  // Join separately encoded data into one stream.
+  UtObjectRef first_data = get_utf8_data("hello");
+  UtObjectRef first_data_stream = ut_list_input_stream_new(first_data);
+  UtObjectRef first_encoder = ut_deflate_encoder_new(first_data_stream);
+  ut_deflate_encoder_set_is_final(first_encoder, false);
+  UtObjectRef first_result = ut_input_stream_read_sync(first_encoder);
+  ut_assert_is_not_error(first_result);
+  ut_assert_uint8_list_equal_hex(first_result, "ca48cdc9c907000000ffff");
+  UtObjectRef second_data = get_utf8_data("world");
+  UtObjectRef second_data_stream = ut_list_input_stream_new(second_data);
+  UtObjectRef second_encoder = ut_deflate_encoder_new(second_data_stream);
+  UtObjectRef second_result = ut_input_stream_read_sync(second_encoder);
+  ut_assert_is_not_error(second_result);
+  UtObjectRef joined_data = ut_list_copy(first_result);
+  ut_list_append_list(joined_data, second_result);
+  UtObjectRef joined_data_stream = ut_list_input_stream_new(joined_data);
+  UtObjectRef joined_decoder = ut_deflate_decoder_new(joined_data_stream);
+  UtObjectRef joined_result = ut_input_stream_read_sync(joined_decoder);
+  ut_assert_is_not_error(joined_result);
+  ut_assert_uint8_list_equal_hex(joined_result, "68656c6c6f776f726c64");
+
   return 0;
 }
@@ -2,6 +2,9 @@
 
 #include "ut.h"
 
+// Code used for blocks that are not compressed.
+#define BLOCK_UNCOMPRESSED 0
+
 // Code used for blocks that use static Huffman codes.
 #define BLOCK_STATIC_HUFFMAN 1
 
@@ -16,6 +19,9 @@ typedef struct {
 
   size_t window_size;
 
+  // True if this data ends the deflate stream.
+  bool is_final;
+
   // Huffman encoder for literal/length codes.
   UtObject *literal_length_huffman_encoder;
 
@@ -96,10 +102,11 @@ static void find_match(UtDeflateEncoder *self, size_t data_length,
   for (size_t distance = 1; distance <= max_distance; distance++) {
     const uint8_t *match = data - distance;
 
-    // Can't match more than the data we have.
+    // Can't match more than the data we have, or the longest length that can
+    // be encoded.
     size_t max_length = data_length;
-    if (max_length > 285) {
-      max_length = 285;
+    if (max_length > 258) {
+      max_length = 258;
     }
 
     size_t length;
@@ -223,7 +230,7 @@ static size_t read_cb(UtObject *object, UtObject *data, bool complete) {
   UtDeflateEncoder *self = (UtDeflateEncoder *)object;
 
   if (!self->written_header) {
-    write_block_header(self, true, BLOCK_STATIC_HUFFMAN);
+    write_block_header(self, self->is_final, BLOCK_STATIC_HUFFMAN);
     self->written_header = true;
   }
 
@@ -261,6 +268,16 @@ static size_t read_cb(UtObject *object, UtObject *data, bool complete) {
   // If complete, use partially filled bytes.
   if (complete) {
     write_symbol(self, self->literal_length_huffman_encoder, END_OF_STREAM);
+
+    // Finish with an empty uncompressed block, which aligns the data to a
+    // byte boundary so more blocks can be appended.
+    if (!self->is_final) {
+      write_block_header(self, false, BLOCK_UNCOMPRESSED);
+      end_bits(self);
+      ut_uint8_list_append_uint16_le(self->buffer, 0x0000);
+      ut_uint8_list_append_uint16_le(self->buffer, 0xffff);
+    }
+
     end_bits(self);
   }
 
@@ -277,6 +294,7 @@ static size_t read_cb(UtObject *object, UtObject *data, bool complete) {
 
 static void ut_deflate_encoder_init(UtObject *object) {
   UtDeflateEncoder *self = (UtDeflateEncoder *)object;
+  self->is_final = true;
   self->dictionary = ut_uint8_array_new();
   self->buffer = ut_uint8_array_new();
 
@@ -363,6 +381,12 @@ size_t ut_deflate_encoder_get_window_size(UtObject *object) {
   return self->window_size;
 }
 
+void ut_deflate_encoder_set_is_final(UtObject *object, bool is_final) {
+  assert(ut_object_is_deflate_encoder(object));
+  UtDeflateEncoder *self = (UtDeflateEncoder *)object;
+  self->is_final = is_final;
+}
+
 bool ut_object_is_deflate_encoder(UtObject *object) {
   return ut_object_is_type(object, &object_interface);
 }
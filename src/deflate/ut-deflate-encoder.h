@@ -23,5 +23,10 @@ UtObject *ut_deflate_encoder_new_with_window_size(size_t window_size,
 /// Returns the window size used by this encoder.
 size_t ut_deflate_encoder_get_window_size(UtObject *object);
 
+/// Sets whether the encoded data ends the deflate stream. If [is_final] is
+/// [false] the data ends on a byte boundary with an empty uncompressed block,
+/// so the output of another encoder can be appended to it. Defaults to [true].
+void ut_deflate_encoder_set_is_final(UtObject *object, bool is_final);
+
 /// Returns [true] if [object] is a [UtDeflateEncoder].
 bool ut_object_is_deflate_encoder(UtObject *object);
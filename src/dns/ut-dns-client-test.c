@@ -2,6 +2,55 @@
 
 #include "ut.h"
 
+// Socket on another port used to send spoofed replies.
+static UtObject *spoof_socket = NULL;
+
+// Valid reply, sent after the invalid ones have been received.
+static UtObject *reply_timer = NULL;
+static UtObject *reply_address = NULL;
+static uint16_t reply_port = 0;
+static UtObject *reply = NULL;
+
+// Make a reply to a query [id] for [name] of [type] with IPv4 [address].
+static UtObject *make_reply(uint16_t id, uint16_t flags, const char *name,
+                            uint16_t type, uint32_t address) {
+  UtObject *reply = ut_uint8_array_new();
+  ut_uint8_list_append_uint16_be(reply, id);
+  ut_uint8_list_append_uint16_be(reply, flags);
+  ut_uint8_list_append_uint16_be(reply, 1); // n_questions
+  ut_uint8_list_append_uint16_be(reply, 1); // n_answers
+  ut_uint8_list_append_uint16_be(reply, 0);
+  ut_uint8_list_append_uint16_be(reply, 0);
+  const char *label = name;
+  while (*label != '\0') {
+    size_t label_length = 0;
+    while (label[label_length] != '.' && label[label_length] != '\0') {
+      label_length++;
+    }
+    ut_uint8_list_append(reply, label_length);
+    ut_uint8_list_append_block(reply, (const uint8_t *)label, label_length);
+    label += label_length;
+    if (*label == '.') {
+      label++;
+    }
+  }
+  ut_uint8_list_append(reply, 0);
+  ut_uint8_list_append_uint16_be(reply, type);   // type
+  ut_uint8_list_append_uint16_be(reply, 1);      // class
+  ut_uint8_list_append_uint16_be(reply, 0xc00c); // name pointer
+  ut_uint8_list_append_uint16_be(reply, 1);      // type
+  ut_uint8_list_append_uint16_be(reply, 1);      // class
+  ut_uint8_list_append_uint32_be(reply, 60);     // ttl
+  ut_uint8_list_append_uint16_be(reply, 4);      // data_length
+  ut_uint8_list_append_uint32_be(reply, address);
+  return reply;
+}
+
+static void send_reply_cb(UtObject *object) {
+  UtObject *socket = object;
+  ut_udp_socket_send(socket, reply_address, reply_port, reply);
+}
+
 // Handle DNS requests and send back.
 static size_t dns_read_cb(UtObject *object, UtObject *datagrams,
                           bool complete) {
@@ -10,39 +59,30 @@ static size_t dns_read_cb(UtObject *object, UtObject *datagrams,
   UtObjectRef datagram = ut_list_get_element(datagrams, 0);
   UtObject *request = ut_udp_datagram_get_data(datagram);
   uint16_t id = ut_uint8_list_get_uint16_be(request, 0);
+  UtObject *address = ut_udp_datagram_get_address(datagram);
+  uint16_t port = ut_udp_datagram_get_port(datagram);
+
+  // Replies that must be ignored, as they are from the wrong port, aren't
+  // marked as responses or are for a different question.
+  UtObjectRef spoofed_reply =
+      make_reply(id, 0x8180, "example.com", 1, 0x06060606);
+  ut_udp_socket_send(spoof_socket, address, port, spoofed_reply);
+  UtObjectRef request_reply =
+      make_reply(id, 0x0100, "example.com", 1, 0x06060606);
+  ut_udp_socket_send(socket, address, port, request_reply);
+  UtObjectRef wrong_name_reply =
+      make_reply(id, 0x8180, "example.org", 1, 0x06060606);
+  ut_udp_socket_send(socket, address, port, wrong_name_reply);
+  UtObjectRef wrong_type_reply =
+      make_reply(id, 0x8180, "example.com", 28, 0x06060606);
+  ut_udp_socket_send(socket, address, port, wrong_type_reply);
+
+  // Canned response to request for example.com, with the name case changed.
+  reply_address = ut_object_ref(address);
+  reply_port = port;
+  reply = make_reply(id, 0x8180, "eXample.COM", 1, 0x5db8d822);
+  reply_timer = ut_event_loop_add_delay(1, socket, send_reply_cb);
 
-  // Canned response to request for example.com
-  UtObjectRef reply = ut_uint8_array_new();
-  ut_uint8_list_append_uint16_be(reply, id);
-  ut_uint8_list_append_uint16_be(reply, 0xf0); // flags
-  ut_uint8_list_append_uint16_be(reply, 0);
-  ut_uint8_list_append_uint16_be(reply, 1);
-  ut_uint8_list_append_uint16_be(reply, 0);
-  ut_uint8_list_append_uint16_be(reply, 0);
-  ut_uint8_list_append(reply, 7); // name
-  ut_uint8_list_append(reply, 'e');
-  ut_uint8_list_append(reply, 'x');
-  ut_uint8_list_append(reply, 'a');
-  ut_uint8_list_append(reply, 'm');
-  ut_uint8_list_append(reply, 'p');
-  ut_uint8_list_append(reply, 'l');
-  ut_uint8_list_append(reply, 'e');
-  ut_uint8_list_append(reply, 3);
-  ut_uint8_list_append(reply, 'c');
-  ut_uint8_list_append(reply, 'o');
-  ut_uint8_list_append(reply, 'm');
-  ut_uint8_list_append(reply, 0);
-  ut_uint8_list_append_uint16_be(reply, 1);  // type
-  ut_uint8_list_append_uint16_be(reply, 1);  // class
-  ut_uint8_list_append_uint32_be(reply, 60); // ttl
-  ut_uint8_list_append_uint16_be(reply, 4);  // data_length
-  ut_uint8_list_append(reply, 93);           // IP address
-  ut_uint8_list_append(reply, 184);
-  ut_uint8_list_append(reply, 216);
-  ut_uint8_list_append(reply, 34);
-
-  ut_udp_socket_send(socket, ut_udp_datagram_get_address(datagram),
-                     ut_udp_datagram_get_port(datagram), reply);
   return ut_list_get_length(datagrams);
 }
 
@@ -61,6 +101,9 @@ int main(int argc, char **argv) {
   ut_udp_socket_bind(dns_socket, 0);
   uint16_t dns_port = ut_udp_socket_get_port(dns_socket);
 
+  spoof_socket = ut_udp_socket_new_ipv4();
+  ut_udp_socket_bind(spoof_socket, 0);
+
   UtObjectRef address = ut_ipv4_address_new_loopback();
   UtObjectRef client = ut_dns_client_new(address, dns_port);
 
@@ -69,5 +112,10 @@ int main(int argc, char **argv) {
 
   ut_event_loop_run();
 
+  ut_object_unref(spoof_socket);
+  ut_object_unref(reply_timer);
+  ut_object_unref(reply_address);
+  ut_object_unref(reply);
+
   return 0;
 }
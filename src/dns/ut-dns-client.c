@@ -1,36 +1,69 @@
 #include <assert.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <sys/random.h>
 
 #include "ut.h"
 
+// Seconds to wait for a response before resending a query.
+#define QUERY_TIMEOUT 5
+
+// Number of times a query is sent before giving up.
+#define QUERY_ATTEMPTS 2
+
+#define TYPE_A 1
+#define TYPE_SOA 6
+#define TYPE_AAAA 28
+
+#define CLASS_IN 1
+
+#define FLAG_RESPONSE 0x8000
+#define FLAG_RECURSION_DESIRED 0x0100
+
+#define RCODE_NO_ERROR 0
+#define RCODE_NAME_ERROR 3
+
+typedef struct _UtDnsClient UtDnsClient;
+
 typedef struct {
   UtObject object;
+  UtDnsClient *client;
   uint16_t id;
+  uint16_t type;
+  UtObject *message;
+  size_t n_attempts;
+  UtObject *timer;
   UtObject *callback_object;
-  UtDnsLookupCallback callback;
+  UtDnsLookupCallback lookup_callback;
+  UtDnsQueryCallback query_callback;
 } UtDnsQuery;
 
 static void ut_dns_query_cleanup(UtObject *object) {
   UtDnsQuery *self = (UtDnsQuery *)object;
+  ut_object_unref(self->message);
+  if (self->timer != NULL) {
+    ut_event_loop_cancel_timer(self->timer);
+  }
+  ut_object_unref(self->timer);
   ut_object_weak_unref(&self->callback_object);
 }
 
 static UtObjectInterface query_object_interface = {
     .type_name = "DnsQuery", .cleanup = ut_dns_query_cleanup};
 
-typedef struct {
+struct _UtDnsClient {
   UtObject object;
   UtObject *server_address;
   uint16_t port;
   UtObject *socket;
-  uint16_t next_id;
   UtObject *queries;
-} UtDnsClient;
+};
 
 static UtDnsQuery *get_query(UtDnsClient *self, uint16_t id) {
   size_t queries_length = ut_list_get_length(self->queries);
   for (size_t i = 0; i < queries_length; i++) {
-    UtObjectRef query_object = ut_list_get_element(self->queries, i);
-    UtDnsQuery *query = (UtDnsQuery *)query_object;
+    UtDnsQuery *query =
+        (UtDnsQuery *)ut_object_list_get_element(self->queries, i);
     if (query->id == id) {
       return query;
     }
@@ -39,25 +72,14 @@ static UtDnsQuery *get_query(UtDnsClient *self, uint16_t id) {
   return NULL;
 }
 
-static uint16_t add_query(UtDnsClient *self, UtObject *callback_object,
-                          UtDnsLookupCallback callback) {
-  UtObjectRef query_object =
-      ut_object_new(sizeof(UtDnsQuery), &query_object_interface);
-  UtDnsQuery *query = (UtDnsQuery *)query_object;
-
-  while (true) {
-    // FIXME: Use a random number
-    query->id = self->next_id++;
-    if (get_query(self, query->id) == NULL) {
-      break;
+static void remove_query(UtDnsClient *self, UtDnsQuery *query) {
+  size_t queries_length = ut_list_get_length(self->queries);
+  for (size_t i = 0; i < queries_length; i++) {
+    if (ut_object_list_get_element(self->queries, i) == (UtObject *)query) {
+      ut_list_remove(self->queries, i, 1);
+      return;
     }
   }
-
-  ut_object_weak_ref(callback_object, &query->callback_object);
-  query->callback = callback;
-  ut_list_append(self->queries, query_object);
-
-  return query->id;
 }
 
 static void write_name(UtObject *message, const char *name) {
@@ -105,21 +127,16 @@ static void write_lookup(UtObject *message, uint16_t id, uint16_t flags,
   write_question(message, name, type, class);
 }
 
-static void write_ipv4_lookup(UtObject *message, uint16_t id, uint16_t flags,
-                              const char *name) {
-  write_lookup(message, id, flags, name, 1, 1);
-}
-
-static void write_ipv6_lookup(UtObject *message, uint16_t id, uint16_t flags,
-                              const char *name) {
-  write_lookup(message, id, flags, name, 28, 1);
-}
-
 static char *read_name(UtObject *message, size_t *offset) {
+  size_t message_length = ut_list_get_length(message);
   size_t pointer_offset;
   UtObjectRef name = ut_uint8_array_new();
   size_t label_count = 0;
+  size_t n_pointers = 0;
   while (true) {
+    if (*offset >= message_length) {
+      return NULL;
+    }
     uint8_t length = ut_uint8_list_get_element(message, *offset);
     (*offset)++;
     if (length == 0) {
@@ -127,6 +144,9 @@ static char *read_name(UtObject *message, size_t *offset) {
       return (char *)ut_uint8_list_take_data(name);
     }
     if ((length & 0xc0) == 0) {
+      if (*offset + length > message_length) {
+        return NULL;
+      }
       if (label_count > 0) {
         ut_uint8_list_append(name, '.');
       }
@@ -135,10 +155,14 @@ static char *read_name(UtObject *message, size_t *offset) {
       ut_list_append_list(name, label);
       label_count++;
     } else if ((length & 0xc0) == 0xc0) {
+      // Limit pointers to avoid loops.
+      n_pointers++;
+      if (*offset >= message_length || n_pointers > 64) {
+        return NULL;
+      }
       uint8_t length2 = ut_uint8_list_get_element(message, *offset);
       (*offset)++;
       pointer_offset = ((length & 0x3f) << 8) | length2;
-      // FIXME: Validate
       offset = &pointer_offset;
     } else {
       return NULL;
@@ -146,85 +170,185 @@ static char *read_name(UtObject *message, size_t *offset) {
   }
 }
 
-static void read_question(UtObject *message, size_t *offset) {
+static char *read_question(UtObject *message, size_t *offset, uint16_t *type,
+                           uint16_t *class) {
   ut_cstring_ref name = read_name(message, offset);
-  // uint16_t type = ut_uint8_list_get_uint16_be(message, *offset);
+  if (name == NULL || *offset + 4 > ut_list_get_length(message)) {
+    return NULL;
+  }
+  *type = ut_uint8_list_get_uint16_be(message, *offset);
   *offset += 2;
-  // uint16_t class = ut_uint8_list_get_uint16_be(message, *offset);
+  *class = ut_uint8_list_get_uint16_be(message, *offset);
   *offset += 2;
+  return ut_cstring_take(&name);
+}
+
+// Returns true if the question at [offset] in [message] is the one asked in
+// [query]. Names are compared ignoring case, as servers may change it.
+static bool question_matches(UtDnsQuery *query, UtObject *message,
+                             size_t *offset) {
+  uint16_t type, class;
+  ut_cstring_ref name = read_question(message, offset, &type, &class);
+  if (name == NULL) {
+    return false;
+  }
+
+  size_t query_offset = 12;
+  uint16_t query_type, query_class;
+  ut_cstring_ref query_name =
+      read_question(query->message, &query_offset, &query_type, &query_class);
+  return strcasecmp(name, query_name) == 0 && type == query_type &&
+         class == query_class;
 }
 
-static void read_resource_record(UtDnsQuery *query, UtObject *message,
-                                 size_t *offset) {
+// Reads a resource record of [type] from [message].
+// If it is an address record of [query_type], [address] is set.
+// If it is a start of authority record, [minimum_ttl] is set to its minimum TTL
+// field.
+static bool read_resource_record(UtObject *message, size_t *offset,
+                                 uint16_t query_type, UtObject **address,
+                                 uint32_t *ttl, uint32_t *minimum_ttl) {
+  size_t message_length = ut_list_get_length(message);
+
   ut_cstring_ref name = read_name(message, offset);
+  if (name == NULL || *offset + 10 > message_length) {
+    return false;
+  }
   uint16_t type = ut_uint8_list_get_uint16_be(message, *offset);
   *offset += 2;
   uint16_t class = ut_uint8_list_get_uint16_be(message, *offset);
   *offset += 2;
-  // uint32_t ttl = ut_uint8_list_get_uint32_be(message, *offset);
+  *ttl = ut_uint8_list_get_uint32_be(message, *offset);
   *offset += 4;
   uint16_t data_length = ut_uint8_list_get_uint16_be(message, *offset);
   *offset += 2;
+  if (*offset + data_length > message_length) {
+    return false;
+  }
+  size_t data_offset = *offset;
+  *offset += data_length;
 
-  UtObjectRef address = NULL;
-  switch (type) {
-  case 1:
-    assert(class == 1);
-    assert(data_length == 4);
-    address =
-        ut_ipv4_address_new(ut_uint8_list_get_uint32_be(message, *offset));
-    *offset += data_length;
-    break;
-  case 28:
-    assert(class == 1);
-    assert(data_length == 16);
+  *address = NULL;
+  *minimum_ttl = UINT32_MAX;
+  if (class != CLASS_IN) {
+    return true;
+  }
+
+  if (type == TYPE_A && query_type == TYPE_A && data_length == 4) {
+    *address =
+        ut_ipv4_address_new(ut_uint8_list_get_uint32_be(message, data_offset));
+  } else if (type == TYPE_AAAA && query_type == TYPE_AAAA &&
+             data_length == 16) {
     uint8_t address6[16];
     for (size_t i = 0; i < 16; i++) {
-      address6[i] = ut_uint8_list_get_element(message, *offset + i);
+      address6[i] = ut_uint8_list_get_element(message, data_offset + i);
+    }
+    *address = ut_ipv6_address_new(address6);
+  } else if (type == TYPE_SOA) {
+    // Minimum TTL is the last field after two names and four other values.
+    ut_cstring_ref primary_name = read_name(message, &data_offset);
+    ut_cstring_ref mailbox = read_name(message, &data_offset);
+    if (primary_name == NULL || mailbox == NULL ||
+        data_offset + 20 > *offset) {
+      return false;
     }
-    address = ut_ipv6_address_new(address6);
-    *offset += data_length;
-    break;
-  default:
-    *offset += data_length;
-    break;
+    *minimum_ttl = ut_uint8_list_get_uint32_be(message, data_offset + 16);
   }
 
-  // FIXME: Check correct result
-  if (address != NULL && query->callback_object != NULL) {
-    query->callback(query->callback_object, address);
+  return true;
+}
+
+static void complete_query(UtDnsClient *self, UtDnsQuery *query,
+                           UtObject *addresses, uint32_t ttl) {
+  // Keep query alive until callbacks complete.
+  UtObjectRef query_ref = ut_object_ref((UtObject *)query);
+  remove_query(self, query);
+
+  if (query->callback_object == NULL) {
+    return;
+  }
+  if (query->lookup_callback != NULL) {
+    size_t addresses_length = ut_list_get_length(addresses);
+    for (size_t i = 0; i < addresses_length; i++) {
+      query->lookup_callback(query->callback_object,
+                             ut_object_list_get_element(addresses, i));
+    }
+  }
+  if (query->query_callback != NULL) {
+    query->query_callback(query->callback_object, addresses, ttl);
   }
 }
 
-static void process_message(UtDnsClient *self, UtObject *message) {
+static void process_message(UtDnsClient *self, UtObject *datagram) {
+  // Only accept replies from the server, so they can't be spoofed by another
+  // host or local process.
+  if (!ut_object_equal(ut_udp_datagram_get_address(datagram),
+                       self->server_address) ||
+      ut_udp_datagram_get_port(datagram) != self->port) {
+    return;
+  }
+
+  UtObject *message = ut_udp_datagram_get_data(datagram);
   size_t message_length = ut_list_get_length(message);
   if (message_length < 12) {
     return;
   }
   uint16_t id = ut_uint8_list_get_uint16_be(message, 0);
-  // uint16_t flags = ut_uint8_list_get_uint16_be(message, 2);
+  uint16_t flags = ut_uint8_list_get_uint16_be(message, 2);
   uint16_t n_questions = ut_uint8_list_get_uint16_be(message, 4);
   uint16_t n_answers = ut_uint8_list_get_uint16_be(message, 6);
   uint16_t n_authorities = ut_uint8_list_get_uint16_be(message, 8);
-  uint16_t n_additional_records = ut_uint8_list_get_uint16_be(message, 10);
 
   UtDnsQuery *query = get_query(self, id);
-  if (query == NULL) {
+  if (query == NULL || (flags & FLAG_RESPONSE) == 0) {
     return;
   }
 
+  // Replies must contain the question that was asked.
   size_t offset = 12;
-  for (size_t i = 0; i < n_questions; i++) {
-    read_question(message, &offset);
+  if (n_questions != 1 || !question_matches(query, message, &offset)) {
+    return;
   }
+
+  UtObjectRef addresses = ut_object_list_new();
+  uint32_t address_ttl = UINT32_MAX;
   for (size_t i = 0; i < n_answers; i++) {
-    read_resource_record(query, message, &offset);
+    UtObjectRef address = NULL;
+    uint32_t ttl, minimum_ttl;
+    if (!read_resource_record(message, &offset, query->type, &address, &ttl,
+                              &minimum_ttl)) {
+      return;
+    }
+    if (address != NULL) {
+      ut_list_append(addresses, address);
+      if (ttl < address_ttl) {
+        address_ttl = ttl;
+      }
+    }
   }
+
+  // Negative responses are cached using the start of authority record.
+  uint32_t negative_ttl = 0;
   for (size_t i = 0; i < n_authorities; i++) {
-    read_resource_record(query, message, &offset);
+    UtObjectRef address = NULL;
+    uint32_t ttl, minimum_ttl;
+    if (!read_resource_record(message, &offset, query->type, &address, &ttl,
+                              &minimum_ttl)) {
+      break;
+    }
+    if (minimum_ttl != UINT32_MAX) {
+      negative_ttl = ttl < minimum_ttl ? ttl : minimum_ttl;
+    }
   }
-  for (size_t i = 0; i < n_additional_records; i++) {
-    read_resource_record(query, message, &offset);
+
+  uint8_t rcode = flags & 0xf;
+  if (rcode == RCODE_NO_ERROR && ut_list_get_length(addresses) > 0) {
+    complete_query(self, query, addresses, address_ttl);
+  } else if (rcode == RCODE_NO_ERROR || rcode == RCODE_NAME_ERROR) {
+    complete_query(self, query, addresses, negative_ttl);
+  } else {
+    // Server failure, don't cache.
+    complete_query(self, query, addresses, 0);
   }
 }
 
@@ -234,16 +358,71 @@ static size_t read_cb(UtObject *object, UtObject *datagrams, bool complete) {
   size_t datagrams_length = ut_list_get_length(datagrams);
   for (size_t i = 0; i < datagrams_length; i++) {
     UtObjectRef datagram = ut_list_get_element(datagrams, i);
-    // FIXME: Validate address
-    process_message(self, ut_udp_datagram_get_data(datagram));
+    process_message(self, datagram);
   }
 
   return datagrams_length;
 }
 
+static void send_query(UtDnsQuery *query);
+
+static void timeout_cb(UtObject *object) {
+  UtDnsQuery *query = (UtDnsQuery *)object;
+  if (query->n_attempts < QUERY_ATTEMPTS) {
+    send_query(query);
+  } else {
+    UtObjectRef addresses = ut_object_list_new();
+    complete_query(query->client, query, addresses, 0);
+  }
+}
+
+static void send_query(UtDnsQuery *query) {
+  UtDnsClient *self = query->client;
+  query->n_attempts++;
+  ut_object_unref(query->timer);
+  query->timer = ut_event_loop_add_delay(QUERY_TIMEOUT, (UtObject *)query,
+                                         timeout_cb);
+  ut_udp_socket_send(self->socket, self->server_address, self->port,
+                     query->message);
+}
+
+// Returns a random query ID, so replies are hard to forge.
+static uint16_t get_random_id() {
+  uint16_t id;
+  if (getrandom(&id, sizeof(id), 0) != sizeof(id)) {
+    id = rand();
+  }
+  return id;
+}
+
+static void start_query(UtDnsClient *self, const char *name, uint16_t type,
+                        UtObject *callback_object,
+                        UtDnsLookupCallback lookup_callback,
+                        UtDnsQueryCallback query_callback) {
+  UtObjectRef query_object =
+      ut_object_new(sizeof(UtDnsQuery), &query_object_interface);
+  UtDnsQuery *query = (UtDnsQuery *)query_object;
+  query->client = self;
+
+  do {
+    query->id = get_random_id();
+  } while (get_query(self, query->id) != NULL);
+
+  query->type = type;
+  ut_object_weak_ref(callback_object, &query->callback_object);
+  query->lookup_callback = lookup_callback;
+  query->query_callback = query_callback;
+  ut_list_append(self->queries, query_object);
+
+  query->message = ut_uint8_array_new();
+  write_lookup(query->message, query->id, FLAG_RECURSION_DESIRED, name, type,
+               CLASS_IN);
+  send_query(query);
+}
+
 static void ut_dns_client_init(UtObject *object) {
   UtDnsClient *self = (UtDnsClient *)object;
-  self->queries = ut_list_new();
+  self->queries = ut_object_list_new();
 }
 
 static void ut_dns_client_cleanup(UtObject *object) {
@@ -265,7 +444,9 @@ UtObject *ut_dns_client_new(UtObject *server_address, uint16_t port) {
   UtDnsClient *self = (UtDnsClient *)object;
   self->server_address = ut_object_ref(server_address);
   self->port = port;
-  self->socket = ut_udp_socket_new_ipv4();
+  self->socket = ut_object_is_ipv6_address(server_address)
+                     ? ut_udp_socket_new_ipv6()
+                     : ut_udp_socket_new_ipv4();
   ut_input_stream_read(self->socket, object, read_cb);
   return object;
 }
@@ -278,11 +459,7 @@ void ut_dns_client_lookup_ipv4(UtObject *object, const char *name,
 
   assert(callback != NULL);
 
-  uint16_t id = add_query(self, callback_object, callback);
-
-  UtObjectRef message = ut_uint8_array_new();
-  write_ipv4_lookup(message, id, 0, name);
-  ut_udp_socket_send(self->socket, self->server_address, self->port, message);
+  start_query(self, name, TYPE_A, callback_object, callback, NULL);
 }
 
 void ut_dns_client_lookup_ipv6(UtObject *object, const char *name,
@@ -293,11 +470,29 @@ void ut_dns_client_lookup_ipv6(UtObject *object, const char *name,
 
   assert(callback != NULL);
 
-  uint16_t id = add_query(self, callback_object, callback);
+  start_query(self, name, TYPE_AAAA, callback_object, callback, NULL);
+}
+
+void ut_dns_client_query_ipv4(UtObject *object, const char *name,
+                              UtObject *callback_object,
+                              UtDnsQueryCallback callback) {
+  assert(ut_object_is_dns_client(object));
+  UtDnsClient *self = (UtDnsClient *)object;
+
+  assert(callback != NULL);
+
+  start_query(self, name, TYPE_A, callback_object, NULL, callback);
+}
+
+void ut_dns_client_query_ipv6(UtObject *object, const char *name,
+                              UtObject *callback_object,
+                              UtDnsQueryCallback callback) {
+  assert(ut_object_is_dns_client(object));
+  UtDnsClient *self = (UtDnsClient *)object;
+
+  assert(callback != NULL);
 
-  UtObjectRef message = ut_uint8_array_new();
-  write_ipv6_lookup(message, id, 0, name);
-  ut_udp_socket_send(self->socket, self->server_address, self->port, message);
+  start_query(self, name, TYPE_AAAA, callback_object, NULL, callback);
 }
 
 bool ut_object_is_dns_client(UtObject *object) {
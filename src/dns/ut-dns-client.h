@@ -13,6 +13,15 @@
 /// !arg-type address UtIpAddress
 typedef void (*UtDnsLookupCallback)(UtObject *object, UtObject *address);
 
+/// Function called when a DNS query is completed.
+/// [addresses] contains the addresses returned by the server, and is empty if
+/// the name doesn't exist or the query failed.
+/// [ttl] is the number of seconds the result may be cached for.
+///
+/// !arg-type addresses UtObjectList
+typedef void (*UtDnsQueryCallback)(UtObject *object, UtObject *addresses,
+                                   uint32_t ttl);
+
 /// Creates a new DNS client to access the DNS server on [server_address] and
 /// [port].
 ///
@@ -33,5 +42,19 @@ void ut_dns_client_lookup_ipv6(UtObject *object, const char *name,
                                UtObject *callback_object,
                                UtDnsLookupCallback callback);
 
+/// Perform an IPv4 address query for the host with [name].
+/// All the addresses in the response are returned in a single call to
+/// [callback].
+void ut_dns_client_query_ipv4(UtObject *object, const char *name,
+                              UtObject *callback_object,
+                              UtDnsQueryCallback callback);
+
+/// Perform an IPv6 address query for the host with [name].
+/// All the addresses in the response are returned in a single call to
+/// [callback].
+void ut_dns_client_query_ipv6(UtObject *object, const char *name,
+                              UtObject *callback_object,
+                              UtDnsQueryCallback callback);
+
 /// Returns [true] if [object] is a [UtDnsClient].
 bool ut_object_is_dns_client(UtObject *object);
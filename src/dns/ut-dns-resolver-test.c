@@ -0,0 +1,380 @@
+#include <stdio.h>
+
+#include "ut.h"
+
+// Number of requests received by the mock DNS server.
+static size_t n_requests = 0;
+
+// Number of lookups completed.
+static size_t n_lookups = 0;
+
+// Number of requests for failover.example.com, the first two of which fail.
+static size_t n_failover_requests = 0;
+
+// Resolver using configuration text and the number of requests when its test
+// lookups started.
+static UtObject *config_resolver = NULL;
+static size_t config_n_requests = 0;
+
+// Timer to wait for short.example.com to expire.
+static UtObject *expiry_timer = NULL;
+
+// Resolver whose cache is filled, the number of names looked up to fill it
+// and the number of those names looked up again.
+static UtObject *cache_resolver = NULL;
+static size_t n_cache_names = 0;
+static size_t n_cache_lookups = 0;
+
+// Number of names the resolver caches.
+#define MAX_CACHE_LENGTH 256
+
+static void append_name(UtObject *message, const char *name) {
+  const char *label = name;
+  while (*label != '\0') {
+    size_t label_length = 0;
+    while (label[label_length] != '.' && label[label_length] != '\0') {
+      label_length++;
+    }
+    ut_uint8_list_append(message, label_length);
+    ut_uint8_list_append_block(message, (const uint8_t *)label, label_length);
+    label += label_length;
+    if (*label == '.') {
+      label++;
+    }
+  }
+  ut_uint8_list_append(message, 0);
+}
+
+// Handle DNS requests for example.com and some of its subdomains, and report
+// all other names as not existing.
+static size_t dns_read_cb(UtObject *object, UtObject *datagrams,
+                          bool complete) {
+  UtObject *socket = object;
+
+  size_t datagrams_length = ut_list_get_length(datagrams);
+  for (size_t i = 0; i < datagrams_length; i++) {
+    UtObjectRef datagram = ut_list_get_element(datagrams, i);
+    UtObject *request = ut_udp_datagram_get_data(datagram);
+    n_requests++;
+
+    uint16_t id = ut_uint8_list_get_uint16_be(request, 0);
+    size_t offset = 12;
+    UtObjectRef name = ut_uint8_array_new();
+    while (true) {
+      uint8_t length = ut_uint8_list_get_element(request, offset);
+      offset++;
+      if (length == 0) {
+        break;
+      }
+      if (ut_list_get_length(name) > 0) {
+        ut_uint8_list_append(name, '.');
+      }
+      UtObjectRef label = ut_list_get_sublist(request, offset, length);
+      ut_list_append_list(name, label);
+      offset += length;
+    }
+    ut_uint8_list_append(name, '\0');
+    uint16_t type = ut_uint8_list_get_uint16_be(request, offset);
+    const char *name_text = (const char *)ut_uint8_list_get_data(name);
+    bool is_failover = ut_cstring_equal(name_text, "failover.example.com");
+    bool is_short = ut_cstring_equal(name_text, "short.example.com");
+    bool exists = ut_cstring_equal(name_text, "example.com") ||
+                  ut_cstring_equal(name_text, "www.example.com") ||
+                  is_failover || is_short;
+    bool failed = is_failover && n_failover_requests++ < 2;
+
+    uint16_t flags = failed ? 0x8182 : exists ? 0x8180 : 0x8183;
+    UtObjectRef reply = ut_uint8_array_new();
+    ut_uint8_list_append_uint16_be(reply, id);
+    ut_uint8_list_append_uint16_be(reply, flags);
+    ut_uint8_list_append_uint16_be(reply, 1); // n_questions
+    ut_uint8_list_append_uint16_be(reply,
+                                   exists && !failed ? 1 : 0); // n_answers
+    ut_uint8_list_append_uint16_be(reply,
+                                   exists || failed ? 0 : 1); // n_authorities
+    ut_uint8_list_append_uint16_be(reply, 0);
+    append_name(reply, name_text);
+    ut_uint8_list_append_uint16_be(reply, type);
+    ut_uint8_list_append_uint16_be(reply, 1); // class
+    if (failed) {
+      // Server failure has no records.
+    } else if (exists) {
+      ut_uint8_list_append_uint16_be(reply, 0xc00c); // name pointer
+      ut_uint8_list_append_uint16_be(reply, type);
+      ut_uint8_list_append_uint16_be(reply, 1);               // class
+      ut_uint8_list_append_uint32_be(reply, is_short ? 1 : 60); // ttl
+      if (type == 1) {
+        uint8_t address[4] = {93, 184, 216, 34};
+        ut_uint8_list_append_uint16_be(reply, 4);
+        ut_uint8_list_append_block(reply, address, 4);
+      } else {
+        uint8_t address[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+                               0,    0,    0,    0,    0, 0, 0, 1};
+        ut_uint8_list_append_uint16_be(reply, 16);
+        ut_uint8_list_append_block(reply, address, 16);
+      }
+    } else {
+      append_name(reply, "example.com");
+      ut_uint8_list_append_uint16_be(reply, 6);   // SOA
+      ut_uint8_list_append_uint16_be(reply, 1);   // class
+      ut_uint8_list_append_uint32_be(reply, 600); // ttl
+      UtObjectRef soa = ut_uint8_array_new();
+      append_name(soa, "ns.example.com");
+      append_name(soa, "admin.example.com");
+      ut_uint8_list_append_uint32_be(soa, 1);    // serial
+      ut_uint8_list_append_uint32_be(soa, 7200); // refresh
+      ut_uint8_list_append_uint32_be(soa, 3600); // retry
+      ut_uint8_list_append_uint32_be(soa, 1209600); // expire
+      ut_uint8_list_append_uint32_be(soa, 30);      // minimum
+      ut_uint8_list_append_uint16_be(reply, ut_list_get_length(soa));
+      ut_list_append_list(reply, soa);
+    }
+
+    ut_udp_socket_send(socket, ut_udp_datagram_get_address(datagram),
+                       ut_udp_datagram_get_port(datagram), reply);
+  }
+
+  return datagrams_length;
+}
+
+static void check_addresses(UtObject *addresses, const char *address0,
+                            const char *address1) {
+  ut_assert_int_equal(ut_list_get_length(addresses), address1 != NULL ? 2 : 1);
+  ut_cstring_ref address0_string =
+      ut_ip_address_to_string(ut_object_list_get_element(addresses, 0));
+  ut_assert_cstring_equal(address0_string, address0);
+  if (address1 != NULL) {
+    ut_cstring_ref address1_string =
+        ut_ip_address_to_string(ut_object_list_get_element(addresses, 1));
+    ut_assert_cstring_equal(address1_string, address1);
+  }
+}
+
+static void cached_lookup_cb(UtObject *object, UtObject *addresses) {
+  n_lookups++;
+}
+
+static void host_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "192.168.1.2", "fe80::2");
+  n_lookups++;
+}
+
+static void literal_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "10.0.0.1", NULL);
+  n_lookups++;
+}
+
+static void cache_lookup_cb(UtObject *object, UtObject *addresses) {
+  n_cache_lookups++;
+  if (n_cache_lookups == MAX_CACHE_LENGTH) {
+    ut_event_loop_return(NULL);
+  }
+}
+
+static void fill_cache_lookup_cb(UtObject *object, UtObject *addresses);
+
+static void lookup_cache_name(size_t index,
+                              UtDnsResolverLookupCallback callback) {
+  ut_cstring_ref name = ut_cstring_new_printf("name%zi.example.com", index);
+  ut_dns_resolver_lookup(cache_resolver, name, cache_resolver, callback);
+}
+
+static void fill_cache_lookup_cb(UtObject *object, UtObject *addresses) {
+  ut_assert_int_equal(ut_list_get_length(addresses), 0);
+  n_cache_names++;
+  if (n_cache_names < MAX_CACHE_LENGTH) {
+    lookup_cache_name(n_cache_names, fill_cache_lookup_cb);
+    return;
+  }
+
+  // The cache was already full when the last name was added, so the missing
+  // name that expires first was removed. example.com has a longer TTL so is
+  // kept.
+  ut_dns_resolver_lookup(cache_resolver, "example.com", cache_resolver,
+                         cache_lookup_cb);
+  ut_assert_int_equal(n_cache_lookups, 1);
+  n_cache_lookups = 0;
+  for (size_t i = 0; i < MAX_CACHE_LENGTH; i++) {
+    lookup_cache_name(i, cache_lookup_cb);
+  }
+  ut_assert_int_equal(n_cache_lookups, MAX_CACHE_LENGTH - 1);
+}
+
+static void cache_example_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "93.184.216.34", "2001:db8::1");
+  lookup_cache_name(0, fill_cache_lookup_cb);
+}
+
+static void expired_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "93.184.216.34", "2001:db8::1");
+  n_lookups++;
+
+  // Expired entry was queried again.
+  ut_assert_int_equal(n_requests, config_n_requests + 14);
+
+  // Fill the cache of a new resolver with example.com and names that don't
+  // exist.
+  ut_dns_resolver_lookup(cache_resolver, "example.com", cache_resolver,
+                         cache_example_lookup_cb);
+}
+
+static void expiry_cb(UtObject *object) {
+  ut_dns_resolver_lookup(config_resolver, "short.example.com", config_resolver,
+                         expired_lookup_cb);
+}
+
+static void short_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "93.184.216.34", "2001:db8::1");
+  n_lookups++;
+  ut_assert_int_equal(n_requests, config_n_requests + 12);
+
+  // Cached until the one second TTL has passed.
+  ut_dns_resolver_lookup(config_resolver, "short.example.com", config_resolver,
+                         cached_lookup_cb);
+  ut_assert_int_equal(n_requests, config_n_requests + 12);
+  expiry_timer = ut_event_loop_add_delay(2, config_resolver, expiry_cb);
+}
+
+static void failover_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "93.184.216.34", "2001:db8::1");
+  n_lookups++;
+
+  // First server failed, so the second was used.
+  ut_assert_int_equal(n_requests, config_n_requests + 10);
+  ut_assert_int_equal(n_failover_requests, 4);
+
+  ut_dns_resolver_lookup(config_resolver, "short.example.com", config_resolver,
+                         short_lookup_cb);
+}
+
+static void relative_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "93.184.216.34", "2001:db8::1");
+  n_lookups++;
+
+  // example.com.example.com was tried first as the name has less than two
+  // dots.
+  ut_assert_int_equal(n_requests, config_n_requests + 6);
+
+  ut_dns_resolver_lookup(config_resolver, "failover.example.com",
+                         config_resolver, failover_lookup_cb);
+}
+
+static void search_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "93.184.216.34", "2001:db8::1");
+  n_lookups++;
+
+  // www.example.com was found from the search domain.
+  ut_assert_int_equal(n_requests, config_n_requests + 2);
+
+  ut_dns_resolver_lookup(config_resolver, "example.com", config_resolver,
+                         relative_lookup_cb);
+}
+
+static void localhost_lookup_cb(UtObject *object, UtObject *addresses) {
+  check_addresses(addresses, "127.0.0.1", NULL);
+  n_lookups++;
+}
+
+// Check a resolver created from configuration text.
+static void test_config() {
+  // Host names from the hosts file are used without querying the server.
+  ut_dns_resolver_lookup(config_resolver, "printer", config_resolver,
+                         host_lookup_cb);
+  ut_dns_resolver_lookup(config_resolver, "localhost", config_resolver,
+                         localhost_lookup_cb);
+  ut_assert_int_equal(n_requests, config_n_requests);
+
+  ut_dns_resolver_lookup(config_resolver, "www", config_resolver,
+                         search_lookup_cb);
+}
+
+static void missing_lookup_cb(UtObject *object, UtObject *addresses) {
+  UtObject *resolver = object;
+
+  ut_assert_int_equal(ut_list_get_length(addresses), 0);
+  n_lookups++;
+  ut_assert_int_equal(n_requests, 4);
+
+  // Names that don't exist are cached too.
+  ut_dns_resolver_lookup(resolver, "missing.example.com", resolver,
+                         cached_lookup_cb);
+  ut_assert_int_equal(n_lookups, 5);
+  ut_assert_int_equal(n_requests, 4);
+
+  // Host entries are used without querying the server, IPv4 first.
+  UtObjectRef host_address6 = ut_ipv6_address_new_from_string("fe80::2");
+  UtObjectRef host_address4 = ut_ipv4_address_new_from_string("192.168.1.2");
+  ut_dns_resolver_add_host(resolver, "printer.local", host_address6);
+  ut_dns_resolver_add_host(resolver, "printer.local", host_address4);
+  ut_dns_resolver_lookup(resolver, "Printer.Local", resolver, host_lookup_cb);
+  ut_assert_int_equal(n_lookups, 6);
+
+  // Addresses don't need resolving.
+  ut_dns_resolver_lookup(resolver, "10.0.0.1", resolver, literal_lookup_cb);
+  ut_assert_int_equal(n_lookups, 7);
+  ut_assert_int_equal(n_requests, 4);
+
+  config_n_requests = n_requests;
+  test_config();
+}
+
+static void example_lookup_cb(UtObject *object, UtObject *addresses) {
+  UtObject *resolver = object;
+
+  check_addresses(addresses, "93.184.216.34", "2001:db8::1");
+  n_lookups++;
+  if (n_lookups < 2) {
+    return;
+  }
+
+  // Both lookups shared the same A and AAAA queries.
+  ut_assert_int_equal(n_requests, 2);
+
+  // Cached result is returned immediately.
+  ut_dns_resolver_lookup(resolver, "example.com", resolver, cached_lookup_cb);
+  ut_assert_int_equal(n_lookups, 3);
+  ut_assert_int_equal(n_requests, 2);
+
+  ut_dns_resolver_lookup(resolver, "missing.example.com", resolver,
+                         missing_lookup_cb);
+}
+
+int main(int argc, char **argv) {
+  // Make a mock DNS server
+  UtObjectRef dns_socket = ut_udp_socket_new_ipv4();
+  ut_input_stream_read(dns_socket, dns_socket, dns_read_cb);
+  ut_udp_socket_bind(dns_socket, 0);
+  uint16_t dns_port = ut_udp_socket_get_port(dns_socket);
+
+  UtObjectRef address = ut_ipv4_address_new_loopback();
+  UtObjectRef resolver = ut_dns_resolver_new_with_server(address, dns_port);
+  cache_resolver = ut_dns_resolver_new_with_server(address, dns_port);
+
+  // The same server is listed twice to check failing over to the next one.
+  config_resolver = ut_dns_resolver_new_from_config(
+      "# Static hosts\n"
+      "127.0.0.1\tlocalhost\n"
+      "192.168.1.2 printer printer.local # Office printer\n"
+      "fe80::2 printer\n",
+      "# Generated by a network manager\n"
+      "nameserver 127.0.0.1\n"
+      "nameserver 127.0.0.1\n"
+      "nameserver not-an-address\n"
+      "search Example.COM.\n"
+      "options ndots:2 timeout:1\n",
+      dns_port);
+
+  ut_dns_resolver_lookup(resolver, "example.com", resolver, example_lookup_cb);
+  ut_dns_resolver_lookup(resolver, "EXAMPLE.COM.", resolver,
+                         example_lookup_cb);
+
+  ut_event_loop_run();
+
+  ut_assert_int_equal(n_lookups, 15);
+
+  ut_object_unref(config_resolver);
+  ut_object_unref(cache_resolver);
+  ut_object_unref(expiry_timer);
+
+  return 0;
+}
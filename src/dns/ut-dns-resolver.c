@@ -0,0 +1,597 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ut.h"
+
+#define HOSTS_PATH "/etc/hosts"
+#define RESOLV_CONF_PATH "/etc/resolv.conf"
+
+// Maximum number of cached names.
+#define MAX_CACHE_LENGTH 256
+
+// Maximum number of servers used from resolv.conf, as in the C library.
+#define MAX_NAMESERVERS 3
+
+// Limit on the ndots option, as in the C library.
+#define MAX_NDOTS 15
+
+typedef struct _UtDnsResolver UtDnsResolver;
+
+// Addresses returned from the DNS server, valid until [expiry].
+typedef struct {
+  UtObject object;
+  UtObject *addresses;
+  time_t expiry;
+} CacheEntry;
+
+static void cache_entry_cleanup(UtObject *object) {
+  CacheEntry *self = (CacheEntry *)object;
+  ut_object_unref(self->addresses);
+}
+
+static UtObjectInterface cache_entry_object_interface = {
+    .type_name = "DnsCacheEntry", .cleanup = cache_entry_cleanup};
+
+static UtObject *cache_entry_new(UtObject *addresses, time_t expiry) {
+  UtObject *object =
+      ut_object_new(sizeof(CacheEntry), &cache_entry_object_interface);
+  CacheEntry *self = (CacheEntry *)object;
+  self->addresses = ut_object_ref(addresses);
+  self->expiry = expiry;
+  return object;
+}
+
+// Callback waiting on a lookup.
+typedef struct {
+  UtObject object;
+  UtObject *callback_object;
+  UtDnsResolverLookupCallback callback;
+} LookupCallback;
+
+static void lookup_callback_cleanup(UtObject *object) {
+  LookupCallback *self = (LookupCallback *)object;
+  ut_object_weak_unref(&self->callback_object);
+}
+
+static UtObjectInterface lookup_callback_object_interface = {
+    .type_name = "DnsLookupCallback", .cleanup = lookup_callback_cleanup};
+
+static UtObject *lookup_callback_new(UtObject *callback_object,
+                                     UtDnsResolverLookupCallback callback) {
+  UtObject *object =
+      ut_object_new(sizeof(LookupCallback), &lookup_callback_object_interface);
+  LookupCallback *self = (LookupCallback *)object;
+  ut_object_weak_ref(callback_object, &self->callback_object);
+  self->callback = callback;
+  return object;
+}
+
+// Queries in progress for a name. Each of [names] is tried in turn, and each
+// name is tried on the next server if the current one fails.
+typedef struct {
+  UtObject object;
+  UtDnsResolver *resolver;
+  char *key;
+  UtObject *names;
+  size_t name_index;
+  size_t server_index;
+  UtObject *ipv4_addresses;
+  uint32_t ipv4_ttl;
+  UtObject *ipv6_addresses;
+  uint32_t ipv6_ttl;
+  UtObject *callbacks;
+} Lookup;
+
+static void lookup_init(UtObject *object) {
+  Lookup *self = (Lookup *)object;
+  self->callbacks = ut_object_list_new();
+}
+
+static void lookup_cleanup(UtObject *object) {
+  Lookup *self = (Lookup *)object;
+  free(self->key);
+  ut_object_unref(self->names);
+  ut_object_unref(self->ipv4_addresses);
+  ut_object_unref(self->ipv6_addresses);
+  ut_object_unref(self->callbacks);
+}
+
+static UtObjectInterface lookup_object_interface = {.type_name = "DnsLookup",
+                                                    .init = lookup_init,
+                                                    .cleanup = lookup_cleanup};
+
+static UtObject *lookup_new(UtDnsResolver *resolver, const char *key,
+                            UtObject *names) {
+  UtObject *object = ut_object_new(sizeof(Lookup), &lookup_object_interface);
+  Lookup *self = (Lookup *)object;
+  self->resolver = resolver;
+  self->key = ut_cstring_new(key);
+  self->names = ut_object_ref(names);
+  return object;
+}
+
+struct _UtDnsResolver {
+  UtObject object;
+  UtObject *clients;
+  UtObject *search_domains;
+  size_t ndots;
+  UtObject *hosts;
+  UtObject *cache;
+  UtObject *lookups;
+};
+
+static time_t get_time() {
+  struct timespec now;
+  assert(clock_gettime(CLOCK_MONOTONIC, &now) == 0);
+  return now.tv_sec;
+}
+
+// Names are case insensitive and may be fully qualified with a trailing dot.
+static char *normalize_name(const char *name) {
+  char *key = ut_cstring_new_lowercase(name);
+  size_t key_length = ut_cstring_get_length(key);
+  if (key_length > 0 && key[key_length - 1] == '.') {
+    key[key_length - 1] = '\0';
+  }
+  return key;
+}
+
+// Returns [ipv4_addresses] followed by [ipv6_addresses].
+static UtObject *combine_addresses(UtObject *ipv4_addresses,
+                                   UtObject *ipv6_addresses) {
+  UtObject *addresses = ut_object_list_new();
+  ut_list_append_list(addresses, ipv4_addresses);
+  ut_list_append_list(addresses, ipv6_addresses);
+  return addresses;
+}
+
+// Returns the addresses in [cache] for [name] or NULL if not present.
+static UtObject *cache_lookup(UtObject *cache, const char *name) {
+  CacheEntry *entry = (CacheEntry *)ut_map_lookup_string(cache, name);
+  if (entry == NULL) {
+    return NULL;
+  }
+  if (entry->expiry <= get_time()) {
+    UtObjectRef key = ut_string_new(name);
+    ut_map_remove(cache, key);
+    return NULL;
+  }
+
+  return entry->addresses;
+}
+
+static void remove_expired_entries(UtObject *cache) {
+  time_t now = get_time();
+  UtObjectRef items = ut_map_get_items(cache);
+  size_t items_length = ut_list_get_length(items);
+  for (size_t i = 0; i < items_length; i++) {
+    UtObjectRef item = ut_list_get_element(items, i);
+    CacheEntry *entry = (CacheEntry *)ut_map_item_get_value(item);
+    if (entry->expiry <= now) {
+      ut_map_remove(cache, ut_map_item_get_key(item));
+    }
+  }
+}
+
+// Remove the entry in [cache] that expires first.
+static void remove_first_expiring_entry(UtObject *cache) {
+  UtObjectRef items = ut_map_get_items(cache);
+  size_t items_length = ut_list_get_length(items);
+  UtObjectRef first_item = NULL;
+  time_t first_expiry = 0;
+  for (size_t i = 0; i < items_length; i++) {
+    UtObjectRef item = ut_list_get_element(items, i);
+    CacheEntry *entry = (CacheEntry *)ut_map_item_get_value(item);
+    if (first_item == NULL || entry->expiry < first_expiry) {
+      ut_object_unref(first_item);
+      first_item = ut_object_ref(item);
+      first_expiry = entry->expiry;
+    }
+  }
+  if (first_item != NULL) {
+    ut_map_remove(cache, ut_map_item_get_key(first_item));
+  }
+}
+
+static void cache_insert(UtObject *cache, const char *name,
+                         UtObject *addresses, uint32_t ttl) {
+  // Results that can't be cached (e.g. server failures) have no TTL.
+  if (ttl == 0) {
+    return;
+  }
+
+  // When full, make space by removing expired entries, or failing that the
+  // entry that would expire soonest.
+  if (ut_map_get_length(cache) >= MAX_CACHE_LENGTH) {
+    remove_expired_entries(cache);
+  }
+  if (ut_map_get_length(cache) >= MAX_CACHE_LENGTH &&
+      ut_map_lookup_string(cache, name) == NULL) {
+    remove_first_expiring_entry(cache);
+  }
+
+  ut_map_insert_string_take(cache, name,
+                            cache_entry_new(addresses, get_time() + ttl));
+}
+
+static void ipv4_query_cb(UtObject *object, UtObject *addresses,
+                          uint32_t ttl);
+static void ipv6_query_cb(UtObject *object, UtObject *addresses,
+                          uint32_t ttl);
+
+// Query the current name on the current server.
+static void start_queries(Lookup *lookup) {
+  ut_object_clear(&lookup->ipv4_addresses);
+  ut_object_clear(&lookup->ipv6_addresses);
+
+  const char *name =
+      ut_string_list_get_element(lookup->names, lookup->name_index);
+  UtObject *client = ut_object_list_get_element(lookup->resolver->clients,
+                                                lookup->server_index);
+  ut_dns_client_query_ipv4(client, name, (UtObject *)lookup, ipv4_query_cb);
+  ut_dns_client_query_ipv6(client, name, (UtObject *)lookup, ipv6_query_cb);
+}
+
+static void check_lookup_complete(Lookup *lookup) {
+  if (lookup->ipv4_addresses == NULL || lookup->ipv6_addresses == NULL) {
+    return;
+  }
+
+  if (ut_list_get_length(lookup->ipv4_addresses) == 0 &&
+      ut_list_get_length(lookup->ipv6_addresses) == 0) {
+    // Nothing to cache means the server failed or didn't respond, so try the
+    // next server. Otherwise the name doesn't exist, so try the next name.
+    bool failed = lookup->ipv4_ttl == 0 && lookup->ipv6_ttl == 0;
+    if (failed && lookup->server_index + 1 <
+                      ut_list_get_length(lookup->resolver->clients)) {
+      lookup->server_index++;
+      start_queries(lookup);
+      return;
+    }
+    if (lookup->name_index + 1 < ut_list_get_length(lookup->names)) {
+      lookup->name_index++;
+      lookup->server_index = 0;
+      start_queries(lookup);
+      return;
+    }
+  }
+
+  // Keep the lookup alive until callbacks complete.
+  UtObjectRef lookup_ref = ut_object_ref((UtObject *)lookup);
+  UtObjectRef key = ut_string_new(lookup->key);
+  ut_map_remove(lookup->resolver->lookups, key);
+
+  UtObjectRef addresses =
+      combine_addresses(lookup->ipv4_addresses, lookup->ipv6_addresses);
+  cache_insert(lookup->resolver->cache, lookup->key, addresses,
+               lookup->ipv4_ttl < lookup->ipv6_ttl ? lookup->ipv4_ttl
+                                                   : lookup->ipv6_ttl);
+  size_t callbacks_length = ut_list_get_length(lookup->callbacks);
+  for (size_t i = 0; i < callbacks_length; i++) {
+    LookupCallback *callback =
+        (LookupCallback *)ut_object_list_get_element(lookup->callbacks, i);
+    if (callback->callback_object != NULL) {
+      callback->callback(callback->callback_object, addresses);
+    }
+  }
+}
+
+static void ipv4_query_cb(UtObject *object, UtObject *addresses,
+                          uint32_t ttl) {
+  Lookup *lookup = (Lookup *)object;
+  lookup->ipv4_addresses = ut_object_ref(addresses);
+  lookup->ipv4_ttl = ttl;
+  check_lookup_complete(lookup);
+}
+
+static void ipv6_query_cb(UtObject *object, UtObject *addresses,
+                          uint32_t ttl) {
+  Lookup *lookup = (Lookup *)object;
+  lookup->ipv6_addresses = ut_object_ref(addresses);
+  lookup->ipv6_ttl = ttl;
+  check_lookup_complete(lookup);
+}
+
+// Returns [address] parsed from text, or NULL if not a valid address.
+static UtObject *parse_address(const char *text) {
+  UtObjectRef ipv4_address = ut_ipv4_address_new_from_string(text);
+  if (!ut_object_implements_error(ipv4_address)) {
+    return ut_object_ref(ipv4_address);
+  }
+  UtObjectRef ipv6_address = ut_ipv6_address_new_from_string(text);
+  if (!ut_object_implements_error(ipv6_address)) {
+    return ut_object_ref(ipv6_address);
+  }
+  return NULL;
+}
+
+static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Returns the next whitespace separated word in [line] or NULL at the end of
+// the line. Comments starting with '#' are ignored.
+static char *read_word(const char **line) {
+  const char *c = *line;
+  while (is_space(*c)) {
+    c++;
+  }
+  if (*c == '\0' || *c == '\n' || *c == '#') {
+    *line = c;
+    return NULL;
+  }
+
+  const char *start = c;
+  while (*c != '\0' && *c != '\n' && *c != '#' && !is_space(*c)) {
+    c++;
+  }
+  *line = c;
+  return ut_cstring_new_sized(start, c - start);
+}
+
+// Moves [line] to the start of the next line.
+static void next_line(const char **line) {
+  const char *c = *line;
+  while (*c != '\0' && *c != '\n') {
+    c++;
+  }
+  if (*c == '\n') {
+    c++;
+  }
+  *line = c;
+}
+
+// Returns the contents of the file at [path] or NULL if unable to read it.
+// Configuration files are small and read once, so this is done synchronously.
+static char *read_file(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return NULL;
+  }
+
+  UtObjectRef data = ut_uint8_array_new();
+  uint8_t buffer[4096];
+  size_t n_read;
+  while ((n_read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    ut_uint8_list_append_block(data, buffer, n_read);
+  }
+  fclose(file);
+
+  ut_uint8_list_append(data, '\0');
+  return (char *)ut_uint8_list_take_data(data);
+}
+
+static void load_hosts(UtObject *object, const char *text) {
+  const char *line = text;
+  while (*line != '\0') {
+    ut_cstring_ref address_text = read_word(&line);
+    UtObjectRef address =
+        address_text != NULL ? parse_address(address_text) : NULL;
+    if (address != NULL) {
+      while (true) {
+        ut_cstring_ref name = read_word(&line);
+        if (name == NULL) {
+          break;
+        }
+        ut_dns_resolver_add_host(object, name, address);
+      }
+    }
+    next_line(&line);
+  }
+}
+
+// Reads the servers, search domains and options from resolv.conf [text].
+static void load_resolv_conf(UtDnsResolver *self, const char *text,
+                             uint16_t port) {
+  const char *line = text;
+  while (*line != '\0') {
+    ut_cstring_ref option = read_word(&line);
+    if (option == NULL) {
+      // Blank line or comment.
+    } else if (ut_cstring_equal(option, "nameserver")) {
+      ut_cstring_ref address_text = read_word(&line);
+      UtObjectRef address =
+          address_text != NULL ? parse_address(address_text) : NULL;
+      if (address != NULL &&
+          ut_list_get_length(self->clients) < MAX_NAMESERVERS) {
+        ut_list_append_take(self->clients, ut_dns_client_new(address, port));
+      }
+    } else if (ut_cstring_equal(option, "domain") ||
+               ut_cstring_equal(option, "search")) {
+      // The last domain or search line is used.
+      ut_list_clear(self->search_domains);
+      while (true) {
+        ut_cstring_ref domain = read_word(&line);
+        if (domain == NULL) {
+          break;
+        }
+        ut_cstring_ref normalized_domain = normalize_name(domain);
+        ut_string_list_append(self->search_domains, normalized_domain);
+      }
+    } else if (ut_cstring_equal(option, "options")) {
+      while (true) {
+        ut_cstring_ref value = read_word(&line);
+        if (value == NULL) {
+          break;
+        }
+        if (ut_cstring_starts_with(value, "ndots:")) {
+          int ndots = atoi(value + 6);
+          self->ndots = ndots < 0           ? 0
+                        : ndots > MAX_NDOTS ? MAX_NDOTS
+                                            : ndots;
+        }
+      }
+    }
+    next_line(&line);
+  }
+}
+
+// Returns the names to query for [name]. Names with at least ndots dots are
+// tried before the search domains are appended, others after. Names ending in
+// a dot are never searched.
+static UtObject *get_search_names(UtDnsResolver *self, const char *name) {
+  UtObject *names = ut_string_list_new();
+  ut_cstring_ref key = normalize_name(name);
+  size_t name_length = ut_cstring_get_length(name);
+  if (name_length > 0 && name[name_length - 1] == '.') {
+    ut_string_list_append(names, key);
+    return names;
+  }
+
+  size_t n_dots = 0;
+  for (const char *c = key; *c != '\0'; c++) {
+    if (*c == '.') {
+      n_dots++;
+    }
+  }
+
+  if (n_dots >= self->ndots) {
+    ut_string_list_append(names, key);
+  }
+  size_t search_domains_length = ut_list_get_length(self->search_domains);
+  for (size_t i = 0; i < search_domains_length; i++) {
+    ut_string_list_append_printf(
+        names, "%s.%s", key,
+        ut_string_list_get_element(self->search_domains, i));
+  }
+  if (n_dots < self->ndots) {
+    ut_string_list_append(names, key);
+  }
+
+  return names;
+}
+
+static void ut_dns_resolver_init(UtObject *object) {
+  UtDnsResolver *self = (UtDnsResolver *)object;
+  self->clients = ut_object_list_new();
+  self->search_domains = ut_string_list_new();
+  self->ndots = 1;
+  self->hosts = ut_map_new_unordered();
+  self->cache = ut_map_new_unordered();
+  self->lookups = ut_map_new_unordered();
+}
+
+static void ut_dns_resolver_cleanup(UtObject *object) {
+  UtDnsResolver *self = (UtDnsResolver *)object;
+  ut_object_unref(self->clients);
+  ut_object_unref(self->search_domains);
+  ut_object_unref(self->hosts);
+  ut_object_unref(self->cache);
+  ut_object_unref(self->lookups);
+}
+
+static UtObjectInterface object_interface = {.type_name = "UtDnsResolver",
+                                             .init = ut_dns_resolver_init,
+                                             .cleanup =
+                                                 ut_dns_resolver_cleanup};
+
+UtObject *ut_dns_resolver_new() {
+  ut_cstring_ref hosts_text = read_file(HOSTS_PATH);
+  ut_cstring_ref resolv_conf_text = read_file(RESOLV_CONF_PATH);
+  return ut_dns_resolver_new_from_config(hosts_text, resolv_conf_text,
+                                         UT_DNS_DEFAULT_PORT);
+}
+
+UtObject *ut_dns_resolver_new_from_config(const char *hosts,
+                                          const char *resolv_conf,
+                                          uint16_t port) {
+  UtObject *object = ut_object_new(sizeof(UtDnsResolver), &object_interface);
+  UtDnsResolver *self = (UtDnsResolver *)object;
+
+  if (hosts != NULL) {
+    load_hosts(object, hosts);
+  }
+  if (resolv_conf != NULL) {
+    load_resolv_conf(self, resolv_conf, port);
+  }
+  if (ut_list_get_length(self->clients) == 0) {
+    // Default to a local server, as the C library does.
+    UtObjectRef server_address = ut_ipv4_address_new_loopback();
+    ut_list_append_take(self->clients,
+                        ut_dns_client_new(server_address, port));
+  }
+
+  return object;
+}
+
+UtObject *ut_dns_resolver_new_with_server(UtObject *server_address,
+                                          uint16_t port) {
+  UtObject *object = ut_object_new(sizeof(UtDnsResolver), &object_interface);
+  UtDnsResolver *self = (UtDnsResolver *)object;
+  ut_list_append_take(self->clients, ut_dns_client_new(server_address, port));
+  return object;
+}
+
+void ut_dns_resolver_add_host(UtObject *object, const char *name,
+                              UtObject *address) {
+  assert(ut_object_is_dns_resolver(object));
+  UtDnsResolver *self = (UtDnsResolver *)object;
+
+  ut_cstring_ref key = normalize_name(name);
+  UtObject *addresses = ut_map_lookup_string(self->hosts, key);
+  if (addresses == NULL) {
+    addresses = ut_object_list_new();
+    ut_map_insert_string_take(self->hosts, key, addresses);
+  }
+
+  // Keep IPv4 addresses before IPv6 addresses.
+  size_t index = ut_list_get_length(addresses);
+  if (ut_object_is_ipv4_address(address)) {
+    while (index > 0 && ut_object_is_ipv6_address(ut_object_list_get_element(
+                            addresses, index - 1))) {
+      index--;
+    }
+  }
+  ut_list_insert(addresses, index, address);
+}
+
+void ut_dns_resolver_lookup(UtObject *object, const char *name,
+                            UtObject *callback_object,
+                            UtDnsResolverLookupCallback callback) {
+  assert(ut_object_is_dns_resolver(object));
+  UtDnsResolver *self = (UtDnsResolver *)object;
+
+  assert(callback != NULL);
+
+  // Names that are addresses don't need to be resolved.
+  UtObjectRef address = parse_address(name);
+  if (address != NULL) {
+    UtObjectRef addresses = ut_list_new_from_elements(address, NULL);
+    callback(callback_object, addresses);
+    return;
+  }
+
+  ut_cstring_ref key = normalize_name(name);
+
+  UtObject *host_addresses = ut_map_lookup_string(self->hosts, key);
+  if (host_addresses != NULL) {
+    callback(callback_object, host_addresses);
+    return;
+  }
+
+  // Lookups and cached results are shared by requests that search the same
+  // names.
+  UtObjectRef names = get_search_names(self, name);
+  ut_cstring_ref search_key = ut_string_list_join(names, " ");
+
+  UtObject *cached_addresses = cache_lookup(self->cache, search_key);
+  if (cached_addresses != NULL) {
+    callback(callback_object, cached_addresses);
+    return;
+  }
+
+  UtObject *lookup_object = ut_map_lookup_string(self->lookups, search_key);
+  if (lookup_object == NULL) {
+    lookup_object = lookup_new(self, search_key, names);
+    ut_map_insert_string_take(self->lookups, search_key, lookup_object);
+    start_queries((Lookup *)lookup_object);
+  }
+
+  Lookup *lookup = (Lookup *)lookup_object;
+  ut_list_append_take(lookup->callbacks,
+                      lookup_callback_new(callback_object, callback));
+}
+
+bool ut_object_is_dns_resolver(UtObject *object) {
+  return ut_object_is_type(object, &object_interface);
+}
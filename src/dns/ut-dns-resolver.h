@@ -0,0 +1,62 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ut-object.h"
+
+#pragma once
+
+/// Function called when a DNS resolver lookup is completed.
+/// [addresses] is empty if the name could not be resolved.
+///
+/// !arg-type addresses UtObjectList
+typedef void (*UtDnsResolverLookupCallback)(UtObject *object,
+                                            UtObject *addresses);
+
+/// Creates a new DNS resolver using the system configuration.
+/// Hosts are read from /etc/hosts, and the DNS servers, search domains and
+/// ndots option from /etc/resolv.conf.
+///
+/// !return-type UtDnsResolver
+/// !return-ref
+UtObject *ut_dns_resolver_new();
+
+/// Creates a new DNS resolver using [hosts] and [resolv_conf], which are in
+/// the same format as /etc/hosts and /etc/resolv.conf. Either can be [NULL].
+/// DNS servers are sent queries on [port].
+///
+/// !return-type UtDnsResolver
+/// !return-ref
+UtObject *ut_dns_resolver_new_from_config(const char *hosts,
+                                          const char *resolv_conf,
+                                          uint16_t port);
+
+/// Creates a new DNS resolver that sends queries to the DNS server on
+/// [server_address] and [port].
+///
+/// !arg-type server_address UtIpAddress
+/// !return-type UtDnsResolver
+/// !return-ref
+UtObject *ut_dns_resolver_new_with_server(UtObject *server_address,
+                                          uint16_t port);
+
+/// Adds a static entry that resolves [name] to [address], in the same way as
+/// an entry in /etc/hosts.
+///
+/// !arg-type address UtIpAddress
+void ut_dns_resolver_add_host(UtObject *object, const char *name,
+                              UtObject *address);
+
+/// Lookup the IPv4 and IPv6 addresses for [name] and return them in
+/// [callback]. IPv4 addresses are returned first.
+/// Names with fewer dots than the ndots option have the search domains tried
+/// first. If a DNS server fails to reply the next one is used.
+/// Results are cached for the time provided by the DNS server, and concurrent
+/// lookups of the same name share the same queries.
+/// If the result is already known [callback] is called before this function
+/// returns.
+void ut_dns_resolver_lookup(UtObject *object, const char *name,
+                            UtObject *callback_object,
+                            UtDnsResolverLookupCallback callback);
+
+/// Returns [true] if [object] is a [UtDnsResolver].
+bool ut_object_is_dns_resolver(UtObject *object);
@@ -75,6 +75,9 @@ typedef struct {
   // Delay time before showing the next image.
   uint16_t delay_time;
 
+  // Color index not drawn in the next image or -1.
+  int transparent_color_index;
+
   // LZW decoder for image data.
   UtObject *lzw_input_stream;
   UtObject *lzw_decoder;
@@ -245,11 +248,12 @@ static void decode_graphic_control(UtGifDecoder *self, UtObject *sub_blocks) {
 
   uint8_t flags = ut_uint8_list_get_element(data, 0);
   self->delay_time = ut_uint8_list_get_uint16_le(data, 1);
-  // uint8_t transparent_color_index = ut_uint8_list_get_element(data, 3);
 
   self->disposal_method = (flags >> 2) & 0x7;
   // uint8_t user_input = (flags & 0x2) != 0;
-  // uint8_t has_transparent_color = (flags & 0x1) != 0;
+  bool has_transparent_color = (flags & 0x1) != 0;
+  self->transparent_color_index =
+      has_transparent_color ? ut_uint8_list_get_element(data, 3) : -1;
 }
 
 static void decode_netscape_extension(UtGifDecoder *self,
@@ -477,8 +481,15 @@ static size_t decode_image_data(UtGifDecoder *self, UtObject *data) {
       self->image_color_table, self->image_data);
   ut_gif_image_set_disposal_method(image, self->disposal_method);
   ut_gif_image_set_delay_time(image, self->delay_time);
+  ut_gif_image_set_transparent_color_index(image,
+                                           self->transparent_color_index);
   ut_list_append(self->images, image);
 
+  // Graphic control only applies to the image following it.
+  self->disposal_method = UT_GIF_DISPOSAL_METHOD_NONE;
+  self->delay_time = 0;
+  self->transparent_color_index = -1;
+
   uint8_t lzw_min_code_size = ut_uint8_list_get_element(data, 0);
   ut_object_unref(self->lzw_input_stream);
   ut_object_unref(self->lzw_decoder);
@@ -585,6 +596,7 @@ static void ut_gif_decoder_init(UtObject *object) {
   self->loop_count = 1;
   self->comments = ut_string_list_new();
   self->images = ut_object_list_new();
+  self->transparent_color_index = -1;
 }
 
 static void ut_gif_decoder_cleanup(UtObject *object) {
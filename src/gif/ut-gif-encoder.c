@@ -304,15 +304,33 @@ void ut_gif_encoder_encode(UtObject *object) {
     UtGifDisposalMethod disposal_method =
         ut_gif_image_get_disposal_method(image);
     uint16_t delay_time = ut_gif_image_get_delay_time(image);
-    if (disposal_method != UT_GIF_DISPOSAL_METHOD_NONE || delay_time != 0) {
+    int transparent_color_index =
+        ut_gif_image_get_transparent_color_index(image);
+    if (disposal_method != UT_GIF_DISPOSAL_METHOD_NONE || delay_time != 0 ||
+        transparent_color_index >= 0) {
       write_graphic_control_extension(self, disposal_method, false, delay_time,
-                                      -1);
+                                      transparent_color_index);
     }
 
-    write_image_descriptor(self, ut_gif_image_get_left(image),
-                           ut_gif_image_get_top(image),
-                           ut_gif_image_get_width(image),
-                           ut_gif_image_get_height(image), false, 0, false);
+    // Images with a different color table to the global one have their own.
+    UtObject *color_table = ut_gif_image_get_color_table(image);
+    size_t color_table_depth = 0;
+    if (color_table != NULL &&
+        (self->global_color_table == NULL ||
+         !ut_object_equal(color_table, self->global_color_table))) {
+      color_table_depth = get_color_table_depth(color_table);
+      if (color_table_depth == 0) {
+        color_table_depth = 1;
+      }
+    }
+
+    write_image_descriptor(
+        self, ut_gif_image_get_left(image), ut_gif_image_get_top(image),
+        ut_gif_image_get_width(image), ut_gif_image_get_height(image), false,
+        color_table_depth, false);
+    if (color_table_depth > 0) {
+      write_color_table(self, color_table, color_table_depth);
+    }
     write_image_data(self, ut_gif_image_get_data(image));
   }
   write_trailer(self);
@@ -15,6 +15,7 @@ typedef struct {
   uint16_t height;
   UtGifDisposalMethod disposal_method;
   uint16_t delay_time;
+  int transparent_color_index;
   UtObject *color_table;
   UtObject *data;
 } UtGifImage;
@@ -50,6 +51,7 @@ UtObject *ut_gif_image_new(uint16_t left, uint16_t top, uint16_t width,
   self->top = top;
   self->width = width;
   self->height = height;
+  self->transparent_color_index = -1;
   self->color_table = ut_object_ref(color_table);
   self->data = ut_object_ref(data);
 
@@ -105,6 +107,21 @@ uint16_t ut_gif_image_get_delay_time(UtObject *object) {
   return self->delay_time;
 }
 
+void ut_gif_image_set_transparent_color_index(UtObject *object,
+                                              int transparent_color_index) {
+  assert(ut_object_is_gif_image(object));
+  UtGifImage *self = (UtGifImage *)object;
+  assert(transparent_color_index < 256);
+  self->transparent_color_index =
+      transparent_color_index < 0 ? -1 : transparent_color_index;
+}
+
+int ut_gif_image_get_transparent_color_index(UtObject *object) {
+  assert(ut_object_is_gif_image(object));
+  UtGifImage *self = (UtGifImage *)object;
+  return self->transparent_color_index;
+}
+
 UtObject *ut_gif_image_get_color_table(UtObject *object) {
   assert(ut_object_is_gif_image(object));
   UtGifImage *self = (UtGifImage *)object;
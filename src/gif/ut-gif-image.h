@@ -57,6 +57,15 @@ void ut_gif_image_set_delay_time(UtObject *object, uint16_t delay_time);
 /// second.
 uint16_t ut_gif_image_get_delay_time(UtObject *object);
 
+/// Sets the [transparent_color_index] of the pixels that are not drawn, or -1
+/// if all pixels are drawn.
+void ut_gif_image_set_transparent_color_index(UtObject *object,
+                                              int transparent_color_index);
+
+/// Returns the index of the pixels that are not drawn, or -1 if all pixels are
+/// drawn.
+int ut_gif_image_get_transparent_color_index(UtObject *object);
+
 /// Returns the color table for this image.
 ///
 /// !return-type UtUint8List
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ut.h"
+
+// Encode [images] into a GIF and return a renderer for it.
+static UtObject *create_renderer(uint16_t width, uint16_t height,
+                                 UtObject *images) {
+  UtObjectRef data = ut_uint8_array_new();
+  UtObjectRef encoder = ut_gif_encoder_new(width, height, NULL, images, data);
+  ut_gif_encoder_encode(encoder);
+
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_gif_decoder_new(data_stream);
+  UtObjectRef result = ut_gif_decoder_decode_sync(decoder);
+  ut_assert_is_not_error(result);
+
+  return ut_gif_renderer_new(decoder);
+}
+
+// Check [image] covers the given area.
+static void check_image(UtObject *image, uint16_t left, uint16_t top,
+                        uint16_t width, uint16_t height,
+                        UtGifDisposalMethod disposal_method) {
+  ut_assert_int_equal(ut_gif_image_get_left(image), left);
+  ut_assert_int_equal(ut_gif_image_get_top(image), top);
+  ut_assert_int_equal(ut_gif_image_get_width(image), width);
+  ut_assert_int_equal(ut_gif_image_get_height(image), height);
+  ut_assert_int_equal(ut_gif_image_get_disposal_method(image),
+                      disposal_method);
+}
+
+// Exact colors are used when there are few enough of them.
+static void test_rgb() {
+  UtObjectRef frame =
+      ut_uint8_list_new_from_hex_string("ff000000ff000000ff"
+                                        "ffffff000000808080");
+  UtObjectRef quantizer = ut_gif_quantizer_new(3, 2, 3);
+  ut_gif_quantizer_add_frame(quantizer, frame, 0);
+  UtObject *images = ut_gif_quantizer_get_images(quantizer);
+  ut_assert_int_equal(ut_list_get_length(images), 1);
+  check_image(ut_object_list_get_element(images, 0), 0, 0, 3, 2,
+              UT_GIF_DISPOSAL_METHOD_NONE);
+
+  UtObjectRef renderer = create_renderer(3, 2, images);
+  UtObjectRef rgb = ut_gif_renderer_render(renderer);
+  ut_assert_equal(rgb, frame);
+}
+
+// Animations only contain the changed areas.
+static void test_animation() {
+  UtObjectRef frame1 =
+      ut_uint8_list_new_from_hex_string("00000000ff0000ffff0000ff00000000"
+                                        "00000000ff0000ffff0000ff00000000");
+  UtObjectRef frame2 =
+      ut_uint8_list_new_from_hex_string("00000000ff0000ff00ff00ff00000000"
+                                        "00000000ff0000ffff0000ff00000000");
+  UtObjectRef frame3 =
+      ut_uint8_list_new_from_hex_string("00000000ff0000ff00ff00ff00000000"
+                                        "00000000ff0000ff00000000ff0000ff");
+
+  UtObjectRef quantizer = ut_gif_quantizer_new(4, 2, 4);
+  ut_gif_quantizer_add_frame(quantizer, frame1, 10);
+  ut_gif_quantizer_add_frame(quantizer, frame2, 10);
+  ut_gif_quantizer_add_frame(quantizer, frame2, 10);
+  ut_gif_quantizer_add_frame(quantizer, frame3, 10);
+  UtObject *images = ut_gif_quantizer_get_images(quantizer);
+  ut_assert_int_equal(ut_list_get_length(images), 4);
+  check_image(ut_object_list_get_element(images, 0), 1, 0, 2, 2,
+              UT_GIF_DISPOSAL_METHOD_DO_NOT_DISPOSE);
+  check_image(ut_object_list_get_element(images, 1), 2, 0, 1, 1,
+              UT_GIF_DISPOSAL_METHOD_DO_NOT_DISPOSE);
+  // Next frame clears a pixel, so this one is removed after display.
+  check_image(ut_object_list_get_element(images, 2), 0, 0, 4, 2,
+              UT_GIF_DISPOSAL_METHOD_RESTORE_TO_BACKGROUND);
+  check_image(ut_object_list_get_element(images, 3), 1, 0, 3, 2,
+              UT_GIF_DISPOSAL_METHOD_NONE);
+  ut_assert_int_equal(
+      ut_gif_image_get_delay_time(ut_object_list_get_element(images, 3)), 10);
+
+  UtObjectRef renderer = create_renderer(4, 2, images);
+  ut_assert_equal(ut_gif_renderer_render_next(renderer), frame1);
+  ut_assert_equal(ut_gif_renderer_render_next(renderer), frame2);
+  ut_assert_equal(ut_gif_renderer_render_next(renderer), frame2);
+  ut_assert_equal(ut_gif_renderer_render_next(renderer), frame3);
+}
+
+// Create a horizontal gray gradient.
+static UtObject *create_gradient(uint16_t width, uint16_t height) {
+  UtObject *frame = ut_uint8_array_new_sized(width * height * 3);
+  uint8_t *d = ut_uint8_list_get_writable_data(frame);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      memset(d + (y * width + x) * 3, x * 256 / width, 3);
+    }
+  }
+  return frame;
+}
+
+// Returns the largest difference in brightness between [a] and [b] averaged
+// over blocks of [block_width] columns. The first and last blocks are skipped
+// as they may be outside the range of the color table.
+static int get_max_block_error(UtObject *a, UtObject *b, uint16_t width,
+                               uint16_t height, uint16_t block_width) {
+  const uint8_t *a_data = ut_uint8_list_get_data(a);
+  const uint8_t *b_data = ut_uint8_list_get_data(b);
+  int max_error = 0;
+  for (size_t block = block_width; block + block_width < width;
+       block += block_width) {
+    int error = 0;
+    for (size_t y = 0; y < height; y++) {
+      for (size_t x = block; x < block + block_width; x++) {
+        error += a_data[(y * width + x) * 3] - b_data[(y * width + x) * 3];
+      }
+    }
+    error = abs(error) / (block_width * height);
+    max_error = error > max_error ? error : max_error;
+  }
+  return max_error;
+}
+
+// Colors are reduced to the maximum allowed, and dithering keeps the average
+// brightness.
+static void test_dither() {
+  UtObjectRef frame = create_gradient(64, 8);
+
+  UtObjectRef quantizer = ut_gif_quantizer_new(64, 8, 3);
+  ut_gif_quantizer_set_max_colors(quantizer, 4);
+  ut_gif_quantizer_add_frame(quantizer, frame, 0);
+  UtObject *images = ut_gif_quantizer_get_images(quantizer);
+  UtObject *image = ut_object_list_get_element(images, 0);
+  ut_assert_int_equal(ut_list_get_length(ut_gif_image_get_color_table(image)),
+                      4 * 3);
+  UtObjectRef renderer = create_renderer(64, 8, images);
+  UtObjectRef rgb = ut_gif_renderer_render(renderer);
+  int error = get_max_block_error(frame, rgb, 64, 8, 8);
+
+  UtObjectRef dither_quantizer = ut_gif_quantizer_new(64, 8, 3);
+  ut_gif_quantizer_set_max_colors(dither_quantizer, 4);
+  ut_gif_quantizer_set_dither(dither_quantizer, true);
+  ut_gif_quantizer_add_frame(dither_quantizer, frame, 0);
+  UtObjectRef dither_renderer = create_renderer(
+      64, 8, ut_gif_quantizer_get_images(dither_quantizer));
+  UtObjectRef dither_rgb = ut_gif_renderer_render(dither_renderer);
+  int dither_error = get_max_block_error(frame, dither_rgb, 64, 8, 8);
+
+  ut_assert_true(dither_error < 8);
+  ut_assert_true(dither_error < error);
+}
+
+int main(int argc, char **argv) {
+  test_rgb();
+  test_animation();
+  test_dither();
+
+  return 0;
+}
@@ -0,0 +1,520 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ut.h"
+
+// Colors are counted using 5 bits per channel.
+#define N_BINS 32768
+
+// Colors in a frame that map to the same bin.
+typedef struct {
+  uint32_t count;
+  uint64_t red;
+  uint64_t green;
+  uint64_t blue;
+} Bin;
+
+// Range of bins that are converted into a single color by the median cut.
+typedef struct {
+  size_t start;
+  size_t end;
+
+  // Channel with the largest range of values and the size of that range.
+  size_t channel;
+  uint8_t range;
+} Box;
+
+// Area of a frame.
+typedef struct {
+  size_t left;
+  size_t top;
+  size_t width;
+  size_t height;
+} Rect;
+
+typedef struct {
+  UtObject object;
+
+  // Dimensions of frames.
+  uint16_t width;
+  uint16_t height;
+
+  // Number of samples per pixel.
+  size_t n_channels;
+
+  // Maximum number of colors in each image.
+  size_t max_colors;
+
+  // True if using dithering.
+  bool dither;
+
+  // Frame that has not yet been converted, as the disposal method depends on
+  // the next frame.
+  UtObject *pending_data;
+  uint16_t pending_delay_time;
+
+  // Frame shown under the pending frame or NULL if the canvas is empty.
+  UtObject *base_data;
+
+  // Generated images.
+  UtObject *images;
+
+  // Color counts for the current image.
+  Bin *bins;
+
+  // Bins in use.
+  uint16_t *keys;
+  uint16_t *sorted_keys;
+  size_t n_keys;
+
+  // Color table index for each bin, or -1 if not yet calculated.
+  int16_t *lookup;
+} UtGifQuantizer;
+
+static uint16_t get_key(const uint8_t *color) {
+  return (color[0] >> 3) << 10 | (color[1] >> 3) << 5 | color[2] >> 3;
+}
+
+static uint8_t get_key_value(uint16_t key, size_t channel) {
+  return (key >> (10 - channel * 5)) & 0x1f;
+}
+
+static const uint8_t *get_pixel(UtGifQuantizer *self, UtObject *data, size_t x,
+                                size_t y) {
+  if (data == NULL) {
+    return NULL;
+  }
+  return ut_uint8_list_get_data(data) +
+         (y * self->width + x) * self->n_channels;
+}
+
+static bool is_visible(UtGifQuantizer *self, const uint8_t *pixel) {
+  return self->n_channels < 4 || pixel[3] >= 128;
+}
+
+// Returns true if [pixel] needs to be drawn over [base_pixel].
+static bool is_drawn(UtGifQuantizer *self, const uint8_t *pixel,
+                     const uint8_t *base_pixel) {
+  if (!is_visible(self, pixel)) {
+    return false;
+  }
+  return base_pixel == NULL || !is_visible(self, base_pixel) ||
+         memcmp(pixel, base_pixel, 3) != 0;
+}
+
+// Returns true if any pixels visible in [data] are transparent in [next_data].
+static bool has_cleared_pixels(UtGifQuantizer *self, UtObject *data,
+                               UtObject *next_data) {
+  if (self->n_channels < 4) {
+    return false;
+  }
+
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  const uint8_t *next_d = ut_uint8_list_get_data(next_data);
+  size_t n_pixels = (size_t)self->width * self->height;
+  for (size_t i = 0; i < n_pixels; i++) {
+    if (is_visible(self, d + i * 4) && !is_visible(self, next_d + i * 4)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Gets the area of [data] that changed from [base_data]. Returns false if
+// nothing changed.
+static bool get_changed_rect(UtGifQuantizer *self, UtObject *data,
+                             UtObject *base_data, Rect *rect) {
+  size_t left = self->width, top = self->height, right = 0, bottom = 0;
+  for (size_t y = 0; y < self->height; y++) {
+    for (size_t x = 0; x < self->width; x++) {
+      if (is_drawn(self, get_pixel(self, data, x, y),
+                   get_pixel(self, base_data, x, y))) {
+        left = x < left ? x : left;
+        right = x + 1 > right ? x + 1 : right;
+        top = y < top ? y : top;
+        bottom = y + 1;
+      }
+    }
+  }
+  if (right == 0) {
+    return false;
+  }
+
+  rect->left = left;
+  rect->top = top;
+  rect->width = right - left;
+  rect->height = bottom - top;
+  return true;
+}
+
+// Counts the colors drawn in [rect]. Returns the number of pixels drawn.
+static size_t count_colors(UtGifQuantizer *self, UtObject *data,
+                           UtObject *base_data, Rect *rect) {
+  for (size_t i = 0; i < self->n_keys; i++) {
+    memset(&self->bins[self->keys[i]], 0, sizeof(Bin));
+  }
+  self->n_keys = 0;
+
+  size_t n_drawn = 0;
+  for (size_t y = rect->top; y < rect->top + rect->height; y++) {
+    for (size_t x = rect->left; x < rect->left + rect->width; x++) {
+      const uint8_t *pixel = get_pixel(self, data, x, y);
+      if (!is_drawn(self, pixel, get_pixel(self, base_data, x, y))) {
+        continue;
+      }
+
+      uint16_t key = get_key(pixel);
+      Bin *bin = &self->bins[key];
+      if (bin->count == 0) {
+        self->keys[self->n_keys] = key;
+        self->n_keys++;
+      }
+      bin->count++;
+      bin->red += pixel[0];
+      bin->green += pixel[1];
+      bin->blue += pixel[2];
+      n_drawn++;
+    }
+  }
+
+  return n_drawn;
+}
+
+static void update_box(UtGifQuantizer *self, Box *box) {
+  uint8_t min[3] = {31, 31, 31}, max[3] = {0, 0, 0};
+  for (size_t i = box->start; i < box->end; i++) {
+    for (size_t c = 0; c < 3; c++) {
+      uint8_t value = get_key_value(self->keys[i], c);
+      min[c] = value < min[c] ? value : min[c];
+      max[c] = value > max[c] ? value : max[c];
+    }
+  }
+
+  box->channel = 0;
+  box->range = 0;
+  for (size_t c = 0; c < 3; c++) {
+    if (max[c] - min[c] > box->range) {
+      box->channel = c;
+      box->range = max[c] - min[c];
+    }
+  }
+}
+
+// Splits [box] at the median pixel of its widest channel, with the upper half
+// going into [new_box].
+static void split_box(UtGifQuantizer *self, Box *box, Box *new_box) {
+  // Counting sort on the channel value.
+  size_t offsets[33] = {0};
+  for (size_t i = box->start; i < box->end; i++) {
+    offsets[get_key_value(self->keys[i], box->channel) + 1]++;
+  }
+  for (size_t i = 1; i < 33; i++) {
+    offsets[i] += offsets[i - 1];
+  }
+  for (size_t i = box->start; i < box->end; i++) {
+    uint8_t value = get_key_value(self->keys[i], box->channel);
+    self->sorted_keys[box->start + offsets[value]] = self->keys[i];
+    offsets[value]++;
+  }
+  memcpy(self->keys + box->start, self->sorted_keys + box->start,
+         (box->end - box->start) * sizeof(uint16_t));
+
+  uint64_t total = 0;
+  for (size_t i = box->start; i < box->end; i++) {
+    total += self->bins[self->keys[i]].count;
+  }
+  size_t split = box->end - 1;
+  uint64_t count = 0;
+  for (size_t i = box->start; i < box->end - 1; i++) {
+    count += self->bins[self->keys[i]].count;
+    if (count * 2 >= total) {
+      split = i + 1;
+      break;
+    }
+  }
+
+  new_box->start = split;
+  new_box->end = box->end;
+  box->end = split;
+  update_box(self, box);
+  update_box(self, new_box);
+}
+
+// Generates up to [max_colors] in [color_table] from the counted colors.
+// Returns the number of colors generated.
+static size_t make_color_table(UtGifQuantizer *self, size_t max_colors,
+                               uint8_t *color_table) {
+  if (self->n_keys == 0) {
+    return 0;
+  }
+
+  Box boxes[256];
+  size_t n_boxes = 1;
+  boxes[0].start = 0;
+  boxes[0].end = self->n_keys;
+  update_box(self, &boxes[0]);
+  while (n_boxes < max_colors) {
+    Box *widest = NULL;
+    for (size_t i = 0; i < n_boxes; i++) {
+      if (boxes[i].end - boxes[i].start > 1 &&
+          (widest == NULL || boxes[i].range > widest->range)) {
+        widest = &boxes[i];
+      }
+    }
+    if (widest == NULL) {
+      break;
+    }
+
+    split_box(self, widest, &boxes[n_boxes]);
+    n_boxes++;
+  }
+
+  for (size_t i = 0; i < n_boxes; i++) {
+    uint64_t count = 0, red = 0, green = 0, blue = 0;
+    for (size_t j = boxes[i].start; j < boxes[i].end; j++) {
+      Bin *bin = &self->bins[self->keys[j]];
+      count += bin->count;
+      red += bin->red;
+      green += bin->green;
+      blue += bin->blue;
+    }
+    color_table[i * 3 + 0] = (red + count / 2) / count;
+    color_table[i * 3 + 1] = (green + count / 2) / count;
+    color_table[i * 3 + 2] = (blue + count / 2) / count;
+  }
+
+  return n_boxes;
+}
+
+// Returns the index of the closest color in [color_table] to [color].
+static uint8_t lookup_color(UtGifQuantizer *self, const uint8_t *color_table,
+                            size_t color_table_length, const uint8_t *color) {
+  uint16_t key = get_key(color);
+  if (self->lookup[key] >= 0) {
+    return self->lookup[key];
+  }
+
+  // Match using the center of the bin.
+  int value[3];
+  for (size_t c = 0; c < 3; c++) {
+    value[c] = get_key_value(key, c) << 3 | 0x4;
+  }
+  size_t best_index = 0;
+  int best_distance = -1;
+  for (size_t i = 0; i < color_table_length; i++) {
+    int distance = 0;
+    for (size_t c = 0; c < 3; c++) {
+      int d = value[c] - color_table[i * 3 + c];
+      distance += d * d;
+    }
+    if (best_distance < 0 || distance < best_distance) {
+      best_index = i;
+      best_distance = distance;
+    }
+  }
+
+  self->lookup[key] = best_index;
+  return best_index;
+}
+
+static uint8_t clamp(int value) {
+  return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// Converts [data] into a GIF image drawn over [base_data].
+static void add_image(UtGifQuantizer *self, UtObject *data,
+                      UtObject *base_data, uint16_t delay_time,
+                      UtGifDisposalMethod disposal_method) {
+  Rect rect = {0, 0, 1, 1};
+  if (disposal_method == UT_GIF_DISPOSAL_METHOD_RESTORE_TO_BACKGROUND) {
+    rect.width = self->width;
+    rect.height = self->height;
+  } else {
+    get_changed_rect(self, data, base_data, &rect);
+  }
+
+  size_t n_drawn = count_colors(self, data, base_data, &rect);
+  bool has_transparency = n_drawn < rect.width * rect.height;
+  size_t max_colors = self->max_colors - (has_transparency ? 1 : 0);
+  uint8_t colors[256 * 3];
+  size_t n_colors = make_color_table(self, max_colors, colors);
+  int transparent_color_index = -1;
+  if (has_transparency) {
+    transparent_color_index = n_colors;
+    memset(colors + n_colors * 3, 0, 3);
+    n_colors++;
+  }
+  UtObjectRef color_table = ut_uint8_array_new_from_data(colors, n_colors * 3);
+
+  memset(self->lookup, 0xff, N_BINS * sizeof(int16_t));
+  UtObjectRef image_data = ut_uint8_array_new_sized(rect.width * rect.height);
+  uint8_t *indexes = ut_uint8_list_get_writable_data(image_data);
+
+  // Error carried to the current and next rows, scaled by 16.
+  int *errors = NULL, *next_errors = NULL;
+  if (self->dither) {
+    errors = calloc((rect.width + 2) * 3, sizeof(int));
+    next_errors = calloc((rect.width + 2) * 3, sizeof(int));
+  }
+
+  for (size_t y = 0; y < rect.height; y++) {
+    for (size_t x = 0; x < rect.width; x++) {
+      const uint8_t *pixel = get_pixel(self, data, rect.left + x, rect.top + y);
+      const uint8_t *base_pixel =
+          get_pixel(self, base_data, rect.left + x, rect.top + y);
+      uint8_t *index = indexes + y * rect.width + x;
+      if (!is_drawn(self, pixel, base_pixel)) {
+        *index = transparent_color_index;
+        continue;
+      }
+
+      if (!self->dither) {
+        *index = lookup_color(self, colors, n_colors, pixel);
+        continue;
+      }
+
+      int *e = errors + (x + 1) * 3;
+      uint8_t color[3];
+      for (size_t c = 0; c < 3; c++) {
+        color[c] = clamp(pixel[c] + e[c] / 16);
+      }
+      *index = lookup_color(self, colors, n_colors, color);
+      for (size_t c = 0; c < 3; c++) {
+        int error = color[c] - colors[*index * 3 + c];
+        errors[(x + 2) * 3 + c] += error * 7;
+        next_errors[x * 3 + c] += error * 3;
+        next_errors[(x + 1) * 3 + c] += error * 5;
+        next_errors[(x + 2) * 3 + c] += error;
+      }
+    }
+
+    if (self->dither) {
+      int *t = errors;
+      errors = next_errors;
+      next_errors = t;
+      memset(next_errors, 0, (rect.width + 2) * 3 * sizeof(int));
+    }
+  }
+  free(errors);
+  free(next_errors);
+
+  UtObjectRef image = ut_gif_image_new(rect.left, rect.top, rect.width,
+                                       rect.height, color_table, image_data);
+  ut_gif_image_set_disposal_method(image, disposal_method);
+  ut_gif_image_set_delay_time(image, delay_time);
+  ut_gif_image_set_transparent_color_index(image, transparent_color_index);
+  ut_list_append(self->images, image);
+}
+
+// Converts the pending frame, which is followed by [next_data] or is the last
+// frame if [next_data] is NULL.
+static void flush_pending(UtGifQuantizer *self, UtObject *next_data) {
+  // If the next frame makes pixels transparent the canvas has to be cleared
+  // and redrawn.
+  UtGifDisposalMethod disposal_method = UT_GIF_DISPOSAL_METHOD_NONE;
+  if (next_data != NULL) {
+    disposal_method = has_cleared_pixels(self, self->pending_data, next_data)
+                          ? UT_GIF_DISPOSAL_METHOD_RESTORE_TO_BACKGROUND
+                          : UT_GIF_DISPOSAL_METHOD_DO_NOT_DISPOSE;
+  }
+
+  add_image(self, self->pending_data, self->base_data,
+            self->pending_delay_time, disposal_method);
+
+  ut_object_clear(&self->base_data);
+  if (disposal_method != UT_GIF_DISPOSAL_METHOD_RESTORE_TO_BACKGROUND) {
+    self->base_data = ut_object_ref(self->pending_data);
+  }
+  ut_object_clear(&self->pending_data);
+}
+
+static void ut_gif_quantizer_init(UtObject *object) {
+  UtGifQuantizer *self = (UtGifQuantizer *)object;
+  self->max_colors = 256;
+  self->images = ut_object_list_new();
+  self->bins = calloc(N_BINS, sizeof(Bin));
+  self->keys = malloc(N_BINS * sizeof(uint16_t));
+  self->sorted_keys = malloc(N_BINS * sizeof(uint16_t));
+  self->lookup = malloc(N_BINS * sizeof(int16_t));
+}
+
+static void ut_gif_quantizer_cleanup(UtObject *object) {
+  UtGifQuantizer *self = (UtGifQuantizer *)object;
+  ut_object_unref(self->pending_data);
+  ut_object_unref(self->base_data);
+  ut_object_unref(self->images);
+  free(self->bins);
+  free(self->keys);
+  free(self->sorted_keys);
+  free(self->lookup);
+}
+
+static UtObjectInterface object_interface = {
+    .type_name = "UtGifQuantizer",
+    .init = ut_gif_quantizer_init,
+    .cleanup = ut_gif_quantizer_cleanup};
+
+UtObject *ut_gif_quantizer_new(uint16_t width, uint16_t height,
+                               size_t n_channels) {
+  assert(n_channels == 3 || n_channels == 4);
+  UtObject *object = ut_object_new(sizeof(UtGifQuantizer), &object_interface);
+  UtGifQuantizer *self = (UtGifQuantizer *)object;
+  self->width = width;
+  self->height = height;
+  self->n_channels = n_channels;
+  return object;
+}
+
+void ut_gif_quantizer_set_max_colors(UtObject *object, size_t max_colors) {
+  assert(ut_object_is_gif_quantizer(object));
+  UtGifQuantizer *self = (UtGifQuantizer *)object;
+  assert(max_colors >= 2 && max_colors <= 256);
+  self->max_colors = max_colors;
+}
+
+void ut_gif_quantizer_set_dither(UtObject *object, bool dither) {
+  assert(ut_object_is_gif_quantizer(object));
+  UtGifQuantizer *self = (UtGifQuantizer *)object;
+  self->dither = dither;
+}
+
+void ut_gif_quantizer_add_frame(UtObject *object, UtObject *data,
+                                uint16_t delay_time) {
+  assert(ut_object_is_gif_quantizer(object));
+  UtGifQuantizer *self = (UtGifQuantizer *)object;
+
+  size_t data_length = (size_t)self->width * self->height * self->n_channels;
+  assert(ut_list_get_length(data) == data_length);
+
+  // Keep a copy as the caller may reuse [data] for the next frame.
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  UtObjectRef array = NULL;
+  if (d == NULL) {
+    array = ut_uint8_list_get_array(data);
+    d = ut_uint8_list_get_data(array);
+  }
+  UtObjectRef frame = ut_uint8_array_new_from_data(d, data_length);
+
+  if (self->pending_data != NULL) {
+    flush_pending(self, frame);
+  }
+  self->pending_data = ut_object_ref(frame);
+  self->pending_delay_time = delay_time;
+}
+
+UtObject *ut_gif_quantizer_get_images(UtObject *object) {
+  assert(ut_object_is_gif_quantizer(object));
+  UtGifQuantizer *self = (UtGifQuantizer *)object;
+
+  if (self->pending_data != NULL) {
+    flush_pending(self, NULL);
+  }
+
+  return self->images;
+}
+
+bool ut_object_is_gif_quantizer(UtObject *object) {
+  return ut_object_is_type(object, &object_interface);
+}
@@ -0,0 +1,40 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ut-object.h"
+
+#pragma once
+
+/// Creates a new quantizer that converts frames of [width]x[height] pixels
+/// into GIF images. Each pixel in a frame has [n_channels] 8 bit samples,
+/// either RGB (3) or RGBA (4). Pixels with an alpha below 128 are transparent.
+///
+/// !return-ref
+/// !return-type UtGifQuantizer
+UtObject *ut_gif_quantizer_new(uint16_t width, uint16_t height,
+                               size_t n_channels);
+
+/// Sets the [max_colors] (2-256) in the color table of each image. Defaults
+/// to 256.
+void ut_gif_quantizer_set_max_colors(UtObject *object, size_t max_colors);
+
+/// Sets if Floyd-Steinberg [dither]ing is used to reduce banding. Defaults to
+/// [false].
+void ut_gif_quantizer_set_dither(UtObject *object, bool dither);
+
+/// Adds a frame with pixel [data] to be shown for [delay_time] 1/100th of a
+/// second. Each image only contains the area that changed from the previous
+/// frame and has its own color table.
+///
+/// !arg-type data UtUint8List
+void ut_gif_quantizer_add_frame(UtObject *object, UtObject *data,
+                                uint16_t delay_time);
+
+/// Returns the images generated from the frames added, suitable to pass to
+/// [ut_gif_encoder_new].
+///
+/// !return-type UtObjectList
+UtObject *ut_gif_quantizer_get_images(UtObject *object);
+
+/// Returns [true] if [object] is a [UtGifQuantizer].
+bool ut_object_is_gif_quantizer(UtObject *object);
@@ -0,0 +1,137 @@
+#include <string.h>
+
+#include "ut.h"
+
+// Color table containing red, green, blue and white.
+static const char *color_table_data = "ff000000ff000000ffffffff";
+
+// Create an image at [left], [top] using the color indexes in [hex_data].
+static UtObject *create_image(uint16_t left, uint16_t top, uint16_t width,
+                              uint16_t height, const char *hex_data,
+                              UtGifDisposalMethod disposal_method,
+                              int transparent_color_index) {
+  UtObjectRef color_table = ut_uint8_list_new_from_hex_string(color_table_data);
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(hex_data);
+  UtObject *image =
+      ut_gif_image_new(left, top, width, height, color_table, data);
+  ut_gif_image_set_disposal_method(image, disposal_method);
+  ut_gif_image_set_transparent_color_index(image, transparent_color_index);
+  return image;
+}
+
+// Encode [images] into a GIF and return a renderer for it.
+static UtObject *create_renderer(uint16_t width, uint16_t height,
+                                 UtObject *images) {
+  UtObjectRef color_table = ut_uint8_list_new_from_hex_string(color_table_data);
+  UtObjectRef data = ut_uint8_array_new();
+  UtObjectRef encoder =
+      ut_gif_encoder_new(width, height, color_table, images, data);
+  ut_gif_encoder_encode(encoder);
+
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_gif_decoder_new(data_stream);
+  UtObjectRef result = ut_gif_decoder_decode_sync(decoder);
+  ut_assert_is_not_error(result);
+
+  return ut_gif_renderer_new(decoder);
+}
+
+// Check the next frame matches [pixels], where each pixel is 'R', 'G', 'B',
+// 'W' or 'T' for transparent.
+static void check_frame(UtObject *renderer, const char *pixels) {
+  UtObject *frame = ut_gif_renderer_render_next(renderer);
+  ut_assert_non_null_object(frame);
+
+  UtObjectRef expected = ut_uint8_array_new();
+  for (const char *p = pixels; *p != '\0'; p++) {
+    uint8_t rgba[4] = {0x00, 0x00, 0x00, 0x00};
+    switch (*p) {
+    case 'R':
+      rgba[0] = rgba[3] = 0xff;
+      break;
+    case 'G':
+      rgba[1] = rgba[3] = 0xff;
+      break;
+    case 'B':
+      rgba[2] = rgba[3] = 0xff;
+      break;
+    case 'W':
+      memset(rgba, 0xff, 4);
+      break;
+    }
+    ut_uint8_list_append_block(expected, rgba, 4);
+  }
+  ut_assert_equal(frame, expected);
+}
+
+static void test_disposal() {
+  UtObjectRef images = ut_object_list_new();
+  ut_list_append_take(
+      images, create_image(0, 0, 4, 4, "00000000000000000000000000000000",
+                           UT_GIF_DISPOSAL_METHOD_DO_NOT_DISPOSE, -1));
+  ut_list_append_take(
+      images, create_image(1, 1, 2, 2, "01030101",
+                           UT_GIF_DISPOSAL_METHOD_RESTORE_TO_BACKGROUND, 3));
+  ut_list_append_take(
+      images, create_image(2, 0, 2, 2, "02020202",
+                           UT_GIF_DISPOSAL_METHOD_RESTORE_TO_PREVIOUS, -1));
+  ut_list_append_take(
+      images,
+      create_image(0, 3, 1, 1, "03", UT_GIF_DISPOSAL_METHOD_NONE, -1));
+  UtObjectRef renderer = create_renderer(4, 4, images);
+
+  check_frame(renderer, "RRRR"
+                        "RRRR"
+                        "RRRR"
+                        "RRRR");
+  check_frame(renderer, "RRRR"
+                        "RGRR"
+                        "RGGR"
+                        "RRRR");
+  check_frame(renderer, "RRBB"
+                        "RTBB"
+                        "RTTR"
+                        "RRRR");
+  check_frame(renderer, "RRRR"
+                        "RTTR"
+                        "RTTR"
+                        "WRRR");
+  ut_assert_null_object(ut_gif_renderer_render_next(renderer));
+
+  // Can render again from the start.
+  ut_gif_renderer_reset(renderer);
+  check_frame(renderer, "RRRR"
+                        "RRRR"
+                        "RRRR"
+                        "RRRR");
+
+  UtObjectRef rgb = ut_gif_renderer_render(renderer);
+  ut_assert_uint8_list_equal_hex(rgb, "ff0000ff0000ff0000ff0000"
+                                      "ff0000000000000000ff0000"
+                                      "ff0000000000000000ff0000"
+                                      "ffffffff0000ff0000ff0000");
+}
+
+// Check rows long enough to be expanded in blocks of pixels.
+static void test_wide() {
+  UtObjectRef images = ut_object_list_new();
+  ut_list_append_take(
+      images,
+      create_image(0, 0, 19, 1, "00000000000000000000000000000000000000",
+                   UT_GIF_DISPOSAL_METHOD_NONE, -1));
+  ut_list_append_take(
+      images,
+      create_image(1, 0, 20, 1, "0103010301030103010301030103010301030103",
+                   UT_GIF_DISPOSAL_METHOD_NONE, 3));
+  UtObjectRef renderer = create_renderer(19, 1, images);
+
+  check_frame(renderer, "RRRRRRRRRRRRRRRRRRR");
+  check_frame(renderer, "RGRGRGRGRGRGRGRGRGR");
+}
+
+int main(int argc, char **argv) {
+  test_disposal();
+  test_wide();
+
+  return 0;
+}
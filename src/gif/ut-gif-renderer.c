@@ -1,17 +1,213 @@
 #include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ut-cpu-private.h"
 #include "ut.h"
 
+// Function to write a row of color indexes as RGBA pixels using a lookup
+// table, leaving pixels with [transparent_color_index] unchanged.
+typedef void (*ExpandRowFunction)(const uint32_t *lut, const uint8_t *indexes,
+                                  uint8_t *output, size_t length,
+                                  int transparent_color_index);
+
+// Area of the canvas covered by an image.
+typedef struct {
+  size_t left;
+  size_t top;
+  size_t width;
+  size_t height;
+} Rect;
+
 typedef struct {
   UtObject object;
 
   // Decoded image being rendered.
   UtObject *decoder;
+
+  // RGBA image that frames are composited onto.
+  UtObject *canvas;
+
+  // Index of the next image to render.
+  size_t next_image;
+
+  // Canvas under the last image, used to restore to previous.
+  uint8_t *previous;
+  size_t previous_length;
 } UtGifRenderer;
 
+static void expand_row_scalar(const uint32_t *lut, const uint8_t *indexes,
+                              uint8_t *output, size_t length,
+                              int transparent_color_index) {
+  for (size_t i = 0; i < length; i++) {
+    if (indexes[i] != transparent_color_index) {
+      memcpy(output + i * 4, &lut[indexes[i]], 4);
+    }
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static void
+expand_row_avx2(const uint32_t *lut, const uint8_t *indexes, uint8_t *output,
+                size_t length, int transparent_color_index) {
+  size_t i = 0;
+  if (transparent_color_index < 0) {
+    for (; i + 8 <= length; i += 8) {
+      __m256i index = _mm256_cvtepu8_epi32(
+          _mm_loadl_epi64((const __m128i *)(indexes + i)));
+      __m256i color = _mm256_i32gather_epi32((const int *)lut, index, 4);
+      _mm256_storeu_si256((__m256i *)(output + i * 4), color);
+    }
+  } else {
+    __m256i transparent = _mm256_set1_epi32(transparent_color_index);
+    for (; i + 8 <= length; i += 8) {
+      __m256i index = _mm256_cvtepu8_epi32(
+          _mm_loadl_epi64((const __m128i *)(indexes + i)));
+      __m256i color = _mm256_i32gather_epi32((const int *)lut, index, 4);
+      __m256i existing = _mm256_loadu_si256((const __m256i *)(output + i * 4));
+      __m256i is_transparent = _mm256_cmpeq_epi32(index, transparent);
+      _mm256_storeu_si256((__m256i *)(output + i * 4),
+                          _mm256_blendv_epi8(color, existing, is_transparent));
+    }
+  }
+
+  expand_row_scalar(lut, indexes + i, output + i * 4, length - i,
+                    transparent_color_index);
+}
+#endif
+
+static ExpandRowFunction expand_row_function = NULL;
+static pthread_once_t functions_once = PTHREAD_ONCE_INIT;
+
+// Choose the fastest function the CPU supports.
+static void select_functions() {
+  ExpandRowFunction f = expand_row_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+  if (_ut_cpu_has_avx2()) {
+    f = expand_row_avx2;
+  }
+#endif
+
+  expand_row_function = f;
+}
+
+static ExpandRowFunction get_expand_row_function() {
+  pthread_once(&functions_once, select_functions);
+  return expand_row_function;
+}
+
+// Get the area of the canvas covered by [image]. Returns false if the image is
+// outside the canvas.
+static bool get_image_rect(UtGifRenderer *self, UtObject *image, Rect *rect) {
+  size_t width = ut_gif_decoder_get_width(self->decoder);
+  size_t height = ut_gif_decoder_get_height(self->decoder);
+  size_t image_left = ut_gif_image_get_left(image);
+  size_t image_top = ut_gif_image_get_top(image);
+  size_t image_width = ut_gif_image_get_width(image);
+  size_t image_height = ut_gif_image_get_height(image);
+  if (image_left >= width || image_top >= height) {
+    return false;
+  }
+
+  rect->left = image_left;
+  rect->top = image_top;
+  rect->width =
+      image_left + image_width > width ? width - image_left : image_width;
+  rect->height =
+      image_top + image_height > height ? height - image_top : image_height;
+  return true;
+}
+
+// Returns the address of the pixel at [x], [y] in the canvas.
+static uint8_t *get_canvas_pixel(UtGifRenderer *self, size_t x, size_t y) {
+  size_t width = ut_gif_decoder_get_width(self->decoder);
+  return ut_uint8_list_get_writable_data(self->canvas) + (y * width + x) * 4;
+}
+
+// Set the area of the canvas under [image] to transparent.
+static void clear_image(UtGifRenderer *self, UtObject *image) {
+  Rect rect;
+  if (!get_image_rect(self, image, &rect)) {
+    return;
+  }
+  for (size_t y = 0; y < rect.height; y++) {
+    memset(get_canvas_pixel(self, rect.left, rect.top + y), 0, rect.width * 4);
+  }
+}
+
+// Save the area of the canvas under [image] so it can be restored.
+static void save_image(UtGifRenderer *self, UtObject *image) {
+  Rect rect;
+  if (!get_image_rect(self, image, &rect)) {
+    return;
+  }
+  size_t row_length = rect.width * 4;
+  if (self->previous_length < rect.height * row_length) {
+    self->previous_length = rect.height * row_length;
+    self->previous = realloc(self->previous, self->previous_length);
+  }
+  for (size_t y = 0; y < rect.height; y++) {
+    memcpy(self->previous + y * row_length,
+           get_canvas_pixel(self, rect.left, rect.top + y), row_length);
+  }
+}
+
+// Restore the area of the canvas under [image] saved with [save_image].
+static void restore_image(UtGifRenderer *self, UtObject *image) {
+  Rect rect;
+  if (!get_image_rect(self, image, &rect)) {
+    return;
+  }
+  size_t row_length = rect.width * 4;
+  for (size_t y = 0; y < rect.height; y++) {
+    memcpy(get_canvas_pixel(self, rect.left, rect.top + y),
+           self->previous + y * row_length, row_length);
+  }
+}
+
+// Draw [image] onto the canvas.
+static void draw_image(UtGifRenderer *self, UtObject *image) {
+  Rect rect;
+  if (!get_image_rect(self, image, &rect)) {
+    return;
+  }
+
+  // Build a lookup table from color index to RGBA. Indexes outside the color
+  // table are drawn as black.
+  uint32_t lut[256];
+  UtObject *color_table = ut_gif_image_get_color_table(image);
+  const uint8_t *color_table_data = ut_uint8_list_get_data(color_table);
+  size_t color_table_length = ut_list_get_length(color_table) / 3;
+  for (size_t i = 0; i < 256; i++) {
+    uint8_t color[4] = {0x00, 0x00, 0x00, 0xff};
+    if (i < color_table_length) {
+      memcpy(color, color_table_data + i * 3, 3);
+    }
+    memcpy(&lut[i], color, 4);
+  }
+
+  ExpandRowFunction expand_row = get_expand_row_function();
+  int transparent_color_index = ut_gif_image_get_transparent_color_index(image);
+  size_t image_width = ut_gif_image_get_width(image);
+  const uint8_t *image_data =
+      ut_uint8_list_get_data(ut_gif_image_get_data(image));
+  for (size_t y = 0; y < rect.height; y++) {
+    expand_row(lut, image_data + y * image_width,
+               get_canvas_pixel(self, rect.left, rect.top + y), rect.width,
+               transparent_color_index);
+  }
+}
+
 static void ut_gif_renderer_cleanup(UtObject *object) {
   UtGifRenderer *self = (UtGifRenderer *)object;
   ut_object_unref(self->decoder);
+  ut_object_unref(self->canvas);
+  free(self->previous);
 }
 
 static UtObjectInterface object_interface = {
@@ -25,6 +221,58 @@ UtObject *ut_gif_renderer_new(UtObject *decoder) {
   return object;
 }
 
+UtObject *ut_gif_renderer_render_next(UtObject *object) {
+  assert(ut_object_is_gif_renderer(object));
+  UtGifRenderer *self = (UtGifRenderer *)object;
+
+  UtObject *images = ut_gif_decoder_get_images(self->decoder);
+  if (self->next_image >= ut_list_get_length(images)) {
+    return NULL;
+  }
+
+  // Canvas starts transparent.
+  if (self->canvas == NULL) {
+    size_t width = ut_gif_decoder_get_width(self->decoder);
+    size_t height = ut_gif_decoder_get_height(self->decoder);
+    self->canvas = ut_uint8_array_new_sized(width * height * 4);
+  }
+
+  // Remove the previous image as requested.
+  if (self->next_image > 0) {
+    UtObject *last_image =
+        ut_object_list_get_element(images, self->next_image - 1);
+    switch (ut_gif_image_get_disposal_method(last_image)) {
+    case UT_GIF_DISPOSAL_METHOD_NONE:
+    case UT_GIF_DISPOSAL_METHOD_DO_NOT_DISPOSE:
+      // No action required.
+      break;
+    case UT_GIF_DISPOSAL_METHOD_RESTORE_TO_BACKGROUND:
+      clear_image(self, last_image);
+      break;
+    case UT_GIF_DISPOSAL_METHOD_RESTORE_TO_PREVIOUS:
+      restore_image(self, last_image);
+      break;
+    }
+  }
+
+  UtObject *image = ut_object_list_get_element(images, self->next_image);
+  if (ut_gif_image_get_disposal_method(image) ==
+      UT_GIF_DISPOSAL_METHOD_RESTORE_TO_PREVIOUS) {
+    save_image(self, image);
+  }
+  draw_image(self, image);
+  self->next_image++;
+
+  return self->canvas;
+}
+
+void ut_gif_renderer_reset(UtObject *object) {
+  assert(ut_object_is_gif_renderer(object));
+  UtGifRenderer *self = (UtGifRenderer *)object;
+  ut_object_clear(&self->canvas);
+  self->next_image = 0;
+}
+
 UtObject *ut_gif_renderer_render(UtObject *object) {
   assert(ut_object_is_gif_renderer(object));
   UtGifRenderer *self = (UtGifRenderer *)object;
@@ -32,94 +280,26 @@ UtObject *ut_gif_renderer_render(UtObject *object) {
   size_t width = ut_gif_decoder_get_width(self->decoder);
   size_t height = ut_gif_decoder_get_height(self->decoder);
 
-  UtObjectRef data = ut_uint8_array_new();
-  ut_list_resize(data, width * height * 3);
-  uint8_t *buffer = ut_uint8_list_get_writable_data(data);
-
-  size_t offset = 0;
-  for (size_t y = 0; y < height; y++) {
-    for (size_t x = 0; x < width; x++) {
-      uint8_t *pixel = buffer + offset;
-      // FIXME: Use correct color
-      pixel[0] = 0;
-      pixel[1] = 0;
-      pixel[2] = 0;
-      offset += 3;
+  ut_gif_renderer_reset(object);
+  UtObject *canvas = NULL;
+  while (true) {
+    UtObject *frame = ut_gif_renderer_render_next(object);
+    if (frame == NULL) {
+      break;
     }
+    canvas = frame;
   }
 
-  UtObject *images = ut_gif_decoder_get_images(self->decoder);
-  size_t images_length = ut_list_get_length(images);
-  UtObject *last_image = NULL;
-  for (size_t i = 0; i < images_length; i++) {
-    if (last_image != NULL) {
-      size_t image_top, image_left, image_width, image_height;
-      switch (ut_gif_image_get_disposal_method(last_image)) {
-      case UT_GIF_DISPOSAL_METHOD_NONE:
-      case UT_GIF_DISPOSAL_METHOD_DO_NOT_DISPOSE:
-        // No action required.
-        break;
-      case UT_GIF_DISPOSAL_METHOD_RESTORE_TO_BACKGROUND:
-        image_top = ut_gif_image_get_top(last_image);
-        image_left = ut_gif_image_get_left(last_image);
-        image_width = ut_gif_image_get_width(last_image);
-        image_height = ut_gif_image_get_height(last_image);
-        // FIXME: crop
-        for (size_t y = 0; y < image_height; y++) {
-          size_t iy = image_top + y;
-          for (size_t x = 0; x < image_width; x++) {
-            size_t ix = image_left + x;
-            size_t pixel_offset = (iy * width) + ix;
-            uint8_t *pixel = buffer + pixel_offset * 3;
-            // FIXME: Use correct color
-            pixel[0] = 0;
-            pixel[1] = 0;
-            pixel[2] = 0;
-          }
-        }
-        break;
-      case UT_GIF_DISPOSAL_METHOD_RESTORE_TO_PREVIOUS:
-        break;
-      }
+  UtObject *data = ut_uint8_array_new_sized(width * height * 3);
+  if (canvas != NULL) {
+    uint8_t *buffer = ut_uint8_list_get_writable_data(data);
+    const uint8_t *canvas_data = ut_uint8_list_get_data(canvas);
+    for (size_t i = 0; i < width * height; i++) {
+      memcpy(buffer + i * 3, canvas_data + i * 4, 3);
     }
-
-    UtObject *image = ut_object_list_get_element(images, i);
-    size_t image_top = ut_gif_image_get_top(image);
-    size_t image_left = ut_gif_image_get_left(image);
-    size_t image_width = ut_gif_image_get_width(image);
-    size_t image_height = ut_gif_image_get_height(image);
-    const uint8_t *image_data =
-        ut_uint8_list_get_data(ut_gif_image_get_data(image));
-    const uint8_t *color_table =
-        ut_uint8_list_get_data(ut_gif_image_get_color_table(image));
-
-    // Only use image if inside final dimensions.
-    if (image_left >= width || image_top >= image_height) {
-      continue;
-    }
-    size_t image_cropped_width =
-        image_left + image_width > width ? width - image_left : image_width;
-    size_t image_cropped_height =
-        image_top + image_height > height ? height - image_top : image_height;
-
-    for (size_t y = 0; y < image_cropped_height; y++) {
-      size_t iy = image_top + y;
-      for (size_t x = 0; x < image_cropped_width; x++) {
-        size_t ix = image_left + x;
-        uint8_t color_index = image_data[(y * image_width) + x];
-        const uint8_t *color = &color_table[color_index * 3];
-        size_t pixel_offset = (iy * width) + ix;
-        uint8_t *pixel = buffer + pixel_offset * 3;
-        pixel[0] = color[0];
-        pixel[1] = color[1];
-        pixel[2] = color[2];
-      }
-    }
-
-    last_image = image;
   }
 
-  return ut_object_ref(data);
+  return data;
 }
 
 bool ut_object_is_gif_renderer(UtObject *object) {
@@ -11,7 +11,18 @@
 /// !return-type UtGifRenderer
 UtObject *ut_gif_renderer_new(UtObject *decoder);
 
-/// Returns a rendered image in RGB format.
+/// Composites the next image onto the canvas and returns the canvas in RGBA
+/// format, or [NULL] if all the images have been rendered. The canvas starts
+/// transparent and the same list is updated for each frame.
+///
+/// !return-type UtUint8List NULL
+UtObject *ut_gif_renderer_render_next(UtObject *object);
+
+/// Clears the canvas so the next call to [ut_gif_renderer_render_next] renders
+/// the first image.
+void ut_gif_renderer_reset(UtObject *object);
+
+/// Returns the final rendered image in RGB format.
 ///
 /// !return-ref
 /// !return-type UtUint8List
@@ -73,19 +73,19 @@ UtObject *http_request_new(const char *host, uint16_t port, const char *method,
 
 typedef struct {
   UtObject object;
-  UtObject *ip_address_resolver;
+  UtObject *dns_resolver;
   UtObject *requests;
 } UtHttpClient;
 
 static void ut_http_client_init(UtObject *object) {
   UtHttpClient *self = (UtHttpClient *)object;
-  self->ip_address_resolver = ut_ip_address_resolver_new();
+  self->dns_resolver = ut_dns_resolver_new();
   self->requests = ut_object_list_new();
 }
 
 static void ut_http_client_cleanup(UtObject *object) {
   UtHttpClient *self = (UtHttpClient *)object;
-  ut_object_unref(self->ip_address_resolver);
+  ut_object_unref(self->dns_resolver);
   ut_object_unref(self->requests);
 }
 
@@ -164,6 +164,18 @@ static void connect_cb(UtObject *object, UtObject *error) {
 
 static void lookup_cb(UtObject *object, UtObject *addresses) {
   HttpRequest *request = (HttpRequest *)object;
+
+  if (ut_list_get_length(addresses) == 0) {
+    if (request->callback_object != NULL && request->callback != NULL) {
+      ut_cstring_ref description =
+          ut_cstring_new_printf("Failed to resolve host %s", request->host);
+      UtObjectRef error = ut_general_error_new(description);
+      request->callback(request->callback_object, error);
+    }
+    ut_request_unref(object);
+    return;
+  }
+
   UtObjectRef address = ut_list_get_first(addresses);
   request->tcp_socket = ut_tcp_socket_new(address, request->port);
   ut_tcp_socket_connect(request->tcp_socket, object, connect_cb);
@@ -201,8 +213,7 @@ void ut_http_client_send_request(UtObject *object, const char *method,
                                object, callback_object, callback);
 
   ut_list_append(self->requests, request);
-  ut_ip_address_resolver_lookup(self->ip_address_resolver, host, request,
-                                lookup_cb);
+  ut_dns_resolver_lookup(self->dns_resolver, host, request, lookup_cb);
 }
 
 bool ut_object_is_http_client(UtObject *object) {
@@ -0,0 +1,263 @@
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ut-cpu-private.h"
+#include "ut-jpeg.h"
+
+// Fixed point YCbCr to RGB conversion as defined in JFIF:
+// R = Y + 1.402 * (Cr - 128)
+// G = Y - 0.344136 * (Cb - 128) - 0.714136 * (Cr - 128)
+// B = Y + 1.772 * (Cb - 128)
+//
+// The constants are scaled by 2^14 so they fit in 16 bits and can be used with
+// the SIMD multiply-add instructions. The SIMD implementations give exactly
+// the same results as the scalar implementation.
+
+#define SCALE_BITS 14
+#define ROUND (1 << (SCALE_BITS - 1))
+
+#define CR_R 22970
+#define CB_G -5638
+#define CR_G -11700
+#define CB_B 29032
+
+static uint8_t clamp(int32_t value) {
+  if (value < 0) {
+    return 0;
+  } else if (value > 255) {
+    return 255;
+  } else {
+    return value;
+  }
+}
+
+static void ycbcr_to_rgb_pixels(const uint8_t *y, const uint8_t *cb,
+                                const uint8_t *cr, uint8_t *rgb,
+                                size_t width) {
+  for (size_t x = 0; x < width; x++) {
+    int32_t Y = y[x];
+    int32_t Cb = cb[x] - 128;
+    int32_t Cr = cr[x] - 128;
+    rgb[0] = clamp(Y + ((CR_R * Cr + ROUND) >> SCALE_BITS));
+    rgb[1] = clamp(Y + ((CB_G * Cb + CR_G * Cr + ROUND) >> SCALE_BITS));
+    rgb[2] = clamp(Y + ((CB_B * Cb + ROUND) >> SCALE_BITS));
+    rgb += 3;
+  }
+}
+
+#if defined(__SSE2__)
+// Returns the [cb] and [cr] pairs multiplied by [cb_scale] and [cr_scale]
+// as 16 bit values.
+static __m128i multiply_chroma_sse2(__m128i cbcr_lo, __m128i cbcr_hi,
+                                    int16_t cb_scale, int16_t cr_scale) {
+  __m128i c =
+      _mm_set1_epi32((uint16_t)cb_scale | (uint32_t)(uint16_t)cr_scale << 16);
+  __m128i round = _mm_set1_epi32(ROUND);
+  __m128i lo = _mm_srai_epi32(
+      _mm_add_epi32(_mm_madd_epi16(cbcr_lo, c), round), SCALE_BITS);
+  __m128i hi = _mm_srai_epi32(
+      _mm_add_epi32(_mm_madd_epi16(cbcr_hi, c), round), SCALE_BITS);
+  return _mm_packs_epi32(lo, hi);
+}
+
+static void ycbcr_to_rgb_sse2(const uint8_t *y, const uint8_t *cb,
+                              const uint8_t *cr, uint8_t *rgb, size_t width) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i offset = _mm_set1_epi16(128);
+
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i Y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(y + x)),
+                                  zero);
+    __m128i Cb = _mm_sub_epi16(
+        _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(cb + x)), zero),
+        offset);
+    __m128i Cr = _mm_sub_epi16(
+        _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(cr + x)), zero),
+        offset);
+    __m128i cbcr_lo = _mm_unpacklo_epi16(Cb, Cr);
+    __m128i cbcr_hi = _mm_unpackhi_epi16(Cb, Cr);
+
+    __m128i r = _mm_add_epi16(
+        Y, multiply_chroma_sse2(cbcr_lo, cbcr_hi, 0, CR_R));
+    __m128i g = _mm_add_epi16(
+        Y, multiply_chroma_sse2(cbcr_lo, cbcr_hi, CB_G, CR_G));
+    __m128i b = _mm_add_epi16(
+        Y, multiply_chroma_sse2(cbcr_lo, cbcr_hi, CB_B, 0));
+
+    // SSE2 has no byte shuffle, so interleave the saturated values through
+    // memory.
+    uint8_t r_values[16], g_values[16], b_values[16];
+    _mm_storeu_si128((__m128i *)r_values, _mm_packus_epi16(r, r));
+    _mm_storeu_si128((__m128i *)g_values, _mm_packus_epi16(g, g));
+    _mm_storeu_si128((__m128i *)b_values, _mm_packus_epi16(b, b));
+    uint8_t *pixel = rgb + x * 3;
+    for (size_t i = 0; i < 8; i++) {
+      pixel[0] = r_values[i];
+      pixel[1] = g_values[i];
+      pixel[2] = b_values[i];
+      pixel += 3;
+    }
+  }
+
+  ycbcr_to_rgb_pixels(y + x, cb + x, cr + x, rgb + x * 3, width - x);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static __m256i
+multiply_chroma_avx2(__m256i cbcr_lo, __m256i cbcr_hi, int16_t cb_scale,
+                     int16_t cr_scale) {
+  __m256i c = _mm256_set1_epi32((uint16_t)cb_scale |
+                                (uint32_t)(uint16_t)cr_scale << 16);
+  __m256i round = _mm256_set1_epi32(ROUND);
+  __m256i lo = _mm256_srai_epi32(
+      _mm256_add_epi32(_mm256_madd_epi16(cbcr_lo, c), round), SCALE_BITS);
+  __m256i hi = _mm256_srai_epi32(
+      _mm256_add_epi32(_mm256_madd_epi16(cbcr_hi, c), round), SCALE_BITS);
+  return _mm256_packs_epi32(lo, hi);
+}
+
+// Returns the 16 bit values in [value] saturated to 8 bits.
+__attribute__((target("avx2"))) static __m128i pack_avx2(__m256i value) {
+  return _mm256_castsi256_si128(_mm256_permute4x64_epi64(
+      _mm256_packus_epi16(value, value), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+__attribute__((target("avx2"))) static void
+ycbcr_to_rgb_avx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                  uint8_t *rgb, size_t width) {
+  __m256i offset = _mm256_set1_epi16(128);
+
+  // Shuffles to interleave sixteen R, G and B values into 48 bytes.
+  __m128i r_shuffle0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1,
+                                     -1, 4, -1, -1, 5);
+  __m128i g_shuffle0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3,
+                                     -1, -1, 4, -1, -1);
+  __m128i b_shuffle0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1,
+                                     3, -1, -1, 4, -1);
+  __m128i r_shuffle1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1,
+                                     9, -1, -1, 10, -1);
+  __m128i g_shuffle1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1,
+                                     -1, 9, -1, -1, 10);
+  __m128i b_shuffle1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8,
+                                     -1, -1, 9, -1, -1);
+  __m128i r_shuffle2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1,
+                                     14, -1, -1, 15, -1, -1);
+  __m128i g_shuffle2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1,
+                                     -1, 14, -1, -1, 15, -1);
+  __m128i b_shuffle2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13,
+                                     -1, -1, 14, -1, -1, 15);
+
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i Y =
+        _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(y + x)));
+    __m256i Cb = _mm256_sub_epi16(
+        _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(cb + x))),
+        offset);
+    __m256i Cr = _mm256_sub_epi16(
+        _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(cr + x))),
+        offset);
+    __m256i cbcr_lo = _mm256_unpacklo_epi16(Cb, Cr);
+    __m256i cbcr_hi = _mm256_unpackhi_epi16(Cb, Cr);
+
+    __m128i r = pack_avx2(
+        _mm256_add_epi16(Y, multiply_chroma_avx2(cbcr_lo, cbcr_hi, 0, CR_R)));
+    __m128i g = pack_avx2(_mm256_add_epi16(
+        Y, multiply_chroma_avx2(cbcr_lo, cbcr_hi, CB_G, CR_G)));
+    __m128i b = pack_avx2(
+        _mm256_add_epi16(Y, multiply_chroma_avx2(cbcr_lo, cbcr_hi, CB_B, 0)));
+
+    __m128i *pixel = (__m128i *)(rgb + x * 3);
+    _mm_storeu_si128(pixel,
+                     _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r_shuffle0),
+                                               _mm_shuffle_epi8(g, g_shuffle0)),
+                                  _mm_shuffle_epi8(b, b_shuffle0)));
+    _mm_storeu_si128(pixel + 1,
+                     _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r_shuffle1),
+                                               _mm_shuffle_epi8(g, g_shuffle1)),
+                                  _mm_shuffle_epi8(b, b_shuffle1)));
+    _mm_storeu_si128(pixel + 2,
+                     _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r_shuffle2),
+                                               _mm_shuffle_epi8(g, g_shuffle2)),
+                                  _mm_shuffle_epi8(b, b_shuffle2)));
+  }
+
+  ycbcr_to_rgb_pixels(y + x, cb + x, cr + x, rgb + x * 3, width - x);
+}
+#endif
+
+// Implementations from slowest to fastest, the last is the one used.
+static JpegColorFunctions implementations[3];
+static size_t n_implementations = 0;
+static pthread_once_t implementations_once = PTHREAD_ONCE_INIT;
+
+// Find the conversions the CPU supports. Rows are converted by several decoder
+// workers at once.
+static void select_implementations() {
+  implementations[n_implementations++] =
+      (JpegColorFunctions){"scalar", ycbcr_to_rgb_pixels};
+#if defined(__SSE2__)
+  implementations[n_implementations++] =
+      (JpegColorFunctions){"sse2", ycbcr_to_rgb_sse2};
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+  if (_ut_cpu_has_avx2()) {
+    implementations[n_implementations++] =
+        (JpegColorFunctions){"avx2", ycbcr_to_rgb_avx2};
+  }
+#endif
+}
+
+size_t jpeg_get_color_functions(const JpegColorFunctions **functions) {
+  pthread_once(&implementations_once, select_implementations);
+  *functions = implementations;
+  return n_implementations;
+}
+
+void jpeg_ycbcr_to_rgb(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                       uint8_t *rgb, size_t width) {
+  pthread_once(&implementations_once, select_implementations);
+  implementations[n_implementations - 1].ycbcr_to_rgb(y, cb, cr, rgb, width);
+}
+
+// RGB to YCbCr conversion as defined in JFIF:
+// Y = 0.299 * R + 0.587 * G + 0.114 * B
+// Cb = -0.168736 * R - 0.331264 * G + 0.5 * B + 128
+// Cr = 0.5 * R - 0.418688 * G - 0.081312 * B + 128
+//
+// The constants are scaled by 2^16. Chrominance is rounded down at exactly
+// half so it doesn't exceed 255.
+
+#define RGB_SCALE_BITS 16
+#define RGB_ROUND (1 << (RGB_SCALE_BITS - 1))
+
+#define R_Y 19595
+#define G_Y 38470
+#define B_Y 7471
+#define R_CB -11059
+#define G_CB -21709
+#define B_CB 32768
+#define R_CR 32768
+#define G_CR -27439
+#define B_CR -5329
+
+void jpeg_rgb_to_ycbcr(const uint8_t *rgb, uint8_t *y, uint8_t *cb,
+                       uint8_t *cr, size_t width) {
+  int32_t chroma_offset = (128 << RGB_SCALE_BITS) + RGB_ROUND - 1;
+  for (size_t x = 0; x < width; x++) {
+    int32_t r = rgb[0];
+    int32_t g = rgb[1];
+    int32_t b = rgb[2];
+    y[x] = (R_Y * r + G_Y * g + B_Y * b + RGB_ROUND) >> RGB_SCALE_BITS;
+    cb[x] = (R_CB * r + G_CB * g + B_CB * b + chroma_offset) >> RGB_SCALE_BITS;
+    cr[x] = (R_CR * r + G_CR * g + B_CR * b + chroma_offset) >> RGB_SCALE_BITS;
+    rgb += 3;
+  }
+}
@@ -0,0 +1,758 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ut-cpu-private.h"
+#include "ut-jpeg.h"
+
+// Fixed point discrete cosine transforms using the Loeffler, Ligtenberg and
+// Moschytz factorization, as used by the IJG library (jfdctint.c and
+// jidctint.c).
+//
+// Each 2D transform is done as a 1D transform on each column followed by a 1D
+// transform on each row (or rows then columns for the forward transform).
+// Intermediate values are kept in 16 bits, scaled up by PASS1_BITS for extra
+// precision. The SIMD implementations combine the multiplications of the
+// factorization into pairs of constants applied with a multiply-add
+// instruction, and give exactly the same results as the scalar
+// implementation.
+
+#define CONST_BITS 13
+#define PASS1_BITS 2
+
+#define FIX_0_211164243 1730
+#define FIX_0_298631336 2446
+#define FIX_0_390180644 3196
+#define FIX_0_509795579 4176
+#define FIX_0_541196100 4433
+#define FIX_0_601344887 4926
+#define FIX_0_720959822 5906
+#define FIX_0_765366865 6270
+#define FIX_0_850430095 6967
+#define FIX_0_899976223 7373
+#define FIX_1_061594337 8697
+#define FIX_1_175875602 9633
+#define FIX_1_272758580 10426
+#define FIX_1_451774981 11893
+#define FIX_1_501321110 12299
+#define FIX_1_847759065 15137
+#define FIX_1_961570560 16069
+#define FIX_2_053119869 16819
+#define FIX_2_172734803 17799
+#define FIX_2_562915447 20995
+#define FIX_3_072711026 25172
+#define FIX_3_624509785 29692
+
+static int16_t clamp_int16(int32_t value) {
+  if (value < INT16_MIN) {
+    return INT16_MIN;
+  } else if (value > INT16_MAX) {
+    return INT16_MAX;
+  } else {
+    return value;
+  }
+}
+
+static int32_t descale(int32_t value, int shift) {
+  return (value + (1 << (shift - 1))) >> shift;
+}
+
+// Forward transform of [input] into [output]. The first pass leaves the
+// results scaled up by PASS1_BITS, the second pass removes this scaling.
+static void dct_1d(const int32_t *input, int32_t *output, bool first_pass) {
+  int32_t tmp0 = input[0] + input[7];
+  int32_t tmp7 = input[0] - input[7];
+  int32_t tmp1 = input[1] + input[6];
+  int32_t tmp6 = input[1] - input[6];
+  int32_t tmp2 = input[2] + input[5];
+  int32_t tmp5 = input[2] - input[5];
+  int32_t tmp3 = input[3] + input[4];
+  int32_t tmp4 = input[3] - input[4];
+
+  // Even part.
+  int32_t tmp10 = tmp0 + tmp3;
+  int32_t tmp13 = tmp0 - tmp3;
+  int32_t tmp11 = tmp1 + tmp2;
+  int32_t tmp12 = tmp1 - tmp2;
+
+  int shift;
+  if (first_pass) {
+    output[0] = (tmp10 + tmp11) * (1 << PASS1_BITS);
+    output[4] = (tmp10 - tmp11) * (1 << PASS1_BITS);
+    shift = CONST_BITS - PASS1_BITS;
+  } else {
+    output[0] = descale(tmp10 + tmp11, PASS1_BITS);
+    output[4] = descale(tmp10 - tmp11, PASS1_BITS);
+    shift = CONST_BITS + PASS1_BITS;
+  }
+
+  int32_t z1 = (tmp12 + tmp13) * FIX_0_541196100;
+  output[2] = descale(z1 + tmp13 * FIX_0_765366865, shift);
+  output[6] = descale(z1 - tmp12 * FIX_1_847759065, shift);
+
+  // Odd part.
+  z1 = tmp4 + tmp7;
+  int32_t z2 = tmp5 + tmp6;
+  int32_t z3 = tmp4 + tmp6;
+  int32_t z4 = tmp5 + tmp7;
+  int32_t z5 = (z3 + z4) * FIX_1_175875602;
+
+  tmp4 *= FIX_0_298631336;
+  tmp5 *= FIX_2_053119869;
+  tmp6 *= FIX_3_072711026;
+  tmp7 *= FIX_1_501321110;
+  z1 *= -FIX_0_899976223;
+  z2 *= -FIX_2_562915447;
+  z3 = z3 * -FIX_1_961570560 + z5;
+  z4 = z4 * -FIX_0_390180644 + z5;
+
+  output[7] = descale(tmp4 + z1 + z3, shift);
+  output[5] = descale(tmp5 + z2 + z4, shift);
+  output[3] = descale(tmp6 + z2 + z3, shift);
+  output[1] = descale(tmp7 + z1 + z4, shift);
+}
+
+// Inverse transform of [input], with output values descaled by [shift] bits.
+static void inverse_dct_1d(const int32_t *input, int32_t *output, int shift) {
+  // Even part.
+  int32_t z1 = (input[2] + input[6]) * FIX_0_541196100;
+  int32_t tmp2 = z1 - input[6] * FIX_1_847759065;
+  int32_t tmp3 = z1 + input[2] * FIX_0_765366865;
+  int32_t tmp0 = (input[0] + input[4]) * (1 << CONST_BITS);
+  int32_t tmp1 = (input[0] - input[4]) * (1 << CONST_BITS);
+
+  int32_t tmp10 = tmp0 + tmp3;
+  int32_t tmp13 = tmp0 - tmp3;
+  int32_t tmp11 = tmp1 + tmp2;
+  int32_t tmp12 = tmp1 - tmp2;
+
+  // Odd part.
+  tmp0 = input[7];
+  tmp1 = input[5];
+  tmp2 = input[3];
+  tmp3 = input[1];
+
+  z1 = tmp0 + tmp3;
+  int32_t z2 = tmp1 + tmp2;
+  int32_t z3 = tmp0 + tmp2;
+  int32_t z4 = tmp1 + tmp3;
+  int32_t z5 = (z3 + z4) * FIX_1_175875602;
+
+  tmp0 *= FIX_0_298631336;
+  tmp1 *= FIX_2_053119869;
+  tmp2 *= FIX_3_072711026;
+  tmp3 *= FIX_1_501321110;
+  z1 *= -FIX_0_899976223;
+  z2 *= -FIX_2_562915447;
+  z3 = z3 * -FIX_1_961570560 + z5;
+  z4 = z4 * -FIX_0_390180644 + z5;
+
+  tmp0 += z1 + z3;
+  tmp1 += z2 + z4;
+  tmp2 += z2 + z3;
+  tmp3 += z1 + z4;
+
+  output[0] = descale(tmp10 + tmp3, shift);
+  output[7] = descale(tmp10 - tmp3, shift);
+  output[1] = descale(tmp11 + tmp2, shift);
+  output[6] = descale(tmp11 - tmp2, shift);
+  output[2] = descale(tmp12 + tmp1, shift);
+  output[5] = descale(tmp12 - tmp1, shift);
+  output[3] = descale(tmp13 + tmp0, shift);
+  output[4] = descale(tmp13 - tmp0, shift);
+}
+
+static void dct_scalar(const int16_t *data_unit, int16_t *coefficients) {
+  int16_t workspace[64];
+  int32_t input[8], output[8];
+
+  for (size_t y = 0; y < 8; y++) {
+    for (size_t x = 0; x < 8; x++) {
+      input[x] = data_unit[(y * 8) + x];
+    }
+    dct_1d(input, output, true);
+    for (size_t u = 0; u < 8; u++) {
+      workspace[(y * 8) + u] = clamp_int16(output[u]);
+    }
+  }
+
+  for (size_t u = 0; u < 8; u++) {
+    for (size_t y = 0; y < 8; y++) {
+      input[y] = workspace[(y * 8) + u];
+    }
+    dct_1d(input, output, false);
+    for (size_t v = 0; v < 8; v++) {
+      coefficients[(v * 8) + u] = clamp_int16(output[v]);
+    }
+  }
+}
+
+static void inverse_dct_scalar(const int16_t *coefficients,
+                               int16_t *data_unit) {
+  int16_t workspace[64];
+  int32_t input[8], output[8];
+
+  for (size_t u = 0; u < 8; u++) {
+    for (size_t v = 0; v < 8; v++) {
+      input[v] = coefficients[(v * 8) + u];
+    }
+    inverse_dct_1d(input, output, CONST_BITS - PASS1_BITS);
+    for (size_t y = 0; y < 8; y++) {
+      workspace[(y * 8) + u] = clamp_int16(output[y]);
+    }
+  }
+
+  for (size_t y = 0; y < 8; y++) {
+    for (size_t u = 0; u < 8; u++) {
+      input[u] = workspace[(y * 8) + u];
+    }
+    inverse_dct_1d(input, output, CONST_BITS + PASS1_BITS + 3);
+    for (size_t x = 0; x < 8; x++) {
+      data_unit[(y * 8) + x] = clamp_int16(output[x]);
+    }
+  }
+}
+
+#if defined(__SSE2__)
+// Transposes the 8x8 block of 16 bit values in [rows].
+static void transpose_sse2(__m128i *rows) {
+  __m128i a0 = _mm_unpacklo_epi16(rows[0], rows[1]);
+  __m128i a1 = _mm_unpackhi_epi16(rows[0], rows[1]);
+  __m128i a2 = _mm_unpacklo_epi16(rows[2], rows[3]);
+  __m128i a3 = _mm_unpackhi_epi16(rows[2], rows[3]);
+  __m128i a4 = _mm_unpacklo_epi16(rows[4], rows[5]);
+  __m128i a5 = _mm_unpackhi_epi16(rows[4], rows[5]);
+  __m128i a6 = _mm_unpacklo_epi16(rows[6], rows[7]);
+  __m128i a7 = _mm_unpackhi_epi16(rows[6], rows[7]);
+
+  __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+  __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+  __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+  __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+  __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+  __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+  __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+  __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+  rows[0] = _mm_unpacklo_epi64(b0, b4);
+  rows[1] = _mm_unpackhi_epi64(b0, b4);
+  rows[2] = _mm_unpacklo_epi64(b1, b5);
+  rows[3] = _mm_unpackhi_epi64(b1, b5);
+  rows[4] = _mm_unpacklo_epi64(b2, b6);
+  rows[5] = _mm_unpackhi_epi64(b2, b6);
+  rows[6] = _mm_unpacklo_epi64(b3, b7);
+  rows[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+// 32 bit results for the eight lanes of a 16 bit vector.
+typedef struct {
+  __m128i lo;
+  __m128i hi;
+} Int32x8;
+
+// Returns [a] * [ca] + [b] * [cb] for each lane.
+static Int32x8 multiply_add_sse2(__m128i a, __m128i b, int16_t ca,
+                                 int16_t cb) {
+  __m128i c = _mm_set1_epi32((uint16_t)ca | (uint32_t)(uint16_t)cb << 16);
+  return (Int32x8){_mm_madd_epi16(_mm_unpacklo_epi16(a, b), c),
+                   _mm_madd_epi16(_mm_unpackhi_epi16(a, b), c)};
+}
+
+static Int32x8 add_sse2(Int32x8 a, Int32x8 b) {
+  return (Int32x8){_mm_add_epi32(a.lo, b.lo), _mm_add_epi32(a.hi, b.hi)};
+}
+
+static Int32x8 sub_sse2(Int32x8 a, Int32x8 b) {
+  return (Int32x8){_mm_sub_epi32(a.lo, b.lo), _mm_sub_epi32(a.hi, b.hi)};
+}
+
+// Returns [value] descaled by [shift] bits and saturated to 16 bits.
+static __m128i descale_sse2(Int32x8 value, int shift) {
+  __m128i round = _mm_set1_epi32(1 << (shift - 1));
+  __m128i count = _mm_cvtsi32_si128(shift);
+  return _mm_packs_epi32(_mm_sra_epi32(_mm_add_epi32(value.lo, round), count),
+                         _mm_sra_epi32(_mm_add_epi32(value.hi, round), count));
+}
+
+static void dct_1d_sse2(__m128i *v, bool first_pass) {
+  __m128i tmp0 = _mm_add_epi16(v[0], v[7]);
+  __m128i tmp7 = _mm_sub_epi16(v[0], v[7]);
+  __m128i tmp1 = _mm_add_epi16(v[1], v[6]);
+  __m128i tmp6 = _mm_sub_epi16(v[1], v[6]);
+  __m128i tmp2 = _mm_add_epi16(v[2], v[5]);
+  __m128i tmp5 = _mm_sub_epi16(v[2], v[5]);
+  __m128i tmp3 = _mm_add_epi16(v[3], v[4]);
+  __m128i tmp4 = _mm_sub_epi16(v[3], v[4]);
+
+  // Even part.
+  __m128i tmp10 = _mm_add_epi16(tmp0, tmp3);
+  __m128i tmp13 = _mm_sub_epi16(tmp0, tmp3);
+  __m128i tmp11 = _mm_add_epi16(tmp1, tmp2);
+  __m128i tmp12 = _mm_sub_epi16(tmp1, tmp2);
+
+  int shift;
+  if (first_pass) {
+    v[0] = _mm_slli_epi16(_mm_add_epi16(tmp10, tmp11), PASS1_BITS);
+    v[4] = _mm_slli_epi16(_mm_sub_epi16(tmp10, tmp11), PASS1_BITS);
+    shift = CONST_BITS - PASS1_BITS;
+  } else {
+    __m128i round = _mm_set1_epi16(1 << (PASS1_BITS - 1));
+    v[0] = _mm_srai_epi16(
+        _mm_add_epi16(_mm_add_epi16(tmp10, tmp11), round), PASS1_BITS);
+    v[4] = _mm_srai_epi16(
+        _mm_add_epi16(_mm_sub_epi16(tmp10, tmp11), round), PASS1_BITS);
+    shift = CONST_BITS + PASS1_BITS;
+  }
+
+  v[2] = descale_sse2(multiply_add_sse2(tmp13, tmp12,
+                                        FIX_0_541196100 + FIX_0_765366865,
+                                        FIX_0_541196100),
+                      shift);
+  v[6] = descale_sse2(multiply_add_sse2(tmp13, tmp12, FIX_0_541196100,
+                                        FIX_0_541196100 - FIX_1_847759065),
+                      shift);
+
+  // Odd part.
+  v[7] = descale_sse2(
+      add_sse2(multiply_add_sse2(tmp4, tmp5,
+                                 FIX_0_298631336 - FIX_0_899976223 -
+                                     FIX_1_961570560 + FIX_1_175875602,
+                                 FIX_1_175875602),
+               multiply_add_sse2(tmp6, tmp7,
+                                 FIX_1_175875602 - FIX_1_961570560,
+                                 FIX_1_175875602 - FIX_0_899976223)),
+      shift);
+  v[5] = descale_sse2(
+      add_sse2(multiply_add_sse2(tmp4, tmp5, FIX_1_175875602,
+                                 FIX_2_053119869 - FIX_2_562915447 -
+                                     FIX_0_390180644 + FIX_1_175875602),
+               multiply_add_sse2(tmp6, tmp7,
+                                 FIX_1_175875602 - FIX_2_562915447,
+                                 FIX_1_175875602 - FIX_0_390180644)),
+      shift);
+  v[3] = descale_sse2(
+      add_sse2(multiply_add_sse2(tmp4, tmp5,
+                                 FIX_1_175875602 - FIX_1_961570560,
+                                 FIX_1_175875602 - FIX_2_562915447),
+               multiply_add_sse2(tmp6, tmp7,
+                                 FIX_3_072711026 - FIX_2_562915447 -
+                                     FIX_1_961570560 + FIX_1_175875602,
+                                 FIX_1_175875602)),
+      shift);
+  v[1] = descale_sse2(
+      add_sse2(multiply_add_sse2(tmp4, tmp5,
+                                 FIX_1_175875602 - FIX_0_899976223,
+                                 FIX_1_175875602 - FIX_0_390180644),
+               multiply_add_sse2(tmp6, tmp7, FIX_1_175875602,
+                                 FIX_1_501321110 - FIX_0_899976223 -
+                                     FIX_0_390180644 + FIX_1_175875602)),
+      shift);
+}
+
+static void inverse_dct_1d_sse2(__m128i *v, int shift) {
+  // Even part.
+  Int32x8 tmp0 = multiply_add_sse2(v[0], v[4], 1 << CONST_BITS,
+                                   1 << CONST_BITS);
+  Int32x8 tmp1 = multiply_add_sse2(v[0], v[4], 1 << CONST_BITS,
+                                   -(1 << CONST_BITS));
+  Int32x8 tmp2 = multiply_add_sse2(v[2], v[6], FIX_0_541196100,
+                                   FIX_0_541196100 - FIX_1_847759065);
+  Int32x8 tmp3 = multiply_add_sse2(
+      v[2], v[6], FIX_0_541196100 + FIX_0_765366865, FIX_0_541196100);
+
+  Int32x8 tmp10 = add_sse2(tmp0, tmp3);
+  Int32x8 tmp13 = sub_sse2(tmp0, tmp3);
+  Int32x8 tmp11 = add_sse2(tmp1, tmp2);
+  Int32x8 tmp12 = sub_sse2(tmp1, tmp2);
+
+  // Odd part.
+  tmp0 = add_sse2(
+      multiply_add_sse2(v[1], v[3], FIX_1_175875602 - FIX_0_899976223,
+                        FIX_1_175875602 - FIX_1_961570560),
+      multiply_add_sse2(v[5], v[7], FIX_1_175875602,
+                        FIX_0_298631336 - FIX_0_899976223 -
+                            FIX_1_961570560 + FIX_1_175875602));
+  tmp1 = add_sse2(
+      multiply_add_sse2(v[1], v[3], FIX_1_175875602 - FIX_0_390180644,
+                        FIX_1_175875602 - FIX_2_562915447),
+      multiply_add_sse2(v[5], v[7],
+                        FIX_2_053119869 - FIX_2_562915447 -
+                            FIX_0_390180644 + FIX_1_175875602,
+                        FIX_1_175875602));
+  tmp2 = add_sse2(
+      multiply_add_sse2(v[1], v[3], FIX_1_175875602,
+                        FIX_3_072711026 - FIX_2_562915447 -
+                            FIX_1_961570560 + FIX_1_175875602),
+      multiply_add_sse2(v[5], v[7], FIX_1_175875602 - FIX_2_562915447,
+                        FIX_1_175875602 - FIX_1_961570560));
+  tmp3 = add_sse2(
+      multiply_add_sse2(v[1], v[3],
+                        FIX_1_501321110 - FIX_0_899976223 -
+                            FIX_0_390180644 + FIX_1_175875602,
+                        FIX_1_175875602),
+      multiply_add_sse2(v[5], v[7], FIX_1_175875602 - FIX_0_390180644,
+                        FIX_1_175875602 - FIX_0_899976223));
+
+  v[0] = descale_sse2(add_sse2(tmp10, tmp3), shift);
+  v[7] = descale_sse2(sub_sse2(tmp10, tmp3), shift);
+  v[1] = descale_sse2(add_sse2(tmp11, tmp2), shift);
+  v[6] = descale_sse2(sub_sse2(tmp11, tmp2), shift);
+  v[2] = descale_sse2(add_sse2(tmp12, tmp1), shift);
+  v[5] = descale_sse2(sub_sse2(tmp12, tmp1), shift);
+  v[3] = descale_sse2(add_sse2(tmp13, tmp0), shift);
+  v[4] = descale_sse2(sub_sse2(tmp13, tmp0), shift);
+}
+
+static void dct_sse2(const int16_t *data_unit, int16_t *coefficients) {
+  __m128i v[8];
+  for (size_t i = 0; i < 8; i++) {
+    v[i] = _mm_loadu_si128((const __m128i *)(data_unit + i * 8));
+  }
+
+  // Each vector contains a row after transposing.
+  transpose_sse2(v);
+  dct_1d_sse2(v, true);
+  transpose_sse2(v);
+  dct_1d_sse2(v, false);
+
+  for (size_t i = 0; i < 8; i++) {
+    _mm_storeu_si128((__m128i *)(coefficients + i * 8), v[i]);
+  }
+}
+
+static void inverse_dct_sse2(const int16_t *coefficients, int16_t *data_unit) {
+  __m128i v[8];
+  for (size_t i = 0; i < 8; i++) {
+    v[i] = _mm_loadu_si128((const __m128i *)(coefficients + i * 8));
+  }
+
+  inverse_dct_1d_sse2(v, CONST_BITS - PASS1_BITS);
+  transpose_sse2(v);
+  inverse_dct_1d_sse2(v, CONST_BITS + PASS1_BITS + 3);
+  transpose_sse2(v);
+
+  for (size_t i = 0; i < 8; i++) {
+    _mm_storeu_si128((__m128i *)(data_unit + i * 8), v[i]);
+  }
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+// The AVX2 implementation does the multiply-adds for all eight lanes in one
+// instruction.
+
+__attribute__((target("avx2"))) static __m256i
+multiply_add_avx2(__m128i a, __m128i b, int16_t ca, int16_t cb) {
+  __m256i c = _mm256_set1_epi32((uint16_t)ca | (uint32_t)(uint16_t)cb << 16);
+  return _mm256_madd_epi16(
+      _mm256_set_m128i(_mm_unpackhi_epi16(a, b), _mm_unpacklo_epi16(a, b)), c);
+}
+
+__attribute__((target("avx2"))) static __m128i descale_avx2(__m256i value,
+                                                           int shift) {
+  value = _mm256_sra_epi32(
+      _mm256_add_epi32(value, _mm256_set1_epi32(1 << (shift - 1))),
+      _mm_cvtsi32_si128(shift));
+  return _mm_packs_epi32(_mm256_castsi256_si128(value),
+                         _mm256_extracti128_si256(value, 1));
+}
+
+__attribute__((target("avx2"))) static void dct_1d_avx2(__m128i *v,
+                                                       bool first_pass) {
+  __m128i tmp0 = _mm_add_epi16(v[0], v[7]);
+  __m128i tmp7 = _mm_sub_epi16(v[0], v[7]);
+  __m128i tmp1 = _mm_add_epi16(v[1], v[6]);
+  __m128i tmp6 = _mm_sub_epi16(v[1], v[6]);
+  __m128i tmp2 = _mm_add_epi16(v[2], v[5]);
+  __m128i tmp5 = _mm_sub_epi16(v[2], v[5]);
+  __m128i tmp3 = _mm_add_epi16(v[3], v[4]);
+  __m128i tmp4 = _mm_sub_epi16(v[3], v[4]);
+
+  // Even part.
+  __m128i tmp10 = _mm_add_epi16(tmp0, tmp3);
+  __m128i tmp13 = _mm_sub_epi16(tmp0, tmp3);
+  __m128i tmp11 = _mm_add_epi16(tmp1, tmp2);
+  __m128i tmp12 = _mm_sub_epi16(tmp1, tmp2);
+
+  int shift;
+  if (first_pass) {
+    v[0] = _mm_slli_epi16(_mm_add_epi16(tmp10, tmp11), PASS1_BITS);
+    v[4] = _mm_slli_epi16(_mm_sub_epi16(tmp10, tmp11), PASS1_BITS);
+    shift = CONST_BITS - PASS1_BITS;
+  } else {
+    __m128i round = _mm_set1_epi16(1 << (PASS1_BITS - 1));
+    v[0] = _mm_srai_epi16(
+        _mm_add_epi16(_mm_add_epi16(tmp10, tmp11), round), PASS1_BITS);
+    v[4] = _mm_srai_epi16(
+        _mm_add_epi16(_mm_sub_epi16(tmp10, tmp11), round), PASS1_BITS);
+    shift = CONST_BITS + PASS1_BITS;
+  }
+
+  v[2] = descale_avx2(multiply_add_avx2(tmp13, tmp12,
+                                        FIX_0_541196100 + FIX_0_765366865,
+                                        FIX_0_541196100),
+                      shift);
+  v[6] = descale_avx2(multiply_add_avx2(tmp13, tmp12, FIX_0_541196100,
+                                        FIX_0_541196100 - FIX_1_847759065),
+                      shift);
+
+  // Odd part.
+  v[7] = descale_avx2(
+      _mm256_add_epi32(
+          multiply_add_avx2(tmp4, tmp5,
+                            FIX_0_298631336 - FIX_0_899976223 -
+                                FIX_1_961570560 + FIX_1_175875602,
+                            FIX_1_175875602),
+          multiply_add_avx2(tmp6, tmp7, FIX_1_175875602 - FIX_1_961570560,
+                            FIX_1_175875602 - FIX_0_899976223)),
+      shift);
+  v[5] = descale_avx2(
+      _mm256_add_epi32(
+          multiply_add_avx2(tmp4, tmp5, FIX_1_175875602,
+                            FIX_2_053119869 - FIX_2_562915447 -
+                                FIX_0_390180644 + FIX_1_175875602),
+          multiply_add_avx2(tmp6, tmp7, FIX_1_175875602 - FIX_2_562915447,
+                            FIX_1_175875602 - FIX_0_390180644)),
+      shift);
+  v[3] = descale_avx2(
+      _mm256_add_epi32(
+          multiply_add_avx2(tmp4, tmp5, FIX_1_175875602 - FIX_1_961570560,
+                            FIX_1_175875602 - FIX_2_562915447),
+          multiply_add_avx2(tmp6, tmp7,
+                            FIX_3_072711026 - FIX_2_562915447 -
+                                FIX_1_961570560 + FIX_1_175875602,
+                            FIX_1_175875602)),
+      shift);
+  v[1] = descale_avx2(
+      _mm256_add_epi32(
+          multiply_add_avx2(tmp4, tmp5, FIX_1_175875602 - FIX_0_899976223,
+                            FIX_1_175875602 - FIX_0_390180644),
+          multiply_add_avx2(tmp6, tmp7, FIX_1_175875602,
+                            FIX_1_501321110 - FIX_0_899976223 -
+                                FIX_0_390180644 + FIX_1_175875602)),
+      shift);
+}
+
+__attribute__((target("avx2"))) static void inverse_dct_1d_avx2(__m128i *v,
+                                                               int shift) {
+  // Even part.
+  __m256i tmp0 =
+      multiply_add_avx2(v[0], v[4], 1 << CONST_BITS, 1 << CONST_BITS);
+  __m256i tmp1 =
+      multiply_add_avx2(v[0], v[4], 1 << CONST_BITS, -(1 << CONST_BITS));
+  __m256i tmp2 = multiply_add_avx2(v[2], v[6], FIX_0_541196100,
+                                   FIX_0_541196100 - FIX_1_847759065);
+  __m256i tmp3 = multiply_add_avx2(
+      v[2], v[6], FIX_0_541196100 + FIX_0_765366865, FIX_0_541196100);
+
+  __m256i tmp10 = _mm256_add_epi32(tmp0, tmp3);
+  __m256i tmp13 = _mm256_sub_epi32(tmp0, tmp3);
+  __m256i tmp11 = _mm256_add_epi32(tmp1, tmp2);
+  __m256i tmp12 = _mm256_sub_epi32(tmp1, tmp2);
+
+  // Odd part.
+  tmp0 = _mm256_add_epi32(
+      multiply_add_avx2(v[1], v[3], FIX_1_175875602 - FIX_0_899976223,
+                        FIX_1_175875602 - FIX_1_961570560),
+      multiply_add_avx2(v[5], v[7], FIX_1_175875602,
+                        FIX_0_298631336 - FIX_0_899976223 -
+                            FIX_1_961570560 + FIX_1_175875602));
+  tmp1 = _mm256_add_epi32(
+      multiply_add_avx2(v[1], v[3], FIX_1_175875602 - FIX_0_390180644,
+                        FIX_1_175875602 - FIX_2_562915447),
+      multiply_add_avx2(v[5], v[7],
+                        FIX_2_053119869 - FIX_2_562915447 -
+                            FIX_0_390180644 + FIX_1_175875602,
+                        FIX_1_175875602));
+  tmp2 = _mm256_add_epi32(
+      multiply_add_avx2(v[1], v[3], FIX_1_175875602,
+                        FIX_3_072711026 - FIX_2_562915447 -
+                            FIX_1_961570560 + FIX_1_175875602),
+      multiply_add_avx2(v[5], v[7], FIX_1_175875602 - FIX_2_562915447,
+                        FIX_1_175875602 - FIX_1_961570560));
+  tmp3 = _mm256_add_epi32(
+      multiply_add_avx2(v[1], v[3],
+                        FIX_1_501321110 - FIX_0_899976223 -
+                            FIX_0_390180644 + FIX_1_175875602,
+                        FIX_1_175875602),
+      multiply_add_avx2(v[5], v[7], FIX_1_175875602 - FIX_0_390180644,
+                        FIX_1_175875602 - FIX_0_899976223));
+
+  v[0] = descale_avx2(_mm256_add_epi32(tmp10, tmp3), shift);
+  v[7] = descale_avx2(_mm256_sub_epi32(tmp10, tmp3), shift);
+  v[1] = descale_avx2(_mm256_add_epi32(tmp11, tmp2), shift);
+  v[6] = descale_avx2(_mm256_sub_epi32(tmp11, tmp2), shift);
+  v[2] = descale_avx2(_mm256_add_epi32(tmp12, tmp1), shift);
+  v[5] = descale_avx2(_mm256_sub_epi32(tmp12, tmp1), shift);
+  v[3] = descale_avx2(_mm256_add_epi32(tmp13, tmp0), shift);
+  v[4] = descale_avx2(_mm256_sub_epi32(tmp13, tmp0), shift);
+}
+
+__attribute__((target("avx2"))) static void dct_avx2(const int16_t *data_unit,
+                                                    int16_t *coefficients) {
+  __m128i v[8];
+  for (size_t i = 0; i < 8; i++) {
+    v[i] = _mm_loadu_si128((const __m128i *)(data_unit + i * 8));
+  }
+
+  transpose_sse2(v);
+  dct_1d_avx2(v, true);
+  transpose_sse2(v);
+  dct_1d_avx2(v, false);
+
+  for (size_t i = 0; i < 8; i++) {
+    _mm_storeu_si128((__m128i *)(coefficients + i * 8), v[i]);
+  }
+}
+
+__attribute__((target("avx2"))) static void
+inverse_dct_avx2(const int16_t *coefficients, int16_t *data_unit) {
+  __m128i v[8];
+  for (size_t i = 0; i < 8; i++) {
+    v[i] = _mm_loadu_si128((const __m128i *)(coefficients + i * 8));
+  }
+
+  inverse_dct_1d_avx2(v, CONST_BITS - PASS1_BITS);
+  transpose_sse2(v);
+  inverse_dct_1d_avx2(v, CONST_BITS + PASS1_BITS + 3);
+  transpose_sse2(v);
+
+  for (size_t i = 0; i < 8; i++) {
+    _mm_storeu_si128((__m128i *)(data_unit + i * 8), v[i]);
+  }
+}
+#endif
+
+// Implementations from slowest to fastest, the last is the one used.
+static JpegDctFunctions implementations[3];
+static size_t n_implementations = 0;
+static pthread_once_t implementations_once = PTHREAD_ONCE_INIT;
+
+// Find the transforms the CPU supports. Components are decoded on separate
+// threads, which all use these.
+static void select_implementations() {
+  implementations[n_implementations++] =
+      (JpegDctFunctions){"scalar", dct_scalar, inverse_dct_scalar};
+#if defined(__SSE2__)
+  implementations[n_implementations++] =
+      (JpegDctFunctions){"sse2", dct_sse2, inverse_dct_sse2};
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+  if (_ut_cpu_has_avx2()) {
+    implementations[n_implementations++] =
+        (JpegDctFunctions){"avx2", dct_avx2, inverse_dct_avx2};
+  }
+#endif
+}
+
+static const JpegDctFunctions *get_dct_functions() {
+  pthread_once(&implementations_once, select_implementations);
+  return &implementations[n_implementations - 1];
+}
+
+size_t jpeg_get_dct_functions(const JpegDctFunctions **functions) {
+  pthread_once(&implementations_once, select_implementations);
+  *functions = implementations;
+  return n_implementations;
+}
+
+void jpeg_integer_dct(const int16_t *data_unit, int16_t *coefficients) {
+  get_dct_functions()->dct(data_unit, coefficients);
+}
+
+void jpeg_integer_inverse_dct(const int16_t *coefficients,
+                              int16_t *data_unit) {
+  get_dct_functions()->inverse_dct(coefficients, data_unit);
+}
+
+// Reduced size inverse transforms, as used by the IJG library (jidctred.c).
+// These compute the low frequency outputs directly from the coefficients, so
+// scaled images can be decoded without doing the full transform. Coefficient
+// 4 doesn't contribute to the 4 point outputs, and coefficients 2, 4 and 6
+// don't contribute to the 2 point outputs.
+
+// 4 point inverse transform of the 8 values in [input], with output values
+// descaled by [shift] bits.
+static void inverse_dct_1d_4(const int32_t *input, int32_t *output,
+                             int shift) {
+  // Even part.
+  int32_t tmp0 = input[0] * (1 << (CONST_BITS + 1));
+  int32_t tmp2 = input[2] * FIX_1_847759065 - input[6] * FIX_0_765366865;
+  int32_t tmp10 = tmp0 + tmp2;
+  int32_t tmp12 = tmp0 - tmp2;
+
+  // Odd part.
+  tmp0 = input[7] * -FIX_0_211164243 + input[5] * FIX_1_451774981 +
+         input[3] * -FIX_2_172734803 + input[1] * FIX_1_061594337;
+  tmp2 = input[7] * -FIX_0_509795579 + input[5] * -FIX_0_601344887 +
+         input[3] * FIX_0_899976223 + input[1] * FIX_2_562915447;
+
+  output[0] = descale(tmp10 + tmp2, shift + 1);
+  output[3] = descale(tmp10 - tmp2, shift + 1);
+  output[1] = descale(tmp12 + tmp0, shift + 1);
+  output[2] = descale(tmp12 - tmp0, shift + 1);
+}
+
+// 2 point inverse transform of the 8 values in [input], with output values
+// descaled by [shift] bits.
+static void inverse_dct_1d_2(const int32_t *input, int32_t *output,
+                             int shift) {
+  int32_t tmp10 = input[0] * (1 << (CONST_BITS + 2));
+  int32_t tmp0 = input[7] * -FIX_0_720959822 + input[5] * FIX_0_850430095 +
+                 input[3] * -FIX_1_272758580 + input[1] * FIX_3_624509785;
+
+  output[0] = descale(tmp10 + tmp0, shift + 2);
+  output[1] = descale(tmp10 - tmp0, shift + 2);
+}
+
+typedef void (*InverseDct1dFunction)(const int32_t *input, int32_t *output,
+                                     int shift);
+
+// Inverse transform of [coefficients] into [size]x[size] samples in
+// [data_unit] using [inverse_dct_1d].
+static void reduced_inverse_dct(const int16_t *coefficients,
+                                int16_t *data_unit, size_t size,
+                                InverseDct1dFunction inverse_dct_1d) {
+  int16_t workspace[64];
+  int32_t input[8], output[8];
+
+  for (size_t u = 0; u < 8; u++) {
+    for (size_t v = 0; v < 8; v++) {
+      input[v] = coefficients[(v * 8) + u];
+    }
+    inverse_dct_1d(input, output, CONST_BITS - PASS1_BITS);
+    for (size_t y = 0; y < size; y++) {
+      workspace[(y * 8) + u] = clamp_int16(output[y]);
+    }
+  }
+
+  for (size_t y = 0; y < size; y++) {
+    for (size_t u = 0; u < 8; u++) {
+      input[u] = workspace[(y * 8) + u];
+    }
+    inverse_dct_1d(input, output, CONST_BITS + PASS1_BITS + 3);
+    for (size_t x = 0; x < size; x++) {
+      data_unit[(y * size) + x] = clamp_int16(output[x]);
+    }
+  }
+}
+
+void jpeg_integer_inverse_dct_4x4(const int16_t *coefficients,
+                                  int16_t *data_unit) {
+  reduced_inverse_dct(coefficients, data_unit, 4, inverse_dct_1d_4);
+}
+
+void jpeg_integer_inverse_dct_2x2(const int16_t *coefficients,
+                                  int16_t *data_unit) {
+  reduced_inverse_dct(coefficients, data_unit, 2, inverse_dct_1d_2);
+}
+
+void jpeg_integer_inverse_dct_1x1(const int16_t *coefficients,
+                                  int16_t *data_unit) {
+  data_unit[0] = descale(coefficients[0], 3);
+}
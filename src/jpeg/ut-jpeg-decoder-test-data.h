@@ -73,3 +73,478 @@ const char *ange_albertini_image_data =
     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff";
 // clang-format on
+
+// Synthetic 30x27 image with 4:2:0 chroma subsampling.
+const char *ycbcr420_data =
+    "ffd8ffdb0043000101010101010101010101010101010101010101010101010101010101"
+    "0101010101010101010101010101010101010101010101010101010101010101010101ff"
+    "c0001108001b001e03012200021100031100ffc4001f0000010501010101010100000000"
+    "000000000102030405060708090a0bffc400141001000000000000000000000000000000"
+    "00ffda000c03010002000300003f00fc1f7e6fbfdba1f23bd01fc3bbf8df7f39eff5a87e"
+    "43be6773efe51df84eff004b87d60fe7dda0fb81fe14ef177fb8c3fb7079bbffd9";
+
+const char *ycbcr420_image_data =
+    "009252009252009252009252009252009252009252009252006e2e006e2e006e2e006e2e"
+    "006e2e006e2e006e2e00702500d77700d96f00d96f00d96f00d96f00d96f00d96f00d96f"
+    "009329009329009329009329009329009329009252009252009252009252009252009252"
+    "009252009252006e2e006e2e006e2e006e2e006e2e006e2e006e2e00702500d77700d96f"
+    "00d96f00d96f00d96f00d96f00d96f00d96f009329009329009329009329009329009329"
+    "009252009252009252009252009252009252009252009252006e2e006e2e006e2e006e2e"
+    "006e2e006e2e006e2e00702500d77700d96f00d96f00d96f00d96f00d96f00d96f00d96f"
+    "009329009329009329009329009329009329009252009252009252009252009252009252"
+    "009252009252006e2e006e2e006e2e006e2e006e2e006e2e006e2e00702500d77700d96f"
+    "00d96f00d96f00d96f00d96f00d96f00d96f009329009329009329009329009329009329"
+    "009252009252009252009252009252009252009252009252006e2e006e2e006e2e006e2e"
+    "006e2e006e2e006e2e00702500d77700d96f00d96f00d96f00d96f00d96f00d96f00d96f"
+    "009329009329009329009329009329009329009252009252009252009252009252009252"
+    "009252009252006e2e006e2e006e2e006e2e006e2e006e2e006e2e00702500d77700d96f"
+    "00d96f00d96f00d96f00d96f00d96f00d96f009329009329009329009329009329009329"
+    "009252009252009252009252009252009252009252009252006e2e006e2e006e2e006e2e"
+    "006e2e006e2e006e2e00702500d77700d96f00d96f00d96f00d96f00d96f00d96f00d96f"
+    "009329009329009329009329009329009329009252009252009252009252009252009252"
+    "009252009252006e2e006e2e006e2e006e2e006e2e006e2e006e2e00702500d77700d96f"
+    "00d96f00d96f00d96f00d96f00d96f00d96f009329009329009329009329009329009329"
+    "5fffff5fffff5fffff5fffff5fffff5fffff5fffff5fffff48fff448fff448fff448fff4"
+    "48fff448fff448fff446ffeb4effe64dffde4dffde4dffde4dffde4dffde4dffde4dffde"
+    "1effaf1effaf1effaf1effaf1effaf1effaf5fffff5fffff5fffff5fffff5fffff5fffff"
+    "5fffff5fffff48fff448fff448fff448fff448fff448fff448fff446ffeb4effe64dffde"
+    "4dffde4dffde4dffde4dffde4dffde4dffde1effaf1effaf1effaf1effaf1effaf1effaf"
+    "5fffff5fffff5fffff5fffff5fffff5fffff5fffff5fffff48fff448fff448fff448fff4"
+    "48fff448fff448fff446ffeb4effe64dffde4dffde4dffde4dffde4dffde4dffde4dffde"
+    "1effaf1effaf1effaf1effaf1effaf1effaf5fffff5fffff5fffff5fffff5fffff5fffff"
+    "5fffff5fffff48fff448fff448fff448fff448fff448fff448fff446ffeb4effe64dffde"
+    "4dffde4dffde4dffde4dffde4dffde4dffde1effaf1effaf1effaf1effaf1effaf1effaf"
+    "5fffff5fffff5fffff5fffff5fffff5fffff5fffff5fffff48fff448fff448fff448fff4"
+    "48fff448fff448fff446ffeb4effe64dffde4dffde4dffde4dffde4dffde4dffde4dffde"
+    "1effaf1effaf1effaf1effaf1effaf1effaf5fffff5fffff5fffff5fffff5fffff5fffff"
+    "5fffff5fffff48fff448fff448fff448fff448fff448fff448fff446ffeb4effe64dffde"
+    "4dffde4dffde4dffde4dffde4dffde4dffde1effaf1effaf1effaf1effaf1effaf1effaf"
+    "5fffff5fffff5fffff5fffff5fffff5fffff5fffff5fffff48fff448fff448fff448fff4"
+    "48fff448fff448fff446ffeb4effe64dffde4dffde4dffde4dffde4dffde4dffde4dffde"
+    "1effaf1effaf1effaf1effaf1effaf1effaf5fffe65dffe65fffe65dffe65fffe65dffe6"
+    "5fffe65dffe648ffcf46ffcf48ffcf46ffcf48ffcf46ffcf48ffcf45ffd44dffec4afff1"
+    "4afff14afff14afff14afff14afff14afff11bffc21bffc21bffc21bffc21bffc21bffc2"
+    "00cf0a00d00a00cf0a00d00a00cf0a00d00a00cf0a00d00a009400009500009400009500"
+    "009400009500009400008f0051fffe4effff4effff4effff4effff4effff4effff4effff"
+    "005d37005d37005d37005d37005d37005d3700d70000d70000d70000d70000d70000d700"
+    "00d70000d700009c00009c00009c00009c00009c00009c00009c000094004effff4bffff"
+    "4bffff4bffff4bffff4bffff4bffff4bffff005b4a005b4a005b4a005b4a005b4a005b4a"
+    "00d70000d70000d70000d70000d70000d70000d70000d700009c00009c00009c00009c00"
+    "009c00009c00009c000094004effff4bffff4bffff4bffff4bffff4bffff4bffff4bffff"
+    "005b4a005b4a005b4a005b4a005b4a005b4a00d70000d70000d70000d70000d70000d700"
+    "00d70000d700009c00009c00009c00009c00009c00009c00009c000094004effff4bffff"
+    "4bffff4bffff4bffff4bffff4bffff4bffff005b4a005b4a005b4a005b4a005b4a005b4a"
+    "00d70000d70000d70000d70000d70000d70000d70000d700009c00009c00009c00009c00"
+    "009c00009c00009c000094004effff4bffff4bffff4bffff4bffff4bffff4bffff4bffff"
+    "005b4a005b4a005b4a005b4a005b4a005b4a00d70000d70000d70000d70000d70000d700"
+    "00d70000d700009c00009c00009c00009c00009c00009c00009c000094004effff4bffff"
+    "4bffff4bffff4bffff4bffff4bffff4bffff005b4a005b4a005b4a005b4a005b4a005b4a"
+    "00d70000d70000d70000d70000d70000d70000d70000d700009c00009c00009c00009c00"
+    "009c00009c00009c000094004effff4bffff4bffff4bffff4bffff4bffff4bffff4bffff"
+    "005b4a005b4a005b4a005b4a005b4a005b4a00d70000d70000d70000d70000d70000d700"
+    "00d70000d700009c00009c00009c00009c00009c00009c00009c000094004effff4bffff"
+    "4bffff4bffff4bffff4bffff4bffff4bffff005b4a005b4a005b4a005b4a005b4a005b4a"
+    "26ff4026ff4026ff4026ff4026ff4026ff4026ff4026ff403cff563cff563cff563cff56"
+    "3cff563cff563cff5639ff8600560d004e3d004e3d004e3d004e3d004e3d004e3d004e3d"
+    "36ffff36ffff36ffff36ffff36ffff36ffff26ff4026ff4026ff4026ff4026ff4026ff40"
+    "26ff4026ff403cff563cff563cff563cff563cff563cff563cff5639ff8600560d004e3d"
+    "004e3d004e3d004e3d004e3d004e3d004e3d36ffff36ffff36ffff36ffff36ffff36ffff"
+    "26ff4026ff4026ff4026ff4026ff4026ff4026ff4026ff403cff563cff563cff563cff56"
+    "3cff563cff563cff5639ff8600560d004e3d004e3d004e3d004e3d004e3d004e3d004e3d"
+    "36ffff36ffff36ffff36ffff36ffff36ffff";
+
+const char *ycbcr420_nearest_image_data =
+    "009252009252009252009252009252009252009252009252006e2e006e2e006e2e006e2e"
+    "006e2e006e2e006e2e006e2e00d96f00d96f00d96f00d96f00d96f00d96f00d96f00d96f"
+    "009329009329009329009329009329009329009252009252009252009252009252009252"
+    "009252009252006e2e006e2e006e2e006e2e006e2e006e2e006e2e006e2e00d96f00d96f"
+    "00d96f00d96f00d96f00d96f00d96f00d96f009329009329009329009329009329009329"
+    "009252009252009252009252009252009252009252009252006e2e006e2e006e2e006e2e"
+    "006e2e006e2e006e2e006e2e00d96f00d96f00d96f00d96f00d96f00d96f00d96f00d96f"
+    "009329009329009329009329009329009329009252009252009252009252009252009252"
+    "009252009252006e2e006e2e006e2e006e2e006e2e006e2e006e2e006e2e00d96f00d96f"
+    "00d96f00d96f00d96f00d96f00d96f00d96f009329009329009329009329009329009329"
+    "009252009252009252009252009252009252009252009252006e2e006e2e006e2e006e2e"
+    "006e2e006e2e006e2e006e2e00d96f00d96f00d96f00d96f00d96f00d96f00d96f00d96f"
+    "009329009329009329009329009329009329009252009252009252009252009252009252"
+    "009252009252006e2e006e2e006e2e006e2e006e2e006e2e006e2e006e2e00d96f00d96f"
+    "00d96f00d96f00d96f00d96f00d96f00d96f009329009329009329009329009329009329"
+    "009252009252009252009252009252009252009252009252006e2e006e2e006e2e006e2e"
+    "006e2e006e2e006e2e006e2e00d96f00d96f00d96f00d96f00d96f00d96f00d96f00d96f"
+    "009329009329009329009329009329009329009252009252009252009252009252009252"
+    "009252009252006e2e006e2e006e2e006e2e006e2e006e2e006e2e006e2e00d96f00d96f"
+    "00d96f00d96f00d96f00d96f00d96f00d96f009329009329009329009329009329009329"
+    "5fffff5fffff5fffff5fffff5fffff5fffff5fffff5fffff48fff448fff448fff448fff4"
+    "48fff448fff448fff448fff44dffde4dffde4dffde4dffde4dffde4dffde4dffde4dffde"
+    "1effaf1effaf1effaf1effaf1effaf1effaf5fffff5fffff5fffff5fffff5fffff5fffff"
+    "5fffff5fffff48fff448fff448fff448fff448fff448fff448fff448fff44dffde4dffde"
+    "4dffde4dffde4dffde4dffde4dffde4dffde1effaf1effaf1effaf1effaf1effaf1effaf"
+    "5fffff5fffff5fffff5fffff5fffff5fffff5fffff5fffff48fff448fff448fff448fff4"
+    "48fff448fff448fff448fff44dffde4dffde4dffde4dffde4dffde4dffde4dffde4dffde"
+    "1effaf1effaf1effaf1effaf1effaf1effaf5fffff5fffff5fffff5fffff5fffff5fffff"
+    "5fffff5fffff48fff448fff448fff448fff448fff448fff448fff448fff44dffde4dffde"
+    "4dffde4dffde4dffde4dffde4dffde4dffde1effaf1effaf1effaf1effaf1effaf1effaf"
+    "5fffff5fffff5fffff5fffff5fffff5fffff5fffff5fffff48fff448fff448fff448fff4"
+    "48fff448fff448fff448fff44dffde4dffde4dffde4dffde4dffde4dffde4dffde4dffde"
+    "1effaf1effaf1effaf1effaf1effaf1effaf5fffff5fffff5fffff5fffff5fffff5fffff"
+    "5fffff5fffff48fff448fff448fff448fff448fff448fff448fff448fff44dffde4dffde"
+    "4dffde4dffde4dffde4dffde4dffde4dffde1effaf1effaf1effaf1effaf1effaf1effaf"
+    "5fffff5fffff5fffff5fffff5fffff5fffff5fffff5fffff48fff448fff448fff448fff4"
+    "48fff448fff448fff448fff44dffde4dffde4dffde4dffde4dffde4dffde4dffde4dffde"
+    "1effaf1effaf1effaf1effaf1effaf1effaf5fffff5fffff5fffff5fffff5fffff5fffff"
+    "5fffff5fffff48fff448fff448fff448fff448fff448fff448fff448fff44dffde4dffde"
+    "4dffde4dffde4dffde4dffde4dffde4dffde1effaf1effaf1effaf1effaf1effaf1effaf"
+    "00d70000d70000d70000d70000d70000d70000d70000d700009c00009c00009c00009c00"
+    "009c00009c00009c00009c004bffff4bffff4bffff4bffff4bffff4bffff4bffff4bffff"
+    "005b4a005b4a005b4a005b4a005b4a005b4a00d70000d70000d70000d70000d70000d700"
+    "00d70000d700009c00009c00009c00009c00009c00009c00009c00009c004bffff4bffff"
+    "4bffff4bffff4bffff4bffff4bffff4bffff005b4a005b4a005b4a005b4a005b4a005b4a"
+    "00d70000d70000d70000d70000d70000d70000d70000d700009c00009c00009c00009c00"
+    "009c00009c00009c00009c004bffff4bffff4bffff4bffff4bffff4bffff4bffff4bffff"
+    "005b4a005b4a005b4a005b4a005b4a005b4a00d70000d70000d70000d70000d70000d700"
+    "00d70000d700009c00009c00009c00009c00009c00009c00009c00009c004bffff4bffff"
+    "4bffff4bffff4bffff4bffff4bffff4bffff005b4a005b4a005b4a005b4a005b4a005b4a"
+    "00d70000d70000d70000d70000d70000d70000d70000d700009c00009c00009c00009c00"
+    "009c00009c00009c00009c004bffff4bffff4bffff4bffff4bffff4bffff4bffff4bffff"
+    "005b4a005b4a005b4a005b4a005b4a005b4a00d70000d70000d70000d70000d70000d700"
+    "00d70000d700009c00009c00009c00009c00009c00009c00009c00009c004bffff4bffff"
+    "4bffff4bffff4bffff4bffff4bffff4bffff005b4a005b4a005b4a005b4a005b4a005b4a"
+    "00d70000d70000d70000d70000d70000d70000d70000d700009c00009c00009c00009c00"
+    "009c00009c00009c00009c004bffff4bffff4bffff4bffff4bffff4bffff4bffff4bffff"
+    "005b4a005b4a005b4a005b4a005b4a005b4a00d70000d70000d70000d70000d70000d700"
+    "00d70000d700009c00009c00009c00009c00009c00009c00009c00009c004bffff4bffff"
+    "4bffff4bffff4bffff4bffff4bffff4bffff005b4a005b4a005b4a005b4a005b4a005b4a"
+    "26ff4026ff4026ff4026ff4026ff4026ff4026ff4026ff403cff563cff563cff563cff56"
+    "3cff563cff563cff563cff56004e3d004e3d004e3d004e3d004e3d004e3d004e3d004e3d"
+    "36ffff36ffff36ffff36ffff36ffff36ffff26ff4026ff4026ff4026ff4026ff4026ff40"
+    "26ff4026ff403cff563cff563cff563cff563cff563cff563cff563cff56004e3d004e3d"
+    "004e3d004e3d004e3d004e3d004e3d004e3d36ffff36ffff36ffff36ffff36ffff36ffff"
+    "26ff4026ff4026ff4026ff4026ff4026ff4026ff4026ff403cff563cff563cff563cff56"
+    "3cff563cff563cff563cff56004e3d004e3d004e3d004e3d004e3d004e3d004e3d004e3d"
+    "36ffff36ffff36ffff36ffff36ffff36ffff";
+
+// Synthetic 30x11 image with 4:2:2 chroma subsampling.
+const char *ycbcr422_data =
+    "ffd8ffdb0043000101010101010101010101010101010101010101010101010101010101"
+    "0101010101010101010101010101010101010101010101010101010101010101010101ff"
+    "c0001108000b001e03012100021100031100ffc4001f0000010501010101010100000000"
+    "000000000102030405060708090a0bffc400141001000000000000000000000000000000"
+    "00ffda000c03010002000300003f00fe37df483f88f7ef831dfe8d0fdf87e943f8ef7f47"
+    "0ff4587f25ef85df2fbe677f08efffd9";
+
+const char *ycbcr422_image_data =
+    "731600731600731600731600731600731600731600731600852800852800852800852800"
+    "852800852800852800921c00a90000b60000b60000b60000b60000b60000b60000b60000"
+    "ff8165ff8165ff8165ff8165ff8165ff8165731600731600731600731600731600731600"
+    "731600731600852800852800852800852800852800852800852800921c00a90000b60000"
+    "b60000b60000b60000b60000b60000b60000ff8165ff8165ff8165ff8165ff8165ff8165"
+    "731600731600731600731600731600731600731600731600852800852800852800852800"
+    "852800852800852800921c00a90000b60000b60000b60000b60000b60000b60000b60000"
+    "ff8165ff8165ff8165ff8165ff8165ff8165731600731600731600731600731600731600"
+    "731600731600852800852800852800852800852800852800852800921c00a90000b60000"
+    "b60000b60000b60000b60000b60000b60000ff8165ff8165ff8165ff8165ff8165ff8165"
+    "731600731600731600731600731600731600731600731600852800852800852800852800"
+    "852800852800852800921c00a90000b60000b60000b60000b60000b60000b60000b60000"
+    "ff8165ff8165ff8165ff8165ff8165ff8165731600731600731600731600731600731600"
+    "731600731600852800852800852800852800852800852800852800921c00a90000b60000"
+    "b60000b60000b60000b60000b60000b60000ff8165ff8165ff8165ff8165ff8165ff8165"
+    "731600731600731600731600731600731600731600731600852800852800852800852800"
+    "852800852800852800921c00a90000b60000b60000b60000b60000b60000b60000b60000"
+    "ff8165ff8165ff8165ff8165ff8165ff8165731600731600731600731600731600731600"
+    "731600731600852800852800852800852800852800852800852800921c00a90000b60000"
+    "b60000b60000b60000b60000b60000b60000ff8165ff8165ff8165ff8165ff8165ff8165"
+    "6330f96330f96330f96330f96330f96330f96330f96330f9aa77ffaa77ffaa77ffaa77ff"
+    "aa77ffaa77ffaa77ff808eff109eff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff"
+    "00a1ed00a1ed00a1ed00a1ed00a1ed00a1ed6330f96330f96330f96330f96330f96330f9"
+    "6330f96330f9aa77ffaa77ffaa77ffaa77ffaa77ffaa77ffaa77ff808eff109eff00b5ff"
+    "00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff00a1ed00a1ed00a1ed00a1ed00a1ed00a1ed"
+    "6330f96330f96330f96330f96330f96330f96330f96330f9aa77ffaa77ffaa77ffaa77ff"
+    "aa77ffaa77ffaa77ff808eff109eff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff"
+    "00a1ed00a1ed00a1ed00a1ed00a1ed00a1ed";
+
+const char *ycbcr422_nearest_image_data =
+    "731600731600731600731600731600731600731600731600852800852800852800852800"
+    "852800852800852800852800b60000b60000b60000b60000b60000b60000b60000b60000"
+    "ff8165ff8165ff8165ff8165ff8165ff8165731600731600731600731600731600731600"
+    "731600731600852800852800852800852800852800852800852800852800b60000b60000"
+    "b60000b60000b60000b60000b60000b60000ff8165ff8165ff8165ff8165ff8165ff8165"
+    "731600731600731600731600731600731600731600731600852800852800852800852800"
+    "852800852800852800852800b60000b60000b60000b60000b60000b60000b60000b60000"
+    "ff8165ff8165ff8165ff8165ff8165ff8165731600731600731600731600731600731600"
+    "731600731600852800852800852800852800852800852800852800852800b60000b60000"
+    "b60000b60000b60000b60000b60000b60000ff8165ff8165ff8165ff8165ff8165ff8165"
+    "731600731600731600731600731600731600731600731600852800852800852800852800"
+    "852800852800852800852800b60000b60000b60000b60000b60000b60000b60000b60000"
+    "ff8165ff8165ff8165ff8165ff8165ff8165731600731600731600731600731600731600"
+    "731600731600852800852800852800852800852800852800852800852800b60000b60000"
+    "b60000b60000b60000b60000b60000b60000ff8165ff8165ff8165ff8165ff8165ff8165"
+    "731600731600731600731600731600731600731600731600852800852800852800852800"
+    "852800852800852800852800b60000b60000b60000b60000b60000b60000b60000b60000"
+    "ff8165ff8165ff8165ff8165ff8165ff8165731600731600731600731600731600731600"
+    "731600731600852800852800852800852800852800852800852800852800b60000b60000"
+    "b60000b60000b60000b60000b60000b60000ff8165ff8165ff8165ff8165ff8165ff8165"
+    "6330f96330f96330f96330f96330f96330f96330f96330f9aa77ffaa77ffaa77ffaa77ff"
+    "aa77ffaa77ffaa77ffaa77ff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff"
+    "00a1ed00a1ed00a1ed00a1ed00a1ed00a1ed6330f96330f96330f96330f96330f96330f9"
+    "6330f96330f9aa77ffaa77ffaa77ffaa77ffaa77ffaa77ffaa77ffaa77ff00b5ff00b5ff"
+    "00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff00a1ed00a1ed00a1ed00a1ed00a1ed00a1ed"
+    "6330f96330f96330f96330f96330f96330f96330f96330f9aa77ffaa77ffaa77ffaa77ff"
+    "aa77ffaa77ffaa77ffaa77ff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff00b5ff"
+    "00a1ed00a1ed00a1ed00a1ed00a1ed00a1ed";
+
+// Synthetic 40x24 progressive image with 4:2:0 chroma subsampling, using
+// spectral selection and successive approximation.
+const char *progressive_data =
+    "ffd8ffdb004300100b0a101828333d0c0c0e131a3a3c370e0d1018283945380e11161d33"
+    "57503e12162538446d674d182337405168715c31404e5767797865485c5f6270646763ff"
+    "c20011080018002803012200021100031100ffc40022000000000f000000000000000000"
+    "000000000102030405060708090a0b0c0d0effc401121000000000000000ff0000000000"
+    "0000000102030405060708090a1112131415161718191a2122232425262728292a313233"
+    "3435363738393a4142434445464748494a5152535455565758595a616263646566676869"
+    "6a7172737475767778797a8182838485868788898a9192939495969798999aa1a2a3a4a5"
+    "a6a7a8a9aab1b2b3b4b5b6b7b8b9bac1c2c3c4c5c6c7c8c9cad1d2d3d4d5d6d7d8d9dae1"
+    "e2e3e4e5e6e7e8e9eaf1f2f3f4f5f6f7f8f9fa00102030405060708090a0b0c0d0e0f00b"
+    "0c0d0e0f1b1c1d1e1f2b2c2d2e2f3b3c3d3e3f4b4c4d4e4f5b5c5d5e5f6b6c6d6e6f7b7c"
+    "7d7e7f8b8c8d8e8f9b9c9d9e9fabacadaeafbbbcbdbebfcbcccdcecfdbdcdddedfebeced"
+    "eeeffbfcfdfeffda000c03010002000300000001404b436a118fb3282d133cb74a6c98e6"
+    "8d9c522ac84b695480b92d784202d4c89409078a4bffda000801010001050201c0202d12"
+    "2b5005d440ab40170068401a17ffda0008010300013f01020190071e2d003403c1540215"
+    "008f078000ad00fe29018505000006840760100144023c1e0542b5e8caf0a0fc01000500"
+    "5460a683ffda0008010200013f011f80601405282d6bcf15e14a0010280280c011540200"
+    "0a0a2bebe31401780c281547814a01e0a406142840201a0fffda0008010100063f02a180"
+    "42b403da32150ad0bfffda0008010100013f210ac008a0005100056875e57b22bc28f005"
+    "02a1500502d0291e0a001408d0a40201008f029402914c102b43000f03c0a802878a6290"
+    "f4010a14285fffda000c030100020003000000100b1f048ccfffda0008010300013f100a"
+    "d78c0000450010080052290014002141ed04174014141e078011405402280a500547b943"
+    "029008040065008005251140f284294f0200251140002815288a250a01418140a8502a00"
+    "8a2140a801421500140280100507ffda0008010200013f1014283c01288000032850003d"
+    "0a00453009400142140c014051e2011480052010a0000214000028414c7880085518000a"
+    "05002791e0500014a096a0140f00015000000001140502801008a40001008016bfffda00"
+    "08010100013f1078b00000a0a4a0dd000042800a1800c80505215328007a501485052280"
+    "085214008540340461e0000000a229140a00015000f02828a01e9410f01945201140002a"
+    "780a856811b000a100f028151e0507a3c140f42b408c428283283c000040029148047865"
+    "288068664015c29008040264280f428150a000500000002323c9423d00a8052141485450"
+    "000a054001414d08a100a142050781e85000000085450140a0047942ffd9";
+
+const char *progressive_image_data =
+    "bf6d008f1d00ac006871005241000053200d3f0032760d72d630aecb40778c7609938100"
+    "df6000f05500c75d00a1604059387d602bad9312adae04adb301adc700adeb00adf400ad"
+    "be0085a20072af007d7400638d2abb5928a80f0063430033fa801dffe03cfff667ffdc4c"
+    "fffb59ebfa59e0ff97c2ff9fd996007e2100b92650a2116e64073c98578273316f370025"
+    "cb3d87c04d54857c00888200c76200d55800b065008f6a3e4a407c5730ad8c15adab05ad"
+    "b202adc700adea00adf600adff0cd49c00639c00638000634800634e008aa35fe6310022"
+    "ffe39cffdf56ffc13fd2b325dfdc35eaff5addff7f77d831a47e00986400be6e0b983337"
+    "7205949232da7d3e8d6a2c39b65739ab650d7788007088009765409d604d84761d6a7e37"
+    "2d507a403cad7f1cada508adaf03adc700adea00adfb00add7008ebe0076ab0063ff54ff"
+    "6b00636d00816a008e450035c95443ffbf6dffff95cdd1469bc211c2ff34caff3e68dc00"
+    "d7ba168363006746008f5418ab42d3851edf4e1b6a5f3a27a76906a273007f8400787f0b"
+    "8f6265945e6e897226737a362a5178393fad7c1dada20aada906adbe00addd00adf100ad"
+    "db0090bf0076a10063850063df42e774008f4a0063490033fda28ffff2a4fffbafd8ce6d"
+    "ecff82e6ff70c8ff44d2ff45ddb2648164005f5c0057440042002e7c23999273ae33230a"
+    "9d7300a775009e7300a06a12ac5a42b85444c35719a85e3743447a433aad8319ada20aad"
+    "a10aadac05adc500addc00ada90065b8007a7e0063510063561da08f5ede400063982777"
+    "fffbaafff178ffc4a0e89c8efff6c0f8ffaebfe171afdd617547376f57295f72095f6619"
+    "460932581a5b6a6b6d16270088770d9974009e7200a26d00a56616b05d29c45132b84f5e"
+    "6531866628ad9411ada708ad9e0cada10aadb003adc800adea00af9a0063960089400063"
+    "6039b60d0063a42dc549002edebb83dbc560ffecc3ffc8b1c9b382c6d68be9ff9eadd55b"
+    "b997a542353c0009003a4e597150971a0224002c000039006a746b7871577f83007f8b00"
+    "7888007d7a198d6170a14ca992159fa20aadb003adaf03ada00bad9a0eada00badb700ad"
+    "ff24e7ab00757700637a00873200636e11a0a81aba4f004cffe5ffffe9d6fff499fff579"
+    "caf67dbbff73dfff61e2ff486850343d33310a1f4a1a2f660300190c14003c8200002800"
+    "5e7d5d6c7755768700778e00738e00777c1e845ba79e41e7a00ab4b500adb600adb202ad"
+    "a906ada10aad990fada20aad760063c100a674006373006dad0cb2b110b66b006370006e"
+    "ad6fc5f1ebedddf38697cf26baff6ab2ff5aabff2381cb00524500140d00393a704d578a"
+    "6a79286588002567005a9f00f2ff75a2b71ccbc94effff8ffff166ffca98ffceffffb3ff"
+    "ff99fff064fff156faa800a6ff63ffff6affb428c7c652e95200775e00777c0077910077"
+    "a00077a60077a30077780060b599c27cbe985dd47655e24861e60f76dd0795c62ca5bb3f"
+    "bbc73d7481296775803f5153364b003855001e4200597d00ffff39ffff45eed368fff5c1"
+    "fff0bfffdffdff8dffff7effa30ac7f453f9ed3de8ff7dffff91ffff99fff575ffe683ff"
+    "4500775300777500778e00779f0077a90077aa00777600569faaa65dd28141e27845e851"
+    "6ae30c89d600a0c12aacb73f154837002000003900113a00232d003126002e1f006a5700"
+    "f5dd01e1bd00ebb146ffe9dcf18ad9ffc4ffe66effffb0ffff81ffff64ffd800a5ff3df7"
+    "dd33dcff93ffbb55e7a73fd26100776f00777500777500776e00777900779500776a004d"
+    "87bb8b4ee15d4fe25466db3d92cb1aa7c600a5c900a3cc00004d7c00453c0057000a5100"
+    "2c3d064a3613543000693e00ffff3bffcc01ffc03effdfc3ffb3ffffbdffff89ffff8fff"
+    "ff50ffff11e1ff0dddff2eeead1bbce98cff8b3ec8ae51e06400776b00775c0077460077"
+    "2f00774200778100776400527cbd9b48e0715cd96478d0469bc718a9c700a0d1009cd600"
+    "197fb0003a3e003700107a0c3864270a0b00260f00795612ffe027ffe305ffc20dffd26f"
+    "ffc6d6ff8fffff81ffff87ffff43ffff05d6ff2fffff2eece76cffd99affbe89ffb977fd"
+    "4c0077480077260077030977001b770309776f00776700677bb3d84bd0bd68c5aa7cc66d"
+    "86d50a8edb0095d80098d700003740002f22003d0621833a466a240e0c00160a00331d00"
+    "e9cd23ffc100ffd416ffcb50ff9992fd1784ff65ffff56ffff43ffff2cfdfe00aff007c5"
+    "ff95ffbd7ffff4c7ff966cea2c00772c0077250077140177000e771c00777f00776c0070"
+    "7badf648ccdb66c4b276c96f79da0f89dc00a5cd00b1c7004a4300707e43164b3b00210a"
+    "2f2600866d00d7d028b4af00ffff6ae39e03ffb91affd071ff83a2ff78ffff8dffff6bff"
+    "ff11ffff73ffff0fe0ff59ffff83ff923bc88b56d83b269d000b771800775a00777c0077"
+    "7d00778e0077ae00777800707badf63ed4c953d78166d84c75d72c98c915d0b007eba301"
+    "cc7f177f4300371c15a68981be7c30430000491d00714a00ffda58ffa438ffad38ffcf87"
+    "ec3a54ff68e1ff48ffff94ffff38ebff6affec00afff29ffff5dffffa3ffde6fffd893ff"
+    "1304692600626f005b8e005d8300678d0075ad008787008bae8cff80aceb8db3a49cb476"
+    "acb161cfa24fff8a45ff7e3f6800008e09006e00005a0000650000680000640000941700"
+    "c44200e75814ba1300df3000e43822c5141cec2850ea2455e9335bf3248eff00faff00ff"
+    "fe05fff210f6f215dee024c3ffccffffd6ffe666a1fca2d6bfc1fce6c9ffff5dffff67ff"
+    "ff36fff63efffd41ffff47daff5199ff517dff4682ff41859800007b00007b0000960000"
+    "7b00007b00007b0000c31b00a10000c51d00cb2300ff78499c0000a10000ce2600ba1100"
+    "e73a40ee2887fd0afcff00ffff00ffff05efff0cdcee1cc7ffc7ffffdaffd18caba18695"
+    "c1dff9e0d9ffffaaffff9dffff25ffff1fffff1cffff23ffff32b5ff3992ff38a0ff37a7"
+    "7b00007b0000f24a1bed4516b109007b0000990000a70000b00800c921009a0000c82000"
+    "7b0000e33b0cf74f20b00000ff226cfd1aa7de1ee3e11aefff0dd1ff0ec7e51ed1b834d7"
+    "ffe0ff9999f9bad0ff8d81a5ffb1ebff97ffff93ffec5effff44abff3aa0ff31f7ff33f7"
+    "ff409eff467bff4889ff4890810000ad05008c0000aa02008100009c00007b0000be1600"
+    "b10900b70f00a70000c31b00b50d008c00008e0000cf140fff2370f51fa5cf29d1d324e1"
+    "ff0dd5ff0bd1e81cd7b735d5ffe7ffc2d2ffeaffffedc1f4ff6ebcff42c2ffa8ffffbeff"
+    "ff4aa5ff3c92ff36dcff37e3ff3fa5ff4682ff4b7bff4e759f00007b0000a500009d0000"
+    "e73f107b00007b0000b20a009300007d0000c51d009d0000db33047b00007f0000940000"
+    "de3c49d6367ecf2bc8de1af8ff01ffff00ffff06ece520c5ffdcffcea2c5b47099ffd2ff"
+    "ffb3ffff9bffffbbffffbdffff37ffff26ecff2bdeff2ed3ff2ecaff35abff4374ff4a57"
+    "7b00007b0000a90100bb13007b0000900000980000830000c21a007b0000ce26007b0000"
+    "7f00009b0000f95122980000de3d42dd3479e421c5f210faff00ffff01fff016dfda2bac"
+    "ff88beffd4edffb6e2ffd2ffff8ee6ff68e8c97effe180ffff29ffff19ffff28d5ff2cc2"
+    "ff28e5ff2adeff36acff3a94b109008400009300007b00007b0000a10000e63e0f7b0000"
+    "9700007b0000fc5425ea4213aa0200980000a80000ac0000ff265eff1891ff0cc7ff06e5"
+    "ff05ece51cdc974cb192568cf95788ffc1f3ffe5ffffeaffffb8ffffa9ffffb2ffffbaff"
+    "ff21ffff17ffff2bc3ff32b2ff2af9ff25ffff22ffff21ff9000007b00007b00007b0000"
+    "a100007b00007b0000930000bd1500b008009c0000ad05008b0000d02800810000d91612"
+    "ff1b6aff0a9eff02c7ff01daff08d5d42ac06a679c6f6b7cff6997ff4586ffe9fff5f7ff"
+    "ffe7ffd782e0a2299cff7bffff1dffff15ffff2dbbff34abff2bffff23ffff19ffff14ff";
+
+const char *ange_albertini_half_image_data =
+    "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+    "fffffffffffffffffffffffffefefefeffffffffffffffffffffffffffffffffffffffff"
+    "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffefefefeffffffff"
+    "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+    "fffffffffffffffffefefefeffffffffffffffffffffffffffffffffffffffffffffffff"
+    "fffffffffffffffffffffffffffffffffffffffffffffffffefefefeffffffffffffffff"
+    "ffffffff00000000ffffffff0000000000000000fefefefefefefefefefefefe00000000"
+    "00000000ffffffffffffffffffffffffffffffff00000000ffffffff0000000000000000"
+    "fefefefefefefefefefefefe0000000000000000ffffffffffffffffffffffffffffffff"
+    "00000000ffffffff0000000000000000fefefefefefefefefefefefe0000000000000000"
+    "ffffffffffffffffffffffffffffffff00000000ffffffff0000000000000000fefefefe"
+    "fefefefefefefefe0000000000000000ffffffffffffffffffffffffffffffff00000000"
+    "ffffffff00000000ffffffff00000000ffffffff00000000ffffffffffffffffffffffff"
+    "ffffffffffffffffffffffff00000000ffffffff00000000ffffffff00000000ffffffff"
+    "00000000ffffffffffffffffffffffffffffffffffffffffffffffff00000000ffffffff"
+    "00000000ffffffff00000000ffffffff00000000ffffffffffffffffffffffffffffffff"
+    "ffffffffffffffff00000000ffffffff00000000ffffffff00000000ffffffff00000000"
+    "ffffffffffffffffffffffffffffffffffffffffffffffff00000000ffffffff00000000"
+    "00000000ffffffffffffffff000000000000000000000000ffffffffffffffffffffffff"
+    "ffffffff00000000ffffffff0000000000000000ffffffffffffffff0000000000000000"
+    "00000000ffffffffffffffffffffffffffffffff00000000ffffffff0000000000000000"
+    "ffffffffffffffff000000000000000000000000ffffffffffffffffffffffffffffffff"
+    "00000000ffffffff0000000000000000ffffffffffffffff000000000000000000000000"
+    "ffffffffffffffff01010101ffffffff00000000ffffffff00000000ffffffffffffffff"
+    "ffffffff00000000ffffffff00000000ffffffffffffffff01010101ffffffff00000000"
+    "ffffffff00000000ffffffffffffffffffffffff00000000ffffffff00000000ffffffff"
+    "ffffffff01010101ffffffff00000000ffffffff00000000ffffffffffffffffffffffff"
+    "00000000ffffffff00000000ffffffffffffffff01010101ffffffff00000000ffffffff"
+    "00000000ffffffffffffffffffffffff00000000ffffffff00000000ffffffffffffffff"
+    "fefefefe00000000ffffffffffffffff00000000ffffffffffffffffffffffffffffffff"
+    "0000000000000000fffffffffffffffffefefefe00000000ffffffffffffffff00000000"
+    "ffffffffffffffffffffffffffffffff0000000000000000fffffffffffffffffefefefe"
+    "00000000ffffffffffffffff00000000ffffffffffffffffffffffffffffffff00000000"
+    "00000000fffffffffffffffffefefefe00000000ffffffffffffffff00000000ffffffff"
+    "ffffffffffffffffffffffff0000000000000000ffffffffffffffffffffffffffffffff"
+    "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+    "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+    "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+    "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+    "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+    "ffffffffffffffffffffffffffffffff";
+
+const char *ange_albertini_eighth_image_data =
+    "fffffffffffffffffffffffffeffffff00ff0000fefefe0000ffffffff00ff00ff00ff00"
+    "ffffffffffff00ff0000ffff000000ffff01ff00ff00ffffff00ff00fffffe00ffff00ff"
+    "ffffff0000ffffffffffffffffffffffffffff";
+
+const char *ycbcr420_half_image_data =
+    "009252009252009252009252006e2e006e2e006e2e00702500d77700d96f00d96f00d96f"
+    "009329009329009329009252009252009252009252006e2e006e2e006e2e00702500d777"
+    "00d96f00d96f00d96f009329009329009329009252009252009252009252006e2e006e2e"
+    "006e2e00702500d77700d96f00d96f00d96f009329009329009329009252009252009252"
+    "009252006e2e006e2e006e2e00702500d77700d96f00d96f00d96f009329009329009329"
+    "5fffff5fffff5fffff5fffff48fff448fff448fff446ffeb4effe64dffde4dffde4dffde"
+    "1effaf1effaf1effaf5fffff5fffff5fffff5fffff48fff448fff448fff446ffeb4effe6"
+    "4dffde4dffde4dffde1effaf1effaf1effaf5fffff5fffff5fffff5fffff48fff448fff4"
+    "48fff446ffeb4effe64dffde4dffde4dffde1effaf1effaf1effaf5fffe65dffe65fffe6"
+    "5dffe648ffcf46ffcf48ffcf45ffd44dffec4afff14afff14afff11bffc21bffc21bffc2"
+    "00cf0a00d00a00cf0a00d00a009400009500009400008f0051fffe4effff4effff4effff"
+    "005d37005d37005d3700d70000d70000d70000d700009c00009c00009c000094004effff"
+    "4bffff4bffff4bffff005b4a005b4a005b4a00d70000d70000d70000d700009c00009c00"
+    "009c000094004effff4bffff4bffff4bffff005b4a005b4a005b4a00d70000d70000d700"
+    "00d700009c00009c00009c000094004effff4bffff4bffff4bffff005b4a005b4a005b4a"
+    "26ff4026ff4026ff4026ff403cff563cff563cff5639ff8600560d004e3d004e3d004e3d"
+    "36ffff36ffff36ffff26ff4026ff4026ff4026ff403cff563cff563cff5639ff8600560d"
+    "004e3d004e3d004e3d36ffff36ffff36ffff";
+
+const char *progressive_quarter_image_data =
+    "794e485e3217996a22a55e40961a7ca508ad70006d6d0044ffd597eff162644a31492600"
+    "9e6727b057479b167fa807ad6d006b6d004af9dd9edef567414a09554106ffd9a8ffc2cd"
+    "f156cbfd53fc760077540044a7b06f87ca3c5941006b3800ffc399ffa1b5ff4ecaff5aff"
+    "6f007054004bc29b94b0ac6f6e0000670000b82400b70b19ee23a0e122c7ffa9ffff9cff"
+    "fc50beff4bb38300008a0000a70000a90000f6209ce521c3ffb3ffff9effff36deff25e2";
+
+// The progressive image encoded as baseline with a restart interval of four
+// MCUs.
+const char *restart_data =
+    "ffd8ffdb004300100b0a101828333d0c0c0e131a3a3c370e0d1018283945380e11161d33"
+    "57503e12162538446d674d182337405168715c31404e5767797865485c5f6270646763ff"
+    "c00011080018002803012200021100031100ffc40022000000000f000000000000000000"
+    "000000000102030405060708090a0b0c0d0effc401121000000000000000ff0000000000"
+    "0000000102030405060708090a1112131415161718191a2122232425262728292a313233"
+    "3435363738393a4142434445464748494a5152535455565758595a616263646566676869"
+    "6a7172737475767778797a8182838485868788898a9192939495969798999aa1a2a3a4a5"
+    "a6a7a8a9aab1b2b3b4b5b6b7b8b9bac1c2c3c4c5c6c7c8c9cad1d2d3d4d5d6d7d8d9dae1"
+    "e2e3e4e5e6e7e8e9eaf1f2f3f4f5f6f7f8f9fa00102030405060708090a0b0c0d0e0f00b"
+    "0c0d0e0f1b1c1d1e1f2b2c2d2e2f3b3c3d3e3f4b4c4d4e4f5b5c5d5e5f6b6c6d6e6f7b7c"
+    "7d7e7f8b8c8d8e8f9b9c9d9e9fabacadaeafbbbcbdbebfcbcccdcecfdbdcdddedfebeced"
+    "eeeffbfcfdfeffdd00040004ffda000c03010002000300003f005081f0150360b8061540"
+    "5298050b8a2000a0a4a0dd000042800a05b5029c5e02a660ac140b455014006514804500"
+    "00a9e02a15a07a01b27b004000380c0300c3e85a001e0502a3c0a0f478281e856815c280"
+    "2a05409012294a0011f82a000019428001e850022a0040250002da9c0601b005c022a2da"
+    "030540001140040200148a40050008507b40ed28146002a8190001414854ca001e940521"
+    "4148a0020205028010a8056d7862b0ae3c0a0a0a50b8023c000040029148047865288068"
+    "1ded035b40b51f05900c1780c3e8fa0285c010a0a0f03c008a02a011405281f2a300a14a"
+    "1685c000180500000a229140a00015000f02828a073b40f1a81dcd03120442d024054061"
+    "660300a168002d00051e2011480052010a0000214000020d6582a19c57028010b0a50140"
+    "61e8a4020100194020014944503ca0300286b8aa280102f0140229008040264280f42815"
+    "0a00050000000232b60db02c28508f402a0148505215140002815000505340f2a818aa00"
+    "a06ca83fffd046a06dc0b8ac2d006028000a00e0305a3c01428781e85000000085450140"
+    "a004794066814340b10ce0502a020b31f42d000042a8c0005028013c8f028000a5034209"
+    "601c051485c030f83e85c170f002511400028152880828282da4d030340b1a04ca02c7d1"
+    "5c0a0aaa300c03004503c0005400000000450140a00402290000402005aad48200e0205a"
+    "04c00140a850050a80c01288502a005085400500a0040141ffd9";
+
+// The progressive image with a restart interval of four MCUs.
+const char *progressive_restart_data =
+    "ffd8ffdb004300100b0a101828333d0c0c0e131a3a3c370e0d1018283945380e11161d33"
+    "57503e12162538446d674d182337405168715c31404e5767797865485c5f6270646763ff"
+    "c20011080018002803012200021100031100ffc40022000000000f000000000000000000"
+    "000000000102030405060708090a0b0c0d0effc401121000000000000000ff0000000000"
+    "0000000102030405060708090a1112131415161718191a2122232425262728292a313233"
+    "3435363738393a4142434445464748494a5152535455565758595a616263646566676869"
+    "6a7172737475767778797a8182838485868788898a9192939495969798999aa1a2a3a4a5"
+    "a6a7a8a9aab1b2b3b4b5b6b7b8b9bac1c2c3c4c5c6c7c8c9cad1d2d3d4d5d6d7d8d9dae1"
+    "e2e3e4e5e6e7e8e9eaf1f2f3f4f5f6f7f8f9fa00102030405060708090a0b0c0d0e0f00b"
+    "0c0d0e0f1b1c1d1e1f2b2c2d2e2f3b3c3d3e3f4b4c4d4e4f5b5c5d5e5f6b6c6d6e6f7b7c"
+    "7d7e7f8b8c8d8e8f9b9c9d9e9fabacadaeafbbbcbdbebfcbcccdcecfdbdcdddedfebeced"
+    "eeeffbfcfdfeffdd00040004ffda000c03010002000300000001404b436a118fb3282d13"
+    "3cb74a6c98e68d9c522ac84b695480b9ffd034bc21012160250241e292ff00ffda000801"
+    "010001050201c0202d11ffd0a015a802ea17ffd1a10ab401700683ffd2a000d0bfffda00"
+    "08010300013f01020190071e2d003403c1540215008f078000ad00fe2901850500000685"
+    "ffd003b00800a2011e0f02a15af46578507e008002802a305341ffda0008010200013f01"
+    "1f80601405282d6bcf15e14a0010280280c0115402000a0a2bebe3141fffd00bc06140aa"
+    "3c0a500f052030a1420100d07fffda0008010100063f02a18042b41fffd01ed11fffd1a2"
+    "3fffd2a00a85685fffda0008010100013f210ac008a0005100056875e57b22bc29ffd078"
+    "028150a8028168148f05000a04685201008047814a0148a60815a0ffd1a1000781e05401"
+    "42ff00ffd2a014c521e802142850bfffda000c030100020003000000100b1f04ffd08ccf"
+    "ffda0008010300013f100ad78c0000450010080052290014002141ed04174014141e0780"
+    "11405402280a500547b943029008040065008005251140f285ffd014a781001288a00014"
+    "0a9445128500a0c0a0542815004510a05400a10a800a0140080283ffda0008010200013f"
+    "1014283c01288000032850003d0a00453009400142140c014051e2011480052010a00002"
+    "140000284fffd014c7880085518000a05002791e0500014a096a0140f000150000000011"
+    "40502801008a40001008016bffda0008010100013f1078b00000a0a4a0dd000042800a18"
+    "00c80505215328007a501485052280085214008540340fffd0461e0000000a229140a000"
+    "15000f02828a01e9410f01945201140002a780a856811b000a100f028151e0507a3c140f"
+    "42b408c428283283c0000400291480478652880683ffd1a11900570a4020100990a03d0a"
+    "05428001400000008c8f2508f402a0148505215140002815000505341fffd2a028402850"
+    "8141e07a140000002151405028011e50bfffd9";
@@ -1,11 +1,208 @@
+#include <math.h>
+#include <stdlib.h>
+
 #include "ut-jpeg-decoder-test-data.h"
+#include "ut-jpeg.h"
 #include "ut.h"
 
-static void check_jpeg(const char *hex_data, size_t width, size_t height,
-                       size_t n_components, const char *hex_image_data) {
+// Random number generator from IEEE 1180-1990.
+static uint32_t random_state = 1;
+
+// Returns a random value in the range [-low, high].
+static int32_t random_value(int32_t low, int32_t high) {
+  random_state = random_state * 1103515245 + 12345;
+  uint32_t i = random_state & 0x7ffffffe;
+  double x = (double)i / 0x7fffffff * (low + high + 1);
+  return (int32_t)x - low;
+}
+
+static int16_t clamp(int16_t value, int16_t min, int16_t max) {
+  return value < min ? min : (value > max ? max : value);
+}
+
+// Check the fixed point inverse DCT against the floating point reference,
+// using the accuracy requirements from IEEE 1180-1990.
+static void check_inverse_dct_accuracy(int32_t low, int32_t high,
+                                       int16_t sign) {
+  float dct_alpha[8], dct_cos[64];
+  jpeg_build_dct_values(dct_alpha, dct_cos);
+
+  const size_t n_blocks = 10000;
+  int64_t total_error[64] = {0};
+  int64_t total_squared_error[64] = {0};
+  random_state = 1;
+  for (size_t i = 0; i < n_blocks; i++) {
+    int16_t data_unit[64];
+    for (size_t j = 0; j < 64; j++) {
+      data_unit[j] = random_value(low, high) * sign;
+    }
+    float encoded_data_unit[64];
+    jpeg_dct(dct_alpha, dct_cos, data_unit, encoded_data_unit);
+    int16_t coefficients[64];
+    for (size_t j = 0; j < 64; j++) {
+      coefficients[j] = clamp(round(encoded_data_unit[j]), -2048, 2047);
+    }
+
+    int16_t reference[64], result[64];
+    jpeg_inverse_dct(dct_alpha, dct_cos, coefficients, reference);
+    jpeg_integer_inverse_dct(coefficients, result);
+    for (size_t j = 0; j < 64; j++) {
+      int32_t error =
+          clamp(result[j], -256, 255) - clamp(reference[j], -256, 255);
+      ut_assert_true(abs(error) <= 1);
+      total_error[j] += error;
+      total_squared_error[j] += error * error;
+    }
+  }
+
+  int64_t overall_error = 0, overall_squared_error = 0;
+  for (size_t j = 0; j < 64; j++) {
+    ut_assert_true(llabs(total_error[j]) <= n_blocks * 0.015);
+    ut_assert_true(total_squared_error[j] <= n_blocks * 0.06);
+    overall_error += total_error[j];
+    overall_squared_error += total_squared_error[j];
+  }
+  ut_assert_true(llabs(overall_error) <= n_blocks * 64 * 0.0015);
+  ut_assert_true(overall_squared_error <= n_blocks * 64 * 0.02);
+}
+
+// Check the fixed point DCT matches the floating point reference.
+static void check_dct_accuracy() {
+  float dct_alpha[8], dct_cos[64];
+  jpeg_build_dct_values(dct_alpha, dct_cos);
+
+  random_state = 1;
+  for (size_t i = 0; i < 10000; i++) {
+    int16_t data_unit[64];
+    for (size_t j = 0; j < 64; j++) {
+      data_unit[j] = random_value(128, 127);
+    }
+    float reference[64];
+    jpeg_dct(dct_alpha, dct_cos, data_unit, reference);
+    int16_t result[64];
+    jpeg_integer_dct(data_unit, result);
+    for (size_t j = 0; j < 64; j++) {
+      ut_assert_true(fabs(result[j] / 8.0 - reference[j]) <= 1.0);
+    }
+  }
+}
+
+// Returns [low] or [high] at random.
+static int32_t random_extreme(int32_t low, int32_t high) {
+  return random_value(0, 1) == 0 ? low : high;
+}
+
+// Check the optimized transforms give the same results as the scalar ones,
+// on random blocks and blocks of the extreme values.
+static void check_dct_implementations() {
+  const JpegDctFunctions *implementations;
+  size_t n_implementations = jpeg_get_dct_functions(&implementations);
+
+  random_state = 1;
+  for (size_t i = 0; i < 10000; i++) {
+    // Level shifted samples and dequantized coefficients.
+    int16_t data_unit[64], coefficients[64];
+    for (size_t j = 0; j < 64; j++) {
+      switch (i % 4) {
+      case 0:
+        data_unit[j] = random_value(128, 127);
+        coefficients[j] = random_value(1024, 1023);
+        break;
+      case 1:
+        data_unit[j] = random_extreme(-128, 127);
+        coefficients[j] = random_extreme(-1024, 1023);
+        break;
+      case 2:
+        data_unit[j] = -128;
+        coefficients[j] = -1024;
+        break;
+      case 3:
+        data_unit[j] = 127;
+        coefficients[j] = 1023;
+        break;
+      }
+    }
+
+    int16_t expected_coefficients[64], expected_data_unit[64];
+    implementations[0].dct(data_unit, expected_coefficients);
+    implementations[0].inverse_dct(coefficients, expected_data_unit);
+    for (size_t j = 1; j < n_implementations; j++) {
+      int16_t result_coefficients[64], result_data_unit[64];
+      implementations[j].dct(data_unit, result_coefficients);
+      implementations[j].inverse_dct(coefficients, result_data_unit);
+      for (size_t k = 0; k < 64; k++) {
+        ut_assert_int_equal(result_coefficients[k], expected_coefficients[k]);
+        ut_assert_int_equal(result_data_unit[k], expected_data_unit[k]);
+      }
+    }
+  }
+}
+
+// Check the optimized color conversions give the same results as the scalar
+// one, on random rows and rows of the extreme values.
+static void check_color_implementations() {
+  const JpegColorFunctions *implementations;
+  size_t n_implementations = jpeg_get_color_functions(&implementations);
+
+  random_state = 1;
+  for (size_t width = 1; width <= 100; width++) {
+    for (size_t i = 0; i < 4; i++) {
+      uint8_t y[100], cb[100], cr[100];
+      for (size_t x = 0; x < width; x++) {
+        switch (i) {
+        case 0:
+          y[x] = random_value(0, 255);
+          cb[x] = random_value(0, 255);
+          cr[x] = random_value(0, 255);
+          break;
+        case 1:
+          y[x] = random_extreme(0, 255);
+          cb[x] = random_extreme(0, 255);
+          cr[x] = random_extreme(0, 255);
+          break;
+        case 2:
+          y[x] = cb[x] = cr[x] = 0;
+          break;
+        case 3:
+          y[x] = cb[x] = cr[x] = 255;
+          break;
+        }
+      }
+
+      uint8_t expected_rgb[300];
+      implementations[0].ycbcr_to_rgb(y, cb, cr, expected_rgb, width);
+      for (size_t j = 1; j < n_implementations; j++) {
+        uint8_t rgb[300];
+        implementations[j].ycbcr_to_rgb(y, cb, cr, rgb, width);
+        ut_assert_uint8_array_equal(rgb, width * 3, expected_rgb, width * 3);
+      }
+    }
+  }
+}
+
+static void check_jpeg(const char *hex_data, bool fancy_upsampling,
+                       size_t width, size_t height, size_t n_components,
+                       const char *hex_image_data) {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(hex_data);
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_jpeg_decoder_new(data_stream);
+  ut_jpeg_decoder_set_fancy_upsampling(decoder, fancy_upsampling);
+  UtObjectRef image = ut_jpeg_decoder_decode_sync(decoder);
+  ut_assert_is_not_error(image);
+  ut_assert_int_equal(ut_jpeg_image_get_width(image), width);
+  ut_assert_int_equal(ut_jpeg_image_get_height(image), height);
+  ut_assert_int_equal(ut_jpeg_image_get_n_components(image), n_components);
+  ut_assert_uint8_list_equal_hex(ut_jpeg_image_get_data(image), hex_image_data);
+}
+
+// Check decoding [hex_data] scaled down by [scale] gives [hex_image_data].
+static void check_scaled_jpeg(const char *hex_data, size_t scale,
+                              size_t width, size_t height, size_t n_components,
+                              const char *hex_image_data) {
   UtObjectRef data = ut_uint8_list_new_from_hex_string(hex_data);
   UtObjectRef data_stream = ut_list_input_stream_new(data);
   UtObjectRef decoder = ut_jpeg_decoder_new(data_stream);
+  ut_jpeg_decoder_set_scale(decoder, scale);
   UtObjectRef image = ut_jpeg_decoder_decode_sync(decoder);
   ut_assert_is_not_error(image);
   ut_assert_int_equal(ut_jpeg_image_get_width(image), width);
@@ -14,8 +211,121 @@ static void check_jpeg(const char *hex_data, size_t width, size_t height,
   ut_assert_uint8_list_equal_hex(ut_jpeg_image_get_data(image), hex_image_data);
 }
 
+static size_t n_previews = 0;
+
+static void preview_cb(UtObject *object) {
+  UtObject *decoder = object;
+  UtObject *image = ut_jpeg_decoder_get_image(decoder);
+  ut_assert_int_equal(ut_jpeg_image_get_width(image), 40);
+  ut_assert_int_equal(ut_jpeg_image_get_height(image), 24);
+  n_previews++;
+}
+
+// Check previews are generated while decoding a progressive image.
+static void check_progressive_preview() {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(progressive_data);
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_jpeg_decoder_new(data_stream);
+  ut_jpeg_decoder_set_preview_callback(decoder, decoder, preview_cb);
+  UtObjectRef image = ut_jpeg_decoder_decode_sync(decoder);
+  ut_assert_is_not_error(image);
+  ut_assert_uint8_list_equal_hex(ut_jpeg_image_get_data(image),
+                                 progressive_image_data);
+
+  // Image has ten scans, the first containing the DC coefficients for all
+  // components.
+  ut_assert_int_equal(n_previews, 10);
+}
+
+// Check decoding [hex_data] using [n_threads] gives [hex_image_data].
+static void check_threaded_jpeg(const char *hex_data, size_t n_threads,
+                                size_t width, size_t height,
+                                size_t n_components,
+                                const char *hex_image_data) {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(hex_data);
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_jpeg_decoder_new(data_stream);
+  ut_jpeg_decoder_set_n_threads(decoder, n_threads);
+  UtObjectRef image = ut_jpeg_decoder_decode_sync(decoder);
+  ut_assert_is_not_error(image);
+  ut_assert_int_equal(ut_jpeg_image_get_width(image), width);
+  ut_assert_int_equal(ut_jpeg_image_get_height(image), height);
+  ut_assert_int_equal(ut_jpeg_image_get_n_components(image), n_components);
+  ut_assert_uint8_list_equal_hex(ut_jpeg_image_get_data(image), hex_image_data);
+}
+
+// Check a progressive DC scan that claims to contain AC coefficients is
+// rejected.
+static void check_invalid_dc_scan() {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(progressive_data);
+  uint8_t *d = ut_uint8_list_get_writable_data(data);
+  size_t data_length = ut_list_get_length(data);
+  size_t sos_offset = 0;
+  for (size_t i = 0; i + 1 < data_length; i++) {
+    if (d[i] == 0xff && d[i + 1] == 0xda) {
+      sos_offset = i;
+      break;
+    }
+  }
+  ut_assert_true(sos_offset > 0);
+
+  // Set the end of the spectral selection, which follows the components.
+  size_t n_components = d[sos_offset + 4];
+  size_t selection_offset = sos_offset + 5 + n_components * 2;
+  ut_assert_int_equal(d[selection_offset], 0);
+  ut_assert_int_equal(d[selection_offset + 1], 0);
+  d[selection_offset + 1] = 5;
+
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_jpeg_decoder_new(data_stream);
+  UtObjectRef image = ut_jpeg_decoder_decode_sync(decoder);
+  ut_assert_is_error(image);
+}
+
 int main(int argc, char **argv) {
-  check_jpeg(ange_albertini_data, 104, 56, 1, ange_albertini_image_data);
+  check_inverse_dct_accuracy(256, 255, 1);
+  check_inverse_dct_accuracy(256, 255, -1);
+  check_inverse_dct_accuracy(5, 5, 1);
+  check_inverse_dct_accuracy(5, 5, -1);
+  check_inverse_dct_accuracy(300, 300, 1);
+  check_inverse_dct_accuracy(300, 300, -1);
+  check_dct_accuracy();
+  check_dct_implementations();
+  check_color_implementations();
+
+  // All zero coefficients must give all zero output.
+  int16_t zero_coefficients[64] = {0}, zero_data_unit[64];
+  jpeg_integer_inverse_dct(zero_coefficients, zero_data_unit);
+  for (size_t i = 0; i < 64; i++) {
+    ut_assert_int_equal(zero_data_unit[i], 0);
+  }
+
+  check_jpeg(ange_albertini_data, true, 104, 56, 1, ange_albertini_image_data);
+
+  check_jpeg(ycbcr420_data, true, 30, 27, 3, ycbcr420_image_data);
+  check_jpeg(ycbcr420_data, false, 30, 27, 3, ycbcr420_nearest_image_data);
+  check_jpeg(ycbcr422_data, true, 30, 11, 3, ycbcr422_image_data);
+  check_jpeg(ycbcr422_data, false, 30, 11, 3, ycbcr422_nearest_image_data);
+
+  check_jpeg(progressive_data, true, 40, 24, 3, progressive_image_data);
+  check_progressive_preview();
+  check_invalid_dc_scan();
+
+  check_scaled_jpeg(ange_albertini_data, 2, 52, 28, 1,
+                    ange_albertini_half_image_data);
+  check_scaled_jpeg(ange_albertini_data, 8, 13, 7, 1,
+                    ange_albertini_eighth_image_data);
+  check_scaled_jpeg(ycbcr420_data, 2, 15, 14, 3, ycbcr420_half_image_data);
+  check_scaled_jpeg(progressive_data, 4, 10, 6, 3,
+                    progressive_quarter_image_data);
+
+  check_jpeg(restart_data, true, 40, 24, 3, progressive_image_data);
+  check_jpeg(progressive_restart_data, true, 40, 24, 3,
+             progressive_image_data);
+  check_threaded_jpeg(restart_data, 4, 40, 24, 3, progressive_image_data);
+  check_threaded_jpeg(restart_data, 16, 40, 24, 3, progressive_image_data);
+  check_threaded_jpeg(progressive_restart_data, 4, 40, 24, 3,
+                      progressive_image_data);
 
   return 0;
 }
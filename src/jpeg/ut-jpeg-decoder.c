@@ -1,14 +1,16 @@
 #include <assert.h>
-#include <math.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "ut-jpeg.h"
+#include "ut-parallel-private.h"
 #include "ut.h"
 
 // https://www.w3.org/Graphics/JPEG/itu-t81.pdf
 // https://www.w3.org/Graphics/JPEG/jfif3.pdf
 
-// Supports baseline process
+// Supports baseline and progressive processes
 
 typedef enum {
   DECODER_STATE_MARKER,
@@ -66,8 +68,27 @@ typedef struct {
   // Number of data units decoded in the current MCU.
   size_t data_unit_count;
 
-  // Encoded image coefficients.
+  // Encoded image coefficients. For progressive images this contains the
+  // quantized coefficients for every data unit.
   UtObject *coefficients;
+
+  // True if DC coefficients have been received in a progressive image.
+  bool have_dc;
+
+  // Decoded samples, padded to a whole number of MCUs.
+  UtObject *samples;
+  size_t samples_width;
+
+  // Number of samples that contain image data.
+  size_t width;
+  size_t height;
+
+  // Width of the component in data units, padded to a whole number of MCUs.
+  size_t width_in_data_units;
+
+  // Number of data units that contain image data.
+  size_t image_width_in_data_units;
+  size_t image_height_in_data_units;
 } JpegComponent;
 
 typedef struct {
@@ -80,6 +101,10 @@ typedef struct {
   UtObject *callback_object;
   UtJpegDecodeCallback callback;
 
+  // Callback to notify when a progressive preview is available.
+  UtObject *preview_callback_object;
+  UtJpegDecodeCallback preview_callback;
+
   // Current bits being written.
   uint8_t bit_buffer;
   uint8_t bit_count;
@@ -114,6 +139,24 @@ typedef struct {
   // Height of an MCU in data units.
   size_t mcu_height;
 
+  // Size of the image in MCUs.
+  size_t width_in_mcus;
+  size_t height_in_mcus;
+
+  // Factor to scale the image down by when decoding.
+  size_t scale;
+
+  // Width and height of each decoded data unit in samples.
+  size_t data_unit_size;
+
+  // True if subsampled components are upsampled using a triangle filter,
+  // otherwise samples are replicated.
+  bool fancy_upsampling;
+
+  // Buffers used when upsampling a row of each component.
+  UtObject *upsample_buffer;
+  UtObject *upsample_workspace;
+
   // Huffman decoders for DC coefficients.
   UtObject *dc_decoders[4];
 
@@ -129,10 +172,6 @@ typedef struct {
   // Order that data unit values are written.
   uint8_t data_unit_order[64];
 
-  // Precalculated cosines for DCT.
-  float dct_alpha[8];
-  float dct_cos[64];
-
   // Last read Huffman code.
   uint16_t code;
   uint8_t code_width;
@@ -145,6 +184,7 @@ typedef struct {
 
   // Components in the current scan.
   JpegComponent *scan_components[4];
+  size_t n_scan_components;
 
   // Current component scan is processing.
   size_t scan_component_index;
@@ -158,9 +198,32 @@ typedef struct {
   // Index of current coefficient in current data unit.
   size_t data_unit_coefficient_index;
 
+  // Number of MCUs in each restart interval, or 0 if restarts are not used.
+  uint16_t restart_interval;
+
+  // Number of restart markers received in the current scan.
+  size_t restart_count;
+
+  // Number of threads to decode restart intervals with.
+  size_t n_threads;
+
+  // Successive approximation bit positions in current scan.
+  uint8_t successive_approximation_high;
+  uint8_t successive_approximation_low;
+
+  // Number of data units remaining with no more coefficients in the current
+  // progressive scan.
+  size_t end_of_band_run;
+
+  // Amount of progressive scan data checked for the end of the scan.
+  size_t scan_length;
+
   // Number of MCUs processed.
   size_t mcu_count;
 
+  // Number of image rows that have been written.
+  size_t output_row;
+
   // Density information;
   UtJpegDensityUnits density_units;
   uint16_t horizontal_pixel_density;
@@ -310,97 +373,219 @@ static bool read_int(UtJpegDecoder *self, UtObject *data, size_t *offset,
   return true;
 }
 
-static uint8_t clamp(float value) {
-  if (value < 0.0) {
-    return 0;
-  } else if (value > 255.0) {
-    return 255;
-  } else {
-    return floor(value);
+// Upsample [workspace] containing [length] values by a factor of two
+// horizontally into [output], using a triangle filter. The result is descaled
+// by [shift] bits using [even_bias] and [odd_bias] for rounding.
+static void upsample_horizontal(const uint16_t *workspace, size_t length,
+                                uint8_t *output, uint16_t even_bias,
+                                uint16_t odd_bias, int shift) {
+  for (size_t i = 0; i < length; i++) {
+    uint16_t value = workspace[i] * 3;
+    uint16_t previous = workspace[i > 0 ? i - 1 : 0];
+    uint16_t next = workspace[i + 1 < length ? i + 1 : length - 1];
+    output[i * 2] = (value + previous + even_bias) >> shift;
+    output[i * 2 + 1] = (value + next + odd_bias) >> shift;
   }
 }
 
-static void ycbcr_to_rgb(uint8_t *pixel) {
-  float Y = pixel[0];
-  float Cb = pixel[1] - 128.0;
-  float Cr = pixel[2] - 128.0;
+// Get row [y] of the image from [component], upsampling into [output] if
+// required using [workspace].
+static const uint8_t *upsample_row(UtJpegDecoder *self,
+                                   JpegComponent *component, size_t y,
+                                   uint8_t *output, uint16_t *workspace) {
+  uint16_t image_width = ut_jpeg_image_get_width(self->image);
+  const uint8_t *samples = ut_uint8_list_get_data(component->samples);
+  size_t horizontal_ratio =
+      self->mcu_width / component->horizontal_sampling_factor;
+  size_t vertical_ratio =
+      self->mcu_height / component->vertical_sampling_factor;
+
+  size_t sample_y = y / vertical_ratio;
+  const uint8_t *row = samples + sample_y * component->samples_width;
+  if (horizontal_ratio == 1 && vertical_ratio == 1) {
+    return row;
+  }
+
+  // Use the triangle filter from the IJG library for 2:1 subsampling, and
+  // replicate samples for other ratios.
+  if (!self->fancy_upsampling || horizontal_ratio > 2 || vertical_ratio > 2) {
+    if (horizontal_ratio == 1) {
+      return row;
+    }
+    for (size_t x = 0; x < image_width; x++) {
+      output[x] = row[x / horizontal_ratio];
+    }
+    return output;
+  }
+
+  if (vertical_ratio == 2) {
+    // Blend with the nearest row above or below, weighted 3:1.
+    bool upper = y % 2 == 0;
+    size_t far_y;
+    if (upper) {
+      far_y = sample_y > 0 ? sample_y - 1 : 0;
+    } else {
+      far_y = sample_y + 1 < component->height ? sample_y + 1 : sample_y;
+    }
+    const uint8_t *far_row = samples + far_y * component->samples_width;
+    for (size_t x = 0; x < component->width; x++) {
+      workspace[x] = row[x] * 3 + far_row[x];
+    }
+
+    if (horizontal_ratio == 2) {
+      upsample_horizontal(workspace, component->width, output, 8, 7, 4);
+    } else {
+      uint16_t bias = upper ? 1 : 2;
+      for (size_t x = 0; x < component->width; x++) {
+        output[x] = (workspace[x] + bias) >> 2;
+      }
+    }
+  } else {
+    for (size_t x = 0; x < component->width; x++) {
+      workspace[x] = row[x];
+    }
+    upsample_horizontal(workspace, component->width, output, 1, 2, 2);
+  }
 
-  pixel[0] = clamp(Y + 1.402 * Cr);
-  pixel[1] = clamp(Y - 0.344136 * Cb - 0.714136 * Cr);
-  pixel[2] = clamp(Y + 1.772 * Cb);
+  return output;
 }
 
-// Process a received data unit.
-static void process_data_unit(UtJpegDecoder *self) {
+// Width of the buffers used to upsample a row of each component.
+static size_t get_upsample_buffer_width(UtJpegDecoder *self) {
+  return self->width_in_mcus * self->mcu_width * self->data_unit_size;
+}
+
+// Write image row [y] from the decoded component samples, upsampling and
+// converting from YCbCr to RGB. [buffer] and [workspace] are used for
+// upsampling.
+static void write_row(UtJpegDecoder *self, size_t y, uint8_t *buffer,
+                      uint16_t *workspace) {
   uint16_t image_width = ut_jpeg_image_get_width(self->image);
-  uint16_t image_height = ut_jpeg_image_get_height(self->image);
   size_t n_components = ut_jpeg_image_get_n_components(self->image);
-  size_t row_stride = image_width * n_components;
   uint8_t *image_data =
       ut_uint8_list_get_writable_data(ut_jpeg_image_get_data(self->image));
+  size_t buffer_width = get_upsample_buffer_width(self);
 
-  // Get position of current MCU in image.
-  size_t width_in_mcus =
-      (image_width + (self->mcu_width * 8) - 1) / (self->mcu_width * 8);
-  size_t mcu_x = (self->mcu_count % width_in_mcus) * self->mcu_width * 8;
-  size_t mcu_y = (self->mcu_count / width_in_mcus) * self->mcu_height * 8;
-
-  // Get position of current data unit in image.
-  JpegComponent *component = self->scan_components[self->scan_component_index];
-  size_t data_unit_x =
-      mcu_x +
-      (component->data_unit_count % component->horizontal_sampling_factor) * 8;
-  size_t data_unit_y =
-      mcu_y +
-      (component->data_unit_count / component->horizontal_sampling_factor) * 8;
+  const uint8_t *rows[4];
+  for (size_t i = 0; i < n_components; i++) {
+    rows[i] = upsample_row(self, &self->components[i], y,
+                           buffer + i * buffer_width, workspace);
+  }
 
-  // Do inverse DCT on data unit.
-  int16_t *encoded_data_unit =
-      ut_int16_list_get_writable_data(component->coefficients);
-  int16_t decoded_data_unit[64];
-  jpeg_inverse_dct(self->dct_alpha, self->dct_cos, encoded_data_unit,
-                   decoded_data_unit);
+  uint8_t *image_row = image_data + y * image_width * n_components;
+  if (n_components == 1) {
+    memcpy(image_row, rows[0], image_width);
+  } else if (n_components == 3) {
+    jpeg_ycbcr_to_rgb(rows[0], rows[1], rows[2], image_row, image_width);
+  } else {
+    for (size_t x = 0; x < image_width; x++) {
+      for (size_t i = 0; i < n_components; i++) {
+        image_row[x * n_components + i] = rows[i][x];
+      }
+    }
+  }
+}
 
-  // Check if this is the final component being written.
-  bool last_component = self->scan_component_index == n_components - 1;
+// Write image rows up to [end] from the decoded component samples.
+static void write_rows(UtJpegDecoder *self, size_t end) {
+  uint8_t *buffer = ut_uint8_list_get_writable_data(self->upsample_buffer);
+  uint16_t *workspace =
+      ut_uint16_list_get_writable_data(self->upsample_workspace);
+  for (; self->output_row < end; self->output_row++) {
+    write_row(self, self->output_row, buffer, workspace);
+  }
+}
 
-  // Write values into image.
-  size_t sample_width = self->mcu_width / component->horizontal_sampling_factor;
-  size_t sample_height = self->mcu_height / component->vertical_sampling_factor;
-  for (size_t y = 0; y < 8; y++) {
-    size_t sy = data_unit_y + y * sample_height;
-    for (size_t x = 0; x < 8; x++) {
-      size_t sx = data_unit_x + x * sample_width;
+// Do the inverse DCT on [encoded_data_unit] and write the samples into
+// [component] at data unit position [data_unit_x], [data_unit_y]. Scaled
+// images use a reduced size inverse DCT.
+static void write_data_unit(UtJpegDecoder *self, JpegComponent *component,
+                            size_t data_unit_x, size_t data_unit_y,
+                            const int16_t *encoded_data_unit) {
+  size_t size = self->data_unit_size;
+  int16_t decoded_data_unit[64];
+  switch (size) {
+  case 8:
+    jpeg_integer_inverse_dct(encoded_data_unit, decoded_data_unit);
+    break;
+  case 4:
+    jpeg_integer_inverse_dct_4x4(encoded_data_unit, decoded_data_unit);
+    break;
+  case 2:
+    jpeg_integer_inverse_dct_2x2(encoded_data_unit, decoded_data_unit);
+    break;
+  default:
+    jpeg_integer_inverse_dct_1x1(encoded_data_unit, decoded_data_unit);
+    break;
+  }
 
-      int16_t sample = decoded_data_unit[(y * 8) + x] + 128;
+  uint8_t *samples = ut_uint8_list_get_writable_data(component->samples);
+  for (size_t y = 0; y < size; y++) {
+    uint8_t *row = samples +
+                   ((data_unit_y * size) + y) * component->samples_width +
+                   (data_unit_x * size);
+    for (size_t x = 0; x < size; x++) {
+      int16_t sample = decoded_data_unit[(y * size) + x] + 128;
       if (sample < 0) {
         sample = 0;
       } else if (sample > 255) {
         sample = 255;
       }
+      row[x] = sample;
+    }
+  }
+}
 
-      for (size_t v = 0; v < sample_height; v++) {
-        size_t py = sy + v;
-        if (py >= image_height) {
-          break;
-        }
-        for (size_t u = 0; u < sample_width; u++) {
-          size_t px = sx + u;
-          if (px >= image_width) {
-            break;
-          }
+// Write the image from the accumulated coefficients of a progressive image.
+static void write_progressive_image(UtJpegDecoder *self) {
+  uint16_t image_height = ut_jpeg_image_get_height(self->image);
+  size_t n_components = ut_jpeg_image_get_n_components(self->image);
 
-          size_t pixel_index = (py * row_stride) + (px * n_components);
-          image_data[pixel_index + component->index] = sample;
-          // Last channel placed - do color conversion.
-          if (last_component && n_components == 3) {
-            ycbcr_to_rgb(image_data + pixel_index);
-          }
+  for (size_t i = 0; i < n_components; i++) {
+    JpegComponent *component = &self->components[i];
+    const uint8_t *quantization_table_data =
+        ut_uint8_list_get_data(component->quantization_table);
+    const int16_t *coefficients =
+        ut_int16_list_get_data(component->coefficients);
+    size_t width_in_data_units = component->width_in_data_units;
+    size_t height_in_data_units =
+        self->height_in_mcus * component->vertical_sampling_factor;
+    for (size_t y = 0; y < height_in_data_units; y++) {
+      for (size_t x = 0; x < width_in_data_units; x++) {
+        const int16_t *data_unit =
+            coefficients + ((y * width_in_data_units) + x) * 64;
+        int16_t encoded_data_unit[64];
+        for (size_t j = 0; j < 64; j++) {
+          encoded_data_unit[j] = data_unit[j] * quantization_table_data[j];
         }
+        write_data_unit(self, component, x, y, encoded_data_unit);
       }
     }
   }
 
+  self->output_row = 0;
+  write_rows(self, image_height);
+}
+
+// Process a received data unit.
+static void process_data_unit(UtJpegDecoder *self) {
+  uint16_t image_height = ut_jpeg_image_get_height(self->image);
+  size_t n_components = ut_jpeg_image_get_n_components(self->image);
+
+  // Get position of current data unit in the component samples.
+  JpegComponent *component = self->scan_components[self->scan_component_index];
+  size_t mcu_x = self->mcu_count % self->width_in_mcus;
+  size_t mcu_y = self->mcu_count / self->width_in_mcus;
+  size_t data_unit_x =
+      mcu_x * component->horizontal_sampling_factor +
+      component->data_unit_count % component->horizontal_sampling_factor;
+  size_t data_unit_y =
+      mcu_y * component->vertical_sampling_factor +
+      component->data_unit_count / component->horizontal_sampling_factor;
+
+  write_data_unit(self, component, data_unit_x, data_unit_y,
+                  ut_int16_list_get_data(component->coefficients));
+
   component->data_unit_count++;
 
   // All data units for this component in this MCU complete, move to the next
@@ -414,6 +599,16 @@ static void process_data_unit(UtJpegDecoder *self) {
     if (self->scan_component_index >= n_components) {
       self->scan_component_index = 0;
       self->mcu_count++;
+
+      // Write out the image when a row of MCUs is complete. The last row of
+      // MCUs is held back as upsampling needs the samples from the next row.
+      if (self->mcu_count == self->width_in_mcus * self->height_in_mcus) {
+        write_rows(self, image_height);
+      } else if (self->mcu_count % self->width_in_mcus == 0) {
+        size_t n_mcu_rows = self->mcu_count / self->width_in_mcus;
+        write_rows(self, (n_mcu_rows - 1) * self->mcu_height *
+                             self->data_unit_size);
+      }
     }
   }
 
@@ -455,20 +650,54 @@ static void add_coefficient(UtJpegDecoder *self, size_t run_length,
   }
 }
 
+// Returns the number of MCUs decoded when the current restart interval is
+// complete.
+static size_t get_restart_interval_end(UtJpegDecoder *self) {
+  size_t n_mcus = self->width_in_mcus * self->height_in_mcus;
+  if (self->restart_interval == 0) {
+    return n_mcus;
+  }
+  size_t end = (self->restart_count + 1) * self->restart_interval;
+  return end < n_mcus ? end : n_mcus;
+}
+
 static void handle_restart(UtJpegDecoder *self, uint8_t count) {
-  if (true) {
-    set_error(self, "JPEG restart not supported");
+  if (self->image == NULL || self->restart_interval == 0 ||
+      self->mcu_count >= self->width_in_mcus * self->height_in_mcus ||
+      self->mcu_count != get_restart_interval_end(self)) {
+    set_error(self, "Unexpected JPEG restart marker");
     return;
   }
+  if (count != self->restart_count % 8) {
+    set_error(self, "Invalid JPEG restart marker %d", count);
+    return;
+  }
+  self->restart_count++;
 
-  self->state = DECODER_STATE_MARKER;
+  // Entropy coding restarts on a byte boundary with no DC prediction.
+  self->bit_count = 0;
+  self->code = 0;
+  self->code_width = 0;
+  self->scan_decoder_state = SCAN_DECODER_STATE_COEFFICIENT_MAGNITUDE;
+  self->data_unit_coefficient_index = self->scan_coefficient_start;
+  for (size_t i = 0; i < self->n_scan_components; i++) {
+    self->scan_components[i]->previous_dc = 0;
+  }
+
+  self->state = DECODER_STATE_SCAN;
 }
 
 static void handle_start_of_image(UtJpegDecoder *self) {
   self->state = DECODER_STATE_MARKER;
 }
 
-static void handle_end_of_image(UtJpegDecoder *self) { set_done(self); }
+static void handle_end_of_image(UtJpegDecoder *self) {
+  if (self->mode == DECODE_MODE_PROGRESSIVE_DCT && self->image != NULL) {
+    write_progressive_image(self);
+  }
+
+  set_done(self);
+}
 
 static void decode_jfif(UtJpegDecoder *self, UtObject *data) {
   size_t data_length = ut_list_get_length(data);
@@ -719,10 +948,58 @@ static size_t decode_start_of_frame(UtJpegDecoder *self, UtObject *data) {
     self->components[i].vertical_sampling_factor = vertical_sampling_factor;
     self->components[i].quantization_table = quantization_table;
 
-    self->components[i].coefficients = ut_int16_array_new_sized(64);
   }
   self->mcu_width = mcu_width;
   self->mcu_height = mcu_height;
+  self->width_in_mcus = (width + (mcu_width * 8) - 1) / (mcu_width * 8);
+  self->height_in_mcus = (height + (mcu_height * 8) - 1) / (mcu_height * 8);
+
+  // Scaled images are decoded with smaller data units, so only the reduced
+  // size samples are stored.
+  size_t scale = self->scale;
+  size_t data_unit_size = 8 / scale;
+  self->data_unit_size = data_unit_size;
+  uint16_t scaled_width = (width + scale - 1) / scale;
+  uint16_t scaled_height = (height + scale - 1) / scale;
+
+  // Allocate space for decoded samples and upsampling.
+  for (size_t i = 0; i < n_components; i++) {
+    JpegComponent *component = &self->components[i];
+    size_t horizontal_sampling_factor = component->horizontal_sampling_factor;
+    size_t vertical_sampling_factor = component->vertical_sampling_factor;
+    component->width_in_data_units =
+        self->width_in_mcus * horizontal_sampling_factor;
+    size_t height_in_data_units =
+        self->height_in_mcus * vertical_sampling_factor;
+    component->image_width_in_data_units =
+        (width * horizontal_sampling_factor + mcu_width * 8 - 1) /
+        (mcu_width * 8);
+    component->image_height_in_data_units =
+        (height * vertical_sampling_factor + mcu_height * 8 - 1) /
+        (mcu_height * 8);
+    component->samples_width = component->width_in_data_units * data_unit_size;
+    size_t horizontal_divisor = mcu_width * scale;
+    size_t vertical_divisor = mcu_height * scale;
+    component->width = (width * horizontal_sampling_factor +
+                        horizontal_divisor - 1) /
+                       horizontal_divisor;
+    component->height = (height * vertical_sampling_factor +
+                         vertical_divisor - 1) /
+                        vertical_divisor;
+    size_t samples_height = height_in_data_units * data_unit_size;
+    component->samples =
+        ut_uint8_array_new_sized(component->samples_width * samples_height);
+
+    // Progressive images build up the coefficients for the whole image.
+    size_t n_data_units = 1;
+    if (self->mode == DECODE_MODE_PROGRESSIVE_DCT) {
+      n_data_units = component->width_in_data_units * height_in_data_units;
+    }
+    component->coefficients = ut_int16_array_new_sized(n_data_units * 64);
+  }
+  size_t buffer_width = self->width_in_mcus * mcu_width * data_unit_size;
+  self->upsample_buffer = ut_uint8_array_new_sized(buffer_width * n_components);
+  self->upsample_workspace = ut_uint16_array_new_sized(buffer_width);
 
   if (!supported_precision(self, precision)) {
     set_error(self, "Unsupported JPEG precision %d", precision);
@@ -739,10 +1016,11 @@ static size_t decode_start_of_frame(UtJpegDecoder *self, UtObject *data) {
   }
 
   UtObjectRef image_data =
-      ut_uint8_array_new_sized(height * width * n_components);
-  self->image = ut_jpeg_image_new(
-      width, height, self->density_units, self->horizontal_pixel_density,
-      self->vertical_pixel_density, n_components, image_data);
+      ut_uint8_array_new_sized(scaled_height * scaled_width * n_components);
+  self->image =
+      ut_jpeg_image_new(scaled_width, scaled_height, self->density_units,
+                        self->horizontal_pixel_density,
+                        self->vertical_pixel_density, n_components, image_data);
 
   self->state = DECODER_STATE_MARKER;
 
@@ -997,14 +1275,12 @@ static size_t decode_define_restart_interval(UtJpegDecoder *self,
     set_error(self, "Invalid JPEG define restart interval length %d", length);
     return 0;
   }
-
-  /*uint16_t restart_interval =*/ut_uint8_list_get_uint16_be(data, 2);
-
-  if (true) {
-    set_error(self, "JPEG restart interval not supported");
+  if (data_length < length) {
     return 0;
   }
 
+  self->restart_interval = ut_uint8_list_get_uint16_be(data, 2);
+
   self->state = DECODER_STATE_MARKER;
 
   return length;
@@ -1053,6 +1329,10 @@ static bool supported_scan_selection(UtJpegDecoder *self,
   case DECODE_MODE_EXTENDED_DCT:
     return selection_start == 0 && selection_end == 63;
   case DECODE_MODE_PROGRESSIVE_DCT:
+    // DC scans contain only the DC coefficient, and AC scans never contain it.
+    if (selection_start == 0) {
+      return selection_end == 0;
+    }
     return selection_end <= 63 && selection_start <= selection_end;
   case DECODE_MODE_LOSSLESS:
     return (selection_start >= 1 && selection_start <= 7) && selection_end == 0;
@@ -1098,7 +1378,14 @@ static size_t decode_start_of_scan(UtJpegDecoder *self, UtObject *data) {
     set_error(self, "Insufficient data for JPEG start of scan");
     return length;
   }
-  if (n_scan_components != ut_jpeg_image_get_n_components(self->image)) {
+  // Progressive images can have components in separate scans.
+  size_t n_components = ut_jpeg_image_get_n_components(self->image);
+  bool valid_n_scan_components = n_scan_components == n_components;
+  if (self->mode == DECODE_MODE_PROGRESSIVE_DCT) {
+    valid_n_scan_components =
+        n_scan_components >= 1 && n_scan_components <= n_components;
+  }
+  if (!valid_n_scan_components) {
     set_error(self,
               "Mismatched number of scan components in JPEG start of scan");
     return length;
@@ -1127,30 +1414,47 @@ static size_t decode_start_of_scan(UtJpegDecoder *self, UtObject *data) {
     }
     component->dc_decoder = self->dc_decoders[dc_table];
     component->dc_table = self->dc_tables[dc_table];
-    if (component->dc_decoder == NULL) {
-      set_error(self, "Missing DC table in JPEG start of scan");
-      return length;
-    }
     component->ac_decoder = self->ac_decoders[ac_table];
     component->ac_table = self->ac_tables[ac_table];
-    if (component->ac_decoder == NULL) {
-      set_error(self, "Missing AC table in JPEG start of scan");
-      return length;
-    }
   }
+  self->n_scan_components = n_scan_components;
   uint8_t selection_start = ut_uint8_list_get_element(data, offset++);
   uint8_t selection_end = ut_uint8_list_get_element(data, offset++);
   uint8_t successive_approximation = ut_uint8_list_get_element(data, offset++);
   uint8_t successive_approximation_high = successive_approximation >> 4;
   uint8_t successive_approximation_low = successive_approximation & 0xf;
 
+  // Progressive scans only use the tables they need: refining DC values uses
+  // no tables, and DC and AC coefficients are in separate scans.
+  bool need_dc_table = selection_start == 0;
+  bool need_ac_table = selection_end > 0;
+  if (self->mode == DECODE_MODE_PROGRESSIVE_DCT &&
+      successive_approximation_high > 0) {
+    need_dc_table = false;
+  }
+  for (size_t i = 0; i < n_scan_components; i++) {
+    JpegComponent *component = self->scan_components[i];
+    if (need_dc_table && component->dc_decoder == NULL) {
+      set_error(self, "Missing DC table in JPEG start of scan");
+      return length;
+    }
+    if (need_ac_table && component->ac_decoder == NULL) {
+      set_error(self, "Missing AC table in JPEG start of scan");
+      return length;
+    }
+  }
+  if (selection_start > 0 && n_scan_components != 1) {
+    set_error(self, "Invalid number of components in JPEG AC scan");
+    return length;
+  }
+
   if (!supported_scan_selection(self, selection_start, selection_end)) {
     set_error(self, "Invalid scan selection range %d-%d in JPEG start of scan",
               selection_start, selection_end);
     return length;
   }
   if (!supported_successive_approximation(self, successive_approximation_high,
-                                          successive_approximation_low) != 0) {
+                                          successive_approximation_low)) {
     set_error(self, "Invalid successive approximation in JPEG start of scan");
     return length;
   }
@@ -1159,10 +1463,6 @@ static size_t decode_start_of_scan(UtJpegDecoder *self, UtObject *data) {
     set_error(self, "Extended DCT JPEG not supported");
     return length;
   }
-  if (self->mode == DECODE_MODE_PROGRESSIVE_DCT) {
-    set_error(self, "Progressive DCT JPEG not supported");
-    return length;
-  }
   if (self->mode == DECODE_MODE_LOSSLESS) {
     set_error(self, "Lossless JPEG not supported");
     return length;
@@ -1179,18 +1479,42 @@ static size_t decode_start_of_scan(UtJpegDecoder *self, UtObject *data) {
 
   self->scan_coefficient_start = selection_start;
   self->scan_coefficient_end = selection_end;
+  self->successive_approximation_high = successive_approximation_high;
+  self->successive_approximation_low = successive_approximation_low;
+  self->end_of_band_run = 0;
   self->data_unit_coefficient_index = self->scan_coefficient_start;
   self->mcu_count = 0;
+  self->restart_count = 0;
+  self->output_row = 0;
   self->scan_component_index = 0;
   for (size_t i = 0; i < n_scan_components; i++) {
-    self->components[i].previous_dc = 0;
-    self->components[i].data_unit_count = 0;
+    self->scan_components[i]->previous_dc = 0;
+    self->scan_components[i]->data_unit_count = 0;
   }
   self->state = DECODER_STATE_SCAN;
 
   return offset;
 }
 
+// Convert a [value] of [magnitude] bits into a signed coefficient.
+// Upper half of values are positive, lower half are negative, i.e.
+// 0 bits:  0
+// 1 bit:  -1, 1
+// 2 bits: -3,-2, 2, 3
+// 3 bits: -7,-6,-5,-4, 4, 5, 6, 7
+// ...
+static int16_t extend(uint16_t value, uint8_t magnitude) {
+  if (magnitude == 0) {
+    return 0;
+  }
+  int32_t min_amplitude = 1 << (magnitude - 1);
+  if (value >= min_amplitude) {
+    return value;
+  } else {
+    return value - (min_amplitude * 2) + 1;
+  }
+}
+
 static bool decode_coefficient_magnitude(UtJpegDecoder *self, UtObject *data,
                                          size_t *offset) {
   JpegComponent *component = self->scan_components[self->scan_component_index];
@@ -1208,6 +1532,10 @@ static bool decode_coefficient_magnitude(UtJpegDecoder *self, UtObject *data,
   if (!read_huffman_symbol(self, data, offset, decoder, &symbol)) {
     return false;
   }
+  if (symbol >= ut_list_get_length(table)) {
+    set_error(self, "Invalid Huffman code in JPEG scan");
+    return false;
+  }
   uint8_t value = ut_uint8_list_get_element(table, symbol);
 
   if (self->data_unit_coefficient_index == 0) {
@@ -1240,19 +1568,7 @@ static bool decode_coefficient_amplitude(UtJpegDecoder *self, UtObject *data,
     if (!read_int(self, data, offset, self->coefficient_magnitude, &value)) {
       return false;
     }
-
-    // Upper half of values are positive, lower half are negative, i.e.
-    // 0 bits:  0
-    // 1 bit:  -1, 1
-    // 2 bits: -3,-2, 2, 3
-    // 3 bits: -7,-6,-5,-4, 4, 5, 6, 7
-    // ...
-    int16_t min_amplitude = 1 << (self->coefficient_magnitude - 1);
-    if (value >= min_amplitude) {
-      amplitude = value;
-    } else {
-      amplitude = value - (min_amplitude * 2) + 1;
-    }
+    amplitude = extend(value, self->coefficient_magnitude);
   }
 
   size_t run_length;
@@ -1304,9 +1620,649 @@ static bool decode_coefficient_end_of_block_count(UtJpegDecoder *self,
   return true;
 }
 
+// Reads bits from a complete block of entropy coded data.
+typedef struct {
+  const uint8_t *data;
+  size_t length;
+  size_t offset;
+  uint32_t buffer;
+  size_t buffer_length;
+} BitReader;
+
+// Read [length] bits from [reader]. If there is no data remaining zeros are
+// returned, in the same way as the IJG library.
+static uint16_t read_bits(BitReader *reader, size_t length) {
+  while (reader->buffer_length < length) {
+    uint8_t byte = 0;
+    if (reader->offset < reader->length) {
+      byte = reader->data[reader->offset++];
+      // Skip stuffed zero after 0xff.
+      if (byte == 0xff) {
+        reader->offset++;
+      }
+    }
+    reader->buffer = reader->buffer << 8 | byte;
+    reader->buffer_length += 8;
+  }
+
+  reader->buffer_length -= length;
+  return (reader->buffer >> reader->buffer_length) & ((1 << length) - 1);
+}
+
+// Entropy coded data for a scan, split into restart intervals.
+typedef struct {
+  const uint8_t *data;
+
+  // Offset of the start of each restart interval, followed by the end of the
+  // data plus the two bytes of a marker.
+  const uint32_t *interval_offsets;
+  size_t n_intervals;
+} ScanData;
+
+// Set [reader] to read restart interval [index] of [scan].
+static void read_restart_interval(BitReader *reader, const ScanData *scan,
+                                  size_t index) {
+  reader->data = scan->data;
+  reader->offset = 0;
+  reader->length = 0;
+  reader->buffer = 0;
+  reader->buffer_length = 0;
+  if (index < scan->n_intervals) {
+    reader->data += scan->interval_offsets[index];
+    reader->length = scan->interval_offsets[index + 1] - 2 -
+                     scan->interval_offsets[index];
+  }
+}
+
+// Gets the [length] of the entropy coded data at the start of [data], which
+// ends at the first marker that is not a restart marker. Returns false if the
+// end has not yet been received.
+static bool get_scan_length(UtJpegDecoder *self, const uint8_t *data,
+                            size_t data_length, size_t *length) {
+  size_t l = self->scan_length;
+  while (l + 1 < data_length) {
+    if (data[l] == 0xff && data[l + 1] != 0x00 &&
+        (data[l + 1] < 0xd0 || data[l + 1] > 0xd7)) {
+      self->scan_length = 0;
+      *length = l;
+      return true;
+    }
+    l++;
+  }
+
+  // Resume checking from here when more data is received.
+  self->scan_length = l;
+  return false;
+}
+
+// Returns the offsets of the restart intervals in the entropy coded [data] of
+// [length] bytes for a scan of [n_mcus] MCUs, in the form used by [ScanData].
+static UtObject *get_restart_intervals(UtJpegDecoder *self,
+                                       const uint8_t *data, size_t length,
+                                       size_t n_mcus) {
+  UtObjectRef offsets = ut_uint32_array_new();
+  ut_uint32_list_append(offsets, 0);
+  if (self->restart_interval != 0) {
+    for (size_t i = 0; i + 1 < length; i++) {
+      if (data[i] == 0xff && data[i + 1] != 0x00) {
+        size_t count = ut_list_get_length(offsets) - 1;
+        if (data[i + 1] != 0xd0 + count % 8) {
+          set_error(self, "Invalid JPEG restart marker %d", data[i + 1] - 0xd0);
+          return NULL;
+        }
+        ut_uint32_list_append(offsets, i + 2);
+        i++;
+      }
+    }
+  }
+  ut_uint32_list_append(offsets, length + 2);
+
+  size_t n_intervals = 1;
+  if (self->restart_interval != 0) {
+    n_intervals =
+        (n_mcus + self->restart_interval - 1) / self->restart_interval;
+  }
+  if (ut_list_get_length(offsets) - 1 != n_intervals) {
+    set_error(self, "Invalid number of JPEG restart intervals");
+    return NULL;
+  }
+
+  return ut_object_ref(offsets);
+}
+
+// Read a Huffman symbol from [reader] using [decoder] and map it using
+// [table]. Returns false if the code is invalid.
+static bool read_huffman_value(BitReader *reader, UtObject *decoder,
+                               UtObject *table, uint8_t *value) {
+  uint16_t code = 0;
+  for (size_t code_width = 1; code_width <= 16; code_width++) {
+    code = code << 1 | read_bits(reader, 1);
+    uint16_t symbol;
+    if (ut_huffman_decoder_get_symbol(decoder, code, code_width, &symbol)) {
+      if (symbol >= ut_list_get_length(table)) {
+        return false;
+      }
+      *value = ut_uint8_list_get_element(table, symbol);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Read a Huffman symbol from [reader] using [decoder] and map it using
+// [table].
+static bool read_symbol(UtJpegDecoder *self, BitReader *reader,
+                        UtObject *decoder, UtObject *table, uint8_t *value) {
+  if (!read_huffman_value(reader, decoder, table, value)) {
+    set_error(self, "Invalid Huffman code in JPEG scan");
+    return false;
+  }
+  return true;
+}
+
+static bool decode_dc_first(UtJpegDecoder *self, BitReader *reader,
+                            JpegComponent *component, int16_t *data_unit) {
+  uint8_t magnitude;
+  if (!read_symbol(self, reader, component->dc_decoder, component->dc_table,
+                   &magnitude)) {
+    return false;
+  }
+  if (magnitude > 15) {
+    set_error(self, "Invalid DC coefficient magnitude in JPEG scan");
+    return false;
+  }
+  int16_t diff = extend(read_bits(reader, magnitude), magnitude);
+  component->previous_dc += diff;
+  data_unit[0] = component->previous_dc *
+                 (1 << self->successive_approximation_low);
+  return true;
+}
+
+static bool decode_dc_refine(UtJpegDecoder *self, BitReader *reader,
+                             int16_t *data_unit) {
+  if (read_bits(reader, 1)) {
+    data_unit[0] |= 1 << self->successive_approximation_low;
+  }
+  return true;
+}
+
+static bool decode_ac_first(UtJpegDecoder *self, BitReader *reader,
+                            JpegComponent *component, int16_t *data_unit) {
+  if (self->end_of_band_run > 0) {
+    self->end_of_band_run--;
+    return true;
+  }
+
+  for (size_t k = self->scan_coefficient_start; k <= self->scan_coefficient_end;
+       k++) {
+    uint8_t value;
+    if (!read_symbol(self, reader, component->ac_decoder, component->ac_table,
+                     &value)) {
+      return false;
+    }
+    uint8_t run_length = value >> 4;
+    uint8_t magnitude = value & 0xf;
+    if (magnitude == 0) {
+      if (run_length < 15) {
+        // End of band, and possibly following data units.
+        self->end_of_band_run = (1 << run_length) - 1;
+        if (run_length > 0) {
+          self->end_of_band_run += read_bits(reader, run_length);
+        }
+        return true;
+      }
+
+      // Sixteen zeros.
+      k += 15;
+      continue;
+    }
+
+    k += run_length;
+    if (k > self->scan_coefficient_end) {
+      set_error(self, "Too many coefficients in data unit");
+      return false;
+    }
+    int16_t coefficient = extend(read_bits(reader, magnitude), magnitude);
+    data_unit[self->data_unit_order[k]] =
+        coefficient * (1 << self->successive_approximation_low);
+  }
+
+  return true;
+}
+
+// Add a correction bit from [reader] to the non-zero [coefficient].
+static void refine_coefficient(UtJpegDecoder *self, BitReader *reader,
+                               int16_t *coefficient) {
+  int16_t bit = 1 << self->successive_approximation_low;
+  if (read_bits(reader, 1) && (*coefficient & bit) == 0) {
+    *coefficient += *coefficient >= 0 ? bit : -bit;
+  }
+}
+
+static bool decode_ac_refine(UtJpegDecoder *self, BitReader *reader,
+                             JpegComponent *component, int16_t *data_unit) {
+  size_t k = self->scan_coefficient_start;
+  if (self->end_of_band_run == 0) {
+    for (; k <= self->scan_coefficient_end; k++) {
+      uint8_t value;
+      if (!read_symbol(self, reader, component->ac_decoder,
+                       component->ac_table, &value)) {
+        return false;
+      }
+      int run_length = value >> 4;
+      uint8_t magnitude = value & 0xf;
+
+      int16_t new_coefficient = 0;
+      if (magnitude != 0) {
+        // New coefficients are always +/-1 at this bit position.
+        if (magnitude != 1) {
+          set_error(self, "Invalid JPEG refinement coefficient");
+          return false;
+        }
+        int16_t bit = 1 << self->successive_approximation_low;
+        new_coefficient = read_bits(reader, 1) ? bit : -bit;
+      } else if (run_length != 15) {
+        // End of band, the remaining coefficients are refined below.
+        self->end_of_band_run = 1 << run_length;
+        if (run_length > 0) {
+          self->end_of_band_run += read_bits(reader, run_length);
+        }
+        break;
+      }
+
+      // Skip zero coefficients, refining non-zero ones as we pass.
+      for (; k <= self->scan_coefficient_end; k++) {
+        int16_t *coefficient = &data_unit[self->data_unit_order[k]];
+        if (*coefficient != 0) {
+          refine_coefficient(self, reader, coefficient);
+        } else {
+          if (run_length == 0) {
+            break;
+          }
+          run_length--;
+        }
+      }
+
+      if (new_coefficient != 0) {
+        if (k > self->scan_coefficient_end) {
+          set_error(self, "Too many coefficients in data unit");
+          return false;
+        }
+        data_unit[self->data_unit_order[k]] = new_coefficient;
+      }
+    }
+  }
+
+  if (self->end_of_band_run > 0) {
+    for (; k <= self->scan_coefficient_end; k++) {
+      int16_t *coefficient = &data_unit[self->data_unit_order[k]];
+      if (*coefficient != 0) {
+        refine_coefficient(self, reader, coefficient);
+      }
+    }
+    self->end_of_band_run--;
+  }
+
+  return true;
+}
+
+// Decode the data unit at [x], [y] of [component] in a progressive scan.
+static bool decode_progressive_data_unit(UtJpegDecoder *self,
+                                         BitReader *reader,
+                                         JpegComponent *component, size_t x,
+                                         size_t y) {
+  int16_t *coefficients =
+      ut_int16_list_get_writable_data(component->coefficients);
+  int16_t *data_unit =
+      coefficients + ((y * component->width_in_data_units) + x) * 64;
+
+  if (self->scan_coefficient_start == 0) {
+    if (self->successive_approximation_high == 0) {
+      return decode_dc_first(self, reader, component, data_unit);
+    } else {
+      return decode_dc_refine(self, reader, data_unit);
+    }
+  } else {
+    if (self->successive_approximation_high == 0) {
+      return decode_ac_first(self, reader, component, data_unit);
+    } else {
+      return decode_ac_refine(self, reader, component, data_unit);
+    }
+  }
+}
+
+// Returns the number of MCUs in the current progressive scan. Scans with a
+// single component are not interleaved and cover just the data units inside
+// the image, one per MCU.
+static size_t get_progressive_scan_n_mcus(UtJpegDecoder *self) {
+  if (self->n_scan_components == 1) {
+    JpegComponent *component = self->scan_components[0];
+    return component->image_width_in_data_units *
+           component->image_height_in_data_units;
+  }
+  return self->width_in_mcus * self->height_in_mcus;
+}
+
+// Prepare [reader] to decode MCU [mcu] of a progressive scan, moving to the
+// next restart interval if required.
+static void start_progressive_mcu(UtJpegDecoder *self, BitReader *reader,
+                                  const ScanData *scan, size_t mcu) {
+  size_t interval = 0;
+  if (self->restart_interval != 0) {
+    if (mcu % self->restart_interval != 0) {
+      return;
+    }
+    interval = mcu / self->restart_interval;
+  } else if (mcu != 0) {
+    return;
+  }
+
+  read_restart_interval(reader, scan, interval);
+  for (size_t i = 0; i < self->n_scan_components; i++) {
+    self->scan_components[i]->previous_dc = 0;
+  }
+  self->end_of_band_run = 0;
+}
+
+static void decode_progressive_scan_data(UtJpegDecoder *self,
+                                         const ScanData *scan) {
+  BitReader reader;
+
+  if (self->n_scan_components == 1) {
+    JpegComponent *component = self->scan_components[0];
+    size_t mcu = 0;
+    for (size_t y = 0; y < component->image_height_in_data_units; y++) {
+      for (size_t x = 0; x < component->image_width_in_data_units; x++) {
+        start_progressive_mcu(self, &reader, scan, mcu);
+        mcu++;
+        if (!decode_progressive_data_unit(self, &reader, component, x, y)) {
+          return;
+        }
+      }
+    }
+    return;
+  }
+
+  for (size_t mcu_y = 0; mcu_y < self->height_in_mcus; mcu_y++) {
+    for (size_t mcu_x = 0; mcu_x < self->width_in_mcus; mcu_x++) {
+      start_progressive_mcu(self, &reader, scan,
+                            mcu_y * self->width_in_mcus + mcu_x);
+      for (size_t i = 0; i < self->n_scan_components; i++) {
+        JpegComponent *component = self->scan_components[i];
+        for (size_t v = 0; v < component->vertical_sampling_factor; v++) {
+          for (size_t u = 0; u < component->horizontal_sampling_factor;
+               u++) {
+            size_t x = mcu_x * component->horizontal_sampling_factor + u;
+            size_t y = mcu_y * component->vertical_sampling_factor + v;
+            if (!decode_progressive_data_unit(self, &reader, component, x,
+                                              y)) {
+              return;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Progressive scans are decoded once all the scan data is available, as the
+// coefficients are refined in place.
+static size_t decode_progressive_scan(UtJpegDecoder *self, UtObject *data) {
+  size_t data_length = ut_list_get_length(data);
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  UtObjectRef array = NULL;
+  if (d == NULL) {
+    array = ut_uint8_list_get_array(data);
+    d = ut_uint8_list_get_data(array);
+  }
+
+  size_t length;
+  if (!get_scan_length(self, d, data_length, &length)) {
+    return 0;
+  }
+  UtObjectRef intervals = get_restart_intervals(
+      self, d, length, get_progressive_scan_n_mcus(self));
+  if (intervals == NULL) {
+    return length;
+  }
+
+  ScanData scan = {.data = d,
+                   .interval_offsets = ut_uint32_list_get_data(intervals),
+                   .n_intervals = ut_list_get_length(intervals) - 1};
+  decode_progressive_scan_data(self, &scan);
+  if (self->state == DECODER_STATE_ERROR) {
+    return length;
+  }
+
+  // Notify when a preview is available, once all the DC values are known.
+  bool have_dc = true;
+  size_t n_components = ut_jpeg_image_get_n_components(self->image);
+  for (size_t i = 0; i < n_components; i++) {
+    JpegComponent *component = &self->components[i];
+    if (self->scan_coefficient_start == 0) {
+      for (size_t j = 0; j < self->n_scan_components; j++) {
+        if (self->scan_components[j] == component) {
+          component->have_dc = true;
+        }
+      }
+    }
+    have_dc = have_dc && component->have_dc;
+  }
+  if (have_dc && self->preview_callback_object != NULL) {
+    write_progressive_image(self);
+    self->preview_callback(self->preview_callback_object);
+  }
+
+  self->state = DECODER_STATE_MARKER;
+
+  return length;
+}
+
+// Decode a baseline data unit for [component] from [reader] into
+// [data_unit], using and updating the DC prediction in [previous_dc].
+// Returns an error message if the data is invalid.
+static const char *decode_baseline_data_unit(UtJpegDecoder *self,
+                                             BitReader *reader,
+                                             JpegComponent *component,
+                                             int16_t *previous_dc,
+                                             int16_t *data_unit) {
+  const uint8_t *quantization_table_data =
+      ut_uint8_list_get_data(component->quantization_table);
+  memset(data_unit, 0, sizeof(int16_t) * 64);
+
+  uint8_t magnitude;
+  if (!read_huffman_value(reader, component->dc_decoder, component->dc_table,
+                          &magnitude)) {
+    return "Invalid Huffman code in JPEG scan";
+  }
+  if (magnitude > 15) {
+    return "Invalid DC coefficient magnitude in JPEG scan";
+  }
+  *previous_dc += extend(read_bits(reader, magnitude), magnitude);
+  data_unit[0] = *previous_dc * quantization_table_data[0];
+
+  for (size_t k = 1; k < 64; k++) {
+    uint8_t value;
+    if (!read_huffman_value(reader, component->ac_decoder, component->ac_table,
+                            &value)) {
+      return "Invalid Huffman code in JPEG scan";
+    }
+    uint8_t run_length = value >> 4;
+    magnitude = value & 0xf;
+    if (magnitude == 0) {
+      if (run_length < 15) {
+        break;
+      }
+
+      // Sixteen zeros.
+      k += 15;
+      continue;
+    }
+
+    k += run_length;
+    if (k > 63) {
+      return "Too many coefficients in data unit";
+    }
+    uint8_t index = self->data_unit_order[k];
+    data_unit[index] = extend(read_bits(reader, magnitude), magnitude) *
+                       quantization_table_data[index];
+  }
+
+  return NULL;
+}
+
+// Work done on a thread when decoding a scan in parallel.
+typedef struct {
+  UtJpegDecoder *decoder;
+  const ScanData *scan;
+
+  // Restart intervals to decode.
+  size_t interval_start;
+  size_t interval_end;
+
+  // Image rows to write.
+  size_t row_start;
+  size_t row_end;
+
+  // Error that occurred during decoding or NULL.
+  const char *error;
+} ScanWorker;
+
+static void decode_intervals_cb(void *data) {
+  ScanWorker *worker = data;
+  UtJpegDecoder *self = worker->decoder;
+  size_t n_mcus = self->width_in_mcus * self->height_in_mcus;
+
+  for (size_t i = worker->interval_start; i < worker->interval_end; i++) {
+    BitReader reader;
+    read_restart_interval(&reader, worker->scan, i);
+    int16_t previous_dc[4] = {0, 0, 0, 0};
+    size_t mcu_start = i * self->restart_interval;
+    size_t mcu_end = mcu_start + self->restart_interval;
+    if (mcu_end > n_mcus) {
+      mcu_end = n_mcus;
+    }
+    for (size_t mcu = mcu_start; mcu < mcu_end; mcu++) {
+      size_t mcu_x = mcu % self->width_in_mcus;
+      size_t mcu_y = mcu / self->width_in_mcus;
+      for (size_t c = 0; c < self->n_scan_components; c++) {
+        JpegComponent *component = self->scan_components[c];
+        for (size_t v = 0; v < component->vertical_sampling_factor; v++) {
+          for (size_t u = 0; u < component->horizontal_sampling_factor;
+               u++) {
+            int16_t data_unit[64];
+            worker->error = decode_baseline_data_unit(
+                self, &reader, component, &previous_dc[c], data_unit);
+            if (worker->error != NULL) {
+              return;
+            }
+            write_data_unit(
+                self, component,
+                mcu_x * component->horizontal_sampling_factor + u,
+                mcu_y * component->vertical_sampling_factor + v, data_unit);
+          }
+        }
+      }
+    }
+  }
+}
+
+static void write_rows_cb(void *data) {
+  ScanWorker *worker = data;
+  UtJpegDecoder *self = worker->decoder;
+
+  size_t buffer_width = get_upsample_buffer_width(self);
+  uint8_t *buffer = malloc(buffer_width * 4);
+  uint16_t *workspace = malloc(sizeof(uint16_t) * buffer_width);
+  for (size_t y = worker->row_start; y < worker->row_end; y++) {
+    write_row(self, y, buffer, workspace);
+  }
+  free(buffer);
+  free(workspace);
+}
+
+// Baseline scans with restart intervals can be decoded in parallel once all
+// the scan data is available, as each interval is independent.
+static size_t decode_parallel_scan(UtJpegDecoder *self, UtObject *data) {
+  size_t data_length = ut_list_get_length(data);
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  UtObjectRef array = NULL;
+  if (d == NULL) {
+    array = ut_uint8_list_get_array(data);
+    d = ut_uint8_list_get_data(array);
+  }
+
+  size_t length;
+  if (!get_scan_length(self, d, data_length, &length)) {
+    return 0;
+  }
+  size_t n_mcus = self->width_in_mcus * self->height_in_mcus;
+  UtObjectRef intervals = get_restart_intervals(self, d, length, n_mcus);
+  if (intervals == NULL) {
+    return length;
+  }
+  ScanData scan = {.data = d,
+                   .interval_offsets = ut_uint32_list_get_data(intervals),
+                   .n_intervals = ut_list_get_length(intervals) - 1};
+
+  // Split the intervals between the threads, then the rows to write.
+  size_t n_workers = self->n_threads;
+  ScanWorker *workers = calloc(n_workers, sizeof(ScanWorker));
+  uint16_t image_height = ut_jpeg_image_get_height(self->image);
+  for (size_t i = 0; i < n_workers; i++) {
+    workers[i].decoder = self;
+    workers[i].scan = &scan;
+    workers[i].interval_start = i * scan.n_intervals / n_workers;
+    workers[i].interval_end = (i + 1) * scan.n_intervals / n_workers;
+    workers[i].row_start = i * image_height / n_workers;
+    workers[i].row_end = (i + 1) * image_height / n_workers;
+  }
+
+  _ut_parallel_run(workers, sizeof(ScanWorker), n_workers,
+                   decode_intervals_cb);
+  const char *error = NULL;
+  for (size_t i = 0; i < n_workers && error == NULL; i++) {
+    error = workers[i].error;
+  }
+  if (error == NULL) {
+    _ut_parallel_run(workers, sizeof(ScanWorker), n_workers, write_rows_cb);
+  }
+  free(workers);
+  if (error != NULL) {
+    set_error(self, "%s", error);
+    return length;
+  }
+
+  self->mcu_count = n_mcus;
+  self->output_row = image_height;
+  self->state = DECODER_STATE_MARKER;
+
+  return length;
+}
+
 static size_t decode_scan(UtJpegDecoder *self, UtObject *data) {
+  if (self->mode == DECODE_MODE_PROGRESSIVE_DCT) {
+    return decode_progressive_scan(self, data);
+  }
+  if (self->n_threads > 1 && self->restart_interval != 0 &&
+      self->n_scan_components ==
+          ut_jpeg_image_get_n_components(self->image)) {
+    return decode_parallel_scan(self, data);
+  }
+
   size_t offset = 0;
 
+  // Skip any padding after the last MCU in the restart interval until the
+  // next marker.
+  if (self->mcu_count == get_restart_interval_end(self)) {
+    self->bit_count = 0;
+    uint8_t value;
+    while (read_scan_byte(self, data, &offset, &value)) {
+    }
+    return offset;
+  }
+
   bool have_coefficient;
   do {
     switch (self->scan_decoder_state) {
@@ -1321,7 +2277,8 @@ static size_t decode_scan(UtJpegDecoder *self, UtObject *data) {
           decode_coefficient_end_of_block_count(self, data, &offset);
       break;
     }
-  } while (have_coefficient && self->state != DECODER_STATE_ERROR);
+  } while (have_coefficient && self->state == DECODER_STATE_SCAN &&
+           self->mcu_count < get_restart_interval_end(self));
 
   return offset;
 }
@@ -1372,7 +2329,7 @@ static size_t decode_marker(UtJpegDecoder *self, UtObject *data) {
   case 0xd5:
   case 0xd6:
   case 0xd7:
-    handle_restart(self, marker_id = 0xd0);
+    handle_restart(self, marker_id - 0xd0);
     break;
   case 0xd8:
     handle_start_of_image(self);
@@ -1557,7 +2514,9 @@ static void done_cb(UtObject *object) {}
 static void ut_jpeg_decoder_init(UtObject *object) {
   UtJpegDecoder *self = (UtJpegDecoder *)object;
   jpeg_build_data_unit_order(self->data_unit_order);
-  jpeg_build_dct_values(self->dct_alpha, self->dct_cos);
+  self->fancy_upsampling = true;
+  self->scale = 1;
+  self->n_threads = 1;
 }
 
 static void ut_jpeg_decoder_cleanup(UtObject *object) {
@@ -1567,6 +2526,7 @@ static void ut_jpeg_decoder_cleanup(UtObject *object) {
 
   ut_object_unref(self->input_stream);
   ut_object_weak_unref(&self->callback_object);
+  ut_object_weak_unref(&self->preview_callback_object);
   for (size_t i = 0; i < 4; i++) {
     ut_object_unref(self->quantization_tables[i]);
     ut_object_unref(self->dc_decoders[i]);
@@ -1574,7 +2534,10 @@ static void ut_jpeg_decoder_cleanup(UtObject *object) {
     ut_object_unref(self->ac_decoders[i]);
     ut_object_unref(self->ac_tables[i]);
     ut_object_unref(self->components[i].coefficients);
+    ut_object_unref(self->components[i].samples);
   }
+  ut_object_unref(self->upsample_buffer);
+  ut_object_unref(self->upsample_workspace);
   free(self->comment);
   ut_object_unref(self->image);
   ut_object_unref(self->error);
@@ -1592,6 +2555,37 @@ UtObject *ut_jpeg_decoder_new(UtObject *input_stream) {
   return object;
 }
 
+void ut_jpeg_decoder_set_fancy_upsampling(UtObject *object,
+                                         bool fancy_upsampling) {
+  assert(ut_object_is_jpeg_decoder(object));
+  UtJpegDecoder *self = (UtJpegDecoder *)object;
+  self->fancy_upsampling = fancy_upsampling;
+}
+
+void ut_jpeg_decoder_set_scale(UtObject *object, size_t scale) {
+  assert(ut_object_is_jpeg_decoder(object));
+  UtJpegDecoder *self = (UtJpegDecoder *)object;
+  assert(scale == 1 || scale == 2 || scale == 4 || scale == 8);
+  self->scale = scale;
+}
+
+void ut_jpeg_decoder_set_n_threads(UtObject *object, size_t n_threads) {
+  assert(ut_object_is_jpeg_decoder(object));
+  UtJpegDecoder *self = (UtJpegDecoder *)object;
+  assert(n_threads > 0);
+  self->n_threads = n_threads;
+}
+
+void ut_jpeg_decoder_set_preview_callback(UtObject *object,
+                                         UtObject *callback_object,
+                                         UtJpegDecodeCallback callback) {
+  assert(ut_object_is_jpeg_decoder(object));
+  UtJpegDecoder *self = (UtJpegDecoder *)object;
+
+  ut_object_weak_ref(callback_object, &self->preview_callback_object);
+  self->preview_callback = callback;
+}
+
 void ut_jpeg_decoder_decode(UtObject *object, UtObject *callback_object,
                             UtJpegDecodeCallback callback) {
   assert(ut_object_is_jpeg_decoder(object));
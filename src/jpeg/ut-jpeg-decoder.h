@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "ut-object.h"
 
@@ -13,6 +14,32 @@ typedef void (*UtJpegDecodeCallback)(UtObject *object);
 /// !return-type UtJpegDecoder
 UtObject *ut_jpeg_decoder_new(UtObject *input_stream);
 
+/// Sets [fancy_upsampling] to choose whether subsampled color components are
+/// upsampled using a triangle filter. If [false], samples are replicated which
+/// is faster but produces blockier edges. Defaults to [true].
+void ut_jpeg_decoder_set_fancy_upsampling(UtObject *object,
+                                         bool fancy_upsampling);
+
+/// Sets the decoder to scale the image down by [scale], which must be 1, 2, 4
+/// or 8. The image is decoded directly at the reduced size using a smaller
+/// inverse DCT, which is much faster and uses less memory than decoding the
+/// full image and resizing it. Defaults to 1 (no scaling).
+void ut_jpeg_decoder_set_scale(UtObject *object, size_t scale);
+
+/// Sets the number of threads used to decode images with restart intervals.
+/// When [n_threads] is greater than one, baseline scans are decoded once all
+/// their data has been received, with the restart intervals split between the
+/// threads. Defaults to 1.
+void ut_jpeg_decoder_set_n_threads(UtObject *object, size_t n_threads);
+
+/// Sets [callback] to be called when a lower quality preview of a progressive
+/// image is available. The preview is written into the image returned by
+/// [ut_jpeg_decoder_get_image], and is updated after each scan once the DC
+/// coefficients of all components have been received.
+void ut_jpeg_decoder_set_preview_callback(UtObject *object,
+                                         UtObject *callback_object,
+                                         UtJpegDecodeCallback callback);
+
 /// Start decoding.
 /// When complete [callback] is called.
 void ut_jpeg_decoder_decode(UtObject *object, UtObject *callback_object,
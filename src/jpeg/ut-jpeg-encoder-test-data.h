@@ -48,11 +48,11 @@ const char *test_greyscale_data =
     "40307073d01a9bed2f9c616b9dd47c4f7b6b7c608e2b72b9eacad9fe757f4ed66e6eefa282"
     "44882b8392a0e7a13eb522ff00c8c173f41ffa08ab3fc55c4eb7ff002173f5ad8d0ffe42d6"
     "df43ff00a09ae99ada04964b9f2ff7a4649c9e702b165d664361a65c5a697f689afc6443f6"
-    "809b7e5dc792307f4aad2be913453dcdf697347790c8b135bf984b33b0ca85c360e7357f47"
-    "889bbdd36892d8b22931c8d38901ed8e0f079ab5aacda9c584d3ec62ba575218b4fe5943eb"
-    "d39159936817125968967e74d18b4044d35bc9b197e4c707af278ab173a0086c97fb3989ba"
-    "8a75b80f70e5ccac38c313cf4e296c25d66e75b592f6c0d9dac70b2e16e448aec4ae0e063b"
-    "03dabfffd9";
+    "809b7e5dc7e62307f4aad2be913453dcdf697347790c8b135bf984b33b0ca85c360e7357f4"
+    "7889bbdd36892d8b22931c8d38901ed8e0f079ab5aacda9c584d3ec62ba575218b4fe5943e"
+    "bd39159936817125968967e74d18b4044d35bc9b197e4c707af278ab173a0086c97fb3989b"
+    "a8a75b80f70e5ccac38c313cf4e296c25d66e75b592f6c0d9dac70b2e16e448aec4ae0e063"
+    "b03dabffd9";
 
 // Example from https://en.wikipedia.org/wiki/JPEG
 const char *wikipedia_image_data =
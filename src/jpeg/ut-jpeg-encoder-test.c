@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "ut-jpeg-encoder-test-data.h"
 #include "ut.h"
@@ -15,10 +16,78 @@ static void check_jpeg(size_t width, size_t height, size_t n_components,
   ut_assert_uint8_list_equal_hex(data, hex_data);
 }
 
+// Encode a smooth color test image with the given settings.
+static UtObject *encode_color_jpeg(uint8_t quality,
+                                   UtJpegChromaSubsampling chroma_subsampling,
+                                   bool optimize_huffman_tables) {
+  UtObjectRef image_data = ut_uint8_array_new();
+  for (size_t y = 0; y < 27; y++) {
+    for (size_t x = 0; x < 30; x++) {
+      ut_uint8_list_append(image_data, x * 8);
+      ut_uint8_list_append(image_data, y * 9);
+      ut_uint8_list_append(image_data, 255 - (x + y) * 4);
+    }
+  }
+  UtObjectRef image = ut_jpeg_image_new(30, 27, UT_JPEG_DENSITY_UNITS_NONE, 1,
+                                        1, 3, image_data);
+
+  UtObject *data = ut_uint8_array_new();
+  UtObjectRef encoder = ut_jpeg_encoder_new(image, data);
+  ut_jpeg_encoder_set_quality(encoder, quality);
+  ut_jpeg_encoder_set_chroma_subsampling(encoder, chroma_subsampling);
+  ut_jpeg_encoder_set_optimize_huffman_tables(encoder, optimize_huffman_tables);
+  ut_jpeg_encoder_encode(encoder);
+
+  return data;
+}
+
+static UtObject *decode_jpeg(UtObject *data) {
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_jpeg_decoder_new(data_stream);
+  UtObject *image = ut_jpeg_decoder_decode_sync(decoder);
+  ut_assert_is_not_error(image);
+  return image;
+}
+
+// Check a color image encoded with [chroma_subsampling] decodes to close to
+// the original, and optimized Huffman tables make it smaller without changing
+// the decoded image.
+static void check_color_jpeg(uint8_t quality,
+                             UtJpegChromaSubsampling chroma_subsampling,
+                             uint8_t max_error) {
+  UtObjectRef data = encode_color_jpeg(quality, chroma_subsampling, false);
+  UtObjectRef image = decode_jpeg(data);
+  ut_assert_int_equal(ut_jpeg_image_get_width(image), 30);
+  ut_assert_int_equal(ut_jpeg_image_get_height(image), 27);
+  ut_assert_int_equal(ut_jpeg_image_get_n_components(image), 3);
+  const uint8_t *image_data =
+      ut_uint8_list_get_data(ut_jpeg_image_get_data(image));
+  for (size_t y = 0; y < 27; y++) {
+    for (size_t x = 0; x < 30; x++) {
+      const uint8_t *pixel = image_data + (y * 30 + x) * 3;
+      ut_assert_true(abs(pixel[0] - (int)(x * 8)) <= max_error);
+      ut_assert_true(abs(pixel[1] - (int)(y * 9)) <= max_error);
+      ut_assert_true(abs(pixel[2] - (int)(255 - (x + y) * 4)) <= max_error);
+    }
+  }
+
+  UtObjectRef optimized_data =
+      encode_color_jpeg(quality, chroma_subsampling, true);
+  ut_assert_true(ut_list_get_length(optimized_data) <
+                 ut_list_get_length(data));
+  UtObjectRef optimized_image = decode_jpeg(optimized_data);
+  ut_assert_equal(ut_jpeg_image_get_data(optimized_image),
+                  ut_jpeg_image_get_data(image));
+}
+
 int main(int argc, char **argv) {
   check_jpeg(8, 8, 1, wikipedia_image_data, wikipedia_data);
 
   check_jpeg(32, 32, 1, test_greyscale_image_data, test_greyscale_data);
 
+  check_color_jpeg(90, UT_JPEG_CHROMA_SUBSAMPLING_444, 8);
+  check_color_jpeg(90, UT_JPEG_CHROMA_SUBSAMPLING_422, 12);
+  check_color_jpeg(75, UT_JPEG_CHROMA_SUBSAMPLING_420, 16);
+
   return 0;
 }
@@ -1,9 +1,43 @@
 #include <assert.h>
-#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "huffman/ut-huffman-code.h"
 #include "ut-jpeg.h"
 #include "ut.h"
 
+// Largest number of bytes a data unit can be encoded in, allowing for every
+// byte to be stuffed.
+#define MAX_DATA_UNIT_LENGTH 512
+
+// Huffman codes for each value in a table.
+typedef struct {
+  uint16_t codes[256];
+  uint8_t code_widths[256];
+
+  // Number of times each value is used, when optimizing the table.
+  uint32_t frequencies[256];
+} HuffmanCodes;
+
+typedef struct {
+  // Sampling factors.
+  uint8_t horizontal_sampling_factor;
+  uint8_t vertical_sampling_factor;
+
+  // Tables used for this component.
+  uint8_t quantization_table;
+  uint8_t dc_table;
+  uint8_t ac_table;
+
+  // Samples for this component, reduced in size if subsampled.
+  uint8_t *samples;
+  size_t width;
+  size_t height;
+
+  // DC coefficient from the previous data unit.
+  int16_t previous_dc;
+} JpegComponent;
+
 typedef struct {
   UtObject object;
 
@@ -17,25 +51,82 @@ typedef struct {
   UtObject *quantization_tables[4];
 
   // Huffman encoders for DC coefficients.
-  UtObject *dc_symbols[2]; // FIXME: Can just be a fixed 256 array
+  UtObject *dc_symbols[2];
   UtObject *dc_encoders[2];
+  HuffmanCodes dc_codes[2];
 
   // Huffman encoders for AC coefficients.
   UtObject *ac_symbols[2];
   UtObject *ac_encoders[2];
+  HuffmanCodes ac_codes[2];
+
+  // Quality used to scale the quantization tables, 1-100.
+  uint8_t quality;
+
+  // Chroma subsampling to use for color images.
+  UtJpegChromaSubsampling chroma_subsampling;
+
+  // True if generating Huffman tables optimized for the image.
+  bool optimize_huffman_tables;
+
+  // Image components being encoded.
+  JpegComponent components[4];
+  size_t n_components;
+
+  // Maximum sampling factors.
+  uint8_t max_horizontal_sampling_factor;
+  uint8_t max_vertical_sampling_factor;
 
   // Order that data unit values are written.
   uint8_t data_unit_order[64];
 
-  // Precalculated cosines for DCT.
-  float dct_alpha[8];
-  float dct_cos[64];
+  // True if counting symbol frequencies instead of writing.
+  bool counting;
+
+  // Quantized coefficients for each data unit, stored when optimizing.
+  int16_t *coefficients;
+
+  // Buffer to write entropy coded data into.
+  uint8_t *scan_data;
+  size_t scan_data_length;
+  size_t scan_data_allocated;
 
   // Current bits being written.
-  uint32_t bit_buffer;
+  uint64_t bit_buffer;
   size_t bit_buffer_length;
 } UtJpegEncoder;
 
+// Scale the standard [quantization_table] to the encoder quality, as used by
+// the Independent JPEG Group.
+static void scale_quantization_table(UtJpegEncoder *self,
+                                     UtObject *quantization_table) {
+  uint32_t scale =
+      self->quality < 50 ? 5000 / self->quality : 200 - self->quality * 2;
+  uint8_t *data = ut_uint8_list_get_writable_data(quantization_table);
+  for (size_t i = 0; i < 64; i++) {
+    uint32_t value = (data[i] * scale + 50) / 100;
+    if (value < 1) {
+      value = 1;
+    } else if (value > 255) {
+      value = 255;
+    }
+    data[i] = value;
+  }
+}
+
+// Fill [codes] from the Huffman [encoder] for [symbols].
+static void build_huffman_codes(HuffmanCodes *codes, UtObject *symbols,
+                                UtObject *encoder) {
+  memset(codes->code_widths, 0, sizeof(codes->code_widths));
+  size_t symbols_length = ut_list_get_length(symbols);
+  for (size_t i = 0; i < symbols_length; i++) {
+    uint8_t value = ut_uint8_list_get_element(symbols, i);
+    size_t code_width;
+    ut_huffman_encoder_get_code(encoder, i, &codes->codes[value], &code_width);
+    codes->code_widths[value] = code_width;
+  }
+}
+
 static void build_tables(UtJpegEncoder *self) {
   // Standard Luminance quantization table and Huffman encoders.
   self->quantization_tables[0] = ut_uint8_list_new_from_elements(
@@ -78,7 +169,7 @@ static void build_tables(UtJpegEncoder *self) {
       ut_huffman_encoder_new_canonical(luminance_ac_code_widths);
 
   // Standard Chrominance quantization table and Huffman encoders.
-  if (ut_jpeg_image_get_n_components(self->image) > 1) {
+  if (self->n_components == 3) {
     self->quantization_tables[1] = ut_uint8_list_new_from_elements(
         64, 17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99, 24,
         26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99, 99, 99, 99,
@@ -118,70 +209,315 @@ static void build_tables(UtJpegEncoder *self) {
     self->ac_encoders[1] =
         ut_huffman_encoder_new_canonical(chrominance_ac_code_widths);
   }
+
+  for (size_t i = 0; i < 4; i++) {
+    if (self->quantization_tables[i] != NULL) {
+      scale_quantization_table(self, self->quantization_tables[i]);
+    }
+  }
+  for (size_t i = 0; i < 2; i++) {
+    if (self->dc_encoders[i] != NULL) {
+      build_huffman_codes(&self->dc_codes[i], self->dc_symbols[i],
+                          self->dc_encoders[i]);
+      build_huffman_codes(&self->ac_codes[i], self->ac_symbols[i],
+                          self->ac_encoders[i]);
+    }
+  }
 }
 
-// Create the data unit at [data_unit_x], [data_unit_y] containing the given
-// image [component]. and write into [data_unit].
-static void create_data_unit(UtJpegEncoder *self, size_t data_unit_x,
-                             size_t data_unit_y, size_t component,
-                             int16_t *data_unit) {
+// Optimal Huffman code width for a value.
+typedef struct {
+  uint8_t value;
+  size_t code_width;
+} CodeWidth;
+
+static int compare_code_widths(const void *a, const void *b) {
+  const CodeWidth *width_a = a, *width_b = b;
+  if (width_a->code_width != width_b->code_width) {
+    return width_a->code_width < width_b->code_width ? -1 : 1;
+  }
+  return width_a->value - width_b->value;
+}
+
+// Replace the Huffman table in [symbols] and [encoder] with one optimized for
+// the frequencies gathered in [codes].
+static void build_optimal_huffman_table(HuffmanCodes *codes,
+                                        UtObject **symbols,
+                                        UtObject **encoder) {
+  CodeWidth widths[256];
+  size_t n_values = 0;
+  UtObjectRef weights = ut_float64_array_new();
+  for (size_t i = 0; i < 256; i++) {
+    if (codes->frequencies[i] > 0) {
+      widths[n_values].value = i;
+      n_values++;
+      ut_float64_list_append(weights, codes->frequencies[i]);
+    }
+  }
+
+  // Reserve a code with the lowest weight so no value gets the all ones code,
+  // which is not allowed in JPEG.
+  ut_float64_list_append(weights, 0.5);
+
+  uint16_t tree_codes[257];
+  size_t tree_code_widths[257];
+  ut_huffman_code_generate(weights, tree_codes, tree_code_widths);
+  for (size_t i = 0; i < n_values; i++) {
+    widths[i].code_width = tree_code_widths[i];
+  }
+  qsort(widths, n_values, sizeof(CodeWidth), compare_code_widths);
+
+  // Count the number of codes of each width, including the reserved code.
+  size_t counts[258];
+  memset(counts, 0, sizeof(counts));
+  size_t max_code_width = tree_code_widths[n_values];
+  counts[tree_code_widths[n_values]]++;
+  for (size_t i = 0; i < n_values; i++) {
+    counts[widths[i].code_width]++;
+    if (widths[i].code_width > max_code_width) {
+      max_code_width = widths[i].code_width;
+    }
+  }
+
+  // JPEG codes are limited to 16 bits. Move pairs of the longest codes up a
+  // level, and use their prefix to extend a shorter code (ITU T.81 K.3).
+  for (size_t i = max_code_width; i > 16; i--) {
+    while (counts[i] > 0) {
+      size_t j = i - 2;
+      while (counts[j] == 0) {
+        j--;
+      }
+      counts[i] -= 2;
+      counts[i - 1]++;
+      counts[j + 1] += 2;
+      counts[j]--;
+    }
+  }
+
+  // Assign the widths in order, leaving the reserved code last.
+  UtObjectRef table_symbols = ut_uint8_array_new();
+  UtObjectRef code_widths = ut_uint8_array_new();
+  size_t code_width = 1;
+  for (size_t i = 0; i < n_values; i++) {
+    while (counts[code_width] == 0) {
+      code_width++;
+    }
+    counts[code_width]--;
+    ut_uint8_list_append(table_symbols, widths[i].value);
+    ut_uint8_list_append(code_widths, code_width);
+  }
+  while (counts[code_width] == 0) {
+    code_width++;
+  }
+  ut_uint8_list_append(code_widths, code_width);
+
+  ut_object_unref(*symbols);
+  *symbols = ut_object_ref(table_symbols);
+  ut_object_unref(*encoder);
+  *encoder = ut_huffman_encoder_new_canonical(code_widths);
+  build_huffman_codes(codes, *symbols, *encoder);
+}
+
+// Set up the components to encode and convert the image samples into them.
+static void build_components(UtJpegEncoder *self) {
   uint16_t image_width = ut_jpeg_image_get_width(self->image);
   uint16_t image_height = ut_jpeg_image_get_height(self->image);
   size_t n_components = ut_jpeg_image_get_n_components(self->image);
   const uint8_t *image_data =
       ut_uint8_list_get_data(ut_jpeg_image_get_data(self->image));
+  size_t n_pixels = (size_t)image_width * image_height;
+
+  self->n_components = n_components;
+  for (size_t i = 0; i < n_components; i++) {
+    JpegComponent *component = &self->components[i];
+    component->horizontal_sampling_factor = 1;
+    component->vertical_sampling_factor = 1;
+    component->samples = malloc(n_pixels);
+    component->width = image_width;
+    component->height = image_height;
+  }
 
+  // Color images are stored as YCbCr, with the chrominance possibly at a
+  // lower resolution.
+  if (n_components == 3) {
+    for (size_t y = 0; y < image_height; y++) {
+      size_t offset = y * image_width;
+      jpeg_rgb_to_ycbcr(image_data + offset * 3,
+                        self->components[0].samples + offset,
+                        self->components[1].samples + offset,
+                        self->components[2].samples + offset, image_width);
+    }
+
+    JpegComponent *luminance = &self->components[0];
+    if (self->chroma_subsampling != UT_JPEG_CHROMA_SUBSAMPLING_444) {
+      luminance->horizontal_sampling_factor = 2;
+    }
+    if (self->chroma_subsampling == UT_JPEG_CHROMA_SUBSAMPLING_420) {
+      luminance->vertical_sampling_factor = 2;
+    }
+    size_t h = luminance->horizontal_sampling_factor;
+    size_t v = luminance->vertical_sampling_factor;
+    for (size_t i = 1; i < 3; i++) {
+      JpegComponent *component = &self->components[i];
+      component->quantization_table = 1;
+      component->dc_table = 1;
+      component->ac_table = 1;
+      if (h == 1 && v == 1) {
+        continue;
+      }
+
+      // Average the samples covered by each subsampled sample.
+      component->width = (image_width + h - 1) / h;
+      component->height = (image_height + v - 1) / v;
+      uint8_t *samples = component->samples;
+      for (size_t y = 0; y < component->height; y++) {
+        for (size_t x = 0; x < component->width; x++) {
+          uint32_t total = 0;
+          for (size_t j = 0; j < v; j++) {
+            size_t iy = y * v + j;
+            if (iy >= image_height) {
+              iy = image_height - 1;
+            }
+            for (size_t k = 0; k < h; k++) {
+              size_t ix = x * h + k;
+              if (ix >= image_width) {
+                ix = image_width - 1;
+              }
+              total += samples[iy * image_width + ix];
+            }
+          }
+          samples[y * component->width + x] = (total + h * v / 2) / (h * v);
+        }
+      }
+    }
+  } else {
+    for (size_t i = 0; i < n_pixels; i++) {
+      for (size_t j = 0; j < n_components; j++) {
+        self->components[j].samples[i] = image_data[i * n_components + j];
+      }
+    }
+  }
+
+  self->max_horizontal_sampling_factor = 1;
+  self->max_vertical_sampling_factor = 1;
+  for (size_t i = 0; i < n_components; i++) {
+    JpegComponent *component = &self->components[i];
+    if (component->horizontal_sampling_factor >
+        self->max_horizontal_sampling_factor) {
+      self->max_horizontal_sampling_factor =
+          component->horizontal_sampling_factor;
+    }
+    if (component->vertical_sampling_factor >
+        self->max_vertical_sampling_factor) {
+      self->max_vertical_sampling_factor = component->vertical_sampling_factor;
+    }
+  }
+}
+
+// Create the data unit at [data_unit_x], [data_unit_y] containing samples
+// from [component] and write into [data_unit].
+static void create_data_unit(JpegComponent *component, size_t data_unit_x,
+                             size_t data_unit_y, int16_t *data_unit) {
   for (size_t y = 0; y < 8; y++) {
+    size_t iy = data_unit_y * 8 + y;
+    if (iy >= component->height) {
+      iy = component->height - 1;
+    }
+    const uint8_t *row = component->samples + iy * component->width;
     for (size_t x = 0; x < 8; x++) {
       size_t ix = data_unit_x * 8 + x;
-      if (ix >= image_width) {
-        ix = image_width - 1;
-      }
-      size_t iy = data_unit_y * 8 + y;
-      if (iy >= image_height) {
-        iy = image_height - 1;
+      if (ix >= component->width) {
+        ix = component->width - 1;
       }
-      int16_t value = image_data[(iy * image_width * n_components) +
-                                 (ix * n_components) + component];
-      data_unit[(y * 8) + x] = (value - 128);
+      data_unit[(y * 8) + x] = row[ix] - 128;
     }
   }
 }
 
-// Write the integer [value] of [length] bits to [buffer].
-static void write_int(UtJpegEncoder *self, UtObject *buffer,
-                      size_t value_length, uint16_t value) {
+// Quantize a DCT [coefficient] (scaled by 8) using [quantization_value],
+// rounding to the nearest integer.
+static int16_t quantize(int16_t coefficient, uint8_t quantization_value) {
+  int32_t divisor = quantization_value * 8;
+  if (coefficient < 0) {
+    return -((-coefficient + (divisor / 2)) / divisor);
+  } else {
+    return (coefficient + (divisor / 2)) / divisor;
+  }
+}
+
+// Transform the data unit at [data_unit_x], [data_unit_y] in [component] and
+// write the quantized values into [coefficients] in zigzag order.
+static void quantize_data_unit(UtJpegEncoder *self, JpegComponent *component,
+                               size_t data_unit_x, size_t data_unit_y,
+                               int16_t *coefficients) {
+  int16_t data_unit[64], encoded_data_unit[64];
+
+  // Copy values from image data into data unit.
+  create_data_unit(component, data_unit_x, data_unit_y, data_unit);
+
+  // Perform the discrete cosine transform on the data.
+  jpeg_integer_dct(data_unit, encoded_data_unit);
+
+  // Quantize coefficients and put into zigzag order.
+  const uint8_t *quantization_table_data = ut_uint8_list_get_data(
+      self->quantization_tables[component->quantization_table]);
+  for (size_t i = 0; i < 64; i++) {
+    uint8_t j = self->data_unit_order[i];
+    coefficients[i] =
+        quantize(encoded_data_unit[j], quantization_table_data[j]);
+  }
+}
+
+// Ensure there is space to write [length] more bytes of scan data.
+static void reserve_scan_data(UtJpegEncoder *self, size_t length) {
+  if (self->scan_data_length + length <= self->scan_data_allocated) {
+    return;
+  }
+
+  size_t allocated = self->scan_data_allocated * 2;
+  if (allocated < self->scan_data_length + length) {
+    allocated = self->scan_data_length + length;
+  }
+  self->scan_data = realloc(self->scan_data, allocated);
+  self->scan_data_allocated = allocated;
+}
+
+// Write the integer [value] of [length] bits to the scan data.
+static void write_int(UtJpegEncoder *self, size_t value_length,
+                      uint16_t value) {
   self->bit_buffer = self->bit_buffer << value_length | value;
   self->bit_buffer_length += value_length;
   while (self->bit_buffer_length >= 8) {
-    size_t shift = self->bit_buffer_length - 8;
-    uint8_t byte = self->bit_buffer >> shift;
-    ut_uint8_list_append(buffer, byte);
+    self->bit_buffer_length -= 8;
+    uint8_t byte = self->bit_buffer >> self->bit_buffer_length;
+    self->scan_data[self->scan_data_length++] = byte;
 
     // Stuff zeros in to stop a marker appearing in the data.
     if (byte == 0xff) {
-      ut_uint8_list_append(buffer, 0x00);
+      self->scan_data[self->scan_data_length++] = 0x00;
     }
-
-    self->bit_buffer ^= byte << shift;
-    self->bit_buffer_length -= 8;
   }
+  self->bit_buffer &= ((uint64_t)1 << self->bit_buffer_length) - 1;
 }
 
-// Write remaining partial byte to the buffer.
-static void end_bits(UtJpegEncoder *self, UtObject *buffer) {
+// Write remaining partial byte to the scan data.
+static void end_bits(UtJpegEncoder *self) {
   if (self->bit_buffer_length == 0) {
     return;
   }
 
   // Pad remaining space with 1 bits.
   size_t length = 8 - self->bit_buffer_length;
-  write_int(self, buffer, length, 0xff >> self->bit_buffer_length);
+  write_int(self, length, 0xff >> self->bit_buffer_length);
 }
 
-// Write [amplitude] using [length] bits to [buffer].
-static void write_amplitude(UtJpegEncoder *self, UtObject *buffer,
-                            size_t length, int16_t amplitude) {
+// Write [amplitude] using [length] bits to the scan data.
+static void write_amplitude(UtJpegEncoder *self, size_t length,
+                            int16_t amplitude) {
+  if (length == 0 || self->counting) {
+    return;
+  }
+
   // Upper half of values are positive, lower half are negative, i.e.
   // 0 bits:  0
   // 1 bit:  -1, 1
@@ -195,7 +531,7 @@ static void write_amplitude(UtJpegEncoder *self, UtObject *buffer,
   } else {
     value = amplitude + (min_amplitude * 2) - 1;
   }
-  write_int(self, buffer, length, value);
+  write_int(self, length, value);
 }
 
 // Get the number of bits required to encode [amplitude].
@@ -213,46 +549,144 @@ static size_t get_amplitude_length(int16_t amplitude) {
   return length;
 }
 
-static uint16_t get_symbol(UtObject *symbols, uint8_t value) {
-  for (size_t i = 0; i < ut_list_get_length(symbols); i++) {
-    if (ut_uint8_list_get_element(symbols, i) == value) {
-      return i;
-    }
+static void write_huffman_code(UtJpegEncoder *self, HuffmanCodes *codes,
+                               uint8_t value) {
+  if (self->counting) {
+    codes->frequencies[value]++;
+    return;
   }
 
-  assert(false);
-}
-
-static void write_huffman_code(UtJpegEncoder *self, UtObject *buffer,
-                               UtObject *symbols, UtObject *encoder,
-                               uint8_t value) {
-  uint16_t symbol = get_symbol(symbols, value);
-  uint16_t code;
-  size_t code_width;
-  ut_huffman_encoder_get_code(encoder, symbol, &code, &code_width);
-  write_int(self, buffer, code_width, code);
+  assert(codes->code_widths[value] != 0);
+  write_int(self, codes->code_widths[value], codes->codes[value]);
 }
 
-static void write_dc_coefficient(UtJpegEncoder *self, UtObject *buffer,
-                                 UtObject *symbols, UtObject *encoder,
+static void write_dc_coefficient(UtJpegEncoder *self, HuffmanCodes *codes,
                                  int16_t diff) {
   size_t length = get_amplitude_length(diff);
-  write_huffman_code(self, buffer, symbols, encoder, length);
-  write_amplitude(self, buffer, length, diff);
+  write_huffman_code(self, codes, length);
+  write_amplitude(self, length, diff);
 }
 
-static void write_ac_coefficient(UtJpegEncoder *self, UtObject *buffer,
-                                 UtObject *symbols, UtObject *encoder,
+static void write_ac_coefficient(UtJpegEncoder *self, HuffmanCodes *codes,
                                  size_t run_length, int16_t coefficient) {
   size_t length = get_amplitude_length(coefficient);
-  write_huffman_code(self, buffer, symbols, encoder,
-                     (run_length << 4) | length);
-  write_amplitude(self, buffer, length, coefficient);
+  write_huffman_code(self, codes, (run_length << 4) | length);
+  write_amplitude(self, length, coefficient);
+}
+
+static void write_eob(UtJpegEncoder *self, HuffmanCodes *codes) {
+  write_huffman_code(self, codes, 0);
+}
+
+// Write the quantized [coefficients] of a data unit from [component].
+static void write_data_unit(UtJpegEncoder *self, JpegComponent *component,
+                            const int16_t *coefficients) {
+  HuffmanCodes *dc_codes = &self->dc_codes[component->dc_table];
+  HuffmanCodes *ac_codes = &self->ac_codes[component->ac_table];
+
+  if (!self->counting) {
+    reserve_scan_data(self, MAX_DATA_UNIT_LENGTH);
+  }
+
+  int16_t dc = coefficients[0];
+  int16_t diff = dc - component->previous_dc;
+  component->previous_dc = dc;
+  write_dc_coefficient(self, dc_codes, diff);
+  for (size_t i = 1; i < 64;) {
+    // Count number of zeros before the next coefficient.
+    size_t run_length = 0;
+    while (i + run_length < 64 && coefficients[i + run_length] == 0) {
+      run_length++;
+    }
+
+    if (i + run_length >= 64) {
+      write_eob(self, ac_codes);
+      i = 64;
+    } else if (run_length <= 15) {
+      write_ac_coefficient(self, ac_codes, run_length,
+                           coefficients[i + run_length]);
+      i += run_length + 1;
+    } else {
+      write_ac_coefficient(self, ac_codes, 15, 0);
+      i += 16;
+    }
+  }
 }
 
-static void write_eob(UtJpegEncoder *self, UtObject *buffer, UtObject *symbols,
-                      UtObject *encoder) {
-  write_huffman_code(self, buffer, symbols, encoder, 0);
+// Write all the data units in the image in MCU order. If [stored_coefficients]
+// is not NULL, the quantized coefficients are written into it if [quantize] is
+// true, otherwise they are read from it.
+static void write_data_units(UtJpegEncoder *self, int16_t *stored_coefficients,
+                             bool quantize) {
+  uint16_t image_width = ut_jpeg_image_get_width(self->image);
+  uint16_t image_height = ut_jpeg_image_get_height(self->image);
+  size_t mcu_width = self->max_horizontal_sampling_factor * 8;
+  size_t mcu_height = self->max_vertical_sampling_factor * 8;
+  size_t width_in_mcus = (image_width + mcu_width - 1) / mcu_width;
+  size_t height_in_mcus = (image_height + mcu_height - 1) / mcu_height;
+
+  for (size_t i = 0; i < self->n_components; i++) {
+    self->components[i].previous_dc = 0;
+  }
+
+  int16_t *coefficients = stored_coefficients;
+  for (size_t mcu_y = 0; mcu_y < height_in_mcus; mcu_y++) {
+    for (size_t mcu_x = 0; mcu_x < width_in_mcus; mcu_x++) {
+      for (size_t i = 0; i < self->n_components; i++) {
+        JpegComponent *component = &self->components[i];
+        size_t h = component->horizontal_sampling_factor;
+        size_t v = component->vertical_sampling_factor;
+        for (size_t y = 0; y < v; y++) {
+          for (size_t x = 0; x < h; x++) {
+            int16_t data_unit_coefficients[64];
+            if (stored_coefficients == NULL) {
+              coefficients = data_unit_coefficients;
+            }
+            if (quantize) {
+              quantize_data_unit(self, component, mcu_x * h + x,
+                                 mcu_y * v + y, coefficients);
+            }
+            write_data_unit(self, component, coefficients);
+            if (stored_coefficients != NULL) {
+              coefficients += 64;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Quantize the image and replace the Huffman tables with ones optimized for
+// the symbols used.
+static void optimize_huffman_tables(UtJpegEncoder *self) {
+  uint16_t image_width = ut_jpeg_image_get_width(self->image);
+  uint16_t image_height = ut_jpeg_image_get_height(self->image);
+  size_t mcu_width = self->max_horizontal_sampling_factor * 8;
+  size_t mcu_height = self->max_vertical_sampling_factor * 8;
+  size_t n_mcus = ((image_width + mcu_width - 1) / mcu_width) *
+                  ((image_height + mcu_height - 1) / mcu_height);
+  size_t n_data_units = 0;
+  for (size_t i = 0; i < self->n_components; i++) {
+    n_data_units += self->components[i].horizontal_sampling_factor *
+                    self->components[i].vertical_sampling_factor * n_mcus;
+  }
+
+  // Keep the coefficients so they don't need to be calculated again when
+  // writing.
+  self->coefficients = malloc(sizeof(int16_t) * 64 * n_data_units);
+  self->counting = true;
+  write_data_units(self, self->coefficients, true);
+  self->counting = false;
+
+  for (size_t i = 0; i < 2; i++) {
+    if (self->dc_encoders[i] != NULL) {
+      build_optimal_huffman_table(&self->dc_codes[i], &self->dc_symbols[i],
+                                  &self->dc_encoders[i]);
+      build_optimal_huffman_table(&self->ac_codes[i], &self->ac_symbols[i],
+                                  &self->ac_encoders[i]);
+    }
+  }
 }
 
 static void write_marker(UtObject *buffer, uint8_t value) {
@@ -343,15 +777,13 @@ static void write_start_of_frame(UtJpegEncoder *self) {
   ut_uint8_list_append_uint16_be(sof, image_width);
   ut_uint8_list_append(sof, n_components);
   for (size_t i = 0; i < n_components; i++) {
+    JpegComponent *component = &self->components[i];
     uint8_t id = i;
-    uint8_t horizontal_sampling_factor = 1;
-    uint8_t vertical_sampling_factor = 1;
-    uint8_t quantization_table = 0; // FIXME
 
     ut_uint8_list_append(sof, id);
-    ut_uint8_list_append(sof, horizontal_sampling_factor << 4 |
-                                  vertical_sampling_factor);
-    ut_uint8_list_append(sof, quantization_table);
+    ut_uint8_list_append(sof, component->horizontal_sampling_factor << 4 |
+                                  component->vertical_sampling_factor);
+    ut_uint8_list_append(sof, component->quantization_table);
   }
   ut_output_stream_write(self->output_stream, sof);
 }
@@ -416,100 +848,43 @@ static void write_define_huffman_table(UtJpegEncoder *self) {
 }
 
 static void write_start_of_scan(UtJpegEncoder *self) {
-  size_t image_width = ut_jpeg_image_get_width(self->image);
-  size_t image_height = ut_jpeg_image_get_height(self->image);
-  size_t n_components = ut_jpeg_image_get_n_components(self->image);
+  size_t n_components = self->n_components;
 
-  size_t length = 3 + 5 * n_components;
+  uint8_t selection_start = 0;
+  uint8_t selection_end = 63;
+  uint8_t successive_approximation = 0;
+
+  size_t length = 6 + 2 * n_components;
 
   UtObjectRef sos = ut_uint8_list_new();
   write_marker(sos, 0xda);
   ut_uint8_list_append_uint16_be(sos, length);
   ut_uint8_list_append(sos, n_components);
   for (size_t i = 0; i < n_components; i++) {
-    uint8_t component_selector = i; // FIXME
-    uint8_t dc_table = 0;           // FIXME
-    uint8_t ac_table = 0;           // FIXME
-    uint8_t selection_start = 0;
-    uint8_t selection_end = 63;
-    uint8_t successive_approximation = 0;
+    JpegComponent *component = &self->components[i];
+    uint8_t component_selector = i;
 
     ut_uint8_list_append(sos, component_selector);
-    ut_uint8_list_append(sos, dc_table << 4 | ac_table);
-    ut_uint8_list_append(sos, selection_start);
-    ut_uint8_list_append(sos, selection_end);
-    ut_uint8_list_append(sos, successive_approximation);
-  }
-
-  size_t width_in_data_units = (image_width + 7) / 8;
-  size_t height_in_data_units = (image_height + 7) / 8;
-  int16_t previous_dc = 0;
-  for (size_t component = 0; component < n_components; component++) {
-    uint8_t quantization_table_index = 0; // FIXME
-    uint8_t dc_table = 0;                 // FIXME
-    uint8_t ac_table = 0;                 // FIXME
-
-    UtObject *quantization_table =
-        self->quantization_tables[quantization_table_index];
-    UtObject *dc_symbols = self->dc_symbols[dc_table];
-    UtObject *dc_encoder = self->dc_encoders[dc_table];
-    UtObject *ac_symbols = self->ac_symbols[ac_table];
-    UtObject *ac_encoder = self->ac_encoders[ac_table];
-
-    const uint8_t *quantization_table_data =
-        ut_uint8_list_get_data(quantization_table);
-
-    for (size_t y = 0; y < height_in_data_units; y++) {
-      for (size_t x = 0; x < width_in_data_units; x++) {
-        int16_t data_unit[64], coefficients[64];
-        float encoded_data_unit[64];
-
-        // Copy values from image data into data unit.
-        create_data_unit(self, x, y, component, data_unit);
-
-        // Perform the discrete cosine transform on the data.
-        jpeg_dct(self->dct_alpha, self->dct_cos, data_unit, encoded_data_unit);
-
-        // Quantize coefficients and put into zigzag order.
-        for (size_t i = 0; i < 64; i++) {
-          uint8_t j = self->data_unit_order[i];
-          coefficients[i] =
-              round(encoded_data_unit[j] / (float)quantization_table_data[j]);
-        }
-
-        // Write out coefficients.
-        int16_t dc = coefficients[0];
-        int16_t diff = dc - previous_dc;
-        previous_dc = dc;
-        write_dc_coefficient(self, sos, dc_symbols, dc_encoder, diff);
-        for (size_t i = 1; i < 64;) {
-          // Count number of zeros before the next coefficient.
-          size_t run_length = 0;
-          while (coefficients[i + run_length] == 0 && i + run_length < 64) {
-            run_length++;
-          }
-
-          if (i + run_length >= 64) {
-            write_eob(self, sos, ac_symbols, ac_encoder);
-            i = 64;
-          } else if (run_length <= 15) {
-            write_ac_coefficient(self, sos, ac_symbols, ac_encoder, run_length,
-                                 coefficients[i + run_length]);
-            i += run_length + 1;
-          } else {
-            write_ac_coefficient(self, sos, ac_symbols, ac_encoder, 15, 0);
-            i += 16;
-          }
-        }
-      }
-    }
+    ut_uint8_list_append(sos, component->dc_table << 4 | component->ac_table);
   }
+  ut_uint8_list_append(sos, selection_start);
+  ut_uint8_list_append(sos, selection_end);
+  ut_uint8_list_append(sos, successive_approximation);
+  ut_output_stream_write(self->output_stream, sos);
+
+  // Write the entropy coded data into a buffer that grows as required.
+  self->scan_data_length = 0;
+  self->bit_buffer = 0;
+  self->bit_buffer_length = 0;
+  write_data_units(self, self->coefficients, self->coefficients == NULL);
 
   // Write any partially complete byte.
-  end_bits(self, sos);
+  reserve_scan_data(self, 2);
+  end_bits(self);
 
-  // FIXME: Write data unit bytes as they are written.
-  ut_output_stream_write(self->output_stream, sos);
+  UtObjectRef scan_data =
+      ut_uint8_array_new_from_data(self->scan_data, self->scan_data_length);
+  ut_output_stream_write(self->output_stream, scan_data);
 }
 
 static void write_end_of_image(UtJpegEncoder *self) {
@@ -531,6 +906,11 @@ static void ut_jpeg_encoder_cleanup(UtObject *object) {
     ut_object_unref(self->ac_symbols[i]);
     ut_object_unref(self->ac_encoders[i]);
   }
+  for (size_t i = 0; i < self->n_components; i++) {
+    free(self->components[i].samples);
+  }
+  free(self->coefficients);
+  free(self->scan_data);
 }
 
 static UtObjectInterface object_interface = {
@@ -541,18 +921,46 @@ UtObject *ut_jpeg_encoder_new(UtObject *image, UtObject *output_stream) {
   UtJpegEncoder *self = (UtJpegEncoder *)object;
   self->image = ut_object_ref(image);
   self->output_stream = ut_object_ref(output_stream);
+  self->quality = 50;
+  self->chroma_subsampling = UT_JPEG_CHROMA_SUBSAMPLING_444;
 
-  build_tables(self);
   jpeg_build_data_unit_order(self->data_unit_order);
-  jpeg_build_dct_values(self->dct_alpha, self->dct_cos);
 
   return object;
 }
 
+void ut_jpeg_encoder_set_quality(UtObject *object, uint8_t quality) {
+  assert(ut_object_is_jpeg_encoder(object));
+  UtJpegEncoder *self = (UtJpegEncoder *)object;
+  assert(quality >= 1 && quality <= 100);
+  self->quality = quality;
+}
+
+void ut_jpeg_encoder_set_chroma_subsampling(
+    UtObject *object, UtJpegChromaSubsampling chroma_subsampling) {
+  assert(ut_object_is_jpeg_encoder(object));
+  UtJpegEncoder *self = (UtJpegEncoder *)object;
+  self->chroma_subsampling = chroma_subsampling;
+}
+
+void ut_jpeg_encoder_set_optimize_huffman_tables(UtObject *object,
+                                                 bool optimize) {
+  assert(ut_object_is_jpeg_encoder(object));
+  UtJpegEncoder *self = (UtJpegEncoder *)object;
+  self->optimize_huffman_tables = optimize;
+}
+
 void ut_jpeg_encoder_encode(UtObject *object) {
   assert(ut_object_is_jpeg_encoder(object));
   UtJpegEncoder *self = (UtJpegEncoder *)object;
 
+  assert(self->n_components == 0);
+  build_components(self);
+  build_tables(self);
+  if (self->optimize_huffman_tables) {
+    optimize_huffman_tables(self);
+  }
+
   write_start_of_image(self);
   write_app0(self);
   write_define_quantization_table(self);
@@ -1,9 +1,22 @@
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "ut-object.h"
 
 #pragma once
 
+/// Chroma subsampling used when encoding color images:
+/// - [UT_JPEG_CHROMA_SUBSAMPLING_444] - chrominance at full resolution.
+/// - [UT_JPEG_CHROMA_SUBSAMPLING_422] - chrominance at half horizontal
+///   resolution.
+/// - [UT_JPEG_CHROMA_SUBSAMPLING_420] - chrominance at half horizontal and
+///   vertical resolution.
+typedef enum {
+  UT_JPEG_CHROMA_SUBSAMPLING_444,
+  UT_JPEG_CHROMA_SUBSAMPLING_422,
+  UT_JPEG_CHROMA_SUBSAMPLING_420
+} UtJpegChromaSubsampling;
+
 /// Creates a new JPEG encoder to write [image] to [output_stream].
 ///
 /// !arg-type image UtJpegImage
@@ -12,6 +25,22 @@
 /// !return-type UtJpegEncoder
 UtObject *ut_jpeg_encoder_new(UtObject *image, UtObject *output_stream);
 
+/// Sets the [quality] of the encoded image from 1 to 100. The standard
+/// quantization tables are scaled, with lower values giving smaller images.
+/// Defaults to 50, which uses the standard tables unchanged.
+void ut_jpeg_encoder_set_quality(UtObject *object, uint8_t quality);
+
+/// Sets the [chroma_subsampling] used for color images. Defaults to
+/// [UT_JPEG_CHROMA_SUBSAMPLING_444].
+void ut_jpeg_encoder_set_chroma_subsampling(
+    UtObject *object, UtJpegChromaSubsampling chroma_subsampling);
+
+/// Sets if Huffman tables are generated to [optimize] the size of the image.
+/// This requires the image to be processed twice. Defaults to [false], which
+/// uses the standard tables.
+void ut_jpeg_encoder_set_optimize_huffman_tables(UtObject *object,
+                                                 bool optimize);
+
 /// Start encoding.
 void ut_jpeg_encoder_encode(UtObject *object);
 
@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <stdint.h>
 
 // Precaclulate order values are entered into a data unit.
@@ -15,3 +16,56 @@ void jpeg_dct(float *dct_alpha, float *dct_cos, const int16_t *data_unit,
 // [data_unit].
 void jpeg_inverse_dct(float *dct_alpha, float *dct_cos,
                       const int16_t *encoded_data_unit, int16_t *data_unit);
+
+// Perform fixed point discrete cosine transform on [data_unit] and write to
+// [coefficients]. The coefficients are scaled up by a factor of 8.
+void jpeg_integer_dct(const int16_t *data_unit, int16_t *coefficients);
+
+// Perform fixed point inverse discrete cosine transform on [coefficients] and
+// write to [data_unit].
+void jpeg_integer_inverse_dct(const int16_t *coefficients, int16_t *data_unit);
+
+// One implementation of the fixed point transforms.
+typedef struct {
+  const char *name;
+  void (*dct)(const int16_t *data_unit, int16_t *coefficients);
+  void (*inverse_dct)(const int16_t *coefficients, int16_t *data_unit);
+} JpegDctFunctions;
+
+// Get the implementations of the fixed point transforms this CPU supports, so
+// they can be tested against each other. The first is the scalar
+// implementation and the last the one used by jpeg_integer_dct and
+// jpeg_integer_inverse_dct. Returns the number of implementations.
+size_t jpeg_get_dct_functions(const JpegDctFunctions **functions);
+
+// Perform fixed point inverse discrete cosine transform on [coefficients] and
+// write a 4x4, 2x2 or 1x1 data unit to [data_unit]. The result is the image
+// scaled down by 2, 4 or 8 respectively.
+void jpeg_integer_inverse_dct_4x4(const int16_t *coefficients,
+                                  int16_t *data_unit);
+void jpeg_integer_inverse_dct_2x2(const int16_t *coefficients,
+                                  int16_t *data_unit);
+void jpeg_integer_inverse_dct_1x1(const int16_t *coefficients,
+                                  int16_t *data_unit);
+
+// Convert [width] pixels from the [y], [cb] and [cr] sample rows to
+// interleaved RGB values in [rgb].
+void jpeg_ycbcr_to_rgb(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                       uint8_t *rgb, size_t width);
+
+// One implementation of the YCbCr to RGB conversion.
+typedef struct {
+  const char *name;
+  void (*ycbcr_to_rgb)(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                       uint8_t *rgb, size_t width);
+} JpegColorFunctions;
+
+// Get the implementations of the YCbCr to RGB conversion this CPU supports.
+// The first is the scalar implementation and the last the one used by
+// jpeg_ycbcr_to_rgb. Returns the number of implementations.
+size_t jpeg_get_color_functions(const JpegColorFunctions **functions);
+
+// Convert [width] interleaved RGB pixels in [rgb] to the [y], [cb] and [cr]
+// sample rows.
+void jpeg_rgb_to_ycbcr(const uint8_t *rgb, uint8_t *y, uint8_t *cb,
+                       uint8_t *cr, size_t width);
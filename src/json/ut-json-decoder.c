@@ -0,0 +1,757 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ut.h"
+
+typedef enum {
+  DECODER_STATE_VALUE,
+  DECODER_STATE_ARRAY_FIRST_VALUE,
+  DECODER_STATE_OBJECT_FIRST_KEY,
+  DECODER_STATE_OBJECT_KEY,
+  DECODER_STATE_OBJECT_COLON,
+  DECODER_STATE_AFTER_VALUE,
+  DECODER_STATE_STRING,
+  DECODER_STATE_STRING_ESCAPE,
+  DECODER_STATE_STRING_UNICODE_ESCAPE,
+  DECODER_STATE_NUMBER,
+  DECODER_STATE_KEYWORD,
+  DECODER_STATE_ERROR,
+  DECODER_STATE_END
+} DecoderState;
+
+typedef struct {
+  UtObject object;
+
+  // Input stream being read.
+  UtObject *input_stream;
+
+  // Callbacks to notify with events.
+  UtObject *callback_object;
+  const UtJsonDecoderCallbacks *callbacks;
+
+  // Current state of the decoder.
+  DecoderState state;
+
+  // Open containers, either '{' or '['.
+  UtObject *stack;
+
+  // Number of top level values decoded.
+  size_t n_values;
+
+  // Number of bytes processed.
+  size_t offset;
+
+  // True if the string being decoded is an object key.
+  bool is_key;
+
+  // Decoded string data not yet emitted.
+  UtObject *string_buffer;
+
+  // Number of continuation bytes remaining in the current UTF-8 sequence and
+  // the number of bytes of that sequence already in [string_buffer].
+  size_t utf8_remaining;
+  size_t utf8_length;
+
+  // Hex digits of a \u escape.
+  uint32_t escape_value;
+  size_t escape_length;
+
+  // High surrogate waiting for a low surrogate escape.
+  uint32_t high_surrogate;
+
+  // Text of a number or keyword being decoded.
+  UtObject *token;
+
+  // Error that occurred during decoding.
+  UtObject *error;
+} UtJsonDecoder;
+
+static bool is_whitespace(uint8_t c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool is_number_character(uint8_t c) {
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+         c == 'e' || c == 'E';
+}
+
+static int decode_hex(uint8_t c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  } else {
+    return -1;
+  }
+}
+
+static void notify_complete(UtJsonDecoder *self) {
+  ut_input_stream_close(self->input_stream);
+  if (self->callback_object != NULL && self->callbacks->complete != NULL) {
+    self->callbacks->complete(self->callback_object);
+  }
+}
+
+static void set_error(UtJsonDecoder *self, const char *description) {
+  if (self->state == DECODER_STATE_ERROR) {
+    return;
+  }
+
+  self->error = ut_json_error_new(description);
+  self->state = DECODER_STATE_ERROR;
+  notify_complete(self);
+}
+
+static void set_error_take(UtJsonDecoder *self, char *description) {
+  set_error(self, description);
+  free(description);
+}
+
+static void set_unexpected_character_error(UtJsonDecoder *self, uint8_t c) {
+  set_error_take(self, ut_cstring_new_printf(
+                           "Unexpected character 0x%02x at offset %zi", c,
+                           self->offset));
+}
+
+static void set_end(UtJsonDecoder *self) {
+  self->state = DECODER_STATE_END;
+  notify_complete(self);
+}
+
+static void append_code_point(UtObject *buffer, uint32_t code_point) {
+  if (code_point <= 0x7f) {
+    ut_uint8_list_append(buffer, code_point);
+  } else if (code_point <= 0x7ff) {
+    uint8_t data[2] = {0xc0 | (code_point >> 6), 0x80 | (code_point & 0x3f)};
+    ut_uint8_list_append_block(buffer, data, 2);
+  } else if (code_point <= 0xffff) {
+    uint8_t data[3] = {0xe0 | (code_point >> 12),
+                       0x80 | ((code_point >> 6) & 0x3f),
+                       0x80 | (code_point & 0x3f)};
+    ut_uint8_list_append_block(buffer, data, 3);
+  } else {
+    uint8_t data[4] = {0xf0 | (code_point >> 18),
+                       0x80 | ((code_point >> 12) & 0x3f),
+                       0x80 | ((code_point >> 6) & 0x3f),
+                       0x80 | (code_point & 0x3f)};
+    ut_uint8_list_append_block(buffer, data, 4);
+  }
+}
+
+// Replace an unpaired high surrogate with the replacement character.
+static void flush_high_surrogate(UtJsonDecoder *self) {
+  if (self->high_surrogate != 0) {
+    append_code_point(self->string_buffer, 0xfffd);
+    self->high_surrogate = 0;
+  }
+}
+
+static void emit_object_start(UtJsonDecoder *self) {
+  if (self->callback_object != NULL && self->callbacks->object_start != NULL) {
+    self->callbacks->object_start(self->callback_object);
+  }
+}
+
+static void emit_object_end(UtJsonDecoder *self) {
+  if (self->callback_object != NULL && self->callbacks->object_end != NULL) {
+    self->callbacks->object_end(self->callback_object);
+  }
+}
+
+static void emit_array_start(UtJsonDecoder *self) {
+  if (self->callback_object != NULL && self->callbacks->array_start != NULL) {
+    self->callbacks->array_start(self->callback_object);
+  }
+}
+
+static void emit_array_end(UtJsonDecoder *self) {
+  if (self->callback_object != NULL && self->callbacks->array_end != NULL) {
+    self->callbacks->array_end(self->callback_object);
+  }
+}
+
+// Emit the first [length] bytes of the string buffer.
+static void emit_string(UtJsonDecoder *self, size_t length, bool complete) {
+  if (self->callback_object != NULL && self->callbacks->string != NULL) {
+    const char *text =
+        length > 0 ? (const char *)ut_uint8_list_get_data(self->string_buffer)
+                   : "";
+    self->callbacks->string(self->callback_object, text, length, complete);
+  }
+  ut_list_remove(self->string_buffer, 0, length);
+}
+
+static void emit_key(UtJsonDecoder *self) {
+  ut_uint8_list_append(self->string_buffer, '\0');
+  if (self->callback_object != NULL && self->callbacks->key != NULL) {
+    const char *key = (const char *)ut_uint8_list_get_data(self->string_buffer);
+    self->callbacks->key(self->callback_object, key);
+  }
+  ut_list_resize(self->string_buffer, 0);
+}
+
+static size_t get_stack_depth(UtJsonDecoder *self) {
+  return ut_list_get_length(self->stack);
+}
+
+static uint8_t get_container(UtJsonDecoder *self) {
+  size_t depth = get_stack_depth(self);
+  return depth > 0 ? ut_uint8_list_get_element(self->stack, depth - 1) : '\0';
+}
+
+static void push_container(UtJsonDecoder *self, uint8_t container) {
+  ut_uint8_list_append(self->stack, container);
+}
+
+static void pop_container(UtJsonDecoder *self) {
+  ut_list_remove(self->stack, get_stack_depth(self) - 1, 1);
+}
+
+static void value_complete(UtJsonDecoder *self) {
+  if (get_stack_depth(self) == 0) {
+    self->n_values++;
+  }
+  self->state = DECODER_STATE_AFTER_VALUE;
+}
+
+static void start_string(UtJsonDecoder *self, bool is_key) {
+  self->is_key = is_key;
+  self->utf8_remaining = 0;
+  self->utf8_length = 0;
+  self->high_surrogate = 0;
+  self->state = DECODER_STATE_STRING;
+}
+
+static void end_string(UtJsonDecoder *self) {
+  flush_high_surrogate(self);
+  if (self->is_key) {
+    emit_key(self);
+    self->state = DECODER_STATE_OBJECT_COLON;
+  } else {
+    emit_string(self, ut_list_get_length(self->string_buffer), true);
+    value_complete(self);
+  }
+}
+
+// Returns true if [text] matches the JSON number grammar.
+// [is_float] is set if the number contains a fraction or exponent.
+static bool validate_number(const char *text, bool *is_float) {
+  const char *c = text;
+  if (*c == '-') {
+    c++;
+  }
+  if (*c == '0') {
+    c++;
+  } else if (*c >= '1' && *c <= '9') {
+    while (*c >= '0' && *c <= '9') {
+      c++;
+    }
+  } else {
+    return false;
+  }
+
+  *is_float = false;
+  if (*c == '.') {
+    c++;
+    *is_float = true;
+    if (!(*c >= '0' && *c <= '9')) {
+      return false;
+    }
+    while (*c >= '0' && *c <= '9') {
+      c++;
+    }
+  }
+  if (*c == 'e' || *c == 'E') {
+    c++;
+    *is_float = true;
+    if (*c == '+' || *c == '-') {
+      c++;
+    }
+    if (!(*c >= '0' && *c <= '9')) {
+      return false;
+    }
+    while (*c >= '0' && *c <= '9') {
+      c++;
+    }
+  }
+
+  return *c == '\0';
+}
+
+static void end_number(UtJsonDecoder *self) {
+  ut_uint8_list_append(self->token, '\0');
+  const char *text = (const char *)ut_uint8_list_get_data(self->token);
+
+  bool is_float;
+  if (!validate_number(text, &is_float)) {
+    set_error_take(self, ut_cstring_new_printf("Invalid number \"%s\"", text));
+    return;
+  }
+
+  int64_t int_value = 0;
+  if (!is_float) {
+    errno = 0;
+    int_value = strtoll(text, NULL, 10);
+    // Integers that don't fit are returned as floating point.
+    is_float = errno == ERANGE;
+  }
+  if (is_float) {
+    double value = strtod(text, NULL);
+    if (self->callback_object != NULL && self->callbacks->float64 != NULL) {
+      self->callbacks->float64(self->callback_object, value);
+    }
+  } else {
+    if (self->callback_object != NULL && self->callbacks->int64 != NULL) {
+      self->callbacks->int64(self->callback_object, int_value);
+    }
+  }
+  ut_list_resize(self->token, 0);
+
+  value_complete(self);
+}
+
+static void end_keyword(UtJsonDecoder *self) {
+  ut_uint8_list_append(self->token, '\0');
+  const char *text = (const char *)ut_uint8_list_get_data(self->token);
+
+  if (ut_cstring_equal(text, "true") || ut_cstring_equal(text, "false")) {
+    if (self->callback_object != NULL && self->callbacks->boolean != NULL) {
+      self->callbacks->boolean(self->callback_object, text[0] == 't');
+    }
+  } else if (ut_cstring_equal(text, "null")) {
+    if (self->callback_object != NULL && self->callbacks->null != NULL) {
+      self->callbacks->null(self->callback_object);
+    }
+  } else {
+    set_error_take(self, ut_cstring_new_printf("Unknown keyword \"%s\"", text));
+    return;
+  }
+  ut_list_resize(self->token, 0);
+
+  value_complete(self);
+}
+
+// Decode a run of unescaped string characters from [data].
+// Returns the number of bytes used.
+static size_t decode_string_data(UtJsonDecoder *self, const uint8_t *data,
+                                 size_t data_length) {
+  size_t length = 0;
+  while (length < data_length) {
+    uint8_t c = data[length];
+    if (c == '"' || c == '\\' || c <= 0x1f || c == 0x7f) {
+      break;
+    }
+
+    if (c < 0x80) {
+      if (self->utf8_remaining != 0) {
+        set_error(self, "Invalid UTF-8 in string");
+        return length;
+      }
+    } else if ((c & 0xc0) == 0x80) {
+      if (self->utf8_remaining == 0) {
+        set_error(self, "Invalid UTF-8 in string");
+        return length;
+      }
+      self->utf8_remaining--;
+      self->utf8_length++;
+    } else {
+      if (self->utf8_remaining != 0) {
+        set_error(self, "Invalid UTF-8 in string");
+        return length;
+      }
+      if ((c & 0xe0) == 0xc0) {
+        self->utf8_remaining = 1;
+      } else if ((c & 0xf0) == 0xe0) {
+        self->utf8_remaining = 2;
+      } else if ((c & 0xf8) == 0xf0) {
+        self->utf8_remaining = 3;
+      } else {
+        set_error(self, "Invalid UTF-8 in string");
+        return length;
+      }
+      self->utf8_length = 1;
+    }
+
+    length++;
+  }
+
+  if (length > 0) {
+    flush_high_surrogate(self);
+    ut_uint8_list_append_block(self->string_buffer, data, length);
+  }
+
+  if (length == data_length) {
+    return length;
+  }
+
+  uint8_t c = data[length];
+  if (self->utf8_remaining != 0) {
+    set_error(self, "Invalid UTF-8 in string");
+    return length;
+  }
+  if (c == '"') {
+    end_string(self);
+  } else if (c == '\\') {
+    self->state = DECODER_STATE_STRING_ESCAPE;
+  } else {
+    set_error(self, "Control character in string");
+    return length;
+  }
+
+  return length + 1;
+}
+
+static void decode_escape(UtJsonDecoder *self, uint8_t c) {
+  if (c == 'u') {
+    self->escape_value = 0;
+    self->escape_length = 0;
+    self->state = DECODER_STATE_STRING_UNICODE_ESCAPE;
+    return;
+  }
+
+  uint32_t code_point;
+  switch (c) {
+  case '"':
+    code_point = '"';
+    break;
+  case '\\':
+    code_point = '\\';
+    break;
+  case '/':
+    code_point = '/';
+    break;
+  case 'b':
+    code_point = '\b';
+    break;
+  case 'f':
+    code_point = '\f';
+    break;
+  case 'n':
+    code_point = '\n';
+    break;
+  case 'r':
+    code_point = '\r';
+    break;
+  case 't':
+    code_point = '\t';
+    break;
+  default:
+    set_error(self, "Unknown escape sequence in string");
+    return;
+  }
+
+  flush_high_surrogate(self);
+  append_code_point(self->string_buffer, code_point);
+  self->state = DECODER_STATE_STRING;
+}
+
+static void decode_unicode_escape(UtJsonDecoder *self, uint8_t c) {
+  int hex = decode_hex(c);
+  if (hex < 0) {
+    set_error(self, "Invalid unicode escape sequence in string");
+    return;
+  }
+  self->escape_value = self->escape_value << 4 | hex;
+  self->escape_length++;
+  if (self->escape_length < 4) {
+    return;
+  }
+
+  uint32_t code_point = self->escape_value;
+  if (code_point >= 0xd800 && code_point <= 0xdbff) {
+    flush_high_surrogate(self);
+    self->high_surrogate = code_point;
+  } else if (code_point >= 0xdc00 && code_point <= 0xdfff) {
+    if (self->high_surrogate != 0) {
+      append_code_point(self->string_buffer,
+                        0x10000 + ((self->high_surrogate - 0xd800) << 10) +
+                            (code_point - 0xdc00));
+      self->high_surrogate = 0;
+    } else {
+      append_code_point(self->string_buffer, 0xfffd);
+    }
+  } else {
+    flush_high_surrogate(self);
+    append_code_point(self->string_buffer, code_point);
+  }
+  self->state = DECODER_STATE_STRING;
+}
+
+static void start_value(UtJsonDecoder *self, uint8_t c) {
+  if (c == '"') {
+    start_string(self, false);
+  } else if (c == '-' || (c >= '0' && c <= '9')) {
+    ut_uint8_list_append(self->token, c);
+    self->state = DECODER_STATE_NUMBER;
+  } else if (c == '{') {
+    push_container(self, '{');
+    emit_object_start(self);
+    self->state = DECODER_STATE_OBJECT_FIRST_KEY;
+  } else if (c == '[') {
+    push_container(self, '[');
+    emit_array_start(self);
+    self->state = DECODER_STATE_ARRAY_FIRST_VALUE;
+  } else if (c >= 'a' && c <= 'z') {
+    ut_uint8_list_append(self->token, c);
+    self->state = DECODER_STATE_KEYWORD;
+  } else {
+    set_unexpected_character_error(self, c);
+  }
+}
+
+static void end_object(UtJsonDecoder *self) {
+  pop_container(self);
+  emit_object_end(self);
+  value_complete(self);
+}
+
+static void end_array(UtJsonDecoder *self) {
+  pop_container(self);
+  emit_array_end(self);
+  value_complete(self);
+}
+
+static void decode_after_value(UtJsonDecoder *self, uint8_t c) {
+  uint8_t container = get_container(self);
+  if (container == '[' && c == ',') {
+    self->state = DECODER_STATE_VALUE;
+  } else if (container == '[' && c == ']') {
+    end_array(self);
+  } else if (container == '{' && c == ',') {
+    self->state = DECODER_STATE_OBJECT_KEY;
+  } else if (container == '{' && c == '}') {
+    end_object(self);
+  } else if (container == '\0') {
+    // Another top level value.
+    start_value(self, c);
+  } else {
+    set_unexpected_character_error(self, c);
+  }
+}
+
+// Decode a single byte [c] outside of string data.
+// Returns false if [c] terminated a token and needs to be processed again.
+static bool decode_byte(UtJsonDecoder *self, uint8_t c) {
+  switch (self->state) {
+  case DECODER_STATE_NUMBER:
+    if (is_number_character(c)) {
+      ut_uint8_list_append(self->token, c);
+      return true;
+    }
+    end_number(self);
+    return false;
+  case DECODER_STATE_KEYWORD:
+    if (c >= 'a' && c <= 'z' && ut_list_get_length(self->token) < 5) {
+      ut_uint8_list_append(self->token, c);
+      return true;
+    }
+    end_keyword(self);
+    return false;
+  case DECODER_STATE_STRING_ESCAPE:
+    decode_escape(self, c);
+    return true;
+  case DECODER_STATE_STRING_UNICODE_ESCAPE:
+    decode_unicode_escape(self, c);
+    return true;
+  default:
+    break;
+  }
+
+  if (is_whitespace(c)) {
+    return true;
+  }
+
+  switch (self->state) {
+  case DECODER_STATE_VALUE:
+    start_value(self, c);
+    break;
+  case DECODER_STATE_ARRAY_FIRST_VALUE:
+    if (c == ']') {
+      end_array(self);
+    } else {
+      start_value(self, c);
+    }
+    break;
+  case DECODER_STATE_OBJECT_FIRST_KEY:
+    if (c == '}') {
+      end_object(self);
+    } else if (c == '"') {
+      start_string(self, true);
+    } else {
+      set_unexpected_character_error(self, c);
+    }
+    break;
+  case DECODER_STATE_OBJECT_KEY:
+    if (c == '"') {
+      start_string(self, true);
+    } else {
+      set_unexpected_character_error(self, c);
+    }
+    break;
+  case DECODER_STATE_OBJECT_COLON:
+    if (c == ':') {
+      self->state = DECODER_STATE_VALUE;
+    } else {
+      set_unexpected_character_error(self, c);
+    }
+    break;
+  case DECODER_STATE_AFTER_VALUE:
+    decode_after_value(self, c);
+    break;
+  default:
+    assert(false);
+  }
+
+  return true;
+}
+
+static void decode_data(UtJsonDecoder *self, const uint8_t *data,
+                        size_t data_length) {
+  size_t offset = 0;
+  while (offset < data_length) {
+    if (self->state == DECODER_STATE_ERROR ||
+        self->state == DECODER_STATE_END) {
+      return;
+    }
+
+    if (self->state == DECODER_STATE_STRING) {
+      size_t n_used =
+          decode_string_data(self, data + offset, data_length - offset);
+      offset += n_used;
+      self->offset += n_used;
+    } else if (decode_byte(self, data[offset])) {
+      offset++;
+      self->offset++;
+    }
+  }
+
+  // Pass on the complete characters of a partially decoded string value.
+  if ((self->state == DECODER_STATE_STRING ||
+       self->state == DECODER_STATE_STRING_ESCAPE ||
+       self->state == DECODER_STATE_STRING_UNICODE_ESCAPE) &&
+      !self->is_key) {
+    size_t buffer_length = ut_list_get_length(self->string_buffer);
+    size_t incomplete_length =
+        self->utf8_remaining != 0 ? self->utf8_length : 0;
+    if (buffer_length > incomplete_length) {
+      emit_string(self, buffer_length - incomplete_length, false);
+    }
+  }
+}
+
+static void decode_end(UtJsonDecoder *self) {
+  if (self->state == DECODER_STATE_NUMBER) {
+    end_number(self);
+  } else if (self->state == DECODER_STATE_KEYWORD) {
+    end_keyword(self);
+  }
+  if (self->state == DECODER_STATE_ERROR) {
+    return;
+  }
+
+  bool at_top_level = get_stack_depth(self) == 0;
+  if (at_top_level && self->n_values > 0 &&
+      (self->state == DECODER_STATE_AFTER_VALUE ||
+       self->state == DECODER_STATE_VALUE)) {
+    set_end(self);
+  } else {
+    set_error(self, "Incomplete JSON");
+  }
+}
+
+static size_t read_cb(UtObject *object, UtObject *data, bool complete) {
+  UtJsonDecoder *self = (UtJsonDecoder *)object;
+
+  if (ut_object_implements_error(data)) {
+    set_error_take(self, ut_cstring_new_printf("Failed to read JSON data: %s",
+                                               ut_error_get_description(data)));
+    return 0;
+  }
+
+  if (self->state == DECODER_STATE_ERROR || self->state == DECODER_STATE_END) {
+    return 0;
+  }
+
+  if (self->callback_object == NULL) {
+    ut_input_stream_close(self->input_stream);
+    return 0;
+  }
+
+  size_t data_length = ut_list_get_length(data);
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  UtObjectRef array = NULL;
+  if (d == NULL) {
+    array = ut_uint8_list_get_array(data);
+    d = ut_uint8_list_get_data(array);
+  }
+  decode_data(self, d, data_length);
+
+  if (complete && self->state != DECODER_STATE_ERROR &&
+      self->state != DECODER_STATE_END) {
+    decode_end(self);
+  }
+
+  return data_length;
+}
+
+static void ut_json_decoder_init(UtObject *object) {
+  UtJsonDecoder *self = (UtJsonDecoder *)object;
+  self->state = DECODER_STATE_VALUE;
+  self->stack = ut_uint8_list_new();
+  self->string_buffer = ut_uint8_list_new();
+  self->token = ut_uint8_list_new();
+}
+
+static void ut_json_decoder_cleanup(UtObject *object) {
+  UtJsonDecoder *self = (UtJsonDecoder *)object;
+
+  ut_input_stream_close(self->input_stream);
+
+  ut_object_unref(self->input_stream);
+  ut_object_weak_unref(&self->callback_object);
+  ut_object_unref(self->stack);
+  ut_object_unref(self->string_buffer);
+  ut_object_unref(self->token);
+  ut_object_unref(self->error);
+}
+
+static UtObjectInterface object_interface = {
+    .type_name = "UtJsonDecoder",
+    .init = ut_json_decoder_init,
+    .cleanup = ut_json_decoder_cleanup};
+
+UtObject *ut_json_decoder_new(UtObject *input_stream) {
+  assert(input_stream != NULL);
+  UtObject *object = ut_object_new(sizeof(UtJsonDecoder), &object_interface);
+  UtJsonDecoder *self = (UtJsonDecoder *)object;
+  self->input_stream = ut_object_ref(input_stream);
+  return object;
+}
+
+void ut_json_decoder_decode(UtObject *object, UtObject *callback_object,
+                            const UtJsonDecoderCallbacks *callbacks) {
+  assert(ut_object_is_json_decoder(object));
+  UtJsonDecoder *self = (UtJsonDecoder *)object;
+
+  assert(self->callbacks == NULL);
+  assert(callbacks != NULL);
+
+  ut_object_weak_ref(callback_object, &self->callback_object);
+  self->callbacks = callbacks;
+
+  ut_input_stream_read(self->input_stream, object, read_cb);
+}
+
+UtObject *ut_json_decoder_get_error(UtObject *object) {
+  assert(ut_object_is_json_decoder(object));
+  UtJsonDecoder *self = (UtJsonDecoder *)object;
+  return self->error;
+}
+
+bool ut_object_is_json_decoder(UtObject *object) {
+  return ut_object_is_type(object, &object_interface);
+}
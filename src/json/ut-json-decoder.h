@@ -0,0 +1,68 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ut-object.h"
+
+#pragma once
+
+typedef void (*UtJsonDecoderObjectStartCallback)(UtObject *object);
+typedef void (*UtJsonDecoderObjectEndCallback)(UtObject *object);
+typedef void (*UtJsonDecoderArrayStartCallback)(UtObject *object);
+typedef void (*UtJsonDecoderArrayEndCallback)(UtObject *object);
+typedef void (*UtJsonDecoderKeyCallback)(UtObject *object, const char *key);
+typedef void (*UtJsonDecoderStringCallback)(UtObject *object, const char *text,
+                                            size_t text_length, bool complete);
+typedef void (*UtJsonDecoderInt64Callback)(UtObject *object, int64_t value);
+typedef void (*UtJsonDecoderFloat64Callback)(UtObject *object, double value);
+typedef void (*UtJsonDecoderBooleanCallback)(UtObject *object, bool value);
+typedef void (*UtJsonDecoderNullCallback)(UtObject *object);
+typedef void (*UtJsonDecoderCompleteCallback)(UtObject *object);
+
+/// Callbacks for events emitted by a [UtJsonDecoder].
+/// Any callback may be [NULL] if the event is not required.
+///
+/// [string] is called with slices of a string value as they are decoded. The
+/// slices are valid UTF-8 but are not NUL terminated. [complete] is set on the
+/// last slice of each string, which may be empty.
+///
+/// [key] is called with the complete NUL terminated key of each object member.
+///
+/// [complete] is called when the input stream ends or an error occurs.
+typedef struct {
+  UtJsonDecoderObjectStartCallback object_start;
+  UtJsonDecoderObjectEndCallback object_end;
+  UtJsonDecoderArrayStartCallback array_start;
+  UtJsonDecoderArrayEndCallback array_end;
+  UtJsonDecoderKeyCallback key;
+  UtJsonDecoderStringCallback string;
+  UtJsonDecoderInt64Callback int64;
+  UtJsonDecoderFloat64Callback float64;
+  UtJsonDecoderBooleanCallback boolean;
+  UtJsonDecoderNullCallback null;
+  UtJsonDecoderCompleteCallback complete;
+} UtJsonDecoderCallbacks;
+
+/// Creates a new streaming JSON decoder to read JSON text from [input_stream].
+/// The input stream is processed as it arrives, with decoding state retained
+/// across data boundaries. The stream may contain multiple values separated by
+/// whitespace, e.g. newline delimited JSON.
+///
+/// !arg-type input_stream UtInputStream
+/// !return-ref
+/// !return-type UtJsonDecoder
+UtObject *ut_json_decoder_new(UtObject *input_stream);
+
+/// Start decoding.
+/// [callbacks] are called on [callback_object] for each event decoded.
+void ut_json_decoder_decode(UtObject *object, UtObject *callback_object,
+                            const UtJsonDecoderCallbacks *callbacks);
+
+/// Returns the first error that occurred during decoding or [NULL] if no error
+/// occurred.
+///
+/// !return-type UtJsonError NULL
+UtObject *ut_json_decoder_get_error(UtObject *object);
+
+/// Returns [true] if [object] is a [UtJsonDecoder].
+bool ut_object_is_json_decoder(UtObject *object);
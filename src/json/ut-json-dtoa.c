@@ -0,0 +1,303 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ut-json-dtoa.h"
+
+// Implementation of the Grisu2 algorithm from "Printing Floating-Point Numbers
+// Quickly and Accurately with Integers" by Florian Loitsch. This produces the
+// shortest representation for almost all values, and always one that parses
+// back to the original value.
+
+// Number with a 64 bit significand and binary exponent, i.e. f * 2^e.
+typedef struct {
+  uint64_t f;
+  int e;
+} DiyFp;
+
+#define SIGNIFICAND_SIZE 52
+#define HIDDEN_BIT ((uint64_t)1 << SIGNIFICAND_SIZE)
+#define SIGNIFICAND_MASK (HIDDEN_BIT - 1)
+#define EXPONENT_BIAS (0x3ff + SIGNIFICAND_SIZE)
+
+// Normalized powers of ten 10^-348, 10^-340, ..., 10^340.
+static const uint64_t cached_powers_f[] = {
+    0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76,
+    0xcf42894a5dce35ea, 0x9a6bb0aa55653b2d, 0xe61acf033d1a45df,
+    0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f, 0xbe5691ef416bd60c,
+    0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+    0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57,
+    0xc21094364dfb5637, 0x9096ea6f3848984f, 0xd77485cb25823ac7,
+    0xa086cfcd97bf97f4, 0xef340a98172aace5, 0xb23867fb2a35b28e,
+    0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+    0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126,
+    0xb5b5ada8aaff80b8, 0x87625f056c7c4a8b, 0xc9bcff6034c13053,
+    0x964e858c91ba2655, 0xdff9772470297ebd, 0xa6dfbd9fb8e5b88f,
+    0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+    0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06,
+    0xaa242499697392d3, 0xfd87b5f28300ca0e, 0xbce5086492111aeb,
+    0x8cbccc096f5088cc, 0xd1b71758e219652c, 0x9c40000000000000,
+    0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+    0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068,
+    0x9f4f2726179a2245, 0xed63a231d4c4fb27, 0xb0de65388cc8ada8,
+    0x83c7088e1aab65db, 0xc45d1df942711d9a, 0x924d692ca61be758,
+    0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+    0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d,
+    0x952ab45cfa97a0b3, 0xde469fbd99a05fe3, 0xa59bc234db398c25,
+    0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece, 0x88fcf317f22241e2,
+    0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+    0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410,
+    0x8bab8eefb6409c1a, 0xd01fef10a657842c, 0x9b10a4e5e9913129,
+    0xe7109bfba19c0c9d, 0xac2820d9623bf429, 0x80444b5e7aa7cf85,
+    0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+    0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b,
+};
+static const int16_t cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954,
+    -927, -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635,
+    -608, -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316,
+    -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30, 56,
+    83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402, 428, 455,
+    481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853,
+    880, 907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint64_t powers_of_ten[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull,
+    1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+    1000000000000000000ull, 10000000000000000000ull};
+
+static DiyFp diy_fp(uint64_t f, int e) {
+  DiyFp value = {f, e};
+  return value;
+}
+
+static DiyFp diy_fp_from_double(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  int biased_exponent = (bits >> SIGNIFICAND_SIZE) & 0x7ff;
+  uint64_t significand = bits & SIGNIFICAND_MASK;
+  if (biased_exponent != 0) {
+    return diy_fp(significand + HIDDEN_BIT, biased_exponent - EXPONENT_BIAS);
+  } else {
+    return diy_fp(significand, 1 - EXPONENT_BIAS);
+  }
+}
+
+static DiyFp diy_fp_multiply(DiyFp a, DiyFp b) {
+  unsigned __int128 product = (unsigned __int128)a.f * b.f;
+  uint64_t high = product >> 64;
+  uint64_t low = (uint64_t)product;
+  // Round to nearest.
+  if ((low & ((uint64_t)1 << 63)) != 0) {
+    high++;
+  }
+  return diy_fp(high, a.e + b.e + 64);
+}
+
+static DiyFp diy_fp_normalize(DiyFp value) {
+  int shift = __builtin_clzll(value.f);
+  return diy_fp(value.f << shift, value.e - shift);
+}
+
+// Get the boundaries [minus] and [plus] halfway to the adjacent doubles, with
+// the same exponent.
+static void get_normalized_boundaries(DiyFp value, DiyFp *minus, DiyFp *plus) {
+  DiyFp p = diy_fp((value.f << 1) + 1, value.e - 1);
+  while ((p.f & (HIDDEN_BIT << 1)) == 0) {
+    p.f <<= 1;
+    p.e--;
+  }
+  p.f <<= 64 - SIGNIFICAND_SIZE - 2;
+  p.e -= 64 - SIGNIFICAND_SIZE - 2;
+
+  // The gap below is half the size when at the start of an exponent.
+  DiyFp m = value.f == HIDDEN_BIT ? diy_fp((value.f << 2) - 1, value.e - 2)
+                                  : diy_fp((value.f << 1) - 1, value.e - 1);
+  m.f <<= m.e - p.e;
+  m.e = p.e;
+
+  *minus = m;
+  *plus = p;
+}
+
+// Get a cached power of ten c = 10^-k such that the binary exponent of c
+// multiplied by a number with exponent [e] is in the range [-60, -32].
+static DiyFp get_cached_power(int e, int *k) {
+  // 0.30102999566398114 = 1 / log2(10)
+  double dk = (-61 - e) * 0.30102999566398114 + 347;
+  int ik = (int)dk;
+  if (dk - ik > 0.0) {
+    ik++;
+  }
+  size_t index = (ik >> 3) + 1;
+  *k = -(-348 + (int)index * 8);
+  return diy_fp(cached_powers_f[index], cached_powers_e[index]);
+}
+
+static int count_decimal_digits(uint32_t n) {
+  int count = 1;
+  while (count < 10 && n >= powers_of_ten[count]) {
+    count++;
+  }
+  return count;
+}
+
+// Move the last digit towards the real value while staying in the range.
+static void grisu_round(char *buffer, size_t length, uint64_t delta,
+                        uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+  while (rest < wp_w && delta - rest >= ten_kappa &&
+         (rest + ten_kappa < wp_w ||
+          wp_w - rest > rest + ten_kappa - wp_w)) {
+    buffer[length - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+// Generate the shortest digits in the range [plus - delta, plus].
+static void generate_digits(DiyFp w, DiyFp plus, uint64_t delta, char *buffer,
+                            size_t *length, int *k) {
+  DiyFp one = diy_fp((uint64_t)1 << -plus.e, plus.e);
+  uint64_t wp_w = plus.f - w.f;
+  uint32_t p1 = plus.f >> -one.e;
+  uint64_t p2 = plus.f & (one.f - 1);
+
+  // Integer part.
+  int kappa = count_decimal_digits(p1);
+  *length = 0;
+  while (kappa > 0) {
+    uint32_t divisor = powers_of_ten[kappa - 1];
+    uint32_t digit = p1 / divisor;
+    p1 %= divisor;
+    if (digit != 0 || *length != 0) {
+      buffer[(*length)++] = '0' + digit;
+    }
+    kappa--;
+    uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+    if (rest <= delta) {
+      *k += kappa;
+      grisu_round(buffer, *length, delta, rest,
+                  powers_of_ten[kappa] << -one.e, wp_w);
+      return;
+    }
+  }
+
+  // Fractional part.
+  while (true) {
+    p2 *= 10;
+    delta *= 10;
+    char digit = p2 >> -one.e;
+    if (digit != 0 || *length != 0) {
+      buffer[(*length)++] = '0' + digit;
+    }
+    p2 &= one.f - 1;
+    kappa--;
+    if (p2 < delta) {
+      *k += kappa;
+      int index = -kappa;
+      grisu_round(buffer, *length, delta, p2, one.f,
+                  index < 20 ? wp_w * powers_of_ten[index] : 0);
+      return;
+    }
+  }
+}
+
+// Generate the digits of positive [value] such that value = digits * 10^k.
+static void grisu2(double value, char *buffer, size_t *length, int *k) {
+  DiyFp v = diy_fp_from_double(value);
+  DiyFp minus, plus;
+  get_normalized_boundaries(v, &minus, &plus);
+
+  DiyFp c_mk = get_cached_power(plus.e, k);
+  DiyFp w = diy_fp_multiply(diy_fp_normalize(v), c_mk);
+  DiyFp w_plus = diy_fp_multiply(plus, c_mk);
+  DiyFp w_minus = diy_fp_multiply(minus, c_mk);
+
+  // Allow for the error in the multiplications.
+  w_minus.f++;
+  w_plus.f--;
+  generate_digits(w, w_plus, w_plus.f - w_minus.f, buffer, length, k);
+}
+
+static size_t write_exponent(int exponent, char *buffer) {
+  size_t length = 0;
+  buffer[length++] = 'e';
+  if (exponent < 0) {
+    buffer[length++] = '-';
+    exponent = -exponent;
+  }
+  if (exponent >= 100) {
+    buffer[length++] = '0' + exponent / 100;
+    exponent %= 100;
+    buffer[length++] = '0' + exponent / 10;
+  } else if (exponent >= 10) {
+    buffer[length++] = '0' + exponent / 10;
+  }
+  buffer[length++] = '0' + exponent % 10;
+  return length;
+}
+
+// Lay out [length] digits in [buffer] with value digits * 10^k.
+static size_t prettify(char *buffer, size_t length, int k) {
+  // Position of the decimal point relative to the start of the digits.
+  int point = (int)length + k;
+
+  if (k >= 0 && point <= 21) {
+    // 1234e7 -> 12340000000.0
+    memset(buffer + length, '0', k);
+    buffer[point] = '.';
+    buffer[point + 1] = '0';
+    return point + 2;
+  } else if (point > 0 && point <= 21) {
+    // 1234e-2 -> 12.34
+    memmove(buffer + point + 1, buffer + point, length - point);
+    buffer[point] = '.';
+    return length + 1;
+  } else if (point > -6 && point <= 0) {
+    // 1234e-6 -> 0.001234
+    size_t offset = 2 - point;
+    memmove(buffer + offset, buffer, length);
+    buffer[0] = '0';
+    buffer[1] = '.';
+    memset(buffer + 2, '0', -point);
+    return length + offset;
+  } else if (length == 1) {
+    // 1e30
+    return 1 + write_exponent(point - 1, buffer + 1);
+  } else {
+    // 1234e30 -> 1.234e33
+    memmove(buffer + 2, buffer + 1, length - 1);
+    buffer[1] = '.';
+    return length + 1 + write_exponent(point - 1, buffer + length + 1);
+  }
+}
+
+size_t json_format_float64(double value, char *buffer) {
+  size_t length;
+  if (!isfinite(value)) {
+    // JSON has no representation for infinity or NaN.
+    length = 4;
+    memcpy(buffer, "null", length);
+  } else {
+    size_t offset = 0;
+    if (signbit(value)) {
+      buffer[offset++] = '-';
+      value = -value;
+    }
+    if (value == 0.0) {
+      memcpy(buffer + offset, "0.0", 3);
+      length = offset + 3;
+    } else {
+      size_t n_digits;
+      int k;
+      grisu2(value, buffer + offset, &n_digits, &k);
+      length = offset + prettify(buffer + offset, n_digits, k);
+    }
+  }
+
+  buffer[length] = '\0';
+  return length;
+}
@@ -0,0 +1,14 @@
+#include <stddef.h>
+
+#pragma once
+
+// Maximum length of text written by json_format_float64, including the NUL
+// terminator.
+#define JSON_FLOAT64_MAX_LENGTH 32
+
+// Write the shortest text representation of [value] that parses back to the
+// same value into [buffer], which must be at least JSON_FLOAT64_MAX_LENGTH
+// long. The text always contains a '.' or exponent so it is decoded as a
+// floating point number. Infinity and NaN are written as "null".
+// Returns the length of the text written.
+size_t json_format_float64(double value, char *buffer);
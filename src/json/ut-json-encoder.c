@@ -1,79 +1,188 @@
 #include <assert.h>
-#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "ut-json-dtoa.h"
 #include "ut.h"
 
+// Size of blocks written to output streams.
+#define STREAM_BLOCK_SIZE 65536
+
 typedef struct {
   UtObject object;
 } UtJsonEncoder;
 
-static bool encode_value(UtObject *buffer, UtObject *value);
-
-static bool encode_string(UtObject *buffer, const char *value) {
-  UtObjectRef input = ut_string_new_constant(value);
-  UtObjectRef code_points = ut_string_get_code_points(input);
-  size_t code_points_length = ut_list_get_length(code_points);
-  ut_string_append(buffer, "\"");
-  for (size_t i = 0; i < code_points_length; i++) {
-    uint32_t code_point = ut_uint32_list_get_element(code_points, i);
-    if (code_point <= 0x1f || code_point == 0x7f) {
-      char escape_sequence[7];
-      switch (code_point) {
-      case '\b':
-        ut_string_append(buffer, "\\b");
-        break;
-      case '\f':
-        ut_string_append(buffer, "\\f");
-        break;
-      case '\n':
-        ut_string_append(buffer, "\\n");
-        break;
-      case '\r':
-        ut_string_append(buffer, "\\r");
-        break;
-      case '\t':
-        ut_string_append(buffer, "\\t");
-        break;
-      default:
-        snprintf(escape_sequence, 7, "\\u%04x", code_point);
-        ut_string_append(buffer, escape_sequence);
-        break;
-      }
-    } else if (code_point == '\"') {
-      ut_string_append(buffer, "\\\"");
-    } else if (code_point == '\\') {
-      ut_string_append(buffer, "\\\\");
-    } else {
-      ut_string_append_code_point(buffer, code_point);
+// Growable buffer that encoded text is written to.
+// If [output_stream] is set the buffer is written to it when full.
+typedef struct {
+  char *data;
+  size_t length;
+  size_t allocated;
+  UtObject *output_stream;
+} Buffer;
+
+static void buffer_flush(Buffer *buffer) {
+  if (buffer->output_stream == NULL || buffer->length == 0) {
+    return;
+  }
+
+  UtObjectRef data =
+      ut_uint8_array_new_from_data((uint8_t *)buffer->data, buffer->length);
+  ut_output_stream_write(buffer->output_stream, data);
+  buffer->length = 0;
+}
+
+// Returns a pointer to write [length] bytes to the end of [buffer].
+static char *buffer_reserve(Buffer *buffer, size_t length) {
+  size_t required = buffer->length + length;
+  if (required > buffer->allocated) {
+    buffer_flush(buffer);
+    required = buffer->length + length;
+  }
+  if (required > buffer->allocated) {
+    size_t allocated = buffer->allocated * 2;
+    if (allocated < required) {
+      allocated = required;
     }
+    buffer->data = realloc(buffer->data, allocated);
+    buffer->allocated = allocated;
   }
 
-  ut_string_append(buffer, "\"");
+  return buffer->data + buffer->length;
+}
+
+static void buffer_append(Buffer *buffer, const char *data, size_t length) {
+  memcpy(buffer_reserve(buffer, length), data, length);
+  buffer->length += length;
+}
+
+static void buffer_append_char(Buffer *buffer, char c) {
+  *buffer_reserve(buffer, 1) = c;
+  buffer->length++;
+}
+
+static bool encode_value(Buffer *buffer, UtObject *value);
+
+static bool is_escaped(uint8_t c) {
+  return c <= 0x1f || c == '"' || c == '\\' || c == 0x7f;
+}
+
+// Returns the number of bytes at the start of [text] that don't need escaping.
+static size_t find_escape(const char *text, size_t text_length) {
+  size_t length = 0;
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  const __m128i delete_character = _mm_set1_epi8(0x7f);
+  while (length + 16 <= text_length) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(text + length));
+    __m128i escaped =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                  _mm_cmpeq_epi8(v, backslash)),
+                     _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, control), v),
+                                  _mm_cmpeq_epi8(v, delete_character)));
+    int mask = _mm_movemask_epi8(escaped);
+    if (mask != 0) {
+      return length + __builtin_ctz(mask);
+    }
+    length += 16;
+  }
+#endif
+
+  while (length < text_length && !is_escaped(text[length])) {
+    length++;
+  }
+  return length;
+}
+
+static bool encode_string(Buffer *buffer, const char *value) {
+  static const char hex_digits[] = "0123456789abcdef";
+
+  size_t value_length = strlen(value);
+  buffer_append_char(buffer, '"');
+  size_t offset = 0;
+  while (offset < value_length) {
+    // Copy characters that don't need escaping in one block.
+    size_t run_length = find_escape(value + offset, value_length - offset);
+    buffer_append(buffer, value + offset, run_length);
+    offset += run_length;
+    if (offset >= value_length) {
+      break;
+    }
+
+    uint8_t c = value[offset];
+    offset++;
+    switch (c) {
+    case '\b':
+      buffer_append(buffer, "\\b", 2);
+      break;
+    case '\f':
+      buffer_append(buffer, "\\f", 2);
+      break;
+    case '\n':
+      buffer_append(buffer, "\\n", 2);
+      break;
+    case '\r':
+      buffer_append(buffer, "\\r", 2);
+      break;
+    case '\t':
+      buffer_append(buffer, "\\t", 2);
+      break;
+    case '"':
+      buffer_append(buffer, "\\\"", 2);
+      break;
+    case '\\':
+      buffer_append(buffer, "\\\\", 2);
+      break;
+    default: {
+      char escape_sequence[6] = {
+          '\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0xf]};
+      buffer_append(buffer, escape_sequence, 6);
+      break;
+    }
+    }
+  }
+
+  buffer_append_char(buffer, '"');
   return true;
 }
 
-static bool encode_integer_number(UtObject *buffer, int64_t value) {
-  char text[1024];
-  snprintf(text, 1024, "%li", value);
-  ut_string_append(buffer, text);
+static bool encode_integer_number(Buffer *buffer, int64_t value) {
+  // Write digits backwards from the end of the text.
+  char text[20];
+  size_t offset = sizeof(text);
+  uint64_t v = value < 0 ? -(uint64_t)value : (uint64_t)value;
+  do {
+    text[--offset] = '0' + v % 10;
+    v /= 10;
+  } while (v != 0);
+  if (value < 0) {
+    text[--offset] = '-';
+  }
+
+  buffer_append(buffer, text + offset, sizeof(text) - offset);
   return true;
 }
 
-static bool encode_float_number(UtObject *buffer, double value) {
-  char text[1024];
-  snprintf(text, 1024, "%e", value);
-  ut_string_append(buffer, text);
+static bool encode_float_number(Buffer *buffer, double value) {
+  char *text = buffer_reserve(buffer, JSON_FLOAT64_MAX_LENGTH);
+  buffer->length += json_format_float64(value, text);
   return true;
 }
 
-static bool encode_object(UtObject *buffer, UtObject *value) {
-  ut_string_append(buffer, "{");
+static bool encode_object(Buffer *buffer, UtObject *value) {
+  buffer_append_char(buffer, '{');
   UtObjectRef items = ut_map_get_items(value);
   size_t length = ut_list_get_length(items);
   for (size_t i = 0; i < length; i++) {
     UtObjectRef item = ut_list_get_element(items, i);
     if (i != 0) {
-      ut_string_append(buffer, ",");
+      buffer_append_char(buffer, ',');
     }
 
     UtObject *key = ut_map_item_get_key(item);
@@ -86,7 +195,7 @@ static bool encode_object(UtObject *buffer, UtObject *value) {
       return false;
     }
 
-    ut_string_append(buffer, ":");
+    buffer_append_char(buffer, ':');
 
     UtObject *value = ut_map_item_get_value(item);
     result = encode_value(buffer, value);
@@ -94,38 +203,42 @@ static bool encode_object(UtObject *buffer, UtObject *value) {
       return false;
     }
   }
-  ut_string_append(buffer, "}");
+  buffer_append_char(buffer, '}');
   return true;
 }
 
-static bool encode_array(UtObject *buffer, UtObject *value) {
-  ut_string_append(buffer, "[");
+static bool encode_array(Buffer *buffer, UtObject *value) {
+  buffer_append_char(buffer, '[');
   size_t length = ut_list_get_length(value);
   for (size_t i = 0; i < length; i++) {
     UtObjectRef child = ut_list_get_element(value, i);
     if (i != 0) {
-      ut_string_append(buffer, ",");
+      buffer_append_char(buffer, ',');
     }
     bool result = encode_value(buffer, child);
     if (!result) {
       return false;
     }
   }
-  ut_string_append(buffer, "]");
+  buffer_append_char(buffer, ']');
   return true;
 }
 
-static bool encode_boolean(UtObject *buffer, bool value) {
-  ut_string_append(buffer, value ? "true" : "false");
+static bool encode_boolean(Buffer *buffer, bool value) {
+  if (value) {
+    buffer_append(buffer, "true", 4);
+  } else {
+    buffer_append(buffer, "false", 5);
+  }
   return true;
 }
 
-static bool encode_null(UtObject *buffer) {
-  ut_string_append(buffer, "null");
+static bool encode_null(Buffer *buffer) {
+  buffer_append(buffer, "null", 4);
   return true;
 }
 
-static bool encode_value(UtObject *buffer, UtObject *value) {
+static bool encode_value(Buffer *buffer, UtObject *value) {
   if (ut_object_implements_string(value)) {
     return encode_string(buffer, ut_string_get_text(value));
   } else if (ut_object_is_int64(value)) {
@@ -155,9 +268,24 @@ UtObject *ut_json_encoder_new() {
 char *ut_json_encoder_encode(UtObject *object, UtObject *message) {
   assert(ut_object_is_json_encoder(object));
 
-  UtObjectRef buffer = ut_string_new("");
-  encode_value(buffer, message);
-  return ut_string_take_text(buffer);
+  Buffer buffer = {.data = malloc(64), .length = 0, .allocated = 64};
+  encode_value(&buffer, message);
+  buffer_append_char(&buffer, '\0');
+  return buffer.data;
+}
+
+void ut_json_encoder_encode_to_stream(UtObject *object, UtObject *message,
+                                      UtObject *output_stream) {
+  assert(ut_object_is_json_encoder(object));
+  assert(ut_object_implements_output_stream(output_stream));
+
+  Buffer buffer = {.data = malloc(STREAM_BLOCK_SIZE),
+                   .length = 0,
+                   .allocated = STREAM_BLOCK_SIZE,
+                   .output_stream = output_stream};
+  encode_value(&buffer, message);
+  buffer_flush(&buffer);
+  free(buffer.data);
 }
 
 bool ut_object_is_json_encoder(UtObject *object) {
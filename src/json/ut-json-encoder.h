@@ -21,5 +21,20 @@ UtObject *ut_json_encoder_new();
 /// !arg-type message UtNull
 char *ut_json_encoder_encode(UtObject *object, UtObject *message);
 
+/// Writes a JSON encoded representation of [message] to [output_stream].
+/// The text is written in blocks as it is encoded, so the complete text is not
+/// held in memory.
+///
+/// !arg-type message UtString
+/// !arg-type message UtInt64
+/// !arg-type message UtFloat64
+/// !arg-type message UtMap
+/// !arg-type message UtList
+/// !arg-type message UtBoolean
+/// !arg-type message UtNull
+/// !arg-type output_stream UtOutputStream
+void ut_json_encoder_encode_to_stream(UtObject *object, UtObject *message,
+                                      UtObject *output_stream);
+
 /// Returns [true] if [object] is a [UtJsonEncoder].
 bool ut_object_is_json_encoder(UtObject *object);
@@ -0,0 +1,43 @@
+#include <assert.h>
+
+#include "ut.h"
+
+typedef struct {
+  UtObject object;
+  char *description;
+} UtJsonError;
+
+static char *ut_json_error_to_string(UtObject *object) {
+  UtJsonError *self = (UtJsonError *)object;
+  return ut_cstring_new_printf("<UtJsonError>(\"%s\")", self->description);
+}
+
+static void ut_json_error_cleanup(UtObject *object) {
+  UtJsonError *self = (UtJsonError *)object;
+  free(self->description);
+}
+
+static char *ut_json_error_get_description(UtObject *object) {
+  UtJsonError *self = (UtJsonError *)object;
+  return ut_cstring_new(self->description);
+}
+
+static UtErrorInterface error_interface = {.get_description =
+                                               ut_json_error_get_description};
+
+static UtObjectInterface object_interface = {
+    .type_name = "UtJsonError",
+    .to_string = ut_json_error_to_string,
+    .cleanup = ut_json_error_cleanup,
+    .interfaces = {{&ut_error_id, &error_interface}, {NULL, NULL}}};
+
+UtObject *ut_json_error_new(const char *description) {
+  UtObject *object = ut_object_new(sizeof(UtJsonError), &object_interface);
+  UtJsonError *self = (UtJsonError *)object;
+  self->description = ut_cstring_new(description);
+  return object;
+}
+
+bool ut_object_is_json_error(UtObject *object) {
+  return ut_object_is_type(object, &object_interface);
+}
@@ -0,0 +1,14 @@
+#include <stdbool.h>
+
+#include "ut-object.h"
+
+#pragma once
+
+/// Creates a new JSON error with [description].
+///
+/// !return-ref
+/// !return-type UtJsonError
+UtObject *ut_json_error_new(const char *description);
+
+/// Returns [true] if [object] is a [UtJsonError].
+bool ut_object_is_json_error(UtObject *object);
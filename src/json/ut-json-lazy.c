@@ -0,0 +1,382 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ut-json-private.h"
+#include "ut-list-private.h"
+#include "ut-map-private.h"
+#include "ut.h"
+
+// Values are only decoded from the text when they are accessed. The text is
+// referred to by the offsets of its tokens (see ut-json-scanner.c), with the
+// index of the last token of each value used to skip over nested objects and
+// arrays.
+
+typedef struct {
+  UtObject object;
+
+  // JSON text being decoded.
+  UtObject *text;
+  const char *text_data;
+
+  // Offset of each token in the text.
+  uint32_t *indexes;
+
+  // Index of the last token in the value starting with each token.
+  uint32_t *ends;
+
+  size_t n_indexes;
+} UtJsonLazyDocument;
+
+typedef struct {
+  UtObject object;
+
+  UtJsonLazyDocument *document;
+
+  // Token index of the key of each member.
+  uint32_t *members;
+  size_t n_members;
+
+  // Number of unique keys, calculated when first needed.
+  size_t length;
+  bool have_length;
+
+  // Decoded keys and values, NULL until accessed.
+  UtObject **keys;
+  UtObject **values;
+
+  // All the members, created if this object is modified.
+  UtObject *map;
+} UtJsonLazyMap;
+
+typedef struct {
+  UtObject object;
+
+  UtJsonLazyDocument *document;
+
+  // Token index of each element.
+  uint32_t *elements;
+  size_t n_elements;
+
+  // Decoded values, NULL until accessed.
+  UtObject **values;
+} UtJsonLazyList;
+
+static void ut_json_lazy_document_cleanup(UtObject *object) {
+  UtJsonLazyDocument *self = (UtJsonLazyDocument *)object;
+  ut_object_unref(self->text);
+  free(self->indexes);
+  free(self->ends);
+}
+
+static UtObjectInterface document_object_interface = {
+    .type_name = "UtJsonLazyDocument",
+    .cleanup = ut_json_lazy_document_cleanup};
+
+// Returns the index of the token following the value starting at [index].
+static size_t skip_value(UtJsonLazyDocument *document, size_t index) {
+  return document->ends[index] + 1;
+}
+
+static char get_token(UtJsonLazyDocument *document, size_t index) {
+  return document->text_data[document->indexes[index]];
+}
+
+// Get the token index of each element of the array or key of each member of the
+// object starting at [index].
+static uint32_t *find_children(UtJsonLazyDocument *document, size_t index,
+                               size_t *n_children) {
+  bool is_object = get_token(document, index) == '{';
+  size_t end = document->ends[index];
+
+  // Object values follow the key and colon.
+  size_t value_offset = is_object ? 2 : 0;
+
+  *n_children = 0;
+  for (size_t i = index + 1; i < end;
+       i = skip_value(document, i + value_offset) + 1) {
+    (*n_children)++;
+  }
+
+  uint32_t *children = malloc(sizeof(uint32_t) * *n_children);
+  size_t child_index = 0;
+  for (size_t i = index + 1; i < end;
+       i = skip_value(document, i + value_offset) + 1) {
+    children[child_index] = i;
+    child_index++;
+  }
+
+  return children;
+}
+
+static UtObject *map_get_key(UtJsonLazyMap *self, size_t index) {
+  if (self->keys[index] == NULL) {
+    UtJsonLazyDocument *document = self->document;
+    self->keys[index] = json_decode_string(
+        document->text_data, document->indexes[self->members[index]]);
+  }
+  return self->keys[index];
+}
+
+static UtObject *map_get_value(UtJsonLazyMap *self, size_t index) {
+  if (self->values[index] == NULL) {
+    // Value follows the key and colon.
+    self->values[index] = json_lazy_value_new((UtObject *)self->document,
+                                              self->members[index] + 2);
+  }
+  return self->values[index];
+}
+
+// Returns true if the key of the member at [index] is [key].
+static bool map_key_matches(UtJsonLazyMap *self, size_t index, const char *key,
+                            size_t key_length) {
+  UtJsonLazyDocument *document = self->document;
+  const char *text =
+      document->text_data + document->indexes[self->members[index]] + 1;
+  for (size_t i = 0; i < key_length; i++) {
+    if (text[i] == '\\') {
+      // Compare escaped keys once decoded.
+      return strcmp(ut_string_get_text(map_get_key(self, index)), key) == 0;
+    }
+    if (text[i] != key[i] || text[i] == '"') {
+      return false;
+    }
+  }
+
+  return text[key_length] == '"';
+}
+
+// Get a map containing all the members, for when this map is modified.
+static UtObject *map_get_map(UtJsonLazyMap *self) {
+  if (self->map == NULL) {
+    self->map = ut_map_new();
+    for (size_t i = 0; i < self->n_members; i++) {
+      ut_map_insert(self->map, map_get_key(self, i), map_get_value(self, i));
+    }
+  }
+  return self->map;
+}
+
+static int compare_keys(const void *a, const void *b) {
+  return strcmp(*(const char **)a, *(const char **)b);
+}
+
+static size_t ut_json_lazy_map_get_length(UtObject *object) {
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  if (self->map != NULL) {
+    return ut_map_get_length(self->map);
+  }
+
+  // Members with the same key are only counted once.
+  if (!self->have_length) {
+    const char **keys = malloc(sizeof(const char *) * self->n_members);
+    for (size_t i = 0; i < self->n_members; i++) {
+      keys[i] = ut_string_get_text(map_get_key(self, i));
+    }
+    qsort(keys, self->n_members, sizeof(const char *), compare_keys);
+    self->length = 0;
+    for (size_t i = 0; i < self->n_members; i++) {
+      if (i == 0 || strcmp(keys[i - 1], keys[i]) != 0) {
+        self->length++;
+      }
+    }
+    free(keys);
+    self->have_length = true;
+  }
+
+  return self->length;
+}
+
+static void ut_json_lazy_map_insert(UtObject *object, UtObject *key,
+                                    UtObject *value) {
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  ut_map_insert(map_get_map(self), key, value);
+}
+
+static UtObject *ut_json_lazy_map_lookup(UtObject *object, UtObject *key) {
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  if (self->map != NULL) {
+    return ut_map_lookup(self->map, key);
+  }
+
+  if (!ut_object_implements_string(key)) {
+    return NULL;
+  }
+  const char *key_text = ut_string_get_text(key);
+  size_t key_length = strlen(key_text);
+
+  // Later members replace earlier members with the same key.
+  for (size_t i = self->n_members; i > 0; i--) {
+    if (map_key_matches(self, i - 1, key_text, key_length)) {
+      return map_get_value(self, i - 1);
+    }
+  }
+
+  return NULL;
+}
+
+static void ut_json_lazy_map_remove(UtObject *object, UtObject *key) {
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  ut_map_remove(map_get_map(self), key);
+}
+
+static UtObject *ut_json_lazy_map_get_items(UtObject *object) {
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  return ut_map_get_items(map_get_map(self));
+}
+
+static UtObject *ut_json_lazy_map_get_keys(UtObject *object) {
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  return ut_map_get_keys(map_get_map(self));
+}
+
+static UtObject *ut_json_lazy_map_get_values(UtObject *object) {
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  return ut_map_get_values(map_get_map(self));
+}
+
+static UtMapInterface map_interface = {
+    .get_length = ut_json_lazy_map_get_length,
+    .insert = ut_json_lazy_map_insert,
+    .lookup = ut_json_lazy_map_lookup,
+    .remove = ut_json_lazy_map_remove,
+    .get_items = ut_json_lazy_map_get_items,
+    .get_keys = ut_json_lazy_map_get_keys,
+    .get_values = ut_json_lazy_map_get_values};
+
+static void ut_json_lazy_map_cleanup(UtObject *object) {
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  for (size_t i = 0; i < self->n_members; i++) {
+    ut_object_unref(self->keys[i]);
+    ut_object_unref(self->values[i]);
+  }
+  free(self->members);
+  free(self->keys);
+  free(self->values);
+  ut_object_unref(self->map);
+  ut_object_unref((UtObject *)self->document);
+}
+
+static UtObjectInterface map_object_interface = {
+    .type_name = "UtJsonLazyMap",
+    .to_string = _ut_map_to_string,
+    .cleanup = ut_json_lazy_map_cleanup,
+    .interfaces = {{&ut_map_id, &map_interface}, {NULL, NULL}}};
+
+static UtObject *lazy_map_new(UtJsonLazyDocument *document, size_t index) {
+  UtObject *object =
+      ut_object_new(sizeof(UtJsonLazyMap), &map_object_interface);
+  UtJsonLazyMap *self = (UtJsonLazyMap *)object;
+  self->document = (UtJsonLazyDocument *)ut_object_ref((UtObject *)document);
+
+  self->members = find_children(document, index, &self->n_members);
+
+  self->keys = calloc(self->n_members, sizeof(UtObject *));
+  self->values = calloc(self->n_members, sizeof(UtObject *));
+
+  return object;
+}
+
+static UtObject *list_get_value(UtJsonLazyList *self, size_t index) {
+  if (self->values[index] == NULL) {
+    self->values[index] =
+        json_lazy_value_new((UtObject *)self->document, self->elements[index]);
+  }
+  return self->values[index];
+}
+
+static size_t ut_json_lazy_list_get_length(UtObject *object) {
+  UtJsonLazyList *self = (UtJsonLazyList *)object;
+  return self->n_elements;
+}
+
+static UtObject *ut_json_lazy_list_get_element(UtObject *object, size_t index) {
+  UtJsonLazyList *self = (UtJsonLazyList *)object;
+  return list_get_value(self, index);
+}
+
+static UtObject *ut_json_lazy_list_get_element_ref(UtObject *object,
+                                                  size_t index) {
+  UtJsonLazyList *self = (UtJsonLazyList *)object;
+  return ut_object_ref(list_get_value(self, index));
+}
+
+static UtObject *ut_json_lazy_list_get_sublist(UtObject *object, size_t start,
+                                               size_t count) {
+  UtJsonLazyList *self = (UtJsonLazyList *)object;
+  UtObject *sublist = ut_object_array_new();
+  for (size_t i = 0; i < count; i++) {
+    ut_list_append(sublist, list_get_value(self, start + i));
+  }
+  return sublist;
+}
+
+static UtObject *ut_json_lazy_list_copy(UtObject *object) {
+  UtJsonLazyList *self = (UtJsonLazyList *)object;
+  return ut_json_lazy_list_get_sublist(object, 0, self->n_elements);
+}
+
+static UtObjectListInterface object_list_interface = {
+    .get_element = ut_json_lazy_list_get_element};
+
+static UtListInterface list_interface = {
+    .is_mutable = false,
+    .get_length = ut_json_lazy_list_get_length,
+    .get_element = ut_json_lazy_list_get_element_ref,
+    .get_sublist = ut_json_lazy_list_get_sublist,
+    .copy = ut_json_lazy_list_copy};
+
+static void ut_json_lazy_list_cleanup(UtObject *object) {
+  UtJsonLazyList *self = (UtJsonLazyList *)object;
+  for (size_t i = 0; i < self->n_elements; i++) {
+    ut_object_unref(self->values[i]);
+  }
+  free(self->elements);
+  free(self->values);
+  ut_object_unref((UtObject *)self->document);
+}
+
+static UtObjectInterface list_object_interface = {
+    .type_name = "UtJsonLazyList",
+    .to_string = _ut_list_to_string,
+    .cleanup = ut_json_lazy_list_cleanup,
+    .interfaces = {{&ut_object_list_id, &object_list_interface},
+                   {&ut_list_id, &list_interface},
+                   {NULL, NULL}}};
+
+static UtObject *lazy_list_new(UtJsonLazyDocument *document, size_t index) {
+  UtObject *object =
+      ut_object_new(sizeof(UtJsonLazyList), &list_object_interface);
+  UtJsonLazyList *self = (UtJsonLazyList *)object;
+  self->document = (UtJsonLazyDocument *)ut_object_ref((UtObject *)document);
+
+  self->elements = find_children(document, index, &self->n_elements);
+
+  self->values = calloc(self->n_elements, sizeof(UtObject *));
+
+  return object;
+}
+
+UtObject *json_lazy_document_new(UtObject *text, uint32_t *indexes,
+                                 uint32_t *ends, size_t n_indexes) {
+  UtObject *object =
+      ut_object_new(sizeof(UtJsonLazyDocument), &document_object_interface);
+  UtJsonLazyDocument *self = (UtJsonLazyDocument *)object;
+  self->text = ut_object_ref(text);
+  self->text_data = ut_string_get_text(text);
+  self->indexes = indexes;
+  self->ends = ends;
+  self->n_indexes = n_indexes;
+  return object;
+}
+
+UtObject *json_lazy_value_new(UtObject *document, size_t index) {
+  UtJsonLazyDocument *self = (UtJsonLazyDocument *)document;
+  switch (get_token(self, index)) {
+  case '{':
+    return lazy_map_new(self, index);
+  case '[':
+    return lazy_list_new(self, index);
+  default:
+    return json_decode_scalar(self->text_data, self->indexes[index]);
+  }
+}
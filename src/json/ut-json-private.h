@@ -0,0 +1,23 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ut-object.h"
+
+#pragma once
+
+// Decode the string with opening quote at [offset] in [text].
+UtObject *json_decode_string(const char *text, size_t offset);
+
+// Decode the string, number, boolean or null value at [offset] in [text].
+UtObject *json_decode_scalar(const char *text, size_t offset);
+
+// Create a document containing the validated JSON [text] that lazy values
+// refer to. [indexes] contains the offset of each of the [n_indexes] tokens,
+// and [ends] the index of the token that ends each value. Takes ownership of
+// [indexes] and [ends].
+UtObject *json_lazy_document_new(UtObject *text, uint32_t *indexes,
+                                 uint32_t *ends, size_t n_indexes);
+
+// Create a value for the token at [index] in [document]. Objects and arrays
+// are returned as a map and list that decode their contents when accessed.
+UtObject *json_lazy_value_new(UtObject *document, size_t index);
@@ -0,0 +1,331 @@
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ut-cpu-private.h"
+#include "ut-json-scanner.h"
+
+// Text is processed in blocks of 64 bytes, with each byte in the block
+// represented by one bit in these masks.
+typedef struct {
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t operators;
+  uint64_t whitespace;
+  uint64_t control;
+  uint64_t non_ascii;
+} BlockMasks;
+
+typedef void (*ClassifyFunction)(const uint8_t *block, BlockMasks *masks);
+
+typedef struct {
+  // Continuation bytes remaining in the current sequence.
+  int remaining;
+
+  // Valid range of the next continuation byte.
+  uint8_t lower;
+  uint8_t upper;
+} Utf8State;
+
+static void classify_scalar(const uint8_t *block, BlockMasks *masks) {
+  memset(masks, 0, sizeof(BlockMasks));
+  for (size_t i = 0; i < 64; i++) {
+    uint8_t c = block[i];
+    uint64_t bit = (uint64_t)1 << i;
+    switch (c) {
+    case '"':
+      masks->quote |= bit;
+      break;
+    case '\\':
+      masks->backslash |= bit;
+      break;
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+      masks->operators |= bit;
+      break;
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+      masks->whitespace |= bit;
+      break;
+    default:
+      break;
+    }
+    if (c <= 0x1f || c == 0x7f) {
+      masks->control |= bit;
+    }
+    if (c >= 0x80) {
+      masks->non_ascii |= bit;
+    }
+  }
+}
+
+#if defined(__SSE2__)
+static uint64_t sse2_mask(__m128i v0, __m128i v1, __m128i v2, __m128i v3) {
+  return (uint64_t)(uint16_t)_mm_movemask_epi8(v0) |
+         (uint64_t)(uint16_t)_mm_movemask_epi8(v1) << 16 |
+         (uint64_t)(uint16_t)_mm_movemask_epi8(v2) << 32 |
+         (uint64_t)(uint16_t)_mm_movemask_epi8(v3) << 48;
+}
+
+static void classify_sse2(const uint8_t *block, BlockMasks *masks) {
+  __m128i v[4];
+  __m128i quote[4], backslash[4], operators[4], whitespace[4], control[4];
+  for (size_t i = 0; i < 4; i++) {
+    v[i] = _mm_loadu_si128((const __m128i *)(block + i * 16));
+    quote[i] = _mm_cmpeq_epi8(v[i], _mm_set1_epi8('"'));
+    backslash[i] = _mm_cmpeq_epi8(v[i], _mm_set1_epi8('\\'));
+
+    // '[' and ']' differ from '{' and '}' only by bit 5.
+    __m128i lower = _mm_or_si128(v[i], _mm_set1_epi8(0x20));
+    operators[i] = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+                     _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v[i], _mm_set1_epi8(':')),
+                     _mm_cmpeq_epi8(v[i], _mm_set1_epi8(','))));
+
+    whitespace[i] =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v[i], _mm_set1_epi8(' ')),
+                                  _mm_cmpeq_epi8(v[i], _mm_set1_epi8('\t'))),
+                     _mm_or_si128(_mm_cmpeq_epi8(v[i], _mm_set1_epi8('\n')),
+                                  _mm_cmpeq_epi8(v[i], _mm_set1_epi8('\r'))));
+
+    // Unsigned v <= 0x1f is the same as min(v, 0x1f) == v.
+    control[i] = _mm_or_si128(
+        _mm_cmpeq_epi8(_mm_min_epu8(v[i], _mm_set1_epi8(0x1f)), v[i]),
+        _mm_cmpeq_epi8(v[i], _mm_set1_epi8(0x7f)));
+  }
+
+  masks->quote = sse2_mask(quote[0], quote[1], quote[2], quote[3]);
+  masks->backslash =
+      sse2_mask(backslash[0], backslash[1], backslash[2], backslash[3]);
+  masks->operators =
+      sse2_mask(operators[0], operators[1], operators[2], operators[3]);
+  masks->whitespace =
+      sse2_mask(whitespace[0], whitespace[1], whitespace[2], whitespace[3]);
+  masks->control = sse2_mask(control[0], control[1], control[2], control[3]);
+  masks->non_ascii = sse2_mask(v[0], v[1], v[2], v[3]);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static uint64_t avx2_mask(__m256i v0,
+                                                           __m256i v1) {
+  return (uint64_t)(uint32_t)_mm256_movemask_epi8(v0) |
+         (uint64_t)(uint32_t)_mm256_movemask_epi8(v1) << 32;
+}
+
+__attribute__((target("avx2"))) static void
+classify_avx2(const uint8_t *block, BlockMasks *masks) {
+  __m256i v[2];
+  __m256i quote[2], backslash[2], operators[2], whitespace[2], control[2];
+  for (size_t i = 0; i < 2; i++) {
+    v[i] = _mm256_loadu_si256((const __m256i *)(block + i * 32));
+    quote[i] = _mm256_cmpeq_epi8(v[i], _mm256_set1_epi8('"'));
+    backslash[i] = _mm256_cmpeq_epi8(v[i], _mm256_set1_epi8('\\'));
+
+    __m256i lower = _mm256_or_si256(v[i], _mm256_set1_epi8(0x20));
+    operators[i] = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')),
+                        _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v[i], _mm256_set1_epi8(':')),
+                        _mm256_cmpeq_epi8(v[i], _mm256_set1_epi8(','))));
+
+    whitespace[i] = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v[i], _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(v[i], _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v[i], _mm256_set1_epi8('\n')),
+                        _mm256_cmpeq_epi8(v[i], _mm256_set1_epi8('\r'))));
+
+    control[i] = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v[i], _mm256_set1_epi8(0x1f)), v[i]),
+        _mm256_cmpeq_epi8(v[i], _mm256_set1_epi8(0x7f)));
+  }
+
+  masks->quote = avx2_mask(quote[0], quote[1]);
+  masks->backslash = avx2_mask(backslash[0], backslash[1]);
+  masks->operators = avx2_mask(operators[0], operators[1]);
+  masks->whitespace = avx2_mask(whitespace[0], whitespace[1]);
+  masks->control = avx2_mask(control[0], control[1]);
+  masks->non_ascii = avx2_mask(v[0], v[1]);
+}
+#endif
+
+static ClassifyFunction classify_function = NULL;
+static pthread_once_t functions_once = PTHREAD_ONCE_INIT;
+
+// Choose the fastest function the CPU supports.
+static void select_functions() {
+  ClassifyFunction classify = classify_scalar;
+#if defined(__SSE2__)
+  classify = classify_sse2;
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+  if (_ut_cpu_has_avx2()) {
+    classify = classify_avx2;
+  }
+#endif
+
+  classify_function = classify;
+}
+
+static ClassifyFunction get_classify_function() {
+  pthread_once(&functions_once, select_functions);
+  return classify_function;
+}
+
+// Returns a mask with each bit set to the XOR of all the bits up to and
+// including it, i.e. the regions between pairs of set bits.
+static uint64_t prefix_xor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+// Returns a mask of the characters escaped by an odd length sequence of
+// backslashes. [odd_backslash_carry] is set if the block ends in such a
+// sequence.
+static uint64_t find_escaped(uint64_t backslash,
+                             uint64_t *odd_backslash_carry) {
+  const uint64_t even_bits = 0x5555555555555555;
+  const uint64_t odd_bits = ~even_bits;
+
+  uint64_t start_edges = backslash & ~(backslash << 1);
+  uint64_t even_start_mask = even_bits ^ *odd_backslash_carry;
+  uint64_t even_starts = start_edges & even_start_mask;
+  uint64_t odd_starts = start_edges & ~even_start_mask;
+  uint64_t even_carries = backslash + even_starts;
+
+  uint64_t odd_carries;
+  bool ends_odd_backslash =
+      __builtin_add_overflow(backslash, odd_starts, &odd_carries);
+  odd_carries |= *odd_backslash_carry;
+  *odd_backslash_carry = ends_odd_backslash ? 1 : 0;
+
+  uint64_t even_carry_ends = even_carries & ~backslash;
+  uint64_t odd_carry_ends = odd_carries & ~backslash;
+  uint64_t even_start_odd_end = even_carry_ends & odd_bits;
+  uint64_t odd_start_even_end = odd_carry_ends & even_bits;
+  return even_start_odd_end | odd_start_even_end;
+}
+
+static bool validate_utf8(Utf8State *state, const uint8_t *data,
+                          size_t data_length) {
+  for (size_t i = 0; i < data_length; i++) {
+    uint8_t c = data[i];
+    if (state->remaining > 0) {
+      if (c < state->lower || c > state->upper) {
+        return false;
+      }
+      state->remaining--;
+      state->lower = 0x80;
+      state->upper = 0xbf;
+      continue;
+    }
+
+    if (c <= 0x7f) {
+      continue;
+    }
+
+    state->lower = 0x80;
+    state->upper = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf) {
+      state->remaining = 1;
+    } else if (c >= 0xe0 && c <= 0xef) {
+      state->remaining = 2;
+      if (c == 0xe0) {
+        state->lower = 0xa0;
+      } else if (c == 0xed) {
+        state->upper = 0x9f;
+      }
+    } else if (c >= 0xf0 && c <= 0xf4) {
+      state->remaining = 3;
+      if (c == 0xf0) {
+        state->lower = 0x90;
+      } else if (c == 0xf4) {
+        state->upper = 0x8f;
+      }
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool json_build_structural_index(const char *text, size_t text_length,
+                                 uint32_t *indexes, size_t *n_indexes) {
+  ClassifyFunction classify = get_classify_function();
+
+  uint64_t odd_backslash_carry = 0;
+  uint64_t in_string_carry = 0;
+  uint64_t scalar_carry = 0;
+  Utf8State utf8_state = {0, 0x80, 0xbf};
+  size_t n = 0;
+  for (size_t offset = 0; offset < text_length; offset += 64) {
+    const uint8_t *block = (const uint8_t *)text + offset;
+    size_t block_length = text_length - offset;
+
+    // Pad the last block with whitespace.
+    uint8_t last_block[64];
+    if (block_length < 64) {
+      memset(last_block, ' ', 64);
+      memcpy(last_block, block, block_length);
+      block = last_block;
+    } else {
+      block_length = 64;
+    }
+
+    BlockMasks masks;
+    classify(block, &masks);
+
+    if (masks.non_ascii != 0 || utf8_state.remaining != 0) {
+      if (!validate_utf8(&utf8_state, block, block_length)) {
+        return false;
+      }
+    }
+
+    uint64_t escaped = find_escaped(masks.backslash, &odd_backslash_carry);
+    uint64_t quote = masks.quote & ~escaped;
+    uint64_t in_string = prefix_xor(quote) ^ in_string_carry;
+    in_string_carry = (uint64_t)((int64_t)in_string >> 63);
+
+    // Control characters must be escaped in strings.
+    if ((masks.control & in_string) != 0) {
+      return false;
+    }
+
+    uint64_t operators = masks.operators & ~in_string;
+    uint64_t string_start = quote & in_string;
+    uint64_t scalar =
+        ~(masks.operators | masks.whitespace | quote) & ~in_string;
+    uint64_t scalar_start = scalar & ~(scalar << 1 | scalar_carry);
+    scalar_carry = scalar >> 63;
+
+    uint64_t structural = operators | string_start | scalar_start;
+    while (structural != 0) {
+      indexes[n] = offset + __builtin_ctzll(structural);
+      n++;
+      structural &= structural - 1;
+    }
+  }
+
+  if (in_string_carry != 0 || utf8_state.remaining != 0) {
+    return false;
+  }
+
+  *n_indexes = n;
+  return true;
+}
@@ -0,0 +1,14 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+// Build an index of the offset of each token in [text] of length
+// [text_length]. Tokens are the structural characters '{', '}', '[', ']', ':'
+// and ',', the opening quote of each string and the first character of each
+// number or keyword. Strings are checked for valid UTF-8 and unescaped control
+// characters. [indexes] must have space for [text_length] values.
+// Returns false if [text] is not valid.
+bool json_build_structural_index(const char *text, size_t text_length,
+                                 uint32_t *indexes, size_t *n_indexes);
@@ -1,5 +1,7 @@
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ut.h"
 
@@ -39,25 +41,71 @@ static void test_encode() {
   UtObjectRef one_point_one = ut_float64_new(1.1);
   ut_cstring_ref one_point_one_text =
       ut_json_encoder_encode(encoder, one_point_one);
-  ut_assert_cstring_equal(one_point_one_text, "1.100000e+00");
+  ut_assert_cstring_equal(one_point_one_text, "1.1");
 
   UtObjectRef minus_one_point_one = ut_float64_new(-1.1);
   ut_cstring_ref minus_one_point_one_text =
       ut_json_encoder_encode(encoder, minus_one_point_one);
-  ut_assert_cstring_equal(minus_one_point_one_text, "-1.100000e+00");
+  ut_assert_cstring_equal(minus_one_point_one_text, "-1.1");
 
   UtObjectRef scientific_number = ut_float64_new(1024);
   ut_cstring_ref scientific_number_text =
       ut_json_encoder_encode(encoder, scientific_number);
-  ut_assert_cstring_equal(scientific_number_text, "1.024000e+03");
+  ut_assert_cstring_equal(scientific_number_text, "1024.0");
 
   UtObjectRef one_M = ut_float64_new(1000000);
   ut_cstring_ref one_M_text = ut_json_encoder_encode(encoder, one_M);
-  ut_assert_cstring_equal(one_M_text, "1.000000e+06");
+  ut_assert_cstring_equal(one_M_text, "1000000.0");
 
   UtObjectRef one_u = ut_float64_new(0.000001);
   ut_cstring_ref one_u_text = ut_json_encoder_encode(encoder, one_u);
-  ut_assert_cstring_equal(one_u_text, "1.000000e-06");
+  ut_assert_cstring_equal(one_u_text, "0.000001");
+
+  UtObjectRef float_zero = ut_float64_new(0.0);
+  ut_cstring_ref float_zero_text = ut_json_encoder_encode(encoder, float_zero);
+  ut_assert_cstring_equal(float_zero_text, "0.0");
+
+  UtObjectRef inexact_sum = ut_float64_new(0.1 + 0.2);
+  ut_cstring_ref inexact_sum_text =
+      ut_json_encoder_encode(encoder, inexact_sum);
+  ut_assert_cstring_equal(inexact_sum_text, "0.30000000000000004");
+
+  UtObjectRef large_float = ut_float64_new(1.7976931348623157e308);
+  ut_cstring_ref large_float_text =
+      ut_json_encoder_encode(encoder, large_float);
+  ut_assert_cstring_equal(large_float_text, "1.7976931348623157e308");
+
+  UtObjectRef small_float = ut_float64_new(5e-324);
+  ut_cstring_ref small_float_text =
+      ut_json_encoder_encode(encoder, small_float);
+  ut_assert_cstring_equal(small_float_text, "5e-324");
+
+  UtObjectRef tiny_float = ut_float64_new(-1.5e-7);
+  ut_cstring_ref tiny_float_text = ut_json_encoder_encode(encoder, tiny_float);
+  ut_assert_cstring_equal(tiny_float_text, "-1.5e-7");
+
+  UtObjectRef infinity = ut_float64_new(INFINITY);
+  ut_cstring_ref infinity_text = ut_json_encoder_encode(encoder, infinity);
+  ut_assert_cstring_equal(infinity_text, "null");
+
+  // Floating point values are decoded back to the same value.
+  double round_trip_value = 1.0;
+  for (size_t i = 0; i < 1000; i++) {
+    round_trip_value = round_trip_value * 1.7 + 0.3 / round_trip_value;
+    if (round_trip_value > 1e100) {
+      round_trip_value = 1e-100;
+    }
+    UtObjectRef value = ut_float64_new(round_trip_value);
+    ut_cstring_ref value_text = ut_json_encoder_encode(encoder, value);
+    UtObjectRef decoded_value = ut_json_decode(value_text);
+    ut_assert_non_null_object(decoded_value);
+    ut_assert_true(ut_object_is_float64(decoded_value));
+    ut_assert_true(ut_float64_get_value(decoded_value) == round_trip_value);
+  }
+
+  UtObjectRef min_int = ut_int64_new(INT64_MIN);
+  ut_cstring_ref min_int_text = ut_json_encoder_encode(encoder, min_int);
+  ut_assert_cstring_equal(min_int_text, "-9223372036854775808");
 
   UtObjectRef empty_string = ut_string_new("");
   ut_cstring_ref empty_string_text =
@@ -79,6 +127,17 @@ static void test_encode() {
       ut_json_encoder_encode(encoder, emoji_string);
   ut_assert_cstring_equal(emoji_string_text, "\"😀\"");
 
+  UtObjectRef long_string = ut_string_new("");
+  for (size_t i = 0; i < 100; i++) {
+    ut_string_append(long_string, "0123456789\"\x01");
+  }
+  ut_cstring_ref long_string_text =
+      ut_json_encoder_encode(encoder, long_string);
+  UtObjectRef decoded_long_string = ut_json_decode(long_string_text);
+  ut_assert_non_null_object(decoded_long_string);
+  ut_assert_cstring_equal(ut_string_get_text(decoded_long_string),
+                          ut_string_get_text(long_string));
+
   UtObjectRef empty_array = ut_list_new();
   ut_cstring_ref empty_array_text =
       ut_json_encoder_encode(encoder, empty_array);
@@ -98,7 +157,7 @@ static void test_encode() {
   ut_list_append_take(mixed_array, ut_float64_new(3.1));
   ut_cstring_ref mixed_array_text =
       ut_json_encoder_encode(encoder, mixed_array);
-  ut_assert_cstring_equal(mixed_array_text, "[false,\"two\",3.100000e+00]");
+  ut_assert_cstring_equal(mixed_array_text, "[false,\"two\",3.1]");
 
   UtObjectRef empty_object = ut_map_new();
   ut_cstring_ref empty_object_text =
@@ -120,6 +179,19 @@ static void test_encode() {
       ut_json_encoder_encode(encoder, mixed_object);
   ut_assert_cstring_equal(
       mixed_object_text, "{\"boolean\":true,\"number\":42,\"string\":\"foo\"}");
+
+  UtObjectRef stream_value = ut_list_new();
+  for (size_t i = 0; i < 10000; i++) {
+    ut_list_append_take(stream_value, ut_string_new("Hello World!"));
+  }
+  UtObjectRef stream_data = ut_uint8_array_new();
+  ut_json_encoder_encode_to_stream(encoder, stream_value, stream_data);
+  ut_cstring_ref stream_value_text =
+      ut_json_encoder_encode(encoder, stream_value);
+  ut_assert_int_equal(ut_list_get_length(stream_data),
+                      strlen(stream_value_text));
+  ut_assert_true(memcmp(ut_uint8_list_get_data(stream_data), stream_value_text,
+                        strlen(stream_value_text)) == 0);
 }
 
 static void test_decode() {
@@ -274,9 +346,301 @@ static void test_decode() {
   ut_assert_non_null_object(mixed_value3);
   ut_assert_true(ut_object_implements_string(mixed_value3));
   ut_assert_cstring_equal(ut_string_get_text(mixed_value3), "foo");
+
+  UtObjectRef whitespace_object =
+      ut_json_decode(" \n{ \"a\" : [ 1 , true , null ] }\t\r\n");
+  ut_assert_non_null_object(whitespace_object);
+  ut_assert_true(ut_object_implements_map(whitespace_object));
+  UtObject *whitespace_value = ut_map_lookup_string(whitespace_object, "a");
+  ut_assert_non_null_object(whitespace_value);
+  ut_assert_int_equal(ut_list_get_length(whitespace_value), 3);
+
+  UtObjectRef surrogate_pair_string = ut_json_decode("\"\\ud83d\\ude00\"");
+  ut_assert_non_null_object(surrogate_pair_string);
+  ut_assert_cstring_equal(ut_string_get_text(surrogate_pair_string), "😀");
+
+  UtObjectRef unpaired_surrogate_string = ut_json_decode("\"\\ud83dx\"");
+  ut_assert_non_null_object(unpaired_surrogate_string);
+  ut_assert_cstring_equal(ut_string_get_text(unpaired_surrogate_string),
+                          "\xef\xbf\xbdx");
+
+  UtObjectRef large_integer = ut_json_decode("9223372036854775807");
+  ut_assert_non_null_object(large_integer);
+  ut_assert_true(ut_object_is_int64(large_integer));
+  ut_assert_int_equal(ut_int64_get_value(large_integer), INT64_MAX);
+
+  UtObjectRef overflow_integer = ut_json_decode("9223372036854775808");
+  ut_assert_non_null_object(overflow_integer);
+  ut_assert_true(ut_object_is_float64(overflow_integer));
+
+  // Escapes and backslash runs that cross the 64 byte blocks used when
+  // scanning.
+  for (size_t prefix_length = 50; prefix_length < 70; prefix_length++) {
+    UtObjectRef text = ut_string_new("[\"");
+    for (size_t i = 0; i < prefix_length; i++) {
+      ut_string_append(text, "x");
+    }
+    ut_string_append(text, "\\\\\\\\\\\"\",\"{]\"]");
+    UtObjectRef value = ut_json_decode(ut_string_get_text(text));
+    ut_assert_non_null_object(value);
+    ut_assert_int_equal(ut_list_get_length(value), 2);
+    UtObject *escaped_value = ut_object_list_get_element(value, 0);
+    ut_assert_int_equal(strlen(ut_string_get_text(escaped_value)),
+                        prefix_length + 3);
+    ut_assert_cstring_equal(
+        ut_string_get_text(ut_object_list_get_element(value, 1)), "{]");
+  }
+
+  UtObjectRef long_text = ut_string_new("{\"key\":\"");
+  for (size_t i = 0; i < 1000; i++) {
+    ut_string_append(long_text, "é,:[");
+  }
+  ut_string_append(long_text, "\"}");
+  UtObjectRef long_object = ut_json_decode(ut_string_get_text(long_text));
+  ut_assert_non_null_object(long_object);
+  UtObject *long_value = ut_map_lookup_string(long_object, "key");
+  ut_assert_non_null_object(long_value);
+  ut_assert_int_equal(strlen(ut_string_get_text(long_value)), 5000);
+
+  UtObjectRef invalid_utf8_string = ut_json_decode("\"\xc3\"");
+  ut_assert_null_object(invalid_utf8_string);
+
+  UtObjectRef overlong_utf8_string = ut_json_decode("\"\xc0\xaf\"");
+  ut_assert_null_object(overlong_utf8_string);
+
+  UtObjectRef control_character_string = ut_json_decode("\"\n\"");
+  ut_assert_null_object(control_character_string);
+
+  UtObjectRef unterminated_string = ut_json_decode("\"abc");
+  ut_assert_null_object(unterminated_string);
+
+  UtObjectRef invalid_escape_string = ut_json_decode("\"\\x\"");
+  ut_assert_null_object(invalid_escape_string);
+
+  UtObjectRef trailing_value = ut_json_decode("[] []");
+  ut_assert_null_object(trailing_value);
+
+  UtObjectRef trailing_characters = ut_json_decode("1x");
+  ut_assert_null_object(trailing_characters);
+
+  UtObjectRef missing_comma = ut_json_decode("[1 2]");
+  ut_assert_null_object(missing_comma);
+
+  UtObjectRef leading_zero = ut_json_decode("01");
+  ut_assert_null_object(leading_zero);
+}
+
+static void object_start_cb(UtObject *object) { ut_string_append(object, "{"); }
+
+static void object_end_cb(UtObject *object) { ut_string_append(object, "}"); }
+
+static void array_start_cb(UtObject *object) { ut_string_append(object, "["); }
+
+static void array_end_cb(UtObject *object) { ut_string_append(object, "]"); }
+
+static void key_cb(UtObject *object, const char *key) {
+  ut_string_append_printf(object, "<%s>", key);
+}
+
+static void string_cb(UtObject *object, const char *text, size_t text_length,
+                      bool complete) {
+  ut_string_append_printf(object, "'%.*s'%s", (int)text_length, text,
+                          complete ? "" : "+");
+}
+
+static void int64_cb(UtObject *object, int64_t value) {
+  ut_string_append_printf(object, "i%li", value);
+}
+
+static void float64_cb(UtObject *object, double value) {
+  ut_string_append_printf(object, "f%g", value);
+}
+
+static void boolean_cb(UtObject *object, bool value) {
+  ut_string_append(object, value ? "T" : "F");
+}
+
+static void null_cb(UtObject *object) { ut_string_append(object, "N"); }
+
+static void complete_cb(UtObject *object) { ut_string_append(object, "."); }
+
+static UtJsonDecoderCallbacks decoder_callbacks = {
+    .object_start = object_start_cb,
+    .object_end = object_end_cb,
+    .array_start = array_start_cb,
+    .array_end = array_end_cb,
+    .key = key_cb,
+    .string = string_cb,
+    .int64 = int64_cb,
+    .float64 = float64_cb,
+    .boolean = boolean_cb,
+    .null = null_cb,
+    .complete = complete_cb};
+
+// Decodes [text] written in blocks of [block_size] and returns the events.
+static char *decode_events(const char *text, size_t block_size) {
+  UtObjectRef input_stream = ut_writable_input_stream_new();
+  UtObjectRef decoder = ut_json_decoder_new(input_stream);
+  UtObjectRef events = ut_string_new("");
+  ut_json_decoder_decode(decoder, events, &decoder_callbacks);
+
+  size_t text_length = strlen(text);
+  size_t offset = 0;
+  do {
+    size_t length = text_length - offset;
+    if (block_size > 0 && length > block_size) {
+      length = block_size;
+    }
+    UtObjectRef data =
+        ut_uint8_list_new_from_data((const uint8_t *)text + offset, length);
+    offset += length;
+    ut_writable_input_stream_write(input_stream, data, offset == text_length);
+  } while (offset < text_length);
+
+  if (ut_json_decoder_get_error(decoder) != NULL) {
+    ut_string_append(events, "!");
+  }
+
+  return ut_string_take_text(events);
+}
+
+static void test_decode_lazy() {
+  UtObjectRef invalid_text = ut_string_new("{\"a\":[1,2}");
+  UtObjectRef invalid = ut_json_decode_lazy(invalid_text);
+  ut_assert_null_object(invalid);
+
+  // Invalid values are detected even if they are not accessed.
+  UtObjectRef invalid_number_text = ut_string_new("{\"a\":1,\"b\":01}");
+  UtObjectRef invalid_number = ut_json_decode_lazy(invalid_number_text);
+  ut_assert_null_object(invalid_number);
+
+  UtObjectRef invalid_escape_text = ut_string_new("[\"\\q\"]");
+  UtObjectRef invalid_escape = ut_json_decode_lazy(invalid_escape_text);
+  ut_assert_null_object(invalid_escape);
+
+  UtObjectRef number_text = ut_string_new("42");
+  UtObjectRef number = ut_json_decode_lazy(number_text);
+  ut_assert_non_null_object(number);
+  ut_assert_true(ut_object_is_int64(number));
+  ut_assert_int_equal(ut_int64_get_value(number), 42);
+
+  UtObjectRef text = ut_string_new(
+      "{\"id\": 7, \"tags\": [\"a\", [], {}, \"b\"], "
+      "\"nested\": {\"x\": {\"y\": [1.5, null]}}, "
+      "\"escaped\\u0021\": true, \"id2\": \"seven\", \"id\": 8}");
+  UtObjectRef document = ut_json_decode_lazy(text);
+  ut_assert_non_null_object(document);
+  ut_assert_true(ut_object_implements_map(document));
+  ut_assert_int_equal(ut_map_get_length(document), 5);
+
+  // Later values replace earlier ones with the same key.
+  UtObject *id = ut_map_lookup_string(document, "id");
+  ut_assert_non_null_object(id);
+  ut_assert_int_equal(ut_int64_get_value(id), 8);
+
+  UtObject *id2 = ut_map_lookup_string(document, "id2");
+  ut_assert_non_null_object(id2);
+  ut_assert_cstring_equal(ut_string_get_text(id2), "seven");
+
+  ut_assert_null_object(ut_map_lookup_string(document, "i"));
+  ut_assert_null_object(ut_map_lookup_string(document, "id\": 7"));
+
+  UtObject *escaped = ut_map_lookup_string(document, "escaped!");
+  ut_assert_non_null_object(escaped);
+  ut_assert_true(ut_boolean_get_value(escaped));
+
+  UtObject *tags = ut_map_lookup_string(document, "tags");
+  ut_assert_non_null_object(tags);
+  ut_assert_true(ut_object_implements_list(tags));
+  ut_assert_int_equal(ut_list_get_length(tags), 4);
+  ut_assert_cstring_equal(
+      ut_string_get_text(ut_object_list_get_element(tags, 0)), "a");
+  ut_assert_int_equal(
+      ut_list_get_length(ut_object_list_get_element(tags, 1)), 0);
+  ut_assert_int_equal(ut_map_get_length(ut_object_list_get_element(tags, 2)),
+                      0);
+  ut_assert_cstring_equal(
+      ut_string_get_text(ut_object_list_get_element(tags, 3)), "b");
+
+  UtObject *x = ut_map_lookup_string(
+      ut_map_lookup_string(document, "nested"), "x");
+  ut_assert_non_null_object(x);
+  UtObject *y = ut_map_lookup_string(x, "y");
+  ut_assert_non_null_object(y);
+  ut_assert_int_equal(ut_list_get_length(y), 2);
+  ut_assert_float_equal(
+      ut_float64_get_value(ut_object_list_get_element(y, 0)), 1.5);
+  ut_assert_true(ut_object_is_null(ut_object_list_get_element(y, 1)));
+
+  // Modifying the map decodes all the members.
+  ut_map_insert_string_take(document, "new", ut_int64_new(9));
+  ut_assert_int_equal(ut_map_get_length(document), 6);
+  ut_assert_int_equal(
+      ut_int64_get_value(ut_map_lookup_string(document, "new")), 9);
+  ut_assert_int_equal(ut_int64_get_value(ut_map_lookup_string(document, "id")),
+                      8);
+}
+
+static void test_decoder() {
+  ut_cstring_ref empty = decode_events("", 0);
+  ut_assert_cstring_equal(empty, ".!");
+
+  ut_cstring_ref keywords = decode_events("true false null", 0);
+  ut_assert_cstring_equal(keywords, "TFN.");
+
+  ut_cstring_ref unknown_keyword = decode_events("foo", 0);
+  ut_assert_cstring_equal(unknown_keyword, ".!");
+
+  ut_cstring_ref numbers = decode_events("[0,-1,1024,1.5,1e3,-2.5E-1]", 0);
+  ut_assert_cstring_equal(numbers, "[i0i-1i1024f1.5f1000f-0.25].");
+
+  ut_cstring_ref invalid_number = decode_events("01", 0);
+  ut_assert_cstring_equal(invalid_number, ".!");
+
+  ut_cstring_ref big_number = decode_events("18446744073709551616", 0);
+  ut_assert_cstring_equal(big_number, "f1.84467e+19.");
+
+  ut_cstring_ref object =
+      decode_events("{\"one\": 1, \"two\": [true, null], \"three\": {}}", 0);
+  ut_assert_cstring_equal(object, "{<one>i1<two>[TN]<three>{}}.");
+
+  ut_cstring_ref escaped_string =
+      decode_events("\"\\\"\\\\\\/\\n\\t\\u0041\\ud83d\\ude00\"", 0);
+  ut_assert_cstring_equal(escaped_string, "'\"\\/\n\tA😀'.");
+
+  ut_cstring_ref unpaired_surrogate = decode_events("\"\\ud83dx\"", 0);
+  ut_assert_cstring_equal(unpaired_surrogate, "'\xef\xbf\xbdx'.");
+
+  ut_cstring_ref multiple_values = decode_events("{}\n[]\n\"x\"\n", 0);
+  ut_assert_cstring_equal(multiple_values, "{}[]'x'.");
+
+  ut_cstring_ref unterminated_array = decode_events("[1,", 0);
+  ut_assert_cstring_equal(unterminated_array, "[i1.!");
+
+  ut_cstring_ref mismatched_container = decode_events("[1}", 0);
+  ut_assert_cstring_equal(mismatched_container, "[i1.!");
+
+  ut_cstring_ref control_character = decode_events("\"\x01\"", 0);
+  ut_assert_cstring_equal(control_character, ".!");
+
+  ut_cstring_ref invalid_utf8 = decode_events("\"\xff\"", 0);
+  ut_assert_cstring_equal(invalid_utf8, ".!");
+
+  // Tokens split across blocks.
+  ut_cstring_ref split_tokens =
+      decode_events("{\"key\":[12345,true,\"\\u0041\"]}", 1);
+  ut_assert_cstring_equal(split_tokens, "{<key>[i12345T'A'+'']}.");
+
+  // Strings are passed on in slices that never split a UTF-8 sequence.
+  ut_cstring_ref string_slices = decode_events("\"abcdef\"", 4);
+  ut_assert_cstring_equal(string_slices, "'abc'+'def'.");
+  ut_cstring_ref utf8_slices = decode_events("\"a😀b\"", 3);
+  ut_assert_cstring_equal(utf8_slices, "'a'+'😀'+'b'.");
 }
 
 int main(int argc, char **argv) {
   test_encode();
   test_decode();
+  test_decode_lazy();
+  test_decoder();
 }
@@ -1,71 +1,40 @@
+#include <errno.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "ut-json-private.h"
+#include "ut-json-scanner.h"
 #include "ut.h"
 
-static UtObject *decode_value(const char *text, size_t *offset);
+// JSON is decoded in two stages. First the text is scanned to find the offset
+// of each token (see ut-json-scanner.c), then the values are built by walking
+// the tokens.
 
-static bool get_utf8_code_point(const char *text, size_t *offset,
-                                uint32_t *code_point) {
-  uint8_t byte1 = text[*offset];
-  if ((byte1 & 0x80) == 0) {
-    *code_point = byte1;
-    (*offset)++;
-    return true;
-  } else if ((byte1 & 0xe0) == 0xc0) {
-    uint8_t byte2;
-    if ((byte2 = text[*offset + 1]) == '\0') {
-      return false;
-    }
-    if ((byte2 & 0xc0) != 0x80) {
-      // FIXME: Throw an error (invalid utf-8)
-      return false;
-    }
-    *code_point = (byte1 & 0x1f) << 6 | (byte2 & 0x3f);
-    (*offset) += 2;
-    return true;
-  } else if ((byte1 & 0xf0) == 0xe0) {
-    uint8_t byte2, byte3;
-    if ((byte2 = text[*offset + 1]) == '\0' ||
-        (byte3 = text[*offset + 2]) == '\0') {
-      return false;
-    }
-    if ((byte2 & 0xc0) != 0x80 || (byte3 & 0xc0) != 0x80) {
-      // FIXME: Throw an error (invalid utf-8)
-      return false;
-    }
-    *code_point = (byte1 & 0x0f) << 12 | (byte2 & 0x3f) << 6 | (byte3 & 0x3f);
-    (*offset) += 3;
-    return true;
-  } else if ((byte1 & 0xf8) == 0xf0) {
-    uint8_t byte2, byte3, byte4;
-    if ((byte2 = text[*offset + 1]) == '\0' ||
-        (byte3 = text[*offset + 2]) == '\0' ||
-        (byte4 = text[*offset + 3]) == '\0') {
-      return false;
-    }
-    if ((byte2 & 0xc0) != 0x80 || (byte3 & 0xc0) != 0x80 ||
-        (byte4 & 0xc0) != 0x80) {
-      // FIXME: Throw an error (invalid utf-8)
-      return false;
-    }
-    *code_point = (byte1 & 0x07) << 18 | (byte2 & 0x3f) << 12 |
-                  (byte3 & 0x3f) << 6 | (byte4 & 0x3f);
-    (*offset) += 4;
-    return true;
-  } else {
-    // FIXME: Throw an error (invalid utf-8)
+typedef struct {
+  const char *text;
+  const uint32_t *indexes;
+  size_t n_indexes;
+  size_t index;
+} Decoder;
+
+static UtObject *decode_value(Decoder *decoder);
+
+static bool next_token(Decoder *decoder, size_t *offset) {
+  if (decoder->index >= decoder->n_indexes) {
     return false;
   }
+  *offset = decoder->indexes[decoder->index];
+  decoder->index++;
+  return true;
 }
 
-static int decode_digit(char c) {
-  if (c >= '0' && c <= '9') {
-    return c - '0';
-  } else {
-    return -1;
+static char peek_token(Decoder *decoder) {
+  if (decoder->index >= decoder->n_indexes) {
+    return '\0';
   }
+  return decoder->text[decoder->indexes[decoder->index]];
 }
 
 static int decode_hex(char c) {
@@ -80,219 +49,289 @@ static int decode_hex(char c) {
   }
 }
 
-static bool is_whitespace(char c) {
-  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// Returns true if [c] can follow a number or keyword.
+static bool is_value_end(char c) {
+  switch (c) {
+  case '\0':
+  case ' ':
+  case '\n':
+  case '\r':
+  case '\t':
+  case ',':
+  case ':':
+  case ']':
+  case '}':
+  case '[':
+  case '{':
+    return true;
+  default:
+    return false;
+  }
 }
 
-static void decode_whitespace(const char *text, size_t *offset) {
-  while (is_whitespace(text[*offset])) {
-    (*offset)++;
+static bool decode_unicode_escape(const char *text, uint32_t *code_point) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; i++) {
+    int hex = decode_hex(text[i]);
+    if (hex < 0) {
+      // FIXME: Throw an error (invalid escape sequence)
+      return false;
+    }
+    value = value << 4 | hex;
   }
+  *code_point = value;
+  return true;
 }
 
-static UtObject *decode_string(const char *text, size_t *offset) {
-  size_t end = *offset;
-  if (text[end] != '\"') {
-    return NULL;
+static size_t encode_utf8(uint32_t code_point, char *buffer) {
+  if (code_point <= 0x7f) {
+    buffer[0] = code_point;
+    return 1;
+  } else if (code_point <= 0x7ff) {
+    buffer[0] = 0xc0 | (code_point >> 6);
+    buffer[1] = 0x80 | (code_point & 0x3f);
+    return 2;
+  } else if (code_point <= 0xffff) {
+    buffer[0] = 0xe0 | (code_point >> 12);
+    buffer[1] = 0x80 | ((code_point >> 6) & 0x3f);
+    buffer[2] = 0x80 | (code_point & 0x3f);
+    return 3;
+  } else {
+    buffer[0] = 0xf0 | (code_point >> 18);
+    buffer[1] = 0x80 | ((code_point >> 12) & 0x3f);
+    buffer[2] = 0x80 | ((code_point >> 6) & 0x3f);
+    buffer[3] = 0x80 | (code_point & 0x3f);
+    return 4;
   }
-  end++;
+}
 
-  UtObjectRef value = ut_string_new("");
-  while (true) {
-    if (text[end] == '\"') {
-      *offset = end + 1;
-      return ut_object_ref(value);
+// Unescape the string in [start] to [end] into [buffer], which must be at
+// least the same length as the escaped string.
+static bool unescape_string(const char *start, const char *end, char *buffer,
+                            size_t *length) {
+  size_t buffer_length = 0;
+  const char *c = start;
+  while (c < end) {
+    const char *escape = memchr(c, '\\', end - c);
+    if (escape == NULL) {
+      escape = end;
+    }
+    memcpy(buffer + buffer_length, c, escape - c);
+    buffer_length += escape - c;
+    c = escape;
+    if (c == end) {
+      break;
     }
 
     uint32_t code_point;
-    if (text[end] == '\\') {
-      switch (text[end + 1]) {
-      case '\"':
-        code_point = '"';
-        break;
-      case '\\':
-        code_point = '\\';
-        break;
-      case '/':
-        code_point = '/';
-        break;
-      case 'b':
-        code_point = '\b';
-        break;
-      case 'f':
-        code_point = '\f';
-        break;
-      case 'n':
-        code_point = '\n';
-        break;
-      case 'r':
-        code_point = '\r';
-        break;
-      case 't':
-        code_point = '\t';
-        break;
-      case 'u':
-        if (text[end + 2] == '\0' || text[end + 3] == '\0' ||
-            text[end + 4] == '\0' || text[end + 5] == '\0') {
-          return NULL;
-        }
-        int hex1 = decode_hex(text[end + 2]);
-        int hex2 = decode_hex(text[end + 3]);
-        int hex3 = decode_hex(text[end + 4]);
-        int hex4 = decode_hex(text[end + 5]);
-        if (hex1 < 0 || hex2 < 0 || hex3 < 0 || hex4 < 0) {
-          // FIXME: Throw an error (invalid escape sequence)
-          return NULL;
-        }
-        code_point = hex1 << 12 | hex2 << 8 | hex3 << 4 | hex4;
-        end += 4;
-        break;
-      case '\0':
-        return NULL;
-      default:
-        // FIXME: Throw an error (unknown escape sequence)
-        return NULL;
-      }
-      end += 2;
-    } else {
-      if (!get_utf8_code_point(text, &end, &code_point)) {
-        return NULL;
+    switch (c[1]) {
+    case '"':
+      code_point = '"';
+      break;
+    case '\\':
+      code_point = '\\';
+      break;
+    case '/':
+      code_point = '/';
+      break;
+    case 'b':
+      code_point = '\b';
+      break;
+    case 'f':
+      code_point = '\f';
+      break;
+    case 'n':
+      code_point = '\n';
+      break;
+    case 'r':
+      code_point = '\r';
+      break;
+    case 't':
+      code_point = '\t';
+      break;
+    case 'u':
+      if (end - c < 6 || !decode_unicode_escape(c + 2, &code_point)) {
+        return false;
       }
-
-      if (code_point <= 0x1f || code_point == 0x7f) {
-        // FIXME: Throw an error (control characters not allowed)
-        return NULL;
+      c += 4;
+
+      // Combine UTF-16 surrogate pairs, replace unpaired surrogates.
+      if (code_point >= 0xd800 && code_point <= 0xdbff) {
+        uint32_t low_surrogate;
+        if (end - c >= 8 && c[2] == '\\' && c[3] == 'u' &&
+            decode_unicode_escape(c + 4, &low_surrogate) &&
+            low_surrogate >= 0xdc00 && low_surrogate <= 0xdfff) {
+          code_point = 0x10000 + ((code_point - 0xd800) << 10) +
+                       (low_surrogate - 0xdc00);
+          c += 6;
+        } else {
+          code_point = 0xfffd;
+        }
+      } else if (code_point >= 0xdc00 && code_point <= 0xdfff) {
+        code_point = 0xfffd;
       }
+      break;
+    default:
+      // FIXME: Throw an error (unknown escape sequence)
+      return false;
     }
+    c += 2;
 
-    ut_string_append_code_point(value, code_point);
+    buffer_length += encode_utf8(code_point, buffer + buffer_length);
   }
-}
 
-static UtObject *decode_number(const char *text, size_t *offset) {
-  size_t end = *offset;
+  *length = buffer_length;
+  return true;
+}
 
-  int64_t sign = 1;
-  if (text[end] == '-') {
-    sign = -1;
+UtObject *json_decode_string(const char *text, size_t offset) {
+  // The scanner has already checked the string is terminated and contains
+  // valid UTF-8 without control characters.
+  const char *start = text + offset + 1;
+  const char *end = start;
+  bool has_escapes = false;
+  while (*end != '"') {
+    if (*end == '\\') {
+      has_escapes = true;
+      end++;
+    }
     end++;
   }
 
-  int64_t value = decode_digit(text[end]);
-  if (value < 0) {
-    // FIXME: Throw an error (invalid number)
-    return NULL;
+  if (!has_escapes) {
+    return ut_string_new_sized(start, end - start);
   }
-  end++;
-  if (value != 0) {
-    int digit;
-    while ((digit = decode_digit(text[end])) >= 0) {
-      value = value * 10 + digit;
-      end++;
-    }
+
+  char *buffer = malloc(end - start);
+  size_t length;
+  UtObject *value = NULL;
+  if (unescape_string(start, end, buffer, &length)) {
+    value = ut_string_new_sized(buffer, length);
   }
+  free(buffer);
+  return value;
+}
 
-  bool floating = false;
-  double fraction = 0.0;
-  if (text[end] == '.') {
-    end++;
+// Check the number at [offset] in [text] is valid and if it has a fraction or
+// exponent. [n_digits] is set to the number of integer digits and [value] to
+// their value if they fit.
+static bool scan_number(const char *text, size_t offset, bool *floating,
+                        uint64_t *value, size_t *n_digits) {
+  const char *c = text + offset;
+  if (*c == '-') {
+    c++;
+  }
 
-    floating = true;
+  *value = 0;
+  *n_digits = 0;
+  if (*c == '0') {
+    c++;
+  } else if (is_digit(*c)) {
+    while (is_digit(*c)) {
+      *value = *value * 10 + (*c - '0');
+      (*n_digits)++;
+      c++;
+    }
+  } else {
+    // FIXME: Throw an error (invalid number)
+    return false;
+  }
 
-    double numerator = decode_digit(text[end]);
-    double denominator = 10;
-    if (numerator < 0) {
+  *floating = false;
+  if (*c == '.') {
+    c++;
+    *floating = true;
+    if (!is_digit(*c)) {
       // FIXME: Throw an error
-      return NULL;
+      return false;
     }
-    end++;
-    int digit;
-    while ((digit = decode_digit(text[end])) >= 0) {
-      numerator = numerator * 10 + digit;
-      denominator *= 10;
-      end++;
+    while (is_digit(*c)) {
+      c++;
     }
-    fraction = numerator / denominator;
   }
 
-  int64_t exponent = 0;
-  if (text[end] == 'e' || text[end] == 'E') {
-    end++;
-
-    int64_t exponent_sign = 1;
-    if (text[end] == '+' || text[end] == '-') {
-      exponent_sign = -1;
-      end++;
+  if (*c == 'e' || *c == 'E') {
+    c++;
+    *floating = true;
+    if (*c == '+' || *c == '-') {
+      c++;
     }
-
-    exponent = decode_digit(text[end]);
-    if (exponent < 0) {
+    if (!is_digit(*c)) {
       // FIXME: Throw an error
-      return NULL;
+      return false;
     }
-    end++;
-    int digit;
-    while ((digit = decode_digit(text[end])) >= 0) {
-      exponent = exponent * 10 + digit;
-      end++;
+    while (is_digit(*c)) {
+      c++;
     }
+  }
 
-    exponent *= exponent_sign;
+  if (!is_value_end(*c)) {
+    // FIXME: Throw an error (invalid number)
+    return false;
   }
-  if (exponent != 0) {
-    floating = true;
+
+  return true;
+}
+
+static UtObject *decode_number(const char *text, size_t offset) {
+  bool floating;
+  uint64_t value;
+  size_t n_digits;
+  if (!scan_number(text, offset, &floating, &value, &n_digits)) {
+    return NULL;
   }
 
-  *offset = end;
-  if (floating) {
-    double v = sign * (value + fraction);
-    for (int64_t i = 0; i < exponent; i++) {
-      v *= 10;
-    }
-    double divisor = 1;
-    for (int64_t i = exponent; i < 0; i++) {
-      divisor *= 10;
+  const char *start = text + offset;
+  if (!floating) {
+    // Accumulated digits are exact if they fit into 64 bits.
+    if (n_digits <= 18) {
+      return ut_int64_new(*start == '-' ? -(int64_t)value : (int64_t)value);
     }
-    return ut_float64_new(v / divisor);
-  } else {
-    for (int64_t i = 0; i < exponent; i++) {
-      value *= 10;
+
+    errno = 0;
+    int64_t int_value = strtoll(start, NULL, 10);
+    if (errno != ERANGE) {
+      return ut_int64_new(int_value);
     }
-    return ut_int64_new(sign * value);
   }
-}
 
-static UtObject *decode_object(const char *text, size_t *offset) {
-  size_t end = *offset;
-  if (text[end] != '{') {
-    return NULL;
-  }
-  end++;
+  // Integers that don't fit are returned as floating point.
+  return ut_float64_new(strtod(start, NULL));
+}
 
-  decode_whitespace(text, &end);
+static bool decode_keyword(const char *text, size_t offset,
+                           const char *keyword) {
+  size_t keyword_length = strlen(keyword);
+  return strncmp(text + offset, keyword, keyword_length) == 0 &&
+         is_value_end(text[offset + keyword_length]);
+}
 
+static UtObject *decode_object(Decoder *decoder) {
   UtObjectRef object = ut_map_new();
-  if (text[end] == '}') {
-    *offset = end + 1;
+  if (peek_token(decoder) == '}') {
+    decoder->index++;
     return ut_object_ref(object);
   }
 
   while (true) {
-    decode_whitespace(text, &end);
-    UtObjectRef key = decode_string(text, &end);
-    if (key == NULL) {
+    size_t offset;
+    if (!next_token(decoder, &offset) || decoder->text[offset] != '"') {
       // FIXME: Throw an error (invalid key in object)
       return NULL;
     }
+    UtObjectRef key = json_decode_string(decoder->text, offset);
+    if (key == NULL) {
+      return NULL;
+    }
 
-    decode_whitespace(text, &end);
-    if (text[end] != ':') {
+    if (!next_token(decoder, &offset) || decoder->text[offset] != ':') {
       // FIXME: Throw an error (invalid object)
       return NULL;
     }
-    end++;
 
-    UtObjectRef value = decode_value(text, &end);
+    UtObjectRef value = decode_value(decoder);
     if (value == NULL) {
       // FIXME: Throw an error (invalid value in object)
       return NULL;
@@ -300,35 +339,28 @@ static UtObject *decode_object(const char *text, size_t *offset) {
 
     ut_map_insert(object, key, value);
 
-    if (text[end] == '}') {
-      *offset = end + 1;
+    if (!next_token(decoder, &offset)) {
+      return NULL;
+    }
+    if (decoder->text[offset] == '}') {
       return ut_object_ref(object);
     }
-
-    if (text[end] != ',') {
+    if (decoder->text[offset] != ',') {
       // FIXME: Throw an error (invalid character beween objects)
       return NULL;
     }
-    end++;
   }
 }
-static UtObject *decode_array(const char *text, size_t *offset) {
-  size_t end = *offset;
-  if (text[end] != '[') {
-    return NULL;
-  }
-  end++;
-
-  decode_whitespace(text, &end);
 
+static UtObject *decode_array(Decoder *decoder) {
   UtObjectRef array = ut_object_array_new();
-  if (text[end] == ']') {
-    *offset = end + 1;
+  if (peek_token(decoder) == ']') {
+    decoder->index++;
     return ut_object_ref(array);
   }
 
   while (true) {
-    UtObjectRef value = decode_value(text, &end);
+    UtObjectRef value = decode_value(decoder);
     if (value == NULL) {
       // FIXME: Throw an error (invalid value in array)
       return NULL;
@@ -336,28 +368,24 @@ static UtObject *decode_array(const char *text, size_t *offset) {
 
     ut_list_append(array, value);
 
-    if (text[end] == ']') {
-      *offset = end + 1;
+    size_t offset;
+    if (!next_token(decoder, &offset)) {
+      return NULL;
+    }
+    if (decoder->text[offset] == ']') {
       return ut_object_ref(array);
     }
-
-    if (text[end] != ',') {
+    if (decoder->text[offset] != ',') {
       // FIXME: Throw an error
       return NULL;
     }
-    end++;
   }
 }
 
-static UtObject *decode_value(const char *text, size_t *offset) {
-  size_t end = *offset;
-  decode_whitespace(text, &end);
-
-  UtObject *value;
-  switch (text[end]) {
+UtObject *json_decode_scalar(const char *text, size_t offset) {
+  switch (text[offset]) {
   case '"':
-    value = decode_string(text, &end);
-    break;
+    return json_decode_string(text, offset);
   case '-':
   case '0':
   case '1':
@@ -369,65 +397,205 @@ static UtObject *decode_value(const char *text, size_t *offset) {
   case '7':
   case '8':
   case '9':
-    value = decode_number(text, &end);
-    break;
-  case '{':
-    value = decode_object(text, &end);
-    break;
-  case '[':
-    value = decode_array(text, &end);
-    break;
+    return decode_number(text, offset);
   case 't':
-    if (text[end + 1] != 'r' || text[end + 2] != 'u' || text[end + 3] != 'e') {
-      if (text[end + 1] != '\0' && text[end + 2] != '\0' &&
-          text[end + 3] != '\0') {
-        // FIXME: Throw an error (unknown keyword)
-      }
+    if (!decode_keyword(text, offset, "true")) {
+      // FIXME: Throw an error (unknown keyword)
       return NULL;
     }
-    end += 4;
-    value = ut_boolean_new(true);
-    break;
+    return ut_boolean_new(true);
   case 'f':
-    if (text[end + 1] != 'a' || text[end + 2] != 'l' || text[end + 3] != 's' ||
-        text[end + 4] != 'e') {
-      if (text[end + 1] != '\0' && text[end + 2] != '\0' &&
-          text[end + 3] != '\0' && text[end + 4] != '\0') {
-        // FIXME: Throw an error (unknown keyword)
-      }
+    if (!decode_keyword(text, offset, "false")) {
+      // FIXME: Throw an error (unknown keyword)
       return NULL;
     }
-    end += 5;
-    value = ut_boolean_new(false);
-    break;
+    return ut_boolean_new(false);
   case 'n':
-    if (text[end + 1] != 'u' || text[end + 2] != 'l' || text[end + 3] != 'l') {
-      if (text[end + 1] != '\0' && text[end + 2] != '\0' &&
-          text[end + 3] != '\0') {
-        // FIXME: Throw an error (unknown keyword)
-      }
+    if (!decode_keyword(text, offset, "null")) {
+      // FIXME: Throw an error (unknown keyword)
       return NULL;
     }
-    end += 4;
-    value = ut_null_new();
-    break;
-  case '\0':
-    return NULL;
+    return ut_null_new();
   default:
     // FIXME: Throw an error (unknown value)
     return NULL;
   }
-  if (value == NULL) {
+}
+
+static UtObject *decode_value(Decoder *decoder) {
+  size_t offset;
+  if (!next_token(decoder, &offset)) {
     return NULL;
   }
 
-  decode_whitespace(text, &end);
+  switch (decoder->text[offset]) {
+  case '{':
+    return decode_object(decoder);
+  case '[':
+    return decode_array(decoder);
+  default:
+    return json_decode_scalar(decoder->text, offset);
+  }
+}
 
-  *offset = end;
-  return value;
+// Check the string starting at [offset] in [text] has valid escape sequences.
+static bool check_string(const char *text, size_t offset) {
+  for (const char *c = text + offset + 1; *c != '"'; c++) {
+    if (*c != '\\') {
+      continue;
+    }
+    c++;
+    if (*c == 'u') {
+      for (size_t i = 0; i < 4; i++) {
+        c++;
+        if (decode_hex(*c) < 0) {
+          return false;
+        }
+      }
+    } else if (strchr("\"\\/bfnrt", *c) == NULL) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Check the scalar value at [offset] in [text] without decoding it.
+static bool check_scalar(const char *text, size_t offset) {
+  bool floating;
+  uint64_t value;
+  size_t n_digits;
+  switch (text[offset]) {
+  case '"':
+    return check_string(text, offset);
+  case 't':
+    return decode_keyword(text, offset, "true");
+  case 'f':
+    return decode_keyword(text, offset, "false");
+  case 'n':
+    return decode_keyword(text, offset, "null");
+  default:
+    return scan_number(text, offset, &floating, &value, &n_digits);
+  }
+}
+
+// Check the value at the current token is valid, and record the index of the
+// closing token of each object and array in [ends].
+static bool check_value(Decoder *decoder, uint32_t *ends) {
+  size_t start = decoder->index;
+  size_t offset;
+  if (!next_token(decoder, &offset)) {
+    return false;
+  }
+
+  const char *text = decoder->text;
+  char open = text[offset];
+  if (open != '{' && open != '[') {
+    ends[start] = start;
+    return check_scalar(text, offset);
+  }
+
+  char close = open == '{' ? '}' : ']';
+  if (peek_token(decoder) == close) {
+    ends[start] = decoder->index;
+    decoder->index++;
+    return true;
+  }
+
+  while (true) {
+    if (open == '{') {
+      if (!next_token(decoder, &offset) || text[offset] != '"' ||
+          !check_string(text, offset)) {
+        return false;
+      }
+      if (!next_token(decoder, &offset) || text[offset] != ':') {
+        return false;
+      }
+    }
+
+    if (!check_value(decoder, ends)) {
+      return false;
+    }
+
+    if (!next_token(decoder, &offset)) {
+      return false;
+    }
+    if (text[offset] == close) {
+      ends[start] = decoder->index - 1;
+      return true;
+    }
+    if (text[offset] != ',') {
+      return false;
+    }
+  }
 }
 
 UtObject *ut_json_decode(const char *text) {
-  size_t offset = 0;
-  return decode_value(text, &offset);
+  size_t text_length = strlen(text);
+  if (text_length > UINT32_MAX) {
+    return NULL;
+  }
+
+  uint32_t *indexes = malloc(sizeof(uint32_t) * (text_length + 1));
+  size_t n_indexes;
+  UtObject *value = NULL;
+  if (json_build_structural_index(text, text_length, indexes, &n_indexes)) {
+    Decoder decoder = {
+        .text = text, .indexes = indexes, .n_indexes = n_indexes, .index = 0};
+    value = decode_value(&decoder);
+
+    // Only whitespace is allowed after the value.
+    if (decoder.index != n_indexes) {
+      ut_object_clear(&value);
+    }
+  }
+  free(indexes);
+
+  return value;
+}
+
+UtObject *ut_json_decode_lazy(UtObject *text) {
+  const char *text_data = ut_string_get_text(text);
+  size_t text_length = strlen(text_data);
+  if (text_length > UINT32_MAX) {
+    return NULL;
+  }
+
+  uint32_t *indexes = malloc(sizeof(uint32_t) * (text_length + 1));
+  size_t n_indexes;
+  if (!json_build_structural_index(text_data, text_length, indexes,
+                                   &n_indexes)) {
+    free(indexes);
+    return NULL;
+  }
+
+  // The index was allocated for the worst case of every character being a
+  // token, so trim it as it is kept for the life of the document.
+  uint32_t *trimmed_indexes =
+      realloc(indexes, sizeof(uint32_t) * (n_indexes + 1));
+  if (trimmed_indexes != NULL) {
+    indexes = trimmed_indexes;
+  }
+
+  // Check the whole document is valid, so values can be decoded later
+  // without errors.
+  uint32_t *ends = malloc(sizeof(uint32_t) * (n_indexes + 1));
+  Decoder decoder = {.text = text_data,
+                     .indexes = indexes,
+                     .n_indexes = n_indexes,
+                     .index = 0};
+  if (!check_value(&decoder, ends) || decoder.index != n_indexes) {
+    free(indexes);
+    free(ends);
+    return NULL;
+  }
+
+  UtObjectRef document =
+      json_lazy_document_new(text, indexes, ends, n_indexes);
+  return json_lazy_value_new(document, 0);
+}
+
+char *ut_json_encode(UtObject *object) {
+  UtObjectRef encoder = ut_json_encoder_new();
+  return ut_json_encoder_encode(encoder, object);
 }
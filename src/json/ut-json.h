@@ -16,3 +16,14 @@ char *ut_json_encode(UtObject *object);
 /// !return-type UtString UtInt64 UtFloat64 UtMap UtList UtBoolean UtNull
 /// !return-ref
 UtObject *ut_json_decode(const char *text);
+
+/// Decode JSON encoded [text] on demand.
+/// The text is checked to be valid JSON, but values are only decoded when they
+/// are accessed. Objects and arrays are returned as a [UtMap] and [UtList]
+/// that refer to [text], which must not be modified while they are in use.
+/// This is faster than [ut_json_decode] when only part of a document is used.
+///
+/// !arg-type text UtString
+/// !return-type UtString UtInt64 UtFloat64 UtMap UtList UtBoolean UtNull
+/// !return-ref
+UtObject *ut_json_decode_lazy(UtObject *text);
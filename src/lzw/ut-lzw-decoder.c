@@ -1,6 +1,7 @@
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
-#include "ut-lzw-dictionary.h"
 #include "ut.h"
 
 typedef struct {
@@ -10,8 +11,22 @@ typedef struct {
   UtObject *callback_object;
   UtInputStreamCallback callback;
 
-  // Bytes that each code represents.
-  UtObject *dictionary;
+  // Number of symbols.
+  size_t n_symbols;
+
+  // Maximum number of codes in the dictionary.
+  size_t max_dictionary_length;
+
+  // Number of codes in the dictionary.
+  size_t dictionary_length;
+
+  // Dictionary entries. Each code represents the symbols of the [prefix] code
+  // followed by [suffix]. [first] is the first symbol of the code and
+  // [length] the total number of symbols.
+  uint16_t *prefix;
+  uint8_t *suffix;
+  uint8_t *first;
+  uint16_t *length;
 
   // Length of next code to read.
   size_t code_length;
@@ -27,8 +42,11 @@ typedef struct {
   // Last code word received.
   uint16_t last_code;
 
-  // Decoded data.
+  // Decoded data, [buffer_length] bytes of [buffer] are in use.
   UtObject *buffer;
+  uint8_t *buffer_data;
+  size_t buffer_size;
+  size_t buffer_length;
 } UtLzwDecoder;
 
 // Report error in decoding.
@@ -39,13 +57,39 @@ static void error(UtLzwDecoder *self, const char *description) {
   }
 }
 
+// Returns the code used to clear the dictionary.
+static uint16_t get_clear_code(UtLzwDecoder *self) { return self->n_symbols; }
+
+// Returns the code used to mark the end of the data.
+static uint16_t get_end_of_information_code(UtLzwDecoder *self) {
+  return self->n_symbols + 1;
+}
+
+// Returns true if no more codes can be added to the dictionary.
+static bool dictionary_is_full(UtLzwDecoder *self) {
+  return self->dictionary_length >= self->max_dictionary_length;
+}
+
+// Add a new dictionary entry that extends [code] with [b].
+static void dictionary_append(UtLzwDecoder *self, uint16_t code, uint8_t b) {
+  if (dictionary_is_full(self)) {
+    return;
+  }
+
+  size_t new_code = self->dictionary_length;
+  self->prefix[new_code] = code;
+  self->suffix[new_code] = b;
+  self->first[new_code] = self->first[code];
+  self->length[new_code] = self->length[code] + 1;
+  self->dictionary_length++;
+}
+
 // Update length of next code to read.
 static void update_code_length(UtLzwDecoder *self) {
-  size_t dictionary_length = ut_lzw_dictionary_get_length(self->dictionary);
+  size_t dictionary_length = self->dictionary_length;
 
   // We are one dictionary entry behind.
-  if (self->last_code != ut_lzw_dictionary_get_clear_code(self->dictionary) &&
-      !ut_lzw_dictionary_get_is_full(self->dictionary)) {
+  if (self->last_code != get_clear_code(self) && !dictionary_is_full(self)) {
     dictionary_length++;
   }
 
@@ -57,18 +101,53 @@ static void update_code_length(UtLzwDecoder *self) {
 // Create a mask for the last [length] bits in a 16 bit word.
 static uint16_t bit_mask(size_t length) { return 0xffff >> (16 - length); }
 
+// Make space for [length] more bytes in the output buffer and return a pointer
+// to them.
+static uint8_t *reserve_output(UtLzwDecoder *self, size_t length) {
+  size_t required_size = self->buffer_length + length;
+  if (required_size > self->buffer_size) {
+    size_t new_size = self->buffer_size * 2;
+    if (new_size < required_size) {
+      new_size = required_size;
+    }
+    ut_list_resize(self->buffer, new_size);
+    self->buffer_data = ut_uint8_list_get_writable_data(self->buffer);
+    self->buffer_size = new_size;
+  }
+
+  return self->buffer_data + self->buffer_length;
+}
+
+// Write the symbols for [code] into [output] last symbol first by following
+// the prefix chain.
+static void write_code_symbols(UtLzwDecoder *self, uint16_t code,
+                               uint8_t *output) {
+  for (size_t i = self->length[code]; i > 0; i--) {
+    output[i - 1] = self->suffix[code];
+    code = self->prefix[code];
+  }
+}
+
 static size_t read_cb(UtObject *object, UtObject *data, bool complete) {
   UtLzwDecoder *self = (UtLzwDecoder *)object;
 
   size_t data_length = ut_list_get_length(data);
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  UtObjectRef data_array = NULL;
+  if (d == NULL) {
+    data_array = ut_uint8_list_get_array(data);
+    d = ut_uint8_list_get_data(data_array);
+  }
 
+  uint16_t clear_code = get_clear_code(self);
+  uint16_t end_of_information_code = get_end_of_information_code(self);
   size_t offset = 0;
   bool have_eoi = false;
   while (true) {
     // Read bytes from input so we have sufficient bits for a code word.
     update_code_length(self);
     while (self->read_buffer_bits < self->code_length && offset < data_length) {
-      uint32_t b = ut_uint8_list_get_element(data, offset);
+      uint32_t b = d[offset];
       if (self->lsb_packing) {
         self->read_buffer |= b << self->read_buffer_bits;
       } else {
@@ -94,37 +173,36 @@ static size_t read_cb(UtObject *object, UtObject *data, bool complete) {
     self->read_buffer_bits -= self->code_length;
 
     // Process code.
-    uint16_t clear_code = ut_lzw_dictionary_get_clear_code(self->dictionary);
     if (code == clear_code) {
-      ut_lzw_dictionary_clear(self->dictionary);
+      self->dictionary_length = self->n_symbols + 2;
       self->last_code = clear_code;
       self->code_length = 0;
-    } else if (code == ut_lzw_dictionary_get_end_of_information_code(
-                           self->dictionary)) {
+    } else if (code == end_of_information_code) {
       ut_input_stream_close(self->input_stream);
       have_eoi = true;
       break;
     } else {
       uint8_t first_symbol;
-      size_t dictionary_length = ut_lzw_dictionary_get_length(self->dictionary);
-      if (code < dictionary_length) {
-        UtObject *entry = ut_lzw_dictionary_lookup(self->dictionary, code);
-        ut_list_append_list(self->buffer, entry);
-        first_symbol = ut_uint8_list_get_element(entry, 0);
-      } else if (code == dictionary_length && self->last_code != clear_code) {
-        UtObject *entry =
-            ut_lzw_dictionary_lookup(self->dictionary, self->last_code);
-        first_symbol = ut_uint8_list_get_element(entry, 0);
-        ut_list_append_list(self->buffer, entry);
-        ut_uint8_list_append(self->buffer, first_symbol);
+      if (code < self->dictionary_length) {
+        size_t length = self->length[code];
+        write_code_symbols(self, code, reserve_output(self, length));
+        self->buffer_length += length;
+        first_symbol = self->first[code];
+      } else if (code == self->dictionary_length &&
+                 self->last_code != clear_code) {
+        size_t length = self->length[self->last_code];
+        uint8_t *output = reserve_output(self, length + 1);
+        write_code_symbols(self, self->last_code, output);
+        first_symbol = self->first[self->last_code];
+        output[length] = first_symbol;
+        self->buffer_length += length + 1;
       } else {
         error(self, "Invalid code received");
         return offset;
       }
 
       if (self->last_code != clear_code) {
-        ut_lzw_dictionary_append(self->dictionary, self->last_code,
-                                 first_symbol);
+        dictionary_append(self, self->last_code, first_symbol);
       }
       self->last_code = code;
     }
@@ -135,13 +213,20 @@ static size_t read_cb(UtObject *object, UtObject *data, bool complete) {
     return offset;
   }
 
-  size_t buffer_length = ut_list_get_length(self->buffer);
-  if (buffer_length > 0 || have_eoi) {
+  if (self->buffer_length > 0 || have_eoi) {
+    UtObjectRef decoded_data =
+        ut_list_get_sublist(self->buffer, 0, self->buffer_length);
     size_t n_used =
         self->callback_object != NULL
-            ? self->callback(self->callback_object, self->buffer, have_eoi)
+            ? self->callback(self->callback_object, decoded_data, have_eoi)
             : 0;
-    ut_list_remove(self->buffer, 0, n_used);
+
+    // Move unused data to the start of the buffer so it doesn't keep growing.
+    if (n_used > 0 && n_used < self->buffer_length) {
+      memmove(self->buffer_data, self->buffer_data + n_used,
+              self->buffer_length - n_used);
+    }
+    self->buffer_length -= n_used;
   }
 
   return offset;
@@ -158,7 +243,11 @@ static void ut_lzw_decoder_cleanup(UtObject *object) {
   ut_input_stream_close(self->input_stream);
 
   ut_object_unref(self->input_stream);
-  ut_object_unref(self->dictionary);
+  ut_object_weak_unref(&self->callback_object);
+  free(self->prefix);
+  free(self->suffix);
+  free(self->first);
+  free(self->length);
   ut_object_unref(self->buffer);
 }
 
@@ -193,8 +282,29 @@ static UtObject *ut_lzw_decoder_new(size_t n_symbols,
   assert(input_stream != NULL);
   UtObject *object = ut_object_new(sizeof(UtLzwDecoder), &object_interface);
   UtLzwDecoder *self = (UtLzwDecoder *)object;
-  self->dictionary = ut_lzw_dictionary_new(n_symbols, max_dictionary_length);
-  self->last_code = ut_lzw_dictionary_get_clear_code(self->dictionary);
+  self->n_symbols = n_symbols;
+  self->max_dictionary_length = max_dictionary_length;
+  self->prefix = malloc(sizeof(uint16_t) * max_dictionary_length);
+  self->suffix = malloc(sizeof(uint8_t) * max_dictionary_length);
+  self->first = malloc(sizeof(uint8_t) * max_dictionary_length);
+  self->length = malloc(sizeof(uint16_t) * max_dictionary_length);
+
+  // Each symbol is a single entry, followed by the clear and end of
+  // information codes which have no symbols.
+  for (size_t i = 0; i < n_symbols; i++) {
+    self->prefix[i] = 0;
+    self->suffix[i] = i;
+    self->first[i] = i;
+    self->length[i] = 1;
+  }
+  for (size_t i = n_symbols; i < n_symbols + 2; i++) {
+    self->prefix[i] = 0;
+    self->suffix[i] = 0;
+    self->first[i] = 0;
+    self->length[i] = 0;
+  }
+  self->dictionary_length = n_symbols + 2;
+  self->last_code = get_clear_code(self);
   self->input_stream = ut_object_ref(input_stream);
   self->lsb_packing = lsb_packing;
   return object;
@@ -123,9 +123,53 @@ static void test_msb() {
   ut_assert_uint8_list_equal_hex(dictionary_reset_result, "a51a2190a296c0");
 }
 
+// Check [data] can be encoded and decoded back to the same data.
+static void check_round_trip(UtObject *data, size_t n_symbols,
+                             size_t max_dictionary_length, bool lsb_packing) {
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef encoder =
+      lsb_packing
+          ? ut_lzw_encoder_new_lsb(n_symbols, max_dictionary_length,
+                                   data_stream)
+          : ut_lzw_encoder_new_msb(n_symbols, max_dictionary_length,
+                                   data_stream);
+  UtObjectRef encoded_data = ut_input_stream_read_sync(encoder);
+  ut_assert_is_not_error(encoded_data);
+
+  UtObjectRef encoded_data_stream = ut_list_input_stream_new(encoded_data);
+  UtObjectRef decoder =
+      lsb_packing ? ut_lzw_decoder_new_lsb(n_symbols, max_dictionary_length,
+                                           encoded_data_stream)
+                  : ut_lzw_decoder_new_msb(n_symbols, max_dictionary_length,
+                                           encoded_data_stream);
+  UtObjectRef decoded_data = ut_input_stream_read_sync(decoder);
+  ut_assert_is_not_error(decoded_data);
+  ut_assert_equal(decoded_data, data);
+}
+
+// Encode enough data to fill the dictionary many times.
+static void test_round_trip() {
+  UtObjectRef data = ut_uint8_array_new_sized(65536);
+  uint8_t *d = ut_uint8_list_get_writable_data(data);
+  for (size_t i = 0; i < 65536; i++) {
+    d[i] = ((i * i) >> 7 ^ i >> 9) & 0xff;
+  }
+  check_round_trip(data, 256, 4096, true);
+  check_round_trip(data, 256, 4096, false);
+
+  UtObjectRef small_symbol_data = ut_uint8_array_new_sized(65536);
+  uint8_t *small_symbol_d = ut_uint8_list_get_writable_data(small_symbol_data);
+  for (size_t i = 0; i < 65536; i++) {
+    small_symbol_d[i] = (i * 7 ^ i >> 4) & 0x3;
+  }
+  check_round_trip(small_symbol_data, 4, 4096, true);
+  check_round_trip(small_symbol_data, 4, 64, false);
+}
+
 int main(int argc, char **argv) {
   test_lsb();
   test_msb();
+  test_round_trip();
 
   return 0;
 }
@@ -1,8 +1,12 @@
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
-#include "ut-lzw-dictionary.h"
 #include "ut.h"
 
+// Marks an unused entry in the dictionary hash table.
+#define EMPTY_KEY 0xffffffff
+
 typedef struct {
   UtObject object;
 
@@ -16,8 +20,18 @@ typedef struct {
   // Number of symbols.
   size_t n_symbols;
 
-  // Bytes that each code represents.
-  UtObject *dictionary;
+  // Maximum number of codes in the dictionary.
+  size_t max_dictionary_length;
+
+  // Number of codes in the dictionary.
+  size_t dictionary_length;
+
+  // Open addressed hash table mapping a prefix code and the following symbol
+  // to the code for that sequence.
+  uint32_t *dictionary_keys;
+  uint16_t *dictionary_codes;
+  size_t dictionary_mask;
+  size_t dictionary_hash_shift;
 
   // Length of next code to write.
   size_t code_length;
@@ -33,63 +47,62 @@ typedef struct {
   size_t unused_bits;
 } UtLzwEncoder;
 
-// Returns true if [data] matches [entry].
-static bool matches(UtObject *entry, UtObject *data) {
-  size_t entry_length = ut_list_get_length(entry);
-  size_t data_length = ut_list_get_length(data);
-  size_t max_length = data_length < entry_length ? data_length : entry_length;
-  for (size_t i = 0; i < max_length; i++) {
-    if (ut_uint8_list_get_element(entry, i) !=
-        ut_uint8_list_get_element(data, i)) {
-      return false;
-    }
-  }
+// Returns the code used to clear the dictionary.
+static uint16_t get_clear_code(UtLzwEncoder *self) { return self->n_symbols; }
 
-  return true;
+// Returns the code used to mark the end of the data.
+static uint16_t get_end_of_information_code(UtLzwEncoder *self) {
+  return self->n_symbols + 1;
 }
 
-// Find a dictionary match for the given data.
-static bool find_match(UtLzwEncoder *self, UtObject *data, bool complete,
-                       size_t *match_length, uint16_t *code) {
-  size_t data_length = ut_list_get_length(data);
-  size_t dictionary_length = ut_lzw_dictionary_get_length(self->dictionary);
-  UtObject *match = NULL;
-  size_t match_index = 0;
-  // FIXME: Reverse for efficiency (match longest first)
-  for (size_t i = 0; i < dictionary_length; i++) {
-    UtObject *entry = ut_lzw_dictionary_lookup(self->dictionary, i);
-    size_t entry_length = ut_list_get_length(entry);
-
-    // Existing match is longer.
-    if (match != NULL && entry_length < ut_list_get_length(match)) {
-      continue;
-    }
-
-    // Not enough data remaining for this entry.
-    if (entry_length > data_length && complete) {
-      continue;
-    }
+// Returns the hash table index to start probing for [key].
+static size_t hash_key(UtLzwEncoder *self, uint32_t key) {
+  return (uint32_t)(key * 2654435761u) >> self->dictionary_hash_shift;
+}
 
-    if (matches(entry, data)) {
-      match = entry;
-      match_index = i;
+// Reset the dictionary to contain only the symbols, clear and end of
+// information codes.
+static void clear_dictionary(UtLzwEncoder *self) {
+  memset(self->dictionary_keys, 0xff,
+         sizeof(uint32_t) * (self->dictionary_mask + 1));
+  self->dictionary_length = self->n_symbols + 2;
+}
 
-      // May be able to match longer if have more data.
-      if (entry_length > data_length && !complete) {
-        return false;
-      }
+// Find the code for [prefix] followed by [b]. Returns false if not in the
+// dictionary.
+static bool lookup_code(UtLzwEncoder *self, uint16_t prefix, uint8_t b,
+                        uint16_t *code) {
+  uint32_t key = (uint32_t)prefix << 8 | b;
+  for (size_t i = hash_key(self, key);; i = (i + 1) & self->dictionary_mask) {
+    uint32_t k = self->dictionary_keys[i];
+    if (k == key) {
+      *code = self->dictionary_codes[i];
+      return true;
+    } else if (k == EMPTY_KEY) {
+      return false;
     }
   }
+}
+
+// Add a new dictionary entry that extends [prefix] with [b].
+static void append_code(UtLzwEncoder *self, uint16_t prefix, uint8_t b) {
+  if (self->dictionary_length >= self->max_dictionary_length) {
+    return;
+  }
 
-  *match_length = ut_list_get_length(match);
-  *code = match_index;
-  return true;
+  uint32_t key = (uint32_t)prefix << 8 | b;
+  size_t i = hash_key(self, key);
+  while (self->dictionary_keys[i] != EMPTY_KEY) {
+    i = (i + 1) & self->dictionary_mask;
+  }
+  self->dictionary_keys[i] = key;
+  self->dictionary_codes[i] = self->dictionary_length;
+  self->dictionary_length++;
 }
 
 // Update length of next code to read.
 static void update_code_length(UtLzwEncoder *self) {
-  size_t dictionary_length = ut_lzw_dictionary_get_length(self->dictionary);
-  while (dictionary_length > (1 << self->code_length)) {
+  while (self->dictionary_length > (1 << self->code_length)) {
     self->code_length++;
   }
 }
@@ -135,41 +148,51 @@ static size_t read_cb(UtObject *object, UtObject *data, bool complete) {
   UtLzwEncoder *self = (UtLzwEncoder *)object;
 
   size_t data_length = ut_list_get_length(data);
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  UtObjectRef data_array = NULL;
+  if (d == NULL) {
+    data_array = ut_uint8_list_get_array(data);
+    d = ut_uint8_list_get_data(data_array);
+  }
+
   size_t offset = 0;
   while (offset < data_length) {
-    assert(ut_uint8_list_get_element(data, 0) < self->n_symbols);
+    assert(d[offset] < self->n_symbols);
+
+    // Find the longest match in our dictionary by extending the match one
+    // symbol at a time.
+    uint16_t code = d[offset];
+    size_t end = offset + 1;
+    while (end < data_length && lookup_code(self, code, d[end], &code)) {
+      end++;
+    }
 
-    // Find the longest match in our dictionary.
-    UtObjectRef d = ut_list_get_sublist(data, offset, data_length - offset);
-    size_t match_length;
-    uint16_t code;
-    if (!find_match(self, d, complete, &match_length, &code)) {
+    // May be able to match longer if have more data.
+    if (end == data_length && !complete) {
       break;
     }
+
     write_code(self, code);
-    offset += match_length;
+    offset = end;
 
     // New dictionary entry with next symbol appended to just used match.
     // Note on the last code an entry is written using 0 to ensure the following
     // code is the correct length.
-    uint8_t b =
-        offset < data_length ? ut_uint8_list_get_element(data, offset) : 0;
-    ut_lzw_dictionary_append(self->dictionary, code, b);
+    append_code(self, code, offset < data_length ? d[offset] : 0);
 
     // Reset dictionary when it's full.
     // FIXME: Ideally would look ahead and determine if current dictionary is
     // sufficient.
-    if (ut_lzw_dictionary_get_is_full(self->dictionary)) {
-      write_code(self, ut_lzw_dictionary_get_clear_code(self->dictionary));
+    if (self->dictionary_length >= self->max_dictionary_length) {
+      write_code(self, get_clear_code(self));
 
-      ut_lzw_dictionary_clear(self->dictionary);
+      clear_dictionary(self);
       self->code_length = 0;
     }
   }
 
   if (complete) {
-    write_code(self,
-               ut_lzw_dictionary_get_end_of_information_code(self->dictionary));
+    write_code(self, get_end_of_information_code(self));
   }
 
   size_t buffer_length = ut_list_get_length(self->buffer);
@@ -200,7 +223,8 @@ static void ut_lzw_encoder_cleanup(UtObject *object) {
 
   ut_object_unref(self->input_stream);
   ut_object_weak_unref(&self->callback_object);
-  ut_object_unref(self->dictionary);
+  free(self->dictionary_keys);
+  free(self->dictionary_codes);
   ut_object_unref(self->buffer);
 }
 
@@ -215,7 +239,7 @@ static void ut_lzw_encoder_read(UtObject *object, UtObject *callback_object,
   self->callback = callback;
 
   // Always starts with a clear code.
-  write_code(self, ut_lzw_dictionary_get_clear_code(self->dictionary));
+  write_code(self, get_clear_code(self));
 
   ut_input_stream_read(self->input_stream, object, read_cb);
 }
@@ -242,7 +266,20 @@ static UtObject *ut_lzw_encoder_new(size_t n_symbols,
   UtObject *object = ut_object_new(sizeof(UtLzwEncoder), &object_interface);
   UtLzwEncoder *self = (UtLzwEncoder *)object;
   self->n_symbols = n_symbols;
-  self->dictionary = ut_lzw_dictionary_new(n_symbols, max_dictionary_length);
+  self->max_dictionary_length = max_dictionary_length;
+
+  // Keep the hash table at most half full so probe sequences stay short.
+  size_t table_size = 2;
+  self->dictionary_hash_shift = 31;
+  while (table_size < max_dictionary_length * 2) {
+    table_size <<= 1;
+    self->dictionary_hash_shift--;
+  }
+  self->dictionary_keys = malloc(sizeof(uint32_t) * table_size);
+  self->dictionary_codes = malloc(sizeof(uint16_t) * table_size);
+  self->dictionary_mask = table_size - 1;
+  clear_dictionary(self);
+
   self->input_stream = ut_object_ref(input_stream);
   self->lsb_packing = lsb_packing;
   return object;
@@ -1,6 +1,32 @@
 #include "ut-png-decoder-test-data.h"
 #include "ut.h"
 
+static uint32_t n_decoded_rows = 0;
+
+static void row_cb(UtObject *object, uint32_t y, UtObject *row) {
+  ut_assert_int_equal(y, n_decoded_rows);
+  ut_assert_int_equal(ut_png_image_get_height(row), 1);
+  ut_list_append_list(object, ut_png_image_get_data(row));
+  n_decoded_rows++;
+}
+
+// Check the PNG image in [hex_data] can be decoded one row at a time and the
+// rows match [hex_image_data].
+static void check_png_rows(const char *hex_data, uint32_t height,
+                           const char *hex_image_data) {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(hex_data);
+  UtObjectRef data_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_png_decoder_new(data_stream);
+  UtObjectRef rows = ut_uint8_array_new();
+  n_decoded_rows = 0;
+  ut_png_decoder_set_row_callback(decoder, rows, row_cb);
+  UtObjectRef image = ut_png_decoder_decode_sync(decoder);
+  ut_assert_is_not_error(image);
+  ut_assert_int_equal(ut_png_image_get_height(image), 1);
+  ut_assert_int_equal(n_decoded_rows, height);
+  ut_assert_uint8_list_equal_hex(rows, hex_image_data);
+}
+
 // Check the PNG image in [hex_data] can be decoded and matches the expected
 // properties.
 static UtObject *check_png_full(const char *hex_data, uint32_t width,
@@ -34,6 +60,8 @@ static UtObject *check_png_full(const char *hex_data, uint32_t width,
   }
   ut_assert_uint8_list_equal_hex(ut_png_image_get_data(image), hex_image_data);
 
+  check_png_rows(hex_data, height, hex_image_data);
+
   return ut_object_ref(image);
 }
 
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <string.h>
 
 #include "ut-png.h"
 #include "ut.h"
@@ -10,14 +11,6 @@ typedef enum {
   DECODER_STATE_END
 } DecoderState;
 
-typedef enum {
-  FILTER_TYPE_NONE,
-  FILTER_TYPE_SUB,
-  FILTER_TYPE_UP,
-  FILTER_TYPE_AVERAGE,
-  FILTER_TYPE_PAETH
-} FilterType;
-
 typedef struct {
   UtObject object;
 
@@ -28,6 +21,10 @@ typedef struct {
   UtObject *callback_object;
   UtPngDecodeCallback callback;
 
+  // Callback to notify when each row is decoded.
+  UtObject *row_callback_object;
+  UtPngDecodeRowCallback row_callback;
+
   // Current state of the decoder.
   DecoderState state;
 
@@ -43,6 +40,20 @@ typedef struct {
   size_t row_count;
   UtObject *previous_row;
 
+  // Buffers rows are decoded into when not written straight into the image.
+  // These are used alternately, so the previous row is kept for unfiltering.
+  UtObject *row_buffers[2];
+
+  // Height of the image, which differs from the height of [image] when
+  // passing rows to the row callback.
+  uint32_t height;
+
+  // Number of rows passed to the row callback.
+  uint32_t n_rows_notified;
+
+  // Buffer for interlaced images when [image] only holds one row.
+  UtObject *interlaced_data;
+
   // Final image object.
   UtObject *image;
 
@@ -212,100 +223,41 @@ static bool decode_interlace_method(uint8_t value,
   }
 }
 
-static bool decode_filter_type(uint8_t value, FilterType *type) {
+static bool decode_filter_type(uint8_t value, UtPngFilterType *type) {
   switch (value) {
   case 0:
-    *type = FILTER_TYPE_NONE;
+    *type = UT_PNG_FILTER_TYPE_NONE;
     return true;
   case 1:
-    *type = FILTER_TYPE_SUB;
+    *type = UT_PNG_FILTER_TYPE_SUB;
     return true;
   case 2:
-    *type = FILTER_TYPE_UP;
+    *type = UT_PNG_FILTER_TYPE_UP;
     return true;
   case 3:
-    *type = FILTER_TYPE_AVERAGE;
+    *type = UT_PNG_FILTER_TYPE_AVERAGE;
     return true;
   case 4:
-    *type = FILTER_TYPE_PAETH;
+    *type = UT_PNG_FILTER_TYPE_PAETH;
     return true;
   default:
     return false;
   }
 }
 
-static uint8_t paeth_filter(uint8_t x, int32_t a, int32_t b, int32_t c) {
-  int32_t p = a + b - c;
-  int32_t pa = p > a ? p - a : a - p;
-  int32_t pb = p > b ? p - b : b - p;
-  int32_t pc = p > c ? p - c : c - p;
-  if (pa <= pb && pa <= pc) {
-    return x + a;
-  } else if (pb <= pc) {
-    return x + b;
-  } else {
-    return x + c;
-  }
-}
-
-static void filter_row(UtPngDecoder *self, FilterType filter,
-                       UtObject *previous_row, UtObject *filtered_row,
+static void filter_row(UtPngDecoder *self, UtPngFilterType filter,
+                       UtObject *previous_row, const uint8_t *filtered_row,
                        UtObject *row) {
-  size_t row_length = ut_list_get_length(filtered_row);
+  size_t row_length = ut_list_get_length(row);
   uint8_t bit_depth = ut_png_image_get_bit_depth(self->image);
   size_t n_channels = ut_png_image_get_n_channels(self->image);
+  size_t bpp = bit_depth < 8 ? 1 : n_channels * (bit_depth / 8);
   const uint8_t *previous_row_data =
       previous_row != NULL ? ut_uint8_list_get_data(previous_row) : NULL;
   uint8_t *row_data = ut_uint8_list_get_writable_data(row);
 
-  for (size_t offset = 0; offset < row_length; offset++) {
-    // Calculate the filter inputs:
-    //
-    // +---+---+
-    // | c | b |
-    // +---+---+
-    // | a | x |
-    // +---+---+
-    uint8_t x = ut_uint8_list_get_element(filtered_row, offset);
-    int32_t a, b, c;
-    size_t left_offset;
-    if (bit_depth < 8) {
-      left_offset = 1;
-    } else {
-      left_offset = n_channels * (bit_depth / 8);
-    }
-    if (offset >= left_offset) {
-      a = row_data[offset - left_offset];
-      c = previous_row_data != NULL ? previous_row_data[offset - left_offset]
-                                    : 0;
-    } else {
-      a = c = 0;
-    }
-    b = previous_row_data != NULL ? previous_row_data[offset] : 0;
-
-    // Reconstruct the pixel value.
-    uint8_t recon_x;
-    switch (filter) {
-    default:
-    case FILTER_TYPE_NONE:
-      recon_x = x;
-      break;
-    case FILTER_TYPE_SUB:
-      recon_x = x + a;
-      break;
-    case FILTER_TYPE_UP:
-      recon_x = x + b;
-      break;
-    case FILTER_TYPE_AVERAGE:
-      recon_x = x + (a + b) / 2;
-      break;
-    case FILTER_TYPE_PAETH:
-      recon_x = paeth_filter(x, a, b, c);
-      break;
-    }
-
-    row_data[offset] = recon_x;
-  }
+  memcpy(row_data, filtered_row, row_length);
+  png_unfilter_row(filter, bpp, previous_row_data, row_data, row_length);
 }
 
 // Gets the dimensions of an Adam7 interlacing [pass] for an image of size
@@ -348,62 +300,57 @@ static void get_adam7_dimensions(size_t width, size_t height, size_t pass,
   }
 }
 
-static uint8_t get_sample1(const uint8_t *row, size_t index) {
-  return (row[index / 8] >> (7 - index % 8)) & 0x1;
-}
-
-static uint8_t get_sample2(const uint8_t *row, size_t index) {
-  return (row[index / 4] >> 2 * (3 - index % 4)) & 0x3;
+// Returns the buffer that the full image is decoded into.
+static UtObject *get_image_data(UtPngDecoder *self) {
+  return self->interlaced_data != NULL ? self->interlaced_data
+                                       : ut_png_image_get_data(self->image);
 }
 
-static uint8_t get_sample4(const uint8_t *row, size_t index) {
-  return (row[index / 2] >> 4 * (1 - index % 2)) & 0xf;
-}
-
-static uint8_t get_sample8(const uint8_t *row, size_t index) {
-  return row[index];
-}
-
-static void write_sample1(uint8_t *image_data, size_t row_stride, size_t index,
-                          size_t y, uint8_t value) {
-  uint8_t *row = image_data + (y * row_stride);
-  uint8_t mask = (0x1 << (7 - index % 8)) ^ 0xff;
-  row[index / 8] &= mask;
-  row[index / 8] |= value << (7 - index % 8);
-}
-
-static void write_sample2(uint8_t *image_data, size_t row_stride, size_t index,
-                          size_t y, uint8_t value) {
-  uint8_t *row = image_data + (y * row_stride);
-  uint8_t mask = (0x3 << 2 * (3 - index % 4)) ^ 0xff;
-  row[index / 4] &= mask;
-  row[index / 4] |= value << 2 * (3 - index % 4);
+// Returns a buffer of [length] bytes to decode the current row into.
+static UtObject *get_row_buffer(UtPngDecoder *self, size_t length) {
+  UtObject **buffer = &self->row_buffers[self->row_count % 2];
+  if (*buffer == NULL) {
+    *buffer = ut_uint8_array_new_sized(length);
+  } else if (ut_list_get_length(*buffer) != length) {
+    ut_list_resize(*buffer, length);
+  }
+  return ut_object_ref(*buffer);
 }
 
-static void write_sample4(uint8_t *image_data, size_t row_stride, size_t index,
-                          size_t y, uint8_t value) {
-  uint8_t *row = image_data + (y * row_stride);
-  uint8_t mask = (0xf << 4 * (1 - index % 2)) ^ 0xff;
-  row[index / 2] &= mask;
-  row[index / 2] |= value << 4 * (1 - index % 2);
+// Pass [row] of [row_stride] bytes at [y] to the row callback.
+static void notify_row(UtPngDecoder *self, uint32_t y, const uint8_t *row,
+                       size_t row_stride) {
+  uint8_t *row_data =
+      ut_uint8_list_get_writable_data(ut_png_image_get_data(self->image));
+  memcpy(row_data, row, row_stride);
+  if (self->row_callback_object != NULL) {
+    self->row_callback(self->row_callback_object, y, self->image);
+  }
+  self->n_rows_notified = y + 1;
 }
 
-static void write_sample8(uint8_t *image_data, size_t row_stride, size_t index,
-                          size_t y, uint8_t value) {
-  uint8_t *row = image_data + (y * row_stride);
-  row[index] = value;
+// Pass the deinterlaced rows before [y] that have not yet been passed to the
+// row callback.
+static void notify_interlaced_rows(UtPngDecoder *self, uint32_t y) {
+  size_t row_stride = ut_png_image_get_row_stride(self->image);
+  const uint8_t *image_data = ut_uint8_list_get_data(self->interlaced_data);
+  if (y > self->height) {
+    y = self->height;
+  }
+  while (self->n_rows_notified < y) {
+    notify_row(self, self->n_rows_notified,
+               image_data + self->n_rows_notified * row_stride, row_stride);
+  }
 }
 
 // Take interlace [row] of [row_width] pixels and write it into the final image.
 static void apply_adam7_row(UtPngDecoder *self, UtObject *row,
                             size_t row_width) {
-  uint32_t image_height = ut_png_image_get_height(self->image);
+  uint32_t image_height = self->height;
   uint32_t image_width = ut_png_image_get_width(self->image);
-  uint8_t bit_depth = ut_png_image_get_bit_depth(self->image);
-  size_t n_channels = ut_png_image_get_n_channels(self->image);
+  UtPixelFormat format = ut_png_image_get_pixel_format(self->image);
   size_t row_stride = ut_png_image_get_row_stride(self->image);
-  uint8_t *image_data =
-      ut_uint8_list_get_writable_data(ut_png_image_get_data(self->image));
+  uint8_t *image_data = ut_uint8_list_get_writable_data(get_image_data(self));
 
   // Get the transform for the interlaced row and the size to fill.
   size_t x0, y0, dx, dy, fill_width, fill_height;
@@ -474,40 +421,6 @@ static void apply_adam7_row(UtPngDecoder *self, UtObject *row,
     break;
   }
 
-  // Get functions to read/write samples in the required bit depth.
-  size_t n_samples;
-  uint8_t (*get_sample)(const uint8_t *, size_t) = NULL;
-  void (*write_sample)(uint8_t *, size_t, size_t, size_t, uint8_t) = NULL;
-  switch (bit_depth) {
-  case 1:
-    n_samples = 1;
-    get_sample = get_sample1;
-    write_sample = write_sample1;
-    break;
-  case 2:
-    n_samples = 1;
-    get_sample = get_sample2;
-    write_sample = write_sample2;
-    break;
-  case 4:
-    n_samples = 1;
-    get_sample = get_sample4;
-    write_sample = write_sample4;
-    break;
-  case 8:
-    n_samples = n_channels;
-    get_sample = get_sample8;
-    write_sample = write_sample8;
-    break;
-  case 16:
-    n_samples = n_channels * 2;
-    get_sample = get_sample8;
-    write_sample = write_sample8;
-    break;
-  default:
-    return;
-  }
-
   // Write pixels in final image.
   const uint8_t *row_data = ut_uint8_list_get_data(row);
   for (size_t i = 0; i < row_width; i++) {
@@ -523,12 +436,10 @@ static void apply_adam7_row(UtPngDecoder *self, UtObject *row,
       py1 = image_height;
     }
 
-    for (size_t s = 0; s < n_samples; s++) {
-      uint8_t sample = get_sample(row_data, i * n_samples + s);
+    for (size_t py = py0; py < py1; py++) {
+      uint8_t *image_row = image_data + py * row_stride;
       for (size_t px = px0; px < px1; px++) {
-        for (size_t py = py0; py < py1; py++) {
-          write_sample(image_data, row_stride, n_samples * px + s, py, sample);
-        }
+        ut_pixel_format_copy_pixel(format, row_data, i, image_row, px);
       }
     }
   }
@@ -538,7 +449,7 @@ static bool is_complete(UtPngDecoder *self) {
   if (self->interlace_method == UT_PNG_INTERLACE_METHOD_ADAM7) {
     return self->interlace_pass >= 7;
   } else {
-    return self->row_count >= ut_png_image_get_height(self->image);
+    return self->row_count >= self->height;
   }
 }
 
@@ -555,8 +466,14 @@ static size_t data_decoder_read_cb(UtObject *object, UtObject *data,
   }
 
   size_t data_length = ut_list_get_length(data);
+  const uint8_t *data_buffer = ut_uint8_list_get_data(data);
+  UtObjectRef data_array = NULL;
+  if (data_buffer == NULL) {
+    data_array = ut_uint8_list_get_array(data);
+    data_buffer = ut_uint8_list_get_data(data_array);
+  }
 
-  uint32_t image_height = ut_png_image_get_height(self->image);
+  uint32_t image_height = self->height;
   uint32_t image_width = ut_png_image_get_width(self->image);
   uint8_t bit_depth = ut_png_image_get_bit_depth(self->image);
   size_t n_channels = ut_png_image_get_n_channels(self->image);
@@ -585,7 +502,7 @@ static size_t data_decoder_read_cb(UtObject *object, UtObject *data,
     }
 
     // Row starts with a filter.
-    FilterType filter;
+    UtPngFilterType filter;
     if (!decode_filter_type(ut_uint8_list_get_element(data, offset), &filter)) {
       set_error(self, "Invalid PNG filter type");
       return offset;
@@ -593,25 +510,27 @@ static size_t data_decoder_read_cb(UtObject *object, UtObject *data,
     offset++;
 
     // Apply filter to row.
-    UtObjectRef filtered_row = ut_list_get_sublist(data, offset, row_stride);
     UtObjectRef row = NULL;
     if (self->interlace_method == UT_PNG_INTERLACE_METHOD_ADAM7) {
       // Pass 7 is just every second row, which can be directly written to the
       // final image.
       if (self->interlace_pass == 6) {
-        row = ut_list_get_sublist(ut_png_image_get_data(self->image),
+        row = ut_list_get_sublist(get_image_data(self),
                                   (self->row_count * 2 + 1) * row_stride,
                                   row_stride);
       } else {
         // Write to a buffer that will be spread through image.
-        row = ut_uint8_array_new_sized(row_stride);
+        row = get_row_buffer(self, row_stride);
       }
+    } else if (self->row_callback != NULL) {
+      // Write to a buffer that is passed to the row callback.
+      row = get_row_buffer(self, row_stride);
     } else {
       // Write directly to final image.
       row = ut_list_get_sublist(ut_png_image_get_data(self->image),
                                 self->row_count * row_stride, row_stride);
     }
-    filter_row(self, filter, self->previous_row, filtered_row, row);
+    filter_row(self, filter, self->previous_row, data_buffer + offset, row);
     offset += row_stride;
 
     // Fill pixels from interlaced row.
@@ -625,6 +544,19 @@ static size_t data_decoder_read_cb(UtObject *object, UtObject *data,
     self->previous_row = ut_object_ref(row);
     self->row_count++;
 
+    // Pass completed rows to the callback. Interlaced rows are complete once
+    // the last pass fills in the odd rows.
+    if (self->row_callback != NULL) {
+      if (self->interlace_method == UT_PNG_INTERLACE_METHOD_ADAM7) {
+        if (self->interlace_pass == 6) {
+          notify_interlaced_rows(self, self->row_count * 2);
+        }
+      } else {
+        notify_row(self, self->row_count - 1, ut_uint8_list_get_data(row),
+                   row_stride);
+      }
+    }
+
     // Move to next interlace pass, skipping any passes that have no pixels.
     if (self->interlace_method == UT_PNG_INTERLACE_METHOD_ADAM7 &&
         self->row_count >= height) {
@@ -636,6 +568,9 @@ static size_t data_decoder_read_cb(UtObject *object, UtObject *data,
         get_adam7_dimensions(image_width, image_height, self->interlace_pass,
                              &width, &height);
       } while (self->interlace_pass < 7 && (width == 0 || height == 0));
+      if (self->row_callback != NULL && self->interlace_pass >= 7) {
+        notify_interlaced_rows(self, image_height);
+      }
     }
   }
 
@@ -709,10 +644,20 @@ static void decode_image_header(UtPngDecoder *self, UtObject *data) {
     break;
   }
   size_t row_stride = (((size_t)width * bit_depth * n_channels) + 7) / 8;
-  UtObjectRef image_data = ut_uint8_array_new_sized(height * row_stride);
+  self->height = height;
+
+  // When passing rows to a callback the image only holds the current row.
+  uint32_t image_height = height;
+  if (self->row_callback != NULL) {
+    image_height = 1;
+    if (self->interlace_method == UT_PNG_INTERLACE_METHOD_ADAM7) {
+      self->interlaced_data = ut_uint8_array_new_sized(height * row_stride);
+    }
+  }
+  UtObjectRef image_data = ut_uint8_array_new_sized(image_height * row_stride);
   UtObjectRef palette = NULL;
   self->image =
-      ut_png_image_new(width, height, bit_depth, color_type, image_data);
+      ut_png_image_new(width, image_height, bit_depth, color_type, image_data);
 }
 
 static void decode_palette(UtPngDecoder *self, UtObject *data) {
@@ -1215,9 +1160,13 @@ static void ut_png_decoder_cleanup(UtObject *object) {
 
   ut_object_unref(self->input_stream);
   ut_object_weak_unref(&self->callback_object);
+  ut_object_weak_unref(&self->row_callback_object);
   ut_object_unref(self->image_data_decoder_input_stream);
   ut_object_unref(self->image_data_decoder);
   ut_object_unref(self->previous_row);
+  ut_object_unref(self->row_buffers[0]);
+  ut_object_unref(self->row_buffers[1]);
+  ut_object_unref(self->interlaced_data);
   ut_object_unref(self->image);
   ut_object_unref(self->error);
 }
@@ -1233,6 +1182,16 @@ UtObject *ut_png_decoder_new(UtObject *input_stream) {
   return object;
 }
 
+void ut_png_decoder_set_row_callback(UtObject *object,
+                                     UtObject *callback_object,
+                                     UtPngDecodeRowCallback callback) {
+  assert(ut_object_is_png_decoder(object));
+  UtPngDecoder *self = (UtPngDecoder *)object;
+  assert(self->callback == NULL);
+  ut_object_weak_ref(callback_object, &self->row_callback_object);
+  self->row_callback = callback;
+}
+
 void ut_png_decoder_decode(UtObject *object, UtObject *callback_object,
                            UtPngDecodeCallback callback) {
   assert(ut_object_is_png_decoder(object));
@@ -1,10 +1,13 @@
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "ut-object.h"
 
 #pragma once
 
 typedef void (*UtPngDecodeCallback)(UtObject *object);
+typedef void (*UtPngDecodeRowCallback)(UtObject *object, uint32_t y,
+                                       UtObject *row);
 
 /// Creates a new PNG decoder to read an image from [input_stream].
 ///
@@ -13,6 +16,20 @@ typedef void (*UtPngDecodeCallback)(UtObject *object);
 /// !return-type UtPngDecoder
 UtObject *ut_png_decoder_new(UtObject *input_stream);
 
+/// Sets [callback] to be called with each row of the image as soon as it is
+/// decoded, in order from the top. [row] is a [UtPngImage] one pixel high
+/// containing row [y] and the image palette. The same image is reused for
+/// every row, so its data is only valid until the callback returns; copy any
+/// data needed after that.
+///
+/// When a row callback is set the full image is not kept, and the image
+/// returned by [ut_png_decoder_get_image] only contains the last row.
+/// Non-interlaced images are decoded holding only two rows in memory;
+/// interlaced images still require a buffer for the whole image.
+void ut_png_decoder_set_row_callback(UtObject *object,
+                                     UtObject *callback_object,
+                                     UtPngDecodeRowCallback callback);
+
 /// Start decoding.
 /// When complete [callback] is called.
 void ut_png_decoder_decode(UtObject *object, UtObject *callback_object,
@@ -16,6 +16,35 @@ static void check_png(uint32_t width, uint32_t height, uint8_t bit_depth,
   ut_assert_uint8_list_equal_hex(data, hex_data);
 }
 
+// Check an image encoded using [n_threads] decodes to the same image.
+static void check_threaded_png(uint32_t width, uint32_t height,
+                               uint8_t bit_depth, UtPngColorType color_type,
+                               size_t n_channels, size_t n_threads) {
+  size_t image_data_length =
+      height * ((width * bit_depth * n_channels + 7) / 8);
+  UtObjectRef image_data = ut_uint8_array_new_sized(image_data_length);
+  uint8_t *d = ut_uint8_list_get_writable_data(image_data);
+  for (size_t i = 0; i < image_data_length; i++) {
+    d[i] = i * 7 + i / 13;
+  }
+  UtObjectRef image =
+      ut_png_image_new(width, height, bit_depth, color_type, image_data);
+
+  UtObjectRef data = ut_uint8_array_new();
+  UtObjectRef encoder = ut_png_encoder_new(image, data);
+  ut_png_encoder_set_n_threads(encoder, n_threads);
+  ut_png_encoder_encode(encoder);
+
+  UtObjectRef input_stream = ut_list_input_stream_new(data);
+  UtObjectRef decoder = ut_png_decoder_new(input_stream);
+  UtObjectRef decoded_image = ut_png_decoder_decode_sync(decoder);
+  ut_assert_is_not_error(decoded_image);
+  ut_assert_int_equal(ut_png_image_get_width(decoded_image), width);
+  ut_assert_int_equal(ut_png_image_get_height(decoded_image), height);
+  ut_assert_uint8_list_equal(ut_png_image_get_data(decoded_image),
+                             d, image_data_length);
+}
+
 int main(int argc, char **argv) {
   check_png(
       1, 1, 8, UT_PNG_COLOR_TYPE_GREYSCALE, NULL, NULL, "00",
@@ -30,8 +59,13 @@ int main(int argc, char **argv) {
   check_png(2, 2, 8, UT_PNG_COLOR_TYPE_TRUECOLOR, NULL, NULL,
             "ff000000ff000000ffffffff",
             "89504e470d0a1a0a0000000d4948445200000002000000020802000000"
-            "fdd49a730000001149444154089963f8cfc000c60cff8100001fee05fb"
-            "f491978b0000000049454e44ae426082");
+            "fdd49a730000001349444154089963f8cfc000c48c40e2ff7f06001ef6"
+            "04fdd1fae37d0000000049454e44ae426082");
+
+  check_threaded_png(16, 16, 8, UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA, 4, 1);
+  check_threaded_png(16, 16, 8, UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA, 4, 2);
+  check_threaded_png(16, 15, 16, UT_PNG_COLOR_TYPE_TRUECOLOR, 3, 4);
+  check_threaded_png(17, 3, 1, UT_PNG_COLOR_TYPE_GREYSCALE, 1, 4);
 
   return 0;
 }
@@ -1,14 +1,27 @@
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "ut-parallel-private.h"
 #include "ut-png.h"
 #include "ut.h"
 
 #define COMPRESS_DEFLATE 0
 
+// Zlib compression method and level used for image data.
+#define ZLIB_METHOD_DEFLATE 8
+#define ZLIB_COMPRESSION_DEFAULT 2
+
+// Largest prime less than 2^16, used in Adler-32 checksums.
+#define ADLER32_BASE 65521
+
 typedef struct {
   UtObject object;
   UtObject *image;
 
+  // Number of threads to compress image data with.
+  size_t n_threads;
+
   UtObject *output_stream;
 } UtPngEncoder;
 
@@ -166,6 +179,163 @@ static size_t zlib_data_cb(UtObject *object, UtObject *data, bool complete) {
   return ut_list_get_length(data);
 }
 
+static size_t get_bytes_per_pixel(UtPngEncoder *self) {
+  uint8_t bit_depth = ut_png_image_get_bit_depth(self->image);
+  size_t n_channels = ut_png_image_get_n_channels(self->image);
+  return bit_depth < 8 ? 1 : n_channels * (bit_depth / 8);
+}
+
+// Filters don't generally improve compression of indexed images or images
+// with less than a byte per pixel, so these are always unfiltered.
+static bool use_adaptive_filter(UtPngEncoder *self) {
+  return ut_png_image_get_color_type(self->image) !=
+             UT_PNG_COLOR_TYPE_INDEXED_COLOR &&
+         ut_png_image_get_bit_depth(self->image) >= 8;
+}
+
+// Write [row] of [image_data] to [buffer], starting with the filter type.
+static void filter_row(UtPngEncoder *self, const uint8_t *image_data,
+                       size_t row, uint8_t *buffer) {
+  size_t row_stride = ut_png_image_get_row_stride(self->image);
+  const uint8_t *row_data = image_data + row * row_stride;
+  const uint8_t *previous_row_data =
+      row > 0 ? image_data + (row - 1) * row_stride : NULL;
+  UtPngFilterType filter_type = UT_PNG_FILTER_TYPE_NONE;
+  if (use_adaptive_filter(self)) {
+    filter_type =
+        png_filter_row_adaptive(get_bytes_per_pixel(self), previous_row_data,
+                                row_data, buffer + 1, row_stride);
+  } else {
+    memcpy(buffer + 1, row_data, row_stride);
+  }
+  buffer[0] = filter_type;
+}
+
+// Work done on a thread when compressing a band of rows.
+typedef struct {
+  UtPngEncoder *encoder;
+  const uint8_t *image_data;
+
+  // Rows to compress.
+  size_t row_start;
+  size_t row_end;
+
+  size_t window_size;
+  bool is_final;
+
+  // Adler-32 checksum of the uncompressed data.
+  uint32_t checksum;
+
+  // Compressed deflate data.
+  UtObject *data;
+} EncodeWorker;
+
+static uint32_t adler32(uint32_t checksum, const uint8_t *data, size_t length) {
+  uint32_t s1 = checksum & 0xffff;
+  uint32_t s2 = checksum >> 16;
+  while (length > 0) {
+    // Largest number of bytes that can be summed before s2 overflows.
+    size_t n = length < 5552 ? length : 5552;
+    for (size_t i = 0; i < n; i++) {
+      s1 += data[i];
+      s2 += s1;
+    }
+    s1 %= ADLER32_BASE;
+    s2 %= ADLER32_BASE;
+    data += n;
+    length -= n;
+  }
+  return s2 << 16 | s1;
+}
+
+// Returns the checksum of two blocks of data given their checksums
+// [checksum1] and [checksum2] and the [length2] of the second block.
+static uint32_t adler32_combine(uint32_t checksum1, uint32_t checksum2,
+                                size_t length2) {
+  uint32_t remainder = length2 % ADLER32_BASE;
+  uint32_t s1 = checksum1 & 0xffff;
+  uint32_t s2 = (uint64_t)remainder * s1 % ADLER32_BASE;
+  s1 += (checksum2 & 0xffff) + ADLER32_BASE - 1;
+  s2 += (checksum1 >> 16) + (checksum2 >> 16) + ADLER32_BASE - remainder;
+  s1 %= ADLER32_BASE;
+  s2 %= ADLER32_BASE;
+  return s2 << 16 | s1;
+}
+
+static void encode_rows_cb(void *data) {
+  EncodeWorker *worker = data;
+  UtPngEncoder *self = worker->encoder;
+
+  size_t row_stride = ut_png_image_get_row_stride(self->image);
+  size_t length = (worker->row_end - worker->row_start) * (1 + row_stride);
+  UtObjectRef filtered_data = ut_uint8_array_new_sized(length);
+  uint8_t *d = ut_uint8_list_get_writable_data(filtered_data);
+  for (size_t row = worker->row_start; row < worker->row_end; row++) {
+    filter_row(self, worker->image_data, row,
+               d + (row - worker->row_start) * (1 + row_stride));
+  }
+  worker->checksum = adler32(1, d, length);
+
+  UtObjectRef deflate_input_stream = ut_list_input_stream_new(filtered_data);
+  UtObjectRef deflate_encoder = ut_deflate_encoder_new_with_window_size(
+      worker->window_size, deflate_input_stream);
+  ut_deflate_encoder_set_is_final(deflate_encoder, worker->is_final);
+  worker->data = ut_input_stream_read_sync(deflate_encoder);
+}
+
+// Write the zlib header to [chunk].
+static void write_zlib_header(UtObject *chunk, size_t window_size) {
+  uint8_t window_size_value = 0;
+  while ((size_t)256 << window_size_value < window_size) {
+    window_size_value++;
+  }
+  uint8_t cmf = window_size_value << 4 | ZLIB_METHOD_DEFLATE;
+  uint8_t flags = ZLIB_COMPRESSION_DEFAULT << 6;
+  uint16_t header_check = (cmf << 8 | flags) % 31;
+  if (header_check != 0) {
+    flags |= 31 - header_check;
+  }
+  ut_uint8_list_append(chunk, cmf);
+  ut_uint8_list_append(chunk, flags);
+}
+
+// Compress bands of rows on separate threads and join them into one zlib
+// stream. Each band is compressed independently, so the data is slightly
+// larger than when compressed as a single stream.
+static void write_parallel_image_data(UtPngEncoder *self, UtObject *chunk,
+                                      const uint8_t *image_data,
+                                      size_t window_size) {
+  size_t image_height = ut_png_image_get_height(self->image);
+  size_t row_stride = ut_png_image_get_row_stride(self->image);
+
+  size_t n_workers = _ut_parallel_get_n_workers(self->n_threads, image_height);
+  EncodeWorker *workers = calloc(n_workers, sizeof(EncodeWorker));
+  for (size_t i = 0; i < n_workers; i++) {
+    EncodeWorker *worker = &workers[i];
+    worker->encoder = self;
+    worker->image_data = image_data;
+    worker->row_start = image_height * i / n_workers;
+    worker->row_end = image_height * (i + 1) / n_workers;
+    worker->window_size = window_size;
+    worker->is_final = i == n_workers - 1;
+    worker->data = NULL;
+  }
+  _ut_parallel_run(workers, sizeof(EncodeWorker), n_workers, encode_rows_cb);
+
+  write_zlib_header(chunk, window_size);
+  uint32_t checksum = 1;
+  for (size_t i = 0; i < n_workers; i++) {
+    EncodeWorker *worker = &workers[i];
+    ut_list_append_list(chunk, worker->data);
+    ut_object_unref(worker->data);
+    checksum = adler32_combine(
+        checksum, worker->checksum,
+        (worker->row_end - worker->row_start) * (1 + row_stride));
+  }
+  free(workers);
+  ut_uint8_list_append_uint32_be(chunk, checksum);
+}
+
 static void write_image_data(UtPngEncoder *self) {
   UtObjectRef chunk = start_chunk(UT_PNG_CHUNK_TYPE_IMAGE_DATA);
 
@@ -182,19 +352,29 @@ static void write_image_data(UtPngEncoder *self) {
     window_size /= 2;
   }
 
+  const uint8_t *image_buffer = ut_uint8_list_get_data(image_data);
+  UtObjectRef image_array = NULL;
+  if (image_buffer == NULL) {
+    image_array = ut_uint8_list_get_array(image_data);
+    image_buffer = ut_uint8_list_get_data(image_array);
+  }
+
+  if (self->n_threads > 1 && image_height > 1) {
+    write_parallel_image_data(self, chunk, image_buffer, window_size);
+    write_chunk(self, chunk);
+    return;
+  }
+
   UtObjectRef zlib_input_stream = ut_buffered_input_stream_new();
   UtObjectRef zlib_encoder = ut_zlib_encoder_new_full(
       UT_ZLIB_COMPRESSION_LEVEL_DEFAULT, window_size, zlib_input_stream);
   ut_input_stream_read(zlib_encoder, chunk, zlib_data_cb);
 
-  uint8_t filter_type = 0;
-  UtObjectRef filter_data = ut_uint8_array_new_from_data(&filter_type, 1);
+  UtObjectRef row_data = ut_uint8_array_new_sized(1 + row_stride);
+  uint8_t *row_buffer = ut_uint8_list_get_writable_data(row_data);
   for (size_t row = 0; row < image_height; row++) {
-    UtObjectRef row_data =
-        ut_list_get_sublist(image_data, row * row_stride, row_stride);
+    filter_row(self, image_buffer, row, row_buffer);
     bool is_last_row = row == image_height - 1;
-
-    ut_buffered_input_stream_write(zlib_input_stream, filter_data, false);
     ut_buffered_input_stream_write(zlib_input_stream, row_data, is_last_row);
   }
 
@@ -219,10 +399,18 @@ UtObject *ut_png_encoder_new(UtObject *image, UtObject *output_stream) {
   UtObject *object = ut_object_new(sizeof(UtPngEncoder), &object_interface);
   UtPngEncoder *self = (UtPngEncoder *)object;
   self->image = ut_object_ref(image);
+  self->n_threads = 1;
   self->output_stream = ut_object_ref(output_stream);
   return object;
 }
 
+void ut_png_encoder_set_n_threads(UtObject *object, size_t n_threads) {
+  assert(ut_object_is_png_encoder(object));
+  UtPngEncoder *self = (UtPngEncoder *)object;
+  assert(n_threads > 0);
+  self->n_threads = n_threads;
+}
+
 void ut_png_encoder_encode(UtObject *object) {
   assert(ut_object_is_png_encoder(object));
   UtPngEncoder *self = (UtPngEncoder *)object;
@@ -12,6 +12,12 @@
 /// !return-type UtPngEncoder
 UtObject *ut_png_encoder_new(UtObject *image, UtObject *output_stream);
 
+/// Sets the number of threads used to compress the image data.
+/// When [n_threads] is greater than one, the rows are split into bands that
+/// are filtered and compressed in parallel and joined into a single stream.
+/// This is faster but gives slightly larger files. Defaults to 1.
+void ut_png_encoder_set_n_threads(UtObject *object, size_t n_threads);
+
 /// Start encoding.
 void ut_png_encoder_encode(UtObject *object);
 
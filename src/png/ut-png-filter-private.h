@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ut-png.h"
+
+typedef void (*PngUnfilterSubFunction)(uint8_t *row, size_t length,
+                                       size_t bpp);
+typedef void (*PngUnfilterUpFunction)(uint8_t *row,
+                                      const uint8_t *previous_row,
+                                      size_t length);
+typedef void (*PngUnfilterFunction)(uint8_t *row, const uint8_t *previous_row,
+                                    size_t length, size_t bpp);
+
+typedef void (*PngFilterFunction)(UtPngFilterType filter_type, size_t bpp,
+                                  const uint8_t *previous_row,
+                                  const uint8_t *row, uint8_t *filtered_row,
+                                  size_t length);
+typedef uint64_t (*PngCostFunction)(const uint8_t *data, size_t length);
+
+// One implementation of the filters. The unfilter functions require a
+// [previous_row], the first row is handled by png_unfilter_row.
+typedef struct {
+  const char *name;
+  PngUnfilterSubFunction unfilter_sub;
+  PngUnfilterUpFunction unfilter_up;
+  PngUnfilterFunction unfilter_average;
+  PngUnfilterFunction unfilter_paeth;
+  PngFilterFunction filter;
+  PngCostFunction cost;
+} PngFilterFunctions;
+
+// Get the implementations of the filters this CPU supports, so they can be
+// tested against each other. The first is the scalar implementation and the
+// last the one used by png_unfilter_row and png_filter_row.
+// Returns the number of implementations.
+size_t png_get_filter_functions(const PngFilterFunctions **functions);
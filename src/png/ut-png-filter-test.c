@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ut-png-filter-private.h"
+#include "ut.h"
+
+#define MAX_ROW_LENGTH 4096
+
+static uint32_t random_state = 1;
+
+static uint8_t random_byte() {
+  random_state = random_state * 1103515245 + 12345;
+  return random_state >> 16;
+}
+
+// Reconstruct [row] in the way described in the PNG specification.
+static void reference_unfilter_row(UtPngFilterType filter_type, size_t bpp,
+                                   const uint8_t *previous_row, uint8_t *row,
+                                   size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    int32_t a = i >= bpp ? row[i - bpp] : 0;
+    int32_t b = previous_row != NULL ? previous_row[i] : 0;
+    int32_t c = i >= bpp && previous_row != NULL ? previous_row[i - bpp] : 0;
+    int32_t p = a + b - c;
+    int32_t pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    switch (filter_type) {
+    case UT_PNG_FILTER_TYPE_NONE:
+      break;
+    case UT_PNG_FILTER_TYPE_SUB:
+      row[i] += a;
+      break;
+    case UT_PNG_FILTER_TYPE_UP:
+      row[i] += b;
+      break;
+    case UT_PNG_FILTER_TYPE_AVERAGE:
+      row[i] += (a + b) / 2;
+      break;
+    case UT_PNG_FILTER_TYPE_PAETH:
+      if (pa <= pb && pa <= pc) {
+        row[i] += a;
+      } else if (pb <= pc) {
+        row[i] += b;
+      } else {
+        row[i] += c;
+      }
+      break;
+    }
+  }
+}
+
+static void check_unfilter_row(UtPngFilterType filter_type, size_t bpp,
+                               size_t length, bool has_previous_row) {
+  uint8_t previous_row[MAX_ROW_LENGTH], row[MAX_ROW_LENGTH];
+  uint8_t expected_row[MAX_ROW_LENGTH];
+  for (size_t i = 0; i < length; i++) {
+    previous_row[i] = random_byte();
+    row[i] = expected_row[i] = random_byte();
+  }
+
+  const uint8_t *p = has_previous_row ? previous_row : NULL;
+  reference_unfilter_row(filter_type, bpp, p, expected_row, length);
+  png_unfilter_row(filter_type, bpp, p, row, length);
+  ut_assert_uint8_array_equal(row, length, expected_row, length);
+}
+
+// Check filtering matches the reference and can be reversed.
+static void check_filter_row(UtPngFilterType filter_type, size_t bpp,
+                             size_t length, bool has_previous_row) {
+  uint8_t previous_row[MAX_ROW_LENGTH], row[MAX_ROW_LENGTH];
+  uint8_t filtered_row[MAX_ROW_LENGTH], unfiltered_row[MAX_ROW_LENGTH];
+  for (size_t i = 0; i < length; i++) {
+    previous_row[i] = random_byte();
+    // Use values that are correlated with the row above and to the left, as
+    // in real images.
+    row[i] = (i >= bpp ? row[i - bpp] : 0) + previous_row[i] / 2 +
+             random_byte() % 8;
+  }
+
+  const uint8_t *p = has_previous_row ? previous_row : NULL;
+  png_filter_row(filter_type, bpp, p, row, filtered_row, length);
+  memcpy(unfiltered_row, filtered_row, length);
+  reference_unfilter_row(filter_type, bpp, p, unfiltered_row, length);
+  ut_assert_uint8_array_equal(unfiltered_row, length, row, length);
+}
+
+// Returns the cost of a filtered row used to choose the filter type.
+static uint64_t get_cost(const uint8_t *data, size_t length) {
+  uint64_t cost = 0;
+  for (size_t i = 0; i < length; i++) {
+    cost += abs((int8_t)data[i]);
+  }
+  return cost;
+}
+
+// Check adaptive filtering picks the filter type with the lowest cost.
+static void check_filter_row_adaptive(size_t bpp, size_t length,
+                                      bool has_previous_row) {
+  uint8_t previous_row[MAX_ROW_LENGTH] = {0}, row[MAX_ROW_LENGTH] = {0};
+  uint8_t filtered_row[MAX_ROW_LENGTH], expected_row[MAX_ROW_LENGTH];
+  for (size_t i = 0; i < length; i++) {
+    previous_row[i] = random_byte();
+    row[i] = previous_row[i] + random_byte() % 4;
+  }
+
+  const uint8_t *p = has_previous_row ? previous_row : NULL;
+  UtPngFilterType filter_type =
+      png_filter_row_adaptive(bpp, p, row, filtered_row, length);
+  png_filter_row(filter_type, bpp, p, row, expected_row, length);
+  ut_assert_uint8_array_equal(filtered_row, length, expected_row, length);
+
+  uint64_t cost = get_cost(filtered_row, length);
+  for (UtPngFilterType f = UT_PNG_FILTER_TYPE_NONE;
+       f <= UT_PNG_FILTER_TYPE_PAETH; f++) {
+    png_filter_row(f, bpp, p, row, expected_row, length);
+    ut_assert_true(cost <= get_cost(expected_row, length));
+  }
+}
+
+// Check each optimized implementation gives the same results as the scalar
+// one on a random row of [length] bytes.
+static void check_implementations(size_t bpp, size_t length) {
+  uint8_t previous_row[MAX_ROW_LENGTH], row[MAX_ROW_LENGTH];
+  for (size_t i = 0; i < length; i++) {
+    previous_row[i] = random_byte();
+    row[i] = random_byte();
+  }
+
+  const PngFilterFunctions *implementations;
+  size_t n_implementations = png_get_filter_functions(&implementations);
+  const PngFilterFunctions *scalar = &implementations[0];
+  for (size_t i = 1; i < n_implementations; i++) {
+    const PngFilterFunctions *f = &implementations[i];
+    uint8_t expected_row[MAX_ROW_LENGTH], result_row[MAX_ROW_LENGTH];
+
+    memcpy(expected_row, row, length);
+    scalar->unfilter_sub(expected_row, length, bpp);
+    memcpy(result_row, row, length);
+    f->unfilter_sub(result_row, length, bpp);
+    ut_assert_uint8_array_equal(result_row, length, expected_row, length);
+
+    memcpy(expected_row, row, length);
+    scalar->unfilter_up(expected_row, previous_row, length);
+    memcpy(result_row, row, length);
+    f->unfilter_up(result_row, previous_row, length);
+    ut_assert_uint8_array_equal(result_row, length, expected_row, length);
+
+    memcpy(expected_row, row, length);
+    scalar->unfilter_average(expected_row, previous_row, length, bpp);
+    memcpy(result_row, row, length);
+    f->unfilter_average(result_row, previous_row, length, bpp);
+    ut_assert_uint8_array_equal(result_row, length, expected_row, length);
+
+    memcpy(expected_row, row, length);
+    scalar->unfilter_paeth(expected_row, previous_row, length, bpp);
+    memcpy(result_row, row, length);
+    f->unfilter_paeth(result_row, previous_row, length, bpp);
+    ut_assert_uint8_array_equal(result_row, length, expected_row, length);
+
+    for (UtPngFilterType filter_type = UT_PNG_FILTER_TYPE_NONE;
+         filter_type <= UT_PNG_FILTER_TYPE_PAETH; filter_type++) {
+      scalar->filter(filter_type, bpp, previous_row, row, expected_row,
+                     length);
+      f->filter(filter_type, bpp, previous_row, row, result_row, length);
+      ut_assert_uint8_array_equal(result_row, length, expected_row, length);
+    }
+
+    ut_assert_int_equal(f->cost(row, length), scalar->cost(row, length));
+  }
+}
+
+int main(int argc, char **argv) {
+  UtPngFilterType filter_types[] = {
+      UT_PNG_FILTER_TYPE_NONE, UT_PNG_FILTER_TYPE_SUB, UT_PNG_FILTER_TYPE_UP,
+      UT_PNG_FILTER_TYPE_AVERAGE, UT_PNG_FILTER_TYPE_PAETH};
+  size_t bpps[] = {1, 2, 3, 4, 6, 8};
+  size_t lengths[] = {1, 8, 15, 16, 17, 31, 32, 33, 100, 1021, 4096};
+
+  for (size_t f = 0; f < 5; f++) {
+    for (size_t b = 0; b < 6; b++) {
+      for (size_t l = 0; l < 11; l++) {
+        // Rows are always a whole number of pixels.
+        size_t length = lengths[l] - lengths[l] % bpps[b];
+        if (length == 0) {
+          continue;
+        }
+        check_unfilter_row(filter_types[f], bpps[b], length, true);
+        check_unfilter_row(filter_types[f], bpps[b], length, false);
+        check_filter_row(filter_types[f], bpps[b], length, true);
+        check_filter_row(filter_types[f], bpps[b], length, false);
+      }
+    }
+  }
+
+  // Lengths either side of the register sizes, and long odd lengths.
+  size_t implementation_lengths[] = {1,  7,  15, 16,  17,  31,   32,
+                                     33, 63, 65, 255, 999, 1021, 4095};
+  for (size_t b = 0; b < 6; b++) {
+    for (size_t l = 0; l < 14; l++) {
+      size_t length = implementation_lengths[l] -
+                      implementation_lengths[l] % bpps[b];
+      if (length == 0) {
+        continue;
+      }
+      for (size_t i = 0; i < 10; i++) {
+        check_implementations(bpps[b], length);
+      }
+    }
+  }
+
+  for (size_t b = 0; b < 6; b++) {
+    check_filter_row_adaptive(bpps[b], bpps[b] * 100, true);
+    check_filter_row_adaptive(bpps[b], bpps[b] * 100, false);
+  }
+
+  return 0;
+}
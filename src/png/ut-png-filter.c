@@ -0,0 +1,756 @@
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ut-cpu-private.h"
+#include "ut-png-filter-private.h"
+
+// Filtering and reconstruction of PNG rows. The filters use the following
+// inputs:
+//
+// +---+---+
+// | c | b |
+// +---+---+
+// | a | x |
+// +---+---+
+//
+// where [a] is the byte in the pixel to the left, [b] the byte in the row
+// above and [c] the byte in the pixel to the left in the row above.
+//
+// When reconstructing, the Sub, Average and Paeth filters depend on the
+// reconstructed pixel to the left, so the SIMD implementations either work on
+// a whole pixel at a time or use a prefix sum. Filtering has no such
+// dependency and works on a full register at a time. The SIMD implementations
+// give exactly the same results as the scalar implementations.
+
+static void unfilter_sub_scalar(uint8_t *row, size_t length, size_t bpp) {
+  for (size_t i = bpp; i < length; i++) {
+    row[i] += row[i - bpp];
+  }
+}
+
+static void unfilter_up_scalar(uint8_t *row, const uint8_t *previous_row,
+                               size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    row[i] += previous_row[i];
+  }
+}
+
+static void unfilter_average_scalar(uint8_t *row, const uint8_t *previous_row,
+                                    size_t length, size_t bpp) {
+  size_t i = 0;
+  for (; i < bpp && i < length; i++) {
+    row[i] += previous_row[i] / 2;
+  }
+  for (; i < length; i++) {
+    row[i] += (row[i - bpp] + previous_row[i]) / 2;
+  }
+}
+
+// The Average filter on the first row, where the row above is all zeros.
+static void unfilter_average_first_row(uint8_t *row, size_t length,
+                                       size_t bpp) {
+  for (size_t i = bpp; i < length; i++) {
+    row[i] += row[i - bpp] / 2;
+  }
+}
+
+// Returns whichever of [a], [b] and [c] is closest to a + b - c.
+// Written as selects rather than branches, as on real images the choice is
+// unpredictable.
+static uint8_t paeth_predictor(int32_t a, int32_t b, int32_t c) {
+  int32_t pa = abs(b - c);
+  int32_t pb = abs(a - c);
+  int32_t pc = abs(a + b - 2 * c);
+  int32_t nearest = pb <= pc ? b : c;
+  int32_t smallest = pb <= pc ? pb : pc;
+  return pa <= smallest ? a : nearest;
+}
+
+static void unfilter_paeth_scalar(uint8_t *row, const uint8_t *previous_row,
+                                  size_t length, size_t bpp) {
+  size_t i = 0;
+  for (; i < bpp && i < length; i++) {
+    row[i] += previous_row[i];
+  }
+  for (; i < length; i++) {
+    row[i] +=
+        paeth_predictor(row[i - bpp], previous_row[i], previous_row[i - bpp]);
+  }
+}
+
+// Filter bytes [start, length) in [row], where [start] >= [bpp].
+static void filter_bytes_scalar(UtPngFilterType filter_type, size_t bpp,
+                                const uint8_t *previous_row,
+                                const uint8_t *row, uint8_t *filtered_row,
+                                size_t start, size_t length) {
+  for (size_t i = start; i < length; i++) {
+    uint8_t a = row[i - bpp], b = previous_row[i], c = previous_row[i - bpp];
+    switch (filter_type) {
+    case UT_PNG_FILTER_TYPE_NONE:
+      filtered_row[i] = row[i];
+      break;
+    case UT_PNG_FILTER_TYPE_SUB:
+      filtered_row[i] = row[i] - a;
+      break;
+    case UT_PNG_FILTER_TYPE_UP:
+      filtered_row[i] = row[i] - b;
+      break;
+    case UT_PNG_FILTER_TYPE_AVERAGE:
+      filtered_row[i] = row[i] - (a + b) / 2;
+      break;
+    case UT_PNG_FILTER_TYPE_PAETH:
+      filtered_row[i] = row[i] - paeth_predictor(a, b, c);
+      break;
+    }
+  }
+}
+
+// Filter the first pixel in [row], which has no pixel to the left.
+static void filter_first_pixel(UtPngFilterType filter_type, size_t bpp,
+                               const uint8_t *previous_row, const uint8_t *row,
+                               uint8_t *filtered_row, size_t length) {
+  for (size_t i = 0; i < bpp && i < length; i++) {
+    switch (filter_type) {
+    case UT_PNG_FILTER_TYPE_NONE:
+    case UT_PNG_FILTER_TYPE_SUB:
+      filtered_row[i] = row[i];
+      break;
+    case UT_PNG_FILTER_TYPE_UP:
+    case UT_PNG_FILTER_TYPE_PAETH:
+      filtered_row[i] = row[i] - previous_row[i];
+      break;
+    case UT_PNG_FILTER_TYPE_AVERAGE:
+      filtered_row[i] = row[i] - previous_row[i] / 2;
+      break;
+    }
+  }
+}
+
+static void filter_row_scalar(UtPngFilterType filter_type, size_t bpp,
+                              const uint8_t *previous_row, const uint8_t *row,
+                              uint8_t *filtered_row, size_t length) {
+  filter_first_pixel(filter_type, bpp, previous_row, row, filtered_row,
+                     length);
+  filter_bytes_scalar(filter_type, bpp, previous_row, row, filtered_row, bpp,
+                      length);
+}
+
+// Returns the sum of the filtered bytes in [data] as signed values, which is
+// used to estimate how well a filtered row will compress.
+static uint64_t cost_scalar(const uint8_t *data, size_t length) {
+  uint64_t cost = 0;
+  for (size_t i = 0; i < length; i++) {
+    cost += data[i] < 128 ? data[i] : 256 - data[i];
+  }
+  return cost;
+}
+
+#if defined(__SSE2__)
+// Load the [bpp] byte pixel at [data] into the low bytes of a register.
+// Where at least eight bytes are [available] the pixel is read with a single
+// load, leaving the following bytes in the upper part of the register.
+// Always inlined so this is a few instructions for a constant [bpp].
+static inline __attribute__((always_inline)) __m128i
+load_pixel(const uint8_t *data, size_t bpp, size_t available) {
+  if (bpp == 8 || available >= 8) {
+    return _mm_loadl_epi64((const __m128i *)data);
+  }
+
+  uint32_t low = 0, high = 0;
+  switch (bpp) {
+  case 3:
+    memcpy(&low, data, 3);
+    break;
+  case 4:
+    memcpy(&low, data, 4);
+    break;
+  case 6:
+    memcpy(&low, data, 4);
+    memcpy(&high, data + 4, 2);
+    break;
+  }
+  return _mm_set_epi32(0, 0, high, low);
+}
+
+// Store the low [bpp] bytes of [pixel] to [data].
+static inline __attribute__((always_inline)) void
+store_pixel(uint8_t *data, __m128i pixel, size_t bpp) {
+  uint32_t low = _mm_cvtsi128_si32(pixel);
+  uint32_t high = _mm_cvtsi128_si32(_mm_srli_si128(pixel, 4));
+  switch (bpp) {
+  case 3:
+    memcpy(data, &low, 3);
+    break;
+  case 4:
+    memcpy(data, &low, 4);
+    break;
+  case 6:
+    memcpy(data, &low, 4);
+    memcpy(data + 4, &high, 2);
+    break;
+  case 8:
+    _mm_storel_epi64((__m128i *)data, pixel);
+    break;
+  }
+}
+
+// Number of bytes in a group of whole pixels that fits in a register.
+static size_t get_sub_chunk_length(size_t bpp) {
+  return bpp == 3 || bpp == 6 ? 12 : 16;
+}
+
+// Add each pixel in [x] to all the pixels after it.
+static __m128i prefix_sum_pixels(__m128i x, size_t bpp) {
+  switch (bpp) {
+  case 1:
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+    // fallthrough
+  case 2:
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+    // fallthrough
+  case 4:
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+    // fallthrough
+  case 8:
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+    break;
+  case 3:
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 3));
+    // fallthrough
+  case 6:
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 6));
+    break;
+  }
+  return x;
+}
+
+// Returns the last pixel in a chunk of [x] in the low bytes.
+static __m128i get_last_pixel(__m128i x, size_t bpp) {
+  switch (bpp) {
+  case 1:
+    return _mm_srli_si128(x, 15);
+  case 2:
+    return _mm_srli_si128(x, 14);
+  case 3:
+    return _mm_srli_si128(_mm_slli_si128(x, 4), 13);
+  case 4:
+    return _mm_srli_si128(x, 12);
+  case 6:
+    return _mm_srli_si128(_mm_slli_si128(x, 4), 10);
+  default:
+    return _mm_srli_si128(x, 8);
+  }
+}
+
+static void unfilter_sub_sse2(uint8_t *row, size_t length, size_t bpp) {
+  size_t chunk_length = get_sub_chunk_length(bpp);
+  __m128i last = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= length; i += chunk_length) {
+    __m128i x =
+        _mm_add_epi8(_mm_loadu_si128((const __m128i *)(row + i)), last);
+    x = prefix_sum_pixels(x, bpp);
+    if (chunk_length == 16) {
+      _mm_storeu_si128((__m128i *)(row + i), x);
+    } else {
+      _mm_storel_epi64((__m128i *)(row + i), x);
+      uint32_t end = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+      memcpy(row + i + 8, &end, 4);
+    }
+    last = get_last_pixel(x, bpp);
+  }
+
+  for (i = i < bpp ? bpp : i; i < length; i++) {
+    row[i] += row[i - bpp];
+  }
+}
+
+static void unfilter_up_sse2(uint8_t *row, const uint8_t *previous_row,
+                             size_t length) {
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(previous_row + i));
+    _mm_storeu_si128((__m128i *)(row + i), _mm_add_epi8(x, b));
+  }
+  unfilter_up_scalar(row + i, previous_row + i, length - i);
+}
+
+static inline __attribute__((always_inline)) void
+unfilter_average_pixels_sse2(uint8_t *row, const uint8_t *previous_row,
+                             size_t length, size_t bpp) {
+  __m128i one = _mm_set1_epi8(1);
+  __m128i a = _mm_setzero_si128();
+  for (size_t i = 0; i + bpp <= length; i += bpp) {
+    __m128i x = load_pixel(row + i, bpp, length - i);
+    __m128i b = load_pixel(previous_row + i, bpp, length - i);
+
+    // Rounding average, corrected to round down.
+    __m128i average = _mm_sub_epi8(
+        _mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+    a = _mm_add_epi8(x, average);
+    store_pixel(row + i, a, bpp);
+  }
+}
+
+static void unfilter_average_sse2(uint8_t *row, const uint8_t *previous_row,
+                                  size_t length, size_t bpp) {
+  // Pixels of one or two bytes have too little to do in parallel.
+  switch (bpp) {
+  case 3:
+    unfilter_average_pixels_sse2(row, previous_row, length, 3);
+    break;
+  case 4:
+    unfilter_average_pixels_sse2(row, previous_row, length, 4);
+    break;
+  case 6:
+    unfilter_average_pixels_sse2(row, previous_row, length, 6);
+    break;
+  case 8:
+    unfilter_average_pixels_sse2(row, previous_row, length, 8);
+    break;
+  default:
+    unfilter_average_scalar(row, previous_row, length, bpp);
+    break;
+  }
+}
+
+// Returns [value] if [mask] is set, otherwise [other].
+static __m128i select_sse2(__m128i mask, __m128i value, __m128i other) {
+  return _mm_or_si128(_mm_and_si128(mask, value),
+                      _mm_andnot_si128(mask, other));
+}
+
+// Returns the Paeth predictor in 16 bit lanes given the distances [pa], [pb]
+// and [pc] from [a], [b] and [c].
+static __m128i paeth_select_sse2(__m128i a, __m128i b, __m128i c, __m128i pa,
+                                 __m128i pb, __m128i pc) {
+  __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+  __m128i nearest = select_sse2(_mm_cmpeq_epi16(pb, smallest), b, c);
+  return select_sse2(_mm_cmpeq_epi16(pa, smallest), a, nearest);
+}
+
+static __m128i abs_sse2(__m128i value) {
+  return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+}
+
+static inline __attribute__((always_inline)) void
+unfilter_paeth_pixels_sse2(uint8_t *row, const uint8_t *previous_row,
+                           size_t length, size_t bpp) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i a = zero, c = zero;
+  for (size_t i = 0; i + bpp <= length; i += bpp) {
+    __m128i x = load_pixel(row + i, bpp, length - i);
+    __m128i b = _mm_unpacklo_epi8(
+        load_pixel(previous_row + i, bpp, length - i), zero);
+
+    __m128i pa = _mm_sub_epi16(b, c);
+    __m128i pb = _mm_sub_epi16(a, c);
+    __m128i pc = abs_sse2(_mm_add_epi16(pa, pb));
+    __m128i predictor =
+        paeth_select_sse2(a, b, c, abs_sse2(pa), abs_sse2(pb), pc);
+    x = _mm_add_epi8(x, _mm_packus_epi16(predictor, predictor));
+    store_pixel(row + i, x, bpp);
+
+    a = _mm_unpacklo_epi8(x, zero);
+    c = b;
+  }
+}
+
+static void unfilter_paeth_sse2(uint8_t *row, const uint8_t *previous_row,
+                                size_t length, size_t bpp) {
+  switch (bpp) {
+  case 3:
+    unfilter_paeth_pixels_sse2(row, previous_row, length, 3);
+    break;
+  case 4:
+    unfilter_paeth_pixels_sse2(row, previous_row, length, 4);
+    break;
+  case 6:
+    unfilter_paeth_pixels_sse2(row, previous_row, length, 6);
+    break;
+  case 8:
+    unfilter_paeth_pixels_sse2(row, previous_row, length, 8);
+    break;
+  default:
+    unfilter_paeth_scalar(row, previous_row, length, bpp);
+    break;
+  }
+}
+static void filter_row_sse2(UtPngFilterType filter_type, size_t bpp,
+                            const uint8_t *previous_row, const uint8_t *row,
+                            uint8_t *filtered_row, size_t length) {
+  filter_first_pixel(filter_type, bpp, previous_row, row, filtered_row,
+                     length);
+
+  __m128i zero = _mm_setzero_si128();
+  __m128i one = _mm_set1_epi8(1);
+  size_t i = bpp;
+  for (; i + 16 <= length; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+    __m128i a = _mm_loadu_si128((const __m128i *)(row + i - bpp));
+    __m128i b = _mm_loadu_si128((const __m128i *)(previous_row + i));
+    __m128i predictor;
+    switch (filter_type) {
+    default:
+    case UT_PNG_FILTER_TYPE_NONE:
+      predictor = zero;
+      break;
+    case UT_PNG_FILTER_TYPE_SUB:
+      predictor = a;
+      break;
+    case UT_PNG_FILTER_TYPE_UP:
+      predictor = b;
+      break;
+    case UT_PNG_FILTER_TYPE_AVERAGE:
+      predictor = _mm_sub_epi8(_mm_avg_epu8(a, b),
+                               _mm_and_si128(_mm_xor_si128(a, b), one));
+      break;
+    case UT_PNG_FILTER_TYPE_PAETH: {
+      __m128i c = _mm_loadu_si128((const __m128i *)(previous_row + i - bpp));
+      __m128i p[2];
+      for (size_t j = 0; j < 2; j++) {
+        __m128i a16 = j == 0 ? _mm_unpacklo_epi8(a, zero)
+                             : _mm_unpackhi_epi8(a, zero);
+        __m128i b16 = j == 0 ? _mm_unpacklo_epi8(b, zero)
+                             : _mm_unpackhi_epi8(b, zero);
+        __m128i c16 = j == 0 ? _mm_unpacklo_epi8(c, zero)
+                             : _mm_unpackhi_epi8(c, zero);
+        __m128i pa = _mm_sub_epi16(b16, c16);
+        __m128i pb = _mm_sub_epi16(a16, c16);
+        __m128i pc = abs_sse2(_mm_add_epi16(pa, pb));
+        p[j] = paeth_select_sse2(a16, b16, c16, abs_sse2(pa), abs_sse2(pb),
+                                 pc);
+      }
+      predictor = _mm_packus_epi16(p[0], p[1]);
+      break;
+    }
+    }
+    _mm_storeu_si128((__m128i *)(filtered_row + i),
+                     _mm_sub_epi8(x, predictor));
+  }
+
+  filter_bytes_scalar(filter_type, bpp, previous_row, row, filtered_row, i,
+                      length);
+}
+
+static uint64_t cost_sse2(const uint8_t *data, size_t length) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i sum = zero;
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    // The absolute value of a signed byte is the smaller of v and 256 - v.
+    __m128i x = _mm_loadu_si128((const __m128i *)(data + i));
+    __m128i magnitude = _mm_min_epu8(x, _mm_sub_epi8(zero, x));
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(magnitude, zero));
+  }
+  uint64_t sums[2];
+  _mm_storeu_si128((__m128i *)sums, sum);
+  return sums[0] + sums[1] + cost_scalar(data + i, length - i);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__SSE2__)
+// As unfilter_paeth_pixels_sse2, but with a native absolute value.
+__attribute__((target("ssse3"), always_inline)) static inline void
+unfilter_paeth_pixels_ssse3(uint8_t *row, const uint8_t *previous_row,
+                            size_t length, size_t bpp) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i a = zero, c = zero;
+  for (size_t i = 0; i + bpp <= length; i += bpp) {
+    __m128i x = load_pixel(row + i, bpp, length - i);
+    __m128i b = _mm_unpacklo_epi8(
+        load_pixel(previous_row + i, bpp, length - i), zero);
+
+    __m128i pa = _mm_sub_epi16(b, c);
+    __m128i pb = _mm_sub_epi16(a, c);
+    __m128i pc = _mm_abs_epi16(_mm_add_epi16(pa, pb));
+    __m128i predictor = paeth_select_sse2(a, b, c, _mm_abs_epi16(pa),
+                                          _mm_abs_epi16(pb), pc);
+    x = _mm_add_epi8(x, _mm_packus_epi16(predictor, predictor));
+    store_pixel(row + i, x, bpp);
+
+    a = _mm_unpacklo_epi8(x, zero);
+    c = b;
+  }
+}
+
+__attribute__((target("ssse3"))) static void
+unfilter_paeth_ssse3(uint8_t *row, const uint8_t *previous_row, size_t length,
+                     size_t bpp) {
+  switch (bpp) {
+  case 3:
+    unfilter_paeth_pixels_ssse3(row, previous_row, length, 3);
+    break;
+  case 4:
+    unfilter_paeth_pixels_ssse3(row, previous_row, length, 4);
+    break;
+  case 6:
+    unfilter_paeth_pixels_ssse3(row, previous_row, length, 6);
+    break;
+  case 8:
+    unfilter_paeth_pixels_ssse3(row, previous_row, length, 8);
+    break;
+  default:
+    unfilter_paeth_scalar(row, previous_row, length, bpp);
+    break;
+  }
+}
+#endif
+
+__attribute__((target("avx2"))) static void
+unfilter_up_avx2(uint8_t *row, const uint8_t *previous_row, size_t length) {
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(row + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(previous_row + i));
+    _mm256_storeu_si256((__m256i *)(row + i), _mm256_add_epi8(x, b));
+  }
+  unfilter_up_scalar(row + i, previous_row + i, length - i);
+}
+
+// Returns the Paeth predictor for 16 bit lanes, as paeth_select_sse2.
+__attribute__((target("avx2"))) static __m256i
+paeth_predictor_avx2(__m256i a, __m256i b, __m256i c) {
+  __m256i pa = _mm256_sub_epi16(b, c);
+  __m256i pb = _mm256_sub_epi16(a, c);
+  __m256i pc = _mm256_abs_epi16(_mm256_add_epi16(pa, pb));
+  pa = _mm256_abs_epi16(pa);
+  pb = _mm256_abs_epi16(pb);
+  __m256i smallest = _mm256_min_epi16(pc, _mm256_min_epi16(pa, pb));
+  __m256i nearest =
+      _mm256_blendv_epi8(c, b, _mm256_cmpeq_epi16(pb, smallest));
+  return _mm256_blendv_epi8(nearest, a, _mm256_cmpeq_epi16(pa, smallest));
+}
+
+// As filter_row_sse2, but 32 bytes at a time. The unpacks and packs work
+// within each 128 bit lane, so the Paeth predictors end up in order.
+__attribute__((target("avx2"))) static void
+filter_row_avx2(UtPngFilterType filter_type, size_t bpp,
+                const uint8_t *previous_row, const uint8_t *row,
+                uint8_t *filtered_row, size_t length) {
+  filter_first_pixel(filter_type, bpp, previous_row, row, filtered_row,
+                     length);
+
+  __m256i zero = _mm256_setzero_si256();
+  __m256i one = _mm256_set1_epi8(1);
+  size_t i = bpp;
+  for (; i + 32 <= length; i += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(row + i));
+    __m256i a = _mm256_loadu_si256((const __m256i *)(row + i - bpp));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(previous_row + i));
+    __m256i predictor;
+    switch (filter_type) {
+    default:
+    case UT_PNG_FILTER_TYPE_NONE:
+      predictor = zero;
+      break;
+    case UT_PNG_FILTER_TYPE_SUB:
+      predictor = a;
+      break;
+    case UT_PNG_FILTER_TYPE_UP:
+      predictor = b;
+      break;
+    case UT_PNG_FILTER_TYPE_AVERAGE:
+      predictor = _mm256_sub_epi8(
+          _mm256_avg_epu8(a, b), _mm256_and_si256(_mm256_xor_si256(a, b), one));
+      break;
+    case UT_PNG_FILTER_TYPE_PAETH: {
+      __m256i c =
+          _mm256_loadu_si256((const __m256i *)(previous_row + i - bpp));
+      __m256i low = paeth_predictor_avx2(_mm256_unpacklo_epi8(a, zero),
+                                         _mm256_unpacklo_epi8(b, zero),
+                                         _mm256_unpacklo_epi8(c, zero));
+      __m256i high = paeth_predictor_avx2(_mm256_unpackhi_epi8(a, zero),
+                                          _mm256_unpackhi_epi8(b, zero),
+                                          _mm256_unpackhi_epi8(c, zero));
+      predictor = _mm256_packus_epi16(low, high);
+      break;
+    }
+    }
+    _mm256_storeu_si256((__m256i *)(filtered_row + i),
+                        _mm256_sub_epi8(x, predictor));
+  }
+
+  filter_bytes_scalar(filter_type, bpp, previous_row, row, filtered_row, i,
+                      length);
+}
+
+__attribute__((target("avx2"))) static uint64_t cost_avx2(const uint8_t *data,
+                                                          size_t length) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i sum = zero;
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(data + i));
+    __m256i magnitude = _mm256_min_epu8(x, _mm256_sub_epi8(zero, x));
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(magnitude, zero));
+  }
+  uint64_t sums[4];
+  _mm256_storeu_si256((__m256i *)sums, sum);
+  return sums[0] + sums[1] + sums[2] + sums[3] +
+         cost_scalar(data + i, length - i);
+}
+#endif
+
+// Implementations from slowest to fastest, the last is the one used.
+static PngFilterFunctions implementations[4];
+static size_t n_implementations = 0;
+static pthread_once_t implementations_once = PTHREAD_ONCE_INIT;
+
+// Find the implementations the CPU supports. Rows are filtered from multiple
+// threads, so this is only done once.
+static void select_implementations() {
+  PngFilterFunctions f = {"scalar",
+                          unfilter_sub_scalar,
+                          unfilter_up_scalar,
+                          unfilter_average_scalar,
+                          unfilter_paeth_scalar,
+                          filter_row_scalar,
+                          cost_scalar};
+  implementations[n_implementations++] = f;
+#if defined(__SSE2__)
+  f.name = "sse2";
+  f.unfilter_sub = unfilter_sub_sse2;
+  f.unfilter_up = unfilter_up_sse2;
+  f.unfilter_average = unfilter_average_sse2;
+  f.unfilter_paeth = unfilter_paeth_sse2;
+  f.filter = filter_row_sse2;
+  f.cost = cost_sse2;
+  implementations[n_implementations++] = f;
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__SSE2__)
+  if (_ut_cpu_has_ssse3()) {
+    f.name = "ssse3";
+    f.unfilter_paeth = unfilter_paeth_ssse3;
+    implementations[n_implementations++] = f;
+  }
+#endif
+  if (_ut_cpu_has_avx2()) {
+    f.name = "avx2";
+    f.unfilter_up = unfilter_up_avx2;
+    f.filter = filter_row_avx2;
+    f.cost = cost_avx2;
+    implementations[n_implementations++] = f;
+  }
+#endif
+}
+
+static const PngFilterFunctions *get_filter_functions() {
+  pthread_once(&implementations_once, select_implementations);
+  return &implementations[n_implementations - 1];
+}
+
+size_t png_get_filter_functions(const PngFilterFunctions **functions) {
+  pthread_once(&implementations_once, select_implementations);
+  *functions = implementations;
+  return n_implementations;
+}
+
+void png_unfilter_row(UtPngFilterType filter_type, size_t bpp,
+                      const uint8_t *previous_row, uint8_t *row,
+                      size_t length) {
+  const PngFilterFunctions *functions = get_filter_functions();
+  switch (filter_type) {
+  case UT_PNG_FILTER_TYPE_NONE:
+    break;
+  case UT_PNG_FILTER_TYPE_SUB:
+    functions->unfilter_sub(row, length, bpp);
+    break;
+  case UT_PNG_FILTER_TYPE_UP:
+    if (previous_row != NULL) {
+      functions->unfilter_up(row, previous_row, length);
+    }
+    break;
+  case UT_PNG_FILTER_TYPE_AVERAGE:
+    if (previous_row != NULL) {
+      functions->unfilter_average(row, previous_row, length, bpp);
+    } else {
+      unfilter_average_first_row(row, length, bpp);
+    }
+    break;
+  case UT_PNG_FILTER_TYPE_PAETH:
+    // With the row above all zeros, the predictor is always the left pixel.
+    if (previous_row != NULL) {
+      functions->unfilter_paeth(row, previous_row, length, bpp);
+    } else {
+      functions->unfilter_sub(row, length, bpp);
+    }
+    break;
+  }
+}
+
+void png_filter_row(UtPngFilterType filter_type, size_t bpp,
+                    const uint8_t *previous_row, const uint8_t *row,
+                    uint8_t *filtered_row, size_t length) {
+  if (previous_row != NULL) {
+    get_filter_functions()->filter(filter_type, bpp, previous_row, row,
+                                   filtered_row, length);
+    return;
+  }
+
+  // On the first row Up is the same as None and Paeth the same as Sub, as the
+  // row above is all zeros.
+  switch (filter_type) {
+  case UT_PNG_FILTER_TYPE_NONE:
+  case UT_PNG_FILTER_TYPE_UP:
+    memcpy(filtered_row, row, length);
+    break;
+  case UT_PNG_FILTER_TYPE_SUB:
+  case UT_PNG_FILTER_TYPE_PAETH:
+    for (size_t i = 0; i < length; i++) {
+      filtered_row[i] = row[i] - (i >= bpp ? row[i - bpp] : 0);
+    }
+    break;
+  case UT_PNG_FILTER_TYPE_AVERAGE:
+    for (size_t i = 0; i < length; i++) {
+      filtered_row[i] = row[i] - (i >= bpp ? row[i - bpp] / 2 : 0);
+    }
+    break;
+  }
+}
+
+UtPngFilterType png_filter_row_adaptive(size_t bpp,
+                                        const uint8_t *previous_row,
+                                        const uint8_t *row,
+                                        uint8_t *filtered_row, size_t length) {
+  const PngFilterFunctions *functions = get_filter_functions();
+  UtPngFilterType filter_types[] = {
+      UT_PNG_FILTER_TYPE_NONE, UT_PNG_FILTER_TYPE_SUB, UT_PNG_FILTER_TYPE_UP,
+      UT_PNG_FILTER_TYPE_AVERAGE, UT_PNG_FILTER_TYPE_PAETH};
+  size_t n_filter_types = 5;
+
+  // Up and Paeth are the same as None and Sub on the first row.
+  if (previous_row == NULL) {
+    filter_types[2] = UT_PNG_FILTER_TYPE_AVERAGE;
+    n_filter_types = 3;
+  }
+
+  UtPngFilterType best_filter_type = UT_PNG_FILTER_TYPE_NONE;
+  uint64_t best_cost = UINT64_MAX;
+  for (size_t i = 0; i < n_filter_types; i++) {
+    png_filter_row(filter_types[i], bpp, previous_row, row, filtered_row,
+                   length);
+    uint64_t cost = functions->cost(filtered_row, length);
+    if (cost < best_cost) {
+      best_filter_type = filter_types[i];
+      best_cost = cost;
+    }
+  }
+
+  if (best_filter_type != filter_types[n_filter_types - 1]) {
+    png_filter_row(best_filter_type, bpp, previous_row, row, filtered_row,
+                   length);
+  }
+
+  return best_filter_type;
+}
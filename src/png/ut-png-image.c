@@ -55,210 +55,6 @@ static size_t get_row_stride(uint32_t width, uint8_t bit_depth,
   return (((size_t)width * bit_depth * n_channels) + 7) / 8;
 }
 
-static void add_rgba(uint8_t *rgba_data, size_t *rgba_offset, uint8_t r,
-                     uint8_t g, uint8_t b, uint8_t a) {
-  rgba_data[(*rgba_offset)++] = r;
-  rgba_data[(*rgba_offset)++] = g;
-  rgba_data[(*rgba_offset)++] = b;
-  rgba_data[(*rgba_offset)++] = a;
-}
-
-// Calculate value that multiples a sample of [bit_depth] to 8 bits.
-// Requires [bit_depth] is 1, 2, 4, or 8;
-static uint8_t get_sample_multiplier(size_t bit_depth) {
-  return 255 / ((1 << bit_depth) - 1);
-}
-
-static void convert_greyscale_to_rgba(size_t width, size_t height,
-                                      size_t bit_depth, const uint8_t *data,
-                                      uint8_t *rgba_data) {
-  // Cases when maximum one sample per byte.
-  if (bit_depth == 8) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset++) {
-      uint8_t v = data[data_offset];
-      add_rgba(rgba_data, &rgba_offset, v, v, v, 0xff);
-    }
-    return;
-  } else if (bit_depth == 16) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height * 2;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset += 2) {
-      uint16_t d0 = data[data_offset];
-      uint16_t d1 = data[data_offset + 1];
-      uint8_t v = (d0 << 8 | d1) / 257;
-      add_rgba(rgba_data, &rgba_offset, v, v, v, 0xff);
-    }
-    return;
-  }
-
-  // Cases when multiple samples per byte.
-  uint8_t sample_multiplier = get_sample_multiplier(bit_depth);
-  size_t row_stride = get_row_stride(width, bit_depth, 1);
-  size_t samples_per_byte = 8 / bit_depth;
-  uint8_t mask = 0xff >> (8 - bit_depth);
-  size_t data_offset = 0;
-  size_t rgba_offset = 0;
-  for (size_t y = 0; y < height; y++) {
-    size_t x = 0;
-    for (size_t row_offset = 0; row_offset < row_stride; row_offset++) {
-      uint8_t d = data[data_offset++];
-      for (size_t i = 0; i < samples_per_byte && x < width; i++) {
-        size_t shift = 8 - (bit_depth * (i + 1));
-        uint8_t v = ((d >> shift) & mask) * sample_multiplier;
-        add_rgba(rgba_data, &rgba_offset, v, v, v, 0xff);
-        x++;
-      }
-    }
-  }
-}
-
-static void convert_truecolor_to_rgba(size_t width, size_t height,
-                                      size_t bit_depth, const uint8_t *data,
-                                      uint8_t *rgba_data) {
-  if (bit_depth == 8) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height * 3;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset += 3) {
-      uint8_t r = data[data_offset];
-      uint8_t g = data[data_offset + 1];
-      uint8_t b = data[data_offset + 2];
-      add_rgba(rgba_data, &rgba_offset, r, g, b, 0xff);
-    }
-  } else if (bit_depth == 16) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height * 6;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset += 6) {
-      uint16_t d0 = data[data_offset];
-      uint16_t d1 = data[data_offset + 1];
-      uint16_t d2 = data[data_offset + 2];
-      uint16_t d3 = data[data_offset + 3];
-      uint16_t d4 = data[data_offset + 4];
-      uint16_t d5 = data[data_offset + 5];
-      uint8_t r = (d0 << 8 | d1) / 257;
-      uint8_t g = (d2 << 8 | d3) / 257;
-      uint8_t b = (d4 << 8 | d5) / 257;
-      add_rgba(rgba_data, &rgba_offset, r, g, b, 0xff);
-    }
-  }
-}
-
-static void add_indexed_rgba(uint8_t *rgba_data, size_t *rgba_offset,
-                             const uint8_t *palette, size_t palette_length,
-                             uint8_t index) {
-  uint8_t r, g, b;
-  if (index < palette_length) {
-    r = palette[index * 3];
-    g = palette[index * 3 + 1];
-    b = palette[index * 3 + 2];
-  } else {
-    r = g = b = 0;
-  }
-  add_rgba(rgba_data, rgba_offset, r, g, b, 0xff);
-}
-
-static void convert_indexed_to_rgba(size_t width, size_t height,
-                                    size_t bit_depth, const uint8_t *data,
-                                    const uint8_t *palette,
-                                    size_t palette_length, uint8_t *rgba_data) {
-  // Cases when maximum one sample per byte.
-  if (bit_depth == 8) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset++) {
-      uint8_t index = data[data_offset];
-      add_indexed_rgba(rgba_data, &rgba_offset, palette, palette_length, index);
-    }
-    return;
-  }
-
-  // Cases when multiple samples per byte.
-  size_t row_stride = get_row_stride(width, bit_depth, 1);
-  size_t samples_per_byte = 8 / bit_depth;
-  uint8_t mask = 0xff >> (8 - bit_depth);
-  size_t data_offset = 0;
-  size_t rgba_offset = 0;
-  for (size_t y = 0; y < height; y++) {
-    size_t x = 0;
-    for (size_t row_offset = 0; row_offset < row_stride; row_offset++) {
-      uint8_t d = data[data_offset++];
-      for (size_t i = 0; i < samples_per_byte && x < width; i++) {
-        size_t shift = 8 - (bit_depth * (i + 1));
-        uint8_t index = (d >> shift) & mask;
-        add_indexed_rgba(rgba_data, &rgba_offset, palette, palette_length,
-                         index);
-        x++;
-      }
-    }
-  }
-}
-
-static void convert_greyscale_with_alpha_to_rgba(size_t width, size_t height,
-                                                 size_t bit_depth,
-                                                 const uint8_t *data,
-                                                 uint8_t *rgba_data) {
-  // Cases when maximum one sample per byte.
-  if (bit_depth == 8) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height * 2;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset += 2) {
-      uint8_t v = data[data_offset];
-      uint8_t a = data[data_offset + 1];
-      add_rgba(rgba_data, &rgba_offset, v, v, v, a);
-    }
-    return;
-  } else if (bit_depth == 16) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height * 4;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset += 4) {
-      uint16_t d0 = data[data_offset];
-      uint16_t d1 = data[data_offset + 1];
-      uint16_t d2 = data[data_offset + 2];
-      uint16_t d3 = data[data_offset + 3];
-      uint8_t v = (d0 << 8 | d1) / 257;
-      uint8_t a = (d2 << 8 | d3) / 257;
-      add_rgba(rgba_data, &rgba_offset, v, v, v, a);
-    }
-    return;
-  }
-}
-
-static void convert_truecolor_with_alpha_to_rgba(size_t width, size_t height,
-                                                 size_t bit_depth,
-                                                 const uint8_t *data,
-                                                 uint8_t *rgba_data) {
-  if (bit_depth == 8) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height * 4;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset += 4) {
-      uint8_t r = data[data_offset];
-      uint8_t g = data[data_offset + 1];
-      uint8_t b = data[data_offset + 2];
-      uint8_t a = data[data_offset + 3];
-      add_rgba(rgba_data, &rgba_offset, r, g, b, a);
-    }
-  } else if (bit_depth == 16) {
-    size_t rgba_offset = 0;
-    size_t data_length = width * height * 8;
-    for (size_t data_offset = 0; data_offset < data_length; data_offset += 8) {
-      uint16_t d0 = data[data_offset];
-      uint16_t d1 = data[data_offset + 1];
-      uint16_t d2 = data[data_offset + 2];
-      uint16_t d3 = data[data_offset + 3];
-      uint16_t d4 = data[data_offset + 4];
-      uint16_t d5 = data[data_offset + 5];
-      uint16_t d6 = data[data_offset + 6];
-      uint16_t d7 = data[data_offset + 7];
-      uint8_t r = (d0 << 8 | d1) / 257;
-      uint8_t g = (d2 << 8 | d3) / 257;
-      uint8_t b = (d4 << 8 | d5) / 257;
-      uint8_t a = (d6 << 8 | d7) / 257;
-      add_rgba(rgba_data, &rgba_offset, r, g, b, a);
-    }
-  }
-}
-
 static void ut_png_image_cleanup(UtObject *object) {
   UtPngImage *self = (UtPngImage *)object;
   ut_object_unref(self->palette);
@@ -360,6 +156,46 @@ size_t ut_png_image_get_row_stride(UtObject *object) {
                         get_n_channels(self->color_type));
 }
 
+UtPixelFormat ut_png_image_get_pixel_format(UtObject *object) {
+  assert(ut_object_is_png_image(object));
+  UtPngImage *self = (UtPngImage *)object;
+  bool is_16_bit = self->bit_depth == 16;
+  switch (self->color_type) {
+  case UT_PNG_COLOR_TYPE_GREYSCALE:
+    switch (self->bit_depth) {
+    case 1:
+      return UT_PIXEL_FORMAT_GREY1;
+    case 2:
+      return UT_PIXEL_FORMAT_GREY2;
+    case 4:
+      return UT_PIXEL_FORMAT_GREY4;
+    case 8:
+      return UT_PIXEL_FORMAT_GREY8;
+    default:
+      return UT_PIXEL_FORMAT_GREY16;
+    }
+  case UT_PNG_COLOR_TYPE_INDEXED_COLOR:
+    switch (self->bit_depth) {
+    case 1:
+      return UT_PIXEL_FORMAT_INDEXED1;
+    case 2:
+      return UT_PIXEL_FORMAT_INDEXED2;
+    case 4:
+      return UT_PIXEL_FORMAT_INDEXED4;
+    default:
+      return UT_PIXEL_FORMAT_INDEXED8;
+    }
+  case UT_PNG_COLOR_TYPE_GREYSCALE_WITH_ALPHA:
+    return is_16_bit ? UT_PIXEL_FORMAT_GREY_ALPHA16
+                     : UT_PIXEL_FORMAT_GREY_ALPHA8;
+  case UT_PNG_COLOR_TYPE_TRUECOLOR:
+    return is_16_bit ? UT_PIXEL_FORMAT_RGB16 : UT_PIXEL_FORMAT_RGB8;
+  case UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA:
+  default:
+    return is_16_bit ? UT_PIXEL_FORMAT_RGBA16 : UT_PIXEL_FORMAT_RGBA8;
+  }
+}
+
 void ut_png_image_set_palette(UtObject *object, UtObject *palette) {
   assert(ut_object_is_png_image(object));
   UtPngImage *self = (UtPngImage *)object;
@@ -518,37 +354,14 @@ UtObject *ut_png_image_to_rgba(UtObject *object) {
     return ut_object_ref(self->data);
   }
 
-  const uint8_t *data = ut_uint8_list_get_data(self->data);
-
-  UtObjectRef rgba = ut_uint8_array_new_sized(self->width * self->height * 4);
-  uint8_t *rgba_data = ut_uint8_list_get_writable_data(rgba);
-
-  switch (self->color_type) {
-  case UT_PNG_COLOR_TYPE_GREYSCALE:
-    convert_greyscale_to_rgba(self->width, self->height, self->bit_depth, data,
-                              rgba_data);
-    break;
-  case UT_PNG_COLOR_TYPE_TRUECOLOR:
-    convert_truecolor_to_rgba(self->width, self->height, self->bit_depth, data,
-                              rgba_data);
-    break;
-  case UT_PNG_COLOR_TYPE_INDEXED_COLOR:
-    // FIXME: Extend palette if < 256 to avoid any errors. Or validate indexes.
-    convert_indexed_to_rgba(self->width, self->height, self->bit_depth, data,
-                            ut_uint8_list_get_data(self->palette),
-                            ut_list_get_length(self->palette) / 3, rgba_data);
-    break;
-  case UT_PNG_COLOR_TYPE_GREYSCALE_WITH_ALPHA:
-    convert_greyscale_with_alpha_to_rgba(self->width, self->height,
-                                         self->bit_depth, data, rgba_data);
-    break;
-  case UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA:
-    convert_truecolor_with_alpha_to_rgba(self->width, self->height,
-                                         self->bit_depth, data, rgba_data);
-    break;
+  UtObjectRef converter = ut_pixel_converter_new(
+      ut_png_image_get_pixel_format(object), UT_PIXEL_FORMAT_RGBA8);
+  if (self->palette != NULL) {
+    ut_pixel_converter_set_palette(converter, self->palette);
   }
-
-  return ut_object_ref(rgba);
+  return ut_pixel_converter_convert(converter, self->data, self->width,
+                                    self->height,
+                                    ut_png_image_get_row_stride(object));
 }
 
 bool ut_object_is_png_image(UtObject *object) {
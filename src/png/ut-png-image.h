@@ -2,6 +2,7 @@
 #include <stdint.h>
 
 #include "ut-object.h"
+#include "ut-pixel-format.h"
 
 #pragma once
 
@@ -48,6 +49,9 @@ size_t ut_png_image_get_n_channels(UtObject *object);
 /// Returns the number of channels per pixel.
 size_t ut_png_image_get_row_stride(UtObject *object);
 
+/// Returns the format of the pixels in the image data.
+UtPixelFormat ut_png_image_get_pixel_format(UtObject *object);
+
 /// Sets the RGB [palette] for this image.
 ///
 /// !arg-type palette UtUint8List
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef enum {
   UT_PNG_CHUNK_TYPE_IMAGE_HEADER = 0x49484452,
   UT_PNG_CHUNK_TYPE_PALETTE = 0x504c5445,
@@ -26,3 +29,31 @@ typedef enum {
   UT_PNG_INTERLACE_METHOD_NONE,
   UT_PNG_INTERLACE_METHOD_ADAM7
 } UtPngInterlaceMethod;
+
+typedef enum {
+  UT_PNG_FILTER_TYPE_NONE,
+  UT_PNG_FILTER_TYPE_SUB,
+  UT_PNG_FILTER_TYPE_UP,
+  UT_PNG_FILTER_TYPE_AVERAGE,
+  UT_PNG_FILTER_TYPE_PAETH
+} UtPngFilterType;
+
+// Reverse [filter_type] on the [length] bytes in [row] in place, where pixels
+// are [bpp] bytes (rounded up to 1).
+// [previous_row] is the reconstructed row above, or NULL for the first row.
+void png_unfilter_row(UtPngFilterType filter_type, size_t bpp,
+                      const uint8_t *previous_row, uint8_t *row, size_t length);
+
+// Apply [filter_type] to the [length] bytes in [row], writing the result to
+// [filtered_row]. [previous_row] is the unfiltered row above, or NULL for the
+// first row.
+void png_filter_row(UtPngFilterType filter_type, size_t bpp,
+                    const uint8_t *previous_row, const uint8_t *row,
+                    uint8_t *filtered_row, size_t length);
+
+// Filter [row] with whichever filter gives the smallest sum of the absolute
+// values of the filtered bytes, and return the filter used.
+UtPngFilterType png_filter_row_adaptive(size_t bpp,
+                                        const uint8_t *previous_row,
+                                        const uint8_t *row,
+                                        uint8_t *filtered_row, size_t length);
@@ -1529,3 +1529,301 @@ const char *palette8_image_data =
     "1c1c1c1c191919199090909043434343d6d6d6d60f0f0f0f9696969657575757"
     "828282827e7e7e7e7c7c7c7c01010101cececece1a1a1a1a21212121cbcbcbcb"
     "efefefef707070706f6f6f6f28282828c5c5c5c5272727279d9d9d9d50505050";
+
+const char *tiled_grayscale8_data =
+    "49492a000806000000070e151c232a31383f464d545b62690d141b232a313940474f565d"
+    "656c737b1a2129313840484f575f666e767d858d272f373f474f575f676f777f878f979f"
+    "343c444d555d666e767f878f98a0a8b14149525b636c757d868f97a0a9b1bac34e576069"
+    "727b848d969fa8b1bac3ccd55b646d778089939ca5afb8c1cbd4dde768717b858e98a2ab"
+    "b5bfc8d2dce5eff9757f89939da7b1bbc5cfd9e3edf7010b828c96a1abb5c0cad4dfe9f3"
+    "fe08121d8f99a4afb9c4cfd9e4eff9040f19242f9ca7b2bdc8d3dee9f4ff0a15202b3641"
+    "a9b4bfcbd6e1edf8030f1a25313c4753b6c1cdd9e4f0fc07131f2a36424d5965c3cfdbe7"
+    "f3ff0b17232f3b47535f6b7770777e858c939aa1a8afb6bdc4cbd2d9828991989fa7aeb5"
+    "bdc4cbd3dae1e9f0949ca4abb3bbc2cad2d9e1e9f0f80007a7afb7bfc7cfd7dfe7eff7ff"
+    "070f171fb9c1cad2dae3ebf3fc040c151d252e36cbd4dde5eef7ff081119222b333c454d"
+    "dee7f0f9020b141d262f38414a535c65f0f9030c151f28313b444d576069737c020c161f"
+    "29333c465059636d76808a93151f29333d47515b656f79838d97a1ab27313c46505b656f"
+    "7a848e99a3adb8c239444f59646f79848f99a4afb9c4cfd94c57626d78838e99a4afbac5"
+    "d0dbe6f15e6975808b97a2adb9c4cfdbe6f1fd08707c88939fabb6c2ced9e5f1fc08141f"
+    "838f9ba7b3bfcbd7e3effb07131f2b37e0e7eef5fc030a110000000000000000f7ff060d"
+    "151c232b00000000000000000f171e262e353d450000000000000000272f373f474f575f"
+    "00000000000000003e474f57606870790000000000000000565f677079818a9300000000"
+    "000000006e778089929ba4ad0000000000000000858f98a1abb4bdc70000000000000000"
+    "9da7b0bac4cdd7e10000000000000000b5bfc9d3dde7f1fb0000000000000000ccd7e1eb"
+    "f6000a150000000000000000e4eff9040f19242f0000000000000000fc07121d28333e49"
+    "0000000000000000131f2a35414c576300000000000000002b37424e5a65717d00000000"
+    "00000000434f5b67737f8b970000000000000000d0dce8f5010d1a26323f4b5764707c89"
+    "dde9f6030f1c2935424f5b6875818e9beaf704111e2b3845525f6c798693a0adf704111f"
+    "2c394754616f7c8997a4b1bf04111f2d3a485663717f8c9aa8b5c3d1111f2d3b49576573"
+    "818f9dabb9c7d5e31e2c3a4957657482909fadbbcad8e6f52b39485765748391a0afbdcc"
+    "dbe9f8070000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000000000000000000000000000"
+    "00000000000000000000000000000000000000000000000095a1aebac6d3dfebf804101d"
+    "2935424ea7b4c1cddae7f3000d1926333f4c5965bac7d4e1eefb0815222f3c495663707d"
+    "ccd9e7f4010f1c293744515f6c798794deecfa071523303e4c59677582909eabf1ff0d1b"
+    "29374553616f7d8b99a7b5c30311202e3c4b5967768492a1afbdccda15243341505f6d7c"
+    "8b99a8b7c5d4e3f100000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000000000005a67737f8c98a4b1"
+    "0000000000000000727f8b98a5b1becb00000000000000008a97a4b1becbd8e500000000"
+    "00000000a1afbcc9d7e4f1ff0000000000000000b9c7d4e2f0fd0b190000000000000000"
+    "d1dfedfb091725330000000000000000e8f7051322303e4d0000000000000000000f1d2c"
+    "3b4958670000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000000000000000000000000000"
+    "00000000000000000000000000000000000000000000000000000000000000000a000001"
+    "030001000000280000000101030001000000180000000201030001000000080000000301"
+    "030001000000010000000601030001000000010000001501030001000000010000004201"
+    "030001000000100000004301030001000000100000004401040006000000860600004501"
+    "0400060000009e0600000000000008000000080100000802000008030000080400000805"
+    "0000000100000001000000010000000100000001000000010000";
+
+const char *tiled_grayscale8_image_data =
+    "00070e151c232a31383f464d545b626970777e858c939aa1a8afb6bdc4cbd2d9e0e7eef5"
+    "fc030a110d141b232a313940474f565d656c737b828991989fa7aeb5bdc4cbd3dae1e9f0"
+    "f7ff060d151c232b1a2129313840484f575f666e767d858d949ca4abb3bbc2cad2d9e1e9"
+    "f0f800070f171e262e353d45272f373f474f575f676f777f878f979fa7afb7bfc7cfd7df"
+    "e7eff7ff070f171f272f373f474f575f343c444d555d666e767f878f98a0a8b1b9c1cad2"
+    "dae3ebf3fc040c151d252e363e474f57606870794149525b636c757d868f97a0a9b1bac3"
+    "cbd4dde5eef7ff081119222b333c454d565f677079818a934e576069727b848d969fa8b1"
+    "bac3ccd5dee7f0f9020b141d262f38414a535c656e778089929ba4ad5b646d778089939c"
+    "a5afb8c1cbd4dde7f0f9030c151f28313b444d576069737c858f98a1abb4bdc768717b85"
+    "8e98a2abb5bfc8d2dce5eff9020c161f29333c465059636d76808a939da7b0bac4cdd7e1"
+    "757f89939da7b1bbc5cfd9e3edf7010b151f29333d47515b656f79838d97a1abb5bfc9d3"
+    "dde7f1fb828c96a1abb5c0cad4dfe9f3fe08121d27313c46505b656f7a848e99a3adb8c2"
+    "ccd7e1ebf6000a158f99a4afb9c4cfd9e4eff9040f19242f39444f59646f79848f99a4af"
+    "b9c4cfd9e4eff9040f19242f9ca7b2bdc8d3dee9f4ff0a15202b36414c57626d78838e99"
+    "a4afbac5d0dbe6f1fc07121d28333e49a9b4bfcbd6e1edf8030f1a25313c47535e697580"
+    "8b97a2adb9c4cfdbe6f1fd08131f2a35414c5763b6c1cdd9e4f0fc07131f2a36424d5965"
+    "707c88939fabb6c2ced9e5f1fc08141f2b37424e5a65717dc3cfdbe7f3ff0b17232f3b47"
+    "535f6b77838f9ba7b3bfcbd7e3effb07131f2b37434f5b67737f8b97d0dce8f5010d1a26"
+    "323f4b5764707c8995a1aebac6d3dfebf804101d2935424e5a67737f8c98a4b1dde9f603"
+    "0f1c2935424f5b6875818e9ba7b4c1cddae7f3000d1926333f4c5965727f8b98a5b1becb"
+    "eaf704111e2b3845525f6c798693a0adbac7d4e1eefb0815222f3c495663707d8a97a4b1"
+    "becbd8e5f704111f2c394754616f7c8997a4b1bfccd9e7f4010f1c293744515f6c798794"
+    "a1afbcc9d7e4f1ff04111f2d3a485663717f8c9aa8b5c3d1deecfa071523303e4c596775"
+    "82909eabb9c7d4e2f0fd0b19111f2d3b49576573818f9dabb9c7d5e3f1ff0d1b29374553"
+    "616f7d8b99a7b5c3d1dfedfb091725331e2c3a4957657482909fadbbcad8e6f50311202e"
+    "3c4b5967768492a1afbdccdae8f7051322303e4d2b39485765748391a0afbdccdbe9f807"
+    "15243341505f6d7c8b99a8b7c5d4e3f1000f1d2c3b495867";
+
+const char *tiled_rgb8_deflate_data =
+    "49492a0034030000789c63304a612705f0da1742181c1c1cc430a47cea200c882041867a"
+    "64370729c0246d0684c1c9c9490cc3b1782984011124c8f06bd8c4490a88eedd0f617071"
+    "7111c3c8987506c280081264942ebfc9450a68daf20cc2e0e6e62686d17ff03384011124"
+    "c898738e819b14b0f2362f84c1c3c3430c63db0b29080322489071f8ab3a0f290000a5da"
+    "3261789c2b5874859d14d0b4e51990e4e0e080700932a61cfbc101061011828ce537b939"
+    "48013b5fcb02494e4e4e089720e3f45f7d4e3080881064dc1370e224057c500a01925c5c"
+    "5c102e410693491a17184044083244dd2bb94801ea91dd40929b9b1bc225c8b0cc9ecb0d"
+    "061011820c9fba0ddca480b8098780240f0f0f844b9051b0e80a0f18404408329ab73ee7"
+    "21050000c12333d2789c7b20e4c28e0dbcdfdbcd800d7cd78ce6e0e080a841665c5d5c88"
+    "553dbf633144190718c019bb3bc3b1aa578fece6c00616e6db62556f57b088939313a206"
+    "99d11eaa8c557d58c72e88324e30803372ad39b1aacf5b7089131b08567c8f557debf697"
+    "5c5c5c1035c80c4bf6ab58d5cf3dcf0851c605067086fcdbdd58d56f7d2ec9850db05e5e"
+    "8855fd997f06dcdcdc1035c88cd73bdbb1aa7f22e60151c60d0670c6c5f9b958d5ffd14b"
+    "e0c606b6b70663552fec5acec3c3035183cc989b6d8955bd766c3f44190f18c019cd81f2"
+    "58d53b972ee7c10632cd59b1aa0700b5b63a01789cbbc064c20306bcbcbcc430eef23b42"
+    "181041828c57327ebca480ef9ad110061f1f1f310c16b30c080322489021e85cca470a90"
+    "0b688230f8f9f9896168c7f643181041820c865130a0000048a41b71789c9b7afc270f0f"
+    "0f2f2f2f0f1810642cbfc9cd0b061011828c5d6fe478490167fe1900493e3e3e089720e3"
+    "9e80131f18404408323e2a87f29102984dd381243f3f3f844b9021ea5ec90f061011820c"
+    "865130a000001bb91ea8789c8bead9c7cbcbcb0306c80c7fd9d70cd840d1926b1065bc60"
+    "006798325fc4aabe6bcf3b5e6c40fae576acea175e66e5e3e383a84166309e9f8b55fdce"
+    "d7b210657c6000673cdfda8c55fd4566533e6ce0ecec4cacea5f48f9f0f3f343d4203336"
+    "37fa6355cf60940251c60f0670c6cc7453ecea47c1800200871d21010b00000103000100"
+    "0000280000000101030001000000180000000201030003000000be030000030103000100"
+    "0000080000000601030001000000020000001501030001000000030000003d0103000100"
+    "000002000000420103000100000010000000430103000100000010000000440104000600"
+    "0000c40300004501040006000000dc030000000000000800080008000800000092000000"
+    "280100000b0200005c020000b60200008a00000096000000e3000000510000005a000000"
+    "7e000000";
+
+const char *tiled_rgb8_deflate_image_data =
+    "00326407396b0e40721547791c4e802355872a5c8e316395386a9c3f71a34678aa4d7fb1"
+    "5486b85b8dbf6294c6699bcd70a2d477a9db7eb0e285b7e98cbef093c5f79accfea1d305"
+    "a8da0cafe113b6e81abdef21c4f628cbfd2fd20436d90b3de01244e7194bee2052f52759"
+    "fc2e600335670a3c6e1143750d3f711446781b4d7f2355872a5c8e316395396b9d4072a4"
+    "4779ab4f81b35688ba5d8fc16597c96c9ed073a5d77baddf82b4e689bbed91c3f598cafc"
+    "9fd103a7d90baee012b5e719bdef21c4f628cbfd2fd30537da0c3ee11345e91b4df02254"
+    "f7295bff316306386a0d3f711547791c4e802355872b5d8f1a4c7e215385295b8d316395"
+    "386a9c4072a4487aac4f81b35789bb5f91c36698ca6ea0d276a8da7dafe185b7e98dbff1"
+    "94c6f89cce00a4d608abdd0fb3e517bbed1fc2f426cafc2ed20436d90b3de11345e91b4d"
+    "f02254f82a5c00326407396b0f417317497b1e508226588a2e60923567993d6fa14577a9"
+    "27598b2f619337699b3f71a34779ab4f81b35789bb5f91c36799cb6fa1d377a9db7fb1e3"
+    "87b9eb8fc1f397c9fb9fd103a7d90bafe113b7e91bbff123c7f92bcf0133d7093bdf1143"
+    "e7194bef2153f7295bff316307396b0f417317497b1f518327598b2f619337699b3f71a3"
+    "4779ab4f81b35789bb5f91c33466983c6ea04476a84d7fb15587b95d8fc16698ca6ea0d2"
+    "76a8da7fb1e387b9eb8fc1f398cafca0d204a8da0cb1e315b9eb1dc1f325cafc2ed20436"
+    "da0c3ee31547eb1d4ff32557fc2e600436680c3e701547791d4f812557892e609236689a"
+    "3e70a24779ab4f81b35789bb6092c4689acc70a2d479abdd4173a5497bad5284b65b8dbf"
+    "6395c76c9ed075a7d97dafe186b8ea8fc1f397c9fba0d204a9db0db1e315baec1ec3f527"
+    "cbfd2fd40638dd0f41e51749ee2052f7295bff3163083a6c114375194b7d2254862b5d8f"
+    "3365973c6ea04577a94d7fb15688ba5f91c36799cb70a2d479abdd81b3e58abcee93c5f7"
+    "4e80b25789bb6092c4699bcd72a4d67baddf84b6e88dbff196c8fa9fd103a8da0cb1e315"
+    "baec1ec3f527ccfe30d50739de1042e7194bf02254f92b5d0234660b3d6f1446781d4f81"
+    "26588a2f6193386a9c4173a54a7cae5385b75c8ec06597c96ea0d277a9db80b2e489bbed"
+    "92c4f69bcdffa4d608addf115b8dbf6496c86d9fd177a9db80b2e489bbed93c5f79cce00"
+    "a5d709afe113b8ea1cc1f325cbfd2fd40638dd0f41e7194bf02254f92b5d0335670c3e70"
+    "1547791f5183285a8c3163953b6d9f4476a84d7fb15789bb6092c4699bcd73a5d77caee0"
+    "85b7e98fc1f398cafca1d305abdd0fb4e618bdef21c7f92b689acc71a3d57baddf85b7e9"
+    "8ec0f298cafca2d406abdd0fb5e719bff123c8fa2cd20436dc0e40e51749ef2153f92b5d"
+    "0234660c3e7016487a1f5183295b8d3365973c6ea04678aa5082b4598bbd6395c76d9fd1"
+    "76a8da80b2e48abcee93c5f79dcf01a7d90bb0e214baec1ec4f628cdff31d7093be11345"
+    "75a7d97fb1e389bbed93c5f79dcf01a7d90bb1e315bbed1fc5f729cf0133d90b3de31547"
+    "ed1f51f7295b0133650b3d6f1547791f5183295b8d3365973d6fa14779ab5183b55b8dbf"
+    "6597c96fa1d379abdd83b5e78dbff197c9fba1d305abdd0fb5e719bff123c9fb2dd30537"
+    "dd0f41e7194bf12355fb2d5f82b4e68cbef096c8faa1d305abdd0fb5e719c0f224cafc2e"
+    "d40638df1143e91b4df32557fe3062083a6c1244761d4f8127598b3163953c6ea04678aa"
+    "5082b45b8dbf6597c96fa1d37aacde84b6e88ec0f299cbfda3d507addf11b8ea1cc2f426"
+    "ccfe30d7093be11345eb1d4ff6285a0032640a3c6e1547798fc1f399cbfda4d608afe113"
+    "b9eb1dc4f628cf0133d90b3de41648ef2153f92b5d0436680f4173194b7d2456882f6193"
+    "396b9d4476a84f81b3598bbd6496c86fa1d379abdd84b6e88fc1f399cbfda4d608afe113"
+    "b9eb1dc4f628cf0133d90b3de41648ef2153f92b5d0436680f4173194b7d2456882f6193"
+    "9cce00a7d90bb2e416bdef21c8fa2cd30537de1042e91b4df42658ff31630a3c6e154779"
+    "2052842b5d8f36689a4173a54c7eb05789bb6294c66d9fd178aadc83b5e78ec0f299cbfd"
+    "a4d608afe113baec1ec5f729d00234db0d3fe6184af12355fc2e6007396b1244761d4f81"
+    "285a8c3365973e70a2497bada9db0db4e618bff123cbfd2fd6083ae11345ed1f51f82a5c"
+    "0335670f41731a4c7e2557893163953c6ea04779ab5385b75e90c2699bcd75a7d980b2e4"
+    "8bbdef97c9fba2d406addf11b9eb1dc4f628cf0133db0d3fe6184af12355fd2f61083a6c"
+    "1345771f51832a5c8e3567994173a54c7eb05789bb6395c7b6e81ac1f325cdff31d90b3d"
+    "e41648f02254fc2e6007396b1345771f51832a5c8e36689a4274a64d7fb1598bbd6597c9"
+    "70a2d47caee088baec93c5f79fd103abdd0fb6e81ac2f426ce0032d90b3de51749f12355"
+    "fc2e60083a6c1446781f51832b5d8f37699b4274a64e80b25a8cbe6597c971a3d57dafe1"
+    "c3f527cf0133db0d3fe7194bf32557ff31630b3d6f17497b2355872f61933b6d9f4779ab"
+    "5385b75f91c36b9dcf77a9db83b5e78fc1f39bcdffa7d90bb3e517bff123cbfd2fd7093b"
+    "e31547ef2153fb2d5f07396b1345771f51832b5d8f37699b4375a74f81b35b8dbf6799cb"
+    "73a5d77fb1e38bbdef97c9fbd00234dc0e40e81a4cf527590133650d3f711a4c7e26588a"
+    "3264963f71a34b7daf5789bb6496c870a2d47caee089bbed95c7f9a1d305aee012baec1e"
+    "c6f82ad30537df1143eb1d4ff82a5c0436681042741d4f81295b8d3567994274a64e80b2"
+    "5a8cbe6799cb73a5d77fb1e38cbef098cafca4d608b1e315dd0f41e91b4df6285a033567"
+    "0f41731c4e80295b8d3567994274a64f81b35b8dbf689acc75a7d981b3e58ec0f29bcdff"
+    "a7d90bb4e618c1f325cdff31da0c3ee7194bf325570032640d3f71194b7d26588a336597"
+    "3f71a34c7eb0598bbd6597c972a4d67fb1e38bbdef98cafca5d709b1e315bef022cbfd2f"
+    "ea1c4ef7295b0436681143751e50822b5d8f386a9c4577a95284b65f91c36c9ed079abdd"
+    "86b8ea93c5f7a0d204addf11baec1ec7f92bd40638e11345ee2052fb2d5f083a6c154779"
+    "2254862f61933c6ea0497bad5688ba6395c770a2d47dafe18abcee97c9fba4d608b1e315"
+    "bef022cbfd2fd80a3ce51749f7295b0436681143751f51832c5e90396b9d4779ab5486b8"
+    "6193c56fa1d37caee089bbed97c9fba4d608b1e315bff123ccfe30d90b3de7194bf42658"
+    "0133650f41731c4e80295b8d37699b4476a85183b55f91c36c9ed079abdd87b9eb94c6f8"
+    "a1d305afe113bcee20c9fb2dd7093be41648f12355ff31630436681143751f51832d5f91"
+    "3a6c9e487aac5688ba6395c771a3d57fb1e38cbef09accfea8da0cb5e719c3f527d10335"
+    "de1042ec1e50fa2c5e07396b1547792355873062943e70a24c7eb0598bbd6799cb75a7d9"
+    "82b4e690c2f49ed002abdd0fb9eb1dc7f92bd40638e21446f02254fd2f610b3d6f194b7d"
+    "1143751f51832d5f913b6d9f497bad5789bb6597c973a5d781b3e58fc1f39dcf01abdd0f"
+    "b9eb1dc7f92bd50739e31547f12355ff31630d3f711b4d7f295b8d37699b4577a95385b7"
+    "6193c56fa1d37dafe18bbdef99cbfda7d90bb5e719c3f527d10335df1143ed1f51fb2d5f"
+    "093b6d17497b2557893365971e50822c5e903a6c9e497bad5789bb6597c974a6d882b4e6"
+    "90c2f49fd103addf11bbed1fcafc2ed80a3ce6184af527590335671143752052842e6092"
+    "3c6ea04b7daf598bbd6799cb76a8da84b6e892c4f6a1d305afe113bdef21ccfe30da0c3e"
+    "e81a4cf7295b0537691345772254863062943e70a24d7fb12b5d8f396b9d487aac5789bb"
+    "6597c974a6d883b5e791c3f5a0d204afe113bdef21ccfe30db0d3fe91b4df82a5c07396b"
+    "1547792456883365974173a55082b45f91c36d9fd17caee08bbdef99cbfda8da0cb7e91b"
+    "c5f729d40638e31547f123550032640f41731d4f812c5e903b6d9f497bad588abc6799cb";
+
+const char *planar_rgb8_deflate_data =
+    "49492a00f4010000789c6360270ef0b2b3731083a4d839388841ea1cc401130e0e4e6210"
+    "005d0b065a789c73e4e0e42406f9711207a23939b98841199c5c5cc4a0522ee200007466"
+    "08e4789c6be2e2e22606f57371731383e6701307567273f31083b671f3f01083008bb40b"
+    "6e789c3bcc431cb8c0c3c34b0cbacbc3cb4b0c7ac54b1cf8cecbcb470c0200a31c0df878"
+    "9c63e1e5e3230609f21107e4f8f8f88941da7cfcfcc42000c39f0901789c3362270ed8b3"
+    "b37310837cd839388841911cc481340e0e4e621000d23b0754789c2be6e0e42406357012"
+    "077a3939b98841b338b9b88841cbb9880300e99609de789cdbc2c5c54d0c3ac8c5cd4d0c"
+    "3ac74d1cb8cdcdcd430c7ac1cdc3430c020000f30c68789cfbca431c60e2e1e12506f1f3"
+    "f0f21283647889039abcbc7cc42000883d0af2789c33e3e5e3230639f3110702f8f8f889"
+    "41b17cfcfcc4200011ce09c9789c4b61270e14b2b3731083ead839388841dd1cc481191c"
+    "1c9cc42000477a084e789c5bcac1c9490cdac4491cd8cfc9c9450c3ac3c9c5450cbac945"
+    "1c00005ed50ad8789c7bc6c5c54d0cfaccc5cd4d0c62e0260ef07273f31083a4b8797888"
+    "410086140a62789c53e7210e98f0f0f012831c79787989417ebcc481685e5e3e62100035"
+    "6d0aec789ccbe0e5e3230695f211079af8f8f88941fd7cfcfcc420005fee0a910b000001"
+    "0300010000002800000001010300010000001800000002010300030000007e0200000301"
+    "03000100000008000000060103000100000002000000110104000f000000840200001501"
+    "03000100000003000000160103000100000005000000170104000f000000c00200001c01"
+    "030001000000020000003d01030001000000020000000000000008000800080008000000"
+    "290000004a0000006d0000008f000000ac000000cd000000ee0000001201000033010000"
+    "500100007101000093010000b6010000d701000021000000210000002300000022000000"
+    "1d000000210000002100000024000000210000001d000000210000002200000023000000"
+    "210000001d000000";
+
+const char *planar_rgb8_deflate_image_data =
+    "00070e151c232a31383f464d545b626970777e858c939aa1a8afb6bdc4cbd2d9e0e7eef5"
+    "fc030a110d141b232a313940474f565d656c737b828991989fa7aeb5bdc4cbd3dae1e9f0"
+    "f7ff060d151c232b1a2129313840484f575f666e767d858d949ca4abb3bbc2cad2d9e1e9"
+    "f0f800070f171e262e353d45272f373f474f575f676f777f878f979fa7afb7bfc7cfd7df"
+    "e7eff7ff070f171f272f373f474f575f343c444d555d666e767f878f98a0a8b1b9c1cad2"
+    "dae3ebf3fc040c151d252e363e474f57606870794149525b636c757d868f97a0a9b1bac3"
+    "cbd4dde5eef7ff081119222b333c454d565f677079818a934e576069727b848d969fa8b1"
+    "bac3ccd5dee7f0f9020b141d262f38414a535c656e778089929ba4ad5b646d778089939c"
+    "a5afb8c1cbd4dde7f0f9030c151f28313b444d576069737c858f98a1abb4bdc768717b85"
+    "8e98a2abb5bfc8d2dce5eff9020c161f29333c465059636d76808a939da7b0bac4cdd7e1"
+    "757f89939da7b1bbc5cfd9e3edf7010b151f29333d47515b656f79838d97a1abb5bfc9d3"
+    "dde7f1fb828c96a1abb5c0cad4dfe9f3fe08121d27313c46505b656f7a848e99a3adb8c2"
+    "ccd7e1ebf6000a158f99a4afb9c4cfd9e4eff9040f19242f39444f59646f79848f99a4af"
+    "b9c4cfd9e4eff9040f19242f9ca7b2bdc8d3dee9f4ff0a15202b36414c57626d78838e99"
+    "a4afbac5d0dbe6f1fc07121d28333e49a9b4bfcbd6e1edf8030f1a25313c47535e697580"
+    "8b97a2adb9c4cfdbe6f1fd08131f2a35414c5763b6c1cdd9e4f0fc07131f2a36424d5965"
+    "707c88939fabb6c2ced9e5f1fc08141f2b37424e5a65717dc3cfdbe7f3ff0b17232f3b47"
+    "535f6b77838f9ba7b3bfcbd7e3effb07131f2b37434f5b67737f8b97d0dce8f5010d1a26"
+    "323f4b5764707c8995a1aebac6d3dfebf804101d2935424e5a67737f8c98a4b1dde9f603"
+    "0f1c2935424f5b6875818e9ba7b4c1cddae7f3000d1926333f4c5965727f8b98a5b1becb"
+    "eaf704111e2b3845525f6c798693a0adbac7d4e1eefb0815222f3c495663707d8a97a4b1"
+    "becbd8e5f704111f2c394754616f7c8997a4b1bfccd9e7f4010f1c293744515f6c798794"
+    "a1afbcc9d7e4f1ff04111f2d3a485663717f8c9aa8b5c3d1deecfa071523303e4c596775"
+    "82909eabb9c7d4e2f0fd0b19111f2d3b49576573818f9dabb9c7d5e3f1ff0d1b29374553"
+    "616f7d8b99a7b5c3d1dfedfb091725331e2c3a4957657482909fadbbcad8e6f50311202e"
+    "3c4b5967768492a1afbdccdae8f7051322303e4d2b39485765748391a0afbdccdbe9f807"
+    "15243341505f6d7c8b99a8b7c5d4e3f1000f1d2c3b495867323940474e555c636a71787f"
+    "868d949ba2a9b0b7bec5ccd3dae1e8eff6fd040b121920272e353c433f464d555c636b72"
+    "7981888f979ea5adb4bbc3cad1d9e0e7eff6fd050c131b222931383f474e555d4c535b63"
+    "6a727a81899198a0a8afb7bfc6ced6dde5edf4fc040b131b222a32394149505860676f77"
+    "596169717981899199a1a9b1b9c1c9d1d9e1e9f1f9010911192129313941495159616971"
+    "79818991666e767f878f98a0a8b1b9c1cad2dae3ebf3fc040c151d252e363e474f576068"
+    "70798189929aa2ab737b848d959ea7afb8c1c9d2dbe3ecf5fd060f172029313a434b545d"
+    "656e777f889199a2abb3bcc58089929ba4adb6bfc8d1dae3ecf5fe071019222b343d464f"
+    "58616a737c858e97a0a9b2bbc4cdd6df8d969fa9b2bbc5ced7e1eaf3fd060f19222b353e"
+    "47515a636d767f89929ba5aeb7c1cad3dde6eff99aa3adb7c0cad4dde7f1fa040e17212b"
+    "343e48515b656e78828b959fa8b2bcc5cfd9e2ecf6ff0913a7b1bbc5cfd9e3edf7010b15"
+    "1f29333d47515b656f79838d97a1abb5bfc9d3dde7f1fb050f19232db4bec8d3dde7f2fc"
+    "06111b25303a444f59636e78828d97a1acb6c0cbd5dfeaf4fe09131d28323c47c1cbd6e1"
+    "ebf6010b16212b36414b56616b76818b96a1abb6c1cbd6e1ebf6010b16212b36414b5661"
+    "ced9e4effa05101b26313c47525d68737e89949faab5c0cbd6e1ecf7020d18232e39444f"
+    "5a65707bdbe6f1fd08131f2a35414c57636e7985909ba7b2bdc9d4dfebf6010d18232f3a"
+    "45515c67737e8995e8f3ff0b16222e3945515c68747f8b97a2aebac5d1dde8f4000b1723"
+    "2e3a46515d6974808c97a3aff5010d1925313d4955616d7985919da9b5c1cdd9e5f1fd09"
+    "15212d3945515d6975818d99a5b1bdc9020e1a27333f4c5864717d8996a2aebbc7d3e0ec"
+    "f805111d2a36424f5b6774808c99a5b1becad6e30f1b2835414e5b6774818d9aa7b3c0cd"
+    "d9e6f3ff0c1925323f4b5865717e8b97a4b1bdcad7e3f0fd1c293643505d6a7784919eab"
+    "b8c5d2dfecf90613202d3a4754616e7b8895a2afbcc9d6e3f0fd0a17293643515e6b7986"
+    "93a1aebbc9d6e3f1fe0b192633414e5b697683919eabb9c6d3e1eefb091623313643515f"
+    "6c7a8895a3b1beccdae7f503101e2c39475562707e8b99a7b4c2d0ddebf90614222f3d4b"
+    "43515f6d7b8997a5b3c1cfddebf9071523313f4d5b69778593a1afbdcbd9e7f503111f2d"
+    "3b495765505e6c7b8997a6b4c2d1dfedfc0a1827354352606e7d8b99a8b6c4d3e1effe0c"
+    "1a2937455462707f5d6b7a8997a6b5c3d2e1effe0d1b2a394756657382919faebdcbdae9"
+    "f706152332414f5e6d7b8a99646b727980878e959ca3aab1b8bfc6cdd4dbe2e9f0f7fe05"
+    "0c131a21282f363d444b525960676e7571787f878e959da4abb3bac1c9d0d7dfe6edf5fc"
+    "030b121921282f373e454d545b636a717980878f7e858d959ca4acb3bbc3cad2dae1e9f1"
+    "f800080f171f262e363d454d545c646b737b828a9299a1a98b939ba3abb3bbc3cbd3dbe3"
+    "ebf3fb030b131b232b333b434b535b636b737b838b939ba3abb3bbc398a0a8b1b9c1cad2"
+    "dae3ebf3fc040c151d252e363e474f57606870798189929aa2abb3bbc4ccd4dda5adb6bf"
+    "c7d0d9e1eaf3fb040d151e272f384149525b636c757d868f97a0a9b1bac3cbd4dde5eef7"
+    "b2bbc4cdd6dfe8f1fa030c151e273039424b545d666f78818a939ca5aeb7c0c9d2dbe4ed"
+    "f6ff0811bfc8d1dbe4edf70009131c252f38414b545d677079838c959fa8b1bbc4cdd7e0"
+    "e9f3fc050f18212bccd5dfe9f2fc060f19232c364049535d66707a838d97a0aab4bdc7d1"
+    "dae4eef7010b141e28313b45d9e3edf7010b151f29333d47515b656f79838d97a1abb5bf"
+    "c9d3dde7f1fb050f19232d37414b555fe6f0fa050f19242e38434d57626c76818b95a0aa"
+    "b4bfc9d3dee8f2fd07111c26303b454f5a646e79f3fd08131d28333d48535d68737d8893"
+    "9da8b3bdc8d3dde8f3fd08131d28333d48535d68737d8893000b16212c37424d58636e79"
+    "848f9aa5b0bbc6d1dce7f2fd08131e29343f4a55606b76818c97a2ad0d18232f3a45515c"
+    "67737e8995a0abb7c2cdd9e4effb06111d28333f4a55616c77838e99a5b0bbc71a25313d"
+    "4854606b77838e9aa6b1bdc9d4e0ecf7030f1a26323d4955606c78838f9ba6b2bec9d5e1"
+    "27333f4b57636f7b87939fabb7c3cfdbe7f3ff0b17232f3b47535f6b77838f9ba7b3bfcb"
+    "d7e3effb34404c5965717e8a96a3afbbc8d4e0edf905121e2a37434f5c6874818d99a6b2"
+    "becbd7e3f0fc0815414d5a6773808d99a6b3bfccd9e5f2ff0b1825313e4b5764717d8a97"
+    "a3b0bdc9d6e3effc0915222f4e5b6875828f9ca9b6c3d0ddeaf704111e2b3845525f6c79"
+    "8693a0adbac7d4e1eefb0815222f3c495b687583909dabb8c5d3e0edfb081523303d4b58"
+    "6573808d9ba8b5c3d0ddebf80513202d3b485563687583919eacbac7d5e3f0fe0c192735"
+    "42505e6b798794a2b0bdcbd9e6f4020f1d2b384654616f7d7583919fadbbc9d7e5f3010f"
+    "1d2b39475563717f8d9ba9b7c5d3e1effd0b19273543515f6d7b899782909eadbbc9d8e6"
+    "f403111f2e3c4a5967758492a0afbdcbdae8f6051321303e4c5b69778694a2b18f9dacbb"
+    "c9d8e7f5041321303f4d5c6b798897a5b4c3d1e0effd0c1b29384755647381909fadbccb";
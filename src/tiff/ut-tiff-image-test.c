@@ -25,6 +25,218 @@ check_tiff(const char *hex_data, uint32_t width, uint32_t length,
                                     hex_color_map_data);
   }
   ut_assert_uint8_list_equal_hex(ut_tiff_image_get_data(image), hex_image_data);
+
+  // Decoding strips/tiles in parallel gives the same result.
+  UtObjectRef threaded_image =
+      ut_tiff_image_new_from_data_with_n_threads(data, 4);
+  ut_assert_is_not_error(threaded_image);
+  ut_assert_uint8_list_equal_hex(ut_tiff_image_get_data(threaded_image),
+                                 hex_image_data);
+}
+
+// Check reading a [width]x[length] region at [x], [y] from a lazily decoded
+// image matches the region read from the fully decoded image.
+static void check_region(UtObject *image, UtObject *lazy_image, uint32_t x,
+                         uint32_t y, uint32_t width, uint32_t length) {
+  UtObjectRef region = ut_tiff_image_read_region(image, x, y, width, length);
+  ut_assert_is_not_error(region);
+  UtObjectRef lazy_region =
+      ut_tiff_image_read_region(lazy_image, x, y, width, length);
+  ut_assert_is_not_error(lazy_region);
+  ut_assert_equal(lazy_region, region);
+}
+
+// Check regions of the TIFF image in [hex_data] can be read without decoding
+// the whole image.
+static void check_tiff_regions(const char *hex_data) {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(hex_data);
+  UtObjectRef image = ut_tiff_image_new_from_data(data);
+  ut_assert_is_not_error(image);
+  UtObjectRef lazy_image = ut_tiff_image_new_from_data_lazy(data);
+  ut_assert_is_not_error(lazy_image);
+
+  uint32_t width = ut_tiff_image_get_width(image);
+  uint32_t length = ut_tiff_image_get_length(image);
+  check_region(image, lazy_image, 0, 0, width, length);
+  check_region(image, lazy_image, 0, 0, 1, 1);
+  check_region(image, lazy_image, width - 1, length - 1, 1, 1);
+  check_region(image, lazy_image, 3, 5, width / 2, length / 3);
+  check_region(image, lazy_image, width / 2, 1, width / 2 - 1, length - 2);
+
+  // Accessing the data decodes the whole image.
+  ut_assert_equal(ut_tiff_image_get_data(lazy_image),
+                  ut_tiff_image_get_data(image));
+}
+
+// Check a region matches the pixels in the image data.
+static void test_region() {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(tiled_rgb8_deflate_data);
+  UtObjectRef image = ut_tiff_image_new_from_data_lazy(data);
+  ut_assert_is_not_error(image);
+  UtObjectRef region = ut_tiff_image_read_region(image, 10, 12, 20, 8);
+  ut_assert_is_not_error(region);
+  ut_assert_int_equal(ut_list_get_length(region), 20 * 8 * 3);
+
+  const uint8_t *image_data =
+      ut_uint8_list_get_data(ut_tiff_image_get_data(image));
+  const uint8_t *region_data = ut_uint8_list_get_data(region);
+  for (size_t y = 0; y < 8; y++) {
+    for (size_t i = 0; i < 20 * 3; i++) {
+      ut_assert_int_equal(region_data[y * 20 * 3 + i],
+                          image_data[(12 + y) * 40 * 3 + 10 * 3 + i]);
+    }
+  }
+}
+
+// Check errors decoding strips/tiles of lazily decoded images are reported.
+static void test_lazy_error() {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(tiled_rgb8_deflate_data);
+
+  // Corrupt the zlib header of the second tile.
+  uint8_t *d = ut_uint8_list_get_writable_data(data);
+  size_t data_length = ut_list_get_length(data);
+  size_t n_headers = 0;
+  for (size_t i = 8; i + 1 < data_length; i++) {
+    if (d[i] == 0x78 && d[i + 1] == 0x9c) {
+      n_headers++;
+      if (n_headers == 2) {
+        d[i] = 0x00;
+        break;
+      }
+    }
+  }
+  ut_assert_int_equal(n_headers, 2);
+
+  UtObjectRef image = ut_tiff_image_new_from_data_lazy(data);
+  ut_assert_is_not_error(image);
+
+  // The first tile can still be read.
+  UtObjectRef region = ut_tiff_image_read_region(image, 0, 0, 1, 1);
+  ut_assert_is_not_error(region);
+
+  uint32_t width = ut_tiff_image_get_width(image);
+  uint32_t length = ut_tiff_image_get_length(image);
+  UtObjectRef full_region =
+      ut_tiff_image_read_region(image, 0, 0, width, length);
+  ut_assert_is_error(full_region);
+
+  ut_assert_null_object(ut_tiff_image_get_error(image));
+  ut_assert_null_object(ut_tiff_image_get_data(image));
+  ut_assert_is_error(ut_tiff_image_get_error(image));
+  ut_assert_null_object(ut_tiff_image_to_rgba(image));
+
+  // Once decoding has failed, regions report the error.
+  UtObjectRef later_region = ut_tiff_image_read_region(image, 0, 0, 1, 1);
+  ut_assert_is_error(later_region);
+}
+
+// Returns the IFD entry for [tag] in little endian TIFF [data].
+static uint8_t *find_entry(UtObject *data, uint16_t tag) {
+  uint8_t *d = ut_uint8_list_get_writable_data(data);
+  uint32_t offset = d[4] | d[5] << 8 | d[6] << 16 | d[7] << 24;
+  size_t n_entries = d[offset] | d[offset + 1] << 8;
+  for (size_t i = 0; i < n_entries; i++) {
+    uint8_t *entry = d + offset + 2 + i * 12;
+    if ((entry[0] | entry[1] << 8) == tag) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void test_rows_per_strip() {
+  // Zero rows per strip is invalid.
+  UtObjectRef zero_data = ut_uint8_list_new_from_hex_string(bilevel_data);
+  uint8_t *zero_entry = find_entry(zero_data, UT_TIFF_TAG_ROWS_PER_STRIP);
+  ut_assert_true(zero_entry != NULL);
+  zero_entry[8] = zero_entry[9] = 0;
+  UtObjectRef zero_image = ut_tiff_image_new_from_data(zero_data);
+  ut_assert_is_error(zero_image);
+  UtObjectRef zero_lazy_image = ut_tiff_image_new_from_data_lazy(zero_data);
+  ut_assert_is_error(zero_lazy_image);
+
+  // More rows than the image is a single strip.
+  UtObjectRef large_data = ut_uint8_list_new_from_hex_string(bilevel_data);
+  uint8_t *large_entry = find_entry(large_data, UT_TIFF_TAG_ROWS_PER_STRIP);
+  large_entry[8] = large_entry[9] = 0xff;
+  UtObjectRef large_image = ut_tiff_image_new_from_data(large_data);
+  ut_assert_is_not_error(large_image);
+  ut_assert_uint8_list_equal_hex(ut_tiff_image_get_data(large_image),
+                                 bilevel_image_data);
+
+  // As is a missing rows per strip tag.
+  UtObjectRef missing_data = ut_uint8_list_new_from_hex_string(bilevel_data);
+  uint8_t *missing_entry =
+      find_entry(missing_data, UT_TIFF_TAG_ROWS_PER_STRIP);
+  missing_entry[0] = 0x00;
+  missing_entry[1] = 0xc0;
+  UtObjectRef missing_image = ut_tiff_image_new_from_data(missing_data);
+  ut_assert_is_not_error(missing_image);
+  ut_assert_uint8_list_equal_hex(ut_tiff_image_get_data(missing_image),
+                                 bilevel_image_data);
+}
+
+static void test_to_rgba() {
+  UtObjectRef grey_data = ut_uint8_list_new_from_hex_string("0080");
+  UtObjectRef grey_image = ut_tiff_image_new(
+      2, 1, UT_TIFF_PHOTOMETRIC_INTERPRETATION_BLACK_IS_ZERO,
+      UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 8, 1, grey_data);
+  UtObjectRef grey_rgba = ut_tiff_image_to_rgba(grey_image);
+  ut_assert_uint8_list_equal_hex(grey_rgba, "000000ff808080ff");
+
+  UtObjectRef rgb_data = ut_uint8_list_new_from_hex_string("ff000000ff00");
+  UtObjectRef rgb_image =
+      ut_tiff_image_new(2, 1, UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB,
+                        UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 8, 3, rgb_data);
+  UtObjectRef rgb_rgba = ut_tiff_image_to_rgba(rgb_image);
+  ut_assert_uint8_list_equal_hex(rgb_rgba, "ff0000ff00ff00ff");
+
+  UtObjectRef palette_data = ut_uint8_list_new_from_hex_string("40");
+  UtObjectRef palette_image = ut_tiff_image_new(
+      2, 1, UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB_PALETTE,
+      UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 1, 1, palette_data);
+  UtObjectRef color_map =
+      ut_uint16_list_new_from_elements(6, 0xffff, 0x0000, 0x0000, 0x8080,
+                                       0x0000, 0x0000);
+  ut_tiff_image_set_color_map(palette_image, color_map);
+  UtObjectRef palette_rgba = ut_tiff_image_to_rgba(palette_image);
+  ut_assert_uint8_list_equal_hex(palette_rgba, "ff0000ff008000ff");
+
+  UtObjectRef invert_data = ut_uint8_list_new_from_hex_string("00ff");
+  UtObjectRef invert_image = ut_tiff_image_new(
+      2, 1, UT_TIFF_PHOTOMETRIC_INTERPRETATION_WHITE_IS_ZERO,
+      UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 8, 1, invert_data);
+  UtObjectRef invert_rgba = ut_tiff_image_to_rgba(invert_image);
+  ut_assert_uint8_list_equal_hex(invert_rgba, "ffffffff000000ff");
+
+  UtObjectRef bilevel_invert_data = ut_uint8_list_new_from_hex_string("40");
+  UtObjectRef bilevel_invert_image = ut_tiff_image_new(
+      2, 1, UT_TIFF_PHOTOMETRIC_INTERPRETATION_WHITE_IS_ZERO,
+      UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 1, 1, bilevel_invert_data);
+  UtObjectRef bilevel_invert_rgba = ut_tiff_image_to_rgba(bilevel_invert_image);
+  ut_assert_uint8_list_equal_hex(bilevel_invert_rgba, "ffffffff000000ff");
+
+  UtObjectRef grey16_data = ut_uint8_list_new_from_hex_string("0000ffff");
+  UtObjectRef grey16_image = ut_tiff_image_new(
+      2, 1, UT_TIFF_PHOTOMETRIC_INTERPRETATION_BLACK_IS_ZERO,
+      UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 16, 1, grey16_data);
+  UtObjectRef grey16_rgba = ut_tiff_image_to_rgba(grey16_image);
+  ut_assert_uint8_list_equal_hex(grey16_rgba, "000000ffffffffff");
+
+  UtObjectRef rgba16_data =
+      ut_uint8_list_new_from_hex_string("ffff00000000ffff");
+  UtObjectRef rgba16_image = ut_tiff_image_new(
+      1, 1, UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB,
+      UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 16, 4, rgba16_data);
+  UtObjectRef rgba16_rgba = ut_tiff_image_to_rgba(rgba16_image);
+  ut_assert_uint8_list_equal_hex(rgba16_rgba, "ff0000ff");
+
+  // Planar images aren't supported.
+  UtObjectRef planar_data = ut_uint8_list_new_from_hex_string("ff0000");
+  UtObjectRef planar_image =
+      ut_tiff_image_new(1, 1, UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB,
+                        UT_TIFF_PLANAR_CONFIGURATION_PLANAR, 8, 3, planar_data);
+  ut_assert_null_object(ut_tiff_image_to_rgba(planar_image));
 }
 
 int main(int argc, char **argv) {
@@ -71,7 +283,17 @@ int main(int argc, char **argv) {
              NULL, rgb_lzw_image_data);
   check_tiff(rgb_deflate_data, 32, 32, UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB,
              8, 3, NULL, rgb_deflate_image_data);
-  // FIXME: deflate without predictor, rgb planar
+  // FIXME: deflate without predictor
+  check_tiff(planar_rgb8_deflate_data, 40, 24,
+             UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB, 8, 3, NULL,
+             planar_rgb8_deflate_image_data);
+
+  check_tiff(tiled_grayscale8_data, 40, 24,
+             UT_TIFF_PHOTOMETRIC_INTERPRETATION_BLACK_IS_ZERO, 8, 1, NULL,
+             tiled_grayscale8_image_data);
+  check_tiff(tiled_rgb8_deflate_data, 40, 24,
+             UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB, 8, 3, NULL,
+             tiled_rgb8_deflate_image_data);
 
   check_tiff(palette4_data, 32, 32,
              UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB_PALETTE, 4, 1,
@@ -80,5 +302,17 @@ int main(int argc, char **argv) {
              UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB_PALETTE, 8, 1,
              palette8_color_map_data, palette8_image_data);
 
+  check_tiff_regions(bilevel_data);
+  check_tiff_regions(grayscale4_data);
+  check_tiff_regions(grayscale8_lzw_data);
+  check_tiff_regions(rgb_deflate_data);
+  check_tiff_regions(planar_rgb8_deflate_data);
+  check_tiff_regions(tiled_grayscale8_data);
+  check_tiff_regions(tiled_rgb8_deflate_data);
+  test_region();
+  test_lazy_error();
+  test_rows_per_strip();
+  test_to_rgba();
+
   return 0;
 }
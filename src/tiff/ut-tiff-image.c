@@ -1,8 +1,60 @@
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "ut-parallel-private.h"
 #include "ut.h"
 
+// Layout of the strips or tiles that make up an image.
+typedef struct {
+  UtTiffCompression compression;
+  UtTiffPredictor predictor;
+  size_t bits_per_sample;
+
+  // Number of samples in each pixel of a strip/tile.
+  size_t n_samples;
+
+  // Size of the image.
+  size_t image_width;
+  size_t image_length;
+  size_t image_row_stride;
+  size_t plane_size;
+
+  // Size of each strip/tile.
+  size_t block_width;
+  size_t block_length;
+  size_t block_row_stride;
+
+  // Number of strips/tiles across and down each plane.
+  size_t blocks_across;
+  size_t blocks_down;
+
+  // Compressed data for each strip/tile.
+  const uint8_t *data;
+  const uint32_t *offsets;
+  const uint32_t *byte_counts;
+
+  // Decoded image.
+  uint8_t *image_data;
+} BlockLayout;
+
+// Decoded strip/tile kept for reading regions.
+typedef struct {
+  // Index of the strip/tile in this entry.
+  size_t index;
+  bool valid;
+
+  // Decoded data.
+  uint8_t *data;
+
+  // Value of the cache clock when this entry was last used.
+  uint64_t last_used;
+} CachedBlock;
+
+// Maximum number of decoded strips/tiles to keep when reading regions.
+#define BLOCK_CACHE_SIZE 64
+
 typedef struct {
   UtObject object;
   uint32_t width;
@@ -13,6 +65,20 @@ typedef struct {
   uint16_t samples_per_pixel;
   UtObject *color_map;
   UtObject *data;
+
+  // Encoded strips/tiles to decode when data is accessed.
+  UtObject *source_data;
+  UtObject *offsets;
+  UtObject *byte_counts;
+  BlockLayout layout;
+  size_t n_blocks;
+
+  // Recently decoded strips/tiles.
+  CachedBlock *block_cache;
+  uint64_t block_cache_clock;
+
+  // Error from decoding the strips/tiles.
+  UtObject *error;
 } UtTiffImage;
 
 static size_t get_row_stride(uint32_t width, size_t bits_per_sample,
@@ -67,11 +133,13 @@ static bool get_short_or_long_tag(UtObject *reader, uint16_t id,
   }
 }
 
-static bool decode_pack_bits(UtObject *input, UtObject *output) {
-  size_t input_length = ut_list_get_length(input);
-
+// Decode PackBits data in [input] into [output], stopping if [output] is
+// full.
+static bool decode_pack_bits(const uint8_t *input, size_t input_length,
+                             uint8_t *output, size_t output_length) {
+  size_t output_offset = 0;
   for (size_t i = 0; i < input_length; i++) {
-    int8_t b = (int8_t)ut_uint8_list_get_element(input, i);
+    int8_t b = (int8_t)input[i];
     size_t count, repeat_count;
     if (b >= 0) {
       count = b + 1;
@@ -89,9 +157,11 @@ static bool decode_pack_bits(UtObject *input, UtObject *output) {
     }
     for (size_t j = 0; j < count; j++) {
       i++;
-      uint8_t value = ut_uint8_list_get_element(input, i);
-      for (size_t k = 0; k < repeat_count; k++) {
-        ut_uint8_list_append(output, value);
+      uint8_t value = input[i];
+      for (size_t k = 0; k < repeat_count && output_offset < output_length;
+           k++) {
+        output[output_offset] = value;
+        output_offset++;
       }
     }
   }
@@ -99,72 +169,327 @@ static bool decode_pack_bits(UtObject *input, UtObject *output) {
   return true;
 }
 
-static bool decode_lzw(UtObject *input, UtObject *output) {
-  UtObjectRef input_stream = ut_list_input_stream_new(input);
-  UtObjectRef lzw_decoder = ut_lzw_decoder_new_msb(256, 4096, input_stream);
-  UtObjectRef decoded_data = ut_input_stream_read_sync(lzw_decoder);
+// Decode all the data from [decoder] into [output], stopping if [output] is
+// full.
+static bool decode_stream(UtObject *decoder, uint8_t *output,
+                          size_t output_length) {
+  UtObjectRef decoded_data = ut_input_stream_read_sync(decoder);
   if (ut_object_implements_error(decoded_data)) {
     return false;
   }
 
-  ut_list_append_list(output, decoded_data);
+  size_t decoded_data_length = ut_list_get_length(decoded_data);
+  const uint8_t *d = ut_uint8_list_get_data(decoded_data);
+  UtObjectRef decoded_array = NULL;
+  if (d == NULL) {
+    decoded_array = ut_uint8_list_get_array(decoded_data);
+    d = ut_uint8_list_get_data(decoded_array);
+  }
+  memcpy(output, d,
+         decoded_data_length < output_length ? decoded_data_length
+                                             : output_length);
 
   return true;
 }
 
-static bool decode_deflate(UtObject *input, UtObject *output) {
-  UtObjectRef input_stream = ut_list_input_stream_new(input);
+static bool decode_lzw(const uint8_t *input, size_t input_length,
+                       uint8_t *output, size_t output_length) {
+  UtObjectRef input_data = ut_uint8_array_new_from_data(input, input_length);
+  UtObjectRef input_stream = ut_list_input_stream_new(input_data);
+  UtObjectRef lzw_decoder = ut_lzw_decoder_new_msb(256, 4096, input_stream);
+  return decode_stream(lzw_decoder, output, output_length);
+}
+
+static bool decode_deflate(const uint8_t *input, size_t input_length,
+                           uint8_t *output, size_t output_length) {
+  UtObjectRef input_data = ut_uint8_array_new_from_data(input, input_length);
+  UtObjectRef input_stream = ut_list_input_stream_new(input_data);
   UtObjectRef zlib_decoder = ut_zlib_decoder_new(input_stream);
-  UtObjectRef decoded_data = ut_input_stream_read_sync(zlib_decoder);
-  if (ut_object_implements_error(decoded_data)) {
+  return decode_stream(zlib_decoder, output, output_length);
+}
+
+// Undo horizontal differencing on [n_rows] rows of [width] pixels with
+// [n_samples] samples in each pixel.
+static bool decode_horizontal_differencing(uint8_t *data, size_t row_stride,
+                                           size_t width, size_t n_rows,
+                                           size_t bits_per_sample,
+                                           size_t n_samples) {
+  // FIXME: Support other bit depths.
+  if (bits_per_sample != 8) {
     return false;
   }
 
-  ut_list_append_list(output, decoded_data);
+  for (size_t y = 0; y < n_rows; y++) {
+    uint8_t *row = data + y * row_stride;
+    for (size_t i = n_samples; i < width * n_samples; i++) {
+      row[i] += row[i - n_samples];
+    }
+  }
 
   return true;
 }
 
-static bool decode_horizontal_differencing(
-    size_t width, size_t length, UtTiffPlanarConfiguration planar_configuration,
-    size_t bits_per_sample, size_t samples_per_pixel, UtObject *image_data) {
-  // FIXME: Support other bit depths.
-  if (bits_per_sample != 8) {
-    return false;
+// Work done on a thread when decoding strips/tiles in parallel.
+typedef struct {
+  const BlockLayout *layout;
+
+  // Strips/tiles to decode.
+  size_t block_start;
+  size_t block_end;
+
+  // Error that occurred during decoding or NULL.
+  const char *error;
+} DecodeWorker;
+
+// Decode the compressed strip/tile data in [input] into [output].
+static const char *decode_block_data(const BlockLayout *layout,
+                                     const uint8_t *input, size_t input_length,
+                                     uint8_t *output, size_t output_length) {
+  switch (layout->compression) {
+  case UT_TIFF_COMPRESSION_UNCOMPRESSED:
+    memcpy(output, input,
+           input_length < output_length ? input_length : output_length);
+    return NULL;
+  case UT_TIFF_COMPRESSION_PACK_BITS:
+    return decode_pack_bits(input, input_length, output, output_length)
+               ? NULL
+               : "Invalid TIFF PackBits data";
+  case UT_TIFF_COMPRESSION_LZW:
+    return decode_lzw(input, input_length, output, output_length)
+               ? NULL
+               : "Invalid TIFF LZW data";
+  case UT_TIFF_COMPRESSION_DEFLATE:
+    return decode_deflate(input, input_length, output, output_length)
+               ? NULL
+               : "Invalid TIFF Deflate data";
+  default:
+    assert(false);
+    return NULL;
   }
+}
 
-  uint8_t *d = ut_uint8_list_get_writable_data(image_data);
-  if (planar_configuration == UT_TIFF_PLANAR_CONFIGURATION_CHUNKY) {
-    size_t offset = 0;
-    for (size_t y = 0; y < length; y++) {
-      offset += samples_per_pixel;
-      for (size_t x = 1; x < width; x++) {
-        for (size_t s = 0; s < samples_per_pixel; s++) {
-          d[offset + s] += d[offset + s - samples_per_pixel];
-        }
-        offset += samples_per_pixel;
-      }
+// Returns the number of rows in strip/tile [index].
+static size_t get_block_n_rows(const BlockLayout *layout, size_t index) {
+  size_t blocks_per_plane = layout->blocks_across * layout->blocks_down;
+  size_t y = index % blocks_per_plane / layout->blocks_across *
+             layout->block_length;
+  return layout->image_length - y < layout->block_length
+             ? layout->image_length - y
+             : layout->block_length;
+}
+
+// Decode strip/tile [index] into [output].
+static const char *decode_block(const BlockLayout *layout, size_t index,
+                                uint8_t *output) {
+  size_t n_rows = get_block_n_rows(layout, index);
+  const char *error = decode_block_data(
+      layout, layout->data + layout->offsets[index],
+      layout->byte_counts[index], output, n_rows * layout->block_row_stride);
+  if (error != NULL) {
+    return error;
+  }
+
+  if (layout->predictor == UT_TIFF_PREDICTOR_HORIZONTAL_DIFFERENCING) {
+    decode_horizontal_differencing(output, layout->block_row_stride,
+                                   layout->block_width, n_rows,
+                                   layout->bits_per_sample, layout->n_samples);
+  }
+
+  return NULL;
+}
+
+static void decode_blocks_cb(void *data) {
+  DecodeWorker *worker = data;
+  const BlockLayout *layout = worker->layout;
+
+  // Strips cover whole rows so can be decoded straight into the image. Tiles
+  // are decoded into a buffer then copied into place.
+  bool is_strip = layout->block_width == layout->image_width;
+  uint8_t *buffer = NULL;
+  size_t buffer_length = layout->block_length * layout->block_row_stride;
+  if (!is_strip) {
+    buffer = malloc(buffer_length);
+  }
+
+  size_t blocks_per_plane = layout->blocks_across * layout->blocks_down;
+  for (size_t i = worker->block_start; i < worker->block_end; i++) {
+    size_t plane = i / blocks_per_plane;
+    size_t block_x = i % blocks_per_plane % layout->blocks_across;
+    size_t block_y = i % blocks_per_plane / layout->blocks_across;
+    size_t n_rows = get_block_n_rows(layout, i);
+    uint8_t *image_block_data =
+        layout->image_data + plane * layout->plane_size +
+        block_y * layout->block_length * layout->image_row_stride;
+
+    if (is_strip) {
+      worker->error = decode_block(layout, i, image_block_data);
+    } else {
+      memset(buffer, 0, buffer_length);
+      worker->error = decode_block(layout, i, buffer);
     }
-  } else if (planar_configuration == UT_TIFF_PLANAR_CONFIGURATION_PLANAR) {
-    size_t offset = 0;
-    for (size_t s = 0; s < samples_per_pixel; s++) {
-      for (size_t y = 0; y < length; y++) {
-        offset++;
-        for (size_t x = 1; x < width; x++) {
-          d[offset] += d[offset - 1];
-          offset++;
-        }
+    if (worker->error != NULL) {
+      break;
+    }
+
+    if (!is_strip) {
+      size_t x_offset = block_x * layout->block_row_stride;
+      size_t row_length = layout->image_row_stride - x_offset;
+      if (row_length > layout->block_row_stride) {
+        row_length = layout->block_row_stride;
+      }
+      for (size_t row = 0; row < n_rows; row++) {
+        memcpy(image_block_data + row * layout->image_row_stride + x_offset,
+               buffer + row * layout->block_row_stride, row_length);
       }
     }
   }
 
+  free(buffer);
+}
+
+// Decode the strips/tiles in [layout], using [n_threads] threads.
+static const char *decode_blocks(const BlockLayout *layout, size_t n_blocks,
+                                 size_t n_threads) {
+  size_t n_workers = _ut_parallel_get_n_workers(n_threads, n_blocks);
+  DecodeWorker *workers = calloc(n_workers, sizeof(DecodeWorker));
+  for (size_t i = 0; i < n_workers; i++) {
+    workers[i].layout = layout;
+    workers[i].block_start = i * n_blocks / n_workers;
+    workers[i].block_end = (i + 1) * n_blocks / n_workers;
+  }
+
+  _ut_parallel_run(workers, sizeof(DecodeWorker), n_workers,
+                   decode_blocks_cb);
+  const char *error = NULL;
+  for (size_t i = 0; i < n_workers && error == NULL; i++) {
+    error = workers[i].error;
+  }
+  free(workers);
+
+  return error;
+}
+
+// Returns true if [tag] exists and contains short or long values.
+static bool is_short_or_long_tag(UtObject *tag) {
+  if (tag == NULL) {
+    return false;
+  }
+  uint16_t type = ut_tiff_tag_get_type(tag);
+  return type == UT_TIFF_TAG_TYPE_SHORT || type == UT_TIFF_TAG_TYPE_LONG;
+}
+
+// Get the offsets and byte counts of each strip/tile from [offsets_tag] and
+// [byte_counts_tag].
+static bool get_block_offsets(UtObject *offsets_tag, UtObject *byte_counts_tag,
+                              size_t n_blocks, size_t data_length,
+                              UtObject **offsets, UtObject **byte_counts) {
+  if (!is_short_or_long_tag(offsets_tag) ||
+      !is_short_or_long_tag(byte_counts_tag) ||
+      ut_tiff_tag_get_count(offsets_tag) < n_blocks ||
+      ut_tiff_tag_get_count(byte_counts_tag) < n_blocks) {
+    return false;
+  }
+
+  *offsets = ut_uint32_array_new_sized(n_blocks);
+  *byte_counts = ut_uint32_array_new_sized(n_blocks);
+  uint32_t *offsets_data = ut_uint32_list_get_writable_data(*offsets);
+  uint32_t *byte_counts_data = ut_uint32_list_get_writable_data(*byte_counts);
+  for (size_t i = 0; i < n_blocks; i++) {
+    offsets_data[i] = ut_tiff_tag_get_short_or_long(offsets_tag, i);
+    byte_counts_data[i] = ut_tiff_tag_get_short_or_long(byte_counts_tag, i);
+    if ((size_t)offsets_data[i] + byte_counts_data[i] > data_length) {
+      return false;
+    }
+  }
+
   return true;
 }
 
+// Copy [n_bits] from [src] starting at bit [src_bit] to [dst] starting at bit
+// [dst_bit]. Bits are ordered most significant first.
+static void copy_bits(uint8_t *dst, size_t dst_bit, const uint8_t *src,
+                      size_t src_bit, size_t n_bits) {
+  if (dst_bit % 8 == 0 && src_bit % 8 == 0) {
+    size_t n_bytes = n_bits / 8;
+    memcpy(dst + dst_bit / 8, src + src_bit / 8, n_bytes);
+    dst_bit += n_bytes * 8;
+    src_bit += n_bytes * 8;
+    n_bits -= n_bytes * 8;
+  }
+
+  for (size_t i = 0; i < n_bits; i++) {
+    size_t s = src_bit + i;
+    size_t d = dst_bit + i;
+    uint8_t bit = (src[s / 8] >> (7 - s % 8)) & 0x1;
+    dst[d / 8] = (dst[d / 8] & ~(0x80 >> d % 8)) | bit << (7 - d % 8);
+  }
+}
+
+// Returns the decoded data for strip/tile [index], decoding it if it is not
+// in the cache.
+static const uint8_t *get_block(UtTiffImage *self, size_t index,
+                                const char **error) {
+  self->block_cache_clock++;
+
+  CachedBlock *entry = NULL;
+  for (size_t i = 0; i < BLOCK_CACHE_SIZE; i++) {
+    CachedBlock *e = &self->block_cache[i];
+    if (e->valid && e->index == index) {
+      e->last_used = self->block_cache_clock;
+      return e->data;
+    }
+
+    // Replace the least recently used entry.
+    if (entry == NULL || e->last_used < entry->last_used) {
+      entry = e;
+    }
+  }
+
+  size_t block_size = self->layout.block_length * self->layout.block_row_stride;
+  if (entry->data == NULL) {
+    entry->data = malloc(block_size);
+  }
+  memset(entry->data, 0, block_size);
+  entry->index = index;
+  entry->last_used = self->block_cache_clock;
+  *error = decode_block(&self->layout, index, entry->data);
+  entry->valid = *error == NULL;
+
+  return entry->valid ? entry->data : NULL;
+}
+
+// Decode all strips/tiles into the image data.
+static void decode_image_data(UtTiffImage *self) {
+  size_t n_planes = self->planar_configuration ==
+                            UT_TIFF_PLANAR_CONFIGURATION_PLANAR
+                        ? self->samples_per_pixel
+                        : 1;
+  UtObjectRef data =
+      ut_uint8_array_new_sized(n_planes * self->layout.plane_size);
+  BlockLayout layout = self->layout;
+  layout.image_data = ut_uint8_list_get_writable_data(data);
+  const char *error = decode_blocks(&layout, self->n_blocks, 1);
+  if (error != NULL) {
+    self->error = ut_tiff_error_new(error);
+    return;
+  }
+  self->data = ut_object_ref(data);
+}
+
 static void ut_tiff_image_cleanup(UtObject *object) {
   UtTiffImage *self = (UtTiffImage *)object;
   ut_object_unref(self->color_map);
   ut_object_unref(self->data);
+  ut_object_unref(self->source_data);
+  ut_object_unref(self->offsets);
+  ut_object_unref(self->byte_counts);
+  ut_object_unref(self->error);
+  if (self->block_cache != NULL) {
+    for (size_t i = 0; i < BLOCK_CACHE_SIZE; i++) {
+      free(self->block_cache[i].data);
+    }
+    free(self->block_cache);
+  }
 }
 
 static char *ut_tiff_image_to_string(UtObject *object) {
@@ -178,18 +503,16 @@ static UtObjectInterface object_interface = {.type_name = "UtTiffImage",
                                              .to_string =
                                                  ut_tiff_image_to_string};
 
-UtObject *
-ut_tiff_image_new(uint32_t width, uint32_t length,
-                  UtTiffPhotometricInterpretation photometric_interpretation,
-                  UtTiffPlanarConfiguration planar_configuration,
-                  uint16_t bits_per_sample, uint16_t samples_per_pixel,
-                  UtObject *data) {
+static UtObject *
+image_new(uint32_t width, uint32_t length,
+          UtTiffPhotometricInterpretation photometric_interpretation,
+          UtTiffPlanarConfiguration planar_configuration,
+          uint16_t bits_per_sample, uint16_t samples_per_pixel) {
   UtObject *object = ut_object_new(sizeof(UtTiffImage), &object_interface);
   UtTiffImage *self = (UtTiffImage *)object;
 
   assert(width > 0);
   assert(length > 0);
-  // FIXMEut_assert_int_equal(ut_list_get_length(data), length * width * 3);
 
   self->width = width;
   self->length = length;
@@ -197,12 +520,13 @@ ut_tiff_image_new(uint32_t width, uint32_t length,
   self->planar_configuration = planar_configuration;
   self->bits_per_sample = bits_per_sample;
   self->samples_per_pixel = samples_per_pixel;
-  self->data = ut_object_ref(data);
 
   return object;
 }
 
-UtObject *ut_tiff_image_new_from_data(UtObject *data) {
+// Read a TIFF image from [data]. If [lazy] the image data is only decoded
+// when it is accessed, otherwise it is decoded using [n_threads] threads.
+static UtObject *new_from_data(UtObject *data, bool lazy, size_t n_threads) {
   UtObjectRef reader = ut_tiff_reader_new(data);
   UtObject *error = ut_tiff_reader_get_error(reader);
   if (error != NULL) {
@@ -246,8 +570,7 @@ UtObject *ut_tiff_image_new_from_data(UtObject *data) {
                      &planar_configuration_value, false, 1)) {
     return ut_tiff_error_new("Invalid TIFF planar configuration tag");
   }
-  UtTiffPhotometricInterpretation planar_configuration =
-      planar_configuration_value;
+  UtTiffPlanarConfiguration planar_configuration = planar_configuration_value;
   switch (planar_configuration) {
   case UT_TIFF_PLANAR_CONFIGURATION_CHUNKY:
   case UT_TIFF_PLANAR_CONFIGURATION_PLANAR:
@@ -283,28 +606,29 @@ UtObject *ut_tiff_image_new_from_data(UtObject *data) {
   }
   UtTiffCompression compression = compression_value;
 
-  uint32_t rows_per_strip;
-  if (!get_short_or_long_tag(reader, UT_TIFF_TAG_ROWS_PER_STRIP,
-                             &rows_per_strip, true, 0)) {
-    return ut_tiff_error_new("Invalid TIFF rows per strip tag");
-  }
-  UtObject *strip_offsets_tag =
-      ut_tiff_reader_lookup_tag(reader, UT_TIFF_TAG_STRIP_OFFSETS);
-  uint16_t strip_offsets_type = ut_tiff_tag_get_type(strip_offsets_tag);
-  if (strip_offsets_tag == NULL ||
-      !(strip_offsets_type == UT_TIFF_TAG_TYPE_SHORT ||
-        strip_offsets_type == UT_TIFF_TAG_TYPE_LONG)) {
-    return ut_tiff_error_new("Invalid TIFF strip offsets tag");
-  }
-  size_t n_strips = ut_tiff_tag_get_count(strip_offsets_tag);
-  UtObject *strip_byte_counts_tag =
-      ut_tiff_reader_lookup_tag(reader, UT_TIFF_TAG_STRIP_BYTE_COUNTS);
-  uint16_t strip_byte_counts_type = ut_tiff_tag_get_type(strip_byte_counts_tag);
-  if (strip_byte_counts_tag == NULL ||
-      !(strip_byte_counts_type == UT_TIFF_TAG_TYPE_SHORT ||
-        strip_byte_counts_type == UT_TIFF_TAG_TYPE_LONG) ||
-      ut_tiff_tag_get_count(strip_byte_counts_tag) != n_strips) {
-    return ut_tiff_error_new("Invalid TIFF strip byte counts tag");
+  // Image data is either in strips of rows or tiles.
+  bool is_tiled =
+      ut_tiff_reader_lookup_tag(reader, UT_TIFF_TAG_TILE_WIDTH) != NULL;
+  uint32_t block_width, block_length;
+  if (is_tiled) {
+    if (!get_short_or_long_tag(reader, UT_TIFF_TAG_TILE_WIDTH, &block_width,
+                               true, 0) ||
+        block_width == 0) {
+      return ut_tiff_error_new("Invalid TIFF tile width tag");
+    }
+    if (!get_short_or_long_tag(reader, UT_TIFF_TAG_TILE_LENGTH, &block_length,
+                               true, 0) ||
+        block_length == 0) {
+      return ut_tiff_error_new("Invalid TIFF tile length tag");
+    }
+  } else {
+    // A missing rows per strip tag means the image is a single strip.
+    block_width = image_width;
+    if (!get_short_or_long_tag(reader, UT_TIFF_TAG_ROWS_PER_STRIP,
+                               &block_length, false, UINT32_MAX) ||
+        block_length == 0) {
+      return ut_tiff_error_new("Invalid TIFF rows per strip tag");
+    }
   }
 
   if (image_length == 0 || image_width == 0) {
@@ -384,56 +708,122 @@ UtObject *ut_tiff_image_new_from_data(UtObject *data) {
     return ut_tiff_error_new("Unsupported TIFF photometric interpretation");
   }
 
-  UtObjectRef image_data = ut_uint8_array_new();
+  size_t n_samples = samples_per_pixel;
+  size_t n_planes = 1;
+  if (planar_configuration == UT_TIFF_PLANAR_CONFIGURATION_PLANAR) {
+    n_samples = 1;
+    n_planes = samples_per_pixel;
+  }
+  if (block_length > image_length) {
+    block_length = image_length;
+  }
+  size_t image_row_stride =
+      get_row_stride(image_width, bits_per_sample, n_samples);
+  size_t plane_size = image_length * image_row_stride;
   size_t data_length = ut_list_get_length(data);
-  for (size_t i = 0; i < n_strips; i++) {
-    uint32_t offset = ut_tiff_tag_get_short_or_long(strip_offsets_tag, i);
-    uint32_t byte_count =
-        ut_tiff_tag_get_short_or_long(strip_byte_counts_tag, i);
-    if (offset + byte_count > data_length) {
-      return ut_tiff_error_new("Invalid TIFF strip");
-    }
-
-    UtObjectRef strip = ut_list_get_sublist(data, offset, byte_count);
-    switch (compression) {
-    case UT_TIFF_COMPRESSION_UNCOMPRESSED:
-      ut_list_append_list(image_data, strip);
-      break;
-    case UT_TIFF_COMPRESSION_PACK_BITS:
-      if (!decode_pack_bits(strip, image_data)) {
-        return ut_tiff_error_new("Invalid TIFF PackBits data");
-      }
-      break;
-    case UT_TIFF_COMPRESSION_LZW:
-      if (!decode_lzw(strip, image_data)) {
-        return ut_tiff_error_new("Invalid TIFF LZW data");
-      }
-      break;
-    case UT_TIFF_COMPRESSION_DEFLATE:
-      if (!decode_deflate(strip, image_data)) {
-        return ut_tiff_error_new("Invalid TIFF Deflate data");
-      }
-      break;
-    default:
-      assert(false);
-    }
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  UtObjectRef data_array = NULL;
+  if (d == NULL) {
+    data_array = ut_uint8_list_get_array(data);
+    d = ut_uint8_list_get_data(data_array);
   }
+  BlockLayout layout = {
+      .compression = compression,
+      .predictor = predictor,
+      .bits_per_sample = bits_per_sample,
+      .n_samples = n_samples,
+      .image_width = image_width,
+      .image_length = image_length,
+      .image_row_stride = image_row_stride,
+      .plane_size = plane_size,
+      .block_width = block_width,
+      .block_length = block_length,
+      .block_row_stride =
+          get_row_stride(block_width, bits_per_sample, n_samples),
+      .blocks_across = (image_width + block_width - 1) / block_width,
+      .blocks_down = (image_length + block_length - 1) / block_length,
+      .data = d};
 
-  if (predictor == UT_TIFF_PREDICTOR_HORIZONTAL_DIFFERENCING) {
-    decode_horizontal_differencing(image_width, image_length,
-                                   planar_configuration, bits_per_sample,
-                                   samples_per_pixel, image_data);
+  size_t n_blocks = n_planes * layout.blocks_across * layout.blocks_down;
+  UtObjectRef offsets = NULL;
+  UtObjectRef byte_counts = NULL;
+  if (is_tiled) {
+    if (!get_block_offsets(
+            ut_tiff_reader_lookup_tag(reader, UT_TIFF_TAG_TILE_OFFSETS),
+            ut_tiff_reader_lookup_tag(reader, UT_TIFF_TAG_TILE_BYTE_COUNTS),
+            n_blocks, data_length, &offsets, &byte_counts)) {
+      return ut_tiff_error_new("Invalid TIFF tile offsets");
+    }
+  } else {
+    if (!get_block_offsets(
+            ut_tiff_reader_lookup_tag(reader, UT_TIFF_TAG_STRIP_OFFSETS),
+            ut_tiff_reader_lookup_tag(reader, UT_TIFF_TAG_STRIP_BYTE_COUNTS),
+            n_blocks, data_length, &offsets, &byte_counts)) {
+      return ut_tiff_error_new("Invalid TIFF strip offsets");
+    }
   }
+  layout.offsets = ut_uint32_list_get_data(offsets);
+  layout.byte_counts = ut_uint32_list_get_data(byte_counts);
 
-  UtObject *image = ut_tiff_image_new(
-      image_width, image_length, photometric_interpretation,
-      planar_configuration, bits_per_sample, samples_per_pixel, image_data);
+  UtObject *image =
+      image_new(image_width, image_length, photometric_interpretation,
+                planar_configuration, bits_per_sample, samples_per_pixel);
+  UtTiffImage *self = (UtTiffImage *)image;
   if (color_map != NULL) {
     ut_tiff_image_set_color_map(image, color_map);
   }
+
+  if (lazy) {
+    self->source_data =
+        data_array != NULL ? ut_object_ref(data_array) : ut_object_ref(data);
+    self->offsets = ut_object_ref(offsets);
+    self->byte_counts = ut_object_ref(byte_counts);
+    self->layout = layout;
+    self->n_blocks = n_blocks;
+    self->block_cache = calloc(BLOCK_CACHE_SIZE, sizeof(CachedBlock));
+    return image;
+  }
+
+  UtObjectRef image_data = ut_uint8_array_new_sized(n_planes * plane_size);
+  layout.image_data = ut_uint8_list_get_writable_data(image_data);
+  const char *decode_error = decode_blocks(&layout, n_blocks, n_threads);
+  if (decode_error != NULL) {
+    ut_object_unref(image);
+    return ut_tiff_error_new(decode_error);
+  }
+  self->data = ut_object_ref(image_data);
+
   return image;
 }
 
+UtObject *
+ut_tiff_image_new(uint32_t width, uint32_t length,
+                  UtTiffPhotometricInterpretation photometric_interpretation,
+                  UtTiffPlanarConfiguration planar_configuration,
+                  uint16_t bits_per_sample, uint16_t samples_per_pixel,
+                  UtObject *data) {
+  // FIXMEut_assert_int_equal(ut_list_get_length(data), length * width * 3);
+  UtObject *object =
+      image_new(width, length, photometric_interpretation,
+                planar_configuration, bits_per_sample, samples_per_pixel);
+  UtTiffImage *self = (UtTiffImage *)object;
+  self->data = ut_object_ref(data);
+  return object;
+}
+
+UtObject *ut_tiff_image_new_from_data(UtObject *data) {
+  return new_from_data(data, false, 1);
+}
+
+UtObject *ut_tiff_image_new_from_data_with_n_threads(UtObject *data,
+                                                     size_t n_threads) {
+  return new_from_data(data, false, n_threads);
+}
+
+UtObject *ut_tiff_image_new_from_data_lazy(UtObject *data) {
+  return new_from_data(data, true, 1);
+}
+
 uint32_t ut_tiff_image_get_width(UtObject *object) {
   assert(ut_object_is_tiff_image(object));
   UtTiffImage *self = (UtTiffImage *)object;
@@ -501,15 +891,271 @@ UtObject *ut_tiff_image_get_color_map(UtObject *object) {
 UtObject *ut_tiff_image_get_data(UtObject *object) {
   assert(ut_object_is_tiff_image(object));
   UtTiffImage *self = (UtTiffImage *)object;
+  if (self->data == NULL && self->error == NULL) {
+    decode_image_data(self);
+  }
   return self->data;
 }
 
+UtObject *ut_tiff_image_get_error(UtObject *object) {
+  assert(ut_object_is_tiff_image(object));
+  UtTiffImage *self = (UtTiffImage *)object;
+  return self->error;
+}
+
+UtObject *ut_tiff_image_read_region(UtObject *object, uint32_t x, uint32_t y,
+                                    uint32_t width, uint32_t length) {
+  assert(ut_object_is_tiff_image(object));
+  UtTiffImage *self = (UtTiffImage *)object;
+
+  assert(width > 0 && length > 0);
+  assert(x + width <= self->width && y + length <= self->length);
+
+  if (self->error != NULL) {
+    return ut_object_ref(self->error);
+  }
+
+  size_t n_samples = self->samples_per_pixel;
+  size_t n_planes = 1;
+  if (self->planar_configuration == UT_TIFF_PLANAR_CONFIGURATION_PLANAR) {
+    n_samples = 1;
+    n_planes = self->samples_per_pixel;
+  }
+  size_t bits_per_pixel = self->bits_per_sample * n_samples;
+  size_t region_row_stride =
+      get_row_stride(width, self->bits_per_sample, n_samples);
+  UtObject *region =
+      ut_uint8_array_new_sized(n_planes * length * region_row_stride);
+  uint8_t *region_data = ut_uint8_list_get_writable_data(region);
+
+  // Copy from the image data if it has been decoded.
+  if (self->data != NULL) {
+    size_t image_row_stride =
+        get_row_stride(self->width, self->bits_per_sample, n_samples);
+    const uint8_t *image_data = ut_uint8_list_get_data(self->data);
+    for (size_t plane = 0; plane < n_planes; plane++) {
+      for (size_t row = 0; row < length; row++) {
+        copy_bits(region_data + (plane * length + row) * region_row_stride, 0,
+                  image_data +
+                      (plane * self->length + y + row) * image_row_stride,
+                  x * bits_per_pixel, width * bits_per_pixel);
+      }
+    }
+    return region;
+  }
+
+  // Otherwise copy from each strip/tile that overlaps the region.
+  const BlockLayout *layout = &self->layout;
+  size_t blocks_per_plane = layout->blocks_across * layout->blocks_down;
+  size_t block_x_start = x / layout->block_width;
+  size_t block_x_end = (x + width - 1) / layout->block_width + 1;
+  size_t block_y_start = y / layout->block_length;
+  size_t block_y_end = (y + length - 1) / layout->block_length + 1;
+  for (size_t plane = 0; plane < n_planes; plane++) {
+    for (size_t block_y = block_y_start; block_y < block_y_end; block_y++) {
+      for (size_t block_x = block_x_start; block_x < block_x_end; block_x++) {
+        size_t index = plane * blocks_per_plane +
+                       block_y * layout->blocks_across + block_x;
+        const char *error = NULL;
+        const uint8_t *block_data = get_block(self, index, &error);
+        if (block_data == NULL) {
+          ut_object_unref(region);
+          return ut_tiff_error_new(error);
+        }
+
+        // Intersection of this strip/tile with the region.
+        size_t x0 = block_x * layout->block_width;
+        size_t y0 = block_y * layout->block_length;
+        size_t start_x = x0 > x ? x0 : x;
+        size_t end_x = x0 + layout->block_width < x + width
+                           ? x0 + layout->block_width
+                           : x + width;
+        size_t start_y = y0 > y ? y0 : y;
+        size_t end_y = y0 + layout->block_length < y + length
+                           ? y0 + layout->block_length
+                           : y + length;
+        for (size_t row = start_y; row < end_y; row++) {
+          copy_bits(region_data +
+                        (plane * length + row - y) * region_row_stride,
+                    (start_x - x) * bits_per_pixel,
+                    block_data + (row - y0) * layout->block_row_stride,
+                    (start_x - x0) * bits_per_pixel,
+                    (end_x - start_x) * bits_per_pixel);
+        }
+      }
+    }
+  }
+
+  return region;
+}
+
+// Get the pixel format for the data in this image, or false if not
+// supported.
+static bool get_pixel_format(UtTiffImage *self, UtPixelFormat *format) {
+  if (self->planar_configuration != UT_TIFF_PLANAR_CONFIGURATION_CHUNKY) {
+    return false;
+  }
+
+  switch (self->photometric_interpretation) {
+  case UT_TIFF_PHOTOMETRIC_INTERPRETATION_WHITE_IS_ZERO:
+    // Inverted greyscale is converted using a palette, see
+    // set_white_is_zero_palette().
+    if (self->samples_per_pixel != 1) {
+      return false;
+    }
+    switch (self->bits_per_sample) {
+    case 1:
+      *format = UT_PIXEL_FORMAT_INDEXED1;
+      return true;
+    case 2:
+      *format = UT_PIXEL_FORMAT_INDEXED2;
+      return true;
+    case 4:
+      *format = UT_PIXEL_FORMAT_INDEXED4;
+      return true;
+    case 8:
+      *format = UT_PIXEL_FORMAT_INDEXED8;
+      return true;
+    default:
+      return false;
+    }
+  case UT_TIFF_PHOTOMETRIC_INTERPRETATION_BLACK_IS_ZERO:
+    if (self->samples_per_pixel == 2) {
+      switch (self->bits_per_sample) {
+      case 8:
+        *format = UT_PIXEL_FORMAT_GREY_ALPHA8;
+        return true;
+      case 16:
+        *format = UT_PIXEL_FORMAT_GREY_ALPHA16;
+        return true;
+      default:
+        return false;
+      }
+    } else if (self->samples_per_pixel != 1) {
+      return false;
+    }
+    switch (self->bits_per_sample) {
+    case 1:
+      *format = UT_PIXEL_FORMAT_GREY1;
+      return true;
+    case 2:
+      *format = UT_PIXEL_FORMAT_GREY2;
+      return true;
+    case 4:
+      *format = UT_PIXEL_FORMAT_GREY4;
+      return true;
+    case 8:
+      *format = UT_PIXEL_FORMAT_GREY8;
+      return true;
+    case 16:
+      *format = UT_PIXEL_FORMAT_GREY16;
+      return true;
+    default:
+      return false;
+    }
+  case UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB:
+    if (self->bits_per_sample == 8) {
+      switch (self->samples_per_pixel) {
+      case 3:
+        *format = UT_PIXEL_FORMAT_RGB8;
+        return true;
+      case 4:
+        *format = UT_PIXEL_FORMAT_RGBA8;
+        return true;
+      default:
+        return false;
+      }
+    } else if (self->bits_per_sample == 16) {
+      switch (self->samples_per_pixel) {
+      case 3:
+        *format = UT_PIXEL_FORMAT_RGB16;
+        return true;
+      case 4:
+        *format = UT_PIXEL_FORMAT_RGBA16;
+        return true;
+      default:
+        return false;
+      }
+    } else {
+      return false;
+    }
+  case UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB_PALETTE:
+    if (self->samples_per_pixel != 1) {
+      return false;
+    }
+    switch (self->bits_per_sample) {
+    case 1:
+      *format = UT_PIXEL_FORMAT_INDEXED1;
+      return true;
+    case 2:
+      *format = UT_PIXEL_FORMAT_INDEXED2;
+      return true;
+    case 4:
+      *format = UT_PIXEL_FORMAT_INDEXED4;
+      return true;
+    case 8:
+      *format = UT_PIXEL_FORMAT_INDEXED8;
+      return true;
+    default:
+      return false;
+    }
+  default:
+    return false;
+  }
+}
+
+// Sets a palette on [converter] that maps [bits_per_sample] sample values to
+// inverted grey levels.
+static void set_white_is_zero_palette(UtObject *converter,
+                                      uint16_t bits_per_sample) {
+  size_t n_colors = 1 << bits_per_sample;
+  UtObjectRef palette = ut_uint8_array_new_sized(n_colors * 3);
+  uint8_t *palette_data = ut_uint8_list_get_writable_data(palette);
+  for (size_t i = 0; i < n_colors; i++) {
+    uint8_t value = 255 - i * 255 / (n_colors - 1);
+    palette_data[i * 3] = palette_data[i * 3 + 1] = palette_data[i * 3 + 2] =
+        value;
+  }
+  ut_pixel_converter_set_palette(converter, palette);
+}
+
 UtObject *ut_tiff_image_to_rgba(UtObject *object) {
   assert(ut_object_is_tiff_image(object));
   UtTiffImage *self = (UtTiffImage *)object;
 
-  // Already in desired format. FIXME
-  return ut_object_ref(self->data);
+  UtObject *data = ut_tiff_image_get_data(object);
+  if (data == NULL) {
+    return NULL;
+  }
+
+  UtPixelFormat format;
+  if (!get_pixel_format(self, &format)) {
+    return NULL;
+  }
+
+  UtObjectRef converter =
+      ut_pixel_converter_new(format, UT_PIXEL_FORMAT_RGBA8);
+  if (self->photometric_interpretation ==
+      UT_TIFF_PHOTOMETRIC_INTERPRETATION_WHITE_IS_ZERO) {
+    set_white_is_zero_palette(converter, self->bits_per_sample);
+  } else if (self->color_map != NULL) {
+    // Color map is stored as all the reds, then greens, then blues.
+    size_t n_colors = ut_list_get_length(self->color_map) / 3;
+    UtObjectRef palette = ut_uint8_array_new_sized(n_colors * 3);
+    uint8_t *palette_data = ut_uint8_list_get_writable_data(palette);
+    for (size_t i = 0; i < n_colors; i++) {
+      for (size_t c = 0; c < 3; c++) {
+        palette_data[i * 3 + c] =
+            ut_uint16_list_get_element(self->color_map, c * n_colors + i) /
+            257;
+      }
+    }
+    ut_pixel_converter_set_palette(converter, palette);
+  }
+
+  return ut_pixel_converter_convert(converter, data, self->width,
+                                    self->length,
+                                    ut_tiff_image_get_row_stride(object));
 }
 
 bool ut_object_is_tiff_image(UtObject *object) {
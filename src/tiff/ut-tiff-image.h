@@ -9,6 +9,7 @@
 /// Creates a new TIFF image of size [width]x[length] from [data].
 /// The data is interpreted using [photometric_interpretation],
 /// [planar_configuration], [bits_per_sample] and [samples_per_pixel].
+/// 16 bit samples are stored in big-endian order.
 ///
 /// !arg-type data UtUint8List
 /// !return-ref
@@ -27,6 +28,27 @@ ut_tiff_image_new(uint32_t width, uint32_t length,
 /// !return-type UtTiffImage UtTiffError
 UtObject *ut_tiff_image_new_from_data(UtObject *data);
 
+/// Creates a new TIFF image from [data], decoding the strips or tiles using
+/// up to [n_threads] threads.
+///
+/// !arg-type data UtUint8List
+/// !return-ref
+/// !return-type UtTiffImage UtTiffError
+UtObject *ut_tiff_image_new_from_data_with_n_threads(UtObject *data,
+                                                     size_t n_threads);
+
+/// Creates a new TIFF image from [data] that only decodes the strips or tiles
+/// needed when the image data is accessed. Recently decoded strips or tiles
+/// are cached for use by [ut_tiff_image_read_region].
+///
+/// [data] is kept for the lifetime of the image, so large images are best
+/// read from a [UtMemoryMappedFile].
+///
+/// !arg-type data UtUint8List
+/// !return-ref
+/// !return-type UtTiffImage UtTiffError
+UtObject *ut_tiff_image_new_from_data_lazy(UtObject *data);
+
 /// Returns the width of the image in pixels.
 uint32_t ut_tiff_image_get_width(UtObject *object);
 
@@ -60,15 +82,36 @@ void ut_tiff_image_set_color_map(UtObject *object, UtObject *color_map);
 /// !return-type UtUint16List
 UtObject *ut_tiff_image_get_color_map(UtObject *object);
 
-/// Returns the image data.
+/// Returns the image data. Images created with
+/// [ut_tiff_image_new_from_data_lazy] are fully decoded when this is first
+/// called, and [NULL] is returned if that fails. The error is available from
+/// [ut_tiff_image_get_error].
 ///
-/// !return-type UtUint8List
+/// !return-type UtUint8List NULL
 UtObject *ut_tiff_image_get_data(UtObject *object);
 
-/// Returns the image data converted to RGBA form.
+/// Returns the error that occurred when decoding the data of an image created
+/// with [ut_tiff_image_new_from_data_lazy], or [NULL] if no error occurred.
+///
+/// !return-type UtTiffError NULL
+UtObject *ut_tiff_image_get_error(UtObject *object);
+
+/// Returns the [width]x[length] pixels starting at [x], [y] in the same form as
+/// [ut_tiff_image_get_data]. Only the strips or tiles that overlap the region
+/// are decoded.
+///
+/// !return-ref
+/// !return-type UtUint8List UtTiffError
+UtObject *ut_tiff_image_read_region(UtObject *object, uint32_t x, uint32_t y,
+                                    uint32_t width, uint32_t length);
+
+/// Returns the image data converted to RGBA form, or [NULL] if the data
+/// couldn't be decoded or the image is in a format that can't be converted.
+/// Bilevel, greyscale, RGB and palette images with chunky samples are
+/// supported.
 ///
 /// !return-ref
-/// !return-type UtUint8List
+/// !return-type UtUint8List NULL
 UtObject *ut_tiff_image_to_rgba(UtObject *object);
 
 /// Returns [true] if [object] is a [UtTiffImage].
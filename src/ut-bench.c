@@ -0,0 +1,832 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "ut.h"
+
+// Measures the throughput of the image codecs and compression formats over a
+// generated corpus and writes the results as JSON.
+//
+// Usage: ut-bench [--min-time SECONDS] [--filter NAME] [--baseline FILE]
+//                 [--threshold PERCENT] [--write-corpus DIRECTORY]
+//
+// When a baseline (the JSON output of a previous run) is given, each result
+// is compared against it and the program exits with status 1 if any
+// throughput has dropped more than the threshold.
+
+#define IMAGE_WIDTH 512
+#define IMAGE_HEIGHT 384
+#define TEXT_LENGTH (1024 * 1024)
+#define TIFF_ROWS_PER_STRIP 16
+
+typedef struct {
+  UtObject *rgb;
+  UtObject *rgba;
+  UtObject *text;
+
+  UtObject *png_image;
+  UtObject *png_data;
+  UtObject *jpeg_image;
+  UtObject *jpeg_data;
+  UtObject *gif_images;
+  UtObject *gif_data;
+  UtObject *tiff_data;
+  UtObject *tiff_deflate_data;
+  UtObject *deflate_data;
+  UtObject *zlib_data;
+  UtObject *gzip_data;
+} Corpus;
+
+typedef struct {
+  const char *name;
+
+  // Number of pixels in each run, or zero for non-image formats.
+  size_t n_pixels;
+
+  // Runs the benchmark once, returning the number of uncompressed bytes.
+  size_t (*run)(Corpus *corpus);
+} Benchmark;
+
+// Sanitizers replace the allocator themselves.
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define HAVE_SANITIZER
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) ||    \
+    __has_feature(thread_sanitizer)
+#define HAVE_SANITIZER
+#endif
+#endif
+
+#if defined(__GLIBC__) && !defined(HAVE_SANITIZER)
+#include <errno.h>
+#include <malloc.h>
+
+// Count allocations by replacing the allocator entry points and forwarding
+// to the C library. glibc requires the whole family to be replaced together.
+// malloc_usable_size is not replaced as the underlying allocator is
+// unchanged.
+extern void *__libc_malloc(size_t size);
+extern void __libc_free(void *ptr);
+extern void *__libc_calloc(size_t n_members, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+
+static size_t n_allocations = 0;
+static size_t n_allocated_bytes = 0;
+
+static void count_allocation(size_t size) {
+  __atomic_fetch_add(&n_allocations, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&n_allocated_bytes, size, __ATOMIC_RELAXED);
+}
+
+void *malloc(size_t size) {
+  count_allocation(size);
+  return __libc_malloc(size);
+}
+
+void free(void *ptr) { __libc_free(ptr); }
+
+void *calloc(size_t n_members, size_t size) {
+  count_allocation(n_members * size);
+  return __libc_calloc(n_members, size);
+}
+
+// Only count the growth, as lists are often grown a piece at a time.
+void *realloc(void *ptr, size_t size) {
+  size_t old_size = ptr != NULL ? malloc_usable_size(ptr) : 0;
+  count_allocation(size > old_size ? size - old_size : 0);
+  return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  count_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+  if (alignment % sizeof(void *) != 0 ||
+      (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  void *result = memalign(alignment, size);
+  if (result == NULL) {
+    return ENOMEM;
+  }
+  *ptr = result;
+  return 0;
+}
+
+void *valloc(size_t size) {
+  count_allocation(size);
+  return __libc_valloc(size);
+}
+
+void *pvalloc(size_t size) {
+  count_allocation(size);
+  return __libc_pvalloc(size);
+}
+
+static bool have_allocation_counts = true;
+#else
+static size_t n_allocations = 0;
+static size_t n_allocated_bytes = 0;
+static bool have_allocation_counts = false;
+#endif
+
+static double get_time() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Reset the peak memory usage, which is only supported on Linux. Returns
+// false if the peak couldn't be reset, in which case it is the peak for the
+// whole process.
+static bool reset_peak_rss() {
+  FILE *file = fopen("/proc/self/clear_refs", "w");
+  if (file == NULL) {
+    return false;
+  }
+  bool written = fputs("5", file) >= 0;
+  return fclose(file) == 0 && written;
+}
+
+// Get the value in kilobytes of [format] from /proc/self/status, or 0 if not
+// available.
+static size_t read_status_kb(const char *format) {
+  FILE *file = fopen("/proc/self/status", "r");
+  if (file == NULL) {
+    return 0;
+  }
+  char line[256];
+  size_t value = 0;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (sscanf(line, format, &value) == 1) {
+      break;
+    }
+  }
+  fclose(file);
+  return value;
+}
+
+// Get the current memory usage in kilobytes, or 0 if not available.
+static size_t get_rss() { return read_status_kb("VmRSS: %zu kB"); }
+
+// Get the peak memory usage in kilobytes.
+static size_t get_peak_rss() {
+  size_t peak_rss = read_status_kb("VmHWM: %zu kB");
+  if (peak_rss != 0) {
+    return peak_rss;
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Pseudo random numbers, so the corpus is the same on every platform.
+static uint32_t random_state = 1;
+static uint32_t get_random() {
+  random_state = random_state * 1103515245 + 12345;
+  return random_state >> 16;
+}
+
+static uint8_t clamp_sample(int value) {
+  return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+// Generate an image with a mix of smooth photographic-like areas and flat
+// user interface-like areas.
+static void generate_image(Corpus *corpus) {
+  corpus->rgb = ut_uint8_array_new_sized(IMAGE_WIDTH * IMAGE_HEIGHT * 3);
+  corpus->rgba = ut_uint8_array_new_sized(IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+  uint8_t *rgb = ut_uint8_list_get_writable_data(corpus->rgb);
+  uint8_t *rgba = ut_uint8_list_get_writable_data(corpus->rgba);
+  for (size_t y = 0; y < IMAGE_HEIGHT; y++) {
+    for (size_t x = 0; x < IMAGE_WIDTH; x++) {
+      uint8_t pixel[4];
+      if (x < IMAGE_WIDTH / 2) {
+        double dx = x - IMAGE_WIDTH / 4.0, dy = y - IMAGE_HEIGHT / 2.0;
+        double rings = sin(sqrt(dx * dx + dy * dy) / 12.0) * 40;
+        int noise = get_random() % 9 - 4;
+        pixel[0] = clamp_sample(x * 255 / IMAGE_WIDTH + rings + noise);
+        pixel[1] = clamp_sample(y * 255 / IMAGE_HEIGHT + rings + noise);
+        pixel[2] = clamp_sample(128 - rings + noise);
+        pixel[3] = 255;
+      } else {
+        // Panels with borders and short runs of "text".
+        bool border = x % 128 < 2 || y % 96 < 2;
+        bool text = y % 96 > 20 && y % 96 < 28 && x % 128 > 10 &&
+                    x % 128 < 110 && (x / 3 + y / 96) % 5 != 0;
+        uint8_t value = border ? 0x40 : text ? 0x20 : 0xf0;
+        pixel[0] = pixel[1] = pixel[2] = value;
+        pixel[3] = y % 96 < 48 ? 255 : 192;
+      }
+      memcpy(rgb + (y * IMAGE_WIDTH + x) * 3, pixel, 3);
+      memcpy(rgba + (y * IMAGE_WIDTH + x) * 4, pixel, 4);
+    }
+  }
+}
+
+// Generate log-like text.
+static void generate_text(Corpus *corpus) {
+  const char *levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARNING"};
+  const char *paths[] = {"/api/v1/items", "/api/v1/users", "/static/app.js",
+                         "/index.html", "/api/v1/search"};
+  UtObjectRef text = ut_string_new("");
+  size_t length = 0;
+  for (size_t i = 0; length < TEXT_LENGTH; i++) {
+    char line[256];
+    length += snprintf(
+        line, sizeof(line),
+        "2024-01-01T%02zu:%02zu:%02zuZ %s request id=%08x path=%s/%u "
+        "status=%d bytes=%u\n",
+        i / 3600 % 24, i / 60 % 60, i % 60, levels[get_random() % 5],
+        get_random() << 16 | get_random(), paths[get_random() % 5],
+        get_random() % 1000, get_random() % 20 == 0 ? 404 : 200,
+        get_random() % 100000);
+    ut_string_append(text, line);
+  }
+  corpus->text = ut_uint8_array_new_from_data(
+      (const uint8_t *)ut_string_get_text(text), TEXT_LENGTH);
+}
+
+static UtObject *read_all(UtObject *input_stream) {
+  UtObject *result = ut_input_stream_read_sync(input_stream);
+  if (ut_object_implements_error(result)) {
+    ut_cstring_ref description = ut_error_get_description(result);
+    fprintf(stderr, "Failed to process stream: %s\n", description);
+    exit(1);
+  }
+  return result;
+}
+
+static void check_image(UtObject *image) {
+  if (ut_object_implements_error(image)) {
+    ut_cstring_ref description = ut_error_get_description(image);
+    fprintf(stderr, "Failed to decode image: %s\n", description);
+    exit(1);
+  }
+}
+
+static void append_uint16(UtObject *data, uint16_t value) {
+  ut_uint8_list_append(data, value & 0xff);
+  ut_uint8_list_append(data, value >> 8);
+}
+
+static void append_uint32(UtObject *data, uint32_t value) {
+  append_uint16(data, value & 0xffff);
+  append_uint16(data, value >> 16);
+}
+
+static void append_tag(UtObject *data, uint16_t id, uint16_t type,
+                       uint32_t count, uint32_t value) {
+  append_uint16(data, id);
+  append_uint16(data, type);
+  append_uint32(data, count);
+  if (type == UT_TIFF_TAG_TYPE_SHORT && count == 1) {
+    append_uint16(data, value);
+    append_uint16(data, 0);
+  } else {
+    append_uint32(data, value);
+  }
+}
+
+// Generate a little endian RGB TIFF image, optionally deflate compressed.
+static UtObject *generate_tiff(Corpus *corpus, bool compress) {
+  const uint8_t *rgb = ut_uint8_list_get_data(corpus->rgb);
+  size_t row_stride = IMAGE_WIDTH * 3;
+  size_t n_strips =
+      (IMAGE_HEIGHT + TIFF_ROWS_PER_STRIP - 1) / TIFF_ROWS_PER_STRIP;
+  UtObjectRef strips = ut_object_list_new();
+  for (size_t i = 0; i < n_strips; i++) {
+    size_t n_rows = IMAGE_HEIGHT - i * TIFF_ROWS_PER_STRIP;
+    if (n_rows > TIFF_ROWS_PER_STRIP) {
+      n_rows = TIFF_ROWS_PER_STRIP;
+    }
+    UtObjectRef strip = ut_uint8_array_new_from_data(
+        rgb + i * TIFF_ROWS_PER_STRIP * row_stride, n_rows * row_stride);
+    if (compress) {
+      UtObjectRef strip_stream = ut_list_input_stream_new(strip);
+      UtObjectRef encoder = ut_zlib_encoder_new(strip_stream);
+      ut_list_append_take(strips, read_all(encoder));
+    } else {
+      ut_list_append(strips, strip);
+    }
+  }
+
+  // Header, then the IFD followed by the tag data and strips.
+  const size_t n_tags = 10;
+  size_t ifd_offset = 8;
+  size_t bits_per_sample_offset = ifd_offset + 2 + n_tags * 12 + 4;
+  size_t strip_offsets_offset = bits_per_sample_offset + 6;
+  size_t strip_byte_counts_offset = strip_offsets_offset + n_strips * 4;
+  size_t strip_offset = strip_byte_counts_offset + n_strips * 4;
+
+  UtObject *data = ut_uint8_array_new();
+  ut_uint8_list_append_block(data, (const uint8_t *)"II*\0", 4);
+  append_uint32(data, ifd_offset);
+  append_uint16(data, n_tags);
+  append_tag(data, UT_TIFF_TAG_IMAGE_WIDTH, UT_TIFF_TAG_TYPE_LONG, 1,
+             IMAGE_WIDTH);
+  append_tag(data, UT_TIFF_TAG_IMAGE_LENGTH, UT_TIFF_TAG_TYPE_LONG, 1,
+             IMAGE_HEIGHT);
+  append_tag(data, UT_TIFF_TAG_BITS_PER_SAMPLE, UT_TIFF_TAG_TYPE_SHORT, 3,
+             bits_per_sample_offset);
+  append_tag(data, UT_TIFF_TAG_COMPRESSION, UT_TIFF_TAG_TYPE_SHORT, 1,
+             compress ? UT_TIFF_COMPRESSION_DEFLATE
+                      : UT_TIFF_COMPRESSION_UNCOMPRESSED);
+  append_tag(data, UT_TIFF_TAG_PHOTOMETRIC_INTERPRETATION,
+             UT_TIFF_TAG_TYPE_SHORT, 1,
+             UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB);
+  append_tag(data, UT_TIFF_TAG_STRIP_OFFSETS, UT_TIFF_TAG_TYPE_LONG, n_strips,
+             strip_offsets_offset);
+  append_tag(data, UT_TIFF_TAG_SAMPLES_PER_PIXEL, UT_TIFF_TAG_TYPE_SHORT, 1,
+             3);
+  append_tag(data, UT_TIFF_TAG_ROWS_PER_STRIP, UT_TIFF_TAG_TYPE_LONG, 1,
+             TIFF_ROWS_PER_STRIP);
+  append_tag(data, UT_TIFF_TAG_STRIP_BYTE_COUNTS, UT_TIFF_TAG_TYPE_LONG,
+             n_strips, strip_byte_counts_offset);
+  append_tag(data, UT_TIFF_TAG_PLANAR_CONFIGURATION, UT_TIFF_TAG_TYPE_SHORT, 1,
+             UT_TIFF_PLANAR_CONFIGURATION_CHUNKY);
+  append_uint32(data, 0);
+  for (size_t i = 0; i < 3; i++) {
+    append_uint16(data, 8);
+  }
+  size_t offset = strip_offset;
+  for (size_t i = 0; i < n_strips; i++) {
+    append_uint32(data, offset);
+    offset += ut_list_get_length(ut_object_list_get_element(strips, i));
+  }
+  for (size_t i = 0; i < n_strips; i++) {
+    append_uint32(data,
+                  ut_list_get_length(ut_object_list_get_element(strips, i)));
+  }
+  for (size_t i = 0; i < n_strips; i++) {
+    ut_list_append_list(data, ut_object_list_get_element(strips, i));
+  }
+
+  return data;
+}
+
+static size_t run_png_encode(Corpus *corpus) {
+  UtObjectRef data = ut_uint8_array_new();
+  UtObjectRef encoder = ut_png_encoder_new(corpus->png_image, data);
+  ut_png_encoder_encode(encoder);
+  return ut_list_get_length(corpus->rgba);
+}
+
+static size_t run_png_decode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->png_data);
+  UtObjectRef decoder = ut_png_decoder_new(input_stream);
+  UtObjectRef image = ut_png_decoder_decode_sync(decoder);
+  check_image(image);
+  return ut_list_get_length(ut_png_image_get_data(image));
+}
+
+static size_t run_jpeg_encode(Corpus *corpus) {
+  UtObjectRef data = ut_uint8_array_new();
+  UtObjectRef encoder = ut_jpeg_encoder_new(corpus->jpeg_image, data);
+  ut_jpeg_encoder_encode(encoder);
+  return ut_list_get_length(corpus->rgb);
+}
+
+static size_t run_jpeg_decode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->jpeg_data);
+  UtObjectRef decoder = ut_jpeg_decoder_new(input_stream);
+  UtObjectRef image = ut_jpeg_decoder_decode_sync(decoder);
+  check_image(image);
+  return ut_list_get_length(ut_jpeg_image_get_data(image));
+}
+
+static size_t run_gif_encode(Corpus *corpus) {
+  UtObjectRef data = ut_uint8_array_new();
+  UtObjectRef encoder = ut_gif_encoder_new(IMAGE_WIDTH, IMAGE_HEIGHT, NULL,
+                                           corpus->gif_images, data);
+  ut_gif_encoder_encode(encoder);
+  return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static size_t run_gif_decode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->gif_data);
+  UtObjectRef decoder = ut_gif_decoder_new(input_stream);
+  UtObjectRef images = ut_gif_decoder_decode_sync(decoder);
+  check_image(images);
+  UtObject *image = ut_object_list_get_element(images, 0);
+  return ut_list_get_length(ut_gif_image_get_data(image));
+}
+
+static size_t decode_tiff(UtObject *data) {
+  UtObjectRef image = ut_tiff_image_new_from_data(data);
+  check_image(image);
+  return ut_list_get_length(ut_tiff_image_get_data(image));
+}
+
+static size_t run_tiff_decode(Corpus *corpus) {
+  return decode_tiff(corpus->tiff_data);
+}
+
+static size_t run_tiff_deflate_decode(Corpus *corpus) {
+  return decode_tiff(corpus->tiff_deflate_data);
+}
+
+static size_t run_deflate_encode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->text);
+  UtObjectRef encoder = ut_deflate_encoder_new(input_stream);
+  UtObjectRef result = read_all(encoder);
+  return ut_list_get_length(corpus->text);
+}
+
+static size_t run_deflate_decode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->deflate_data);
+  UtObjectRef decoder = ut_deflate_decoder_new(input_stream);
+  UtObjectRef result = read_all(decoder);
+  return ut_list_get_length(result);
+}
+
+static size_t run_zlib_encode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->text);
+  UtObjectRef encoder = ut_zlib_encoder_new(input_stream);
+  UtObjectRef result = read_all(encoder);
+  return ut_list_get_length(corpus->text);
+}
+
+static size_t run_zlib_decode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->zlib_data);
+  UtObjectRef decoder = ut_zlib_decoder_new(input_stream);
+  UtObjectRef result = read_all(decoder);
+  return ut_list_get_length(result);
+}
+
+static size_t run_gzip_encode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->text);
+  UtObjectRef encoder = ut_gzip_encoder_new(input_stream);
+  UtObjectRef result = read_all(encoder);
+  return ut_list_get_length(corpus->text);
+}
+
+static size_t run_gzip_decode(Corpus *corpus) {
+  UtObjectRef input_stream = ut_list_input_stream_new(corpus->gzip_data);
+  UtObjectRef decoder = ut_gzip_decoder_new(input_stream);
+  UtObjectRef result = read_all(decoder);
+  return ut_list_get_length(result);
+}
+
+#define N_PIXELS (IMAGE_WIDTH * IMAGE_HEIGHT)
+static Benchmark benchmarks[] = {
+    {"png-encode", N_PIXELS, run_png_encode},
+    {"png-decode", N_PIXELS, run_png_decode},
+    {"jpeg-encode", N_PIXELS, run_jpeg_encode},
+    {"jpeg-decode", N_PIXELS, run_jpeg_decode},
+    {"gif-encode", N_PIXELS, run_gif_encode},
+    {"gif-decode", N_PIXELS, run_gif_decode},
+    {"tiff-decode", N_PIXELS, run_tiff_decode},
+    {"tiff-deflate-decode", N_PIXELS, run_tiff_deflate_decode},
+    {"deflate-encode", 0, run_deflate_encode},
+    {"deflate-decode", 0, run_deflate_decode},
+    {"zlib-encode", 0, run_zlib_encode},
+    {"zlib-decode", 0, run_zlib_decode},
+    {"gzip-encode", 0, run_gzip_encode},
+    {"gzip-decode", 0, run_gzip_decode}};
+
+static UtObject *encode_stream(UtObject *encoder) { return read_all(encoder); }
+
+static void generate_corpus(Corpus *corpus) {
+  generate_image(corpus);
+  generate_text(corpus);
+
+  corpus->png_image =
+      ut_png_image_new(IMAGE_WIDTH, IMAGE_HEIGHT, 8,
+                       UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA, corpus->rgba);
+  corpus->png_data = ut_uint8_array_new();
+  UtObjectRef png_encoder =
+      ut_png_encoder_new(corpus->png_image, corpus->png_data);
+  ut_png_encoder_encode(png_encoder);
+
+  corpus->jpeg_image =
+      ut_jpeg_image_new(IMAGE_WIDTH, IMAGE_HEIGHT,
+                        UT_JPEG_DENSITY_UNITS_NONE, 1, 1, 3, corpus->rgb);
+  corpus->jpeg_data = ut_uint8_array_new();
+  UtObjectRef jpeg_encoder =
+      ut_jpeg_encoder_new(corpus->jpeg_image, corpus->jpeg_data);
+  ut_jpeg_encoder_encode(jpeg_encoder);
+
+  UtObjectRef quantizer = ut_gif_quantizer_new(IMAGE_WIDTH, IMAGE_HEIGHT, 3);
+  ut_gif_quantizer_add_frame(quantizer, corpus->rgb, 0);
+  corpus->gif_images = ut_object_ref(ut_gif_quantizer_get_images(quantizer));
+  corpus->gif_data = ut_uint8_array_new();
+  UtObjectRef gif_encoder = ut_gif_encoder_new(
+      IMAGE_WIDTH, IMAGE_HEIGHT, NULL, corpus->gif_images, corpus->gif_data);
+  ut_gif_encoder_encode(gif_encoder);
+
+  corpus->tiff_data = generate_tiff(corpus, false);
+  corpus->tiff_deflate_data = generate_tiff(corpus, true);
+
+  UtObjectRef deflate_stream = ut_list_input_stream_new(corpus->text);
+  UtObjectRef deflate_encoder = ut_deflate_encoder_new(deflate_stream);
+  corpus->deflate_data = encode_stream(deflate_encoder);
+  UtObjectRef zlib_stream = ut_list_input_stream_new(corpus->text);
+  UtObjectRef zlib_encoder = ut_zlib_encoder_new(zlib_stream);
+  corpus->zlib_data = encode_stream(zlib_encoder);
+  UtObjectRef gzip_stream = ut_list_input_stream_new(corpus->text);
+  UtObjectRef gzip_encoder = ut_gzip_encoder_new(gzip_stream);
+  corpus->gzip_data = encode_stream(gzip_encoder);
+}
+
+static void free_corpus(Corpus *corpus) {
+  ut_object_unref(corpus->rgb);
+  ut_object_unref(corpus->rgba);
+  ut_object_unref(corpus->text);
+  ut_object_unref(corpus->png_image);
+  ut_object_unref(corpus->png_data);
+  ut_object_unref(corpus->jpeg_image);
+  ut_object_unref(corpus->jpeg_data);
+  ut_object_unref(corpus->gif_images);
+  ut_object_unref(corpus->gif_data);
+  ut_object_unref(corpus->tiff_data);
+  ut_object_unref(corpus->tiff_deflate_data);
+  ut_object_unref(corpus->deflate_data);
+  ut_object_unref(corpus->zlib_data);
+  ut_object_unref(corpus->gzip_data);
+}
+
+static bool write_file(const char *directory, const char *name,
+                       UtObject *data) {
+  ut_cstring_ref path = ut_cstring_new_printf("%s/%s", directory, name);
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to write %s\n", path);
+    return false;
+  }
+  fwrite(ut_uint8_list_get_data(data), 1, ut_list_get_length(data), file);
+  fclose(file);
+  return true;
+}
+
+static bool write_corpus(Corpus *corpus, const char *directory) {
+  return write_file(directory, "corpus.png", corpus->png_data) &&
+         write_file(directory, "corpus.jpg", corpus->jpeg_data) &&
+         write_file(directory, "corpus.gif", corpus->gif_data) &&
+         write_file(directory, "corpus.tif", corpus->tiff_data) &&
+         write_file(directory, "corpus-deflate.tif",
+                    corpus->tiff_deflate_data) &&
+         write_file(directory, "corpus.txt", corpus->text) &&
+         write_file(directory, "corpus.txt.deflate", corpus->deflate_data) &&
+         write_file(directory, "corpus.txt.zlib", corpus->zlib_data) &&
+         write_file(directory, "corpus.txt.gz", corpus->gzip_data);
+}
+
+// Round [value] to three decimal places for output.
+static UtObject *rate_new(double value) {
+  return ut_float64_new(round(value * 1000) / 1000);
+}
+
+static UtObject *run_benchmark(Corpus *corpus, Benchmark *benchmark,
+                               double min_time) {
+  static bool reported_reset_failure = false;
+  bool peak_rss_reset = reset_peak_rss();
+  if (!peak_rss_reset && !reported_reset_failure) {
+    fprintf(stderr, "Unable to reset peak RSS, peak_rss_kb is the peak for "
+                    "the whole process\n");
+    reported_reset_failure = true;
+  }
+  size_t start_rss = get_rss();
+  size_t start_n_allocations = n_allocations;
+  size_t start_n_allocated_bytes = n_allocated_bytes;
+  double start = get_time();
+  size_t n_bytes = benchmark->run(corpus);
+  size_t n_iterations = 1;
+  double duration = get_time() - start;
+
+  // If the first run was quick, treat it as a warm up and repeat until we
+  // have enough samples.
+  if (duration < min_time) {
+    start_n_allocations = n_allocations;
+    start_n_allocated_bytes = n_allocated_bytes;
+    n_bytes = 0;
+    n_iterations = 0;
+    start = get_time();
+    do {
+      n_bytes += benchmark->run(corpus);
+      n_iterations++;
+      duration = get_time() - start;
+    } while (duration < min_time);
+  }
+  size_t peak_rss = get_peak_rss();
+
+  UtObject *result = ut_map_new();
+  ut_map_insert_string_take(result, "name", ut_string_new(benchmark->name));
+  ut_map_insert_string_take(result, "iterations", ut_int64_new(n_iterations));
+  ut_map_insert_string_take(result, "seconds_per_iteration",
+                            ut_float64_new(duration / n_iterations));
+  ut_map_insert_string_take(result, "mb_per_s",
+                            rate_new(n_bytes / duration / 1e6));
+  if (benchmark->n_pixels > 0) {
+    ut_map_insert_string_take(
+        result, "pixels_per_s",
+        rate_new(benchmark->n_pixels * n_iterations / duration));
+  }
+  if (have_allocation_counts) {
+    ut_map_insert_string_take(
+        result, "allocations_per_iteration",
+        ut_int64_new((n_allocations - start_n_allocations) / n_iterations));
+    ut_map_insert_string_take(
+        result, "allocated_bytes_per_iteration",
+        ut_int64_new((n_allocated_bytes - start_n_allocated_bytes) /
+                     n_iterations));
+  }
+  ut_map_insert_string_take(result, "peak_rss_kb", ut_int64_new(peak_rss));
+  ut_map_insert_string_take(result, "peak_rss_reset",
+                            ut_boolean_new(peak_rss_reset));
+  // Without a reset the peak may be from an earlier benchmark, so the growth
+  // isn't known.
+  if (peak_rss_reset && start_rss != 0) {
+    ut_map_insert_string_take(
+        result, "rss_growth_kb",
+        ut_int64_new(peak_rss > start_rss ? peak_rss - start_rss : 0));
+  }
+
+  return result;
+}
+
+static double get_number(UtObject *value) {
+  if (value != NULL && ut_object_is_float64(value)) {
+    return ut_float64_get_value(value);
+  } else if (value != NULL && ut_object_is_int64(value)) {
+    return ut_int64_get_value(value);
+  } else {
+    return 0;
+  }
+}
+
+static UtObject *read_baseline(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open baseline %s\n", path);
+    return NULL;
+  }
+  UtObjectRef text = ut_string_new("");
+  char buffer[4096];
+  size_t n_read;
+  while ((n_read = fread(buffer, 1, sizeof(buffer) - 1, file)) > 0) {
+    buffer[n_read] = '\0';
+    ut_string_append(text, buffer);
+  }
+  fclose(file);
+
+  UtObject *baseline = ut_json_decode(ut_string_get_text(text));
+  if (baseline == NULL || !ut_object_implements_map(baseline) ||
+      ut_map_lookup_string(baseline, "results") == NULL) {
+    fprintf(stderr, "Invalid baseline %s\n", path);
+    ut_object_unref(baseline);
+    return NULL;
+  }
+  return baseline;
+}
+
+static UtObject *lookup_baseline_result(UtObject *baseline, const char *name) {
+  UtObject *results = ut_map_lookup_string(baseline, "results");
+  size_t results_length = ut_list_get_length(results);
+  for (size_t i = 0; i < results_length; i++) {
+    UtObject *result = ut_object_list_get_element(results, i);
+    UtObject *result_name = ut_map_lookup_string(result, "name");
+    if (result_name != NULL && ut_object_implements_string(result_name) &&
+        strcmp(ut_string_get_text(result_name), name) == 0) {
+      return result;
+    }
+  }
+  return NULL;
+}
+
+// Add the change from [baseline] to [result], and return [true] if it is a
+// regression of more than [threshold] percent.
+static bool compare_result(UtObject *result, UtObject *baseline,
+                           double threshold) {
+  UtObject *name = ut_map_lookup_string(result, "name");
+  UtObject *baseline_result =
+      lookup_baseline_result(baseline, ut_string_get_text(name));
+  if (baseline_result == NULL) {
+    return false;
+  }
+
+  double baseline_rate =
+      get_number(ut_map_lookup_string(baseline_result, "mb_per_s"));
+  if (baseline_rate <= 0) {
+    return false;
+  }
+  double rate = get_number(ut_map_lookup_string(result, "mb_per_s"));
+  double change = (rate - baseline_rate) * 100 / baseline_rate;
+  bool is_regression = change < -threshold;
+  ut_map_insert_string_take(result, "baseline_mb_per_s",
+                            rate_new(baseline_rate));
+  ut_map_insert_string_take(result, "change_percent", rate_new(change));
+  ut_map_insert_string_take(result, "regression",
+                            ut_boolean_new(is_regression));
+  return is_regression;
+}
+
+static void print_usage() {
+  fprintf(stderr,
+          "Usage: ut-bench [--min-time SECONDS] [--filter NAME] "
+          "[--baseline FILE]\n"
+          "                [--threshold PERCENT] [--write-corpus "
+          "DIRECTORY]\n");
+}
+
+int main(int argc, char **argv) {
+  double min_time = 1.0;
+  const char *filter = NULL;
+  const char *baseline_path = NULL;
+  double threshold = 10.0;
+  const char *corpus_directory = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) {
+      print_usage();
+      return 2;
+    }
+    if (strcmp(argv[i], "--min-time") == 0) {
+      min_time = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--filter") == 0) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--baseline") == 0) {
+      baseline_path = argv[++i];
+    } else if (strcmp(argv[i], "--threshold") == 0) {
+      threshold = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--write-corpus") == 0) {
+      corpus_directory = argv[++i];
+    } else {
+      print_usage();
+      return 2;
+    }
+  }
+
+  UtObjectRef baseline = NULL;
+  if (baseline_path != NULL) {
+    baseline = read_baseline(baseline_path);
+    if (baseline == NULL) {
+      return 2;
+    }
+  }
+
+  Corpus corpus;
+  generate_corpus(&corpus);
+  if (corpus_directory != NULL && !write_corpus(&corpus, corpus_directory)) {
+    free_corpus(&corpus);
+    return 2;
+  }
+
+  UtObjectRef results = ut_object_list_new();
+  UtObjectRef regressions = ut_object_list_new();
+  size_t n_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+  for (size_t i = 0; i < n_benchmarks; i++) {
+    Benchmark *benchmark = &benchmarks[i];
+    if (filter != NULL && strstr(benchmark->name, filter) == NULL) {
+      continue;
+    }
+
+    UtObjectRef result = run_benchmark(&corpus, benchmark, min_time);
+    if (baseline != NULL && compare_result(result, baseline, threshold)) {
+      ut_list_append_take(regressions, ut_string_new(benchmark->name));
+    }
+    fprintf(stderr, "%-20s %10.3f MB/s\n", benchmark->name,
+            get_number(ut_map_lookup_string(result, "mb_per_s")));
+    ut_list_append(results, result);
+  }
+
+  UtObjectRef corpus_info = ut_map_new();
+  ut_map_insert_string_take(corpus_info, "image_width",
+                            ut_int64_new(IMAGE_WIDTH));
+  ut_map_insert_string_take(corpus_info, "image_height",
+                            ut_int64_new(IMAGE_HEIGHT));
+  ut_map_insert_string_take(corpus_info, "text_bytes",
+                            ut_int64_new(TEXT_LENGTH));
+  UtObjectRef output = ut_map_new();
+  ut_map_insert_string(output, "corpus", corpus_info);
+  ut_map_insert_string(output, "results", results);
+  if (baseline != NULL) {
+    ut_map_insert_string_take(output, "threshold_percent",
+                              ut_float64_new(threshold));
+    ut_map_insert_string(output, "regressions", regressions);
+  }
+  ut_cstring_ref json = ut_json_encode(output);
+  printf("%s\n", json);
+
+  free_corpus(&corpus);
+
+  if (ut_list_get_length(regressions) > 0) {
+    fprintf(stderr, "%zi benchmarks regressed\n",
+            ut_list_get_length(regressions));
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,7 @@
+#include <stdbool.h>
+
+#pragma once
+
+bool _ut_cpu_has_ssse3();
+
+bool _ut_cpu_has_avx2();
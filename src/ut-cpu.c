@@ -0,0 +1,25 @@
+#include <pthread.h>
+
+#include "ut-cpu-private.h"
+
+static bool has_ssse3 = false;
+static bool has_avx2 = false;
+static pthread_once_t features_once = PTHREAD_ONCE_INIT;
+
+static void detect_features() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  has_ssse3 = __builtin_cpu_supports("ssse3");
+  has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool _ut_cpu_has_ssse3() {
+  pthread_once(&features_once, detect_features);
+  return has_ssse3;
+}
+
+bool _ut_cpu_has_avx2() {
+  pthread_once(&features_once, detect_features);
+  return has_avx2;
+}
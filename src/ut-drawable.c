@@ -19,6 +19,29 @@ void ut_drawable_render_box(UtObject *object, double x, double y, double width,
   drawable_interface->render_box(object, x, y, width, height, color);
 }
 
+void ut_drawable_set_clip(UtObject *object, UtObject *rectangles) {
+  UtDrawableInterface *drawable_interface =
+      ut_object_get_interface(object, &ut_drawable_id);
+  assert(drawable_interface != NULL);
+  drawable_interface->set_clip(object, rectangles);
+}
+
+void ut_drawable_fill_rectangles(UtObject *object, UtObject *rectangles,
+                                 UtObject *color, UtDrawableOperator op) {
+  UtDrawableInterface *drawable_interface =
+      ut_object_get_interface(object, &ut_drawable_id);
+  assert(drawable_interface != NULL);
+  drawable_interface->fill_rectangles(object, rectangles, color, op);
+}
+
+void ut_drawable_blit(UtObject *object, UtObject *source, int32_t x, int32_t y,
+                      UtDrawableOperator op) {
+  UtDrawableInterface *drawable_interface =
+      ut_object_get_interface(object, &ut_drawable_id);
+  assert(drawable_interface != NULL);
+  drawable_interface->blit(object, source, x, y, op);
+}
+
 bool ut_object_implements_drawable(UtObject *object) {
   return ut_object_get_interface(object, &ut_drawable_id) != NULL;
 }
@@ -1,13 +1,30 @@
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "ut-object.h"
 
 #pragma once
 
+/// Operator used when compositing onto a drawable.
+/// All colors are treated as having premultiplied alpha.
+/// - [UT_DRAWABLE_OPERATOR_SRC] - Replace the destination.
+/// - [UT_DRAWABLE_OPERATOR_SRC_OVER] - Draw over the destination.
+/// - [UT_DRAWABLE_OPERATOR_ADD] - Add to the destination.
+typedef enum {
+  UT_DRAWABLE_OPERATOR_SRC,
+  UT_DRAWABLE_OPERATOR_SRC_OVER,
+  UT_DRAWABLE_OPERATOR_ADD
+} UtDrawableOperator;
+
 typedef struct {
   void (*clear)(UtObject *object, UtObject *color);
   void (*render_box)(UtObject *object, double x, double y, double width,
                      double height, UtObject *color);
+  void (*set_clip)(UtObject *object, UtObject *rectangles);
+  void (*fill_rectangles)(UtObject *object, UtObject *rectangles,
+                          UtObject *color, UtDrawableOperator op);
+  void (*blit)(UtObject *object, UtObject *source, int32_t x, int32_t y,
+               UtDrawableOperator op);
 } UtDrawableInterface;
 
 extern int ut_drawable_id;
@@ -23,5 +40,25 @@ void ut_drawable_clear(UtObject *object, UtObject *color);
 void ut_drawable_render_box(UtObject *object, double x, double y, double width,
                             double height, UtObject *color);
 
+/// Limit drawing to the area covered by [rectangles], or remove the limit if
+/// [rectangles] is [NULL].
+///
+/// !arg-type rectangles UtObjectList NULL
+void ut_drawable_set_clip(UtObject *object, UtObject *rectangles);
+
+/// Composite [color] onto each of [rectangles] using [op].
+///
+/// !arg-type rectangles UtObjectList
+/// !arg-type color UtColor
+void ut_drawable_fill_rectangles(UtObject *object, UtObject *rectangles,
+                                 UtObject *color, UtDrawableOperator op);
+
+/// Composite the premultiplied RGBA pixels in [source] onto the drawable at
+/// [x],[y] using [op].
+///
+/// !arg-type source UtImageBuffer
+void ut_drawable_blit(UtObject *object, UtObject *source, int32_t x, int32_t y,
+                      UtDrawableOperator op);
+
 /// Returns [true] if [object] is a [UtDrawable].
 bool ut_object_implements_drawable(UtObject *object);
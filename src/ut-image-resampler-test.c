@@ -0,0 +1,245 @@
+#include <stdlib.h>
+
+#include "ut.h"
+
+static void check_resample(size_t width, size_t height, size_t new_width,
+                           size_t new_height, UtImageResamplerFilter filter,
+                           size_t n_channels, const char *hex_data,
+                           const char *expected_hex_data) {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(hex_data);
+  UtObjectRef resampler =
+      ut_image_resampler_new(width, height, new_width, new_height, filter);
+  UtObjectRef result = ut_image_resampler_resample(resampler, data, n_channels,
+                                                   width * n_channels);
+  ut_assert_uint8_list_equal_hex(result, expected_hex_data);
+}
+
+// Create an image with random pixels.
+static UtObject *create_random_image(size_t width, size_t height,
+                                     size_t n_channels) {
+  UtObject *data = ut_uint8_array_new_sized(width * height * n_channels);
+  uint8_t *d = ut_uint8_list_get_writable_data(data);
+  for (size_t i = 0; i < width * height * n_channels; i++) {
+    d[i] = rand();
+  }
+  return data;
+}
+
+// Check the same results are generated for each channel count and number of
+// threads.
+static void check_consistent(UtImageResamplerFilter filter) {
+  size_t width = 97, height = 61, new_width = 37, new_height = 83;
+  UtObjectRef rgba = create_random_image(width, height, 4);
+  UtObjectRef rgb = ut_uint8_array_new();
+  const uint8_t *rgba_data = ut_uint8_list_get_data(rgba);
+  for (size_t i = 0; i < width * height; i++) {
+    ut_uint8_list_append_block(rgb, rgba_data + i * 4, 3);
+  }
+
+  UtObjectRef resampler =
+      ut_image_resampler_new(width, height, new_width, new_height, filter);
+  UtObjectRef rgba_result =
+      ut_image_resampler_resample(resampler, rgba, 4, width * 4);
+  UtObjectRef rgb_result =
+      ut_image_resampler_resample(resampler, rgb, 3, width * 3);
+  const uint8_t *rgba_result_data = ut_uint8_list_get_data(rgba_result);
+  const uint8_t *rgb_result_data = ut_uint8_list_get_data(rgb_result);
+  for (size_t i = 0; i < new_width * new_height; i++) {
+    for (size_t c = 0; c < 3; c++) {
+      ut_assert_int_equal(rgba_result_data[i * 4 + c],
+                          rgb_result_data[i * 3 + c]);
+    }
+  }
+
+  ut_image_resampler_set_n_threads(resampler, 4);
+  UtObjectRef threaded_result =
+      ut_image_resampler_resample(resampler, rgba, 4, width * 4);
+  ut_assert_equal(threaded_result, rgba_result);
+}
+
+static void test_resample() {
+  // Same size is unchanged.
+  check_resample(3, 2, 3, 2, UT_IMAGE_RESAMPLER_FILTER_BOX, 3,
+                 "ff000000ff000000ffffffff000000808080",
+                 "ff000000ff000000ffffffff000000808080");
+  check_resample(3, 2, 3, 2, UT_IMAGE_RESAMPLER_FILTER_BILINEAR, 3,
+                 "ff000000ff000000ffffffff000000808080",
+                 "ff000000ff000000ffffffff000000808080");
+  check_resample(3, 2, 3, 2, UT_IMAGE_RESAMPLER_FILTER_LANCZOS3, 3,
+                 "ff000000ff000000ffffffff000000808080",
+                 "ff000000ff000000ffffffff000000808080");
+
+  // Box filter averages pixels.
+  check_resample(4, 2, 2, 1, UT_IMAGE_RESAMPLER_FILTER_BOX, 1,
+                 "0010203040506070", "2848");
+
+  // Bilinear interpolates between pixels.
+  check_resample(2, 1, 4, 1, UT_IMAGE_RESAMPLER_FILTER_BILINEAR, 1, "00ff",
+                 "0040bfff");
+
+  // Lanczos overshoot is clamped.
+  check_resample(4, 1, 8, 1, UT_IMAGE_RESAMPLER_FILTER_LANCZOS3, 1, "0000ffff",
+                 "0a000036c9fffff5");
+
+  check_consistent(UT_IMAGE_RESAMPLER_FILTER_BOX);
+  check_consistent(UT_IMAGE_RESAMPLER_FILTER_BILINEAR);
+  check_consistent(UT_IMAGE_RESAMPLER_FILTER_LANCZOS3);
+}
+
+static void test_resample_image() {
+  UtObjectRef resampler = ut_image_resampler_new(
+      16, 8, 5, 3, UT_IMAGE_RESAMPLER_FILTER_LANCZOS3);
+
+  UtObjectRef buffer = ut_rgba8888_buffer_new(16, 8);
+  UtObjectRef color = ut_color_new_rgba(1.0, 0.5, 0.0, 1.0);
+  ut_drawable_clear(buffer, color);
+  UtObjectRef new_buffer =
+      ut_image_resampler_resample_image(resampler, buffer);
+  ut_assert_true(ut_object_is_rgba8888_buffer(new_buffer));
+  ut_assert_int_equal(ut_image_buffer_get_width(new_buffer), 5);
+  ut_assert_int_equal(ut_image_buffer_get_height(new_buffer), 3);
+  const uint8_t *buffer_data =
+      ut_uint8_list_get_data(ut_image_buffer_get_data(new_buffer));
+  for (size_t i = 0; i < 5 * 3; i++) {
+    ut_assert_int_equal(buffer_data[i * 4 + 0], 0xff);
+    ut_assert_int_equal(buffer_data[i * 4 + 1], 0x7f);
+    ut_assert_int_equal(buffer_data[i * 4 + 2], 0x00);
+    ut_assert_int_equal(buffer_data[i * 4 + 3], 0xff);
+  }
+
+  UtObjectRef jpeg_data = create_random_image(16, 8, 3);
+  UtObjectRef jpeg_image = ut_jpeg_image_new(
+      16, 8, UT_JPEG_DENSITY_UNITS_DOTS_PER_INCH, 72, 72, 3, jpeg_data);
+  UtObjectRef new_jpeg_image =
+      ut_image_resampler_resample_image(resampler, jpeg_image);
+  ut_assert_true(ut_object_is_jpeg_image(new_jpeg_image));
+  ut_assert_int_equal(ut_jpeg_image_get_width(new_jpeg_image), 5);
+  ut_assert_int_equal(ut_jpeg_image_get_height(new_jpeg_image), 3);
+  ut_assert_int_equal(ut_jpeg_image_get_n_components(new_jpeg_image), 3);
+  ut_assert_int_equal(
+      ut_jpeg_image_get_horizontal_pixel_density(new_jpeg_image), 72);
+
+  // Indexed images are converted to RGBA.
+  UtObjectRef png_data = ut_uint8_array_new_sized(16 * 8);
+  UtObjectRef png_image = ut_png_image_new(
+      16, 8, 8, UT_PNG_COLOR_TYPE_INDEXED_COLOR, png_data);
+  UtObjectRef palette = ut_uint8_list_new_from_hex_string("204060");
+  ut_png_image_set_palette(png_image, palette);
+  UtObjectRef new_png_image =
+      ut_image_resampler_resample_image(resampler, png_image);
+  ut_assert_true(ut_object_is_png_image(new_png_image));
+  ut_assert_int_equal(ut_png_image_get_color_type(new_png_image),
+                      UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA);
+  ut_assert_int_equal(ut_png_image_get_width(new_png_image), 5);
+  ut_assert_int_equal(ut_png_image_get_height(new_png_image), 3);
+  const uint8_t *png_image_data =
+      ut_uint8_list_get_data(ut_png_image_get_data(new_png_image));
+  for (size_t i = 0; i < 5 * 3; i++) {
+    ut_assert_int_equal(png_image_data[i * 4 + 0], 0x20);
+    ut_assert_int_equal(png_image_data[i * 4 + 1], 0x40);
+    ut_assert_int_equal(png_image_data[i * 4 + 2], 0x60);
+    ut_assert_int_equal(png_image_data[i * 4 + 3], 0xff);
+  }
+
+  UtObjectRef tiff_data = create_random_image(16, 8, 1);
+  UtObjectRef tiff_image = ut_tiff_image_new(
+      16, 8, UT_TIFF_PHOTOMETRIC_INTERPRETATION_BLACK_IS_ZERO,
+      UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 8, 1, tiff_data);
+  UtObjectRef new_tiff_image =
+      ut_image_resampler_resample_image(resampler, tiff_image);
+  ut_assert_true(ut_object_is_tiff_image(new_tiff_image));
+  ut_assert_int_equal(ut_tiff_image_get_width(new_tiff_image), 5);
+  ut_assert_int_equal(ut_tiff_image_get_length(new_tiff_image), 3);
+  ut_assert_int_equal(
+      ut_list_get_length(ut_tiff_image_get_data(new_tiff_image)), 5 * 3);
+}
+
+// Check transparent pixels don't change the color of visible ones.
+static void check_straight_alpha(UtObject *data, size_t n_channels) {
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  size_t length = ut_list_get_length(data);
+  for (size_t i = 0; i < length; i += n_channels) {
+    uint8_t alpha = d[i + n_channels - 1];
+    if (alpha == 0) {
+      continue;
+    }
+    if (n_channels == 4) {
+      ut_assert_int_equal(d[i + 0], 0x00);
+      ut_assert_int_equal(d[i + 1], 0x00);
+      ut_assert_int_equal(d[i + 2], 0xff);
+    } else {
+      ut_assert_int_equal(d[i + 0], 0xff);
+    }
+  }
+}
+
+static void test_straight_alpha() {
+  // Transparent red on the left, opaque blue on the right.
+  UtObjectRef rgba_data = ut_uint8_array_new_sized(8 * 2 * 4);
+  uint8_t *rgba = ut_uint8_list_get_writable_data(rgba_data);
+  for (size_t i = 0; i < 8 * 2; i++) {
+    bool visible = i % 8 >= 4;
+    rgba[i * 4 + 0] = visible ? 0x00 : 0xff;
+    rgba[i * 4 + 1] = 0x00;
+    rgba[i * 4 + 2] = visible ? 0xff : 0x00;
+    rgba[i * 4 + 3] = visible ? 0xff : 0x00;
+  }
+
+  // Transparent black on the left, opaque white on the right.
+  UtObjectRef grey_alpha_data = ut_uint8_array_new_sized(8 * 2 * 2);
+  uint8_t *grey_alpha = ut_uint8_list_get_writable_data(grey_alpha_data);
+  for (size_t i = 0; i < 8 * 2; i++) {
+    bool visible = i % 8 >= 4;
+    grey_alpha[i * 2 + 0] = visible ? 0xff : 0x00;
+    grey_alpha[i * 2 + 1] = visible ? 0xff : 0x00;
+  }
+
+  UtImageResamplerFilter filters[] = {UT_IMAGE_RESAMPLER_FILTER_BOX,
+                                      UT_IMAGE_RESAMPLER_FILTER_BILINEAR,
+                                      UT_IMAGE_RESAMPLER_FILTER_LANCZOS3};
+  for (size_t i = 0; i < 3; i++) {
+    UtObjectRef resampler = ut_image_resampler_new(8, 2, 13, 3, filters[i]);
+
+    UtObjectRef png_image = ut_png_image_new(
+        8, 2, 8, UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA, rgba_data);
+    UtObjectRef new_png_image =
+        ut_image_resampler_resample_image(resampler, png_image);
+    check_straight_alpha(ut_png_image_get_data(new_png_image), 4);
+
+    UtObjectRef grey_png_image = ut_png_image_new(
+        8, 2, 8, UT_PNG_COLOR_TYPE_GREYSCALE_WITH_ALPHA, grey_alpha_data);
+    UtObjectRef new_grey_png_image =
+        ut_image_resampler_resample_image(resampler, grey_png_image);
+    check_straight_alpha(ut_png_image_get_data(new_grey_png_image), 2);
+
+    UtObjectRef tiff_image = ut_tiff_image_new(
+        8, 2, UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB,
+        UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 8, 4, rgba_data);
+    UtObjectRef new_tiff_image =
+        ut_image_resampler_resample_image(resampler, tiff_image);
+    check_straight_alpha(ut_tiff_image_get_data(new_tiff_image), 4);
+  }
+
+  // The edge is half transparent.
+  UtObjectRef resampler =
+      ut_image_resampler_new(8, 2, 2, 1, UT_IMAGE_RESAMPLER_FILTER_BOX);
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(
+      "ff000000ff000000ff0000000000ffff"
+      "0000ffff0000ffff0000ffff0000ffff"
+      "ff000000ff000000ff0000000000ffff"
+      "0000ffff0000ffff0000ffff0000ffff");
+  UtObjectRef png_image = ut_png_image_new(
+      8, 2, 8, UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA, data);
+  UtObjectRef new_png_image =
+      ut_image_resampler_resample_image(resampler, png_image);
+  ut_assert_uint8_list_equal_hex(ut_png_image_get_data(new_png_image),
+                                 "0000ff400000ffff");
+}
+
+int main(int argc, char **argv) {
+  test_resample();
+  test_resample_image();
+  test_straight_alpha();
+
+  return 0;
+}
@@ -0,0 +1,593 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ut-cpu-private.h"
+#include "ut-parallel-private.h"
+#include "ut.h"
+
+// Filter weights are fixed point with this many fractional bits.
+#define WEIGHT_BITS 14
+
+#define PI 3.14159265358979323846
+
+// Weights to generate each output pixel from a range of input pixels along
+// one axis.
+typedef struct {
+  // First input pixel used for each output pixel.
+  size_t *starts;
+
+  // Number of input pixels used for each output pixel.
+  size_t *n_taps;
+
+  // Weights for each output pixel, [max_taps] per pixel.
+  int16_t *weights;
+  size_t max_taps;
+} Coefficients;
+
+// Function to filter a row of [n_channels] pixels horizontally.
+typedef void (*HorizontalFunction)(const Coefficients *coefficients,
+                                   size_t length, const uint8_t *input,
+                                   size_t n_channels, uint8_t *output);
+
+// Function to combine [n_rows] [rows] of [length] bytes using [weights].
+typedef void (*VerticalFunction)(const uint8_t **rows, const int16_t *weights,
+                                 size_t n_rows, uint8_t *output,
+                                 size_t length);
+
+typedef struct {
+  UtObject object;
+
+  // Dimensions of the input and output images.
+  size_t width;
+  size_t height;
+  size_t new_width;
+  size_t new_height;
+
+  // Coefficients for each axis.
+  Coefficients horizontal;
+  Coefficients vertical;
+
+  // Number of threads to resample with.
+  size_t n_threads;
+} UtImageResampler;
+
+// Work done on a thread when resampling a band of rows.
+typedef struct {
+  UtImageResampler *self;
+
+  const uint8_t *input;
+  size_t row_stride;
+  size_t n_channels;
+  uint8_t *output;
+
+  // Output rows to generate.
+  size_t y_start;
+  size_t y_end;
+} ResampleWorker;
+
+static double sinc(double x) {
+  if (x == 0.0) {
+    return 1.0;
+  }
+  x *= PI;
+  return sin(x) / x;
+}
+
+static double get_filter_support(UtImageResamplerFilter filter) {
+  switch (filter) {
+  case UT_IMAGE_RESAMPLER_FILTER_BOX:
+    return 0.5;
+  case UT_IMAGE_RESAMPLER_FILTER_BILINEAR:
+    return 1.0;
+  case UT_IMAGE_RESAMPLER_FILTER_LANCZOS3:
+    return 3.0;
+  }
+
+  return 0.0;
+}
+
+static double apply_filter(UtImageResamplerFilter filter, double x) {
+  switch (filter) {
+  case UT_IMAGE_RESAMPLER_FILTER_BOX:
+    return x >= -0.5 && x < 0.5 ? 1.0 : 0.0;
+  case UT_IMAGE_RESAMPLER_FILTER_BILINEAR:
+    x = fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+  case UT_IMAGE_RESAMPLER_FILTER_LANCZOS3:
+    return x > -3.0 && x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+  }
+
+  return 0.0;
+}
+
+// Calculate the weights to scale [length] pixels to [new_length].
+static void make_coefficients(Coefficients *coefficients, size_t length,
+                              size_t new_length,
+                              UtImageResamplerFilter filter) {
+  // When reducing, the filter is stretched to cover all the input pixels.
+  double scale = (double)length / new_length;
+  double filter_scale = scale > 1.0 ? scale : 1.0;
+  double support = get_filter_support(filter) * filter_scale;
+
+  coefficients->max_taps = (size_t)ceil(support * 2) + 1;
+  coefficients->starts = malloc(sizeof(size_t) * new_length);
+  coefficients->n_taps = malloc(sizeof(size_t) * new_length);
+  coefficients->weights =
+      calloc(new_length * coefficients->max_taps, sizeof(int16_t));
+  double *weights = malloc(sizeof(double) * coefficients->max_taps);
+
+  for (size_t i = 0; i < new_length; i++) {
+    double center = (i + 0.5) * scale;
+    double first = floor(center - support);
+    double last = ceil(center + support);
+    size_t start = first < 0 ? 0 : first;
+    size_t end = last > length ? length : last;
+    if (end - start > coefficients->max_taps) {
+      end = start + coefficients->max_taps;
+    }
+
+    double total = 0.0;
+    for (size_t j = start; j < end; j++) {
+      weights[j - start] =
+          apply_filter(filter, (j + 0.5 - center) / filter_scale);
+      total += weights[j - start];
+    }
+
+    // Trim unused pixels from each end.
+    size_t n_taps = end - start;
+    while (n_taps > 1 && weights[n_taps - 1] == 0.0) {
+      n_taps--;
+    }
+    size_t offset = 0;
+    while (offset < n_taps - 1 && weights[offset] == 0.0) {
+      offset++;
+    }
+
+    // Convert to fixed point, making sure the weights sum to exactly one.
+    int16_t *fixed_weights =
+        coefficients->weights + i * coefficients->max_taps;
+    if (total == 0.0) {
+      size_t nearest = center < length ? center : length - 1;
+      coefficients->starts[i] = nearest;
+      coefficients->n_taps[i] = 1;
+      fixed_weights[0] = 1 << WEIGHT_BITS;
+      continue;
+    }
+    int fixed_total = 0;
+    size_t largest = 0;
+    for (size_t j = 0; j < n_taps - offset; j++) {
+      fixed_weights[j] =
+          (int16_t)lround(weights[offset + j] / total * (1 << WEIGHT_BITS));
+      fixed_total += fixed_weights[j];
+      if (fixed_weights[j] > fixed_weights[largest]) {
+        largest = j;
+      }
+    }
+    fixed_weights[largest] += (1 << WEIGHT_BITS) - fixed_total;
+
+    coefficients->starts[i] = start + offset;
+    coefficients->n_taps[i] = n_taps - offset;
+  }
+
+  free(weights);
+}
+
+static void free_coefficients(Coefficients *coefficients) {
+  free(coefficients->starts);
+  free(coefficients->n_taps);
+  free(coefficients->weights);
+}
+
+static uint8_t round_sample(int32_t value) {
+  value >>= WEIGHT_BITS;
+  return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static void horizontal_scalar(const Coefficients *coefficients, size_t length,
+                              const uint8_t *input, size_t n_channels,
+                              uint8_t *output) {
+  for (size_t x = 0; x < length; x++) {
+    const int16_t *weights =
+        coefficients->weights + x * coefficients->max_taps;
+    const uint8_t *in = input + coefficients->starts[x] * n_channels;
+    size_t n_taps = coefficients->n_taps[x];
+    for (size_t c = 0; c < n_channels; c++) {
+      int32_t value = 1 << (WEIGHT_BITS - 1);
+      for (size_t i = 0; i < n_taps; i++) {
+        value += weights[i] * in[i * n_channels + c];
+      }
+      output[x * n_channels + c] = round_sample(value);
+    }
+  }
+}
+
+static void vertical_scalar(const uint8_t **rows, const int16_t *weights,
+                            size_t n_rows, uint8_t *output, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    int32_t value = 1 << (WEIGHT_BITS - 1);
+    for (size_t j = 0; j < n_rows; j++) {
+      value += weights[j] * rows[j][i];
+    }
+    output[i] = round_sample(value);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Filter RGBA pixels, multiplying two input pixels at a time.
+__attribute__((target("avx2"))) static void
+horizontal_avx2(const Coefficients *coefficients, size_t length,
+                const uint8_t *input, size_t n_channels, uint8_t *output) {
+  if (n_channels != 4) {
+    horizontal_scalar(coefficients, length, input, n_channels, output);
+    return;
+  }
+
+  // Interleave the channels of two pixels into 16 bit values.
+  const __m128i interleave = _mm_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1,
+                                           6, -1, 3, -1, 7, -1);
+  const __m128i round = _mm_set1_epi32(1 << (WEIGHT_BITS - 1));
+  for (size_t x = 0; x < length; x++) {
+    const int16_t *weights =
+        coefficients->weights + x * coefficients->max_taps;
+    const uint8_t *in = input + coefficients->starts[x] * 4;
+    size_t n_taps = coefficients->n_taps[x];
+    __m128i sum = round;
+    size_t i = 0;
+    for (; i + 2 <= n_taps; i += 2) {
+      __m128i pixels = _mm_shuffle_epi8(
+          _mm_loadl_epi64((const __m128i *)(in + i * 4)), interleave);
+      __m128i w = _mm_set1_epi32((uint16_t)weights[i] |
+                                 ((uint32_t)(uint16_t)weights[i + 1] << 16));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, w));
+    }
+    if (i < n_taps) {
+      int32_t pixel;
+      memcpy(&pixel, in + i * 4, 4);
+      __m128i pixels =
+          _mm_shuffle_epi8(_mm_cvtsi32_si128(pixel), interleave);
+      __m128i w = _mm_set1_epi32((uint16_t)weights[i]);
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, w));
+    }
+    sum = _mm_srai_epi32(sum, WEIGHT_BITS);
+    sum = _mm_packus_epi16(_mm_packs_epi32(sum, sum), sum);
+    int32_t result = _mm_cvtsi128_si32(sum);
+    memcpy(output + x * 4, &result, 4);
+  }
+}
+
+// Combine rows 16 bytes at a time, multiplying two rows at a time.
+__attribute__((target("avx2"))) static void
+vertical_avx2(const uint8_t **rows, const int16_t *weights, size_t n_rows,
+              uint8_t *output, size_t length) {
+  const __m256i round = _mm256_set1_epi32(1 << (WEIGHT_BITS - 1));
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m256i sum_low = round, sum_high = round;
+    size_t j = 0;
+    for (; j < n_rows; j += 2) {
+      __m256i a = _mm256_cvtepu8_epi16(
+          _mm_loadu_si128((const __m128i *)(rows[j] + i)));
+      __m256i b = _mm256_setzero_si256();
+      uint32_t w = (uint16_t)weights[j];
+      if (j + 1 < n_rows) {
+        b = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(rows[j + 1] + i)));
+        w |= (uint32_t)(uint16_t)weights[j + 1] << 16;
+      }
+      __m256i wp = _mm256_set1_epi32(w);
+      sum_low = _mm256_add_epi32(
+          sum_low, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), wp));
+      sum_high = _mm256_add_epi32(
+          sum_high, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), wp));
+    }
+    sum_low = _mm256_srai_epi32(sum_low, WEIGHT_BITS);
+    sum_high = _mm256_srai_epi32(sum_high, WEIGHT_BITS);
+    __m256i values = _mm256_packs_epi32(sum_low, sum_high);
+    values = _mm256_packus_epi16(values, values);
+    values = _mm256_permute4x64_epi64(values, 0x08);
+    _mm_storeu_si128((__m128i *)(output + i), _mm256_castsi256_si128(values));
+  }
+
+  for (; i < length; i++) {
+    int32_t value = 1 << (WEIGHT_BITS - 1);
+    for (size_t j = 0; j < n_rows; j++) {
+      value += weights[j] * rows[j][i];
+    }
+    output[i] = round_sample(value);
+  }
+}
+#endif
+
+static HorizontalFunction horizontal_function = NULL;
+static VerticalFunction vertical_function = NULL;
+static pthread_once_t functions_once = PTHREAD_ONCE_INIT;
+
+// Choose the fastest filters the CPU supports.
+static void select_functions() {
+  HorizontalFunction h = horizontal_scalar;
+  VerticalFunction v = vertical_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+  if (_ut_cpu_has_avx2()) {
+    h = horizontal_avx2;
+    v = vertical_avx2;
+  }
+#endif
+
+  vertical_function = v;
+  horizontal_function = h;
+}
+
+static void resample_rows_cb(void *data) {
+  ResampleWorker *worker = data;
+  UtImageResampler *self = worker->self;
+  const Coefficients *vertical = &self->vertical;
+
+  // Filter horizontally the input rows needed for this band.
+  size_t first_row = vertical->starts[worker->y_start];
+  size_t end_row = first_row;
+  for (size_t y = worker->y_start; y < worker->y_end; y++) {
+    size_t end = vertical->starts[y] + vertical->n_taps[y];
+    end_row = end > end_row ? end : end_row;
+  }
+  size_t new_row_stride = self->new_width * worker->n_channels;
+  uint8_t *rows = malloc((end_row - first_row) * new_row_stride);
+  for (size_t y = first_row; y < end_row; y++) {
+    horizontal_function(&self->horizontal, self->new_width,
+                        worker->input + y * worker->row_stride,
+                        worker->n_channels,
+                        rows + (y - first_row) * new_row_stride);
+  }
+
+  // Combine them vertically.
+  const uint8_t **taps = malloc(sizeof(uint8_t *) * vertical->max_taps);
+  for (size_t y = worker->y_start; y < worker->y_end; y++) {
+    size_t n_taps = vertical->n_taps[y];
+    for (size_t i = 0; i < n_taps; i++) {
+      taps[i] = rows + (vertical->starts[y] + i - first_row) * new_row_stride;
+    }
+    vertical_function(taps, vertical->weights + y * vertical->max_taps, n_taps,
+                      worker->output + y * new_row_stride, new_row_stride);
+  }
+
+  free(taps);
+  free(rows);
+}
+
+// Resample [input] into [output] in bands of rows.
+static void resample(UtImageResampler *self, const uint8_t *input,
+                     size_t n_channels, size_t row_stride, uint8_t *output) {
+  pthread_once(&functions_once, select_functions);
+
+  size_t n_workers =
+      _ut_parallel_get_n_workers(self->n_threads, self->new_height);
+  ResampleWorker *workers = calloc(n_workers, sizeof(ResampleWorker));
+  for (size_t i = 0; i < n_workers; i++) {
+    ResampleWorker *worker = &workers[i];
+    worker->self = self;
+    worker->input = input;
+    worker->row_stride = row_stride;
+    worker->n_channels = n_channels;
+    worker->output = output;
+    worker->y_start = i * self->new_height / n_workers;
+    worker->y_end = (i + 1) * self->new_height / n_workers;
+  }
+
+  _ut_parallel_run(workers, sizeof(ResampleWorker), n_workers,
+                   resample_rows_cb);
+  free(workers);
+}
+
+// Resample [data] into a new list.
+static UtObject *resample_data(UtImageResampler *self, UtObject *data,
+                               size_t n_channels, size_t row_stride) {
+  assert(row_stride >= self->width * n_channels);
+  assert(ut_list_get_length(data) >=
+         (self->height - 1) * row_stride + self->width * n_channels);
+
+  const uint8_t *input = ut_uint8_list_get_data(data);
+  UtObjectRef input_array = NULL;
+  if (input == NULL) {
+    input_array = ut_uint8_list_get_array(data);
+    input = ut_uint8_list_get_data(input_array);
+  }
+
+  UtObject *output = ut_uint8_array_new_sized(self->new_width *
+                                              self->new_height * n_channels);
+  resample(self, input, n_channels, row_stride,
+           ut_uint8_list_get_writable_data(output));
+  return output;
+}
+
+// Resample [data] in [format], which has straight alpha. The pixels are
+// premultiplied while filtering, otherwise the color of transparent pixels
+// bleeds into the visible pixels next to them.
+static UtObject *resample_straight_alpha(UtImageResampler *self,
+                                         UtObject *data, UtPixelFormat format,
+                                         size_t row_stride) {
+  UtObjectRef premultiply_converter =
+      ut_pixel_converter_new(format, UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8);
+  UtObjectRef premultiplied_data = ut_pixel_converter_convert(
+      premultiply_converter, data, self->width, self->height, row_stride);
+  UtObjectRef new_premultiplied_data =
+      resample_data(self, premultiplied_data, 4, self->width * 4);
+  UtObjectRef unpremultiply_converter =
+      ut_pixel_converter_new(UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8, format);
+  return ut_pixel_converter_convert(
+      unpremultiply_converter, new_premultiplied_data, self->new_width,
+      self->new_height, self->new_width * 4);
+}
+
+static UtObject *resample_rgba8888_buffer(UtImageResampler *self,
+                                          UtObject *buffer) {
+  UtObject *new_buffer =
+      ut_rgba8888_buffer_new(self->new_width, self->new_height);
+  UtObject *data = ut_image_buffer_get_data(buffer);
+  UtObject *new_data = ut_image_buffer_get_data(new_buffer);
+  resample(self, ut_uint8_list_get_data(data), 4, self->width * 4,
+           ut_uint8_list_get_writable_data(new_data));
+  return new_buffer;
+}
+
+static UtObject *resample_jpeg_image(UtImageResampler *self, UtObject *image) {
+  size_t n_components = ut_jpeg_image_get_n_components(image);
+  UtObjectRef data =
+      resample_data(self, ut_jpeg_image_get_data(image), n_components,
+                    self->width * n_components);
+  return ut_jpeg_image_new(self->new_width, self->new_height,
+                           ut_jpeg_image_get_density_units(image),
+                           ut_jpeg_image_get_horizontal_pixel_density(image),
+                           ut_jpeg_image_get_vertical_pixel_density(image),
+                           n_components, data);
+}
+
+static UtObject *resample_png_image(UtImageResampler *self, UtObject *image) {
+  UtPngColorType color_type = ut_png_image_get_color_type(image);
+  if (ut_png_image_get_bit_depth(image) == 8 &&
+      color_type != UT_PNG_COLOR_TYPE_INDEXED_COLOR) {
+    UtObject *data = ut_png_image_get_data(image);
+    size_t row_stride = ut_png_image_get_row_stride(image);
+    UtObjectRef new_data = NULL;
+    if (color_type == UT_PNG_COLOR_TYPE_GREYSCALE_WITH_ALPHA ||
+        color_type == UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA) {
+      new_data = resample_straight_alpha(
+          self, data, ut_png_image_get_pixel_format(image), row_stride);
+    } else {
+      new_data = resample_data(self, data, ut_png_image_get_n_channels(image),
+                               row_stride);
+    }
+    return ut_png_image_new(self->new_width, self->new_height, 8, color_type,
+                            new_data);
+  }
+
+  UtObjectRef rgba = ut_png_image_to_rgba(image);
+  UtObjectRef data = resample_straight_alpha(self, rgba, UT_PIXEL_FORMAT_RGBA8,
+                                             self->width * 4);
+  return ut_png_image_new(self->new_width, self->new_height, 8,
+                          UT_PNG_COLOR_TYPE_TRUECOLOR_WITH_ALPHA, data);
+}
+
+static UtObject *resample_tiff_image(UtImageResampler *self, UtObject *image) {
+  UtTiffPhotometricInterpretation photometric_interpretation =
+      ut_tiff_image_get_photometric_interpretation(image);
+  if (ut_tiff_image_get_bits_per_sample(image) != 8 ||
+      ut_tiff_image_get_planar_configuration(image) !=
+          UT_TIFF_PLANAR_CONFIGURATION_CHUNKY ||
+      photometric_interpretation ==
+          UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB_PALETTE) {
+    return NULL;
+  }
+
+  // Extra samples are treated as straight alpha.
+  uint16_t samples_per_pixel = ut_tiff_image_get_samples_per_pixel(image);
+  UtObject *data = ut_tiff_image_get_data(image);
+  if (data == NULL) {
+    return NULL;
+  }
+  size_t row_stride = ut_tiff_image_get_row_stride(image);
+  UtObjectRef new_data = NULL;
+  if (photometric_interpretation == UT_TIFF_PHOTOMETRIC_INTERPRETATION_RGB &&
+      samples_per_pixel == 4) {
+    new_data = resample_straight_alpha(self, data, UT_PIXEL_FORMAT_RGBA8,
+                                       row_stride);
+  } else if (photometric_interpretation ==
+                 UT_TIFF_PHOTOMETRIC_INTERPRETATION_BLACK_IS_ZERO &&
+             samples_per_pixel == 2) {
+    new_data = resample_straight_alpha(self, data,
+                                       UT_PIXEL_FORMAT_GREY_ALPHA8, row_stride);
+  } else {
+    new_data = resample_data(self, data, samples_per_pixel, row_stride);
+  }
+  return ut_tiff_image_new(self->new_width, self->new_height,
+                           photometric_interpretation,
+                           UT_TIFF_PLANAR_CONFIGURATION_CHUNKY, 8,
+                           samples_per_pixel, new_data);
+}
+
+static void ut_image_resampler_init(UtObject *object) {
+  UtImageResampler *self = (UtImageResampler *)object;
+  self->n_threads = 1;
+}
+
+static void ut_image_resampler_cleanup(UtObject *object) {
+  UtImageResampler *self = (UtImageResampler *)object;
+  free_coefficients(&self->horizontal);
+  free_coefficients(&self->vertical);
+}
+
+static UtObjectInterface object_interface = {
+    .type_name = "UtImageResampler",
+    .init = ut_image_resampler_init,
+    .cleanup = ut_image_resampler_cleanup};
+
+UtObject *ut_image_resampler_new(size_t width, size_t height, size_t new_width,
+                                 size_t new_height,
+                                 UtImageResamplerFilter filter) {
+  assert(width > 0 && height > 0);
+  assert(new_width > 0 && new_height > 0);
+
+  UtObject *object =
+      ut_object_new(sizeof(UtImageResampler), &object_interface);
+  UtImageResampler *self = (UtImageResampler *)object;
+  self->width = width;
+  self->height = height;
+  self->new_width = new_width;
+  self->new_height = new_height;
+  make_coefficients(&self->horizontal, width, new_width, filter);
+  make_coefficients(&self->vertical, height, new_height, filter);
+  return object;
+}
+
+void ut_image_resampler_set_n_threads(UtObject *object, size_t n_threads) {
+  assert(ut_object_is_image_resampler(object));
+  UtImageResampler *self = (UtImageResampler *)object;
+  assert(n_threads > 0);
+  self->n_threads = n_threads;
+}
+
+UtObject *ut_image_resampler_resample(UtObject *object, UtObject *data,
+                                      size_t n_channels, size_t row_stride) {
+  assert(ut_object_is_image_resampler(object));
+  UtImageResampler *self = (UtImageResampler *)object;
+  assert(n_channels > 0);
+  return resample_data(self, data, n_channels, row_stride);
+}
+
+UtObject *ut_image_resampler_resample_image(UtObject *object,
+                                            UtObject *image) {
+  assert(ut_object_is_image_resampler(object));
+  UtImageResampler *self = (UtImageResampler *)object;
+
+  if (ut_object_is_rgba8888_buffer(image)) {
+    assert(ut_image_buffer_get_width(image) == self->width &&
+           ut_image_buffer_get_height(image) == self->height);
+    return resample_rgba8888_buffer(self, image);
+  } else if (ut_object_is_jpeg_image(image)) {
+    assert(ut_jpeg_image_get_width(image) == self->width &&
+           ut_jpeg_image_get_height(image) == self->height);
+    assert(self->new_width <= UINT16_MAX && self->new_height <= UINT16_MAX);
+    return resample_jpeg_image(self, image);
+  } else if (ut_object_is_png_image(image)) {
+    assert(ut_png_image_get_width(image) == self->width &&
+           ut_png_image_get_height(image) == self->height);
+    return resample_png_image(self, image);
+  } else if (ut_object_is_tiff_image(image)) {
+    assert(ut_tiff_image_get_width(image) == self->width &&
+           ut_tiff_image_get_length(image) == self->height);
+    return resample_tiff_image(self, image);
+  }
+
+  assert(false);
+  return NULL;
+}
+
+bool ut_object_is_image_resampler(UtObject *object) {
+  return ut_object_is_type(object, &object_interface);
+}
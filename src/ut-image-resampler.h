@@ -0,0 +1,58 @@
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ut-object.h"
+
+#pragma once
+
+/// Filter used when resampling images:
+/// - [UT_IMAGE_RESAMPLER_FILTER_BOX] - average of the pixels covered.
+/// - [UT_IMAGE_RESAMPLER_FILTER_BILINEAR] - linear interpolation.
+/// - [UT_IMAGE_RESAMPLER_FILTER_LANCZOS3] - Lanczos filter with three lobes.
+typedef enum {
+  UT_IMAGE_RESAMPLER_FILTER_BOX,
+  UT_IMAGE_RESAMPLER_FILTER_BILINEAR,
+  UT_IMAGE_RESAMPLER_FILTER_LANCZOS3
+} UtImageResamplerFilter;
+
+/// Creates a new resampler that scales images of [width]x[height] pixels to
+/// [new_width]x[new_height] pixels using [filter].
+/// The filter coefficients are calculated once, so the resampler can be reused
+/// for multiple images of the same size.
+///
+/// !return-ref
+/// !return-type UtImageResampler
+UtObject *ut_image_resampler_new(size_t width, size_t height, size_t new_width,
+                                 size_t new_height,
+                                 UtImageResamplerFilter filter);
+
+/// Sets the number of threads used to resample images.
+/// When [n_threads] is greater than one, the output rows are split into bands
+/// that are processed in parallel. Defaults to 1.
+void ut_image_resampler_set_n_threads(UtObject *object, size_t n_threads);
+
+/// Returns the resampled pixels in [data].
+/// Each pixel has [n_channels] 8 bit samples and each row is [row_stride]
+/// bytes. The returned rows are packed with no padding.
+///
+/// !arg-type data UtUint8List
+/// !return-ref
+/// !return-type UtUint8List
+UtObject *ut_image_resampler_resample(UtObject *object, UtObject *data,
+                                      size_t n_channels, size_t row_stride);
+
+/// Returns a resampled copy of [image], which is a [UtRgba8888Buffer],
+/// [UtJpegImage], [UtPngImage] or [UtTiffImage]. The copy is of the same type.
+/// PNG images that don't have 8 bit samples or use a palette are converted to
+/// RGBA. Returns [NULL] for TIFF images that don't have interleaved 8 bit
+/// samples, use a palette or fail to decode. Images with straight alpha are
+/// premultiplied while filtering so transparent pixels don't affect the
+/// visible ones.
+///
+/// !arg-type image UtObject
+/// !return-ref
+/// !return-type UtObject NULL
+UtObject *ut_image_resampler_resample_image(UtObject *object, UtObject *image);
+
+/// Returns [true] if [object] is a [UtImageResampler].
+bool ut_object_is_image_resampler(UtObject *object);
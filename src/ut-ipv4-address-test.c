@@ -15,6 +15,9 @@ int main(int argc, char **argv) {
   UtObjectRef a3 = ut_ipv4_address_new_from_string("192.168.1.42");
   ut_assert_is_not_error(a3);
   ut_assert_int_equal(ut_ipv4_address_get_address(a3), 0xc0a8012a);
+  ut_assert_true(ut_object_equal(a1, a3));
+  UtObjectRef loopback = ut_ipv4_address_new_loopback();
+  ut_assert_false(ut_object_equal(a1, loopback));
 
   UtObjectRef a4 = ut_ipv4_address_new_from_string("");
   ut_assert_is_error_with_description(a4, "Empty value in IPv4 address");
@@ -24,12 +24,28 @@ static char *ut_ipv4_address_to_object_string(UtObject *object) {
   return ut_cstring_new_printf("<UtIPv4Address>(\"%s\")", address_text);
 }
 
+static bool ut_ipv4_address_equal(UtObject *object, UtObject *other) {
+  UtIPv4Address *self = (UtIPv4Address *)object;
+  if (!ut_object_is_ipv4_address(other)) {
+    return false;
+  }
+  UtIPv4Address *other_self = (UtIPv4Address *)other;
+  return self->address == other_self->address;
+}
+
+static int ut_ipv4_address_hash(UtObject *object) {
+  UtIPv4Address *self = (UtIPv4Address *)object;
+  return self->address;
+}
+
 static UtIPAddressInterface ip_address_interface = {
     .to_string = ut_ipv4_address_to_string};
 
 static UtObjectInterface object_interface = {
     .type_name = "UtIPv4Address",
     .to_string = ut_ipv4_address_to_object_string,
+    .equal = ut_ipv4_address_equal,
+    .hash = ut_ipv4_address_hash,
     .interfaces = {{&ut_ip_address_id, &ip_address_interface}, {NULL, NULL}}};
 
 UtObject *ut_ipv4_address_new(uint32_t address) {
@@ -41,7 +57,7 @@ UtObject *ut_ipv4_address_new(uint32_t address) {
 
 UtObject *ut_ipv4_address_new_from_quad(uint8_t a0, uint8_t a1, uint8_t a2,
                                         uint8_t a3) {
-  return ut_ipv4_address_new(a0 << 24 | a1 << 16 | a2 << 8 | a3);
+  return ut_ipv4_address_new((uint32_t)a0 << 24 | a1 << 16 | a2 << 8 | a3);
 }
 
 UtObject *ut_ipv4_address_new_from_string(const char *address) {
@@ -60,6 +60,19 @@ int main(int argc, char **argv) {
   ut_cstring_ref text7 = ut_ip_address_to_string(a7);
   ut_assert_cstring_equal(text7, "::1");
 
+  // Short prefix and suffix
+  UtObjectRef a13 = ut_ipv6_address_new_from_string("fe80::2");
+  ut_assert_is_not_error(a13);
+  uint8_t link_local_address[16] = {0xfe, 0x80, 0, 0, 0, 0, 0, 0,
+                                    0,    0,    0, 0, 0, 0, 0, 2};
+  ut_assert_uint8_array_equal(ut_ipv6_address_get_address(a13), 16,
+                              link_local_address, 16);
+
+  UtObjectRef loopback1 = ut_ipv6_address_new_from_string("::1");
+  UtObjectRef loopback2 = ut_ipv6_address_new_from_string("0::0:1");
+  ut_assert_true(ut_object_equal(loopback1, loopback2));
+  ut_assert_false(ut_object_equal(loopback1, a13));
+
   // Empty string
   UtObjectRef a8 = ut_ipv6_address_new_from_string("");
   ut_assert_is_error_with_description(
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <string.h>
 
 #include "ut.h"
 
@@ -73,12 +74,32 @@ static char *ut_ipv6_address_to_object_string(UtObject *object) {
   return ut_cstring_new_printf("<UtIPv6Address>(\"%s\")", address_text);
 }
 
+static bool ut_ipv6_address_equal(UtObject *object, UtObject *other) {
+  UtIPv6Address *self = (UtIPv6Address *)object;
+  if (!ut_object_is_ipv6_address(other)) {
+    return false;
+  }
+  UtIPv6Address *other_self = (UtIPv6Address *)other;
+  return memcmp(self->address, other_self->address, 16) == 0;
+}
+
+static int ut_ipv6_address_hash(UtObject *object) {
+  UtIPv6Address *self = (UtIPv6Address *)object;
+  int hash = 0;
+  for (size_t i = 0; i < 16; i++) {
+    hash = hash * 31 + self->address[i];
+  }
+  return hash;
+}
+
 static UtIPAddressInterface ip_address_interface = {
     .to_string = ut_ipv6_address_to_string};
 
 static UtObjectInterface object_interface = {
     .type_name = "UtIPv6Address",
     .to_string = ut_ipv6_address_to_object_string,
+    .equal = ut_ipv6_address_equal,
+    .hash = ut_ipv6_address_hash,
     .interfaces = {{&ut_ip_address_id, &ip_address_interface}, {NULL, NULL}}};
 
 UtObject *ut_ipv6_address_new(uint8_t *address) {
@@ -129,9 +150,9 @@ UtObject *ut_ipv6_address_new_from_string(const char *address) {
         if (duplicate_index != -1) {
           // Shift groups across to make space for zeros
           size_t zero_count = 8 - index;
-          size_t suffix_count = 7 - duplicate_index;
-          for (int i = 7; i > 8 - suffix_count; i--) {
-            groups[i] = groups[i - zero_count];
+          size_t suffix_count = index - duplicate_index;
+          for (size_t i = 0; i < suffix_count; i++) {
+            groups[7 - i] = groups[index - 1 - i];
           }
           for (int i = duplicate_index; i < duplicate_index + zero_count; i++) {
             groups[i] = 0;
@@ -0,0 +1,116 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ut-memory-mapped-file-subarray.h"
+#include "ut.h"
+
+typedef struct {
+  UtObject object;
+  UtObject *parent;
+  size_t start;
+  size_t length;
+} UtMemoryMappedFileSubarray;
+
+static const uint8_t *get_data(UtMemoryMappedFileSubarray *self) {
+  // Catch access after the file has been closed.
+  assert(ut_list_get_length(self->parent) >= self->start + self->length);
+  return ut_memory_mapped_file_get_data(self->parent) + self->start;
+}
+
+static uint8_t ut_memory_mapped_file_subarray_get_element(UtObject *object,
+                                                          size_t index) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  return get_data(self)[index];
+}
+
+static const uint8_t *
+ut_memory_mapped_file_subarray_get_const_data(UtObject *object) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  return get_data(self);
+}
+
+static uint8_t *ut_memory_mapped_file_subarray_take_data(UtObject *object) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  uint8_t *copy = malloc(sizeof(uint8_t) * self->length);
+  memcpy(copy, get_data(self), self->length);
+  return copy;
+}
+
+static size_t ut_memory_mapped_file_subarray_get_length(UtObject *object) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  return self->length;
+}
+
+static UtObject *
+ut_memory_mapped_file_subarray_get_element_object(UtObject *object,
+                                                  size_t index) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  return ut_uint8_new(get_data(self)[index]);
+}
+
+static UtObject *ut_memory_mapped_file_subarray_get_sublist(UtObject *object,
+                                                            size_t start,
+                                                            size_t count) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  assert(start + count <= self->length);
+  return ut_memory_mapped_file_subarray_new(self->parent, self->start + start,
+                                            count);
+}
+
+static UtObject *ut_memory_mapped_file_subarray_copy(UtObject *object) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  UtObject *copy = ut_uint8_array_new();
+  ut_uint8_list_append_block(copy, get_data(self), self->length);
+  return copy;
+}
+
+static char *ut_memory_mapped_file_subarray_to_string(UtObject *object) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  return ut_cstring_new_printf("<UtMemoryMappedFileSubarray>(length: %zi)",
+                               self->length);
+}
+
+static void ut_memory_mapped_file_subarray_cleanup(UtObject *object) {
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+  ut_object_unref(self->parent);
+}
+
+static UtUint8ListInterface uint8_list_interface = {
+    .get_element = ut_memory_mapped_file_subarray_get_element,
+    .get_data = ut_memory_mapped_file_subarray_get_const_data,
+    .take_data = ut_memory_mapped_file_subarray_take_data};
+
+static UtListInterface list_interface = {
+    .is_mutable = false,
+    .get_length = ut_memory_mapped_file_subarray_get_length,
+    .get_element = ut_memory_mapped_file_subarray_get_element_object,
+    .get_sublist = ut_memory_mapped_file_subarray_get_sublist,
+    .copy = ut_memory_mapped_file_subarray_copy};
+
+static UtObjectInterface object_interface = {
+    .type_name = "UtMemoryMappedFileSubarray",
+    .to_string = ut_memory_mapped_file_subarray_to_string,
+    .cleanup = ut_memory_mapped_file_subarray_cleanup,
+    .interfaces = {{&ut_uint8_list_id, &uint8_list_interface},
+                   {&ut_list_id, &list_interface},
+                   {NULL, NULL}}};
+
+UtObject *ut_memory_mapped_file_subarray_new(UtObject *parent, size_t start,
+                                             size_t length) {
+  UtObject *object =
+      ut_object_new(sizeof(UtMemoryMappedFileSubarray), &object_interface);
+  UtMemoryMappedFileSubarray *self = (UtMemoryMappedFileSubarray *)object;
+
+  assert(parent != NULL && ut_object_is_memory_mapped_file(parent));
+  assert(start + length <= ut_list_get_length(parent));
+
+  self->parent = ut_object_ref(parent);
+  self->start = start;
+  self->length = length;
+  return object;
+}
+
+bool ut_object_is_memory_mapped_file_subarray(UtObject *object) {
+  return ut_object_is_type(object, &object_interface);
+}
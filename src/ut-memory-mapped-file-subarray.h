@@ -0,0 +1,11 @@
+#include <stdbool.h>
+
+#include "ut-object.h"
+
+#pragma once
+
+UtObject *ut_memory_mapped_file_subarray_new(UtObject *parent, size_t start,
+                                             size_t length);
+
+/// Returns [true] if [object] is a [UtMemoryMappedFileSubarray].
+bool ut_object_is_memory_mapped_file_subarray(UtObject *object);
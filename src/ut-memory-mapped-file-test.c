@@ -1,14 +1,102 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "ut.h"
 
-int main(int argc, char **argv) {
-  UtObjectRef file = ut_memory_mapped_file_new("README.md");
+static void write_file(const char *path, UtObject *data) {
+  FILE *file = fopen(path, "wb");
+  ut_assert_true(file != NULL);
+  size_t data_length = ut_list_get_length(data);
+  if (data_length > 0) {
+    fwrite(ut_uint8_list_get_data(data), 1, data_length, file);
+  }
+  fclose(file);
+}
+
+static void test_read(const char *dir) {
+  ut_cstring_ref path = ut_cstring_new_printf("%s/data", dir);
+  UtObjectRef data = ut_uint8_list_new_from_hex_string("0123456789abcdef");
+  write_file(path, data);
+
+  UtObjectRef file = ut_memory_mapped_file_new(path);
   ut_file_open_read(file);
-  printf("%zi\n", ut_list_get_length(file));
-  ut_cstring_ref list_string = ut_object_to_string(file);
-  printf("list: %s\n", list_string);
+  ut_assert_uint8_list_equal_hex(file, "0123456789abcdef");
+
+  // Sublists share the mapped data.
+  UtObjectRef sublist = ut_list_get_sublist(file, 2, 3);
+  ut_assert_uint8_list_equal_hex(sublist, "456789");
+  ut_assert_true(ut_uint8_list_get_data(sublist) ==
+                 ut_memory_mapped_file_get_data(file) + 2);
+  UtObjectRef subsublist = ut_list_get_sublist(sublist, 1, 2);
+  ut_assert_uint8_list_equal_hex(subsublist, "6789");
+
+  UtObjectRef result = ut_input_stream_read_sync(file);
+  ut_assert_uint8_list_equal_hex(result, "0123456789abcdef");
+
+  // Closing unmaps the file.
+  ut_file_close(file);
+  ut_assert_true(ut_memory_mapped_file_get_data(file) == NULL);
+  ut_assert_int_equal(ut_list_get_length(file), 0);
+  unlink(path);
+}
+
+static void test_decode(const char *dir) {
+  ut_cstring_ref path = ut_cstring_new_printf("%s/data.gz", dir);
+  UtObjectRef text = ut_string_new("");
+  for (size_t i = 0; i < 1000; i++) {
+    ut_string_append_printf(text, "Line %zi\n", i);
+  }
+  UtObjectRef utf8 = ut_string_get_utf8(text);
+  UtObjectRef utf8_stream = ut_list_input_stream_new(utf8);
+  UtObjectRef encoder = ut_gzip_encoder_new(utf8_stream);
+  UtObjectRef gzip_data = ut_input_stream_read_sync(encoder);
+  write_file(path, gzip_data);
+
+  // Decode directly from the mapped file.
+  UtObjectRef file = ut_memory_mapped_file_new(path);
+  ut_file_open_read(file);
+  UtObjectRef decoder = ut_gzip_decoder_new(file);
+  UtObjectRef result = ut_input_stream_read_sync(decoder);
+  ut_assert_equal(result, utf8);
+
+  ut_file_close(file);
+  unlink(path);
+}
+
+static void test_empty(const char *dir) {
+  ut_cstring_ref path = ut_cstring_new_printf("%s/empty", dir);
+  UtObjectRef data = ut_uint8_array_new();
+  write_file(path, data);
+
+  UtObjectRef file = ut_memory_mapped_file_new(path);
+  ut_file_open_read(file);
+  ut_assert_int_equal(ut_list_get_length(file), 0);
+  UtObjectRef result = ut_input_stream_read_sync(file);
+  ut_assert_int_equal(ut_list_get_length(result), 0);
+
+  ut_file_close(file);
+  unlink(path);
+}
+
+static void test_missing(const char *dir) {
+  ut_cstring_ref path = ut_cstring_new_printf("%s/missing", dir);
+  UtObjectRef file = ut_memory_mapped_file_new(path);
+  ut_file_open_read(file);
+  UtObjectRef result = ut_input_stream_read_sync(file);
+  ut_assert_is_error(result);
+}
+
+int main(int argc, char **argv) {
+  char dir[] = "/tmp/ut-test-XXXXXX";
+  mkdtemp(dir);
+
+  test_read(dir);
+  test_decode(dir);
+  test_empty(dir);
+  test_missing(dir);
+
+  rmdir(dir);
 
   return 0;
 }
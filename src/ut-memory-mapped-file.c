@@ -4,6 +4,7 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 
+#include "ut-memory-mapped-file-subarray.h"
 #include "ut.h"
 
 typedef struct {
@@ -11,30 +12,70 @@ typedef struct {
   UtObject *file;
   uint8_t *data;
   size_t data_length;
+  UtObject *error;
+  bool opened;
+  bool closed;
 } UtMemoryMappedFile;
 
+static void unmap(UtMemoryMappedFile *self) {
+  if (self->data != NULL) {
+    munmap(self->data, self->data_length);
+  }
+  self->data = NULL;
+  self->data_length = 0;
+  ut_object_unref(self->error);
+  self->error = NULL;
+  self->opened = false;
+}
+
 static void map(UtMemoryMappedFile *self, int prot) {
-  int fd = ut_file_descriptor_get_fd(ut_local_file_get_fd(self->file));
+  unmap(self);
+  self->opened = true;
+
+  UtObject *fd_object = ut_local_file_get_fd(self->file);
+  if (fd_object == NULL) {
+    self->error = ut_error_new("Failed to open file");
+    return;
+  }
+  int fd = ut_file_descriptor_get_fd(fd_object);
 
   struct stat stat_result;
-  fstat(fd, &stat_result);
-  self->data_length = stat_result.st_size;
+  if (fstat(fd, &stat_result) != 0) {
+    self->error = ut_error_new("Failed to get file size");
+    return;
+  }
 
-  self->data = mmap(NULL, self->data_length, prot, MAP_SHARED, fd, 0);
+  // Empty files can't be mapped.
+  if (stat_result.st_size == 0) {
+    return;
+  }
+
+  void *data = mmap(NULL, stat_result.st_size, prot, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    self->error = ut_error_new("Failed to map file");
+    return;
+  }
+  self->data = data;
+  self->data_length = stat_result.st_size;
 }
 
 static void ut_memory_mapped_file_cleanup(UtObject *object) {
   UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
   ut_object_unref(self->file);
-  if (self->data != NULL) {
-    munmap(self->data, self->data_length);
-  }
+  unmap(self);
 }
 
 static void ut_memory_mapped_file_open_read(UtObject *object) {
   UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
   ut_file_open_read(self->file);
   map(self, PROT_READ);
+
+  // Files are usually read from start to end, so have the kernel read ahead
+  // aggressively and start loading the pages now.
+  if (self->data != NULL) {
+    posix_madvise(self->data, self->data_length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise(self->data, self->data_length, POSIX_MADV_WILLNEED);
+  }
 }
 
 static void ut_memory_mapped_file_open_write(UtObject *object, bool create) {
@@ -45,15 +86,47 @@ static void ut_memory_mapped_file_open_write(UtObject *object, bool create) {
 
 static void ut_memory_mapped_file_close(UtObject *object) {
   UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
+  unmap(self);
   ut_file_close(self->file);
 }
 
+static void ut_memory_mapped_file_read(UtObject *object,
+                                       UtObject *callback_object,
+                                       UtInputStreamCallback callback) {
+  UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
+
+  assert(self->opened);
+
+  if (self->closed) {
+    return;
+  }
+
+  if (self->error != NULL) {
+    callback(callback_object, self->error, true);
+    return;
+  }
+
+  // The whole file is available, so provide it in one block without copying.
+  size_t n_used = callback(callback_object, object, true);
+  assert(n_used <= self->data_length);
+}
+
+static void ut_memory_mapped_file_close_stream(UtObject *object) {
+  UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
+  self->closed = true;
+}
+
 static uint8_t ut_memory_mapped_file_get_element(UtObject *object,
                                                  size_t index) {
   UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
   return self->data[index];
 }
 
+static const uint8_t *ut_memory_mapped_file_get_const_data(UtObject *object) {
+  UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
+  return self->data;
+}
+
 static uint8_t *ut_memory_mapped_file_take_data(UtObject *object) {
   UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
   uint8_t *copy = malloc(sizeof(uint8_t) * self->data_length);
@@ -75,10 +148,8 @@ static UtObject *ut_memory_mapped_file_get_element_object(UtObject *object,
 static UtObject *ut_memory_mapped_file_get_sublist(UtObject *object,
                                                    size_t start, size_t count) {
   UtMemoryMappedFile *self = (UtMemoryMappedFile *)object;
-  // FIXME: Should do this without copying.
-  UtObject *copy = ut_uint8_array_new();
-  ut_uint8_list_append_block(copy, self->data + start, count);
-  return copy;
+  assert(start + count <= self->data_length);
+  return ut_memory_mapped_file_subarray_new(object, start, count);
 }
 
 static UtObject *ut_memory_mapped_file_copy(UtObject *object) {
@@ -93,8 +164,13 @@ static UtFileInterface file_interface = {
     .open_write = ut_memory_mapped_file_open_write,
     .close = ut_memory_mapped_file_close};
 
+static UtInputStreamInterface input_stream_interface = {
+    .read = ut_memory_mapped_file_read,
+    .close = ut_memory_mapped_file_close_stream};
+
 static UtUint8ListInterface uint8_list_interface = {
     .get_element = ut_memory_mapped_file_get_element,
+    .get_data = ut_memory_mapped_file_get_const_data,
     .take_data = ut_memory_mapped_file_take_data};
 
 static UtListInterface list_interface = {
@@ -108,6 +184,7 @@ static UtObjectInterface object_interface = {
     .type_name = "UtMemoryMappedFile",
     .cleanup = ut_memory_mapped_file_cleanup,
     .interfaces = {{&ut_file_id, &file_interface},
+                   {&ut_input_stream_id, &input_stream_interface},
                    {&ut_uint8_list_id, &uint8_list_interface},
                    {&ut_list_id, &list_interface},
                    {NULL, NULL}}};
@@ -7,12 +7,17 @@
 
 /// Creates a new memory mapped file that accesses [path].
 ///
+/// Once opened for reading the file can be used as an input stream, which
+/// provides the whole file in a single block without copying. This is the
+/// most efficient way to pass a file to a decoder. Closing the file unmaps
+/// it, after which the data and any sublists of it must not be used.
+///
 /// !return-ref
 /// !return-type UtMemoryMappedFile
 UtObject *ut_memory_mapped_file_new(const char *path);
 
 /// Returns the address of the memory mapped file or NULL if not yet
-/// opened.
+/// opened, failed to open or is empty.
 uint8_t *ut_memory_mapped_file_get_data(UtObject *object);
 
 /// Returns [true] if [object] is a [UtMemoryMappedFile].
@@ -0,0 +1,18 @@
+#include <stddef.h>
+
+#pragma once
+
+// Function that does the work for one worker, given a pointer to its data.
+typedef void (*UtParallelFunction)(void *worker);
+
+// Returns the number of workers to split [n_items] between when using up to
+// [n_threads] threads. This is at least one.
+size_t _ut_parallel_get_n_workers(size_t n_threads, size_t n_items);
+
+// Run [function] on each of the [n_workers] workers in the array [workers],
+// where each element is [worker_size] bytes. The workers are shared between
+// at most one thread per CPU, including the calling thread. If a thread can't
+// be created its workers are run on the calling thread. Returns once all the
+// workers have completed.
+void _ut_parallel_run(void *workers, size_t worker_size, size_t n_workers,
+                      UtParallelFunction function);
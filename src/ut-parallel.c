@@ -0,0 +1,81 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ut-parallel-private.h"
+
+// Workers run by one thread.
+typedef struct {
+  UtParallelFunction function;
+  uint8_t *workers;
+  size_t worker_size;
+  size_t n_workers;
+
+  // This thread runs every [step] worker starting at [start].
+  size_t start;
+  size_t step;
+
+  pthread_t thread;
+  bool threaded;
+} Thread;
+
+static size_t get_n_cpus() {
+  long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return n_cpus > 0 ? n_cpus : 1;
+}
+
+static void *run_thread_cb(void *data) {
+  Thread *thread = data;
+  for (size_t i = thread->start; i < thread->n_workers; i += thread->step) {
+    thread->function(thread->workers + i * thread->worker_size);
+  }
+  return NULL;
+}
+
+size_t _ut_parallel_get_n_workers(size_t n_threads, size_t n_items) {
+  size_t n_workers = n_threads < n_items ? n_threads : n_items;
+  return n_workers > 0 ? n_workers : 1;
+}
+
+void _ut_parallel_run(void *workers, size_t worker_size, size_t n_workers,
+                      UtParallelFunction function) {
+  size_t n_threads = get_n_cpus();
+  if (n_threads > n_workers) {
+    n_threads = n_workers;
+  }
+  if (n_threads <= 1) {
+    for (size_t i = 0; i < n_workers; i++) {
+      function((uint8_t *)workers + i * worker_size);
+    }
+    return;
+  }
+
+  Thread *threads = calloc(n_threads, sizeof(Thread));
+  for (size_t i = 0; i < n_threads; i++) {
+    threads[i].function = function;
+    threads[i].workers = workers;
+    threads[i].worker_size = worker_size;
+    threads[i].n_workers = n_workers;
+    threads[i].start = i;
+    threads[i].step = n_threads;
+  }
+
+  // The first thread's workers are run on the calling thread.
+  for (size_t i = 1; i < n_threads; i++) {
+    threads[i].threaded = pthread_create(&threads[i].thread, NULL,
+                                         run_thread_cb, &threads[i]) == 0;
+    if (!threads[i].threaded) {
+      run_thread_cb(&threads[i]);
+    }
+  }
+  run_thread_cb(&threads[0]);
+  for (size_t i = 1; i < n_threads; i++) {
+    if (threads[i].threaded) {
+      pthread_join(threads[i].thread, NULL);
+    }
+  }
+
+  free(threads);
+}
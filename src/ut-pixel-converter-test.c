@@ -0,0 +1,206 @@
+#include <stdlib.h>
+
+#include "ut.h"
+
+static void check_convert(UtPixelFormat format, UtPixelFormat new_format,
+                          size_t width, size_t height, const char *hex_data,
+                          const char *expected_hex_data) {
+  UtObjectRef data = ut_uint8_list_new_from_hex_string(hex_data);
+  UtObjectRef converter = ut_pixel_converter_new(format, new_format);
+  UtObjectRef result = ut_pixel_converter_convert(
+      converter, data, width, height,
+      ut_pixel_format_get_row_stride(format, width));
+  ut_assert_uint8_list_equal_hex(result, expected_hex_data);
+}
+
+// Create [length] bytes of random data.
+static UtObject *create_random_data(size_t length) {
+  UtObject *data = ut_uint8_array_new_sized(length);
+  uint8_t *d = ut_uint8_list_get_writable_data(data);
+  for (size_t i = 0; i < length; i++) {
+    d[i] = rand();
+  }
+  return data;
+}
+
+// Convert random rows of different widths so every part of the optimized
+// conversions gets used.
+static UtObject *convert_random_rows(UtPixelFormat format,
+                                     UtPixelFormat new_format, size_t width,
+                                     UtObject **data) {
+  *data =
+      create_random_data(ut_pixel_format_get_row_stride(format, width) * 3);
+  UtObjectRef converter = ut_pixel_converter_new(format, new_format);
+  return ut_pixel_converter_convert(
+      converter, *data, width, 3,
+      ut_pixel_format_get_row_stride(format, width));
+}
+
+static void test_format() {
+  ut_assert_int_equal(
+      ut_pixel_format_get_bits_per_pixel(UT_PIXEL_FORMAT_GREY1), 1);
+  ut_assert_int_equal(
+      ut_pixel_format_get_bits_per_pixel(UT_PIXEL_FORMAT_RGBA16), 64);
+  ut_assert_int_equal(
+      ut_pixel_format_get_row_stride(UT_PIXEL_FORMAT_GREY1, 9), 2);
+  ut_assert_int_equal(
+      ut_pixel_format_get_row_stride(UT_PIXEL_FORMAT_INDEXED4, 3), 2);
+  ut_assert_int_equal(ut_pixel_format_get_row_stride(UT_PIXEL_FORMAT_RGB8, 3),
+                      9);
+
+  // Copying packed pixels only changes the destination pixel.
+  uint8_t grey2_row[1] = {0x1b};
+  uint8_t new_grey2_row[2] = {0xff, 0x00};
+  ut_pixel_format_copy_pixel(UT_PIXEL_FORMAT_GREY2, grey2_row, 1,
+                             new_grey2_row, 2);
+  ut_pixel_format_copy_pixel(UT_PIXEL_FORMAT_GREY2, grey2_row, 2,
+                             new_grey2_row, 4);
+  ut_assert_int_equal(new_grey2_row[0], 0xf7);
+  ut_assert_int_equal(new_grey2_row[1], 0x80);
+
+  uint8_t rgb16_row[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  uint8_t new_rgb16_row[6] = {0};
+  ut_pixel_format_copy_pixel(UT_PIXEL_FORMAT_RGB16, rgb16_row, 1,
+                             new_rgb16_row, 0);
+  ut_assert_int_equal(new_rgb16_row[0], 6);
+  ut_assert_int_equal(new_rgb16_row[5], 11);
+}
+
+static void test_convert() {
+  check_convert(UT_PIXEL_FORMAT_RGB8, UT_PIXEL_FORMAT_RGB8, 2, 1,
+                "ff000000ff00", "ff000000ff00");
+  check_convert(UT_PIXEL_FORMAT_RGB8, UT_PIXEL_FORMAT_RGBA8, 2, 1,
+                "ff000000ff00", "ff0000ff00ff00ff");
+  check_convert(UT_PIXEL_FORMAT_RGBA8, UT_PIXEL_FORMAT_RGB8, 2, 1,
+                "ff00008000ff0040", "ff000000ff00");
+  check_convert(UT_PIXEL_FORMAT_GREY8, UT_PIXEL_FORMAT_RGBA8, 2, 1, "0080",
+                "000000ff808080ff");
+  check_convert(UT_PIXEL_FORMAT_GREY1, UT_PIXEL_FORMAT_GREY8, 10, 2,
+                "a5c00180", "ff00ff0000ff00ffffff00000000000000ffff00");
+  check_convert(UT_PIXEL_FORMAT_GREY2, UT_PIXEL_FORMAT_GREY8, 4, 1, "1b",
+                "0055aaff");
+  check_convert(UT_PIXEL_FORMAT_GREY4, UT_PIXEL_FORMAT_GREY8, 2, 1, "f1",
+                "ff11");
+  check_convert(UT_PIXEL_FORMAT_GREY16, UT_PIXEL_FORMAT_GREY8, 3, 1,
+                "ffff8080807f", "ff807f");
+  check_convert(UT_PIXEL_FORMAT_GREY_ALPHA8, UT_PIXEL_FORMAT_RGBA16, 1, 1,
+                "4080", "4040404040408080");
+  check_convert(UT_PIXEL_FORMAT_RGB16, UT_PIXEL_FORMAT_RGBA8, 1, 1,
+                "ffff80800000", "ff8000ff");
+  check_convert(UT_PIXEL_FORMAT_RGB8, UT_PIXEL_FORMAT_GREY8, 3, 1,
+                "ff000000ff000000ff", "4c951d");
+  check_convert(UT_PIXEL_FORMAT_RGBA8, UT_PIXEL_FORMAT_GREY1, 9, 1,
+                "ffffffff000000ffffffffff000000ff"
+                "ffffffff000000ffffffffff000000ff"
+                "ffffffff",
+                "aa80");
+  check_convert(UT_PIXEL_FORMAT_RGBA8, UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8, 2,
+                1, "ff804080ffffff00", "8040208000000000");
+  check_convert(UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8, UT_PIXEL_FORMAT_RGBA8, 2,
+                1, "8040208000000000", "ff80408000000000");
+
+  // Indexes outside the palette are black.
+  UtObjectRef indexed_data = ut_uint8_list_new_from_hex_string("1b");
+  UtObjectRef converter =
+      ut_pixel_converter_new(UT_PIXEL_FORMAT_INDEXED2, UT_PIXEL_FORMAT_RGB8);
+  UtObjectRef palette = ut_uint8_list_new_from_hex_string("ff000000ff00");
+  ut_pixel_converter_set_palette(converter, palette);
+  UtObjectRef indexed_result =
+      ut_pixel_converter_convert(converter, indexed_data, 4, 1, 1);
+  ut_assert_uint8_list_equal_hex(indexed_result, "ff000000ff00000000000000");
+
+  // Rows with padding.
+  check_convert(UT_PIXEL_FORMAT_GREY8, UT_PIXEL_FORMAT_RGB8, 1, 2, "01ff02",
+                "010101ffffff");
+  UtObjectRef padded_data = ut_uint8_list_new_from_hex_string("01ff02");
+  UtObjectRef padded_converter =
+      ut_pixel_converter_new(UT_PIXEL_FORMAT_GREY8, UT_PIXEL_FORMAT_RGB8);
+  UtObjectRef padded_result =
+      ut_pixel_converter_convert(padded_converter, padded_data, 1, 2, 2);
+  ut_assert_uint8_list_equal_hex(padded_result, "010101020202");
+}
+
+// Check the optimized conversions match the expected results.
+static void test_optimized() {
+  for (size_t width = 1; width < 80; width++) {
+    UtObjectRef rgb = NULL;
+    UtObjectRef rgba = convert_random_rows(
+        UT_PIXEL_FORMAT_RGB8, UT_PIXEL_FORMAT_RGBA8, width, &rgb);
+    UtObjectRef rgba_converter =
+        ut_pixel_converter_new(UT_PIXEL_FORMAT_RGBA8, UT_PIXEL_FORMAT_RGB8);
+    UtObjectRef rgb_result =
+        ut_pixel_converter_convert(rgba_converter, rgba, width, 3, width * 4);
+    ut_assert_equal(rgb_result, rgb);
+    const uint8_t *rgba_data = ut_uint8_list_get_data(rgba);
+    for (size_t i = 0; i < width * 3; i++) {
+      ut_assert_int_equal(rgba_data[i * 4 + 3], 0xff);
+    }
+
+    UtObjectRef grey = NULL;
+    UtObjectRef grey_rgba = convert_random_rows(
+        UT_PIXEL_FORMAT_GREY8, UT_PIXEL_FORMAT_RGBA8, width, &grey);
+    const uint8_t *grey_data = ut_uint8_list_get_data(grey);
+    const uint8_t *grey_rgba_data = ut_uint8_list_get_data(grey_rgba);
+    for (size_t i = 0; i < width * 3; i++) {
+      for (size_t c = 0; c < 3; c++) {
+        ut_assert_int_equal(grey_rgba_data[i * 4 + c], grey_data[i]);
+      }
+      ut_assert_int_equal(grey_rgba_data[i * 4 + 3], 0xff);
+    }
+
+    UtObjectRef rgba16 = NULL;
+    UtObjectRef rgba8 = convert_random_rows(
+        UT_PIXEL_FORMAT_RGBA16, UT_PIXEL_FORMAT_RGBA8, width, &rgba16);
+    const uint8_t *rgba16_data = ut_uint8_list_get_data(rgba16);
+    const uint8_t *rgba8_data = ut_uint8_list_get_data(rgba8);
+    for (size_t i = 0; i < width * 3 * 4; i++) {
+      uint16_t value = rgba16_data[i * 2] << 8 | rgba16_data[i * 2 + 1];
+      ut_assert_int_equal(rgba8_data[i], value / 257);
+    }
+
+    UtObjectRef unpremultiplied = NULL;
+    UtObjectRef premultiplied =
+        convert_random_rows(UT_PIXEL_FORMAT_RGBA8,
+                            UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8, width,
+                            &unpremultiplied);
+    const uint8_t *unpremultiplied_data =
+        ut_uint8_list_get_data(unpremultiplied);
+    const uint8_t *premultiplied_data = ut_uint8_list_get_data(premultiplied);
+    for (size_t i = 0; i < width * 3; i++) {
+      uint8_t alpha = unpremultiplied_data[i * 4 + 3];
+      for (size_t c = 0; c < 3; c++) {
+        ut_assert_int_equal(premultiplied_data[i * 4 + c],
+                            (unpremultiplied_data[i * 4 + c] * alpha + 127) /
+                                255);
+      }
+      ut_assert_int_equal(premultiplied_data[i * 4 + 3], alpha);
+    }
+
+    UtObjectRef indexed = create_random_data(width);
+    UtObjectRef palette = create_random_data(200 * 3);
+    UtObjectRef indexed_converter =
+        ut_pixel_converter_new(UT_PIXEL_FORMAT_INDEXED8, UT_PIXEL_FORMAT_RGBA8);
+    ut_pixel_converter_set_palette(indexed_converter, palette);
+    UtObjectRef indexed_rgba =
+        ut_pixel_converter_convert(indexed_converter, indexed, width, 1, width);
+    const uint8_t *indexed_data = ut_uint8_list_get_data(indexed);
+    const uint8_t *palette_data = ut_uint8_list_get_data(palette);
+    const uint8_t *indexed_rgba_data = ut_uint8_list_get_data(indexed_rgba);
+    for (size_t i = 0; i < width; i++) {
+      uint8_t index = indexed_data[i];
+      for (size_t c = 0; c < 3; c++) {
+        ut_assert_int_equal(indexed_rgba_data[i * 4 + c],
+                            index < 200 ? palette_data[index * 3 + c] : 0);
+      }
+      ut_assert_int_equal(indexed_rgba_data[i * 4 + 3], 0xff);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  test_format();
+  test_convert();
+  test_optimized();
+
+  return 0;
+}
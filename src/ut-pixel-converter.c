@@ -0,0 +1,580 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ut-cpu-private.h"
+#include "ut.h"
+
+// Number of pixels converted at a time when going through the intermediate
+// format.
+#define CHUNK_SIZE 256
+
+typedef struct _UtPixelConverter UtPixelConverter;
+
+// Function to convert a row of [width] pixels.
+typedef void (*ConvertFunction)(UtPixelConverter *self, const uint8_t *row,
+                                uint8_t *new_row, size_t width);
+
+struct _UtPixelConverter {
+  UtObject object;
+
+  // Formats being converted between.
+  UtPixelFormat format;
+  UtPixelFormat new_format;
+
+  // RGBA values for each palette index.
+  uint32_t palette[256];
+
+  // Function that does the conversion.
+  ConvertFunction convert;
+};
+
+static bool is_indexed(UtPixelFormat format) {
+  return format == UT_PIXEL_FORMAT_INDEXED1 ||
+         format == UT_PIXEL_FORMAT_INDEXED2 ||
+         format == UT_PIXEL_FORMAT_INDEXED4 ||
+         format == UT_PIXEL_FORMAT_INDEXED8;
+}
+
+// Get the sample of [bits] at position [x] in [row].
+static uint8_t get_bits(const uint8_t *row, size_t x, size_t bits) {
+  size_t offset = x * bits;
+  size_t shift = 8 - bits - offset % 8;
+  return (row[offset / 8] >> shift) & (0xff >> (8 - bits));
+}
+
+// Set the sample of [bits] at position [x] in [row] to [value].
+static void set_bits(uint8_t *row, size_t x, size_t bits, uint8_t value) {
+  size_t offset = x * bits;
+  size_t shift = 8 - bits - offset % 8;
+  if (shift == 8 - bits) {
+    row[offset / 8] = 0;
+  }
+  row[offset / 8] |= value << shift;
+}
+
+static uint16_t read16(const uint8_t *data) { return data[0] << 8 | data[1]; }
+
+static void write16(uint8_t *data, uint16_t value) {
+  data[0] = value >> 8;
+  data[1] = value & 0xff;
+}
+
+// Convert a 16 bit sample to 8 bits, equivalent to [value] / 257.
+static uint8_t to8(uint16_t value) { return (value - (value >> 8)) >> 8; }
+
+static uint8_t premultiply(uint8_t value, uint8_t alpha) {
+  uint16_t v = value * alpha + 128;
+  return (v + (v >> 8)) >> 8;
+}
+
+static uint8_t unpremultiply(uint8_t value, uint8_t alpha) {
+  if (alpha == 0) {
+    return 0;
+  }
+  uint16_t v = (value * 255 + alpha / 2) / alpha;
+  return v > 255 ? 255 : v;
+}
+
+static uint16_t get_luminance(const uint16_t *rgba) {
+  return (rgba[0] * 19595u + rgba[1] * 38470u + rgba[2] * 7471u + 32768) >>
+         16;
+}
+
+// Convert [n_pixels] from [x] in [row] to 16 bit RGBA.
+static void unpack(UtPixelConverter *self, const uint8_t *row, size_t x,
+                   size_t n_pixels, uint16_t *rgba) {
+  size_t bits = ut_pixel_format_get_bits_per_pixel(self->format);
+  for (size_t i = 0; i < n_pixels; i++, rgba += 4) {
+    const uint8_t *pixel = row + (x + i) * bits / 8;
+    switch (self->format) {
+    case UT_PIXEL_FORMAT_GREY1:
+    case UT_PIXEL_FORMAT_GREY2:
+    case UT_PIXEL_FORMAT_GREY4:
+      rgba[0] = rgba[1] = rgba[2] =
+          get_bits(row, x + i, bits) * (65535 / ((1 << bits) - 1));
+      rgba[3] = 65535;
+      break;
+    case UT_PIXEL_FORMAT_GREY8:
+      rgba[0] = rgba[1] = rgba[2] = pixel[0] * 257;
+      rgba[3] = 65535;
+      break;
+    case UT_PIXEL_FORMAT_GREY16:
+      rgba[0] = rgba[1] = rgba[2] = read16(pixel);
+      rgba[3] = 65535;
+      break;
+    case UT_PIXEL_FORMAT_GREY_ALPHA8:
+      rgba[0] = rgba[1] = rgba[2] = pixel[0] * 257;
+      rgba[3] = pixel[1] * 257;
+      break;
+    case UT_PIXEL_FORMAT_GREY_ALPHA16:
+      rgba[0] = rgba[1] = rgba[2] = read16(pixel);
+      rgba[3] = read16(pixel + 2);
+      break;
+    case UT_PIXEL_FORMAT_RGB8:
+      for (size_t c = 0; c < 3; c++) {
+        rgba[c] = pixel[c] * 257;
+      }
+      rgba[3] = 65535;
+      break;
+    case UT_PIXEL_FORMAT_RGB16:
+      for (size_t c = 0; c < 3; c++) {
+        rgba[c] = read16(pixel + c * 2);
+      }
+      rgba[3] = 65535;
+      break;
+    case UT_PIXEL_FORMAT_RGBA8:
+      for (size_t c = 0; c < 4; c++) {
+        rgba[c] = pixel[c] * 257;
+      }
+      break;
+    case UT_PIXEL_FORMAT_RGBA16:
+      for (size_t c = 0; c < 4; c++) {
+        rgba[c] = read16(pixel + c * 2);
+      }
+      break;
+    case UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8:
+      for (size_t c = 0; c < 3; c++) {
+        rgba[c] = unpremultiply(pixel[c], pixel[3]) * 257;
+      }
+      rgba[3] = pixel[3] * 257;
+      break;
+    case UT_PIXEL_FORMAT_INDEXED1:
+    case UT_PIXEL_FORMAT_INDEXED2:
+    case UT_PIXEL_FORMAT_INDEXED4:
+    case UT_PIXEL_FORMAT_INDEXED8: {
+      const uint8_t *color =
+          (const uint8_t *)&self->palette[get_bits(row, x + i, bits)];
+      for (size_t c = 0; c < 4; c++) {
+        rgba[c] = color[c] * 257;
+      }
+      break;
+    }
+    }
+  }
+}
+
+// Convert [n_pixels] of 16 bit RGBA to the new format at [x] in [new_row].
+static void pack(UtPixelConverter *self, const uint16_t *rgba, uint8_t *new_row,
+                 size_t x, size_t n_pixels) {
+  size_t bits = ut_pixel_format_get_bits_per_pixel(self->new_format);
+  for (size_t i = 0; i < n_pixels; i++, rgba += 4) {
+    uint8_t *pixel = new_row + (x + i) * bits / 8;
+    switch (self->new_format) {
+    case UT_PIXEL_FORMAT_GREY1:
+    case UT_PIXEL_FORMAT_GREY2:
+    case UT_PIXEL_FORMAT_GREY4:
+      set_bits(new_row, x + i, bits, get_luminance(rgba) >> (16 - bits));
+      break;
+    case UT_PIXEL_FORMAT_GREY8:
+      pixel[0] = to8(get_luminance(rgba));
+      break;
+    case UT_PIXEL_FORMAT_GREY16:
+      write16(pixel, get_luminance(rgba));
+      break;
+    case UT_PIXEL_FORMAT_GREY_ALPHA8:
+      pixel[0] = to8(get_luminance(rgba));
+      pixel[1] = to8(rgba[3]);
+      break;
+    case UT_PIXEL_FORMAT_GREY_ALPHA16:
+      write16(pixel, get_luminance(rgba));
+      write16(pixel + 2, rgba[3]);
+      break;
+    case UT_PIXEL_FORMAT_RGB8:
+      for (size_t c = 0; c < 3; c++) {
+        pixel[c] = to8(rgba[c]);
+      }
+      break;
+    case UT_PIXEL_FORMAT_RGB16:
+      for (size_t c = 0; c < 3; c++) {
+        write16(pixel + c * 2, rgba[c]);
+      }
+      break;
+    case UT_PIXEL_FORMAT_RGBA8:
+      for (size_t c = 0; c < 4; c++) {
+        pixel[c] = to8(rgba[c]);
+      }
+      break;
+    case UT_PIXEL_FORMAT_RGBA16:
+      for (size_t c = 0; c < 4; c++) {
+        write16(pixel + c * 2, rgba[c]);
+      }
+      break;
+    case UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8:
+      for (size_t c = 0; c < 3; c++) {
+        pixel[c] = premultiply(to8(rgba[c]), to8(rgba[3]));
+      }
+      pixel[3] = to8(rgba[3]);
+      break;
+    case UT_PIXEL_FORMAT_INDEXED1:
+    case UT_PIXEL_FORMAT_INDEXED2:
+    case UT_PIXEL_FORMAT_INDEXED4:
+    case UT_PIXEL_FORMAT_INDEXED8:
+      assert(false);
+      break;
+    }
+  }
+}
+
+// Convert any format by going through 16 bit RGBA.
+static void convert_generic(UtPixelConverter *self, const uint8_t *row,
+                            uint8_t *new_row, size_t width) {
+  uint16_t rgba[CHUNK_SIZE * 4];
+  for (size_t x = 0; x < width; x += CHUNK_SIZE) {
+    size_t n_pixels = width - x < CHUNK_SIZE ? width - x : CHUNK_SIZE;
+    unpack(self, row, x, n_pixels, rgba);
+    pack(self, rgba, new_row, x, n_pixels);
+  }
+}
+
+static void convert_copy(UtPixelConverter *self, const uint8_t *row,
+                         uint8_t *new_row, size_t width) {
+  memcpy(new_row, row, ut_pixel_format_get_row_stride(self->format, width));
+}
+
+static void convert_rgb8_to_rgba8(UtPixelConverter *self, const uint8_t *row,
+                                  uint8_t *new_row, size_t width) {
+  for (size_t x = 0; x < width; x++) {
+    memcpy(new_row + x * 4, row + x * 3, 3);
+    new_row[x * 4 + 3] = 0xff;
+  }
+}
+
+static void convert_rgba8_to_rgb8(UtPixelConverter *self, const uint8_t *row,
+                                  uint8_t *new_row, size_t width) {
+  for (size_t x = 0; x < width; x++) {
+    memcpy(new_row + x * 3, row + x * 4, 3);
+  }
+}
+
+static void convert_grey8_to_rgba8(UtPixelConverter *self, const uint8_t *row,
+                                   uint8_t *new_row, size_t width) {
+  for (size_t x = 0; x < width; x++) {
+    memset(new_row + x * 4, row[x], 3);
+    new_row[x * 4 + 3] = 0xff;
+  }
+}
+
+static void convert_indexed8_to_rgba8(UtPixelConverter *self,
+                                      const uint8_t *row, uint8_t *new_row,
+                                      size_t width) {
+  for (size_t x = 0; x < width; x++) {
+    memcpy(new_row + x * 4, &self->palette[row[x]], 4);
+  }
+}
+
+static void convert_rgba8_to_premultiplied(UtPixelConverter *self,
+                                           const uint8_t *row,
+                                           uint8_t *new_row, size_t width) {
+  for (size_t x = 0; x < width; x++) {
+    const uint8_t *pixel = row + x * 4;
+    uint8_t *new_pixel = new_row + x * 4;
+    for (size_t c = 0; c < 3; c++) {
+      new_pixel[c] = premultiply(pixel[c], pixel[3]);
+    }
+    new_pixel[3] = pixel[3];
+  }
+}
+
+static void convert_premultiplied_to_rgba8(UtPixelConverter *self,
+                                           const uint8_t *row,
+                                           uint8_t *new_row, size_t width) {
+  for (size_t x = 0; x < width; x++) {
+    const uint8_t *pixel = row + x * 4;
+    uint8_t *new_pixel = new_row + x * 4;
+    for (size_t c = 0; c < 3; c++) {
+      new_pixel[c] = unpremultiply(pixel[c], pixel[3]);
+    }
+    new_pixel[3] = pixel[3];
+  }
+}
+
+// Convert 16 bit samples to 8 bit with the same channels.
+static void convert_16_to_8(UtPixelConverter *self, const uint8_t *row,
+                            uint8_t *new_row, size_t width) {
+  size_t n_samples = width * ut_pixel_format_get_bits_per_pixel(self->format) /
+                     16;
+  for (size_t i = 0; i < n_samples; i++) {
+    new_row[i] = to8(read16(row + i * 2));
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static void
+convert_rgb8_to_rgba8_avx2(UtPixelConverter *self, const uint8_t *row,
+                           uint8_t *new_row, size_t width) {
+  const __m128i shuffle =
+      _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32(0xff000000);
+  size_t x = 0;
+  // Four pixels at a time, stopping before reading past the end of the row.
+  for (; x + 6 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128((const __m128i *)(row + x * 3));
+    pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha);
+    _mm_storeu_si128((__m128i *)(new_row + x * 4), pixels);
+  }
+  convert_rgb8_to_rgba8(self, row + x * 3, new_row + x * 4, width - x);
+}
+
+__attribute__((target("avx2"))) static void
+convert_rgba8_to_rgb8_avx2(UtPixelConverter *self, const uint8_t *row,
+                           uint8_t *new_row, size_t width) {
+  const __m128i shuffle =
+      _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  size_t x = 0;
+  // Four pixels at a time, stopping before writing past the end of the row.
+  for (; x + 6 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128((const __m128i *)(row + x * 4));
+    _mm_storeu_si128((__m128i *)(new_row + x * 3),
+                     _mm_shuffle_epi8(pixels, shuffle));
+  }
+  convert_rgba8_to_rgb8(self, row + x * 4, new_row + x * 3, width - x);
+}
+
+__attribute__((target("avx2"))) static void
+convert_grey8_to_rgba8_avx2(UtPixelConverter *self, const uint8_t *row,
+                            uint8_t *new_row, size_t width) {
+  const __m128i alpha = _mm_set1_epi32(0xff000000);
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i grey = _mm_loadu_si128((const __m128i *)(row + x));
+    for (int i = 0; i < 4; i++) {
+      const __m128i shuffle = _mm_setr_epi8(
+          i * 4, i * 4, i * 4, -1, i * 4 + 1, i * 4 + 1, i * 4 + 1, -1,
+          i * 4 + 2, i * 4 + 2, i * 4 + 2, -1, i * 4 + 3, i * 4 + 3, i * 4 + 3,
+          -1);
+      _mm_storeu_si128((__m128i *)(new_row + (x + i * 4) * 4),
+                       _mm_or_si128(_mm_shuffle_epi8(grey, shuffle), alpha));
+    }
+  }
+  convert_grey8_to_rgba8(self, row + x, new_row + x * 4, width - x);
+}
+
+__attribute__((target("avx2"))) static void
+convert_indexed8_to_rgba8_avx2(UtPixelConverter *self, const uint8_t *row,
+                               uint8_t *new_row, size_t width) {
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i index =
+        _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(row + x)));
+    __m256i color =
+        _mm256_i32gather_epi32((const int *)self->palette, index, 4);
+    _mm256_storeu_si256((__m256i *)(new_row + x * 4), color);
+  }
+  convert_indexed8_to_rgba8(self, row + x, new_row + x * 4, width - x);
+}
+
+__attribute__((target("avx2"))) static void
+convert_rgba8_to_premultiplied_avx2(UtPixelConverter *self,
+                                    const uint8_t *row, uint8_t *new_row,
+                                    size_t width) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i round = _mm256_set1_epi16(128);
+  const __m256i alpha_mask = _mm256_set1_epi32(0xff000000);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i pixels = _mm256_loadu_si256((const __m256i *)(row + x * 4));
+    __m256i low = _mm256_unpacklo_epi8(pixels, zero);
+    __m256i high = _mm256_unpackhi_epi8(pixels, zero);
+    __m256i low_alpha =
+        _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(low, 0xff), 0xff);
+    __m256i high_alpha =
+        _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(high, 0xff), 0xff);
+    low = _mm256_add_epi16(_mm256_mullo_epi16(low, low_alpha), round);
+    high = _mm256_add_epi16(_mm256_mullo_epi16(high, high_alpha), round);
+    low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)),
+                            8);
+    high = _mm256_srli_epi16(
+        _mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+    __m256i result = _mm256_blendv_epi8(_mm256_packus_epi16(low, high),
+                                        pixels, alpha_mask);
+    _mm256_storeu_si256((__m256i *)(new_row + x * 4), result);
+  }
+  convert_rgba8_to_premultiplied(self, row + x * 4, new_row + x * 4,
+                                 width - x);
+}
+
+__attribute__((target("avx2"))) static void
+convert_16_to_8_avx2(UtPixelConverter *self, const uint8_t *row,
+                     uint8_t *new_row, size_t width) {
+  size_t n_samples = width * ut_pixel_format_get_bits_per_pixel(self->format) /
+                     16;
+  const __m256i low_mask = _mm256_set1_epi16(0x00ff);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 32 <= n_samples; i += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(row + i * 2));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(row + i * 2 + 32));
+    // Samples are big endian, so the first byte is the most significant.
+    __m256i high = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(_mm256_and_si256(a, low_mask),
+                            _mm256_and_si256(b, low_mask)),
+        0xd8);
+    __m256i low = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)),
+        0xd8);
+    // value / 257 is the high byte, less one if the low byte is smaller.
+    __m256i no_borrow =
+        _mm256_cmpeq_epi8(_mm256_subs_epu8(high, low), zero);
+    __m256i result =
+        _mm256_add_epi8(high, _mm256_xor_si256(no_borrow, ones));
+    _mm256_storeu_si256((__m256i *)(new_row + i), result);
+  }
+  for (; i < n_samples; i++) {
+    new_row[i] = to8(read16(row + i * 2));
+  }
+}
+#endif
+
+static bool is_16_to_8(UtPixelFormat format, UtPixelFormat new_format) {
+  return (format == UT_PIXEL_FORMAT_GREY16 &&
+          new_format == UT_PIXEL_FORMAT_GREY8) ||
+         (format == UT_PIXEL_FORMAT_GREY_ALPHA16 &&
+          new_format == UT_PIXEL_FORMAT_GREY_ALPHA8) ||
+         (format == UT_PIXEL_FORMAT_RGB16 &&
+          new_format == UT_PIXEL_FORMAT_RGB8) ||
+         (format == UT_PIXEL_FORMAT_RGBA16 &&
+          new_format == UT_PIXEL_FORMAT_RGBA8);
+}
+
+// Get a function that converts directly between [format] and [new_format]
+// without going through an intermediate format.
+static ConvertFunction get_convert_function(UtPixelFormat format,
+                                            UtPixelFormat new_format) {
+  if (format == new_format) {
+    return convert_copy;
+  }
+
+#if defined(__x86_64__) || defined(__i386__)
+  if (_ut_cpu_has_avx2()) {
+    if (format == UT_PIXEL_FORMAT_RGB8 && new_format == UT_PIXEL_FORMAT_RGBA8) {
+      return convert_rgb8_to_rgba8_avx2;
+    } else if (format == UT_PIXEL_FORMAT_RGBA8 &&
+               new_format == UT_PIXEL_FORMAT_RGB8) {
+      return convert_rgba8_to_rgb8_avx2;
+    } else if (format == UT_PIXEL_FORMAT_GREY8 &&
+               new_format == UT_PIXEL_FORMAT_RGBA8) {
+      return convert_grey8_to_rgba8_avx2;
+    } else if (format == UT_PIXEL_FORMAT_INDEXED8 &&
+               new_format == UT_PIXEL_FORMAT_RGBA8) {
+      return convert_indexed8_to_rgba8_avx2;
+    } else if (format == UT_PIXEL_FORMAT_RGBA8 &&
+               new_format == UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8) {
+      return convert_rgba8_to_premultiplied_avx2;
+    } else if (is_16_to_8(format, new_format)) {
+      return convert_16_to_8_avx2;
+    }
+  }
+#endif
+
+  if (format == UT_PIXEL_FORMAT_RGB8 && new_format == UT_PIXEL_FORMAT_RGBA8) {
+    return convert_rgb8_to_rgba8;
+  } else if (format == UT_PIXEL_FORMAT_RGBA8 &&
+             new_format == UT_PIXEL_FORMAT_RGB8) {
+    return convert_rgba8_to_rgb8;
+  } else if (format == UT_PIXEL_FORMAT_GREY8 &&
+             new_format == UT_PIXEL_FORMAT_RGBA8) {
+    return convert_grey8_to_rgba8;
+  } else if (format == UT_PIXEL_FORMAT_INDEXED8 &&
+             new_format == UT_PIXEL_FORMAT_RGBA8) {
+    return convert_indexed8_to_rgba8;
+  } else if (format == UT_PIXEL_FORMAT_RGBA8 &&
+             new_format == UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8) {
+    return convert_rgba8_to_premultiplied;
+  } else if (format == UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8 &&
+             new_format == UT_PIXEL_FORMAT_RGBA8) {
+    return convert_premultiplied_to_rgba8;
+  } else if (is_16_to_8(format, new_format)) {
+    return convert_16_to_8;
+  }
+
+  return convert_generic;
+}
+
+static UtObjectInterface object_interface = {.type_name = "UtPixelConverter"};
+
+UtObject *ut_pixel_converter_new(UtPixelFormat format,
+                                 UtPixelFormat new_format) {
+  assert(!is_indexed(new_format));
+
+  UtObject *object =
+      ut_object_new(sizeof(UtPixelConverter), &object_interface);
+  UtPixelConverter *self = (UtPixelConverter *)object;
+  self->format = format;
+  self->new_format = new_format;
+  self->convert = get_convert_function(format, new_format);
+
+  // Default to all black.
+  uint8_t black[4] = {0x00, 0x00, 0x00, 0xff};
+  for (size_t i = 0; i < 256; i++) {
+    memcpy(&self->palette[i], black, 4);
+  }
+
+  return object;
+}
+
+void ut_pixel_converter_set_palette(UtObject *object, UtObject *palette) {
+  assert(ut_object_is_pixel_converter(object));
+  UtPixelConverter *self = (UtPixelConverter *)object;
+
+  const uint8_t *palette_data = ut_uint8_list_get_data(palette);
+  UtObjectRef palette_array = NULL;
+  if (palette_data == NULL) {
+    palette_array = ut_uint8_list_get_array(palette);
+    palette_data = ut_uint8_list_get_data(palette_array);
+  }
+  size_t palette_length = ut_list_get_length(palette) / 3;
+  for (size_t i = 0; i < 256; i++) {
+    uint8_t color[4] = {0x00, 0x00, 0x00, 0xff};
+    if (i < palette_length) {
+      memcpy(color, palette_data + i * 3, 3);
+    }
+    memcpy(&self->palette[i], color, 4);
+  }
+}
+
+void ut_pixel_converter_convert_row(UtObject *object, const uint8_t *row,
+                                    uint8_t *new_row, size_t width) {
+  assert(ut_object_is_pixel_converter(object));
+  UtPixelConverter *self = (UtPixelConverter *)object;
+  self->convert(self, row, new_row, width);
+}
+
+UtObject *ut_pixel_converter_convert(UtObject *object, UtObject *data,
+                                     size_t width, size_t height,
+                                     size_t row_stride) {
+  assert(ut_object_is_pixel_converter(object));
+  UtPixelConverter *self = (UtPixelConverter *)object;
+
+  assert(row_stride >= ut_pixel_format_get_row_stride(self->format, width));
+  assert(height == 0 ||
+         ut_list_get_length(data) >=
+             (height - 1) * row_stride +
+                 ut_pixel_format_get_row_stride(self->format, width));
+
+  const uint8_t *d = ut_uint8_list_get_data(data);
+  UtObjectRef array = NULL;
+  if (d == NULL) {
+    array = ut_uint8_list_get_array(data);
+    d = ut_uint8_list_get_data(array);
+  }
+
+  size_t new_row_stride =
+      ut_pixel_format_get_row_stride(self->new_format, width);
+  UtObject *new_data = ut_uint8_array_new_sized(new_row_stride * height);
+  uint8_t *new_d = ut_uint8_list_get_writable_data(new_data);
+  for (size_t y = 0; y < height; y++) {
+    self->convert(self, d + y * row_stride, new_d + y * new_row_stride, width);
+  }
+
+  return new_data;
+}
+
+bool ut_object_is_pixel_converter(UtObject *object) {
+  return ut_object_is_type(object, &object_interface);
+}
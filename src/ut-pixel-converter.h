@@ -0,0 +1,38 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ut-object.h"
+#include "ut-pixel-format.h"
+
+#pragma once
+
+/// Creates a new converter from pixels in [format] to [new_format].
+/// [new_format] can't be an indexed format.
+///
+/// !return-ref
+/// !return-type UtPixelConverter
+UtObject *ut_pixel_converter_new(UtPixelFormat format,
+                                 UtPixelFormat new_format);
+
+/// Sets the [palette] of RGB values used by indexed formats. Indexes outside
+/// the palette are converted to black.
+///
+/// !arg-type palette UtUint8List
+void ut_pixel_converter_set_palette(UtObject *object, UtObject *palette);
+
+/// Converts [width] pixels from [row] into [new_row].
+void ut_pixel_converter_convert_row(UtObject *object, const uint8_t *row,
+                                    uint8_t *new_row, size_t width);
+
+/// Returns [width]x[height] pixels from [data] converted to the new format.
+/// Each row in [data] is [row_stride] bytes.
+///
+/// !arg-type data UtUint8List
+/// !return-ref
+/// !return-type UtUint8List
+UtObject *ut_pixel_converter_convert(UtObject *object, UtObject *data,
+                                     size_t width, size_t height,
+                                     size_t row_stride);
+
+/// Returns [true] if [object] is a [UtPixelConverter].
+bool ut_object_is_pixel_converter(UtObject *object);
@@ -0,0 +1,59 @@
+#include <string.h>
+
+#include "ut.h"
+
+size_t ut_pixel_format_get_bits_per_pixel(UtPixelFormat format) {
+  switch (format) {
+  case UT_PIXEL_FORMAT_GREY1:
+  case UT_PIXEL_FORMAT_INDEXED1:
+    return 1;
+  case UT_PIXEL_FORMAT_GREY2:
+  case UT_PIXEL_FORMAT_INDEXED2:
+    return 2;
+  case UT_PIXEL_FORMAT_GREY4:
+  case UT_PIXEL_FORMAT_INDEXED4:
+    return 4;
+  case UT_PIXEL_FORMAT_GREY8:
+  case UT_PIXEL_FORMAT_INDEXED8:
+    return 8;
+  case UT_PIXEL_FORMAT_GREY16:
+  case UT_PIXEL_FORMAT_GREY_ALPHA8:
+    return 16;
+  case UT_PIXEL_FORMAT_RGB8:
+    return 24;
+  case UT_PIXEL_FORMAT_GREY_ALPHA16:
+  case UT_PIXEL_FORMAT_RGBA8:
+  case UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8:
+    return 32;
+  case UT_PIXEL_FORMAT_RGB16:
+    return 48;
+  case UT_PIXEL_FORMAT_RGBA16:
+    return 64;
+  }
+
+  return 0;
+}
+
+size_t ut_pixel_format_get_row_stride(UtPixelFormat format, size_t width) {
+  return (width * ut_pixel_format_get_bits_per_pixel(format) + 7) / 8;
+}
+
+void ut_pixel_format_copy_pixel(UtPixelFormat format, const uint8_t *row,
+                                size_t x, uint8_t *new_row, size_t new_x) {
+  size_t bits = ut_pixel_format_get_bits_per_pixel(format);
+  if (bits >= 8) {
+    size_t n_bytes = bits / 8;
+    memcpy(new_row + new_x * n_bytes, row + x * n_bytes, n_bytes);
+    return;
+  }
+
+  // Pixels less than 8 bits are packed with the leftmost in the most
+  // significant bits.
+  uint8_t mask = 0xff >> (8 - bits);
+  size_t offset = x * bits;
+  uint8_t value = (row[offset / 8] >> (8 - bits - offset % 8)) & mask;
+  size_t new_offset = new_x * bits;
+  size_t new_shift = 8 - bits - new_offset % 8;
+  new_row[new_offset / 8] =
+      (new_row[new_offset / 8] & ~(mask << new_shift)) | value << new_shift;
+}
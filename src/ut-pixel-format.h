@@ -0,0 +1,54 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+/// Layout of pixels in image data. Rows start on a byte boundary, and
+/// samples less than 8 bits are packed with the leftmost pixel in the most
+/// significant bits. 16 bit samples are big endian.
+/// - [UT_PIXEL_FORMAT_GREY1] - 1 bit greyscale.
+/// - [UT_PIXEL_FORMAT_GREY2] - 2 bit greyscale.
+/// - [UT_PIXEL_FORMAT_GREY4] - 4 bit greyscale.
+/// - [UT_PIXEL_FORMAT_GREY8] - 8 bit greyscale.
+/// - [UT_PIXEL_FORMAT_GREY16] - 16 bit greyscale.
+/// - [UT_PIXEL_FORMAT_GREY_ALPHA8] - 8 bit greyscale and alpha.
+/// - [UT_PIXEL_FORMAT_GREY_ALPHA16] - 16 bit greyscale and alpha.
+/// - [UT_PIXEL_FORMAT_RGB8] - 8 bit red, green and blue.
+/// - [UT_PIXEL_FORMAT_RGB16] - 16 bit red, green and blue.
+/// - [UT_PIXEL_FORMAT_RGBA8] - 8 bit red, green, blue and alpha.
+/// - [UT_PIXEL_FORMAT_RGBA16] - 16 bit red, green, blue and alpha.
+/// - [UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8] - 8 bit red, green, blue and alpha
+/// with the colors multiplied by alpha.
+/// - [UT_PIXEL_FORMAT_INDEXED1] - 1 bit index into a palette.
+/// - [UT_PIXEL_FORMAT_INDEXED2] - 2 bit index into a palette.
+/// - [UT_PIXEL_FORMAT_INDEXED4] - 4 bit index into a palette.
+/// - [UT_PIXEL_FORMAT_INDEXED8] - 8 bit index into a palette.
+typedef enum {
+  UT_PIXEL_FORMAT_GREY1,
+  UT_PIXEL_FORMAT_GREY2,
+  UT_PIXEL_FORMAT_GREY4,
+  UT_PIXEL_FORMAT_GREY8,
+  UT_PIXEL_FORMAT_GREY16,
+  UT_PIXEL_FORMAT_GREY_ALPHA8,
+  UT_PIXEL_FORMAT_GREY_ALPHA16,
+  UT_PIXEL_FORMAT_RGB8,
+  UT_PIXEL_FORMAT_RGB16,
+  UT_PIXEL_FORMAT_RGBA8,
+  UT_PIXEL_FORMAT_RGBA16,
+  UT_PIXEL_FORMAT_PREMULTIPLIED_RGBA8,
+  UT_PIXEL_FORMAT_INDEXED1,
+  UT_PIXEL_FORMAT_INDEXED2,
+  UT_PIXEL_FORMAT_INDEXED4,
+  UT_PIXEL_FORMAT_INDEXED8
+} UtPixelFormat;
+
+/// Returns the number of bits used for each pixel in [format].
+size_t ut_pixel_format_get_bits_per_pixel(UtPixelFormat format);
+
+/// Returns the number of bytes in a row of [width] pixels in [format].
+size_t ut_pixel_format_get_row_stride(UtPixelFormat format, size_t width);
+
+/// Copies pixel [x] from [row] to pixel [new_x] in [new_row], both in
+/// [format]. Other pixels in [new_row] are not changed.
+void ut_pixel_format_copy_pixel(UtPixelFormat format, const uint8_t *row,
+                                size_t x, uint8_t *new_row, size_t new_x);
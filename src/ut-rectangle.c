@@ -0,0 +1,67 @@
+#include <assert.h>
+
+#include "ut.h"
+
+typedef struct {
+  UtObject object;
+  int32_t x;
+  int32_t y;
+  uint32_t width;
+  uint32_t height;
+} UtRectangle;
+
+static char *ut_rectangle_to_string(UtObject *object) {
+  UtRectangle *self = (UtRectangle *)object;
+  return ut_cstring_new_printf("<UtRectangle>(%d, %d, %u, %u)", self->x,
+                               self->y, self->width, self->height);
+}
+
+static bool ut_rectangle_equal(UtObject *object, UtObject *other) {
+  UtRectangle *self = (UtRectangle *)object;
+  if (!ut_object_is_rectangle(other)) {
+    return false;
+  }
+  UtRectangle *other_self = (UtRectangle *)other;
+  return self->x == other_self->x && self->y == other_self->y &&
+         self->width == other_self->width &&
+         self->height == other_self->height;
+}
+
+static UtObjectInterface object_interface = {.type_name = "UtRectangle",
+                                             .to_string =
+                                                 ut_rectangle_to_string,
+                                             .equal = ut_rectangle_equal};
+
+UtObject *ut_rectangle_new(int32_t x, int32_t y, uint32_t width,
+                           uint32_t height) {
+  UtObject *object = ut_object_new(sizeof(UtRectangle), &object_interface);
+  UtRectangle *self = (UtRectangle *)object;
+  self->x = x;
+  self->y = y;
+  self->width = width;
+  self->height = height;
+  return object;
+}
+
+void ut_rectangle_get_dimensions(UtObject *object, int32_t *x, int32_t *y,
+                                 uint32_t *width, uint32_t *height) {
+  assert(ut_object_is_rectangle(object));
+  UtRectangle *self = (UtRectangle *)object;
+
+  if (x != NULL) {
+    *x = self->x;
+  }
+  if (y != NULL) {
+    *y = self->y;
+  }
+  if (width != NULL) {
+    *width = self->width;
+  }
+  if (height != NULL) {
+    *height = self->height;
+  }
+}
+
+bool ut_object_is_rectangle(UtObject *object) {
+  return ut_object_is_type(object, &object_interface);
+}
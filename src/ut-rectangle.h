@@ -0,0 +1,21 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ut-object.h"
+
+#pragma once
+
+/// Creates a new rectangle of size [width]x[height] at location [x],[y].
+///
+/// !return-ref
+/// !return-type UtRectangle
+UtObject *ut_rectangle_new(int32_t x, int32_t y, uint32_t width,
+                           uint32_t height);
+
+/// Gets the dimensions of this rectangle and writes them into [x], [y], [width]
+/// and [height].
+void ut_rectangle_get_dimensions(UtObject *object, int32_t *x, int32_t *y,
+                                 uint32_t *width, uint32_t *height);
+
+/// Returns [true] if [object] is a [UtRectangle].
+bool ut_object_is_rectangle(UtObject *object);
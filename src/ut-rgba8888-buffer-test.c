@@ -0,0 +1,177 @@
+#include <stdlib.h>
+
+#include "ut.h"
+
+static uint8_t *get_data(UtObject *buffer) {
+  return ut_uint8_list_get_writable_data(ut_image_buffer_get_data(buffer));
+}
+
+static void check_pixel(UtObject *buffer, size_t x, size_t y, uint8_t red,
+                        uint8_t green, uint8_t blue, uint8_t alpha) {
+  const uint8_t *pixel =
+      get_data(buffer) + (y * ut_image_buffer_get_width(buffer) + x) * 4;
+  ut_assert_int_equal(pixel[0], red);
+  ut_assert_int_equal(pixel[1], green);
+  ut_assert_int_equal(pixel[2], blue);
+  ut_assert_int_equal(pixel[3], alpha);
+}
+
+static uint8_t div255(int value) { return (value + 127) / 255; }
+
+static void test_render_box() {
+  UtObjectRef buffer = ut_rgba8888_buffer_new(4, 4);
+  UtObjectRef bg_color = ut_color_new_rgba(0.0, 0.0, 1.0, 1.0);
+  ut_drawable_clear(buffer, bg_color);
+  UtObjectRef fg_color = ut_color_new_rgba(1.0, 0.0, 0.0, 1.0);
+  ut_drawable_render_box(buffer, 1, 1, 2, 2, fg_color);
+  check_pixel(buffer, 0, 0, 0x00, 0x00, 0xff, 0xff);
+  check_pixel(buffer, 1, 1, 0xff, 0x00, 0x00, 0xff);
+  check_pixel(buffer, 2, 2, 0xff, 0x00, 0x00, 0xff);
+  check_pixel(buffer, 3, 3, 0x00, 0x00, 0xff, 0xff);
+
+  // Colors are stored premultiplied.
+  UtObjectRef transparent_color = ut_color_new_rgba(1.0, 1.0, 1.0, 0.5);
+  ut_drawable_clear(buffer, transparent_color);
+  check_pixel(buffer, 0, 0, 0x7f, 0x7f, 0x7f, 0x7f);
+}
+
+static void test_fill_rectangles() {
+  UtObjectRef buffer = ut_rgba8888_buffer_new(20, 3);
+  UtObjectRef bg_color = ut_color_new_rgba(0.0, 0.0, 1.0, 1.0);
+  ut_drawable_clear(buffer, bg_color);
+
+  UtObjectRef rectangles = ut_object_list_new();
+  ut_list_append_take(rectangles, ut_rectangle_new(-5, 0, 20, 1));
+  ut_list_append_take(rectangles, ut_rectangle_new(10, 1, 20, 1));
+  UtObjectRef color = ut_color_new_rgba(1.0, 0.0, 0.0, 0.5);
+  ut_drawable_fill_rectangles(buffer, rectangles, color,
+                              UT_DRAWABLE_OPERATOR_SRC_OVER);
+  for (size_t x = 0; x < 20; x++) {
+    if (x < 15) {
+      check_pixel(buffer, x, 0, 0x7f, 0x00, 0x80, 0xff);
+    } else {
+      check_pixel(buffer, x, 0, 0x00, 0x00, 0xff, 0xff);
+    }
+    if (x >= 10) {
+      check_pixel(buffer, x, 1, 0x7f, 0x00, 0x80, 0xff);
+    } else {
+      check_pixel(buffer, x, 1, 0x00, 0x00, 0xff, 0xff);
+    }
+    check_pixel(buffer, x, 2, 0x00, 0x00, 0xff, 0xff);
+  }
+
+  ut_drawable_fill_rectangles(buffer, rectangles, color,
+                              UT_DRAWABLE_OPERATOR_ADD);
+  check_pixel(buffer, 0, 0, 0xfe, 0x00, 0x80, 0xff);
+
+  ut_drawable_fill_rectangles(buffer, rectangles, color,
+                              UT_DRAWABLE_OPERATOR_SRC);
+  check_pixel(buffer, 0, 0, 0x7f, 0x00, 0x00, 0x7f);
+  check_pixel(buffer, 0, 2, 0x00, 0x00, 0xff, 0xff);
+}
+
+static void test_clip() {
+  UtObjectRef buffer = ut_rgba8888_buffer_new(20, 20);
+  UtObjectRef black = ut_color_new_rgba(0.0, 0.0, 0.0, 1.0);
+  ut_drawable_clear(buffer, black);
+
+  // Overlapping clip rectangles are only drawn once.
+  UtObjectRef clip = ut_object_list_new();
+  ut_list_append_take(clip, ut_rectangle_new(2, 2, 10, 10));
+  ut_list_append_take(clip, ut_rectangle_new(5, 5, 10, 10));
+  ut_list_append_take(clip, ut_rectangle_new(-10, -10, 11, 11));
+  ut_drawable_set_clip(buffer, clip);
+
+  UtObjectRef rectangles = ut_object_list_new();
+  ut_list_append_take(rectangles, ut_rectangle_new(0, 0, 20, 20));
+  UtObjectRef white = ut_color_new_rgba(1.0, 1.0, 1.0, 0.25);
+  ut_drawable_fill_rectangles(buffer, rectangles, white,
+                              UT_DRAWABLE_OPERATOR_ADD);
+  for (size_t y = 0; y < 20; y++) {
+    for (size_t x = 0; x < 20; x++) {
+      bool inside = (x >= 2 && x < 12 && y >= 2 && y < 12) ||
+                    (x >= 5 && x < 15 && y >= 5 && y < 15) ||
+                    (x < 1 && y < 1);
+      uint8_t value = inside ? 0x3f : 0x00;
+      check_pixel(buffer, x, y, value, value, value, 0xff);
+    }
+  }
+
+  // Removing the clip draws everywhere.
+  ut_drawable_set_clip(buffer, NULL);
+  ut_drawable_clear(buffer, black);
+  check_pixel(buffer, 3, 3, 0x00, 0x00, 0x00, 0xff);
+  check_pixel(buffer, 19, 0, 0x00, 0x00, 0x00, 0xff);
+
+  // Empty clip draws nothing.
+  UtObjectRef empty_clip = ut_object_list_new();
+  ut_drawable_set_clip(buffer, empty_clip);
+  ut_drawable_clear(buffer, white);
+  check_pixel(buffer, 3, 3, 0x00, 0x00, 0x00, 0xff);
+}
+
+static void test_blit() {
+  size_t width = 37, height = 5;
+  UtObjectRef source = ut_rgba8888_buffer_new(width, height);
+  uint8_t *source_data = get_data(source);
+  for (size_t i = 0; i < width * height; i++) {
+    uint8_t *pixel = source_data + i * 4;
+    // Include runs of transparent and opaque pixels.
+    uint8_t alpha = i / 8 % 3 == 0 ? 0 : i / 8 % 3 == 1 ? 255 : rand();
+    for (size_t c = 0; c < 3; c++) {
+      pixel[c] = alpha == 0 ? 0 : rand() % (alpha + 1);
+    }
+    pixel[3] = alpha;
+  }
+
+  UtObjectRef buffer = ut_rgba8888_buffer_new(width + 2, height + 2);
+  uint8_t *data = get_data(buffer);
+  for (size_t i = 0; i < (width + 2) * (height + 2) * 4; i++) {
+    data[i] = rand();
+  }
+  UtObjectRef original = ut_list_copy(ut_image_buffer_get_data(buffer));
+  const uint8_t *original_data = ut_uint8_list_get_data(original);
+
+  ut_drawable_blit(buffer, source, 1, -1, UT_DRAWABLE_OPERATOR_SRC_OVER);
+  for (size_t y = 0; y < height + 2; y++) {
+    for (size_t x = 0; x < width + 2; x++) {
+      size_t i = (y * (width + 2) + x) * 4;
+      if (x < 1 || x >= width + 1 || y >= height - 1) {
+        for (size_t c = 0; c < 4; c++) {
+          ut_assert_int_equal(data[i + c], original_data[i + c]);
+        }
+        continue;
+      }
+      const uint8_t *source_pixel =
+          source_data + ((y + 1) * width + x - 1) * 4;
+      for (size_t c = 0; c < 4; c++) {
+        int value = source_pixel[c] +
+                    div255(original_data[i + c] * (255 - source_pixel[3]));
+        ut_assert_int_equal(data[i + c], value > 255 ? 255 : value);
+      }
+    }
+  }
+
+  UtObjectRef add_buffer = ut_rgba8888_buffer_new(width, height);
+  UtObjectRef color = ut_color_new_rgba(0.5, 0.5, 0.5, 0.5);
+  ut_drawable_clear(add_buffer, color);
+  ut_drawable_blit(add_buffer, source, 0, 0, UT_DRAWABLE_OPERATOR_ADD);
+  const uint8_t *add_data = get_data(add_buffer);
+  for (size_t i = 0; i < width * height * 4; i++) {
+    int value = source_data[i] + (i % 4 == 3 ? 0x7f : 0x3f);
+    ut_assert_int_equal(add_data[i], value > 255 ? 255 : value);
+  }
+
+  ut_drawable_blit(add_buffer, source, 0, 0, UT_DRAWABLE_OPERATOR_SRC);
+  ut_assert_equal(ut_image_buffer_get_data(add_buffer),
+                  ut_image_buffer_get_data(source));
+}
+
+int main(int argc, char **argv) {
+  test_render_box();
+  test_fill_rectangles();
+  test_clip();
+  test_blit();
+
+  return 0;
+}
@@ -1,16 +1,47 @@
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ut-cpu-private.h"
 #include "ut.h"
 
+// Area of the buffer, [right] and [bottom] are not included.
+typedef struct {
+  size_t left;
+  size_t top;
+  size_t right;
+  size_t bottom;
+} Box;
+
+// Function to composite [color] onto [width] pixels in [row].
+typedef void (*FillFunction)(uint8_t *row, size_t width, const uint8_t *color);
+
+// Function to composite [width] pixels from [source] onto [row].
+typedef void (*BlitFunction)(uint8_t *row, const uint8_t *source,
+                             size_t width);
+
 typedef struct {
   UtObject object;
   size_t width;
   size_t height;
   UtObject *data;
+
+  // Areas drawing is limited to. These never overlap.
+  bool has_clip;
+  Box *clip;
+  size_t clip_length;
 } UtRgba8888Buffer;
 
+// Function to draw onto [box] in the buffer.
+typedef void (*BoxFunction)(UtRgba8888Buffer *self, Box box, void *user_data);
+
 static double clamp(double value, double max) {
   if (value < 0) {
     return 0;
@@ -32,31 +63,384 @@ static uint8_t quantize_channel(double value) {
   return (int)v;
 }
 
-static void render_box(UtRgba8888Buffer *self, size_t left, size_t top,
-                       size_t right, size_t bottom, UtObject *color) {
-  uint8_t red8 = quantize_channel(ut_color_get_red(color));
-  uint8_t green8 = quantize_channel(ut_color_get_green(color));
-  uint8_t blue8 = quantize_channel(ut_color_get_blue(color));
-  uint8_t alpha8 = quantize_channel(ut_color_get_alpha(color));
+// Divide [value] by 255, rounding to the nearest integer.
+static uint8_t div255(uint16_t value) {
+  uint16_t v = value + 128;
+  return (v + (v >> 8)) >> 8;
+}
+
+static uint8_t add_saturate(uint8_t a, uint8_t b) {
+  uint16_t v = a + b;
+  return v > 255 ? 255 : v;
+}
 
-  uint8_t *data = ut_uint8_list_get_writable_data(self->data);
-  size_t row_step = (self->width - (right - left)) * 4;
-  size_t i = (top * self->width * 4) + (left * 4);
-  for (size_t y = top; y < bottom; y++) {
-    for (size_t x = left; x < right; x++) {
-      data[i + 0] = red8;
-      data[i + 1] = green8;
-      data[i + 2] = blue8;
-      data[i + 3] = alpha8;
-      i += 4;
+static void get_premultiplied_color(UtObject *color, uint8_t *value) {
+  double alpha = ut_color_get_alpha(color);
+  value[0] = quantize_channel(ut_color_get_red(color) * alpha);
+  value[1] = quantize_channel(ut_color_get_green(color) * alpha);
+  value[2] = quantize_channel(ut_color_get_blue(color) * alpha);
+  value[3] = quantize_channel(alpha);
+}
+
+static void fill_src(uint8_t *row, size_t width, const uint8_t *color) {
+  uint32_t value;
+  memcpy(&value, color, 4);
+  uint32_t *pixels = (uint32_t *)row;
+  for (size_t x = 0; x < width; x++) {
+    pixels[x] = value;
+  }
+}
+
+static void fill_src_over(uint8_t *row, size_t width, const uint8_t *color) {
+  uint8_t inverse_alpha = 255 - color[3];
+  for (size_t x = 0; x < width; x++) {
+    uint8_t *pixel = row + x * 4;
+    for (size_t c = 0; c < 4; c++) {
+      pixel[c] = add_saturate(color[c], div255(pixel[c] * inverse_alpha));
     }
-    i += row_step;
+  }
+}
+
+static void fill_add(uint8_t *row, size_t width, const uint8_t *color) {
+  for (size_t x = 0; x < width; x++) {
+    uint8_t *pixel = row + x * 4;
+    for (size_t c = 0; c < 4; c++) {
+      pixel[c] = add_saturate(pixel[c], color[c]);
+    }
+  }
+}
+
+static void blit_src(uint8_t *row, const uint8_t *source, size_t width) {
+  memcpy(row, source, width * 4);
+}
+
+static void blit_src_over(uint8_t *row, const uint8_t *source, size_t width) {
+  for (size_t x = 0; x < width; x++) {
+    uint8_t *pixel = row + x * 4;
+    const uint8_t *source_pixel = source + x * 4;
+    uint8_t inverse_alpha = 255 - source_pixel[3];
+    for (size_t c = 0; c < 4; c++) {
+      pixel[c] =
+          add_saturate(source_pixel[c], div255(pixel[c] * inverse_alpha));
+    }
+  }
+}
+
+static void blit_add(uint8_t *row, const uint8_t *source, size_t width) {
+  for (size_t x = 0; x < width * 4; x++) {
+    row[x] = add_saturate(row[x], source[x]);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Multiply the 16 bit values in [value] by [alpha] and divide by 255.
+__attribute__((target("avx2"))) static inline __m256i
+multiply_alpha_avx2(__m256i value, __m256i alpha) {
+  __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(value, alpha),
+                               _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)), 8);
+}
+
+__attribute__((target("avx2"))) static void
+fill_src_avx2(uint8_t *row, size_t width, const uint8_t *color) {
+  uint32_t value;
+  memcpy(&value, color, 4);
+  __m256i pixels = _mm256_set1_epi32(value);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    _mm256_storeu_si256((__m256i *)(row + x * 4), pixels);
+  }
+  fill_src(row + x * 4, width - x, color);
+}
+
+__attribute__((target("avx2"))) static void
+fill_src_over_avx2(uint8_t *row, size_t width, const uint8_t *color) {
+  uint32_t value;
+  memcpy(&value, color, 4);
+  const __m256i color_pixels = _mm256_set1_epi32(value);
+  const __m256i inverse_alpha = _mm256_set1_epi16(255 - color[3]);
+  const __m256i zero = _mm256_setzero_si256();
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i pixels = _mm256_loadu_si256((const __m256i *)(row + x * 4));
+    __m256i low = multiply_alpha_avx2(_mm256_unpacklo_epi8(pixels, zero),
+                                      inverse_alpha);
+    __m256i high = multiply_alpha_avx2(_mm256_unpackhi_epi8(pixels, zero),
+                                       inverse_alpha);
+    pixels = _mm256_adds_epu8(_mm256_packus_epi16(low, high), color_pixels);
+    _mm256_storeu_si256((__m256i *)(row + x * 4), pixels);
+  }
+  fill_src_over(row + x * 4, width - x, color);
+}
+
+__attribute__((target("avx2"))) static void
+fill_add_avx2(uint8_t *row, size_t width, const uint8_t *color) {
+  uint32_t value;
+  memcpy(&value, color, 4);
+  const __m256i color_pixels = _mm256_set1_epi32(value);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i pixels = _mm256_loadu_si256((const __m256i *)(row + x * 4));
+    _mm256_storeu_si256((__m256i *)(row + x * 4),
+                        _mm256_adds_epu8(pixels, color_pixels));
+  }
+  fill_add(row + x * 4, width - x, color);
+}
+
+__attribute__((target("avx2"))) static void
+blit_src_over_avx2(uint8_t *row, const uint8_t *source, size_t width) {
+  const __m256i alpha_mask = _mm256_set1_epi32(0xff000000);
+  const __m256i max = _mm256_set1_epi16(255);
+  const __m256i zero = _mm256_setzero_si256();
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i source_pixels =
+        _mm256_loadu_si256((const __m256i *)(source + x * 4));
+
+    // Skip the common cases of fully transparent and fully opaque pixels.
+    __m256i alpha = _mm256_and_si256(source_pixels, alpha_mask);
+    if (_mm256_testz_si256(source_pixels, source_pixels)) {
+      continue;
+    } else if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alpha_mask)) ==
+               -1) {
+      _mm256_storeu_si256((__m256i *)(row + x * 4), source_pixels);
+      continue;
+    }
+
+    __m256i source_low = _mm256_unpacklo_epi8(source_pixels, zero);
+    __m256i source_high = _mm256_unpackhi_epi8(source_pixels, zero);
+    __m256i inverse_alpha_low = _mm256_sub_epi16(
+        max, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(source_low, 0xff),
+                                    0xff));
+    __m256i inverse_alpha_high = _mm256_sub_epi16(
+        max, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(source_high, 0xff),
+                                    0xff));
+    __m256i pixels = _mm256_loadu_si256((const __m256i *)(row + x * 4));
+    __m256i low = multiply_alpha_avx2(_mm256_unpacklo_epi8(pixels, zero),
+                                      inverse_alpha_low);
+    __m256i high = multiply_alpha_avx2(_mm256_unpackhi_epi8(pixels, zero),
+                                       inverse_alpha_high);
+    pixels = _mm256_adds_epu8(_mm256_packus_epi16(low, high), source_pixels);
+    _mm256_storeu_si256((__m256i *)(row + x * 4), pixels);
+  }
+  blit_src_over(row + x * 4, source + x * 4, width - x);
+}
+
+__attribute__((target("avx2"))) static void
+blit_add_avx2(uint8_t *row, const uint8_t *source, size_t width) {
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i pixels = _mm256_loadu_si256((const __m256i *)(row + x * 4));
+    __m256i source_pixels =
+        _mm256_loadu_si256((const __m256i *)(source + x * 4));
+    _mm256_storeu_si256((__m256i *)(row + x * 4),
+                        _mm256_adds_epu8(pixels, source_pixels));
+  }
+  blit_add(row + x * 4, source + x * 4, width - x);
+}
+#endif
+
+// Functions for each operator, indexed by UtDrawableOperator.
+static FillFunction fill_functions[3] = {NULL, NULL, NULL};
+static BlitFunction blit_functions[3] = {NULL, NULL, NULL};
+static pthread_once_t functions_once = PTHREAD_ONCE_INIT;
+
+// Choose the fastest functions the CPU supports.
+static void select_functions() {
+  FillFunction fill_src_function = fill_src;
+  FillFunction fill_src_over_function = fill_src_over;
+  FillFunction fill_add_function = fill_add;
+  BlitFunction blit_src_over_function = blit_src_over;
+  BlitFunction blit_add_function = blit_add;
+#if defined(__x86_64__) || defined(__i386__)
+  if (_ut_cpu_has_avx2()) {
+    fill_src_function = fill_src_avx2;
+    fill_src_over_function = fill_src_over_avx2;
+    fill_add_function = fill_add_avx2;
+    blit_src_over_function = blit_src_over_avx2;
+    blit_add_function = blit_add_avx2;
+  }
+#endif
+
+  blit_functions[UT_DRAWABLE_OPERATOR_SRC] = blit_src;
+  blit_functions[UT_DRAWABLE_OPERATOR_SRC_OVER] = blit_src_over_function;
+  blit_functions[UT_DRAWABLE_OPERATOR_ADD] = blit_add_function;
+  fill_functions[UT_DRAWABLE_OPERATOR_SRC_OVER] = fill_src_over_function;
+  fill_functions[UT_DRAWABLE_OPERATOR_ADD] = fill_add_function;
+  fill_functions[UT_DRAWABLE_OPERATOR_SRC] = fill_src_function;
+}
+
+static bool box_is_empty(Box box) {
+  return box.left >= box.right || box.top >= box.bottom;
+}
+
+static bool intersect(Box a, Box b, Box *result) {
+  result->left = a.left > b.left ? a.left : b.left;
+  result->top = a.top > b.top ? a.top : b.top;
+  result->right = a.right < b.right ? a.right : b.right;
+  result->bottom = a.bottom < b.bottom ? a.bottom : b.bottom;
+  return !box_is_empty(*result);
+}
+
+// Write the parts of [a] not covered by [b] into [pieces] and return how many
+// there are (up to four).
+static size_t subtract(Box a, Box b, Box *pieces) {
+  Box overlap;
+  if (!intersect(a, b, &overlap)) {
+    pieces[0] = a;
+    return 1;
+  }
+
+  size_t n_pieces = 0;
+  if (a.top < overlap.top) {
+    pieces[n_pieces++] = (Box){a.left, a.top, a.right, overlap.top};
+  }
+  if (a.left < overlap.left) {
+    pieces[n_pieces++] =
+        (Box){a.left, overlap.top, overlap.left, overlap.bottom};
+  }
+  if (overlap.right < a.right) {
+    pieces[n_pieces++] =
+        (Box){overlap.right, overlap.top, a.right, overlap.bottom};
+  }
+  if (overlap.bottom < a.bottom) {
+    pieces[n_pieces++] = (Box){a.left, overlap.bottom, a.right, a.bottom};
+  }
+  return n_pieces;
+}
+
+// Get the area of the buffer covered by [width]x[height] at [x],[y].
+static Box get_box(UtRgba8888Buffer *self, int64_t x, int64_t y, int64_t width,
+                   int64_t height) {
+  int64_t left = x < 0 ? 0 : x;
+  int64_t top = y < 0 ? 0 : y;
+  int64_t right = x + width;
+  int64_t bottom = y + height;
+  if (right > (int64_t)self->width) {
+    right = self->width;
+  }
+  if (bottom > (int64_t)self->height) {
+    bottom = self->height;
+  }
+  if (right < left) {
+    right = left;
+  }
+  if (bottom < top) {
+    bottom = top;
+  }
+  return (Box){left, top, right, bottom};
+}
+
+static Box get_rectangle_box(UtRgba8888Buffer *self, UtObject *rectangle) {
+  int32_t x, y;
+  uint32_t width, height;
+  ut_rectangle_get_dimensions(rectangle, &x, &y, &width, &height);
+  return get_box(self, x, y, width, height);
+}
+
+// Add [box] to the clip, only keeping the parts not already covered.
+static void add_clip_box(UtRgba8888Buffer *self, Box box) {
+  size_t n_pieces = 1;
+  Box *pieces = malloc(sizeof(Box));
+  pieces[0] = box;
+  for (size_t i = 0; i < self->clip_length && n_pieces > 0; i++) {
+    Box *new_pieces = malloc(sizeof(Box) * n_pieces * 4);
+    size_t n_new_pieces = 0;
+    for (size_t j = 0; j < n_pieces; j++) {
+      n_new_pieces +=
+          subtract(pieces[j], self->clip[i], new_pieces + n_new_pieces);
+    }
+    free(pieces);
+    pieces = new_pieces;
+    n_pieces = n_new_pieces;
+  }
+
+  self->clip =
+      realloc(self->clip, sizeof(Box) * (self->clip_length + n_pieces));
+  memcpy(self->clip + self->clip_length, pieces, sizeof(Box) * n_pieces);
+  self->clip_length += n_pieces;
+  free(pieces);
+}
+
+// Call [function] for each part of [box] inside the clip.
+static void clip_box(UtRgba8888Buffer *self, Box box, BoxFunction function,
+                     void *user_data) {
+  if (box_is_empty(box)) {
+    return;
+  }
+
+  if (!self->has_clip) {
+    function(self, box, user_data);
+    return;
+  }
+
+  for (size_t i = 0; i < self->clip_length; i++) {
+    Box clipped_box;
+    if (intersect(box, self->clip[i], &clipped_box)) {
+      function(self, clipped_box, user_data);
+    }
+  }
+}
+
+typedef struct {
+  FillFunction function;
+  uint8_t color[4];
+} FillData;
+
+static void fill_box_cb(UtRgba8888Buffer *self, Box box, void *user_data) {
+  FillData *fill_data = user_data;
+  uint8_t *data = ut_uint8_list_get_writable_data(self->data);
+  size_t row_stride = self->width * 4;
+  for (size_t y = box.top; y < box.bottom; y++) {
+    fill_data->function(data + y * row_stride + box.left * 4,
+                        box.right - box.left, fill_data->color);
+  }
+}
+
+static void fill_box(UtRgba8888Buffer *self, Box box, UtObject *color,
+                     UtDrawableOperator op) {
+  FillData fill_data;
+  get_premultiplied_color(color, fill_data.color);
+
+  // Simplify operators where possible.
+  if (op == UT_DRAWABLE_OPERATOR_SRC_OVER && fill_data.color[3] == 255) {
+    op = UT_DRAWABLE_OPERATOR_SRC;
+  }
+  uint32_t value;
+  memcpy(&value, fill_data.color, 4);
+  if (op != UT_DRAWABLE_OPERATOR_SRC && value == 0) {
+    return;
+  }
+
+  fill_data.function = fill_functions[op];
+  clip_box(self, box, fill_box_cb, &fill_data);
+}
+
+typedef struct {
+  BlitFunction function;
+  const uint8_t *data;
+  size_t row_stride;
+  int64_t x;
+  int64_t y;
+} BlitData;
+
+static void blit_box_cb(UtRgba8888Buffer *self, Box box, void *user_data) {
+  BlitData *blit_data = user_data;
+  uint8_t *data = ut_uint8_list_get_writable_data(self->data);
+  size_t row_stride = self->width * 4;
+  for (size_t y = box.top; y < box.bottom; y++) {
+    const uint8_t *source_row = blit_data->data +
+                                (y - blit_data->y) * blit_data->row_stride +
+                                (box.left - blit_data->x) * 4;
+    blit_data->function(data + y * row_stride + box.left * 4, source_row,
+                        box.right - box.left);
   }
 }
 
 static void ut_rgba8888_buffer_cleanup(UtObject *object) {
   UtRgba8888Buffer *self = (UtRgba8888Buffer *)object;
   ut_object_unref(self->data);
+  free(self->clip);
 }
 
 static char *ut_rgba8888_buffer_to_string(UtObject *object) {
@@ -82,7 +466,8 @@ static UtObject *ut_rgba8888_buffer_get_data(UtObject *object) {
 
 static void ut_rgba8888_buffer_clear(UtObject *object, UtObject *color) {
   UtRgba8888Buffer *self = (UtRgba8888Buffer *)object;
-  render_box(self, 0, 0, self->width, self->height, color);
+  fill_box(self, (Box){0, 0, self->width, self->height}, color,
+           UT_DRAWABLE_OPERATOR_SRC);
 }
 
 static void ut_rgba8888_buffer_render_box(UtObject *object, double x, double y,
@@ -95,7 +480,70 @@ static void ut_rgba8888_buffer_render_box(UtObject *object, double x, double y,
   double right = clamp(x + width, self->width);
   double bottom = clamp(y + height, self->height);
 
-  render_box(self, round(left), round(top), round(right), round(bottom), color);
+  fill_box(self, (Box){round(left), round(top), round(right), round(bottom)},
+           color, UT_DRAWABLE_OPERATOR_SRC);
+}
+
+static void ut_rgba8888_buffer_set_clip(UtObject *object,
+                                        UtObject *rectangles) {
+  UtRgba8888Buffer *self = (UtRgba8888Buffer *)object;
+
+  free(self->clip);
+  self->clip = NULL;
+  self->clip_length = 0;
+  self->has_clip = rectangles != NULL;
+  if (rectangles == NULL) {
+    return;
+  }
+
+  size_t rectangles_length = ut_list_get_length(rectangles);
+  for (size_t i = 0; i < rectangles_length; i++) {
+    Box box = get_rectangle_box(
+        self, ut_object_list_get_element(rectangles, i));
+    if (!box_is_empty(box)) {
+      add_clip_box(self, box);
+    }
+  }
+}
+
+static void ut_rgba8888_buffer_fill_rectangles(UtObject *object,
+                                               UtObject *rectangles,
+                                               UtObject *color,
+                                               UtDrawableOperator op) {
+  UtRgba8888Buffer *self = (UtRgba8888Buffer *)object;
+  size_t rectangles_length = ut_list_get_length(rectangles);
+  for (size_t i = 0; i < rectangles_length; i++) {
+    fill_box(self,
+             get_rectangle_box(self, ut_object_list_get_element(rectangles, i)),
+             color, op);
+  }
+}
+
+static void ut_rgba8888_buffer_blit(UtObject *object, UtObject *source,
+                                    int32_t x, int32_t y,
+                                    UtDrawableOperator op) {
+  UtRgba8888Buffer *self = (UtRgba8888Buffer *)object;
+
+  assert(source != object);
+  size_t source_width = ut_image_buffer_get_width(source);
+  size_t source_height = ut_image_buffer_get_height(source);
+  UtObject *source_data = ut_image_buffer_get_data(source);
+  assert(ut_list_get_length(source_data) >= source_width * source_height * 4);
+
+  const uint8_t *d = ut_uint8_list_get_data(source_data);
+  UtObjectRef source_array = NULL;
+  if (d == NULL) {
+    source_array = ut_uint8_list_get_array(source_data);
+    d = ut_uint8_list_get_data(source_array);
+  }
+
+  BlitData blit_data = {.function = blit_functions[op],
+                        .data = d,
+                        .row_stride = source_width * 4,
+                        .x = x,
+                        .y = y};
+  clip_box(self, get_box(self, x, y, source_width, source_height),
+           blit_box_cb, &blit_data);
 }
 
 static UtImageBufferInterface image_buffer_interface = {
@@ -104,7 +552,11 @@ static UtImageBufferInterface image_buffer_interface = {
     .get_data = ut_rgba8888_buffer_get_data};
 
 static UtDrawableInterface drawable_interface = {
-    .clear = ut_rgba8888_buffer_clear, ut_rgba8888_buffer_render_box};
+    .clear = ut_rgba8888_buffer_clear,
+    .render_box = ut_rgba8888_buffer_render_box,
+    .set_clip = ut_rgba8888_buffer_set_clip,
+    .fill_rectangles = ut_rgba8888_buffer_fill_rectangles,
+    .blit = ut_rgba8888_buffer_blit};
 
 static UtObjectInterface object_interface = {
     .type_name = "UtRgba8888Buffer",
@@ -121,6 +573,8 @@ UtObject *ut_rgba8888_buffer_new(size_t width, size_t height) {
   assert(width > 0);
   assert(height > 0);
 
+  pthread_once(&functions_once, select_functions);
+
   self->width = width;
   self->height = height;
   self->data = ut_uint8_array_new();
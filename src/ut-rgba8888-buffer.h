@@ -6,7 +6,7 @@
 #pragma once
 
 /// Creates a new RGBA buffer with dimensions [width]x[height] containing 8 bit
-/// samples.
+/// samples. The color samples are premultiplied by alpha.
 ///
 /// !return-ref
 /// !return-type UtRgba8888Buffer
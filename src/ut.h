@@ -68,10 +68,12 @@
 #include "deflate/ut-deflate-encoder.h"
 #include "deflate/ut-deflate-error.h"
 #include "dns/ut-dns-client.h"
+#include "dns/ut-dns-resolver.h"
 #include "gif/ut-gif-decoder.h"
 #include "gif/ut-gif-encoder.h"
 #include "gif/ut-gif-error.h"
 #include "gif/ut-gif-image.h"
+#include "gif/ut-gif-quantizer.h"
 #include "gif/ut-gif-renderer.h"
 #include "gzip/ut-gzip-decoder.h"
 #include "gzip/ut-gzip-encoder.h"
@@ -136,6 +138,7 @@
 #include "ut-float64.h"
 #include "ut-general-error.h"
 #include "ut-image-buffer.h"
+#include "ut-image-resampler.h"
 #include "ut-input-stream.h"
 #include "ut-int16-array.h"
 #include "ut-int16-list.h"
@@ -163,6 +166,9 @@
 #include "ut-object.h"
 #include "ut-ordered-hash-table.h"
 #include "ut-output-stream.h"
+#include "ut-pixel-converter.h"
+#include "ut-pixel-format.h"
+#include "ut-rectangle.h"
 #include "ut-rgba8888-buffer.h"
 #include "ut-shared-memory-array.h"
 #include "ut-string-array.h"
@@ -241,5 +247,7 @@
 #include "zlib/ut-zlib-encoder.h"
 #include "zlib/ut-zlib-error.h"
 #include "zlib/ut-zlib.h"
+#include "json/ut-json-decoder.h"
 #include "json/ut-json-encoder.h"
+#include "json/ut-json-error.h"
 #include "json/ut-json.h"